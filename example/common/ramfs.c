@@ -0,0 +1,617 @@
+/**
+ * @file ramfs.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 例程共用的最小内存文件系统，仅用于测试及基准测试。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct {
+    xf_vfs_dir_t base;          /*!< 必须位于首位 */
+    int dir_node;               /*!< -1 表示根目录 */
+    int pos;
+    xf_vfs_dirent_t ent;
+} ramfs_dir_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int ramfs_find(ramfs_t *fs, const char *path);
+static int ramfs_alloc_node(ramfs_t *fs, const char *path, bool is_dir);
+static bool ramfs_parent_exists(ramfs_t *fs, const char *path);
+static bool ramfs_is_child(const char *dir, const char *path);
+static int ramfs_reserve(ramfs_node_t *node, size_t size);
+static ramfs_fd_t *ramfs_get_fd(ramfs_t *fs, int fd);
+static void ramfs_fill_stat(const ramfs_node_t *node, xf_vfs_stat_t *st);
+
+static int ramfs_open(void *ctx, const char *path, int flags, int mode);
+static int ramfs_close(void *ctx, int fd);
+static xf_vfs_ssize_t ramfs_pread(void *ctx, int fd, void *dst, size_t size, xf_vfs_off_t offset);
+static xf_vfs_ssize_t ramfs_pwrite(void *ctx, int fd, const void *src, size_t size, xf_vfs_off_t offset);
+static xf_vfs_ssize_t ramfs_read(void *ctx, int fd, void *dst, size_t size);
+static xf_vfs_ssize_t ramfs_write(void *ctx, int fd, const void *data, size_t size);
+static xf_vfs_off_t ramfs_lseek(void *ctx, int fd, xf_vfs_off_t offset, int whence);
+static int ramfs_fstat(void *ctx, int fd, xf_vfs_stat_t *st);
+static int ramfs_fsync(void *ctx, int fd);
+static int ramfs_stat(void *ctx, const char *path, xf_vfs_stat_t *st);
+static int ramfs_unlink(void *ctx, const char *path);
+static int ramfs_rename(void *ctx, const char *src, const char *dst);
+static xf_vfs_dir_t *ramfs_opendir(void *ctx, const char *name);
+static xf_vfs_dirent_t *ramfs_readdir(void *ctx, xf_vfs_dir_t *pdir);
+static void ramfs_seekdir(void *ctx, xf_vfs_dir_t *pdir, long offset);
+static int ramfs_closedir(void *ctx, xf_vfs_dir_t *pdir);
+static int ramfs_mkdir(void *ctx, const char *name, xf_vfs_mode_t mode);
+static int ramfs_rmdir(void *ctx, const char *name);
+static int ramfs_access(void *ctx, const char *path, int amode);
+static int ramfs_truncate(void *ctx, const char *path, xf_vfs_off_t length);
+static int ramfs_ftruncate(void *ctx, int fd, xf_vfs_off_t length);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_dir_ops_t s_ramfs_dir_ops = {
+    .stat_p = ramfs_stat,
+    .unlink_p = ramfs_unlink,
+    .rename_p = ramfs_rename,
+    .opendir_p = ramfs_opendir,
+    .readdir_p = ramfs_readdir,
+    .seekdir_p = ramfs_seekdir,
+    .closedir_p = ramfs_closedir,
+    .mkdir_p = ramfs_mkdir,
+    .rmdir_p = ramfs_rmdir,
+    .access_p = ramfs_access,
+    .truncate_p = ramfs_truncate,
+    .ftruncate_p = ramfs_ftruncate,
+};
+
+static const xf_vfs_fs_ops_t s_ramfs_ops = {
+    .write_p = ramfs_write,
+    .lseek_p = ramfs_lseek,
+    .read_p = ramfs_read,
+    .pread_p = ramfs_pread,
+    .pwrite_p = ramfs_pwrite,
+    .open_p = ramfs_open,
+    .close_p = ramfs_close,
+    .fstat_p = ramfs_fstat,
+    .fsync_p = ramfs_fsync,
+    .dir = &s_ramfs_dir_ops,
+};
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+xf_err_t ramfs_mount(const char *base_path, ramfs_t **out)
+{
+    ramfs_t *fs = xf_malloc(sizeof(ramfs_t));
+    if (fs == NULL) {
+        return XF_ERR_NO_MEM;
+    }
+    xf_memset(fs, 0, sizeof(ramfs_t));
+    xf_err_t err = xf_vfs_register_fs(base_path, &s_ramfs_ops,
+                                      XF_VFS_FLAG_CONTEXT_PTR | XF_VFS_FLAG_STATIC, fs);
+    if (err != XF_OK) {
+        xf_free(fs);
+        return err;
+    }
+    if (out) {
+        *out = fs;
+    }
+    return XF_OK;
+}
+
+xf_err_t ramfs_unmount(const char *base_path, ramfs_t *fs)
+{
+    xf_err_t err = xf_vfs_unregister_fs(base_path);
+    if (err != XF_OK) {
+        return err;
+    }
+    for (int i = 0; i < RAMFS_NODES_MAX; ++i) {
+        xf_free(fs->nodes[i].data);
+    }
+    xf_free(fs);
+    return XF_OK;
+}
+
+const xf_vfs_fs_ops_t *ramfs_get_ops(void)
+{
+    return &s_ramfs_ops;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int ramfs_find(ramfs_t *fs, const char *path)
+{
+    for (int i = 0; i < RAMFS_NODES_MAX; ++i) {
+        if (fs->nodes[i].used && xf_strcmp(fs->nodes[i].path, path) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int ramfs_alloc_node(ramfs_t *fs, const char *path, bool is_dir)
+{
+    if (xf_strlen(path) >= RAMFS_PATH_MAX) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    for (int i = 0; i < RAMFS_NODES_MAX; ++i) {
+        ramfs_node_t *node = &fs->nodes[i];
+        if (!node->used) {
+            xf_memset(node, 0, sizeof(ramfs_node_t));
+            node->used = true;
+            node->is_dir = is_dir;
+            xf_memcpy(node->path, path, xf_strlen(path) + 1);
+            return i;
+        }
+    }
+    errno = ENOSPC;
+    return -1;
+}
+
+static bool ramfs_parent_exists(ramfs_t *fs, const char *path)
+{
+    const char *slash = path;
+    for (const char *p = path; *p; ++p) {
+        if (*p == '/') {
+            slash = p;
+        }
+    }
+    size_t len = (size_t)(slash - path);
+    if (len == 0) {
+        return true;
+    }
+    char parent[RAMFS_PATH_MAX];
+    if (len >= sizeof(parent)) {
+        return false;
+    }
+    xf_memcpy(parent, path, len);
+    parent[len] = '\0';
+    int idx = ramfs_find(fs, parent);
+    return (idx >= 0) && fs->nodes[idx].is_dir;
+}
+
+static bool ramfs_is_child(const char *dir, const char *path)
+{
+    size_t dlen = (xf_strcmp(dir, "/") == 0) ? 0 : xf_strlen(dir);
+    if (xf_strncmp(path, dir, dlen) != 0 || path[dlen] != '/' || path[dlen + 1] == '\0') {
+        return false;
+    }
+    for (const char *p = path + dlen + 1; *p; ++p) {
+        if (*p == '/') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int ramfs_reserve(ramfs_node_t *node, size_t size)
+{
+    if (size <= node->capacity) {
+        return 0;
+    }
+    size_t cap = node->capacity ? node->capacity : 64;
+    while (cap < size) {
+        cap *= 2;
+    }
+    uint8_t *data = xf_malloc(cap);
+    if (data == NULL) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (node->data) {
+        xf_memcpy(data, node->data, node->size);
+        xf_free(node->data);
+    }
+    node->data = data;
+    node->capacity = cap;
+    return 0;
+}
+
+static ramfs_fd_t *ramfs_get_fd(ramfs_t *fs, int fd)
+{
+    if (fd < 0 || fd >= RAMFS_FDS_MAX || !fs->fds[fd].used) {
+        errno = EBADF;
+        return NULL;
+    }
+    return &fs->fds[fd];
+}
+
+static void ramfs_fill_stat(const ramfs_node_t *node, xf_vfs_stat_t *st)
+{
+    xf_memset(st, 0, sizeof(xf_vfs_stat_t));
+    st->st_mode = node->is_dir ? XF_VFS_S_IFDIR : XF_VFS_S_IFREG;
+    st->st_size = (xf_vfs_off_t)node->size;
+    st->st_blksize = 512;
+    st->st_blocks = (xf_vfs_blkcnt_t)((node->size + 511) / 512);
+}
+
+static int ramfs_open(void *ctx, const char *path, int flags, int mode)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    int idx = ramfs_find(fs, path);
+    if (idx >= 0 && (flags & XF_VFS_O_CREAT) && (flags & XF_VFS_O_EXCL)) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (idx < 0) {
+        if (!(flags & XF_VFS_O_CREAT)) {
+            errno = ENOENT;
+            return -1;
+        }
+        if (!ramfs_parent_exists(fs, path)) {
+            errno = ENOENT;
+            return -1;
+        }
+        idx = ramfs_alloc_node(fs, path, false);
+        if (idx < 0) {
+            return -1;
+        }
+    }
+    if (fs->nodes[idx].is_dir && (flags & XF_VFS_O_ACCMODE) != XF_VFS_O_RDONLY) {
+        errno = EISDIR;
+        return -1;
+    }
+    for (int fd = 0; fd < RAMFS_FDS_MAX; ++fd) {
+        if (!fs->fds[fd].used) {
+            fs->fds[fd].used = true;
+            fs->fds[fd].node = idx;
+            fs->fds[fd].flags = flags;
+            fs->fds[fd].offset = 0;
+            if (flags & XF_VFS_O_TRUNC) {
+                fs->nodes[idx].size = 0;
+            }
+            return fd;
+        }
+    }
+    errno = ENFILE;
+    return -1;
+}
+
+static int ramfs_close(void *ctx, int fd)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    ramfs_fd_t *f = ramfs_get_fd(fs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    f->used = false;
+    return 0;
+}
+
+static xf_vfs_ssize_t ramfs_pread(void *ctx, int fd, void *dst, size_t size, xf_vfs_off_t offset)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    ramfs_fd_t *f = ramfs_get_fd(fs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    if (offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    ramfs_node_t *node = &fs->nodes[f->node];
+    if ((size_t)offset >= node->size) {
+        return 0;
+    }
+    size_t n = node->size - (size_t)offset;
+    if (n > size) {
+        n = size;
+    }
+    xf_memcpy(dst, node->data + offset, n);
+    return (xf_vfs_ssize_t)n;
+}
+
+static xf_vfs_ssize_t ramfs_pwrite(void *ctx, int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    ramfs_fd_t *f = ramfs_get_fd(fs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    if ((f->flags & XF_VFS_O_ACCMODE) == XF_VFS_O_RDONLY) {
+        errno = EBADF;
+        return -1;
+    }
+    if (offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    ramfs_node_t *node = &fs->nodes[f->node];
+    size_t end = (size_t)offset + size;
+    if (ramfs_reserve(node, end) < 0) {
+        return -1;
+    }
+    if ((size_t)offset > node->size) {
+        xf_memset(node->data + node->size, 0, (size_t)offset - node->size);
+    }
+    xf_memcpy(node->data + offset, src, size);
+    if (end > node->size) {
+        node->size = end;
+    }
+    return (xf_vfs_ssize_t)size;
+}
+
+static xf_vfs_ssize_t ramfs_read(void *ctx, int fd, void *dst, size_t size)
+{
+    ramfs_t *fs = ctx;
+    ramfs_fd_t *f = ramfs_get_fd(fs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    xf_vfs_ssize_t n = ramfs_pread(ctx, fd, dst, size, f->offset);
+    if (n > 0) {
+        f->offset += n;
+    }
+    return n;
+}
+
+static xf_vfs_ssize_t ramfs_write(void *ctx, int fd, const void *data, size_t size)
+{
+    ramfs_t *fs = ctx;
+    ramfs_fd_t *f = ramfs_get_fd(fs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    if (f->flags & XF_VFS_O_APPEND) {
+        f->offset = (xf_vfs_off_t)fs->nodes[f->node].size;
+    }
+    xf_vfs_ssize_t n = ramfs_pwrite(ctx, fd, data, size, f->offset);
+    if (n > 0) {
+        f->offset += n;
+    }
+    return n;
+}
+
+static xf_vfs_off_t ramfs_lseek(void *ctx, int fd, xf_vfs_off_t offset, int whence)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    ramfs_fd_t *f = ramfs_get_fd(fs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    xf_vfs_off_t base;
+    switch (whence) {
+    case XF_VFS_SEEK_SET: base = 0; break;
+    case XF_VFS_SEEK_CUR: base = f->offset; break;
+    case XF_VFS_SEEK_END: base = (xf_vfs_off_t)fs->nodes[f->node].size; break;
+    default: errno = EINVAL; return -1;
+    }
+    if (base + offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    f->offset = base + offset;
+    return f->offset;
+}
+
+static int ramfs_fstat(void *ctx, int fd, xf_vfs_stat_t *st)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    ramfs_fd_t *f = ramfs_get_fd(fs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    ramfs_fill_stat(&fs->nodes[f->node], st);
+    return 0;
+}
+
+static int ramfs_fsync(void *ctx, int fd)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    return ramfs_get_fd(fs, fd) ? 0 : -1;
+}
+
+static int ramfs_stat(void *ctx, const char *path, xf_vfs_stat_t *st)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    if (xf_strcmp(path, "/") == 0) {
+        ramfs_node_t root = { .used = true, .is_dir = true };
+        ramfs_fill_stat(&root, st);
+        return 0;
+    }
+    int idx = ramfs_find(fs, path);
+    if (idx < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    ramfs_fill_stat(&fs->nodes[idx], st);
+    return 0;
+}
+
+static int ramfs_unlink(void *ctx, const char *path)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    int idx = ramfs_find(fs, path);
+    if (idx < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (fs->nodes[idx].is_dir) {
+        errno = EISDIR;
+        return -1;
+    }
+    xf_free(fs->nodes[idx].data);
+    xf_memset(&fs->nodes[idx], 0, sizeof(ramfs_node_t));
+    return 0;
+}
+
+static int ramfs_rename(void *ctx, const char *src, const char *dst)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    int idx = ramfs_find(fs, src);
+    if (idx < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (xf_strlen(dst) >= RAMFS_PATH_MAX) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    int old = ramfs_find(fs, dst);
+    if (old >= 0 && old != idx) {
+        xf_free(fs->nodes[old].data);
+        xf_memset(&fs->nodes[old], 0, sizeof(ramfs_node_t));
+    }
+    xf_memcpy(fs->nodes[idx].path, dst, xf_strlen(dst) + 1);
+    return 0;
+}
+
+static xf_vfs_dir_t *ramfs_opendir(void *ctx, const char *name)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    int idx = -1;
+    if (xf_strcmp(name, "/") != 0) {
+        idx = ramfs_find(fs, name);
+        if (idx < 0 || !fs->nodes[idx].is_dir) {
+            errno = ENOENT;
+            return NULL;
+        }
+    }
+    ramfs_dir_t *dir = xf_malloc(sizeof(ramfs_dir_t));
+    if (dir == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    xf_memset(dir, 0, sizeof(ramfs_dir_t));
+    dir->dir_node = idx;
+    return &dir->base;
+}
+
+static xf_vfs_dirent_t *ramfs_readdir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    ramfs_dir_t *dir = (ramfs_dir_t *)pdir;
+    const char *dpath = (dir->dir_node < 0) ? "/" : fs->nodes[dir->dir_node].path;
+    while (dir->pos < RAMFS_NODES_MAX) {
+        ramfs_node_t *node = &fs->nodes[dir->pos++];
+        if (!node->used || !ramfs_is_child(dpath, node->path)) {
+            continue;
+        }
+        const char *name = node->path;
+        for (const char *p = node->path; *p; ++p) {
+            if (*p == '/') {
+                name = p + 1;
+            }
+        }
+        size_t len = xf_strlen(name);
+        xf_memcpy(dir->ent.d_name, name, len + 1);
+        dir->ent.d_namlen = (uint8_t)len;
+        dir->ent.d_ino = (xf_vfs_ino_t)(node - fs->nodes) + 1;
+        dir->ent.d_type = node->is_dir ? XF_VFS_DT_DIR : XF_VFS_DT_REG;
+        return &dir->ent;
+    }
+    return NULL;
+}
+
+static void ramfs_seekdir(void *ctx, xf_vfs_dir_t *pdir, long offset)
+{
+    ramfs_dir_t *dir = (ramfs_dir_t *)pdir;
+    dir->pos = (int)offset;
+}
+
+static int ramfs_closedir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    xf_free(pdir);
+    return 0;
+}
+
+static int ramfs_mkdir(void *ctx, const char *name, xf_vfs_mode_t mode)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    if (xf_strcmp(name, "/") == 0 || ramfs_find(fs, name) >= 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (!ramfs_parent_exists(fs, name)) {
+        errno = ENOENT;
+        return -1;
+    }
+    return (ramfs_alloc_node(fs, name, true) < 0) ? -1 : 0;
+}
+
+static int ramfs_rmdir(void *ctx, const char *name)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    int idx = ramfs_find(fs, name);
+    if (idx < 0 || !fs->nodes[idx].is_dir) {
+        errno = ENOENT;
+        return -1;
+    }
+    for (int i = 0; i < RAMFS_NODES_MAX; ++i) {
+        if (fs->nodes[i].used && ramfs_is_child(name, fs->nodes[i].path)) {
+            errno = ENOTEMPTY;
+            return -1;
+        }
+    }
+    xf_memset(&fs->nodes[idx], 0, sizeof(ramfs_node_t));
+    return 0;
+}
+
+static int ramfs_access(void *ctx, const char *path, int amode)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    if (xf_strcmp(path, "/") == 0 || ramfs_find(fs, path) >= 0) {
+        return 0;
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+static int ramfs_truncate(void *ctx, const char *path, xf_vfs_off_t length)
+{
+    ramfs_t *fs = ctx;
+    ++fs->calls;
+    int idx = ramfs_find(fs, path);
+    if (idx < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    ramfs_node_t *node = &fs->nodes[idx];
+    if (length < 0 || ramfs_reserve(node, (size_t)length) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((size_t)length > node->size) {
+        xf_memset(node->data + node->size, 0, (size_t)length - node->size);
+    }
+    node->size = (size_t)length;
+    return 0;
+}
+
+static int ramfs_ftruncate(void *ctx, int fd, xf_vfs_off_t length)
+{
+    ramfs_t *fs = ctx;
+    ramfs_fd_t *f = ramfs_get_fd(fs, fd);
+    if (f == NULL) {
+        return -1;
+    }
+    return ramfs_truncate(ctx, fs->nodes[f->node].path, length);
+}
@@ -0,0 +1,84 @@
+/**
+ * @file ramfs.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 例程共用的最小内存文件系统，仅用于测试及基准测试。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __RAMFS_H__
+#define __RAMFS_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define RAMFS_NODES_MAX     64
+#define RAMFS_FDS_MAX       16
+#define RAMFS_PATH_MAX      64
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct {
+    bool used;
+    bool is_dir;
+    char path[RAMFS_PATH_MAX];  /*!< 文件系统内的路径，如 "/a/b" */
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+} ramfs_node_t;
+
+typedef struct {
+    bool used;
+    int node;
+    int flags;
+    xf_vfs_off_t offset;
+} ramfs_fd_t;
+
+/**
+ * @brief ramfs 实例。
+ */
+typedef struct {
+    ramfs_node_t nodes[RAMFS_NODES_MAX];
+    ramfs_fd_t fds[RAMFS_FDS_MAX];
+    uint32_t calls;             /*!< 驱动被调用的次数，测试用 */
+} ramfs_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 在 base_path 上挂载一个新的 ramfs 实例。
+ *
+ * @param base_path 挂载点。
+ * @param[out] out 成功时写入 ramfs 实例，可以为 NULL.
+ * @return xf_err_t
+ */
+xf_err_t ramfs_mount(const char *base_path, ramfs_t **out);
+
+/**
+ * @brief 卸载并释放 ramfs 实例。
+ */
+xf_err_t ramfs_unmount(const char *base_path, ramfs_t *fs);
+
+/**
+ * @brief 获取 ramfs 使用的操作表。
+ */
+const xf_vfs_fs_ops_t *ramfs_get_ops(void);
+
+/* ==================== [Macros] ============================================ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __RAMFS_H__ */
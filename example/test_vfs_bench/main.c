@@ -0,0 +1,317 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 负载生成器测试：作业文件解析、顺序/随机/混合读写、多线程、元数据负载与延迟统计。
+ * @version 1.0
+ * @date 2025-01-22
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+#include "xf_vfs_bench.h"
+#include "xf_vfs_fault.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static bool dir_is_empty(const char *path);
+
+static void TEST_CASE_bench_parse(void);
+static void TEST_CASE_bench_sequential(void);
+static void TEST_CASE_bench_mixed_threads(void);
+static void TEST_CASE_bench_meta(void);
+static void TEST_CASE_bench_latency(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static volatile uint64_t s_clock_ns;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+uint64_t test_clock_ns(void)
+{
+    return s_clock_ns;
+}
+
+void test_delay_us(uint32_t us)
+{
+    s_clock_ns += (uint64_t)us * 1000;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ram/b", 0777));
+
+    TEST_CASE_bench_parse();
+    TEST_CASE_bench_sequential();
+    TEST_CASE_bench_mixed_threads();
+    TEST_CASE_bench_meta();
+    TEST_CASE_bench_latency();
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_rmdir("/ram/b"));
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+    return 0;
+}
+
+/* 默认值、[global] 继承、单位、注释与错误 */
+static void TEST_CASE_bench_parse(void)
+{
+    xf_vfs_bench_job_t jobs[3];
+    size_t count;
+
+    TEST_XF_OK(xf_vfs_bench_parse(
+                   "# comment\n"
+                   "[global]\n"
+                   "directory = /ram/b\r\n"
+                   "size=1M\n"
+                   "\n"
+                   "[first]\n"
+                   "rw=randwrite\n"
+                   "bs=512\n"
+                   "; comment\n"
+                   "[global]\n"
+                   "bs=2k\n"
+                   "[second]\n"
+                   "rw=meta\n"
+                   "nrfiles=100\n"
+                   "numjobs=4\n"
+                   "rwmixread=70\n"
+                   "ios=10\n"
+                   "fsync=8\n"
+                   "seed=7",
+                   jobs, 3, &count));
+    TEST_ASSERT_EQUAL(2, count);
+    TEST_ASSERT(xf_strcmp(jobs[0].name, "first") == 0);
+    TEST_ASSERT(xf_strcmp(jobs[0].directory, "/ram/b") == 0);
+    TEST_ASSERT_EQUAL(XF_VFS_BENCH_RW_RANDWRITE, jobs[0].rw);
+    TEST_ASSERT_EQUAL(512u, jobs[0].bs);
+    TEST_ASSERT_EQUAL(1024u * 1024u, jobs[0].size);
+    TEST_ASSERT_EQUAL(1u, jobs[0].nrfiles);
+    TEST_ASSERT_EQUAL(1, jobs[0].numjobs);
+    TEST_ASSERT_EQUAL(50, jobs[0].rwmixread);
+    TEST_ASSERT_EQUAL(0u, jobs[0].ios);
+    TEST_ASSERT_EQUAL(1u, jobs[0].seed);
+
+    /* 之后修改的 [global] 只影响之后的作业 */
+    TEST_ASSERT(xf_strcmp(jobs[1].name, "second") == 0);
+    TEST_ASSERT(xf_strcmp(jobs[1].directory, "/ram/b") == 0);
+    TEST_ASSERT_EQUAL(XF_VFS_BENCH_RW_META, jobs[1].rw);
+    TEST_ASSERT_EQUAL(2048u, jobs[1].bs);
+    TEST_ASSERT_EQUAL(100u, jobs[1].nrfiles);
+    TEST_ASSERT_EQUAL(4, jobs[1].numjobs);
+    TEST_ASSERT_EQUAL(70, jobs[1].rwmixread);
+    TEST_ASSERT_EQUAL(10u, jobs[1].ios);
+    TEST_ASSERT_EQUAL(8u, jobs[1].fsync);
+    TEST_ASSERT_EQUAL(7u, jobs[1].seed);
+
+    static const char *const bad[] = {
+        "[a]\nrw=append",
+        "[a]\nbs=4G",
+        "[a]\nbs=4KB",
+        "[a]\nbs=",
+        "[a]\nnumjobs=0",
+        "[a]\nrwmixread=101",
+        "[a]\nspeed=1",
+        "[a]\nrw",
+        "[a\nrw=read",
+        "[]",
+        "[a-name-that-is-too-long]",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_bench_parse(bad[i], jobs, 3, &count));
+    }
+    TEST_ASSERT_EQUAL(XF_ERR_NO_MEM, xf_vfs_bench_parse("[a]\n[b]\n[c]\n[d]", jobs, 3, &count));
+    TEST_XF_OK(xf_vfs_bench_parse("", jobs, 3, &count));
+    TEST_ASSERT_EQUAL(0, count);
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 顺序写满所有文件、按间隔 fsync，之后顺序读；结束后删除文件 */
+static void TEST_CASE_bench_sequential(void)
+{
+    xf_vfs_bench_job_t jobs[2];
+    xf_vfs_bench_result_t result;
+    size_t count;
+    TEST_XF_OK(xf_vfs_bench_parse(
+                   "[global]\n"
+                   "directory=/ram/b\n"
+                   "bs=1K\n"
+                   "size=16K\n"
+                   "nrfiles=2\n"
+                   "[seqwrite]\n"
+                   "rw=write\n"
+                   "fsync=4\n"
+                   "[seqread]\n"
+                   "rw=read\n",
+                   jobs, 2, &count));
+    TEST_ASSERT_EQUAL(2, count);
+
+    TEST_XF_OK(xf_vfs_bench_run(&jobs[0], &result));
+    TEST_ASSERT_EQUAL(0u, result.errors);
+    TEST_ASSERT_EQUAL(32u, result.op[XF_VFS_BENCH_OP_WRITE].ios);
+    TEST_ASSERT_EQUAL(32u * 1024u, result.op[XF_VFS_BENCH_OP_WRITE].bytes);
+    TEST_ASSERT_EQUAL(8u, result.op[XF_VFS_BENCH_OP_FSYNC].ios);
+    TEST_ASSERT_EQUAL(0u, result.op[XF_VFS_BENCH_OP_READ].ios);
+    TEST_ASSERT(dir_is_empty("/ram/b"));
+    xf_vfs_bench_report(&jobs[0], &result);
+
+    TEST_XF_OK(xf_vfs_bench_run(&jobs[1], &result));
+    TEST_ASSERT_EQUAL(0u, result.errors);
+    TEST_ASSERT_EQUAL(32u, result.op[XF_VFS_BENCH_OP_READ].ios);
+    TEST_ASSERT_EQUAL(32u * 1024u, result.op[XF_VFS_BENCH_OP_READ].bytes);
+    TEST_ASSERT_EQUAL(0u, result.op[XF_VFS_BENCH_OP_WRITE].ios);
+    TEST_ASSERT(dir_is_empty("/ram/b"));
+
+    /* 非法作业与无法准备的文件 */
+    xf_vfs_bench_job_t job = jobs[1];
+    job.bs = job.size + 1;
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_bench_run(&job, &result));
+    job = jobs[1];
+    job.numjobs = XF_VFS_BENCH_THREADS_MAX + 1;
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_bench_run(&job, &result));
+    job = jobs[1];
+    job.directory[0] = '\0';
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_bench_run(&job, &result));
+    job = jobs[1];
+    xf_memcpy(job.directory, "/ram/missing", sizeof("/ram/missing"));
+    TEST_ASSERT_EQUAL(XF_FAIL, xf_vfs_bench_run(&job, &result));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 随机混合读写按比例分配，相同的种子结果相同；多个线程各自完成 ios 次 */
+static void TEST_CASE_bench_mixed_threads(void)
+{
+    xf_vfs_bench_job_t job;
+    xf_vfs_bench_result_t result;
+    xf_vfs_bench_job_init(&job);
+    xf_memcpy(job.name, "mix", sizeof("mix"));
+    xf_memcpy(job.directory, "/ram/b", sizeof("/ram/b"));
+    job.rw = XF_VFS_BENCH_RW_RANDRW;
+    job.rwmixread = 70;
+    job.bs = 256;
+    job.size = 8 * 1024;
+    job.ios = 1000;
+
+    TEST_XF_OK(xf_vfs_bench_run(&job, &result));
+    const uint32_t reads = result.op[XF_VFS_BENCH_OP_READ].ios;
+    TEST_ASSERT_EQUAL(0u, result.errors);
+    TEST_ASSERT(reads > 620 && reads < 780);
+    TEST_ASSERT_EQUAL(1000u, reads + result.op[XF_VFS_BENCH_OP_WRITE].ios);
+    TEST_XF_OK(xf_vfs_bench_run(&job, &result));
+    TEST_ASSERT_EQUAL(reads, result.op[XF_VFS_BENCH_OP_READ].ios);
+
+    job.rw = XF_VFS_BENCH_RW_RANDREAD;
+    job.numjobs = 4;
+    job.nrfiles = 3;
+    job.ios = 200;
+    TEST_XF_OK(xf_vfs_bench_run(&job, &result));
+    TEST_ASSERT_EQUAL(0u, result.errors);
+    TEST_ASSERT_EQUAL(800u, result.op[XF_VFS_BENCH_OP_READ].ios);
+    TEST_ASSERT_EQUAL(800u * 256u, result.op[XF_VFS_BENCH_OP_READ].bytes);
+    TEST_ASSERT(dir_is_empty("/ram/b"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 每个线程创建、stat、删除各自的 nrfiles 个文件 */
+static void TEST_CASE_bench_meta(void)
+{
+    xf_vfs_bench_job_t job;
+    xf_vfs_bench_result_t result;
+    size_t count;
+    TEST_XF_OK(xf_vfs_bench_parse("[files]\nrw=meta\ndirectory=/ram/b/\nnrfiles=20\nnumjobs=4",
+                                  &job, 1, &count));
+    TEST_XF_OK(xf_vfs_bench_run(&job, &result));
+    TEST_ASSERT_EQUAL(0u, result.errors);
+    TEST_ASSERT_EQUAL(80u, result.op[XF_VFS_BENCH_OP_CREATE].ios);
+    TEST_ASSERT_EQUAL(80u, result.op[XF_VFS_BENCH_OP_STAT].ios);
+    TEST_ASSERT_EQUAL(80u, result.op[XF_VFS_BENCH_OP_UNLINK].ios);
+    TEST_ASSERT_EQUAL(0u, result.op[XF_VFS_BENCH_OP_READ].ios);
+    TEST_ASSERT(dir_is_empty("/ram/b"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 通过 fault 驱动注入固定延迟，统计得到的延迟与用时与注入的一致 */
+static void TEST_CASE_bench_latency(void)
+{
+    xf_vfs_bench_job_t job;
+    xf_vfs_bench_result_t result;
+    size_t count;
+    TEST_XF_OK(xf_vfs_fault_register("/slow", "/ram", 1));
+    TEST_XF_OK(xf_vfs_fault_configure("/slow", "pread fixed=100us; pwrite fixed=1ms"));
+    TEST_XF_OK(xf_vfs_bench_parse("[lat]\nrw=randread\ndirectory=/slow/b\nbs=512\nsize=4K\nios=100",
+                                  &job, 1, &count));
+
+    /* 准备文件时的写入不计入用时 */
+    TEST_XF_OK(xf_vfs_bench_run(&job, &result));
+    TEST_ASSERT_EQUAL(0u, result.errors);
+    TEST_ASSERT_EQUAL(100u, result.op[XF_VFS_BENCH_OP_READ].ios);
+    TEST_ASSERT_EQUAL(100u * 100000u, result.elapsed_ns);
+    const xf_vfs_latency_hist_t *lat = &result.op[XF_VFS_BENCH_OP_READ].lat;
+    TEST_ASSERT_EQUAL(100u, lat->count);
+    TEST_ASSERT_EQUAL(100000u, lat->max);
+    TEST_ASSERT_EQUAL(100000u, xf_vfs_latency_value_at(lat, 5000));
+    TEST_ASSERT_EQUAL(100000u, xf_vfs_latency_value_at(lat, 9990));
+    xf_vfs_bench_report(&job, &result);
+
+    TEST_XF_OK(xf_vfs_fault_unregister("/slow"));
+    TEST_ASSERT(dir_is_empty("/ram/b"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static bool dir_is_empty(const char *path)
+{
+    xf_vfs_dir_t *dir = xf_vfs_opendir(path);
+    if (dir == NULL) {
+        return false;
+    }
+    const bool empty = (xf_vfs_readdir(dir) == NULL);
+    xf_vfs_closedir(dir);
+    return empty;
+}
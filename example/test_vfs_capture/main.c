@@ -0,0 +1,345 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief capture 驱动与重放测试：记录到文件、路径匿名化、尽快与按原始时间重放，以及错误处理。
+ * @version 1.0
+ * @date 2025-01-21
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+#include "xf_vfs_capture.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define TRACE_FILE          "/ram/trace.bin"
+#define WORKLOAD_OPS        (17)
+#define TICK_NS             (1000000)
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+} mem_reader_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static xf_vfs_ssize_t file_write(const void *data, size_t size, void *arg);
+static xf_vfs_ssize_t file_read(void *dst, size_t size, void *arg);
+static xf_vfs_ssize_t mem_read(void *dst, size_t size, void *arg);
+static xf_vfs_ssize_t failing_write(const void *data, size_t size, void *arg);
+static void tick(void);
+static void run_workload(void);
+static size_t load_trace(void);
+static bool contains(const uint8_t *data, size_t len, const char *s);
+
+static void TEST_CASE_capture_to_file(void);
+static void TEST_CASE_replay_fast(void);
+static void TEST_CASE_replay_timed(void);
+static void TEST_CASE_capture_errors(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static uint64_t s_clock_ns;
+static uint8_t s_trace[512];
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+uint64_t test_clock_ns(void)
+{
+    return s_clock_ns;
+}
+
+void test_delay_us(uint32_t us)
+{
+    s_clock_ns += (uint64_t)us * 1000;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+
+    TEST_CASE_capture_to_file();
+    TEST_CASE_replay_fast();
+    TEST_CASE_replay_timed();
+    TEST_CASE_capture_errors();
+
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+    return 0;
+}
+
+/* 记录一段负载到 ramfs 上的文件，记录中不含路径名 */
+static void TEST_CASE_capture_to_file(void)
+{
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ram/data", 0777));
+    int out = xf_vfs_open(TRACE_FILE, XF_VFS_O_WRONLY | XF_VFS_O_CREAT | XF_VFS_O_TRUNC, 0666);
+    TEST_ASSERT(out >= 0);
+    TEST_XF_OK(xf_vfs_capture_start("/cap", "/ram/data", file_write, &out));
+    run_workload();
+    TEST_XF_OK(xf_vfs_capture_stop("/cap"));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(out));
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_STATE, xf_vfs_capture_stop("/cap"));
+
+    /* 负载原样作用在目标目录上 */
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/ram/data/secret_dir/private.old", &st));
+    TEST_ASSERT_EQUAL(250, st.st_size);
+
+    const size_t len = load_trace();
+    const xf_vfs_capture_header_t *hdr = (const xf_vfs_capture_header_t *)s_trace;
+    TEST_ASSERT(xf_memcmp(hdr->magic, XF_VFS_CAPTURE_MAGIC, 4) == 0);
+    TEST_ASSERT_EQUAL(XF_VFS_CAPTURE_VERSION, hdr->version);
+    TEST_ASSERT(!contains(s_trace, len, "secret"));
+    TEST_ASSERT(!contains(s_trace, len, "private"));
+    TEST_ASSERT(!contains(s_trace, len, "missing"));
+    /* 每条记录不到 10 字节 */
+    TEST_ASSERT(len < sizeof(xf_vfs_capture_header_t) + WORKLOAD_OPS * 10);
+    XF_LOGI(TAG, "%s passed (%d bytes)", __FUNCTION__, (int)len);
+}
+
+/* 尽快重放：目录结构与大小一致，名字被替换为编号 */
+static void TEST_CASE_replay_fast(void)
+{
+    xf_vfs_replay_stats_t stats;
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ram/fast", 0777));
+
+    int in = xf_vfs_open(TRACE_FILE, XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(in >= 0);
+    const uint64_t t0 = s_clock_ns;
+    TEST_XF_OK(xf_vfs_replay("/ram/fast", file_read, &in, false, &stats));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(in));
+    xf_vfs_replay_report(&stats);
+
+    TEST_ASSERT_EQUAL(WORKLOAD_OPS, stats.ops);
+    TEST_ASSERT_EQUAL(0, stats.mismatches);
+    TEST_ASSERT_EQUAL(0, stats.skipped);
+    TEST_ASSERT_EQUAL(150, stats.bytes_written);
+    TEST_ASSERT_EQUAL(84, stats.bytes_read);
+    TEST_ASSERT_EQUAL(2, stats.op[XF_VFS_TRACE_OP_OPEN].count);
+    TEST_ASSERT_EQUAL(2, stats.op[XF_VFS_TRACE_OP_READDIR].count);
+    TEST_ASSERT_EQUAL((uint64_t)(WORKLOAD_OPS - 1) * TICK_NS, stats.recorded_ns);
+    TEST_ASSERT_EQUAL(0, stats.elapsed_ns);
+    TEST_ASSERT_EQUAL(t0, s_clock_ns);
+
+    /* secret_dir -> n0, private.db -> n1, private.old -> n2 */
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/ram/fast/n0/n2", &st));
+    TEST_ASSERT_EQUAL(250, st.st_size);
+    TEST_ASSERT_EQUAL(-1, xf_vfs_stat("/ram/fast/n0/n1", &st));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 按原始时间重放：用时等于记录时的时长 */
+static void TEST_CASE_replay_timed(void)
+{
+    xf_vfs_replay_stats_t stats;
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ram/timed", 0777));
+
+    int in = xf_vfs_open(TRACE_FILE, XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(in >= 0);
+    TEST_XF_OK(xf_vfs_replay("/ram/timed", file_read, &in, true, &stats));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(in));
+
+    TEST_ASSERT_EQUAL(WORKLOAD_OPS, stats.ops);
+    TEST_ASSERT_EQUAL(0, stats.mismatches);
+    TEST_ASSERT_EQUAL(stats.recorded_ns, stats.elapsed_ns);
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/ram/timed/n0/n2", &st));
+
+    /* 在已有的结果上再次重放：mkdir 失败，目录中多出一项使第二次 readdir 不再到达结尾 */
+    in = xf_vfs_open(TRACE_FILE, XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(in >= 0);
+    TEST_XF_OK(xf_vfs_replay("/ram/timed", file_read, &in, false, &stats));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(in));
+    TEST_ASSERT_EQUAL(WORKLOAD_OPS, stats.ops);
+    TEST_ASSERT_EQUAL(2, stats.mismatches);
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 输出失败、数据损坏与版本不符 */
+static void TEST_CASE_capture_errors(void)
+{
+    int budget = 0;
+    TEST_ASSERT_EQUAL(XF_FAIL, xf_vfs_capture_start("/cap", "/ram/data", failing_write, &budget));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_open("/cap/x", XF_VFS_O_RDONLY, 0));
+
+    /* 头部之后输出失败：转发不受影响，停止时报告丢失 */
+    budget = 1;
+    TEST_XF_OK(xf_vfs_capture_start("/cap", "/ram/data", failing_write, &budget));
+    for (int i = 0; i < 100; ++i) {
+        TEST_ASSERT_EQUAL(0, xf_vfs_access("/cap/secret_dir", XF_VFS_F_OK));
+    }
+    TEST_ASSERT_EQUAL(XF_FAIL, xf_vfs_capture_stop("/cap"));
+
+    const size_t len = load_trace();
+    mem_reader_t mr = { s_trace, len - 1, 0 };
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_replay("/ram/timed", mem_read, &mr, false, NULL));
+
+    s_trace[0] = 'x';
+    mr = (mem_reader_t){ s_trace, len, 0 };
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_replay("/ram/timed", mem_read, &mr, false, NULL));
+    s_trace[0] = XF_VFS_CAPTURE_MAGIC[0];
+
+    ((xf_vfs_capture_header_t *)s_trace)->version = XF_VFS_CAPTURE_VERSION + 1;
+    mr = (mem_reader_t){ s_trace, len, 0 };
+    TEST_ASSERT_EQUAL(XF_ERR_NOT_SUPPORTED, xf_vfs_replay("/ram/timed", mem_read, &mr, false, NULL));
+    ((xf_vfs_capture_header_t *)s_trace)->version = XF_VFS_CAPTURE_VERSION;
+
+    s_trace[sizeof(xf_vfs_capture_header_t)] = XF_VFS_TRACE_OP_MAX;
+    mr = (mem_reader_t){ s_trace, len, 0 };
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_replay("/ram/timed", mem_read, &mr, false, NULL));
+
+    /* 只有头部：没有记录 */
+    xf_vfs_replay_stats_t stats;
+    mr = (mem_reader_t){ s_trace, sizeof(xf_vfs_capture_header_t), 0 };
+    TEST_XF_OK(xf_vfs_replay("/ram/timed", mem_read, &mr, true, &stats));
+    TEST_ASSERT_EQUAL(0, stats.ops);
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void tick(void)
+{
+    s_clock_ns += TICK_NS;
+}
+
+static void run_workload(void)
+{
+    static const char data[100];
+    char buf[64];
+    xf_vfs_stat_t st;
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/cap/secret_dir", 0777));
+    tick();
+    int fd = xf_vfs_open("/cap/secret_dir/private.db", XF_VFS_O_RDWR | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    tick();
+    TEST_ASSERT_EQUAL(100, xf_vfs_write(fd, data, 100));
+    tick();
+    TEST_ASSERT_EQUAL(50, xf_vfs_pwrite(fd, data, 50, 200));
+    tick();
+    TEST_ASSERT_EQUAL(20, xf_vfs_pread(fd, buf, 20, 0));
+    tick();
+    TEST_ASSERT_EQUAL(0, xf_vfs_lseek(fd, 0, XF_VFS_SEEK_SET));
+    tick();
+    TEST_ASSERT_EQUAL(64, xf_vfs_read(fd, buf, sizeof(buf)));
+    tick();
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstat(fd, &st));
+    tick();
+    TEST_ASSERT_EQUAL(0, xf_vfs_fsync(fd));
+    tick();
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    tick();
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/cap/secret_dir/private.db", &st));
+    tick();
+    xf_vfs_dir_t *dir = xf_vfs_opendir("/cap/secret_dir");
+    TEST_ASSERT(dir != NULL);
+    tick();
+    TEST_ASSERT(xf_vfs_readdir(dir) != NULL);
+    tick();
+    TEST_ASSERT(xf_vfs_readdir(dir) == NULL);
+    tick();
+    TEST_ASSERT_EQUAL(0, xf_vfs_closedir(dir));
+    tick();
+    TEST_ASSERT_EQUAL(0, xf_vfs_rename("/cap/secret_dir/private.db", "/cap/secret_dir/private.old"));
+    tick();
+    TEST_ASSERT_EQUAL(-1, xf_vfs_open("/cap/secret_dir/missing", XF_VFS_O_RDONLY, 0));
+}
+
+static size_t load_trace(void)
+{
+    int fd = xf_vfs_open(TRACE_FILE, XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    xf_vfs_ssize_t len = xf_vfs_read(fd, s_trace, sizeof(s_trace));
+    TEST_ASSERT(len > 0 && len < (xf_vfs_ssize_t)sizeof(s_trace));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    return (size_t)len;
+}
+
+static bool contains(const uint8_t *data, size_t len, const char *s)
+{
+    const size_t n = xf_strlen(s);
+    for (size_t i = 0; i + n <= len; ++i) {
+        if (xf_memcmp(data + i, s, n) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static xf_vfs_ssize_t file_write(const void *data, size_t size, void *arg)
+{
+    return xf_vfs_write(*(int *)arg, data, size);
+}
+
+static xf_vfs_ssize_t file_read(void *dst, size_t size, void *arg)
+{
+    return xf_vfs_read(*(int *)arg, dst, size);
+}
+
+static xf_vfs_ssize_t mem_read(void *dst, size_t size, void *arg)
+{
+    mem_reader_t *mr = arg;
+    size_t n = mr->len - mr->pos;
+    if (n > size) {
+        n = size;
+    }
+    xf_memcpy(dst, mr->data + mr->pos, n);
+    mr->pos += n;
+    return (xf_vfs_ssize_t)n;
+}
+
+/* 前 *budget 次成功，之后失败 */
+static xf_vfs_ssize_t failing_write(const void *data, size_t size, void *arg)
+{
+    int *budget = arg;
+    if (*budget <= 0) {
+        return -1;
+    }
+    --*budget;
+    return (xf_vfs_ssize_t)size;
+}
@@ -0,0 +1,487 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs_openat() 等相对目录操作测试：驱动原生实现与拼接路径回退。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define TREE_NODES_MAX  256
+#define TREE_NAME_MAX   16
+#define DEEP_PATH       "/tree/a/b/c/d/e"
+#define DEEP_LEVELS     5
+#define FILES           100
+
+/* ==================== [Typedefs] ========================================== */
+
+/*
+ * 按父节点 + 名称组织的树形文件系统，与常见 flash 文件系统一样
+ * 按路径查找时需要从根目录逐级查找，steps 记录查找的级数。
+ */
+typedef struct {
+    bool used;
+    bool is_dir;
+    int parent;
+    char name[TREE_NAME_MAX];
+} tree_node_t;
+
+typedef struct {
+    xf_vfs_dir_t base;
+    int node;
+    int pos;
+    xf_vfs_dirent_t ent;
+} tree_dir_t;
+
+typedef struct {
+    tree_node_t nodes[TREE_NODES_MAX];
+    uint32_t steps;
+} treefs_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int tree_child(treefs_t *fs, int parent, const char *name, size_t len);
+static int tree_lookup(treefs_t *fs, int start, const char *path, int *parent, const char **leaf);
+static int tree_create(treefs_t *fs, int parent, const char *leaf, bool is_dir);
+static int tree_remove(treefs_t *fs, int start, const char *path, bool is_dir);
+static int tree_open_from(treefs_t *fs, int start, const char *path, int flags);
+static int tree_stat_from(treefs_t *fs, int start, const char *path, xf_vfs_stat_t *st);
+static int tree_mkdir_from(treefs_t *fs, int start, const char *path);
+
+static int tree_open(void *ctx, const char *path, int flags, int mode);
+static int tree_close(void *ctx, int fd);
+static int tree_stat(void *ctx, const char *path, xf_vfs_stat_t *st);
+static int tree_unlink(void *ctx, const char *path);
+static int tree_mkdir(void *ctx, const char *path, xf_vfs_mode_t mode);
+static int tree_rmdir(void *ctx, const char *path);
+static xf_vfs_dir_t *tree_opendir(void *ctx, const char *path);
+static int tree_closedir(void *ctx, xf_vfs_dir_t *pdir);
+static int tree_openat(void *ctx, xf_vfs_dir_t *pdir, const char *name, int flags, int mode);
+static int tree_fstatat(void *ctx, xf_vfs_dir_t *pdir, const char *name, xf_vfs_stat_t *st);
+static int tree_unlinkat(void *ctx, xf_vfs_dir_t *pdir, const char *name, int flags);
+static int tree_mkdirat(void *ctx, xf_vfs_dir_t *pdir, const char *name, xf_vfs_mode_t mode);
+
+static void TEST_CASE_dirat_native(void);
+static void TEST_CASE_dirat_fallback(void);
+static void TEST_CASE_dirat_errors(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_dir_ops_t s_tree_dir_ops = {
+    .stat_p = tree_stat,
+    .unlink_p = tree_unlink,
+    .opendir_p = tree_opendir,
+    .closedir_p = tree_closedir,
+    .mkdir_p = tree_mkdir,
+    .rmdir_p = tree_rmdir,
+    .openat_p = tree_openat,
+    .fstatat_p = tree_fstatat,
+    .unlinkat_p = tree_unlinkat,
+    .mkdirat_p = tree_mkdirat,
+};
+
+static const xf_vfs_fs_ops_t s_tree_ops = {
+    .open_p = tree_open,
+    .close_p = tree_close,
+    .dir = &s_tree_dir_ops,
+};
+
+static treefs_t s_tree;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    s_tree.nodes[0].used = true;
+    s_tree.nodes[0].is_dir = true;
+    s_tree.nodes[0].parent = -1;
+    TEST_XF_OK(xf_vfs_register_fs("/tree", &s_tree_ops, XF_VFS_FLAG_CONTEXT_PTR | XF_VFS_FLAG_STATIC, &s_tree));
+
+    TEST_CASE_dirat_native();
+    TEST_CASE_dirat_fallback();
+    TEST_CASE_dirat_errors();
+
+    TEST_XF_OK(xf_vfs_unregister_fs("/tree"));
+    return 0;
+}
+
+static void TEST_CASE_dirat_native(void)
+{
+    char path[64];
+    char name[16];
+    xf_vfs_stat_t st;
+    xf_snprintf(path, sizeof(path), "/tree");
+    for (const char *p = "abcde"; *p; ++p) {
+        xf_snprintf(path + xf_strlen(path), sizeof(path) - xf_strlen(path), "/%c", *p);
+        TEST_ASSERT_EQUAL(0, xf_vfs_mkdir(path, 0777));
+    }
+
+    /* 完整路径：每次从根目录逐级查找 */
+    s_tree.steps = 0;
+    for (int i = 0; i < FILES; ++i) {
+        xf_snprintf(path, sizeof(path), DEEP_PATH "/p%d", i);
+        int fd = xf_vfs_open(path, XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+        TEST_ASSERT(fd >= 0);
+        TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+        TEST_ASSERT_EQUAL(0, xf_vfs_stat(path, &st));
+    }
+    const uint32_t steps_path = s_tree.steps;
+
+    /* 目录句柄：从 DEEP_PATH 开始查找 */
+    xf_vfs_dirat_t *dir = xf_vfs_dirat_open(DEEP_PATH);
+    TEST_ASSERT(dir != NULL);
+    s_tree.steps = 0;
+    for (int i = 0; i < FILES; ++i) {
+        xf_snprintf(name, sizeof(name), "q%d", i);
+        int fd = xf_vfs_openat(dir, name, XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+        TEST_ASSERT(fd >= 0);
+        TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+        TEST_ASSERT_EQUAL(0, xf_vfs_fstatat(dir, name, &st));
+        TEST_ASSERT_EQUAL(XF_VFS_S_IFREG, st.st_mode & XF_VFS_S_IFMT);
+    }
+    const uint32_t steps_at = s_tree.steps;
+    XF_LOGI(TAG, "lookup steps for %d files: path %u, at %u", FILES, (unsigned)steps_path, (unsigned)steps_at);
+    TEST_ASSERT_EQUAL(steps_path, steps_at * (DEEP_LEVELS + 1));
+
+    /* 相对路径可以包含子目录 */
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdirat(dir, "sub", 0777));
+    int fd = xf_vfs_openat(dir, "sub/f", XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat(DEEP_PATH "/sub/f", &st));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_unlinkat(dir, "sub", XF_VFS_AT_REMOVEDIR));
+    TEST_ASSERT_EQUAL(ENOTEMPTY, errno);
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlinkat(dir, "sub/f", 0));
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlinkat(dir, "sub", XF_VFS_AT_REMOVEDIR));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_fstatat(dir, "sub", &st));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+
+    for (int i = 0; i < FILES; ++i) {
+        xf_snprintf(name, sizeof(name), "q%d", i);
+        TEST_ASSERT_EQUAL(0, xf_vfs_unlinkat(dir, name, 0));
+        xf_snprintf(path, sizeof(path), DEEP_PATH "/p%d", i);
+        TEST_ASSERT_EQUAL(0, xf_vfs_unlinkat(dir, path, 0)); /* 绝对路径忽略 dir */
+    }
+    TEST_ASSERT_EQUAL(0, xf_vfs_dirat_close(dir));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* ramfs 没有 *at 函数：VFS 拼接路径后调用普通函数 */
+static void TEST_CASE_dirat_fallback(void)
+{
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ram/d", 0777));
+
+    xf_vfs_dirat_t *dir = xf_vfs_dirat_open("/ram/d/");
+    TEST_ASSERT(dir != NULL);
+    int fd = xf_vfs_openat(dir, "f", XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(3, xf_vfs_write(fd, "abc", 3));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstatat(dir, "f", &st));
+    TEST_ASSERT_EQUAL(3, st.st_size);
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/ram/d/f", &st));
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdirat(dir, "sub", 0777));
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/ram/d/sub", &st));
+    TEST_ASSERT_EQUAL(XF_VFS_S_IFDIR, st.st_mode & XF_VFS_S_IFMT);
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlinkat(dir, "sub", XF_VFS_AT_REMOVEDIR));
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlinkat(dir, "f", 0));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_stat("/ram/d/f", &st));
+    TEST_ASSERT_EQUAL(0, xf_vfs_dirat_close(dir));
+
+    /* 挂载点根目录 */
+    dir = xf_vfs_dirat_open("/ram");
+    TEST_ASSERT(dir != NULL);
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstatat(dir, "d", &st));
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlinkat(dir, "d", XF_VFS_AT_REMOVEDIR));
+    TEST_ASSERT_EQUAL(0, xf_vfs_dirat_close(dir));
+
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_dirat_errors(void)
+{
+    TEST_ASSERT(xf_vfs_dirat_open("/tree/none") == NULL);
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+    int fd = xf_vfs_open("/ram/f", XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT(xf_vfs_dirat_open("/ram/f") == NULL);
+    TEST_ASSERT_EQUAL(ENOTDIR, errno);
+
+    xf_vfs_dirat_t *dir = xf_vfs_dirat_open("/ram");
+    TEST_ASSERT(dir != NULL);
+    TEST_ASSERT_EQUAL(-1, xf_vfs_unlinkat(dir, "f", 0x100));
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(-1, xf_vfs_fstatat(dir, "", &st));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlinkat(dir, "f", 0));
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+
+    /* 挂载点注销后句柄失效 */
+    TEST_ASSERT_EQUAL(-1, xf_vfs_fstatat(dir, "f", &st));
+    TEST_ASSERT_EQUAL(EBADF, errno);
+    TEST_ASSERT_EQUAL(0, xf_vfs_dirat_close(dir));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 在 parent 下查找 name 的前 len 个字符，每次调用算一级 */
+static int tree_child(treefs_t *fs, int parent, const char *name, size_t len)
+{
+    ++fs->steps;
+    for (int i = 1; i < TREE_NODES_MAX; ++i) {
+        const tree_node_t *node = &fs->nodes[i];
+        if (node->used && node->parent == parent
+                && xf_strncmp(node->name, name, len) == 0 && node->name[len] == '\0') {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * 从 start 开始查找 path 的上级目录，*leaf 指向最后一级名称。
+ * 返回 path 本身对应的节点，不存在时返回 -1（*parent 仍有效时可创建）。
+ */
+static int tree_lookup(treefs_t *fs, int start, const char *path, int *parent, const char **leaf)
+{
+    int node = start;
+    *parent = -1;
+    *leaf = "";
+    while (*path == '/') {
+        ++path;
+    }
+    while (*path != '\0') {
+        const char *end = path;
+        while (*end != '\0' && *end != '/') {
+            ++end;
+        }
+        if (node < 0 || !fs->nodes[node].is_dir) {
+            *parent = -1;
+            return -1;
+        }
+        *parent = node;
+        *leaf = path;
+        node = tree_child(fs, node, path, (size_t)(end - path));
+        path = end;
+        while (*path == '/') {
+            ++path;
+        }
+    }
+    return node;
+}
+
+static int tree_create(treefs_t *fs, int parent, const char *leaf, bool is_dir)
+{
+    if (parent < 0 || xf_strlen(leaf) >= TREE_NAME_MAX) {
+        errno = ENOENT;
+        return -1;
+    }
+    for (int i = 1; i < TREE_NODES_MAX; ++i) {
+        tree_node_t *node = &fs->nodes[i];
+        if (!node->used) {
+            node->used = true;
+            node->is_dir = is_dir;
+            node->parent = parent;
+            xf_memcpy(node->name, leaf, xf_strlen(leaf) + 1);
+            return i;
+        }
+    }
+    errno = ENOSPC;
+    return -1;
+}
+
+static int tree_remove(treefs_t *fs, int start, const char *path, bool is_dir)
+{
+    int parent;
+    const char *leaf;
+    const int node = tree_lookup(fs, start, path, &parent, &leaf);
+    if (node <= 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (fs->nodes[node].is_dir != is_dir) {
+        errno = is_dir ? ENOTDIR : EISDIR;
+        return -1;
+    }
+    for (int i = 1; i < TREE_NODES_MAX; ++i) {
+        if (fs->nodes[i].used && fs->nodes[i].parent == node) {
+            errno = ENOTEMPTY;
+            return -1;
+        }
+    }
+    fs->nodes[node].used = false;
+    return 0;
+}
+
+static int tree_open_from(treefs_t *fs, int start, const char *path, int flags)
+{
+    int parent;
+    const char *leaf;
+    int node = tree_lookup(fs, start, path, &parent, &leaf);
+    if (node < 0 && (flags & XF_VFS_O_CREAT)) {
+        node = tree_create(fs, parent, leaf, false);
+    }
+    if (node < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    return node;
+}
+
+static int tree_stat_from(treefs_t *fs, int start, const char *path, xf_vfs_stat_t *st)
+{
+    int parent;
+    const char *leaf;
+    const int node = tree_lookup(fs, start, path, &parent, &leaf);
+    if (node < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    xf_memset(st, 0, sizeof(xf_vfs_stat_t));
+    st->st_mode = fs->nodes[node].is_dir ? (XF_VFS_S_IFDIR | 0755) : (XF_VFS_S_IFREG | 0644);
+    return 0;
+}
+
+static int tree_mkdir_from(treefs_t *fs, int start, const char *path)
+{
+    int parent;
+    const char *leaf;
+    if (tree_lookup(fs, start, path, &parent, &leaf) >= 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    return (tree_create(fs, parent, leaf, true) < 0) ? -1 : 0;
+}
+
+static int tree_open(void *ctx, const char *path, int flags, int mode)
+{
+    return tree_open_from(ctx, 0, path, flags);
+}
+
+static int tree_close(void *ctx, int fd)
+{
+    return 0;
+}
+
+static int tree_stat(void *ctx, const char *path, xf_vfs_stat_t *st)
+{
+    return tree_stat_from(ctx, 0, path, st);
+}
+
+static int tree_unlink(void *ctx, const char *path)
+{
+    return tree_remove(ctx, 0, path, false);
+}
+
+static int tree_mkdir(void *ctx, const char *path, xf_vfs_mode_t mode)
+{
+    return tree_mkdir_from(ctx, 0, path);
+}
+
+static int tree_rmdir(void *ctx, const char *path)
+{
+    return tree_remove(ctx, 0, path, true);
+}
+
+static xf_vfs_dir_t *tree_opendir(void *ctx, const char *path)
+{
+    treefs_t *fs = ctx;
+    int parent;
+    const char *leaf;
+    const int node = tree_lookup(fs, 0, path, &parent, &leaf);
+    if (node < 0 || !fs->nodes[node].is_dir) {
+        errno = ENOENT;
+        return NULL;
+    }
+    tree_dir_t *dir = xf_malloc(sizeof(tree_dir_t));
+    if (dir == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    xf_memset(dir, 0, sizeof(tree_dir_t));
+    dir->node = node;
+    return &dir->base;
+}
+
+static int tree_closedir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    xf_free(pdir);
+    return 0;
+}
+
+static int tree_openat(void *ctx, xf_vfs_dir_t *pdir, const char *name, int flags, int mode)
+{
+    return tree_open_from(ctx, ((tree_dir_t *)pdir)->node, name, flags);
+}
+
+static int tree_fstatat(void *ctx, xf_vfs_dir_t *pdir, const char *name, xf_vfs_stat_t *st)
+{
+    return tree_stat_from(ctx, ((tree_dir_t *)pdir)->node, name, st);
+}
+
+static int tree_unlinkat(void *ctx, xf_vfs_dir_t *pdir, const char *name, int flags)
+{
+    return tree_remove(ctx, ((tree_dir_t *)pdir)->node, name, (flags & XF_VFS_AT_REMOVEDIR) != 0);
+}
+
+static int tree_mkdirat(void *ctx, xf_vfs_dir_t *pdir, const char *name, xf_vfs_mode_t mode)
+{
+    return tree_mkdir_from(ctx, ((tree_dir_t *)pdir)->node, name);
+}
@@ -0,0 +1,183 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief dup/dup2/F_DUPFD 测试。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int driver_open_count(void);
+
+static void TEST_CASE_dup_shares_open_file(void);
+static void TEST_CASE_dup2_redirects_without_driver(void);
+static void TEST_CASE_fcntl_dupfd(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static ramfs_t *s_fs;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    TEST_XF_OK(ramfs_mount("/ram", &s_fs));
+
+    TEST_CASE_dup_shares_open_file();
+    TEST_CASE_dup2_redirects_without_driver();
+    TEST_CASE_fcntl_dupfd();
+
+    TEST_XF_OK(ramfs_unmount("/ram", s_fs));
+    return 0;
+}
+
+/* 驱动中仍打开的文件数 */
+static int driver_open_count(void)
+{
+    int n = 0;
+    for (int i = 0; i < RAMFS_FDS_MAX; ++i) {
+        n += s_fs->fds[i].used ? 1 : 0;
+    }
+    return n;
+}
+
+static void TEST_CASE_dup_shares_open_file(void)
+{
+    char buf[8] = {0};
+    int fd = xf_vfs_open("/ram/a", XF_VFS_O_RDWR | XF_VFS_O_CREAT | XF_VFS_O_TRUNC, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(6, xf_vfs_write(fd, "abcdef", 6));
+    TEST_ASSERT_EQUAL(0, xf_vfs_lseek(fd, 0, XF_VFS_SEEK_SET));
+
+    uint32_t calls = s_fs->calls;
+    int fd2 = xf_vfs_dup(fd);
+    TEST_ASSERT(fd2 >= 0 && fd2 != fd);
+    TEST_ASSERT_EQUAL(calls, s_fs->calls);
+
+    /* 偏移是共享的 */
+    TEST_ASSERT_EQUAL(3, xf_vfs_read(fd, buf, 3));
+    TEST_ASSERT_EQUAL(3, xf_vfs_read(fd2, buf, 3));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "def"));
+
+    /* 只有最后一次 close 调用驱动 */
+    calls = s_fs->calls;
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(calls, s_fs->calls);
+    TEST_ASSERT_EQUAL(1, driver_open_count());
+    TEST_ASSERT(xf_vfs_read(fd, buf, 1) < 0);
+    TEST_ASSERT_EQUAL(EBADF, errno);
+    TEST_ASSERT_EQUAL(0, xf_vfs_lseek(fd2, 0, XF_VFS_SEEK_SET));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd2));
+    TEST_ASSERT_EQUAL(0, driver_open_count());
+
+    TEST_ASSERT(xf_vfs_dup(fd2) < 0);
+    TEST_ASSERT_EQUAL(EBADF, errno);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_dup2_redirects_without_driver(void)
+{
+    char buf[8] = {0};
+    int log_fd = xf_vfs_open("/ram/log1", XF_VFS_O_WRONLY | XF_VFS_O_CREAT | XF_VFS_O_TRUNC, 0666);
+    int sink = xf_vfs_open("/ram/log2", XF_VFS_O_RDWR | XF_VFS_O_CREAT | XF_VFS_O_TRUNC, 0666);
+    TEST_ASSERT(log_fd >= 0 && sink >= 0);
+    int keep = xf_vfs_dup(log_fd);
+    TEST_ASSERT(keep >= 0);
+
+    /* 把 log_fd 重定向到 sink：log1 仍被 keep 引用，因此不调用驱动 */
+    uint32_t calls = s_fs->calls;
+    TEST_ASSERT_EQUAL(log_fd, xf_vfs_dup2(sink, log_fd));
+    TEST_ASSERT_EQUAL(calls, s_fs->calls);
+    TEST_ASSERT_EQUAL(2, driver_open_count());
+
+    TEST_ASSERT_EQUAL(2, xf_vfs_write(log_fd, "hi", 2));
+    TEST_ASSERT_EQUAL(2, xf_vfs_pread(sink, buf, sizeof(buf), 0));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "hi"));
+
+    /* 相同 fd */
+    TEST_ASSERT_EQUAL(sink, xf_vfs_dup2(sink, sink));
+
+    /* 覆盖最后一个引用时关闭原文件 */
+    TEST_ASSERT_EQUAL(keep, xf_vfs_dup2(sink, keep));
+    TEST_ASSERT_EQUAL(1, driver_open_count());
+
+    TEST_ASSERT(xf_vfs_dup2(sink, -1) < 0);
+    TEST_ASSERT_EQUAL(EBADF, errno);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(keep));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(log_fd));
+    TEST_ASSERT_EQUAL(1, driver_open_count());
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(sink));
+    TEST_ASSERT_EQUAL(0, driver_open_count());
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_fcntl_dupfd(void)
+{
+    int fd = xf_vfs_open("/ram/a", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+
+    int fd2 = xf_vfs_fcntl(fd, XF_VFS_F_DUPFD, 10);
+    TEST_ASSERT(fd2 >= 10);
+    TEST_ASSERT(xf_vfs_fcntl(fd, XF_VFS_F_DUPFD, -1) < 0);
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(1, driver_open_count());
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd2));
+    TEST_ASSERT_EQUAL(0, driver_open_count());
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
@@ -0,0 +1,528 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief XF_VFS_FLAG_EXECUTOR 测试：驱动的所有调用在挂载点的执行线程中进行，
+ *        以及与驱动自己加锁相比，每次调用交给执行线程的开销。
+ * @version 1.0
+ * @date 2025-01-26
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_osal.h"
+#include "xf_vfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define DEV_FILE_SIZE       64
+#define IOCTL_ADD_ONE       1               /* 参数 (int *out, int in)，*out = in + 1 */
+#define IOCTL_RESTAT        2               /* 驱动在执行线程中再 stat 本挂载点 */
+
+#define WRITERS             4
+#define WRITES_PER_WRITER   50
+
+#define BENCH_THREADS_MAX   4
+#define BENCH_OPS           20000           /* 每种配置的总调用数 */
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct {
+    int fd;
+    int index;
+    int failures;
+} writer_t;
+
+typedef struct {
+    int fd;
+    uint32_t ops;
+} bench_job_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int dev_open(const char *path, int flags, int mode);
+static int dev_close(int fd);
+static xf_vfs_ssize_t dev_read(int fd, void *dst, size_t size);
+static xf_vfs_ssize_t dev_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset);
+static int dev_ioctl(int fd, int cmd, va_list args);
+static int dev_stat(const char *path, xf_vfs_stat_t *st);
+static int dev_unlink(const char *path);
+static void *obj_open(void *ctx, const char *path, int flags, int mode);
+static int obj_close(void *ctx, void *h);
+static xf_vfs_ssize_t obj_read(void *ctx, void *h, void *dst, size_t size);
+static xf_vfs_ssize_t bench_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset);
+static xf_vfs_ssize_t bench_locked_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset);
+static int bench_open(const char *path, int flags, int mode);
+
+static void driver_enter(void);
+static void driver_exit(void);
+static void driver_reset(void);
+static void writer_thread(void *argument);
+static void bench_thread(void *argument);
+static uint64_t bench_run(const char *path, int threads);
+
+static void TEST_CASE_executor_register(void);
+static void TEST_CASE_executor_calls(void);
+static void TEST_CASE_executor_concurrent(void);
+static void TEST_CASE_executor_handle(void);
+static void TEST_CASE_executor_bench(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_dir_ops_t s_dev_dir_ops = {
+    .stat = dev_stat,
+    .unlink = dev_unlink,
+};
+
+/* 只能在一个线程中调用的驱动：不加锁，进入时检查调用线程 */
+static const xf_vfs_fs_ops_t s_dev_ops = {
+    .open = dev_open,
+    .close = dev_close,
+    .read = dev_read,
+    .pwrite = dev_pwrite,
+    .ioctl = dev_ioctl,
+    .dir = &s_dev_dir_ops,
+};
+
+static const xf_vfs_handle_ops_t s_obj_handle_ops = {
+    .open = obj_open,
+    .close = obj_close,
+    .read = obj_read,
+};
+
+static const xf_vfs_fs_ops_t s_obj_ops = {
+    .handle = &s_obj_handle_ops,
+};
+
+/* 基准：空操作的 pwrite，可重入或由驱动自己加锁 */
+static const xf_vfs_fs_ops_t s_bench_ops = {
+    .open = bench_open,
+    .close = dev_close,
+    .pwrite = bench_pwrite,
+};
+
+static const xf_vfs_fs_ops_t s_bench_locked_ops = {
+    .open = bench_open,
+    .close = dev_close,
+    .pwrite = bench_locked_pwrite,
+};
+
+static uint8_t s_dev_data[DEV_FILE_SIZE];
+static xf_osal_thread_t s_driver_thread;            /* 第一次调用驱动的线程 */
+static volatile uint32_t s_driver_calls;
+static volatile uint32_t s_wrong_thread;            /* 在其他线程中的调用数 */
+static volatile uint32_t s_overlaps;                /* 进入时已有调用在驱动中的次数 */
+static volatile int s_inside;
+static int s_obj;
+
+static xf_lock_t s_bench_lock;
+static xf_osal_semaphore_t s_done;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "done",
+    };
+    s_done = xf_osal_semaphore_create(WRITERS, 0, &sem_attr);
+    TEST_ASSERT(s_done != NULL);
+    TEST_XF_OK(xf_lock_init(&s_bench_lock));
+
+    TEST_CASE_executor_register();
+    TEST_CASE_executor_calls();
+    TEST_CASE_executor_concurrent();
+    TEST_CASE_executor_handle();
+    TEST_CASE_executor_bench();
+
+    xf_lock_destroy(s_bench_lock);
+    xf_osal_semaphore_delete(s_done);
+    return 0;
+}
+
+/* 执行线程已经串行化所有调用，不能与串行化标志同时使用 */
+static void TEST_CASE_executor_register(void)
+{
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_register_fs("/dev", &s_dev_ops,
+                      XF_VFS_FLAG_EXECUTOR | XF_VFS_FLAG_SERIAL_MOUNT, NULL));
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_register_fs("/dev", &s_dev_ops,
+                      XF_VFS_FLAG_EXECUTOR | XF_VFS_FLAG_SERIAL_FILE, NULL));
+
+    /* 复制的 ops 在注销时随执行线程一起释放 */
+    TEST_XF_OK(xf_vfs_register_fs("/dev", &s_dev_ops, XF_VFS_FLAG_EXECUTOR, NULL));
+    TEST_XF_OK(xf_vfs_unregister_fs("/dev"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 各类调用都在同一个执行线程中进行，返回值、输出参数、errno 与可变参数都传回调用者 */
+static void TEST_CASE_executor_calls(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/dev", &s_dev_ops, XF_VFS_FLAG_STATIC | XF_VFS_FLAG_EXECUTOR, NULL));
+    driver_reset();
+
+    const int fd = xf_vfs_open("/dev/a", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(fd >= 0);
+    errno = 0;
+    TEST_ASSERT_EQUAL(-1, xf_vfs_open("/dev/missing", XF_VFS_O_RDWR, 0));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+
+    TEST_ASSERT_EQUAL(5, xf_vfs_pwrite(fd, "hello", 5, 3));
+    char buf[8] = {0};
+    TEST_ASSERT_EQUAL(8, xf_vfs_read(fd, buf, sizeof(buf)));
+    TEST_ASSERT(xf_memcmp(&buf[3], "hello", 5) == 0);
+
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/dev/a", &st));
+    TEST_ASSERT_EQUAL(DEV_FILE_SIZE, st.st_size);
+    errno = 0;
+    TEST_ASSERT_EQUAL(-1, xf_vfs_unlink("/dev/a"));
+    TEST_ASSERT_EQUAL(EACCES, errno);
+
+    int out = 0;
+    TEST_ASSERT_EQUAL(0, xf_vfs_ioctl(fd, IOCTL_ADD_ONE, &out, 41));
+    TEST_ASSERT_EQUAL(42, out);
+    /* 驱动在执行线程中调用本挂载点时直接执行，不会等待自己 */
+    TEST_ASSERT_EQUAL(0, xf_vfs_ioctl(fd, IOCTL_RESTAT));
+
+    /* 调用成功时调用者的 errno 不变 */
+    errno = EAGAIN;
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/dev/a", &st));
+    TEST_ASSERT_EQUAL(EAGAIN, errno);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(11u, s_driver_calls);
+    TEST_ASSERT_EQUAL(0u, s_wrong_thread);
+    TEST_ASSERT(s_driver_thread != xf_osal_thread_get_current());
+    TEST_XF_OK(xf_vfs_unregister_fs("/dev"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 多个线程同时调用时驱动仍只在执行线程中、一次一个地被调用 */
+static void TEST_CASE_executor_concurrent(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/dev", &s_dev_ops, XF_VFS_FLAG_STATIC | XF_VFS_FLAG_EXECUTOR, NULL));
+    driver_reset();
+    const int fd = xf_vfs_open("/dev/a", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(fd >= 0);
+
+    writer_t w[WRITERS];
+    const xf_osal_thread_attr_t attr = {
+        .name = "writer",
+        .stack_size = 4096,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    for (int i = 0; i < WRITERS; ++i) {
+        w[i] = (writer_t) {
+            .fd = fd, .index = i, .failures = 0
+        };
+        TEST_ASSERT(xf_osal_thread_create(writer_thread, &w[i], &attr) != NULL);
+    }
+    for (int i = 0; i < WRITERS; ++i) {
+        xf_osal_semaphore_acquire(s_done, XF_OSAL_WAIT_FOREVER);
+    }
+    for (int i = 0; i < WRITERS; ++i) {
+        TEST_ASSERT_EQUAL(0, w[i].failures);
+        TEST_ASSERT_EQUAL(i, s_dev_data[i]);
+    }
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(2u + WRITERS * WRITES_PER_WRITER, s_driver_calls);
+    TEST_ASSERT_EQUAL(0u, s_wrong_thread);
+    TEST_ASSERT_EQUAL(0u, s_overlaps);
+    TEST_XF_OK(xf_vfs_unregister_fs("/dev"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 句柄模式的挂载点同样经过执行线程 */
+static void TEST_CASE_executor_handle(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/obj", &s_obj_ops,
+                                  XF_VFS_FLAG_STATIC | XF_VFS_FLAG_HANDLE | XF_VFS_FLAG_EXECUTOR, &s_obj));
+    driver_reset();
+    const int fd = xf_vfs_open("/obj/x", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    char c = 0;
+    TEST_ASSERT_EQUAL(1, xf_vfs_read(fd, &c, 1));
+    TEST_ASSERT_EQUAL('x', c);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(3u, s_driver_calls);
+    TEST_ASSERT_EQUAL(0u, s_wrong_thread);
+    TEST_ASSERT(s_driver_thread != xf_osal_thread_get_current());
+    TEST_XF_OK(xf_vfs_unregister_fs("/obj"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/*
+ * 空操作 pwrite 的平均耗时：可重入的驱动、驱动自己加锁、执行线程。
+ * 执行线程与可重入驱动之差即每次调用交给执行线程的开销。
+ */
+static void TEST_CASE_executor_bench(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/direct", &s_bench_ops, XF_VFS_FLAG_STATIC, NULL));
+    TEST_XF_OK(xf_vfs_register_fs("/mutex", &s_bench_locked_ops, XF_VFS_FLAG_STATIC, NULL));
+    TEST_XF_OK(xf_vfs_register_fs("/exec", &s_bench_ops, XF_VFS_FLAG_STATIC | XF_VFS_FLAG_EXECUTOR, NULL));
+
+    xf_log_printf("%-8s %8s %12s %12s %12s\n", "threads", "ops", "direct ns", "mutex ns", "executor ns");
+    for (int threads = 1; threads <= BENCH_THREADS_MAX; threads *= 2) {
+        const uint64_t direct = bench_run("/direct/f", threads);
+        const uint64_t mutex = bench_run("/mutex/f", threads);
+        const uint64_t exec = bench_run("/exec/f", threads);
+        xf_log_printf("%-8d %8u %12lu %12lu %12lu\n", threads, (unsigned)BENCH_OPS,
+                      (unsigned long)direct, (unsigned long)mutex, (unsigned long)exec);
+        if (threads == 1) {
+            xf_log_printf("hand-off cost per op: %ld ns\n", (long)exec - (long)direct);
+        }
+    }
+
+    TEST_XF_OK(xf_vfs_unregister_fs("/exec"));
+    TEST_XF_OK(xf_vfs_unregister_fs("/mutex"));
+    TEST_XF_OK(xf_vfs_unregister_fs("/direct"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 返回每次调用的平均耗时（ns，按墙钟时间除以总调用数） */
+static uint64_t bench_run(const char *path, int threads)
+{
+    const int fd = xf_vfs_open(path, XF_VFS_O_WRONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    bench_job_t jobs[BENCH_THREADS_MAX];
+    const xf_osal_thread_attr_t attr = {
+        .name = "bench",
+        .stack_size = 4096,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    const uint64_t t0 = xf_sys_time_get_ns();
+    for (int t = 0; t < threads; ++t) {
+        jobs[t] = (bench_job_t) {
+            .fd = fd, .ops = BENCH_OPS / threads
+        };
+        TEST_ASSERT(xf_osal_thread_create(bench_thread, &jobs[t], &attr) != NULL);
+    }
+    for (int t = 0; t < threads; ++t) {
+        xf_osal_semaphore_acquire(s_done, XF_OSAL_WAIT_FOREVER);
+    }
+    const uint64_t elapsed = xf_sys_time_get_ns() - t0;
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    return elapsed / BENCH_OPS;
+}
+
+static void bench_thread(void *argument)
+{
+    bench_job_t *job = argument;
+    const char c = 0;
+    for (uint32_t i = 0; i < job->ops; ++i) {
+        if (xf_vfs_pwrite(job->fd, &c, 1, 0) != 1) {
+            xf_log_printf("bench pwrite failed\n");
+        }
+    }
+    xf_osal_semaphore_release(s_done);
+    xf_osal_thread_delete(NULL);
+}
+
+static void writer_thread(void *argument)
+{
+    writer_t *w = argument;
+    const uint8_t value = (uint8_t)w->index;
+    for (int i = 0; i < WRITES_PER_WRITER; ++i) {
+        if (xf_vfs_pwrite(w->fd, &value, 1, w->index) != 1) {
+            ++w->failures;
+        }
+    }
+    xf_osal_semaphore_release(s_done);
+    xf_osal_thread_delete(NULL);
+}
+
+static void driver_reset(void)
+{
+    s_driver_thread = NULL;
+    s_driver_calls = 0;
+    s_wrong_thread = 0;
+    s_overlaps = 0;
+    s_inside = 0;
+    xf_memset(s_dev_data, 0, sizeof(s_dev_data));
+}
+
+/* 驱动的每个方法在入口与出口调用，记录调用线程与是否有并发的调用 */
+static void driver_enter(void)
+{
+    const xf_osal_thread_t self = xf_osal_thread_get_current();
+    if (s_driver_thread == NULL) {
+        s_driver_thread = self;
+    } else if (s_driver_thread != self) {
+        ++s_wrong_thread;
+    }
+    if (s_inside++ != 0) {
+        ++s_overlaps;
+    }
+    ++s_driver_calls;
+}
+
+static void driver_exit(void)
+{
+    --s_inside;
+}
+
+static int dev_open(const char *path, int flags, int mode)
+{
+    driver_enter();
+    int ret = 0;
+    if (xf_strcmp(path, "/a") != 0) {
+        errno = ENOENT;
+        ret = -1;
+    }
+    driver_exit();
+    return ret;
+}
+
+static int dev_close(int fd)
+{
+    driver_enter();
+    driver_exit();
+    return 0;
+}
+
+static xf_vfs_ssize_t dev_read(int fd, void *dst, size_t size)
+{
+    driver_enter();
+    if (size > DEV_FILE_SIZE) {
+        size = DEV_FILE_SIZE;
+    }
+    xf_memcpy(dst, s_dev_data, size);
+    driver_exit();
+    return (xf_vfs_ssize_t)size;
+}
+
+static xf_vfs_ssize_t dev_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    driver_enter();
+    xf_vfs_ssize_t ret = (xf_vfs_ssize_t)size;
+    if (offset < 0 || (size_t)offset + size > DEV_FILE_SIZE) {
+        errno = EINVAL;
+        ret = -1;
+    } else {
+        /* 逐字节写入并让出 CPU，有并发调用时容易被发现 */
+        for (size_t i = 0; i < size; ++i) {
+            s_dev_data[offset + i] = ((const uint8_t *)src)[i];
+            xf_osal_thread_yield();
+        }
+    }
+    driver_exit();
+    return ret;
+}
+
+static int dev_ioctl(int fd, int cmd, va_list args)
+{
+    driver_enter();
+    int ret = 0;
+    if (cmd == IOCTL_ADD_ONE) {
+        int *out = va_arg(args, int *);
+        *out = va_arg(args, int) + 1;
+    } else if (cmd == IOCTL_RESTAT) {
+        /* 驱动持有状态时重新进入本挂载点 */
+        driver_exit();
+        xf_vfs_stat_t st;
+        ret = xf_vfs_stat("/dev/a", &st);
+        driver_enter();
+        --s_driver_calls;
+    } else {
+        errno = EINVAL;
+        ret = -1;
+    }
+    driver_exit();
+    return ret;
+}
+
+static int dev_stat(const char *path, xf_vfs_stat_t *st)
+{
+    driver_enter();
+    xf_memset(st, 0, sizeof(*st));
+    st->st_size = DEV_FILE_SIZE;
+    driver_exit();
+    return 0;
+}
+
+static int dev_unlink(const char *path)
+{
+    driver_enter();
+    errno = EACCES;
+    driver_exit();
+    return -1;
+}
+
+static void *obj_open(void *ctx, const char *path, int flags, int mode)
+{
+    driver_enter();
+    driver_exit();
+    return ctx;
+}
+
+static int obj_close(void *ctx, void *h)
+{
+    driver_enter();
+    driver_exit();
+    return (h == ctx) ? 0 : -1;
+}
+
+static xf_vfs_ssize_t obj_read(void *ctx, void *h, void *dst, size_t size)
+{
+    driver_enter();
+    *(char *)dst = 'x';
+    driver_exit();
+    return 1;
+}
+
+static int bench_open(const char *path, int flags, int mode)
+{
+    return 0;
+}
+
+static xf_vfs_ssize_t bench_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    return (xf_vfs_ssize_t)size;
+}
+
+static xf_vfs_ssize_t bench_locked_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    xf_lock_lock(s_bench_lock);
+    xf_lock_unlock(s_bench_lock);
+    return (xf_vfs_ssize_t)size;
+}
@@ -0,0 +1,334 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief fault 驱动测试：转发、延迟分布、带宽限制、周期性卡顿与错误，以及脚本配置。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+#include "xf_vfs_fault.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define DELAYS_MAX          10000
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void delays_clear(void);
+static void repeat_read(int fd, int n);
+
+static void TEST_CASE_fault_forward(void);
+static void TEST_CASE_fault_distributions(void);
+static void TEST_CASE_fault_bandwidth_stall_error(void);
+static void TEST_CASE_fault_script(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+/* 注入的每次延迟（us） */
+static uint32_t s_delays[DELAYS_MAX];
+static size_t s_delay_count;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+void test_delay_us(uint32_t us)
+{
+    if (s_delay_count < DELAYS_MAX) {
+        s_delays[s_delay_count++] = us;
+    }
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+    TEST_XF_OK(xf_vfs_fault_register("/slow", "/ram", 1));
+
+    TEST_CASE_fault_forward();
+    TEST_CASE_fault_distributions();
+    TEST_CASE_fault_bandwidth_stall_error();
+    TEST_CASE_fault_script();
+
+    TEST_XF_OK(xf_vfs_fault_unregister("/slow"));
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+    return 0;
+}
+
+/* 没有规则时原样转发到目标目录，不注入延迟 */
+static void TEST_CASE_fault_forward(void)
+{
+    char buf[16] = { 0 };
+    xf_vfs_stat_t st;
+    xf_vfs_fault_stats_t stats;
+    delays_clear();
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/slow/d", 0777));
+    int fd = xf_vfs_open("/slow/d/f", XF_VFS_O_RDWR | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(5, xf_vfs_write(fd, "hello", 5));
+    TEST_ASSERT_EQUAL(3, xf_vfs_pread(fd, buf, 3, 1));
+    TEST_ASSERT(xf_memcmp(buf, "ell", 3) == 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/ram/d/f", &st));
+    TEST_ASSERT_EQUAL(5, st.st_size);
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/slow/d/f", &st));
+    TEST_ASSERT_EQUAL(5, st.st_size);
+
+    xf_vfs_dir_t *dir = xf_vfs_opendir("/slow/d");
+    TEST_ASSERT(dir != NULL);
+    xf_vfs_dirent_t *ent = xf_vfs_readdir(dir);
+    TEST_ASSERT(ent != NULL && xf_strcmp(ent->d_name, "f") == 0);
+    TEST_ASSERT(xf_vfs_readdir(dir) == NULL);
+    TEST_ASSERT_EQUAL(0, xf_vfs_closedir(dir));
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_rename("/slow/d/f", "/slow/d/g"));
+    TEST_ASSERT_EQUAL(0, xf_vfs_access("/ram/d/g", XF_VFS_F_OK));
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlink("/slow/d/g"));
+    TEST_ASSERT_EQUAL(0, xf_vfs_rmdir("/slow/d"));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_stat("/ram/d", &st));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_open("/slow/missing", XF_VFS_O_RDONLY, 0));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+
+    TEST_XF_OK(xf_vfs_fault_get_stats("/slow", &stats, true));
+    TEST_ASSERT_EQUAL(14u, stats.calls);
+    TEST_ASSERT_EQUAL(0u, stats.delay_us);
+    TEST_ASSERT_EQUAL(0, s_delay_count);
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_STATE, xf_vfs_fault_get_stats("/ram", &stats, false));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 固定、均匀与长尾分布，相同的种子得到相同的序列 */
+static void TEST_CASE_fault_distributions(void)
+{
+    xf_vfs_fault_rule_t rule = { .dist = XF_VFS_FAULT_DIST_FIXED, .lat_us = 100 };
+    int fd = xf_vfs_open("/slow/f", XF_VFS_O_RDWR | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+
+    TEST_XF_OK(xf_vfs_fault_set_rule("/slow", XF_VFS_TRACE_OP_READ, &rule));
+    delays_clear();
+    repeat_read(fd, 10);
+    TEST_ASSERT_EQUAL(10, s_delay_count);
+    for (size_t i = 0; i < s_delay_count; ++i) {
+        TEST_ASSERT_EQUAL(100u, s_delays[i]);
+    }
+
+    rule.dist = XF_VFS_FAULT_DIST_UNIFORM;
+    rule.lat_us = 10;
+    rule.lat_max_us = 20;
+    TEST_XF_OK(xf_vfs_fault_set_rule("/slow", XF_VFS_TRACE_OP_READ, &rule));
+    delays_clear();
+    repeat_read(fd, 1000);
+    bool seen_min = false;
+    bool seen_max = false;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < s_delay_count; ++i) {
+        TEST_ASSERT(s_delays[i] >= 10 && s_delays[i] <= 20);
+        seen_min |= (s_delays[i] == 10);
+        seen_max |= (s_delays[i] == 20);
+        sum += s_delays[i];
+    }
+    TEST_ASSERT(seen_min && seen_max);
+    TEST_ASSERT(sum > 14000 && sum < 16000);
+
+    /* P(延迟 >= 10us * 2^k) = 0.5^k */
+    rule.dist = XF_VFS_FAULT_DIST_LONG_TAIL;
+    rule.lat_us = 10;
+    rule.lat_max_us = 10000;
+    rule.tail_permyriad = 5000;
+    TEST_XF_OK(xf_vfs_fault_set_rule("/slow", XF_VFS_TRACE_OP_READ, &rule));
+    delays_clear();
+    repeat_read(fd, DELAYS_MAX);
+    size_t at_least[4] = { 0 };
+    for (size_t i = 0; i < s_delay_count; ++i) {
+        TEST_ASSERT(s_delays[i] >= 10 && s_delays[i] <= 10000);
+        for (int k = 0; k < 4; ++k) {
+            at_least[k] += (s_delays[i] >= (10u << k));
+        }
+    }
+    TEST_ASSERT_EQUAL(DELAYS_MAX, at_least[0]);
+    TEST_ASSERT(at_least[1] > 4500 && at_least[1] < 5500);
+    TEST_ASSERT(at_least[2] > 2000 && at_least[2] < 3000);
+    TEST_ASSERT(at_least[3] > 900 && at_least[3] < 1600);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+
+    /* 重新注册后用相同的种子重放 */
+    static uint32_t first[100];
+    for (int round = 0; round < 2; ++round) {
+        TEST_XF_OK(xf_vfs_fault_unregister("/slow"));
+        TEST_XF_OK(xf_vfs_fault_register("/slow", "/ram", 42));
+        TEST_XF_OK(xf_vfs_fault_configure("/slow", "read uniform=0:1ms"));
+        fd = xf_vfs_open("/slow/f", XF_VFS_O_RDONLY, 0);
+        TEST_ASSERT(fd >= 0);
+        delays_clear();
+        repeat_read(fd, 100);
+        TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+        for (int i = 0; i < 100; ++i) {
+            if (round == 0) {
+                first[i] = s_delays[i];
+            } else {
+                TEST_ASSERT_EQUAL(first[i], s_delays[i]);
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlink("/slow/f"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 带宽按字节数计算传输时间；卡顿与错误按调用次数周期性出现，注入的错误不转发 */
+static void TEST_CASE_fault_bandwidth_stall_error(void)
+{
+    static const char data[1024];
+    xf_vfs_fault_stats_t stats;
+    xf_vfs_stat_t st;
+    const xf_vfs_fault_rule_t rule = {
+        .bytes_per_sec = 1024 * 1024,
+        .stall_every = 4,
+        .stall_us = 80000,
+        .error_every = 3,
+        .error = ENOSPC,
+    };
+    TEST_XF_OK(xf_vfs_fault_set_rule("/slow", XF_VFS_TRACE_OP_WRITE, &rule));
+    TEST_XF_OK(xf_vfs_fault_get_stats("/slow", &stats, true));
+
+    int fd = xf_vfs_open("/slow/g", XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    delays_clear();
+    int ok = 0;
+    for (int i = 1; i <= 12; ++i) {
+        xf_vfs_ssize_t n = xf_vfs_write(fd, data, sizeof(data));
+        if (i % 3 == 0) {
+            TEST_ASSERT_EQUAL(-1, n);
+            TEST_ASSERT_EQUAL(ENOSPC, errno);
+        } else {
+            TEST_ASSERT_EQUAL((xf_vfs_ssize_t)sizeof(data), n);
+            ++ok;
+        }
+        /* 1024 B 在 1 MiB/s 下为 977 us（向上取整） */
+        TEST_ASSERT_EQUAL((i % 4 == 0) ? 977u + 80000u : 977u, s_delays[i - 1]);
+    }
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/ram/g", &st));
+    TEST_ASSERT_EQUAL(ok * (int)sizeof(data), st.st_size);
+
+    TEST_XF_OK(xf_vfs_fault_get_stats("/slow", &stats, false));
+    TEST_ASSERT_EQUAL(3u, stats.stalls);
+    TEST_ASSERT_EQUAL(4u, stats.errors);
+    TEST_ASSERT_EQUAL(12u * 977u + 3u * 80000u, stats.delay_us);
+
+    TEST_XF_OK(xf_vfs_fault_set_rule("/slow", XF_VFS_FAULT_OP_ALL, NULL));
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlink("/slow/g"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 脚本：多个操作、逐项覆盖、clear 与语法错误 */
+static void TEST_CASE_fault_script(void)
+{
+    char c = 0;
+    int fd = xf_vfs_open("/slow/h", XF_VFS_O_RDWR | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(1, xf_vfs_write(fd, &c, 1));
+
+    TEST_XF_OK(xf_vfs_fault_configure("/slow",
+                                      "read,pread fixed=2ms bw=1K\n"
+                                      "pread fixed=5us ; fsync error=2:ETIMEDOUT"));
+    delays_clear();
+    TEST_ASSERT_EQUAL(1, xf_vfs_pread(fd, &c, 1, 0));
+    TEST_ASSERT_EQUAL(0, xf_vfs_read(fd, &c, 0));
+    TEST_ASSERT_EQUAL(0, xf_vfs_fsync(fd));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_fsync(fd));
+    TEST_ASSERT_EQUAL(ETIMEDOUT, errno);
+    TEST_ASSERT_EQUAL(2, s_delay_count);
+    TEST_ASSERT_EQUAL(5u + 977u, s_delays[0]);     /* pread：fixed 被覆盖，bw 保留 */
+    TEST_ASSERT_EQUAL(2000u, s_delays[1]);          /* read 0 字节没有传输时间 */
+
+    TEST_XF_OK(xf_vfs_fault_configure("/slow", "all clear; write stall=1:1s"));
+    delays_clear();
+    TEST_ASSERT_EQUAL(1, xf_vfs_pread(fd, &c, 1, 0));
+    TEST_ASSERT_EQUAL(0, xf_vfs_fsync(fd));
+    TEST_ASSERT_EQUAL(1, xf_vfs_write(fd, &c, 1));
+    TEST_ASSERT_EQUAL(1, s_delay_count);
+    TEST_ASSERT_EQUAL(1000000u, s_delays[0]);
+
+    static const char *const bad[] = {
+        "foo fixed=1us",
+        "read fixed=1xs",
+        "read fixed",
+        "read uniform=5us",
+        "read uniform=5ms:1ms",
+        "read tail=1us:1ms:10001",
+        "read bw=1G",
+        "read stall=4",
+        "read error=1:EFOO",
+        "read,,write fixed=1us",
+        "read speed=1",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_fault_configure("/slow", bad[i]));
+    }
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_STATE, xf_vfs_fault_configure("/ram", "read fixed=1us"));
+    TEST_XF_OK(xf_vfs_fault_configure("/slow", " ;\n; all clear "));
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlink("/slow/h"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void delays_clear(void)
+{
+    s_delay_count = 0;
+}
+
+static void repeat_read(int fd, int n)
+{
+    char c;
+    for (int i = 0; i < n; ++i) {
+        TEST_ASSERT(xf_vfs_pread(fd, &c, 1, 0) >= 0);
+        xf_vfs_read(fd, &c, 0);
+    }
+}
@@ -0,0 +1,50 @@
+/**
+ * @file xf_vfs_config.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 使用 xfusion 菜单配置 xf_vfs 内部配置。
+ * @version 1.0
+ * @date 2025-01-10
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+
+#ifndef __XF_VFS_CONFIG_H__
+#define __XF_VFS_CONFIG_H__
+
+/* ==================== [Includes] ========================================== */
+
+// #include "xfconfig.h"
+#include "xf_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+// #define XF_VFS_SUPPORT_IO_ENABLE CONFIG_XF_VFS_SUPPORT_IO_ENABLE
+// #define XF_VFS_SUPPORT_DIR_ENABLE CONFIG_XF_VFS_SUPPORT_DIR_ENABLE
+#define XF_VFS_SUPPORT_SELECT_ENABLE 0
+// #define XF_VFS_MAX_COUNT CONFIG_XF_VFS_MAX_COUNT
+// #define XF_VFS_CUSTOM_FD_SETSIZE_ENABLE CONFIG_XF_VFS_CUSTOM_FD_SETSIZE_ENABLE
+// #define XF_VFS_CUSTOM_FD_SETSIZE CONFIG_XF_VFS_CUSTOM_FD_SETSIZE
+// #define XF_VFS_PATH_MAX CONFIG_XF_VFS_PATH_MAX
+// #define XF_VFS_DIRENT_NAME_SIZE CONFIG_XF_VFS_DIRENT_NAME_SIZE
+
+/* 注入的延迟只记录、不实际等待 */
+#define XF_VFS_FAULT_DELAY_US(us) test_delay_us(us)
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Global Prototypes] ================================= */
+
+void test_delay_us(uint32_t us);
+
+/* ==================== [Macros] ============================================ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif // __XF_VFS_CONFIG_H__
@@ -0,0 +1,199 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief fd 表分片锁测试：多线程并发 open/close，并按线程数扫描吞吐量。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_osal.h"
+#include "xf_vfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define THREADS_MAX         8
+#define ITERATIONS          20000
+#define FDS_PER_ITERATION   4
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct {
+    int failures;
+    xf_osal_semaphore_t done;
+} worker_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int null_open(const char *path, int flags, int mode);
+static int null_close(int fd);
+
+static void worker(void *argument);
+static uint64_t run_threads(int threads);
+static int count_free_fds(void);
+
+static void TEST_CASE_fd_shards_concurrent_open_close(void);
+static void TEST_CASE_fd_shards_thread_sweep(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_fs_ops_t s_null_ops = {
+    .open = null_open,
+    .close = null_close,
+};
+
+static worker_t s_workers[THREADS_MAX];
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/null", &s_null_ops, XF_VFS_FLAG_STATIC, NULL));
+    for (int i = 0; i < THREADS_MAX; ++i) {
+        s_workers[i].done = xf_osal_semaphore_create(1, 0, NULL);
+        TEST_ASSERT(s_workers[i].done != NULL);
+    }
+
+    TEST_CASE_fd_shards_concurrent_open_close();
+    TEST_CASE_fd_shards_thread_sweep();
+
+    for (int i = 0; i < THREADS_MAX; ++i) {
+        xf_osal_semaphore_delete(s_workers[i].done);
+    }
+    TEST_XF_OK(xf_vfs_unregister_fs("/null"));
+    return 0;
+}
+
+static void TEST_CASE_fd_shards_concurrent_open_close(void)
+{
+    const int free_fds = count_free_fds();
+    TEST_ASSERT(free_fds > 0);
+
+    run_threads(THREADS_MAX);
+    for (int i = 0; i < THREADS_MAX; ++i) {
+        TEST_ASSERT_EQUAL(0, s_workers[i].failures);
+    }
+    /* 所有 fd 及打开文件描述都已归还 */
+    TEST_ASSERT_EQUAL(free_fds, count_free_fds());
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/*
+ * 吞吐量扫描，结果只打印不判定。
+ * 与 -DXF_VFS_FD_LOCK_SHARDS=1 编译的结果对比即可看出分片的效果。
+ */
+static void TEST_CASE_fd_shards_thread_sweep(void)
+{
+    xf_log_printf("shards: %d\n", (int)XF_VFS_FD_LOCK_SHARDS);
+    xf_log_printf("threads  ns/op  Mop/s\n");
+    for (int threads = 1; threads <= THREADS_MAX; threads *= 2) {
+        const uint64_t ns = run_threads(threads);
+        const uint64_t ops = (uint64_t)threads * ITERATIONS * FDS_PER_ITERATION * 2; // open + close
+        xf_log_printf("%7d  %5u  %5u.%02u\n", threads,
+                      (unsigned)(ns * threads / ops),
+                      (unsigned)(ops * 1000 / ns), (unsigned)(ops * 100000 / ns % 100));
+    }
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 启动 threads 个线程并等待全部结束，返回耗时（ns） */
+static uint64_t run_threads(int threads)
+{
+    const xf_osal_thread_attr_t attr = {
+        .name = "worker",
+        .stack_size = 2048,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    const uint64_t start = xf_sys_time_get_ns();
+    for (int i = 0; i < threads; ++i) {
+        s_workers[i].failures = 0;
+        TEST_ASSERT(xf_osal_thread_create(worker, &s_workers[i], &attr) != NULL);
+    }
+    for (int i = 0; i < threads; ++i) {
+        xf_osal_semaphore_acquire(s_workers[i].done, XF_OSAL_WAIT_FOREVER);
+    }
+    return xf_sys_time_get_ns() - start;
+}
+
+static void worker(void *argument)
+{
+    worker_t *w = (worker_t *)argument;
+    int fds[FDS_PER_ITERATION];
+    for (int n = 0; n < ITERATIONS; ++n) {
+        for (int i = 0; i < FDS_PER_ITERATION; ++i) {
+            fds[i] = xf_vfs_open("/null/file", XF_VFS_O_RDONLY, 0);
+            w->failures += (fds[i] < 0);
+        }
+        for (int i = 0; i < FDS_PER_ITERATION; ++i) {
+            w->failures += (fds[i] >= 0 && xf_vfs_close(fds[i]) != 0);
+        }
+    }
+    xf_osal_semaphore_release(w->done);
+    xf_osal_thread_delete(NULL);
+}
+
+/* 打开文件直到 fd 耗尽，返回能打开的数量 */
+static int count_free_fds(void)
+{
+    int fds[XF_VFS_CUSTOM_FD_SETSIZE];
+    int n = 0;
+    while (n < XF_VFS_CUSTOM_FD_SETSIZE && (fds[n] = xf_vfs_open("/null/file", XF_VFS_O_RDONLY, 0)) >= 0) {
+        ++n;
+    }
+    for (int i = 0; i < n; ++i) {
+        xf_vfs_close(fds[i]);
+    }
+    return n;
+}
+
+static int null_open(const char *path, int flags, int mode)
+{
+    return 0;
+}
+
+static int null_close(int fd)
+{
+    return 0;
+}
@@ -0,0 +1,311 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs_getdents() 测试：驱动原生实现与 readdir 回退。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define LIST_ENTRIES    10000
+#define LIST_NAME_LEN   11      /* "log0000.txt" */
+
+/* ==================== [Typedefs] ========================================== */
+
+/* 只读的合成目录：根目录下有 LIST_ENTRIES 个文件 log0000.txt ... */
+typedef struct {
+    xf_vfs_dir_t base;
+    long pos;
+    xf_vfs_dirent_t ent;
+} list_dir_t;
+
+typedef struct {
+    uint32_t calls;
+} listfs_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int list_name(long pos, char *name);
+static xf_vfs_dir_t *list_opendir(void *ctx, const char *name);
+static xf_vfs_dirent_t *list_readdir(void *ctx, xf_vfs_dir_t *pdir);
+static long list_telldir(void *ctx, xf_vfs_dir_t *pdir);
+static void list_seekdir(void *ctx, xf_vfs_dir_t *pdir, long offset);
+static int list_closedir(void *ctx, xf_vfs_dir_t *pdir);
+static xf_vfs_ssize_t list_getdents(void *ctx, xf_vfs_dir_t *pdir, void *buf, size_t len);
+
+static int list_all(const char *path, size_t buf_len);
+
+static void TEST_CASE_getdents_native(void);
+static void TEST_CASE_getdents_readdir_fallback(void);
+static void TEST_CASE_getdents_fallback_without_telldir(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_dir_ops_t s_list_dir_ops = {
+    .opendir_p = list_opendir,
+    .readdir_p = list_readdir,
+    .telldir_p = list_telldir,
+    .seekdir_p = list_seekdir,
+    .closedir_p = list_closedir,
+    .getdents_p = list_getdents,
+};
+
+static const xf_vfs_fs_ops_t s_list_ops = {
+    .dir = &s_list_dir_ops,
+};
+
+/* 同一个驱动去掉 getdents，模拟旧驱动 */
+static const xf_vfs_dir_ops_t s_legacy_dir_ops = {
+    .opendir_p = list_opendir,
+    .readdir_p = list_readdir,
+    .telldir_p = list_telldir,
+    .seekdir_p = list_seekdir,
+    .closedir_p = list_closedir,
+};
+
+static const xf_vfs_fs_ops_t s_legacy_ops = {
+    .dir = &s_legacy_dir_ops,
+};
+
+static listfs_t s_fast;
+static listfs_t s_legacy;
+
+/* 缓冲区按 XF_VFS_DIRENT_REC_ALIGN 对齐 */
+static xf_vfs_ino_t s_buf[4096 / sizeof(xf_vfs_ino_t)];
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/fast", &s_list_ops, XF_VFS_FLAG_CONTEXT_PTR | XF_VFS_FLAG_STATIC, &s_fast));
+    TEST_XF_OK(xf_vfs_register_fs("/legacy", &s_legacy_ops, XF_VFS_FLAG_CONTEXT_PTR | XF_VFS_FLAG_STATIC, &s_legacy));
+
+    TEST_CASE_getdents_native();
+    TEST_CASE_getdents_readdir_fallback();
+    TEST_CASE_getdents_fallback_without_telldir();
+
+    TEST_XF_OK(xf_vfs_unregister_fs("/legacy"));
+    TEST_XF_OK(xf_vfs_unregister_fs("/fast"));
+    return 0;
+}
+
+static void TEST_CASE_getdents_native(void)
+{
+    s_fast.calls = 0;
+    TEST_ASSERT_EQUAL(LIST_ENTRIES, list_all("/fast", sizeof(s_buf)));
+    /* 一次调用读出一整个缓冲区的目录项 */
+    XF_LOGI(TAG, "native: %d entries in %u driver calls", LIST_ENTRIES, (unsigned)s_fast.calls);
+    TEST_ASSERT(s_fast.calls < LIST_ENTRIES / 16);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_getdents_readdir_fallback(void)
+{
+    s_legacy.calls = 0;
+    TEST_ASSERT_EQUAL(LIST_ENTRIES, list_all("/legacy", sizeof(s_buf)));
+    XF_LOGI(TAG, "fallback: %d entries in %u driver calls", LIST_ENTRIES, (unsigned)s_legacy.calls);
+
+    /* 缓冲区只比一条记录略大：放不下的项退回，下次调用再读出，不会丢失 */
+    TEST_ASSERT_EQUAL(LIST_ENTRIES, list_all("/legacy", XF_VFS_DIRENT_REC_LEN(LIST_NAME_LEN) + 8));
+
+    xf_vfs_dir_t *dir = xf_vfs_opendir("/legacy");
+    TEST_ASSERT(dir != NULL);
+    TEST_ASSERT(xf_vfs_getdents(dir, s_buf, XF_VFS_DIRENT_REC_LEN(LIST_NAME_LEN) - 1) < 0);
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+    /* 失败的调用不消耗目录项 */
+    TEST_ASSERT(xf_vfs_getdents(dir, s_buf, sizeof(s_buf)) > 0);
+    const xf_vfs_dirent_rec_t *rec = (const xf_vfs_dirent_rec_t *)s_buf;
+    TEST_ASSERT_EQUAL(0, xf_strcmp(rec->d_name, "log0000.txt"));
+    TEST_ASSERT_EQUAL(LIST_NAME_LEN, rec->d_namlen);
+    TEST_ASSERT_EQUAL(XF_VFS_DT_REG, rec->d_type);
+    TEST_ASSERT_EQUAL(0, xf_vfs_closedir(dir));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_getdents_fallback_without_telldir(void)
+{
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ram/d", 0777));
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ram/d/sub", 0777));
+    int fd = xf_vfs_open("/ram/d/a.txt", XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+
+    xf_vfs_dir_t *dir = xf_vfs_opendir("/ram/d");
+    TEST_ASSERT(dir != NULL);
+    /* ramfs 没有 telldir，缓冲区需能容纳任意名称 */
+    TEST_ASSERT(xf_vfs_getdents(dir, s_buf, XF_VFS_DIRENT_REC_MAX - 1) < 0);
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+
+    const xf_vfs_ssize_t n = xf_vfs_getdents(dir, s_buf, sizeof(s_buf));
+    TEST_ASSERT(n > 0);
+    int count = 0;
+    bool seen_dir = false;
+    for (const xf_vfs_dirent_rec_t *rec = (const xf_vfs_dirent_rec_t *)s_buf;
+            (const uint8_t *)rec < (const uint8_t *)s_buf + n; rec = XF_VFS_DIRENT_REC_NEXT(rec)) {
+        seen_dir |= (xf_strcmp(rec->d_name, "sub") == 0 && rec->d_type == XF_VFS_DT_DIR);
+        ++count;
+    }
+    TEST_ASSERT_EQUAL(2, count);
+    TEST_ASSERT(seen_dir);
+    TEST_ASSERT_EQUAL(0, xf_vfs_getdents(dir, s_buf, sizeof(s_buf)));
+    TEST_ASSERT_EQUAL(0, xf_vfs_closedir(dir));
+
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 用 getdents 列出目录，逐项核对名称，返回项数 */
+static int list_all(const char *path, size_t buf_len)
+{
+    char expected[16];
+    int count = 0;
+    xf_vfs_dir_t *dir = xf_vfs_opendir(path);
+    TEST_ASSERT(dir != NULL);
+    xf_vfs_ssize_t n;
+    while ((n = xf_vfs_getdents(dir, s_buf, buf_len)) > 0) {
+        const uint8_t *end = (const uint8_t *)s_buf + n;
+        for (const xf_vfs_dirent_rec_t *rec = (const xf_vfs_dirent_rec_t *)s_buf;
+                (const uint8_t *)rec < end; rec = XF_VFS_DIRENT_REC_NEXT(rec)) {
+            TEST_ASSERT_EQUAL(list_name(count, expected), rec->d_namlen);
+            TEST_ASSERT_EQUAL(0, xf_strcmp(rec->d_name, expected));
+            TEST_ASSERT_EQUAL((xf_vfs_ino_t)count + 1, rec->d_ino);
+            ++count;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, n);
+    TEST_ASSERT_EQUAL(0, xf_vfs_closedir(dir));
+    return count;
+}
+
+static int list_name(long pos, char *name)
+{
+    return xf_snprintf(name, 16, "log%04ld.txt", pos);
+}
+
+static xf_vfs_dir_t *list_opendir(void *ctx, const char *name)
+{
+    listfs_t *fs = (listfs_t *)ctx;
+    ++fs->calls;
+    if (xf_strcmp(name, "/") != 0) {
+        errno = ENOENT;
+        return NULL;
+    }
+    list_dir_t *dir = xf_malloc(sizeof(list_dir_t));
+    if (dir == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    dir->pos = 0;
+    return &dir->base;
+}
+
+static xf_vfs_dirent_t *list_readdir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    listfs_t *fs = (listfs_t *)ctx;
+    list_dir_t *dir = (list_dir_t *)pdir;
+    ++fs->calls;
+    if (dir->pos >= LIST_ENTRIES) {
+        return NULL;
+    }
+    dir->ent.d_namlen = (uint8_t)list_name(dir->pos, dir->ent.d_name);
+    dir->ent.d_ino = (xf_vfs_ino_t)dir->pos + 1;
+    dir->ent.d_type = XF_VFS_DT_REG;
+    ++dir->pos;
+    return &dir->ent;
+}
+
+static long list_telldir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    listfs_t *fs = (listfs_t *)ctx;
+    ++fs->calls;
+    return ((list_dir_t *)pdir)->pos;
+}
+
+static void list_seekdir(void *ctx, xf_vfs_dir_t *pdir, long offset)
+{
+    listfs_t *fs = (listfs_t *)ctx;
+    ++fs->calls;
+    ((list_dir_t *)pdir)->pos = offset;
+}
+
+static int list_closedir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    listfs_t *fs = (listfs_t *)ctx;
+    ++fs->calls;
+    xf_free(pdir);
+    return 0;
+}
+
+static xf_vfs_ssize_t list_getdents(void *ctx, xf_vfs_dir_t *pdir, void *buf, size_t len)
+{
+    listfs_t *fs = (listfs_t *)ctx;
+    list_dir_t *dir = (list_dir_t *)pdir;
+    ++fs->calls;
+    char name[16];
+    size_t used = 0;
+    while (dir->pos < LIST_ENTRIES) {
+        const int namlen = list_name(dir->pos, name);
+        const size_t reclen = xf_vfs_dirent_rec_fill((uint8_t *)buf + used, len - used,
+                              (xf_vfs_ino_t)dir->pos + 1, XF_VFS_DT_REG, name, namlen);
+        if (reclen == 0) {
+            break;
+        }
+        used += reclen;
+        ++dir->pos;
+    }
+    if (used == 0 && dir->pos < LIST_ENTRIES) {
+        errno = EINVAL;
+        return -1;
+    }
+    return (xf_vfs_ssize_t)used;
+}
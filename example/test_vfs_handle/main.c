@@ -0,0 +1,375 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief XF_VFS_FLAG_HANDLE 测试：驱动用指针句柄代替 local fd.
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define OBJ_DATA_SIZE   32
+#define OBJ_MAX         4
+
+/* ==================== [Typedefs] ========================================== */
+
+/* 驱动对象：open 直接返回对象指针，驱动无需 fd -> 对象的查找表 */
+typedef struct {
+    bool used;
+    const char *name;
+    char data[OBJ_DATA_SIZE];
+    xf_vfs_off_t size;
+    xf_vfs_off_t pos;
+} obj_t;
+
+typedef struct {
+    obj_t objs[OBJ_MAX];
+    int open_count;
+    int close_count;
+    void *last_handle;
+} objfs_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void *obj_open(void *ctx, const char *path, int flags, int mode);
+static int obj_close(void *ctx, void *h);
+static xf_vfs_ssize_t obj_write(void *ctx, void *h, const void *data, size_t size);
+static xf_vfs_ssize_t obj_read(void *ctx, void *h, void *dst, size_t size);
+static xf_vfs_off_t obj_lseek(void *ctx, void *h, xf_vfs_off_t offset, int mode);
+static xf_vfs_ssize_t obj_pread(void *ctx, void *h, void *dst, size_t size, xf_vfs_off_t offset);
+static xf_vfs_ssize_t obj_pwrite(void *ctx, void *h, const void *src, size_t size, xf_vfs_off_t offset);
+static int obj_fstat(void *ctx, void *h, xf_vfs_stat_t *st);
+static int obj_ftruncate(void *ctx, void *h, xf_vfs_off_t length);
+
+static void TEST_CASE_handle_register(void);
+static void TEST_CASE_handle_io(void);
+static void TEST_CASE_handle_dup(void);
+static void TEST_CASE_handle_vfs_offset(void);
+static void TEST_CASE_handle_unregister_closes(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static objfs_t s_fs;
+
+static const xf_vfs_handle_ops_t s_handle_ops = {
+    .open = obj_open,
+    .close = obj_close,
+    .write = obj_write,
+    .lseek = obj_lseek,
+    .read = obj_read,
+    .pread = obj_pread,
+    .pwrite = obj_pwrite,
+    .fstat = obj_fstat,
+    .ftruncate = obj_ftruncate,
+};
+
+static const xf_vfs_fs_ops_t s_ops = {
+    .handle = &s_handle_ops,
+};
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    TEST_CASE_handle_register();
+
+    TEST_XF_OK(xf_vfs_register_fs("/obj", &s_ops, XF_VFS_FLAG_STATIC | XF_VFS_FLAG_HANDLE, &s_fs));
+    TEST_CASE_handle_io();
+    TEST_CASE_handle_dup();
+    TEST_XF_OK(xf_vfs_unregister_fs("/obj"));
+
+    TEST_XF_OK(xf_vfs_register_fs("/obj", &s_ops, XF_VFS_FLAG_HANDLE | XF_VFS_FLAG_VFS_OFFSET, &s_fs));
+    TEST_CASE_handle_vfs_offset();
+    TEST_XF_OK(xf_vfs_unregister_fs("/obj"));
+
+    TEST_CASE_handle_unregister_closes();
+    return 0;
+}
+
+static void TEST_CASE_handle_register(void)
+{
+    /* 句柄模式必须提供 handle->open */
+    const xf_vfs_fs_ops_t no_handle = { 0 };
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_register_fs("/obj", &no_handle, XF_VFS_FLAG_HANDLE, NULL));
+
+    /* 句柄模式的挂载点不能注册 fd */
+    xf_vfs_id_t id;
+    int fd;
+    TEST_XF_OK(xf_vfs_register_fs_with_id(&s_ops, XF_VFS_FLAG_HANDLE, &s_fs, &id));
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_register_fd(id, &fd));
+    TEST_XF_OK(xf_vfs_unregister_fs_with_id(id));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_handle_io(void)
+{
+    char buf[16] = {0};
+    int fd = xf_vfs_open("/obj/a", XF_VFS_O_RDWR | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT(xf_vfs_open("/obj/missing", XF_VFS_O_RDONLY, 0) < 0);
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+
+    /* 每次调用都收到 open 返回的句柄 */
+    void *h = s_fs.last_handle;
+    TEST_ASSERT_EQUAL(5, xf_vfs_write(fd, "hello", 5));
+    TEST_ASSERT(s_fs.last_handle == h);
+    TEST_ASSERT_EQUAL(1, xf_vfs_lseek(fd, 1, XF_VFS_SEEK_SET));
+    TEST_ASSERT_EQUAL(4, xf_vfs_read(fd, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "ello"));
+
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstat(fd, &st));
+    TEST_ASSERT_EQUAL(5, st.st_size);
+    TEST_ASSERT_EQUAL(0, xf_vfs_ftruncate(fd, 2));
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstat(fd, &st));
+    TEST_ASSERT_EQUAL(2, st.st_size);
+
+    /* 驱动未实现的函数 */
+    TEST_ASSERT(xf_vfs_fsync(fd) < 0);
+    TEST_ASSERT_EQUAL(ENOSYS, errno);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT(s_fs.last_handle == h);
+    TEST_ASSERT_EQUAL(s_fs.open_count, s_fs.close_count);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_handle_dup(void)
+{
+    int fd = xf_vfs_open("/obj/a", XF_VFS_O_RDWR, 0);
+    int other = xf_vfs_open("/obj/b", XF_VFS_O_RDWR | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0 && other >= 0);
+    int fd2 = xf_vfs_dup(fd);
+    TEST_ASSERT(fd2 >= 0);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(s_fs.open_count - 2, s_fs.close_count);
+    TEST_ASSERT_EQUAL(2, xf_vfs_write(fd2, "AB", 2));
+
+    /* dup2 覆盖最后一个引用时，用原句柄关闭 */
+    void *h = s_fs.last_handle;
+    TEST_ASSERT_EQUAL(fd2, xf_vfs_dup2(other, fd2));
+    TEST_ASSERT(s_fs.last_handle == h);
+    TEST_ASSERT_EQUAL(s_fs.open_count - 1, s_fs.close_count);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd2));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(other));
+    TEST_ASSERT_EQUAL(s_fs.open_count, s_fs.close_count);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_handle_vfs_offset(void)
+{
+    char buf[8] = {0};
+    int fd = xf_vfs_open("/obj/a", XF_VFS_O_RDWR | XF_VFS_O_APPEND, 0);
+    TEST_ASSERT(fd >= 0);
+
+    /* 偏移由 VFS 维护，驱动只收到带句柄的 pread/pwrite */
+    TEST_ASSERT_EQUAL(2, xf_vfs_write(fd, "CD", 2));
+    TEST_ASSERT_EQUAL(4, xf_vfs_pread(fd, buf, 4, 0));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "ABCD"));
+    TEST_ASSERT_EQUAL(2, xf_vfs_lseek(fd, -2, XF_VFS_SEEK_END));
+    xf_memset(buf, 0, sizeof(buf));
+    TEST_ASSERT_EQUAL(2, xf_vfs_read(fd, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "CD"));
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(s_fs.open_count, s_fs.close_count);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_handle_unregister_closes(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/obj", &s_ops, XF_VFS_FLAG_HANDLE, &s_fs));
+    int base = s_fs.close_count;
+
+    int fd_a = xf_vfs_open("/obj/a", XF_VFS_O_RDONLY, 0);
+    int fd_b = xf_vfs_open("/obj/b", XF_VFS_O_RDWR | XF_VFS_O_CREAT, 0);
+    TEST_ASSERT(fd_a >= 0);
+    TEST_ASSERT(fd_b >= 0);
+    int fd_dup = xf_vfs_dup(fd_a);
+    TEST_ASSERT(fd_dup >= 0);
+
+    /* 卸载时每个存活句柄（dup 共享的只算一个）都要交还驱动关闭 */
+    TEST_XF_OK(xf_vfs_unregister_fs("/obj"));
+    TEST_ASSERT_EQUAL(base + 2, s_fs.close_count);
+    TEST_ASSERT_EQUAL(s_fs.open_count, s_fs.close_count);
+
+    /* fd 随挂载一起失效，不会再次关闭 */
+    TEST_ASSERT_EQUAL(-1, xf_vfs_close(fd_a));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_close(fd_dup));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_close(fd_b));
+    TEST_ASSERT_EQUAL(base + 2, s_fs.close_count);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void *obj_open(void *ctx, const char *path, int flags, int mode)
+{
+    objfs_t *fs = (objfs_t *)ctx;
+    obj_t *free_obj = NULL;
+    for (int i = 0; i < OBJ_MAX; ++i) {
+        obj_t *obj = &fs->objs[i];
+        if (obj->used && xf_strcmp(obj->name, path) == 0) {
+            free_obj = obj;
+            break;
+        }
+        if (!obj->used && free_obj == NULL) {
+            free_obj = obj;
+        }
+    }
+    if (free_obj == NULL || (!free_obj->used && !(flags & XF_VFS_O_CREAT))) {
+        errno = ENOENT;
+        return NULL;
+    }
+    if (!free_obj->used) {
+        /* 测试中路径均为字符串常量 */
+        free_obj->used = true;
+        free_obj->name = path;
+        free_obj->size = 0;
+    }
+    free_obj->pos = 0;
+    ++fs->open_count;
+    fs->last_handle = free_obj;
+    return free_obj;
+}
+
+static int obj_close(void *ctx, void *h)
+{
+    objfs_t *fs = (objfs_t *)ctx;
+    ++fs->close_count;
+    fs->last_handle = h;
+    return 0;
+}
+
+static xf_vfs_ssize_t obj_pwrite(void *ctx, void *h, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    obj_t *obj = (obj_t *)h;
+    ((objfs_t *)ctx)->last_handle = h;
+    if (offset + (xf_vfs_off_t)size > OBJ_DATA_SIZE) {
+        errno = ENOSPC;
+        return -1;
+    }
+    xf_memcpy(obj->data + offset, src, size);
+    if (offset + (xf_vfs_off_t)size > obj->size) {
+        obj->size = offset + size;
+    }
+    return size;
+}
+
+static xf_vfs_ssize_t obj_pread(void *ctx, void *h, void *dst, size_t size, xf_vfs_off_t offset)
+{
+    obj_t *obj = (obj_t *)h;
+    ((objfs_t *)ctx)->last_handle = h;
+    if (offset >= obj->size) {
+        return 0;
+    }
+    if (offset + (xf_vfs_off_t)size > obj->size) {
+        size = obj->size - offset;
+    }
+    xf_memcpy(dst, obj->data + offset, size);
+    return size;
+}
+
+static xf_vfs_ssize_t obj_write(void *ctx, void *h, const void *data, size_t size)
+{
+    obj_t *obj = (obj_t *)h;
+    xf_vfs_ssize_t ret = obj_pwrite(ctx, h, data, size, obj->pos);
+    if (ret > 0) {
+        obj->pos += ret;
+    }
+    return ret;
+}
+
+static xf_vfs_ssize_t obj_read(void *ctx, void *h, void *dst, size_t size)
+{
+    obj_t *obj = (obj_t *)h;
+    xf_vfs_ssize_t ret = obj_pread(ctx, h, dst, size, obj->pos);
+    if (ret > 0) {
+        obj->pos += ret;
+    }
+    return ret;
+}
+
+static xf_vfs_off_t obj_lseek(void *ctx, void *h, xf_vfs_off_t offset, int mode)
+{
+    obj_t *obj = (obj_t *)h;
+    ((objfs_t *)ctx)->last_handle = h;
+    xf_vfs_off_t base = (mode == XF_VFS_SEEK_END) ? obj->size : ((mode == XF_VFS_SEEK_CUR) ? obj->pos : 0);
+    if (base + offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    obj->pos = base + offset;
+    return obj->pos;
+}
+
+static int obj_fstat(void *ctx, void *h, xf_vfs_stat_t *st)
+{
+    obj_t *obj = (obj_t *)h;
+    ((objfs_t *)ctx)->last_handle = h;
+    xf_memset(st, 0, sizeof(*st));
+    st->st_size = obj->size;
+    st->st_mode = XF_VFS_S_IFREG;
+    return 0;
+}
+
+static int obj_ftruncate(void *ctx, void *h, xf_vfs_off_t length)
+{
+    obj_t *obj = (obj_t *)h;
+    ((objfs_t *)ctx)->last_handle = h;
+    if (length > OBJ_DATA_SIZE) {
+        errno = EFBIG;
+        return -1;
+    }
+    obj->size = length;
+    return 0;
+}
@@ -0,0 +1,395 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 延迟直方图测试：分位数与最大值、快照与清零、直方图用完与回收，以及记录期间的快照。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_osal.h"
+#include "xf_vfs.h"
+#include "xf_vfs_latency.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define HISTS_MAX           XF_VFS_LATENCY_SLOTS
+#define THREADS             3
+#define THREAD_OPS          20000
+
+/* ==================== [Typedefs] ========================================== */
+
+/*
+ * 模拟设备：每次读写推进模拟时钟，写入每 stall_every 次有一次 stall_ns（如 SPI flash 擦除）。
+ */
+typedef struct {
+    uint32_t read_ns;
+    uint32_t write_ns;
+    uint32_t stall_every;
+    uint32_t stall_ns;
+    uint32_t writes;
+} slow_dev_t;
+
+/* 一次快照的结果 */
+typedef struct {
+    xf_vfs_id_t vfs_id;
+    xf_vfs_trace_op_t op;
+    xf_vfs_latency_hist_t hist;
+} hist_copy_t;
+
+typedef struct {
+    hist_copy_t hists[HISTS_MAX];
+    size_t count;
+} snapshot_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int dev_open(void *ctx, const char *path, int flags, int mode);
+static int dev_close(void *ctx, int fd);
+static xf_vfs_ssize_t dev_read(void *ctx, int fd, void *dst, size_t size);
+static xf_vfs_ssize_t dev_write(void *ctx, int fd, const void *data, size_t size);
+
+static void collect_cb(xf_vfs_id_t vfs_id, xf_vfs_trace_op_t op, const xf_vfs_latency_hist_t *hist, void *arg);
+static void snapshot(snapshot_t *s, bool reset);
+static const hist_copy_t *find(const snapshot_t *s, xf_vfs_trace_op_t op, uint32_t count);
+static uint32_t count_of(const snapshot_t *s, xf_vfs_trace_op_t op);
+static void repeat_read(const char *path, int n);
+static void worker(void *argument);
+
+static void TEST_CASE_latency_percentiles(void);
+static void TEST_CASE_latency_snapshot_reset(void);
+static void TEST_CASE_latency_slots(void);
+static void TEST_CASE_latency_concurrent(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_fs_ops_t s_dev_ops = {
+    .open_p = dev_open,
+    .close_p = dev_close,
+    .read_p = dev_read,
+    .write_p = dev_write,
+};
+
+static uint64_t s_clock_ns;
+static snapshot_t s_snap;
+static xf_osal_semaphore_t s_done;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* 分位数为所在桶的上界，相对误差不超过 2^-XF_VFS_LATENCY_SUB_BITS */
+#define TEST_ASSERT_NEAR(expected_ns, actual_ns) \
+    TEST_ASSERT((actual_ns) >= (expected_ns) \
+                && (actual_ns) <= (expected_ns) + ((expected_ns) >> XF_VFS_LATENCY_SUB_BITS))
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+uint64_t test_clock_ns(void)
+{
+    return s_clock_ns;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    TEST_CASE_latency_percentiles();
+    TEST_CASE_latency_snapshot_reset();
+    TEST_CASE_latency_slots();
+    TEST_CASE_latency_concurrent();
+    return 0;
+}
+
+/* 偶发的长延迟不影响 p50/p99，但体现在 p99.9 与 max 中；各挂载点分别统计 */
+static void TEST_CASE_latency_percentiles(void)
+{
+    slow_dev_t flash = { .read_ns = 5000, .write_ns = 20000, .stall_every = 200, .stall_ns = 80000000 };
+    slow_dev_t sd = { .read_ns = 1000000 };
+    TEST_XF_OK(xf_vfs_register_fs("/flash", &s_dev_ops, XF_VFS_FLAG_CONTEXT_PTR, &flash));
+    TEST_XF_OK(xf_vfs_register_fs("/sd", &s_dev_ops, XF_VFS_FLAG_CONTEXT_PTR, &sd));
+
+    char buf[16] = { 0 };
+    int fd = xf_vfs_open("/flash/log", XF_VFS_O_WRONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    for (int i = 0; i < 1000; ++i) {
+        TEST_ASSERT_EQUAL(sizeof(buf), xf_vfs_write(fd, buf, sizeof(buf)));
+    }
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    repeat_read("/flash/log", 100);
+    repeat_read("/sd/img", 50);
+
+    snapshot(&s_snap, true);
+    const hist_copy_t *w = find(&s_snap, XF_VFS_TRACE_OP_WRITE, 1000);
+    TEST_ASSERT(w != NULL);
+    TEST_ASSERT_NEAR(20000u, xf_vfs_latency_value_at(&w->hist, 5000));
+    TEST_ASSERT_NEAR(20000u, xf_vfs_latency_value_at(&w->hist, 9000));
+    TEST_ASSERT_NEAR(20000u, xf_vfs_latency_value_at(&w->hist, 9900));
+    TEST_ASSERT_EQUAL(80000000u, xf_vfs_latency_value_at(&w->hist, 9990));
+    TEST_ASSERT_EQUAL(80000000u, w->hist.max);
+
+    const hist_copy_t *fr = find(&s_snap, XF_VFS_TRACE_OP_READ, 100);
+    const hist_copy_t *sr = find(&s_snap, XF_VFS_TRACE_OP_READ, 50);
+    TEST_ASSERT(fr != NULL && sr != NULL);
+    TEST_ASSERT_EQUAL(w->vfs_id, fr->vfs_id);
+    TEST_ASSERT(sr->vfs_id != fr->vfs_id);
+    TEST_ASSERT_NEAR(5000u, xf_vfs_latency_value_at(&fr->hist, 9990));
+    TEST_ASSERT_NEAR(1000000u, xf_vfs_latency_value_at(&sr->hist, 5000));
+    TEST_ASSERT_EQUAL(1000000u, sr->hist.max);
+
+    /* open/close 也被统计，驱动未计时的调用耗时为 0 */
+    const hist_copy_t *o = find(&s_snap, XF_VFS_TRACE_OP_OPEN, 101);
+    TEST_ASSERT(o != NULL);
+    TEST_ASSERT_EQUAL(0u, o->hist.max);
+    TEST_ASSERT_EQUAL(151u, count_of(&s_snap, XF_VFS_TRACE_OP_CLOSE));
+
+    /* 清零后再次快照为空 */
+    snapshot(&s_snap, false);
+    TEST_ASSERT_EQUAL(0, s_snap.count);
+
+    repeat_read("/sd/img", 3);
+    xf_vfs_latency_report(true);
+
+    TEST_XF_OK(xf_vfs_unregister_fs("/flash"));
+    TEST_XF_OK(xf_vfs_unregister_fs("/sd"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 不清零的快照继续累计，清零的快照之后从 0 开始 */
+static void TEST_CASE_latency_snapshot_reset(void)
+{
+    slow_dev_t dev = { .read_ns = 3000 };
+    TEST_XF_OK(xf_vfs_register_fs("/dev", &s_dev_ops, XF_VFS_FLAG_CONTEXT_PTR, &dev));
+
+    repeat_read("/dev/a", 10);
+    snapshot(&s_snap, false);
+    TEST_ASSERT_EQUAL(10u, count_of(&s_snap, XF_VFS_TRACE_OP_READ));
+    snapshot(&s_snap, false);
+    TEST_ASSERT_EQUAL(10u, count_of(&s_snap, XF_VFS_TRACE_OP_READ));
+
+    dev.read_ns = 7000;
+    repeat_read("/dev/a", 5);
+    snapshot(&s_snap, true);
+    const hist_copy_t *r = find(&s_snap, XF_VFS_TRACE_OP_READ, 15);
+    TEST_ASSERT(r != NULL);
+    TEST_ASSERT_EQUAL(7000u, r->hist.max);
+    TEST_ASSERT_NEAR(3000u, xf_vfs_latency_value_at(&r->hist, 5000));
+    TEST_ASSERT_EQUAL(7000u, xf_vfs_latency_value_at(&r->hist, 9000));
+
+    snapshot(&s_snap, true);
+    TEST_ASSERT_EQUAL(0, s_snap.count);
+
+    TEST_XF_OK(xf_vfs_unregister_fs("/dev"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 直方图用完后新组合的样本被丢弃，卸载挂载点后其直方图可被复用 */
+static void TEST_CASE_latency_slots(void)
+{
+    slow_dev_t dev = { .read_ns = 1000, .write_ns = 2000 };
+    char buf[4] = { 0 };
+    TEST_XF_OK(xf_vfs_register_fs("/a", &s_dev_ops, XF_VFS_FLAG_CONTEXT_PTR, &dev));
+    TEST_XF_OK(xf_vfs_register_fs("/b", &s_dev_ops, XF_VFS_FLAG_CONTEXT_PTR, &dev));
+    TEST_XF_OK(xf_vfs_register_fs("/c", &s_dev_ops, XF_VFS_FLAG_CONTEXT_PTR, &dev));
+
+    /* /a、/b 各占用 open、read、write、close 4 个 */
+    static const char *const paths[] = { "/a/f", "/b/f" };
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i) {
+        int fd = xf_vfs_open(paths[i], XF_VFS_O_RDWR, 0);
+        TEST_ASSERT(fd >= 0);
+        TEST_ASSERT_EQUAL(sizeof(buf), xf_vfs_write(fd, buf, sizeof(buf)));
+        TEST_ASSERT_EQUAL(sizeof(buf), xf_vfs_read(fd, buf, sizeof(buf)));
+        TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    }
+    TEST_ASSERT_EQUAL(8, HISTS_MAX);
+
+    const uint32_t dropped = xf_vfs_latency_dropped();
+    repeat_read("/c/f", 2);
+    TEST_ASSERT_EQUAL(dropped + 6, xf_vfs_latency_dropped());
+    snapshot(&s_snap, true);
+    TEST_ASSERT_EQUAL(8, s_snap.count);
+
+    TEST_XF_OK(xf_vfs_unregister_fs("/a"));
+    repeat_read("/c/f", 2);
+    TEST_ASSERT_EQUAL(dropped + 6, xf_vfs_latency_dropped());
+    snapshot(&s_snap, true);
+    TEST_ASSERT_EQUAL(3, s_snap.count);
+    TEST_ASSERT_EQUAL(2u, count_of(&s_snap, XF_VFS_TRACE_OP_READ));
+
+    TEST_XF_OK(xf_vfs_unregister_fs("/b"));
+    TEST_XF_OK(xf_vfs_unregister_fs("/c"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 记录期间反复清零快照，所有样本恰好被统计一次 */
+static void TEST_CASE_latency_concurrent(void)
+{
+    slow_dev_t dev = { 0 };
+    const xf_osal_thread_attr_t attr = {
+        .name = "worker",
+        .stack_size = 2048,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    TEST_XF_OK(xf_vfs_register_fs("/null", &s_dev_ops, XF_VFS_FLAG_CONTEXT_PTR, &dev));
+    s_done = xf_osal_semaphore_create(THREADS, 0, NULL);
+    TEST_ASSERT(s_done != NULL);
+
+    snapshot(&s_snap, true);
+    for (int i = 0; i < THREADS; ++i) {
+        TEST_ASSERT(xf_osal_thread_create(worker, NULL, &attr) != NULL);
+    }
+    uint32_t total = 0;
+    int snapshots = 0;
+    int done = 0;
+    while (done < THREADS) {
+        if (xf_osal_semaphore_acquire(s_done, 0) == XF_OK) {
+            ++done;
+        }
+        snapshot(&s_snap, true);
+        total += count_of(&s_snap, XF_VFS_TRACE_OP_READ);
+        ++snapshots;
+    }
+    snapshot(&s_snap, true);
+    total += count_of(&s_snap, XF_VFS_TRACE_OP_READ);
+    xf_log_printf("%d snapshots during %d reads\n", snapshots, THREADS * THREAD_OPS);
+    TEST_ASSERT_EQUAL((uint32_t)(THREADS * THREAD_OPS), total);
+
+    xf_osal_semaphore_delete(s_done);
+    TEST_XF_OK(xf_vfs_unregister_fs("/null"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void worker(void *argument)
+{
+    char c;
+    int fd = xf_vfs_open("/null/f", XF_VFS_O_RDONLY, 0);
+    for (int i = 0; i < THREAD_OPS; ++i) {
+        xf_vfs_read(fd, &c, 1);
+    }
+    xf_vfs_close(fd);
+    xf_osal_semaphore_release(s_done);
+    xf_osal_thread_delete(NULL);
+}
+
+static void repeat_read(const char *path, int n)
+{
+    char buf[16];
+    for (int i = 0; i < n; ++i) {
+        int fd = xf_vfs_open(path, XF_VFS_O_RDONLY, 0);
+        TEST_ASSERT(fd >= 0);
+        TEST_ASSERT_EQUAL(sizeof(buf), xf_vfs_read(fd, buf, sizeof(buf)));
+        TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    }
+}
+
+static void collect_cb(xf_vfs_id_t vfs_id, xf_vfs_trace_op_t op, const xf_vfs_latency_hist_t *hist, void *arg)
+{
+    snapshot_t *s = (snapshot_t *)arg;
+    TEST_ASSERT(s->count < HISTS_MAX);
+    hist_copy_t *c = &s->hists[s->count++];
+    c->vfs_id = vfs_id;
+    c->op = op;
+    xf_memcpy(&c->hist, hist, sizeof(*hist));
+
+    /* 桶与样本数一致 */
+    uint32_t sum = 0;
+    for (int i = 0; i < XF_VFS_LATENCY_BUCKETS; ++i) {
+        sum += hist->buckets[i];
+    }
+    TEST_ASSERT_EQUAL(hist->count, sum);
+}
+
+static void snapshot(snapshot_t *s, bool reset)
+{
+    s->count = 0;
+    TEST_ASSERT_EQUAL(0, xf_vfs_latency_snapshot(collect_cb, s, reset));
+}
+
+/* 查找操作为 op 且样本数为 count 的直方图 */
+static const hist_copy_t *find(const snapshot_t *s, xf_vfs_trace_op_t op, uint32_t count)
+{
+    for (size_t i = 0; i < s->count; ++i) {
+        if (s->hists[i].op == op && s->hists[i].hist.count == count) {
+            return &s->hists[i];
+        }
+    }
+    return NULL;
+}
+
+/* 所有挂载点上 op 的样本数之和 */
+static uint32_t count_of(const snapshot_t *s, xf_vfs_trace_op_t op)
+{
+    uint32_t count = 0;
+    for (size_t i = 0; i < s->count; ++i) {
+        if (s->hists[i].op == op) {
+            count += s->hists[i].hist.count;
+        }
+    }
+    return count;
+}
+
+static int dev_open(void *ctx, const char *path, int flags, int mode)
+{
+    return 0;
+}
+
+static int dev_close(void *ctx, int fd)
+{
+    return 0;
+}
+
+static xf_vfs_ssize_t dev_read(void *ctx, int fd, void *dst, size_t size)
+{
+    slow_dev_t *dev = (slow_dev_t *)ctx;
+    if (dev->read_ns != 0) {
+        s_clock_ns += dev->read_ns;
+    }
+    return (xf_vfs_ssize_t)size;
+}
+
+static xf_vfs_ssize_t dev_write(void *ctx, int fd, const void *data, size_t size)
+{
+    slow_dev_t *dev = (slow_dev_t *)ctx;
+    ++dev->writes;
+    if (dev->stall_every != 0 && dev->writes % dev->stall_every == 0) {
+        s_clock_ns += dev->stall_ns;
+    } else {
+        s_clock_ns += dev->write_ns;
+    }
+    return (xf_vfs_ssize_t)size;
+}
@@ -0,0 +1,252 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 无堆模式测试：内部结构取自固定内存池，内存池用量统计，以及可替换的分配器。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+#include "xf_vfs_mem.h"
+#include "xf_vfs_walk.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct {
+    uint32_t allocs;
+    uint32_t frees;
+} counting_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int null_open(const char *path, int flags, int mode);
+static int null_close(int fd);
+static int other_open(const char *path, int flags, int mode);
+static void *counting_alloc(size_t size, void *ctx);
+static void counting_dealloc(void *ptr, void *ctx);
+
+static void TEST_CASE_mem_mount_pools(void);
+static void TEST_CASE_mem_handle_pools(void);
+static void TEST_CASE_mem_allocator(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_fs_ops_t s_null_ops = {
+    .open = null_open,
+    .close = null_close,
+};
+
+static const xf_vfs_fs_ops_t s_other_ops = {
+    .open = other_open,
+    .close = null_close,
+};
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    TEST_CASE_mem_mount_pools();
+    TEST_CASE_mem_handle_pools();
+    TEST_CASE_mem_allocator();
+    return 0;
+}
+
+/* 挂载点与驱动函数表副本来自内存池，不经过分配器 */
+static void TEST_CASE_mem_mount_pools(void)
+{
+    xf_vfs_mem_stats_t st;
+    xf_vfs_get_mem_stats(&st);
+    TEST_ASSERT_EQUAL(XF_VFS_MAX_COUNT, st.entry.count);
+    TEST_ASSERT_EQUAL(XF_VFS_MAX_COUNT, st.ops.count);
+    TEST_ASSERT_EQUAL(0, st.entry.used);
+
+    char path[16];
+    for (int i = 0; i < XF_VFS_MAX_COUNT; ++i) {
+        xf_snprintf(path, sizeof(path), "/null%d", i);
+        TEST_XF_OK(xf_vfs_register_fs(path, (i == 0) ? &s_other_ops : &s_null_ops, XF_VFS_FLAG_DEFAULT, NULL));
+    }
+    xf_vfs_get_mem_stats(&st);
+    TEST_ASSERT_EQUAL(XF_VFS_MAX_COUNT, st.entry.used);
+    TEST_ASSERT_EQUAL(2, st.ops.used);              /* 相同的函数表只保存一份 */
+    TEST_ASSERT_EQUAL(0, st.heap_used);
+
+    /* 挂载表已满 */
+    TEST_ASSERT(xf_vfs_register_fs("/full", &s_null_ops, XF_VFS_FLAG_DEFAULT, NULL) != XF_OK);
+
+    int fd = xf_vfs_open("/null3/f", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+
+    for (int i = 0; i < XF_VFS_MAX_COUNT; ++i) {
+        xf_snprintf(path, sizeof(path), "/null%d", i);
+        TEST_XF_OK(xf_vfs_unregister_fs(path));
+    }
+    xf_vfs_get_mem_stats(&st);
+    TEST_ASSERT_EQUAL(0, st.entry.used);
+    TEST_ASSERT_EQUAL(0, st.ops.used);
+    TEST_ASSERT_EQUAL(XF_VFS_MAX_COUNT, st.entry.peak);
+    TEST_ASSERT_EQUAL(0, st.heap_used);
+    TEST_ASSERT_EQUAL(0, st.heap_peak);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_mem_handle_pools(void)
+{
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+
+    xf_vfs_path_t *p[XF_VFS_POOL_PATH_COUNT];
+    for (int i = 0; i < XF_VFS_POOL_PATH_COUNT; ++i) {
+        p[i] = xf_vfs_path_prepare("/ram/f");
+        TEST_ASSERT(p[i] != NULL);
+    }
+    TEST_ASSERT(xf_vfs_path_prepare("/ram/f") == NULL);
+    TEST_ASSERT_EQUAL(ENOMEM, errno);
+
+    xf_vfs_mem_stats_t st;
+    xf_vfs_get_mem_stats(&st);
+    TEST_ASSERT_EQUAL(XF_VFS_POOL_PATH_COUNT, st.path.used);
+    TEST_ASSERT_EQUAL(1, st.path.fails);
+
+    xf_vfs_path_release(p[1]);
+    p[1] = xf_vfs_path_prepare("/ram/f");
+    TEST_ASSERT(p[1] != NULL);
+    int fd = xf_vfs_open_p(p[1], XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    for (int i = 0; i < XF_VFS_POOL_PATH_COUNT; ++i) {
+        xf_vfs_path_release(p[i]);
+    }
+
+    /* 路径超过块大小 */
+    char long_path[XF_VFS_AT_PATH_MAX + 8];
+    xf_memset(long_path, 'a', sizeof(long_path) - 1);
+    long_path[0] = '/';
+    long_path[sizeof(long_path) - 1] = '\0';
+    TEST_ASSERT(xf_vfs_path_prepare(long_path) == NULL);
+
+    xf_vfs_dirat_t *dir = xf_vfs_dirat_open("/ram");
+    TEST_ASSERT(dir != NULL);
+    xf_vfs_get_mem_stats(&st);
+    TEST_ASSERT_EQUAL(1, st.dirat.used);
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlinkat(dir, "f", 0));
+    TEST_ASSERT_EQUAL(0, xf_vfs_dirat_close(dir));
+
+    xf_vfs_get_mem_stats(&st);
+    TEST_ASSERT_EQUAL(0, st.path.used);
+    TEST_ASSERT_EQUAL(0, st.dirat.used);
+    TEST_ASSERT_EQUAL(0, st.heap_used);
+
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 无堆模式下 xf_vfs_walk() 等需要分配器 */
+static void TEST_CASE_mem_allocator(void)
+{
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ram/d", 0777));
+
+    xf_vfs_du_t du;
+    TEST_ASSERT_EQUAL(-1, xf_vfs_du("/ram", &du));
+    TEST_ASSERT_EQUAL(ENOMEM, errno);
+
+    counting_t counting = { 0 };
+    const xf_vfs_allocator_t allocator = {
+        .alloc = counting_alloc,
+        .dealloc = counting_dealloc,
+        .ctx = &counting,
+    };
+    xf_vfs_set_allocator(&allocator);
+    TEST_ASSERT_EQUAL(0, xf_vfs_du("/ram", &du));
+    TEST_ASSERT_EQUAL(2, du.dirs);
+    TEST_ASSERT(counting.allocs > 0);
+    TEST_ASSERT_EQUAL(counting.allocs, counting.frees);
+
+    xf_vfs_mem_stats_t st;
+    xf_vfs_get_mem_stats(&st);
+    TEST_ASSERT_EQUAL(0, st.heap_used);
+    TEST_ASSERT(st.heap_peak >= 1);
+    TEST_ASSERT_EQUAL(1, st.heap_fails);
+
+    xf_vfs_set_allocator(NULL);
+    TEST_ASSERT(xf_vfs_malloc(1) == NULL);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_rmdir("/ram/d"));
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void *counting_alloc(size_t size, void *ctx)
+{
+    ++((counting_t *)ctx)->allocs;
+    return xf_malloc(size);
+}
+
+static void counting_dealloc(void *ptr, void *ctx)
+{
+    ++((counting_t *)ctx)->frees;
+    xf_free(ptr);
+}
+
+static int null_open(const char *path, int flags, int mode)
+{
+    return 0;
+}
+
+static int other_open(const char *path, int flags, int mode)
+{
+    return 1;
+}
+
+static int null_close(int fd)
+{
+    return 0;
+}
@@ -0,0 +1,644 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief pwrite 合并调度测试：相邻与重叠的合并、按文件分组（含句柄模式）、错误与部分写入、
+ *        有请求排队时关闭，以及合并率与增加延迟的基准。
+ * @version 1.0
+ * @date 2025-01-24
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_osal.h"
+#include "xf_vfs.h"
+#include "xf_vfs_merge.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define DEV_FILES           2
+#define DEV_FILE_SIZE       4096
+#define CALLS_MAX           16
+
+#define BENCH_THREADS       4
+#define BENCH_WRITES        32
+#define BENCH_BS            256
+#define FLASH_SIZE          (BENCH_THREADS * BENCH_WRITES * BENCH_BS)
+#define FLASH_PROGRAM_US    300
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct {
+    int fd;
+    xf_vfs_off_t offset;
+    size_t size;
+    char fill;
+    xf_vfs_ssize_t ret;
+    int err;
+} writer_t;
+
+typedef struct {
+    int local_fd;
+    xf_vfs_off_t offset;
+    size_t size;
+} dev_call_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int dev_open(const char *path, int flags, int mode);
+static int dev_close(int fd);
+static xf_vfs_ssize_t dev_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset);
+static void *hdev_open(void *ctx, const char *path, int flags, int mode);
+static int hdev_close(void *ctx, void *h);
+static xf_vfs_ssize_t hdev_pwrite(void *ctx, void *h, const void *src, size_t size, xf_vfs_off_t offset);
+static int flash_open(const char *path, int flags, int mode);
+static xf_vfs_ssize_t flash_pread(int fd, void *dst, size_t size, xf_vfs_off_t offset);
+static xf_vfs_ssize_t flash_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset);
+
+static void writer_thread(void *argument);
+static void writers_start(writer_t *w, size_t n, uint32_t spacing_ms);
+static void writers_wait(size_t n);
+static void writers_run(writer_t *w, size_t n, uint32_t spacing_ms);
+static void bench_thread(void *argument);
+static void bench_run(const char *label, const char *stats_path);
+static void dev_reset(void);
+
+static void TEST_CASE_merge_single(void);
+static void TEST_CASE_merge_adjacent(void);
+static void TEST_CASE_merge_overlap(void);
+static void TEST_CASE_merge_errors(void);
+static void TEST_CASE_merge_handle_files(void);
+static void TEST_CASE_merge_disable_while_queued(void);
+static void TEST_CASE_merge_bench(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_fs_ops_t s_dev_ops = {
+    .open = dev_open,
+    .close = dev_close,
+    .pwrite = dev_pwrite,
+};
+
+/* 句柄模式的设备，句柄指向文件的数据 */
+static const xf_vfs_handle_ops_t s_hdev_handle_ops = {
+    .open = hdev_open,
+    .close = hdev_close,
+    .pwrite = hdev_pwrite,
+};
+
+static const xf_vfs_fs_ops_t s_hdev_ops = {
+    .handle = &s_hdev_handle_ops,
+};
+
+/* 模拟 flash：一次只能进行一次编程，每次固定耗时 FLASH_PROGRAM_US */
+static const xf_vfs_fs_ops_t s_flash_ops = {
+    .open = flash_open,
+    .close = dev_close,
+    .pread = flash_pread,
+    .pwrite = flash_pwrite,
+};
+
+static uint8_t s_dev_data[DEV_FILES][DEV_FILE_SIZE];
+static dev_call_t s_calls[CALLS_MAX];
+static volatile size_t s_call_count;
+static xf_vfs_off_t s_fail_from;            /* 偏移不小于此值的调用失败，0 为不失败 */
+static size_t s_short_max;                  /* 每次调用最多写入的字节数，0 为不限 */
+
+static uint8_t s_flash[FLASH_SIZE];
+static xf_lock_t s_flash_lock;
+static volatile uint32_t s_flash_programs;
+
+static xf_osal_semaphore_t s_done;
+static int s_bench_fd;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "done",
+    };
+    s_done = xf_osal_semaphore_create(BENCH_THREADS, 0, &sem_attr);
+    TEST_ASSERT(s_done != NULL);
+    TEST_XF_OK(xf_vfs_register_fs("/dev", &s_dev_ops, XF_VFS_FLAG_STATIC, NULL));
+
+    TEST_CASE_merge_single();
+    TEST_CASE_merge_adjacent();
+    TEST_CASE_merge_overlap();
+    TEST_CASE_merge_errors();
+    TEST_CASE_merge_handle_files();
+    TEST_CASE_merge_disable_while_queued();
+    TEST_CASE_merge_bench();
+
+    TEST_XF_OK(xf_vfs_unregister_fs("/dev"));
+    xf_osal_semaphore_delete(s_done);
+    return 0;
+}
+
+/* 单个请求等待截止时间后下发；过大的请求与未开启的挂载点不排队 */
+static void TEST_CASE_merge_single(void)
+{
+    static const char data[512];
+    xf_vfs_merge_stats_t stats;
+    const int fd = xf_vfs_open("/dev/a", XF_VFS_O_WRONLY, 0);
+    TEST_ASSERT(fd >= 0);
+
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_STATE, xf_vfs_merge_get_stats("/dev", &stats, false));
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_merge_set("/nowhere", NULL));
+
+    const xf_vfs_merge_config_t config = { .deadline_us = 2000, .max_bytes = 256 };
+    TEST_XF_OK(xf_vfs_merge_set("/dev", &config));
+    dev_reset();
+    TEST_ASSERT_EQUAL(100, xf_vfs_pwrite(fd, data, 100, 0));
+    TEST_ASSERT_EQUAL(1, s_call_count);
+    TEST_XF_OK(xf_vfs_merge_get_stats("/dev/a", &stats, true));
+    TEST_ASSERT_EQUAL(1u, stats.requests);
+    TEST_ASSERT_EQUAL(1u, stats.driver_calls);
+    TEST_ASSERT_EQUAL(0u, stats.merged);
+    TEST_ASSERT_EQUAL(1u, stats.batches);
+    TEST_ASSERT_EQUAL(100u, stats.bytes);
+    TEST_ASSERT(stats.max_wait_us >= 1000);
+
+    /* 不小于 max_bytes 的请求直接下发 */
+    TEST_ASSERT_EQUAL(256, xf_vfs_pwrite(fd, data, 256, 0));
+    TEST_ASSERT_EQUAL(0, xf_vfs_pwrite(fd, data, 0, 0));
+    TEST_XF_OK(xf_vfs_merge_get_stats("/dev", &stats, true));
+    TEST_ASSERT_EQUAL(2u, stats.requests);
+    TEST_ASSERT_EQUAL(2u, stats.driver_calls);
+    TEST_ASSERT_EQUAL(0u, stats.batches);
+    TEST_ASSERT_EQUAL(0u, stats.max_wait_us);
+
+    TEST_XF_OK(xf_vfs_merge_set("/dev", NULL));
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_STATE, xf_vfs_merge_get_stats("/dev", &stats, false));
+    dev_reset();
+    TEST_ASSERT_EQUAL(100, xf_vfs_pwrite(fd, data, 100, 0));
+    TEST_ASSERT_EQUAL(1, s_call_count);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 批次排满时立即下发；同一文件上的相邻请求合并，不同文件分别下发，合并不超过 max_bytes */
+static void TEST_CASE_merge_adjacent(void)
+{
+    xf_vfs_merge_stats_t stats;
+    const int a = xf_vfs_open("/dev/a", XF_VFS_O_WRONLY, 0);
+    const int b = xf_vfs_open("/dev/b", XF_VFS_O_WRONLY, 0);
+    TEST_ASSERT(a >= 0 && b >= 0);
+
+    /* 截止时间很长，只有批次排满才会下发 */
+    xf_vfs_merge_config_t config = { .deadline_us = 60 * 1000 * 1000 };
+    TEST_XF_OK(xf_vfs_merge_set("/dev", &config));
+    writer_t w[4] = {
+        { .fd = a, .offset = 200, .size = 100, .fill = 'c' },
+        { .fd = b, .offset = 300, .size = 100, .fill = 'd' },
+        { .fd = a, .offset = 0, .size = 100, .fill = 'a' },
+        { .fd = a, .offset = 100, .size = 100, .fill = 'b' },
+    };
+    dev_reset();
+    writers_run(w, 4, 0);
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_EQUAL(100, w[i].ret);
+    }
+    TEST_ASSERT_EQUAL(2, s_call_count);
+    TEST_ASSERT_EQUAL(0, s_calls[0].local_fd);
+    TEST_ASSERT_EQUAL(0, s_calls[0].offset);
+    TEST_ASSERT_EQUAL(300u, s_calls[0].size);
+    TEST_ASSERT_EQUAL(1, s_calls[1].local_fd);
+    TEST_ASSERT_EQUAL(300, s_calls[1].offset);
+    TEST_ASSERT_EQUAL(100u, s_calls[1].size);
+    TEST_ASSERT(s_dev_data[0][0] == 'a' && s_dev_data[0][99] == 'a');
+    TEST_ASSERT(s_dev_data[0][100] == 'b' && s_dev_data[0][299] == 'c');
+    TEST_ASSERT(s_dev_data[1][300] == 'd' && s_dev_data[1][399] == 'd');
+    TEST_XF_OK(xf_vfs_merge_get_stats("/dev", &stats, true));
+    TEST_ASSERT_EQUAL(4u, stats.requests);
+    TEST_ASSERT_EQUAL(2u, stats.driver_calls);
+    TEST_ASSERT_EQUAL(3u, stats.merged);
+    TEST_ASSERT_EQUAL(1u, stats.batches);
+    TEST_ASSERT_EQUAL(400u, stats.bytes);
+
+    /* 相邻请求合并后不超过 256 字节 */
+    config.max_bytes = 256;
+    TEST_XF_OK(xf_vfs_merge_set("/dev", &config));
+    for (int i = 0; i < 4; ++i) {
+        w[i].fd = a;
+        w[i].offset = (xf_vfs_off_t)(i * 100);
+    }
+    dev_reset();
+    writers_run(w, 4, 0);
+    TEST_ASSERT_EQUAL(2, s_call_count);
+    TEST_ASSERT_EQUAL(0, s_calls[0].offset);
+    TEST_ASSERT_EQUAL(200u, s_calls[0].size);
+    TEST_ASSERT_EQUAL(200, s_calls[1].offset);
+    TEST_ASSERT_EQUAL(200u, s_calls[1].size);
+
+    TEST_XF_OK(xf_vfs_merge_set("/dev", NULL));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(a));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(b));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 重叠部分以后排队的请求为准；dup 出的 fd 与原 fd 合并；不相邻的请求分别下发 */
+static void TEST_CASE_merge_overlap(void)
+{
+    xf_vfs_merge_stats_t stats;
+    const int a = xf_vfs_open("/dev/a", XF_VFS_O_WRONLY, 0);
+    TEST_ASSERT(a >= 0);
+    const int a2 = xf_vfs_dup(a);
+    TEST_ASSERT(a2 >= 0);
+
+    const xf_vfs_merge_config_t config = { .deadline_us = 60 * 1000 * 1000 };
+    TEST_XF_OK(xf_vfs_merge_set("/dev", &config));
+    writer_t w[4] = {
+        { .fd = a, .offset = 0, .size = 100, .fill = 'a' },
+        { .fd = a, .offset = 50, .size = 100, .fill = 'b' },
+        { .fd = a, .offset = 1000, .size = 100, .fill = 'c' },
+        { .fd = a2, .offset = 150, .size = 100, .fill = 'd' },
+    };
+    dev_reset();
+    /* 依次启动，使排队顺序确定 */
+    writers_run(w, 4, 20);
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_EQUAL(100, w[i].ret);
+    }
+    TEST_ASSERT_EQUAL(2, s_call_count);
+    TEST_ASSERT_EQUAL(0, s_calls[0].offset);
+    TEST_ASSERT_EQUAL(250u, s_calls[0].size);
+    TEST_ASSERT_EQUAL(1000, s_calls[1].offset);
+    TEST_ASSERT_EQUAL(100u, s_calls[1].size);
+    TEST_ASSERT(s_dev_data[0][0] == 'a' && s_dev_data[0][49] == 'a');
+    TEST_ASSERT(s_dev_data[0][50] == 'b' && s_dev_data[0][149] == 'b');
+    TEST_ASSERT(s_dev_data[0][150] == 'd' && s_dev_data[0][249] == 'd');
+    TEST_ASSERT(s_dev_data[0][1000] == 'c');
+    TEST_XF_OK(xf_vfs_merge_get_stats("/dev", &stats, true));
+    TEST_ASSERT_EQUAL(3u, stats.merged);
+    /* 第一个请求等待了后三个请求的启动间隔 */
+    TEST_ASSERT(stats.max_wait_us >= 40 * 1000);
+
+    TEST_XF_OK(xf_vfs_merge_set("/dev", NULL));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(a2));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(a));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 合并的调用失败时所有请求得到相同的错误；只写入一部分时未写入的请求单独重新下发 */
+static void TEST_CASE_merge_errors(void)
+{
+    const int a = xf_vfs_open("/dev/a", XF_VFS_O_WRONLY, 0);
+    TEST_ASSERT(a >= 0);
+    const xf_vfs_merge_config_t config = { .deadline_us = 60 * 1000 * 1000 };
+    TEST_XF_OK(xf_vfs_merge_set("/dev", &config));
+    writer_t w[4];
+    for (int i = 0; i < 4; ++i) {
+        w[i] = (writer_t) {
+            .fd = a, .offset = (xf_vfs_off_t)(2000 + i * 100), .size = 100, .fill = (char)('a' + i)
+        };
+    }
+
+    dev_reset();
+    s_fail_from = 2000;
+    writers_run(w, 4, 0);
+    TEST_ASSERT_EQUAL(1, s_call_count);
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_EQUAL(-1, w[i].ret);
+        TEST_ASSERT_EQUAL(EIO, w[i].err);
+    }
+
+    /* 合并的调用只写入 150 字节：前两个请求得到 100 与 50，后两个重新下发 */
+    dev_reset();
+    s_short_max = 150;
+    writers_run(w, 4, 0);
+    TEST_ASSERT_EQUAL(3, s_call_count);
+    TEST_ASSERT_EQUAL(400u, s_calls[0].size);
+    TEST_ASSERT_EQUAL(100, w[0].ret);
+    TEST_ASSERT_EQUAL(50, w[1].ret);
+    TEST_ASSERT_EQUAL(100, w[2].ret);
+    TEST_ASSERT_EQUAL(100, w[3].ret);
+    TEST_ASSERT(s_dev_data[0][2000] == 'a' && s_dev_data[0][2149] == 'b');
+    TEST_ASSERT(s_dev_data[0][2150] == 0);
+    TEST_ASSERT(s_dev_data[0][2200] == 'c' && s_dev_data[0][2399] == 'd');
+
+    dev_reset();
+    TEST_XF_OK(xf_vfs_merge_set("/dev", NULL));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(a));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 句柄模式的挂载点上 local fd 都是 0，不同文件上相邻的请求不能合并 */
+static void TEST_CASE_merge_handle_files(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/hdev", &s_hdev_ops, XF_VFS_FLAG_STATIC | XF_VFS_FLAG_HANDLE, NULL));
+    const int a = xf_vfs_open("/hdev/a", XF_VFS_O_WRONLY, 0);
+    const int b = xf_vfs_open("/hdev/b", XF_VFS_O_WRONLY, 0);
+    TEST_ASSERT(a >= 0 && b >= 0);
+
+    const xf_vfs_merge_config_t config = { .deadline_us = 60 * 1000 * 1000 };
+    TEST_XF_OK(xf_vfs_merge_set("/hdev", &config));
+    writer_t w[4] = {
+        { .fd = a, .offset = 0, .size = 100, .fill = 'a' },
+        { .fd = b, .offset = 100, .size = 100, .fill = 'b' },
+        { .fd = a, .offset = 100, .size = 100, .fill = 'c' },
+        { .fd = b, .offset = 0, .size = 100, .fill = 'd' },
+    };
+    dev_reset();
+    writers_run(w, 4, 0);
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_EQUAL(100, w[i].ret);
+    }
+    TEST_ASSERT_EQUAL(2, s_call_count);
+    TEST_ASSERT_EQUAL(200u, s_calls[0].size);
+    TEST_ASSERT_EQUAL(200u, s_calls[1].size);
+    TEST_ASSERT(s_calls[0].local_fd != s_calls[1].local_fd);
+    TEST_ASSERT(s_dev_data[0][0] == 'a' && s_dev_data[0][199] == 'c');
+    TEST_ASSERT(s_dev_data[1][0] == 'd' && s_dev_data[1][199] == 'b');
+
+    TEST_XF_OK(xf_vfs_merge_set("/hdev", NULL));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(a));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(b));
+    TEST_XF_OK(xf_vfs_unregister_fs("/hdev"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 有请求排队时关闭合并：排队的请求立即下发并得到结果，之后的请求直接下发 */
+static void TEST_CASE_merge_disable_while_queued(void)
+{
+    static const char data[100];
+    xf_vfs_merge_stats_t stats;
+    const int a = xf_vfs_open("/dev/a", XF_VFS_O_WRONLY, 0);
+    TEST_ASSERT(a >= 0);
+    const xf_vfs_merge_config_t config = { .deadline_us = 60 * 1000 * 1000 };
+    TEST_XF_OK(xf_vfs_merge_set("/dev", &config));
+    writer_t w[2] = {
+        { .fd = a, .offset = 0, .size = 100, .fill = 'a' },
+        { .fd = a, .offset = 100, .size = 100, .fill = 'b' },
+    };
+    dev_reset();
+    writers_start(w, 2, 0);
+    xf_osal_delay_ms(20);
+    TEST_XF_OK(xf_vfs_merge_set("/dev", NULL));
+    writers_wait(2);
+    TEST_ASSERT_EQUAL(100, w[0].ret);
+    TEST_ASSERT_EQUAL(100, w[1].ret);
+    TEST_ASSERT_EQUAL(1, s_call_count);
+    TEST_ASSERT_EQUAL(200u, s_calls[0].size);
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_STATE, xf_vfs_merge_get_stats("/dev", &stats, false));
+
+    dev_reset();
+    TEST_ASSERT_EQUAL(100, xf_vfs_pwrite(a, data, 100, 0));
+    TEST_ASSERT_EQUAL(1, s_call_count);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(a));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/*
+ * 基准：4 个线程交错写同一个文件（线程 t 写第 i * 4 + t 块），
+ * 设备串行编程且每次耗时固定，比较不合并与合并时的驱动调用数、耗时与增加的延迟。
+ */
+static void TEST_CASE_merge_bench(void)
+{
+    TEST_XF_OK(xf_lock_init(&s_flash_lock));
+    TEST_XF_OK(xf_vfs_register_fs("/flash", &s_flash_ops, XF_VFS_FLAG_STATIC, NULL));
+    s_bench_fd = xf_vfs_open("/flash/f", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(s_bench_fd >= 0);
+    bench_run("direct", NULL);
+
+    const xf_vfs_merge_config_t config = { .deadline_us = 1000 };
+    TEST_XF_OK(xf_vfs_merge_set("/flash", &config));
+    bench_run("merged", "/flash");
+
+    /* 每块的内容为写入它的线程号 */
+    uint8_t buf[BENCH_BS];
+    for (int i = 0; i < BENCH_THREADS * BENCH_WRITES; ++i) {
+        TEST_ASSERT_EQUAL(BENCH_BS, xf_vfs_pread(s_bench_fd, buf, BENCH_BS, (xf_vfs_off_t)i * BENCH_BS));
+        TEST_ASSERT(buf[0] == (uint8_t)(i % BENCH_THREADS) && buf[BENCH_BS - 1] == buf[0]);
+    }
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(s_bench_fd));
+    TEST_XF_OK(xf_vfs_unregister_fs("/flash"));
+    xf_lock_destroy(s_flash_lock);
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void bench_run(const char *label, const char *stats_path)
+{
+    s_flash_programs = 0;
+    static uintptr_t s_index[BENCH_THREADS];
+    const xf_osal_thread_attr_t attr = {
+        .name = "bench",
+        .stack_size = 4096,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    const uint64_t t0 = xf_sys_time_get_ns();
+    for (uintptr_t t = 0; t < BENCH_THREADS; ++t) {
+        s_index[t] = t;
+        TEST_ASSERT(xf_osal_thread_create(bench_thread, &s_index[t], &attr) != NULL);
+    }
+    for (int t = 0; t < BENCH_THREADS; ++t) {
+        xf_osal_semaphore_acquire(s_done, XF_OSAL_WAIT_FOREVER);
+    }
+    const uint64_t elapsed_us = (xf_sys_time_get_ns() - t0) / 1000;
+
+    const uint32_t requests = BENCH_THREADS * BENCH_WRITES;
+    if (stats_path == NULL) {
+        TEST_ASSERT_EQUAL(requests, s_flash_programs);
+        xf_log_printf("[%s] %u pwrites, %u driver calls, %lu us\n",
+                      label, (unsigned)requests, (unsigned)s_flash_programs, (unsigned long)elapsed_us);
+        return;
+    }
+    xf_vfs_merge_stats_t st;
+    TEST_XF_OK(xf_vfs_merge_get_stats(stats_path, &st, true));
+    TEST_ASSERT_EQUAL(requests, st.requests);
+    TEST_ASSERT_EQUAL(st.driver_calls, s_flash_programs);
+    TEST_ASSERT(st.driver_calls < st.requests);
+    xf_log_printf("[%s] %u pwrites, %u driver calls (merge rate %u%%), %lu us, "
+                  "added latency avg %lu us max %lu us\n",
+                  label, (unsigned)st.requests, (unsigned)st.driver_calls,
+                  (unsigned)(100 - st.driver_calls * 100 / st.requests), (unsigned long)elapsed_us,
+                  (unsigned long)(st.wait_us / st.requests), (unsigned long)st.max_wait_us);
+}
+
+static void bench_thread(void *argument)
+{
+    const uintptr_t t = *(const uintptr_t *)argument;
+    uint8_t buf[BENCH_BS];
+    xf_memset(buf, (int)t, sizeof(buf));
+    for (uint32_t i = 0; i < BENCH_WRITES; ++i) {
+        const xf_vfs_off_t off = (xf_vfs_off_t)(i * BENCH_THREADS + t) * BENCH_BS;
+        if (xf_vfs_pwrite(s_bench_fd, buf, sizeof(buf), off) != (xf_vfs_ssize_t)sizeof(buf)) {
+            xf_log_printf("bench pwrite failed at %ld\n", (long)off);
+        }
+    }
+    xf_osal_semaphore_release(s_done);
+    xf_osal_thread_delete(NULL);
+}
+
+static void writers_run(writer_t *w, size_t n, uint32_t spacing_ms)
+{
+    writers_start(w, n, spacing_ms);
+    writers_wait(n);
+}
+
+static void writers_start(writer_t *w, size_t n, uint32_t spacing_ms)
+{
+    const xf_osal_thread_attr_t attr = {
+        .name = "writer",
+        .stack_size = 4096,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    for (size_t i = 0; i < n; ++i) {
+        TEST_ASSERT(xf_osal_thread_create(writer_thread, &w[i], &attr) != NULL);
+        if (spacing_ms != 0) {
+            xf_osal_delay_ms(spacing_ms);
+        }
+    }
+}
+
+static void writers_wait(size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        xf_osal_semaphore_acquire(s_done, XF_OSAL_WAIT_FOREVER);
+    }
+}
+
+static void writer_thread(void *argument)
+{
+    writer_t *w = argument;
+    char buf[128];
+    xf_memset(buf, w->fill, sizeof(buf));
+    errno = 0;
+    w->ret = xf_vfs_pwrite(w->fd, buf, w->size, w->offset);
+    w->err = errno;
+    xf_osal_semaphore_release(s_done);
+    xf_osal_thread_delete(NULL);
+}
+
+static void dev_reset(void)
+{
+    xf_memset(s_dev_data, 0, sizeof(s_dev_data));
+    s_call_count = 0;
+    s_fail_from = 0;
+    s_short_max = 0;
+}
+
+static int dev_open(const char *path, int flags, int mode)
+{
+    if (xf_strcmp(path, "/a") == 0) {
+        return 0;
+    }
+    if (xf_strcmp(path, "/b") == 0) {
+        return 1;
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+static int dev_close(int fd)
+{
+    return 0;
+}
+
+static xf_vfs_ssize_t dev_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    if (s_call_count < CALLS_MAX) {
+        s_calls[s_call_count] = (dev_call_t) {
+            .local_fd = fd, .offset = offset, .size = size
+        };
+    }
+    ++s_call_count;
+    if (s_fail_from != 0 && offset >= s_fail_from) {
+        errno = EIO;
+        return -1;
+    }
+    if (s_short_max != 0 && size > s_short_max) {
+        size = s_short_max;
+    }
+    if (fd < 0 || fd >= DEV_FILES || offset < 0 || (size_t)offset + size > DEV_FILE_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+    xf_memcpy(&s_dev_data[fd][offset], src, size);
+    return (xf_vfs_ssize_t)size;
+}
+
+static int flash_open(const char *path, int flags, int mode)
+{
+    return 0;
+}
+
+static xf_vfs_ssize_t flash_pread(int fd, void *dst, size_t size, xf_vfs_off_t offset)
+{
+    if (offset < 0 || (size_t)offset + size > FLASH_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+    xf_memcpy(dst, &s_flash[offset], size);
+    return (xf_vfs_ssize_t)size;
+}
+
+static xf_vfs_ssize_t flash_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    if (offset < 0 || (size_t)offset + size > FLASH_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+    xf_lock_lock(s_flash_lock);
+    xf_delay_us(FLASH_PROGRAM_US);
+    xf_memcpy(&s_flash[offset], src, size);
+    ++s_flash_programs;
+    xf_lock_unlock(s_flash_lock);
+    return (xf_vfs_ssize_t)size;
+}
+
+static void *hdev_open(void *ctx, const char *path, int flags, int mode)
+{
+    const int fd = dev_open(path, flags, mode);
+    return (fd < 0) ? NULL : s_dev_data[fd];
+}
+
+static int hdev_close(void *ctx, void *h)
+{
+    return 0;
+}
+
+static xf_vfs_ssize_t hdev_pwrite(void *ctx, void *h, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    return dev_pwrite((int)(((uint8_t *)h - s_dev_data[0]) / DEV_FILE_SIZE), src, size, offset);
+}
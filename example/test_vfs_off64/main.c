@@ -0,0 +1,396 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 64 位偏移测试：超过 4 GiB 的稀疏文件，以及 32 位驱动的回退。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define GIB             ((xf_vfs_off64_t)1 << 30)
+#define EXTENT_MAX      8
+#define EXTENT_SIZE     16
+
+/* ==================== [Typedefs] ========================================== */
+
+/* 只实现 64 位函数的稀疏文件驱动：整个文件系统只有一个文件，未写入的部分读出 0 */
+typedef struct {
+    xf_vfs_off64_t off;
+    size_t len;
+    uint8_t data[EXTENT_SIZE];
+} extent_t;
+
+typedef struct {
+    xf_vfs_off64_t size;
+    xf_vfs_off64_t pos;
+    extent_t extents[EXTENT_MAX];
+    int extent_count;
+} sparse_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int sparse_open(void *ctx, const char *path, int flags, int mode);
+static int sparse_close(void *ctx, int fd);
+static xf_vfs_off64_t sparse_lseek64(void *ctx, int fd, xf_vfs_off64_t offset, int mode);
+static xf_vfs_ssize_t sparse_pread64(void *ctx, int fd, void *dst, size_t size, xf_vfs_off64_t offset);
+static xf_vfs_ssize_t sparse_pwrite64(void *ctx, int fd, const void *src, size_t size, xf_vfs_off64_t offset);
+static int sparse_fstat64(void *ctx, int fd, xf_vfs_stat64_t *st);
+static int sparse_ftruncate64(void *ctx, int fd, xf_vfs_off64_t length);
+static void *sparse_h_open(void *ctx, const char *path, int flags, int mode);
+static int sparse_h_close(void *ctx, void *h);
+static xf_vfs_off64_t sparse_h_lseek64(void *ctx, void *h, xf_vfs_off64_t offset, int mode);
+static xf_vfs_ssize_t sparse_h_pread64(void *ctx, void *h, void *dst, size_t size, xf_vfs_off64_t offset);
+static xf_vfs_ssize_t sparse_h_pwrite64(void *ctx, void *h, const void *src, size_t size, xf_vfs_off64_t offset);
+static int sparse_h_fstat64(void *ctx, void *h, xf_vfs_stat64_t *st);
+static int sparse_h_ftruncate64(void *ctx, void *h, xf_vfs_off64_t length);
+
+static void TEST_CASE_off64_positional(void);
+static void TEST_CASE_off64_seek_and_truncate(void);
+static void TEST_CASE_off64_vfs_offset_append(void);
+static void TEST_CASE_off64_fallback_to_32bit_driver(void);
+static void TEST_CASE_off64_handle_driver(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static sparse_t s_sparse;
+
+static const xf_vfs_dir_ops_t s_sparse_dir_ops = {
+    .ftruncate64_p = sparse_ftruncate64,
+};
+
+static const xf_vfs_fs_ops_t s_sparse_ops = {
+    .open_p = sparse_open,
+    .close_p = sparse_close,
+    .lseek64_p = sparse_lseek64,
+    .pread64_p = sparse_pread64,
+    .pwrite64_p = sparse_pwrite64,
+    .fstat64_p = sparse_fstat64,
+    .dir = &s_sparse_dir_ops,
+};
+
+/* 同一个稀疏文件的句柄模式驱动，同样只实现 64 位函数 */
+static const xf_vfs_handle_ops_t s_sparse_handle_ops = {
+    .open = sparse_h_open,
+    .close = sparse_h_close,
+    .lseek64 = sparse_h_lseek64,
+    .pread64 = sparse_h_pread64,
+    .pwrite64 = sparse_h_pwrite64,
+    .fstat64 = sparse_h_fstat64,
+    .ftruncate64 = sparse_h_ftruncate64,
+};
+
+static const xf_vfs_fs_ops_t s_sparse_h_ops = {
+    .handle = &s_sparse_handle_ops,
+};
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* xf_vfs_off_t 是否只有 32 位，此时 32 位接口遇到大文件应返回 EOVERFLOW */
+#define OFF_IS_32BIT    (sizeof(xf_vfs_off_t) < sizeof(xf_vfs_off64_t))
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/sd", &s_sparse_ops, XF_VFS_FLAG_CONTEXT_PTR | XF_VFS_FLAG_STATIC, &s_sparse));
+    TEST_CASE_off64_positional();
+    TEST_CASE_off64_seek_and_truncate();
+    TEST_XF_OK(xf_vfs_unregister_fs("/sd"));
+
+    TEST_XF_OK(xf_vfs_register_fs("/sd", &s_sparse_ops,
+                                  XF_VFS_FLAG_CONTEXT_PTR | XF_VFS_FLAG_STATIC | XF_VFS_FLAG_VFS_OFFSET, &s_sparse));
+    TEST_CASE_off64_vfs_offset_append();
+    TEST_XF_OK(xf_vfs_unregister_fs("/sd"));
+
+    TEST_CASE_off64_fallback_to_32bit_driver();
+
+    TEST_XF_OK(xf_vfs_register_fs("/sd", &s_sparse_h_ops, XF_VFS_FLAG_STATIC | XF_VFS_FLAG_HANDLE, &s_sparse));
+    TEST_CASE_off64_handle_driver();
+    TEST_XF_OK(xf_vfs_unregister_fs("/sd"));
+    return 0;
+}
+
+static void TEST_CASE_off64_positional(void)
+{
+    char buf[8] = {0};
+    int fd = xf_vfs_open("/sd/rec.bin", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(fd >= 0);
+
+    const xf_vfs_off64_t off = 5 * GIB + 3;
+    TEST_ASSERT_EQUAL(4, xf_vfs_pwrite64(fd, "tail", 4, off));
+    TEST_ASSERT_EQUAL(4, xf_vfs_pread64(fd, buf, 4, off));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "tail"));
+    TEST_ASSERT_EQUAL(2, xf_vfs_pread64(fd, buf, sizeof(buf), off + 2));
+
+    xf_vfs_stat64_t st64;
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstat64(fd, &st64));
+    TEST_ASSERT(st64.st_size == off + 4);
+
+    /* 32 位接口是包装：小偏移照常工作，文件过大时报告 EOVERFLOW */
+    TEST_ASSERT_EQUAL(2, xf_vfs_pwrite(fd, "hd", 2, 0));
+    TEST_ASSERT_EQUAL(2, xf_vfs_pread(fd, buf, 2, 0));
+    xf_vfs_stat_t st;
+    if (OFF_IS_32BIT) {
+        TEST_ASSERT(xf_vfs_fstat(fd, &st) < 0);
+        TEST_ASSERT_EQUAL(EOVERFLOW, errno);
+    } else {
+        TEST_ASSERT_EQUAL(0, xf_vfs_fstat(fd, &st));
+        TEST_ASSERT(st.st_size == st64.st_size);
+    }
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_off64_seek_and_truncate(void)
+{
+    int fd = xf_vfs_open("/sd/rec.bin", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(fd >= 0);
+
+    TEST_ASSERT(xf_vfs_lseek64(fd, 0, XF_VFS_SEEK_END) == s_sparse.size);
+    if (OFF_IS_32BIT) {
+        TEST_ASSERT(xf_vfs_lseek(fd, 0, XF_VFS_SEEK_CUR) < 0);
+        TEST_ASSERT_EQUAL(EOVERFLOW, errno);
+    }
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_ftruncate64(fd, 3 * GIB));
+    xf_vfs_stat64_t st64;
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstat64(fd, &st64));
+    TEST_ASSERT(st64.st_size == 3 * GIB);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_off64_vfs_offset_append(void)
+{
+    char buf[8] = {0};
+    int fd = xf_vfs_open("/sd/rec.bin", XF_VFS_O_WRONLY | XF_VFS_O_APPEND, 0);
+    TEST_ASSERT(fd >= 0);
+
+    /* 超过 2 GiB 的文件仍可直接追加，不必分段 */
+    TEST_ASSERT_EQUAL(3, xf_vfs_write(fd, "abc", 3));
+    TEST_ASSERT_EQUAL(3, xf_vfs_write(fd, "def", 3));
+    TEST_ASSERT(xf_vfs_lseek64(fd, 0, XF_VFS_SEEK_CUR) == 3 * GIB + 6);
+    TEST_ASSERT_EQUAL(6, xf_vfs_pread64(fd, buf, 6, 3 * GIB));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "abcdef"));
+
+    TEST_ASSERT(xf_vfs_lseek64(fd, -1, XF_VFS_SEEK_END) == 3 * GIB + 5);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_off64_fallback_to_32bit_driver(void)
+{
+    char buf[8] = {0};
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+    int fd = xf_vfs_open("/ram/a", XF_VFS_O_RDWR | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+
+    /* 只实现 32 位函数的驱动通过 64 位接口访问 */
+    TEST_ASSERT_EQUAL(5, xf_vfs_pwrite64(fd, "hello", 5, 0));
+    TEST_ASSERT_EQUAL(3, xf_vfs_pread64(fd, buf, 3, 2));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "llo"));
+    TEST_ASSERT(xf_vfs_lseek64(fd, 1, XF_VFS_SEEK_SET) == 1);
+    xf_vfs_stat64_t st64;
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstat64(fd, &st64));
+    TEST_ASSERT(st64.st_size == 5);
+    TEST_ASSERT_EQUAL(0, xf_vfs_ftruncate64(fd, 2));
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstat64(fd, &st64));
+    TEST_ASSERT(st64.st_size == 2);
+
+    if (OFF_IS_32BIT) {
+        TEST_ASSERT(xf_vfs_pread64(fd, buf, 1, 4 * GIB) < 0);
+        TEST_ASSERT_EQUAL(EOVERFLOW, errno);
+    }
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_off64_handle_driver(void)
+{
+    char buf[8] = {0};
+    int fd = xf_vfs_open("/sd/rec.bin", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(fd >= 0);
+
+    /* 句柄模式驱动的 64 位函数同样被直接调用 */
+    const xf_vfs_off64_t off = 6 * GIB + 1;
+    TEST_ASSERT_EQUAL(3, xf_vfs_pwrite64(fd, "hnd", 3, off));
+    TEST_ASSERT_EQUAL(3, xf_vfs_pread64(fd, buf, 3, off));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "hnd"));
+    TEST_ASSERT(xf_vfs_lseek64(fd, 0, XF_VFS_SEEK_END) == off + 3);
+
+    xf_vfs_stat64_t st64;
+    TEST_ASSERT_EQUAL(0, xf_vfs_ftruncate64(fd, 4 * GIB));
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstat64(fd, &st64));
+    TEST_ASSERT(st64.st_size == 4 * GIB);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static int sparse_open(void *ctx, const char *path, int flags, int mode)
+{
+    sparse_t *sp = (sparse_t *)ctx;
+    if (xf_strcmp(path, "/rec.bin") != 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    sp->pos = 0;
+    return 0;
+}
+
+static int sparse_close(void *ctx, int fd)
+{
+    return 0;
+}
+
+static xf_vfs_off64_t sparse_lseek64(void *ctx, int fd, xf_vfs_off64_t offset, int mode)
+{
+    sparse_t *sp = (sparse_t *)ctx;
+    xf_vfs_off64_t base = (mode == XF_VFS_SEEK_END) ? sp->size : ((mode == XF_VFS_SEEK_CUR) ? sp->pos : 0);
+    if (base + offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    sp->pos = base + offset;
+    return sp->pos;
+}
+
+static xf_vfs_ssize_t sparse_pread64(void *ctx, int fd, void *dst, size_t size, xf_vfs_off64_t offset)
+{
+    sparse_t *sp = (sparse_t *)ctx;
+    if (offset >= sp->size) {
+        return 0;
+    }
+    if (offset + (xf_vfs_off64_t)size > sp->size) {
+        size = (size_t)(sp->size - offset);
+    }
+    uint8_t *out = (uint8_t *)dst;
+    xf_memset(out, 0, size);
+    for (int i = 0; i < sp->extent_count; ++i) {
+        const extent_t *e = &sp->extents[i];
+        for (size_t j = 0; j < e->len; ++j) {
+            const xf_vfs_off64_t at = e->off + (xf_vfs_off64_t)j;
+            if (at >= offset && at < offset + (xf_vfs_off64_t)size && at < sp->size) {
+                out[at - offset] = e->data[j];
+            }
+        }
+    }
+    return size;
+}
+
+static xf_vfs_ssize_t sparse_pwrite64(void *ctx, int fd, const void *src, size_t size, xf_vfs_off64_t offset)
+{
+    sparse_t *sp = (sparse_t *)ctx;
+    if (size > EXTENT_SIZE || sp->extent_count == EXTENT_MAX) {
+        errno = ENOSPC;
+        return -1;
+    }
+    extent_t *e = &sp->extents[sp->extent_count++];
+    e->off = offset;
+    e->len = size;
+    xf_memcpy(e->data, src, size);
+    if (offset + (xf_vfs_off64_t)size > sp->size) {
+        sp->size = offset + size;
+    }
+    return size;
+}
+
+static int sparse_fstat64(void *ctx, int fd, xf_vfs_stat64_t *st)
+{
+    sparse_t *sp = (sparse_t *)ctx;
+    xf_memset(st, 0, sizeof(*st));
+    st->st_mode = XF_VFS_S_IFREG;
+    st->st_size = sp->size;
+    return 0;
+}
+
+static int sparse_ftruncate64(void *ctx, int fd, xf_vfs_off64_t length)
+{
+    sparse_t *sp = (sparse_t *)ctx;
+    sp->size = length;
+    return 0;
+}
+
+static void *sparse_h_open(void *ctx, const char *path, int flags, int mode)
+{
+    return (sparse_open(ctx, path, flags, mode) < 0) ? NULL : ctx;
+}
+
+static int sparse_h_close(void *ctx, void *h)
+{
+    return 0;
+}
+
+static xf_vfs_off64_t sparse_h_lseek64(void *ctx, void *h, xf_vfs_off64_t offset, int mode)
+{
+    return sparse_lseek64(h, 0, offset, mode);
+}
+
+static xf_vfs_ssize_t sparse_h_pread64(void *ctx, void *h, void *dst, size_t size, xf_vfs_off64_t offset)
+{
+    return sparse_pread64(h, 0, dst, size, offset);
+}
+
+static xf_vfs_ssize_t sparse_h_pwrite64(void *ctx, void *h, const void *src, size_t size, xf_vfs_off64_t offset)
+{
+    return sparse_pwrite64(h, 0, src, size, offset);
+}
+
+static int sparse_h_fstat64(void *ctx, void *h, xf_vfs_stat64_t *st)
+{
+    return sparse_fstat64(h, 0, st);
+}
+
+static int sparse_h_ftruncate64(void *ctx, void *h, xf_vfs_off64_t length)
+{
+    return sparse_ftruncate64(h, 0, length);
+}
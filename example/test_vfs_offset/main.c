@@ -0,0 +1,282 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief XF_VFS_FLAG_VFS_OFFSET 测试：驱动只实现 pread/pwrite.
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_osal.h"
+#include "xf_vfs.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void TEST_CASE_offset_read_write_lseek(void);
+static void TEST_CASE_offset_shared_by_dup(void);
+static void TEST_CASE_offset_append(void);
+static void TEST_CASE_offset_append_two_opens(void);
+static void TEST_CASE_offset_append_other_file(void);
+static xf_vfs_ssize_t gated_pwrite(void *ctx, int fd, const void *src, size_t size, xf_vfs_off_t offset);
+static void appender(void *argument);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static ramfs_t *s_fs;
+static const xf_vfs_fs_ops_t *s_ram;
+/* 置位后下一次 pwrite 通知 s_entered 并等待 s_resume */
+static volatile bool s_gate_armed;
+static xf_osal_semaphore_t s_entered;
+static xf_osal_semaphore_t s_resume;
+static xf_osal_semaphore_t s_done;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    /* 去掉 read/write/lseek 的 ramfs，只保留位置 I/O */
+    const xf_vfs_fs_ops_t *ram = ramfs_get_ops();
+    s_ram = ram;
+    xf_vfs_fs_ops_t ops = {
+        .pread_p = ram->pread_p,
+        .pwrite_p = gated_pwrite,
+        .open_p = ram->open_p,
+        .close_p = ram->close_p,
+        .fstat_p = ram->fstat_p,
+        .dir = ram->dir,
+    };
+    s_fs = xf_malloc(sizeof(ramfs_t));
+    TEST_ASSERT(s_fs != NULL);
+    xf_memset(s_fs, 0, sizeof(ramfs_t));
+    TEST_XF_OK(xf_vfs_register_fs("/ram", &ops, XF_VFS_FLAG_CONTEXT_PTR | XF_VFS_FLAG_VFS_OFFSET, s_fs));
+
+    TEST_CASE_offset_read_write_lseek();
+    TEST_CASE_offset_shared_by_dup();
+    TEST_CASE_offset_append();
+    TEST_CASE_offset_append_two_opens();
+    TEST_CASE_offset_append_other_file();
+
+    TEST_XF_OK(xf_vfs_unregister_fs("/ram"));
+    for (int i = 0; i < RAMFS_NODES_MAX; ++i) {
+        xf_free(s_fs->nodes[i].data);
+    }
+    xf_free(s_fs);
+    return 0;
+}
+
+static void TEST_CASE_offset_read_write_lseek(void)
+{
+    char buf[16] = {0};
+    int fd = xf_vfs_open("/ram/a", XF_VFS_O_RDWR | XF_VFS_O_CREAT | XF_VFS_O_TRUNC, 0666);
+    TEST_ASSERT(fd >= 0);
+
+    TEST_ASSERT_EQUAL(5, xf_vfs_write(fd, "hello", 5));
+    TEST_ASSERT_EQUAL(6, xf_vfs_write(fd, " world", 6));
+    TEST_ASSERT_EQUAL(11, xf_vfs_lseek(fd, 0, XF_VFS_SEEK_CUR));
+    TEST_ASSERT_EQUAL(0, xf_vfs_read(fd, buf, sizeof(buf)));
+
+    TEST_ASSERT_EQUAL(6, xf_vfs_lseek(fd, 6, XF_VFS_SEEK_SET));
+    TEST_ASSERT_EQUAL(5, xf_vfs_read(fd, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "world"));
+
+    TEST_ASSERT_EQUAL(8, xf_vfs_lseek(fd, -3, XF_VFS_SEEK_END));
+    TEST_ASSERT_EQUAL(1, xf_vfs_write(fd, "L", 1));
+    TEST_ASSERT_EQUAL(4, xf_vfs_lseek(fd, -5, XF_VFS_SEEK_CUR));
+    xf_memset(buf, 0, sizeof(buf));
+    TEST_ASSERT_EQUAL(7, xf_vfs_read(fd, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "o woLld"));
+
+    TEST_ASSERT(xf_vfs_lseek(fd, -1, XF_VFS_SEEK_SET) < 0);
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_offset_shared_by_dup(void)
+{
+    char buf[4] = {0};
+    int fd = xf_vfs_open("/ram/a", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    int fd2 = xf_vfs_dup(fd);
+    TEST_ASSERT(fd2 >= 0);
+    TEST_ASSERT_EQUAL(2, xf_vfs_read(fd, buf, 2));
+    TEST_ASSERT_EQUAL(2, xf_vfs_read(fd2, buf, 2));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "ll"));
+    TEST_ASSERT_EQUAL(4, xf_vfs_lseek(fd, 0, XF_VFS_SEEK_CUR));
+
+    /* 另一次 open 拥有独立的偏移 */
+    int fd3 = xf_vfs_open("/ram/a", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(fd3 >= 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_lseek(fd3, 0, XF_VFS_SEEK_CUR));
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd2));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd3));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_offset_append(void)
+{
+    char buf[24] = {0};
+    int fd = xf_vfs_open("/ram/a", XF_VFS_O_RDWR | XF_VFS_O_APPEND, 0);
+    TEST_ASSERT(fd >= 0);
+
+    /* O_APPEND 总是写到文件末尾，与当前偏移无关 */
+    TEST_ASSERT_EQUAL(0, xf_vfs_lseek(fd, 0, XF_VFS_SEEK_SET));
+    TEST_ASSERT_EQUAL(1, xf_vfs_write(fd, "!", 1));
+    TEST_ASSERT_EQUAL(12, xf_vfs_lseek(fd, 0, XF_VFS_SEEK_CUR));
+    TEST_ASSERT_EQUAL(0, xf_vfs_lseek(fd, 0, XF_VFS_SEEK_SET));
+    TEST_ASSERT_EQUAL(1, xf_vfs_write(fd, "?", 1));
+    TEST_ASSERT_EQUAL(13, xf_vfs_pread(fd, buf, sizeof(buf), 0));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "hello woLld!?"));
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_ftruncate(fd, 5));
+    TEST_ASSERT_EQUAL(1, xf_vfs_write(fd, ".", 1));
+    xf_memset(buf, 0, sizeof(buf));
+    TEST_ASSERT_EQUAL(6, xf_vfs_pread(fd, buf, sizeof(buf), 0));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "hello."));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_offset_append_two_opens(void)
+{
+    char buf[16] = {0};
+    int fd = xf_vfs_open("/ram/b", XF_VFS_O_WRONLY | XF_VFS_O_CREAT | XF_VFS_O_TRUNC | XF_VFS_O_APPEND, 0666);
+    TEST_ASSERT(fd >= 0);
+    int fd2 = xf_vfs_open("/ram/b", XF_VFS_O_WRONLY | XF_VFS_O_APPEND, 0);
+    TEST_ASSERT(fd2 >= 0);
+    /* openat 打开同一文件时使用与 open 相同的追加写锁 */
+    xf_vfs_dirat_t *dir = xf_vfs_dirat_open("/ram");
+    TEST_ASSERT(dir != NULL);
+    int fd3 = xf_vfs_openat(dir, "b", XF_VFS_O_WRONLY | XF_VFS_O_APPEND, 0);
+    TEST_ASSERT(fd3 >= 0);
+
+    /* 各次 open 的追加写都落在对方写入之后 */
+    TEST_ASSERT_EQUAL(3, xf_vfs_write(fd, "abc", 3));
+    TEST_ASSERT_EQUAL(2, xf_vfs_write(fd2, "de", 2));
+    TEST_ASSERT_EQUAL(1, xf_vfs_write(fd, "f", 1));
+    TEST_ASSERT_EQUAL(1, xf_vfs_write(fd3, "g", 1));
+    TEST_ASSERT_EQUAL(6, xf_vfs_lseek(fd, 0, XF_VFS_SEEK_CUR));
+    TEST_ASSERT_EQUAL(5, xf_vfs_lseek(fd2, 0, XF_VFS_SEEK_CUR));
+    TEST_ASSERT_EQUAL(7, xf_vfs_lseek(fd3, 0, XF_VFS_SEEK_CUR));
+
+    int rd = xf_vfs_open("/ram/b", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(rd >= 0);
+    TEST_ASSERT_EQUAL(7, xf_vfs_read(rd, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "abcdefg"));
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd2));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd3));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(rd));
+    TEST_ASSERT_EQUAL(0, xf_vfs_dirat_close(dir));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 一个文件的追加写停在驱动里时，另一个文件的追加写不等待它 */
+static void TEST_CASE_offset_append_other_file(void)
+{
+    s_entered = xf_osal_semaphore_create(1, 0, NULL);
+    s_resume = xf_osal_semaphore_create(1, 0, NULL);
+    s_done = xf_osal_semaphore_create(1, 0, NULL);
+    TEST_ASSERT(s_entered != NULL && s_resume != NULL && s_done != NULL);
+
+    int slow = xf_vfs_open("/ram/slow", XF_VFS_O_WRONLY | XF_VFS_O_CREAT | XF_VFS_O_TRUNC | XF_VFS_O_APPEND, 0666);
+    TEST_ASSERT(slow >= 0);
+    int fd = xf_vfs_open("/ram/c", XF_VFS_O_WRONLY | XF_VFS_O_CREAT | XF_VFS_O_TRUNC | XF_VFS_O_APPEND, 0666);
+    TEST_ASSERT(fd >= 0);
+
+    const xf_osal_thread_attr_t attr = {
+        .name = "append",
+        .stack_size = 4096,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    s_gate_armed = true;
+    TEST_ASSERT(xf_osal_thread_create(appender, (void *)(intptr_t)slow, &attr) != NULL);
+    xf_osal_semaphore_acquire(s_entered, XF_OSAL_WAIT_FOREVER);
+
+    /* /ram/slow 的追加写正持有它的锁 */
+    TEST_ASSERT_EQUAL(3, xf_vfs_write(fd, "xyz", 3));
+    TEST_ASSERT_EQUAL(3, xf_vfs_lseek(fd, 0, XF_VFS_SEEK_CUR));
+
+    xf_osal_semaphore_release(s_resume);
+    xf_osal_semaphore_acquire(s_done, XF_OSAL_WAIT_FOREVER);
+    TEST_ASSERT_EQUAL(4, xf_vfs_lseek(slow, 0, XF_VFS_SEEK_CUR));
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(slow));
+    xf_osal_semaphore_delete(s_entered);
+    xf_osal_semaphore_delete(s_resume);
+    xf_osal_semaphore_delete(s_done);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void appender(void *argument)
+{
+    const int fd = (int)(intptr_t)argument;
+    TEST_ASSERT_EQUAL(4, xf_vfs_write(fd, "slow", 4));
+    xf_osal_semaphore_release(s_done);
+    xf_osal_thread_delete(NULL);
+}
+
+static xf_vfs_ssize_t gated_pwrite(void *ctx, int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    if (s_gate_armed) {
+        s_gate_armed = false;
+        xf_osal_semaphore_release(s_entered);
+        xf_osal_semaphore_acquire(s_resume, XF_OSAL_WAIT_FOREVER);
+    }
+    return s_ram->pwrite_p(ctx, fd, src, size, offset);
+}
@@ -0,0 +1,352 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief overlay 文件系统测试。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_osal.h"
+#include "xf_vfs.h"
+#include "xf_vfs_fault.h"
+#include "xf_vfs_overlay.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void write_file(const char *path, const char *content);
+static void check_file(const char *path, const char *content, int line);
+static int count_entries(const char *path, const char *name);
+
+static void TEST_CASE_overlay_reads_lower_with_one_call(void);
+static void TEST_CASE_overlay_copies_up_on_first_write(void);
+static void TEST_CASE_overlay_whiteout_hides_lower(void);
+static void TEST_CASE_overlay_merges_readdir(void);
+static void TEST_CASE_overlay_copy_up_keeps_busy_lower_fd(void);
+static void slow_pread_thread(void *argument);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static ramfs_t *s_lower;
+static ramfs_t *s_upper;
+static xf_osal_semaphore_t s_done;
+static char s_slow_buf[16];
+static xf_vfs_ssize_t s_slow_ret;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define test_file_is(path, content) check_file(path, content, __LINE__)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    TEST_XF_OK(ramfs_mount("/lo", &s_lower));
+    TEST_XF_OK(ramfs_mount("/up", &s_upper));
+
+    /* 出厂默认内容 */
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/lo/etc", 0777));
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/lo/etc/sub", 0777));
+    write_file("/lo/etc/a.conf", "lower-a");
+    write_file("/lo/etc/b.conf", "lower-b");
+    write_file("/lo/etc/sub/c.conf", "lower-c");
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/up/etc", 0777));
+
+    TEST_XF_OK(xf_vfs_overlay_register("/ov", "/lo/etc", "/up/etc"));
+
+    TEST_CASE_overlay_reads_lower_with_one_call();
+    TEST_CASE_overlay_copies_up_on_first_write();
+    TEST_CASE_overlay_whiteout_hides_lower();
+    TEST_CASE_overlay_merges_readdir();
+
+    /* 重新注册后，上层索引应能从上层内容重建 */
+    TEST_XF_OK(xf_vfs_overlay_unregister("/ov"));
+    TEST_XF_OK(xf_vfs_overlay_register("/ov", "/lo/etc", "/up/etc"));
+    test_file_is("/ov/a.conf", "upper-a");
+    TEST_ASSERT(xf_vfs_access("/ov/b.conf", XF_VFS_F_OK) < 0);
+    TEST_ASSERT_EQUAL(0, count_entries("/ov", "b.conf"));
+    TEST_XF_OK(xf_vfs_overlay_unregister("/ov"));
+
+    TEST_CASE_overlay_copy_up_keeps_busy_lower_fd();
+
+    TEST_XF_OK(ramfs_unmount("/up", s_upper));
+    TEST_XF_OK(ramfs_unmount("/lo", s_lower));
+    return 0;
+}
+
+static void write_file(const char *path, const char *content)
+{
+    int fd = xf_vfs_open(path, XF_VFS_O_WRONLY | XF_VFS_O_CREAT | XF_VFS_O_TRUNC, 0666);
+    TEST_ASSERT(fd >= 0);
+    size_t len = xf_strlen(content);
+    TEST_ASSERT_EQUAL((xf_vfs_ssize_t)len, xf_vfs_write(fd, content, len));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+}
+
+static void check_file(const char *path, const char *content, int line)
+{
+    char buf[64] = {0};
+    int fd = xf_vfs_open(path, XF_VFS_O_RDONLY, 0);
+    xf_vfs_ssize_t n = (fd >= 0) ? xf_vfs_read(fd, buf, sizeof(buf) - 1) : -1;
+    if (fd < 0 || n != (xf_vfs_ssize_t)xf_strlen(content) || xf_strcmp(buf, content) != 0) {
+        xf_log_printf("Test failed at line %d: %s is \"%s\"\n", line, path, buf);
+        while (1);
+    }
+    xf_vfs_close(fd);
+}
+
+/* 返回目录中名为 name 的条目数，name 为 NULL 时返回条目总数 */
+static int count_entries(const char *path, const char *name)
+{
+    int count = 0;
+    xf_vfs_dir_t *dir = xf_vfs_opendir(path);
+    TEST_ASSERT(dir != NULL);
+    xf_vfs_dirent_t *ent;
+    while ((ent = xf_vfs_readdir(dir)) != NULL) {
+        TEST_ASSERT(xf_strncmp(ent->d_name, XF_VFS_OVERLAY_WHITEOUT_PREFIX,
+                               sizeof(XF_VFS_OVERLAY_WHITEOUT_PREFIX) - 1) != 0);
+        if (name == NULL || xf_strcmp(ent->d_name, name) == 0) {
+            ++count;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, xf_vfs_closedir(dir));
+    return count;
+}
+
+static void TEST_CASE_overlay_reads_lower_with_one_call(void)
+{
+    char buf[16] = {0};
+    uint32_t lower_calls = s_lower->calls;
+    uint32_t upper_calls = s_upper->calls;
+
+    int fd = xf_vfs_open("/ov/a.conf", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    /* 未修改过的文件：打开只访问下层一次，不访问上层 */
+    TEST_ASSERT_EQUAL(lower_calls + 1, s_lower->calls);
+    TEST_ASSERT_EQUAL(upper_calls, s_upper->calls);
+
+    TEST_ASSERT_EQUAL(7, xf_vfs_read(fd, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "lower-a"));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(upper_calls, s_upper->calls);
+
+    TEST_ASSERT(xf_vfs_open("/ov/missing", XF_VFS_O_RDONLY, 0) < 0);
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+    TEST_ASSERT_EQUAL(upper_calls, s_upper->calls);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_overlay_copies_up_on_first_write(void)
+{
+    char buf[16] = {0};
+    uint32_t upper_calls = s_upper->calls;
+
+    int fd = xf_vfs_open("/ov/a.conf", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(fd >= 0);
+    /* 只打开不写入，不会复制 */
+    TEST_ASSERT_EQUAL(upper_calls, s_upper->calls);
+    TEST_ASSERT_EQUAL(6, xf_vfs_read(fd, buf, 6));
+    TEST_ASSERT_EQUAL(0, xf_strcmp(buf, "lower-"));
+
+    /* 首次写入触发 copy-up，并保持当前偏移 */
+    TEST_ASSERT_EQUAL(1, xf_vfs_write(fd, "A", 1));
+    TEST_ASSERT(s_upper->calls != upper_calls);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    test_file_is("/ov/a.conf", "lower-A");
+    test_file_is("/up/etc/a.conf", "lower-A");
+    test_file_is("/lo/etc/a.conf", "lower-a");
+
+    /* O_TRUNC 直接在上层创建，不复制旧内容 */
+    write_file("/ov/a.conf", "upper-a");
+    test_file_is("/ov/a.conf", "upper-a");
+    test_file_is("/lo/etc/a.conf", "lower-a");
+
+    /* 子目录中的文件，上层父目录按需创建 */
+    write_file("/ov/sub/c.conf", "upper-c");
+    test_file_is("/up/etc/sub/c.conf", "upper-c");
+    test_file_is("/lo/etc/sub/c.conf", "lower-c");
+
+    /* 新文件 */
+    write_file("/ov/new.conf", "new");
+    test_file_is("/up/etc/new.conf", "new");
+    TEST_ASSERT(xf_vfs_access("/lo/etc/new.conf", XF_VFS_F_OK) < 0);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/*
+ * 经 dup 的 fd 写入触发 copy-up 时，另一个线程仍在下层 fd 上 pread：
+ * 下层 fd 要等 pread 返回后才关闭，否则其全局 fd 可能被无关的 open 重用而读到别的文件。
+ */
+static void TEST_CASE_overlay_copy_up_keeps_busy_lower_fd(void)
+{
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/lo/busy", 0777));
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/up/busy", 0777));
+    write_file("/lo/busy/x.conf", "lower-x");
+    write_file("/lo/busy/y.conf", "other-y");
+    /* 下层经 fault 驱动访问，使 pread 足够慢 */
+    TEST_XF_OK(xf_vfs_fault_register("/lf", "/lo", 1));
+    TEST_XF_OK(xf_vfs_overlay_register("/ovb", "/lf/busy", "/up/busy"));
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "done",
+    };
+    s_done = xf_osal_semaphore_create(1, 0, &sem_attr);
+    TEST_ASSERT(s_done != NULL);
+
+    const int fd = xf_vfs_open("/ovb/x.conf", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(fd >= 0);
+    const int fd2 = xf_vfs_dup(fd);
+    TEST_ASSERT(fd2 >= 0);
+    const xf_vfs_fault_rule_t slow = {
+        .dist = XF_VFS_FAULT_DIST_FIXED,
+        .lat_us = 100 * 1000,
+    };
+    TEST_XF_OK(xf_vfs_fault_set_rule("/lf", XF_VFS_TRACE_OP_PREAD, &slow));
+
+    const xf_osal_thread_attr_t attr = {
+        .name = "pread",
+        .stack_size = 4096,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    TEST_ASSERT(xf_osal_thread_create(slow_pread_thread, (void *)(intptr_t)fd, &attr) != NULL);
+    xf_delay_ms(20);
+    TEST_ASSERT_EQUAL(1, xf_vfs_pwrite(fd2, "X", 1, 6));
+    /* 若下层 fd 已被关闭，此处会重用它 */
+    const int other = xf_vfs_open("/lf/busy/y.conf", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(other >= 0);
+    xf_osal_semaphore_acquire(s_done, XF_OSAL_WAIT_FOREVER);
+    TEST_ASSERT_EQUAL(7, s_slow_ret);
+    TEST_ASSERT_EQUAL(0, xf_strncmp(s_slow_buf, "lower-x", 7));
+
+    TEST_XF_OK(xf_vfs_fault_set_rule("/lf", XF_VFS_FAULT_OP_ALL, NULL));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(other));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd2));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    test_file_is("/ovb/x.conf", "lower-X");
+    test_file_is("/lo/busy/x.conf", "lower-x");
+
+    xf_osal_semaphore_delete(s_done);
+    TEST_XF_OK(xf_vfs_overlay_unregister("/ovb"));
+    TEST_XF_OK(xf_vfs_fault_unregister("/lf"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void slow_pread_thread(void *argument)
+{
+    s_slow_ret = xf_vfs_pread((int)(intptr_t)argument, s_slow_buf, 7, 0);
+    xf_osal_semaphore_release(s_done);
+    xf_osal_thread_delete(NULL);
+}
+
+static void TEST_CASE_overlay_whiteout_hides_lower(void)
+{
+    xf_vfs_stat_t st;
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlink("/ov/b.conf"));
+    TEST_ASSERT(xf_vfs_stat("/ov/b.conf", &st) < 0);
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+    TEST_ASSERT(xf_vfs_open("/ov/b.conf", XF_VFS_O_RDONLY, 0) < 0);
+    test_file_is("/lo/etc/b.conf", "lower-b");
+
+    /* 在 whiteout 上重新创建 */
+    write_file("/ov/b.conf", "again");
+    test_file_is("/ov/b.conf", "again");
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlink("/ov/b.conf"));
+    TEST_ASSERT(xf_vfs_stat("/ov/b.conf", &st) < 0);
+
+    /* 目录：非空时不能删除，删除后下层子项不再出现 */
+    TEST_ASSERT(xf_vfs_rmdir("/ov/sub") < 0);
+    TEST_ASSERT_EQUAL(ENOTEMPTY, errno);
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlink("/ov/sub/c.conf"));
+    TEST_ASSERT_EQUAL(0, xf_vfs_rmdir("/ov/sub"));
+    TEST_ASSERT(xf_vfs_stat("/ov/sub", &st) < 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ov/sub", 0777));
+    TEST_ASSERT_EQUAL(0, count_entries("/ov/sub", NULL));
+    TEST_ASSERT(xf_vfs_stat("/ov/sub/c.conf", &st) < 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/lo/etc/sub/c.conf", &st));
+
+    /* 重命名下层文件 */
+    write_file("/lo/etc/d.conf", "lower-d");
+    TEST_ASSERT_EQUAL(0, xf_vfs_rename("/ov/d.conf", "/ov/e.conf"));
+    TEST_ASSERT(xf_vfs_stat("/ov/d.conf", &st) < 0);
+    test_file_is("/ov/e.conf", "lower-d");
+    test_file_is("/lo/etc/d.conf", "lower-d");
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_overlay_merges_readdir(void)
+{
+    /* 上层：a.conf new.conf sub e.conf；下层剩余可见：无 */
+    TEST_ASSERT_EQUAL(1, count_entries("/ov", "a.conf"));
+    TEST_ASSERT_EQUAL(0, count_entries("/ov", "b.conf"));
+    TEST_ASSERT_EQUAL(1, count_entries("/ov", "sub"));
+    TEST_ASSERT_EQUAL(0, count_entries("/ov", "d.conf"));
+    TEST_ASSERT_EQUAL(4, count_entries("/ov", NULL));
+
+    /* 仅存在于下层的文件同样列出 */
+    write_file("/lo/etc/f.conf", "lower-f");
+    TEST_ASSERT_EQUAL(1, count_entries("/ov", "f.conf"));
+    TEST_ASSERT_EQUAL(5, count_entries("/ov", NULL));
+
+    /* rewinddir 后重新列出完整内容 */
+    xf_vfs_dir_t *dir = xf_vfs_opendir("/ov");
+    TEST_ASSERT(dir != NULL);
+    int n = 0;
+    while (xf_vfs_readdir(dir) != NULL) {
+        ++n;
+    }
+    xf_vfs_rewinddir(dir);
+    while (xf_vfs_readdir(dir) != NULL) {
+        --n;
+    }
+    TEST_ASSERT_EQUAL(0, n);
+    TEST_ASSERT_EQUAL(0, xf_vfs_closedir(dir));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
@@ -0,0 +1,214 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs_path_prepare() 路径句柄测试：缓存的解析结果、挂载表变化后重新解析及耗时对比。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define ITERATIONS      200000
+#define MOUNTS          6
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int null_stat(const char *path, xf_vfs_stat_t *st);
+
+static void TEST_CASE_path_prepare_basic(void);
+static void TEST_CASE_path_prepare_remount(void);
+static void TEST_CASE_path_prepare_speed(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_dir_ops_t s_null_dir_ops = {
+    .stat = null_stat,
+};
+
+static const xf_vfs_fs_ops_t s_null_ops = {
+    .dir = &s_null_dir_ops,
+};
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    TEST_CASE_path_prepare_basic();
+    TEST_CASE_path_prepare_remount();
+    TEST_CASE_path_prepare_speed();
+    return 0;
+}
+
+static void TEST_CASE_path_prepare_basic(void)
+{
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+
+    xf_vfs_path_t *file = xf_vfs_path_prepare("/ram/f");
+    xf_vfs_path_t *root = xf_vfs_path_prepare("/ram");
+    TEST_ASSERT(file != NULL && root != NULL);
+
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(-1, xf_vfs_stat_p(file, &st));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+    int fd = xf_vfs_open_p(file, XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(5, xf_vfs_write(fd, "hello", 5));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat_p(file, &st));
+    TEST_ASSERT_EQUAL(5, st.st_size);
+    xf_vfs_statx_t stx;
+    TEST_ASSERT_EQUAL(0, xf_vfs_statx_p(file, XF_VFS_STATX_SIZE, &stx));
+    TEST_ASSERT_EQUAL(5, stx.stx_size);
+
+    /* 挂载点本身对应驱动中的 "/" */
+    xf_vfs_dir_t *dir = xf_vfs_opendir_p(root);
+    TEST_ASSERT(dir != NULL);
+    xf_vfs_dirent_t *ent = xf_vfs_readdir(dir);
+    TEST_ASSERT(ent != NULL && xf_strcmp(ent->d_name, "f") == 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_closedir(dir));
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlink_p(file));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_stat("/ram/f", &st));
+
+    xf_vfs_path_release(file);
+    xf_vfs_path_release(root);
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 注册、注销挂载点后句柄按新的挂载表重新解析 */
+static void TEST_CASE_path_prepare_remount(void)
+{
+    xf_vfs_path_t *p = xf_vfs_path_prepare("/data/logs/f");
+    TEST_ASSERT(p != NULL);
+    TEST_ASSERT_EQUAL(-1, xf_vfs_open_p(p, XF_VFS_O_RDONLY, 0));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+
+    ramfs_t *data;
+    TEST_XF_OK(ramfs_mount("/data", &data));
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/data/logs", 0777));
+    int fd = xf_vfs_open_p(p, XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat_p(p, &st));
+
+    /* 更长的前缀优先 */
+    ramfs_t *logs;
+    TEST_XF_OK(ramfs_mount("/data/logs", &logs));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_stat_p(p, &st));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+    fd = xf_vfs_open_p(p, XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(3, xf_vfs_write(fd, "new", 3));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat_p(p, &st));
+    TEST_ASSERT_EQUAL(3, st.st_size);
+
+    TEST_XF_OK(ramfs_unmount("/data/logs", logs));
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat_p(p, &st));
+    TEST_ASSERT_EQUAL(0, st.st_size);
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlink_p(p));
+
+    TEST_XF_OK(ramfs_unmount("/data", data));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_stat_p(p, &st));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+    xf_vfs_path_release(p);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/*
+ * 同一路径反复 stat 的耗时，结果只打印不判定。
+ * 挂载多个前缀相近的挂载点，使查找挂载点的开销更明显。
+ */
+static void TEST_CASE_path_prepare_speed(void)
+{
+    static const char *const mounts[MOUNTS] = {
+        "/sensor", "/sensor/imu", "/sensor/gps", "/telemetry", "/telemetry/cache", "/telemetry/data",
+    };
+    const char *const path = "/telemetry/data/node/metrics/latest.bin";
+    for (int i = 0; i < MOUNTS; ++i) {
+        TEST_XF_OK(xf_vfs_register_fs(mounts[i], &s_null_ops, XF_VFS_FLAG_STATIC, NULL));
+    }
+    xf_vfs_path_t *p = xf_vfs_path_prepare(path);
+    TEST_ASSERT(p != NULL);
+    xf_vfs_stat_t st;
+
+    uint64_t start = xf_sys_time_get_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        TEST_ASSERT_EQUAL(0, xf_vfs_stat(path, &st));
+    }
+    const uint64_t ns_path = xf_sys_time_get_ns() - start;
+
+    start = xf_sys_time_get_ns();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        TEST_ASSERT_EQUAL(0, xf_vfs_stat_p(p, &st));
+    }
+    const uint64_t ns_prepared = xf_sys_time_get_ns() - start;
+
+    xf_log_printf("stat ns/op: path %u, prepared %u\n",
+                  (unsigned)(ns_path / ITERATIONS), (unsigned)(ns_prepared / ITERATIONS));
+
+    xf_vfs_path_release(p);
+    for (int i = 0; i < MOUNTS; ++i) {
+        TEST_XF_OK(xf_vfs_unregister_fs(mounts[i]));
+    }
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static int null_stat(const char *path, xf_vfs_stat_t *st)
+{
+    xf_memset(st, 0, sizeof(xf_vfs_stat_t));
+    return 0;
+}
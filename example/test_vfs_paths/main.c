@@ -13,6 +13,7 @@
 
 #include "xf_utils.h"
 #include "xf_vfs.h"
+#include "xf_vfs_private.h"
 
 /* ==================== [Defines] =========================================== */
 
@@ -43,6 +44,7 @@ static void test_vfs_register(const char *prefix, bool expect_success, int line)
 static void TEST_CASE_vfs_parses_paths_correctly(void);
 static void TEST_CASE_vfs_unregisters_correct_nested_mount_point(void);
 static void TEST_CASE_vfs_checks_mount_point_path(void);
+static void TEST_CASE_vfs_shares_identical_ops(void);
 static int test_main(void);
 
 /* ==================== [Static Variables] ================================== */
@@ -73,6 +75,14 @@ static int test_main(void);
         } \
     } while (0)
 
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
 #define TEST_ASSERT_EQUAL(expected, actual) \
     do { \
         if ((expected)!=(actual)) { \
@@ -139,6 +149,7 @@ static int test_main(void)
     TEST_CASE_vfs_parses_paths_correctly();
     TEST_CASE_vfs_unregisters_correct_nested_mount_point();
     TEST_CASE_vfs_checks_mount_point_path();
+    TEST_CASE_vfs_shares_identical_ops();
     return 0;
 }
 
@@ -326,6 +337,8 @@ static void TEST_CASE_vfs_unregisters_correct_nested_mount_point(void)
     /* repeat the above, with the reverse order of registration */
     TEST_XF_OK(xf_vfs_unregister("/foo/bar"));
     TEST_XF_OK(xf_vfs_register("/foo", &desc_foo, &inst_foo));
+    /* the longest prefix is gone, lookup must still fall back to "/foo" */
+    test_opened(&inst_foo, "/foo/bar/file");
     TEST_XF_OK(xf_vfs_register("/foo/bar", &desc_foobar, &inst_foobar));
     test_opened(&inst_foobar, "/foo/bar/file");
     test_not_called(&inst_foo, "/foo/bar/file");
@@ -366,7 +379,44 @@ static void TEST_CASE_vfs_checks_mount_point_path(void)
     test_register_fail("/aaa/");
     test_register_fail("/aaa/bbb/");
     test_register_ok("/23456789012345");
-    test_register_fail("/234567890123456");
+    test_register_ok("/234567890123456");
+    test_register_ok("/234567890123456789012345678901234567890123456789012345678901234");
+    test_register_fail("/2345678901234567890123456789012345678901234567890123456789012345");
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_vfs_shares_identical_ops(void)
+{
+    dummy_vfs_t inst_a = {
+        .match_path = "/file",
+        .called = false
+    };
+    dummy_vfs_t inst_b = inst_a;
+    xf_vfs_t desc_a = DUMMY_VFS();
+    xf_vfs_t desc_b = DUMMY_VFS();
+    xf_vfs_t desc_other = DUMMY_VFS();
+    desc_other.close_p = NULL;
+    TEST_XF_OK(xf_vfs_register("/a", &desc_a, &inst_a));
+    TEST_XF_OK(xf_vfs_register("/b", &desc_b, &inst_b));
+    TEST_XF_OK(xf_vfs_register("/c", &desc_other, &inst_b));
+
+    /* 内容相同的操作表只保存一份 */
+    const xf_vfs_fs_ops_t *ops_a = xf_vfs_get_vfs_for_path("/a/file")->vfs;
+    TEST_ASSERT(ops_a != NULL);
+    TEST_ASSERT(ops_a == xf_vfs_get_vfs_for_path("/b/file")->vfs);
+    TEST_ASSERT(ops_a != xf_vfs_get_vfs_for_path("/c/file")->vfs);
+
+    /* 注销其中一个后，另一个仍可正常使用 */
+    TEST_XF_OK(xf_vfs_unregister("/a"));
+    test_opened(&inst_b, "/b/file");
+    TEST_XF_OK(xf_vfs_register("/a", &desc_a, &inst_a));
+    TEST_ASSERT(xf_vfs_get_vfs_for_path("/a/file")->vfs == xf_vfs_get_vfs_for_path("/b/file")->vfs);
+    test_opened(&inst_a, "/a/file");
+
+    TEST_XF_OK(xf_vfs_unregister("/a"));
+    TEST_XF_OK(xf_vfs_unregister("/b"));
+    TEST_XF_OK(xf_vfs_unregister("/c"));
 
     XF_LOGI(TAG, "%s passed", __FUNCTION__);
 }
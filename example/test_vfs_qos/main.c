@@ -0,0 +1,423 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief QoS 测试：挂载点与 fd 的令牌桶限速、实时类别不等待、后台类别让位于实时类别。
+ * @version 1.0
+ * @date 2025-01-23
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_osal.h"
+#include "xf_vfs.h"
+#include "xf_vfs_qos.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define DELAYS_MAX          64
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int dev_open(const char *path, int flags, int mode);
+static int dev_close(int fd);
+static xf_vfs_ssize_t dev_read(int fd, void *dst, size_t size);
+static xf_vfs_ssize_t dev_write(int fd, const void *data, size_t size);
+static xf_vfs_ssize_t dev_pread(int fd, void *dst, size_t size, xf_vfs_off_t offset);
+static xf_vfs_ssize_t dev_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset);
+static int dev_fsync(int fd);
+
+static void delays_clear(void);
+static uint64_t delays_sum(void);
+static void realtime_reader(void *argument);
+
+static void TEST_CASE_qos_mount_limits(void);
+static void TEST_CASE_qos_fd_limits(void);
+static void TEST_CASE_qos_classes(void);
+static void TEST_CASE_qos_background_yields(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_fs_ops_t s_dev_ops = {
+    .open = dev_open,
+    .close = dev_close,
+    .read = dev_read,
+    .write = dev_write,
+    .pread = dev_pread,
+    .pwrite = dev_pwrite,
+    .fsync = dev_fsync,
+};
+
+static volatile uint64_t s_clock_ns;
+
+/* 限速的每次等待（us） */
+static uint32_t s_delays[DELAYS_MAX];
+static volatile size_t s_delay_count;
+
+/* dev_read 在 s_gate_armed 时阻塞到 s_gate_open，模拟进行中的实时读 */
+static volatile bool s_gate_armed;
+static volatile bool s_gate_open;
+static volatile bool s_in_read;
+static volatile int s_reads_done;
+static volatile int s_reads_done_at_write;
+static volatile size_t s_open_gate_after;
+static int s_reader_fd;
+static xf_osal_semaphore_t s_reader_exited;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+uint64_t test_clock_ns(void)
+{
+    return s_clock_ns;
+}
+
+void test_delay_us(uint32_t us)
+{
+    s_clock_ns += (uint64_t)us * 1000;
+    if (s_delay_count < DELAYS_MAX) {
+        s_delays[s_delay_count] = us;
+    }
+    ++s_delay_count;
+    if (s_open_gate_after != 0 && s_delay_count >= s_open_gate_after) {
+        s_gate_open = true;
+    }
+    xf_osal_thread_yield();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/dev", &s_dev_ops, XF_VFS_FLAG_STATIC, NULL));
+
+    TEST_CASE_qos_mount_limits();
+    TEST_CASE_qos_fd_limits();
+    TEST_CASE_qos_classes();
+    TEST_CASE_qos_background_yields();
+
+    TEST_XF_OK(xf_vfs_unregister_fs("/dev"));
+    return 0;
+}
+
+/* 挂载点的带宽与 IOPS 令牌桶：先用完容量，之后按速率等待 */
+static void TEST_CASE_qos_mount_limits(void)
+{
+    static const char data[4096];
+    xf_vfs_qos_stats_t stats;
+    const int fd = xf_vfs_open("/dev/a", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(fd >= 0);
+
+    /* 未设置时不限速、不统计 */
+    delays_clear();
+    for (int i = 0; i < 10; ++i) {
+        TEST_ASSERT_EQUAL((xf_vfs_ssize_t)sizeof(data), xf_vfs_write(fd, data, sizeof(data)));
+    }
+    TEST_ASSERT_EQUAL(0, s_delay_count);
+    TEST_XF_OK(xf_vfs_qos_get_stats("/dev", &stats, false));
+    TEST_ASSERT_EQUAL(0u, stats.cls[XF_VFS_QOS_CLASS_NORMAL].ops);
+
+    /* 100 KiB/s，容量 10 KiB：前 3 次不等待，令牌为 -2 KiB；之后每次 4 KiB 需要 40 ms */
+    const xf_vfs_qos_limit_t bw = { .bytes_per_sec = 100 * 1024, .bytes_burst = 10 * 1024 };
+    TEST_XF_OK(xf_vfs_qos_set_mount("/dev", XF_VFS_QOS_CLASS_DEFAULT, &bw));
+    delays_clear();
+    for (int i = 0; i < 10; ++i) {
+        TEST_ASSERT_EQUAL((xf_vfs_ssize_t)sizeof(data), xf_vfs_write(fd, data, sizeof(data)));
+    }
+    TEST_ASSERT_EQUAL(7, s_delay_count);
+    TEST_ASSERT_EQUAL(20000u, s_delays[0]);
+    for (size_t i = 1; i < s_delay_count; ++i) {
+        TEST_ASSERT_EQUAL(40000u, s_delays[i]);
+    }
+    TEST_XF_OK(xf_vfs_qos_get_stats("/dev/a", &stats, true));
+    const xf_vfs_qos_class_stats_t *st = &stats.cls[XF_VFS_QOS_CLASS_NORMAL];
+    TEST_ASSERT_EQUAL(10u, st->ops);
+    TEST_ASSERT_EQUAL(7u, st->throttled);
+    TEST_ASSERT_EQUAL(10u * 4096u, st->bytes);
+    TEST_ASSERT_EQUAL(260000u, st->wait_us);
+    TEST_ASSERT_EQUAL(40000u, st->max_wait_us);
+
+    /* 空闲后令牌补满，但不超过容量 */
+    s_clock_ns += 10ull * 1000 * 1000 * 1000;
+    delays_clear();
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_EQUAL((xf_vfs_ssize_t)sizeof(data), xf_vfs_write(fd, data, sizeof(data)));
+    }
+    TEST_ASSERT_EQUAL(1, s_delay_count);
+
+    /* 100 IOPS，容量 1：fsync 也计为一次调用，前 2 次不等待 */
+    const xf_vfs_qos_limit_t iops = { .iops = 100, .iops_burst = 1 };
+    TEST_XF_OK(xf_vfs_qos_set_mount("/dev", XF_VFS_QOS_CLASS_DEFAULT, &iops));
+    delays_clear();
+    for (int i = 0; i < 5; ++i) {
+        TEST_ASSERT_EQUAL(0, xf_vfs_fsync(fd));
+    }
+    TEST_ASSERT_EQUAL(3, s_delay_count);
+    TEST_ASSERT_EQUAL(30000u, delays_sum());
+
+    TEST_XF_OK(xf_vfs_qos_set_mount("/dev", XF_VFS_QOS_CLASS_DEFAULT, NULL));
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_qos_set_mount("/nowhere", XF_VFS_QOS_CLASS_NORMAL, NULL));
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_qos_set_mount("/dev", XF_VFS_QOS_CLASS_MAX, NULL));
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_qos_get_stats("/nowhere", &stats, false));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* fd 的单独限制只影响该 fd，槽位在 fd 关闭后归还 */
+static void TEST_CASE_qos_fd_limits(void)
+{
+    char c = 0;
+    const xf_vfs_qos_limit_t slow = { .iops = 10, .iops_burst = 1 };
+    int fds[3];
+    for (int i = 0; i < 3; ++i) {
+        fds[i] = xf_vfs_open("/dev/a", XF_VFS_O_RDWR, 0);
+        TEST_ASSERT(fds[i] >= 0);
+    }
+    TEST_XF_OK(xf_vfs_qos_set_fd(fds[0], XF_VFS_QOS_CLASS_DEFAULT, &slow));
+
+    /* 10 IOPS，容量 1：fds[0] 的第 3、4 次调用各等待 100 ms，fds[1] 不受影响 */
+    delays_clear();
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_EQUAL(1, xf_vfs_pread(fds[0], &c, 1, 0));
+        TEST_ASSERT_EQUAL(1, xf_vfs_read(fds[1], &c, 1));
+    }
+    TEST_ASSERT_EQUAL(2, s_delay_count);
+    TEST_ASSERT_EQUAL(100000u, s_delays[0]);
+    TEST_ASSERT_EQUAL(100000u, s_delays[1]);
+
+    /* XF_VFS_QOS_FD_SLOTS 为 2 */
+    TEST_XF_OK(xf_vfs_qos_set_fd(fds[1], XF_VFS_QOS_CLASS_NORMAL, &slow));
+    TEST_ASSERT_EQUAL(XF_ERR_NO_MEM, xf_vfs_qos_set_fd(fds[2], XF_VFS_QOS_CLASS_NORMAL, &slow));
+    TEST_XF_OK(xf_vfs_qos_set_fd(fds[1], XF_VFS_QOS_CLASS_NORMAL, NULL));
+    TEST_XF_OK(xf_vfs_qos_set_fd(fds[2], XF_VFS_QOS_CLASS_NORMAL, &slow));
+    TEST_ASSERT_EQUAL(XF_ERR_NO_MEM, xf_vfs_qos_set_fd(fds[1], XF_VFS_QOS_CLASS_NORMAL, &slow));
+
+    /* 关闭后设置清除，重新打开得到的同一个 fd 不再限速 */
+    const int old = fds[0];
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fds[0]));
+    TEST_XF_OK(xf_vfs_qos_set_fd(fds[1], XF_VFS_QOS_CLASS_NORMAL, &slow));
+    fds[0] = xf_vfs_open("/dev/a", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT_EQUAL(old, fds[0]);
+    delays_clear();
+    for (int i = 0; i < 3; ++i) {
+        TEST_ASSERT_EQUAL(1, xf_vfs_write(fds[0], &c, 1));
+    }
+    TEST_ASSERT_EQUAL(0, s_delay_count);
+
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_qos_set_fd(-1, XF_VFS_QOS_CLASS_NORMAL, NULL));
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_qos_set_fd(XF_VFS_FDS_MAX - 1, XF_VFS_QOS_CLASS_NORMAL, NULL));
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_qos_set_fd(fds[0], XF_VFS_QOS_CLASS_MAX, NULL));
+    for (int i = 0; i < 3; ++i) {
+        TEST_ASSERT_EQUAL(0, xf_vfs_close(fds[i]));
+    }
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 实时类别不等待，欠下的令牌由其他类别偿还；后台类别在实时调用后等待一段时间 */
+static void TEST_CASE_qos_classes(void)
+{
+    static const char data[4096];
+    xf_vfs_qos_stats_t stats;
+    const int rt = xf_vfs_open("/dev/rt", XF_VFS_O_RDWR, 0);
+    const int normal = xf_vfs_open("/dev/normal", XF_VFS_O_RDWR, 0);
+    const int bg = xf_vfs_open("/dev/bg", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(rt >= 0 && normal >= 0 && bg >= 0);
+
+    const xf_vfs_qos_limit_t bw = { .bytes_per_sec = 4096, .bytes_burst = 4096 };
+    TEST_XF_OK(xf_vfs_qos_set_mount("/dev", XF_VFS_QOS_CLASS_BACKGROUND, &bw));
+    TEST_XF_OK(xf_vfs_qos_set_fd(rt, XF_VFS_QOS_CLASS_REALTIME, NULL));
+    TEST_XF_OK(xf_vfs_qos_set_fd(normal, XF_VFS_QOS_CLASS_NORMAL, NULL));
+    TEST_XF_OK(xf_vfs_qos_get_stats("/dev", &stats, true));
+
+    delays_clear();
+    for (int i = 0; i < 3; ++i) {
+        TEST_ASSERT_EQUAL((xf_vfs_ssize_t)sizeof(data), xf_vfs_write(rt, data, sizeof(data)));
+    }
+    TEST_ASSERT_EQUAL(0, s_delay_count);
+
+    /* 令牌为 -8 KiB：普通类别等待 2 s */
+    TEST_ASSERT_EQUAL(1, xf_vfs_write(normal, data, 1));
+    TEST_ASSERT_EQUAL(1, s_delay_count);
+    TEST_ASSERT_EQUAL(2000000u, s_delays[0]);
+
+    /* 后台类别（挂载点的默认类别）：实时调用刚结束，先等待 holdoff，再等待令牌 */
+    s_clock_ns += 10ull * 1000 * 1000 * 1000;
+    TEST_ASSERT_EQUAL((xf_vfs_ssize_t)sizeof(data), xf_vfs_pwrite(rt, data, sizeof(data), 0));
+    delays_clear();
+    TEST_ASSERT_EQUAL(1, xf_vfs_write(bg, data, 1));
+    TEST_ASSERT_EQUAL(1, s_delay_count);
+    TEST_ASSERT_EQUAL((uint32_t)XF_VFS_QOS_BG_HOLDOFF_US, s_delays[0]);
+
+    /* holdoff 之后不再等待实时类别 */
+    s_clock_ns += (uint64_t)XF_VFS_QOS_BG_HOLDOFF_US * 1000;
+    delays_clear();
+    TEST_ASSERT_EQUAL(1, xf_vfs_write(bg, data, 1));
+    TEST_ASSERT_EQUAL(0, s_delay_count);
+
+    TEST_XF_OK(xf_vfs_qos_get_stats("/dev", &stats, true));
+    TEST_ASSERT_EQUAL(4u, stats.cls[XF_VFS_QOS_CLASS_REALTIME].ops);
+    TEST_ASSERT_EQUAL(0u, stats.cls[XF_VFS_QOS_CLASS_REALTIME].throttled);
+    TEST_ASSERT_EQUAL(1u, stats.cls[XF_VFS_QOS_CLASS_NORMAL].throttled);
+    TEST_ASSERT_EQUAL(2u, stats.cls[XF_VFS_QOS_CLASS_BACKGROUND].ops);
+    TEST_ASSERT_EQUAL(1u, stats.cls[XF_VFS_QOS_CLASS_BACKGROUND].throttled);
+
+    TEST_XF_OK(xf_vfs_qos_set_mount("/dev", XF_VFS_QOS_CLASS_NORMAL, NULL));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(rt));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(normal));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(bg));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 实时读进行中时，另一个线程的后台写等待其结束后才调用驱动 */
+static void TEST_CASE_qos_background_yields(void)
+{
+    static const char data[512];
+    const int rt = xf_vfs_open("/dev/rt", XF_VFS_O_RDWR, 0);
+    const int bg = xf_vfs_open("/dev/bg", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(rt >= 0 && bg >= 0);
+    TEST_XF_OK(xf_vfs_qos_set_fd(rt, XF_VFS_QOS_CLASS_REALTIME, NULL));
+    TEST_XF_OK(xf_vfs_qos_set_fd(bg, XF_VFS_QOS_CLASS_BACKGROUND, NULL));
+
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "rt",
+    };
+    s_reader_exited = xf_osal_semaphore_create(1, 0, &sem_attr);
+    TEST_ASSERT(s_reader_exited != NULL);
+    s_reader_fd = rt;
+    s_reads_done = 0;
+    s_gate_open = false;
+    s_gate_armed = true;
+    const xf_osal_thread_attr_t attr = {
+        .name = "rt",
+        .stack_size = 4096,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    TEST_ASSERT(xf_osal_thread_create(realtime_reader, NULL, &attr) != NULL);
+    while (!s_in_read) {
+        xf_osal_thread_yield();
+    }
+
+    /* 第 3 次等待后实时读结束 */
+    delays_clear();
+    s_open_gate_after = 3;
+    TEST_ASSERT_EQUAL((xf_vfs_ssize_t)sizeof(data), xf_vfs_write(bg, data, sizeof(data)));
+    TEST_ASSERT_EQUAL(1, s_reads_done_at_write);
+    TEST_ASSERT(s_delay_count >= 3);
+    for (size_t i = 0; i < 3; ++i) {
+        TEST_ASSERT_EQUAL((uint32_t)XF_VFS_QOS_POLL_US, s_delays[i]);
+    }
+    xf_osal_semaphore_acquire(s_reader_exited, XF_OSAL_WAIT_FOREVER);
+    xf_osal_semaphore_delete(s_reader_exited);
+    s_gate_armed = false;
+    s_open_gate_after = 0;
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(rt));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(bg));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void realtime_reader(void *argument)
+{
+    char buf[16];
+    (void)argument;
+    xf_vfs_read(s_reader_fd, buf, sizeof(buf));
+    xf_osal_semaphore_release(s_reader_exited);
+    xf_osal_thread_delete(NULL);
+}
+
+static int dev_open(const char *path, int flags, int mode)
+{
+    static int s_next = 0;
+    return s_next++;
+}
+
+static int dev_close(int fd)
+{
+    return 0;
+}
+
+static xf_vfs_ssize_t dev_read(int fd, void *dst, size_t size)
+{
+    if (s_gate_armed) {
+        s_in_read = true;
+        while (!s_gate_open) {
+            xf_osal_thread_yield();
+        }
+        s_in_read = false;
+        ++s_reads_done;
+    }
+    return (xf_vfs_ssize_t)size;
+}
+
+static xf_vfs_ssize_t dev_write(int fd, const void *data, size_t size)
+{
+    s_reads_done_at_write = s_reads_done;
+    return (xf_vfs_ssize_t)size;
+}
+
+static xf_vfs_ssize_t dev_pread(int fd, void *dst, size_t size, xf_vfs_off_t offset)
+{
+    return (xf_vfs_ssize_t)size;
+}
+
+static xf_vfs_ssize_t dev_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    return (xf_vfs_ssize_t)size;
+}
+
+static int dev_fsync(int fd)
+{
+    return 0;
+}
+
+static void delays_clear(void)
+{
+    s_delay_count = 0;
+}
+
+static uint64_t delays_sum(void)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < s_delay_count && i < DELAYS_MAX; ++i) {
+        sum += s_delays[i];
+    }
+    return sum;
+}
@@ -0,0 +1,646 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 一次 xf_vfs_select() 同时等待多个 socket 类 VFS（如网络协议栈与 CAN 协议栈）
+ *        以及普通 VFS 的 fd.
+ * @version 1.0
+ * @date 2025-01-27
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_osal.h"
+#include "xf_vfs.h"
+#include "xf_vfs_mem.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define SOCK_FDS            4               /* 每个 socket VFS 注册的 fd 数 */
+#define SOCK_WAITERS        4               /* 同时在 socket_select 中等待的线程数 */
+#define THREAD_SEMS         32              /* 每线程信号量表的大小 */
+#define EVENT_DELAY_MS      30              /* 其他线程产生事件的延迟 */
+#define TIMEOUT_MS          2000            /* 有事件时 select 的超时，不应到达 */
+
+/* ==================== [Typedefs] ========================================== */
+
+/* 模拟的 socket 协议栈：socket_select 在调用线程的信号量上等待，fd 使用全局编号 */
+typedef struct {
+    const char *name;
+    xf_vfs_id_t id;
+    int fds[SOCK_FDS];
+    bool ready[XF_VFS_FDS_MAX];     /*!< 可读的全局 fd */
+    void *waiters[SOCK_WAITERS];    /*!< 正在 socket_select 中等待的线程的信号量 */
+    volatile uint32_t stops;        /*!< stop_socket_select 的调用次数 */
+} sock_t;
+
+typedef struct {
+    xf_osal_thread_t thread;
+    xf_osal_semaphore_t sem;
+} thread_sem_t;
+
+/* 普通 VFS（如串口）：start_select 记下信号量，事件到来时 xf_vfs_select_triggered() */
+typedef struct {
+    bool selecting;
+    bool readable;
+    xf_fd_set *readfds;             /*!< start_select 的 readfds，end_select 时只留下就绪的 fd */
+    xf_vfs_select_sem_t sem;
+} uart_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int sock_a_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds,
+                         xf_vfs_timeval_t *timeout);
+static void sock_a_stop(void *sem);
+static int sock_b_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds,
+                         xf_vfs_timeval_t *timeout);
+static void sock_b_stop(void *sem);
+static void *sock_get_semaphore(void);
+static void *sock_get_select_semaphore(void);
+static int sock_close(int fd);
+static int sock_select(sock_t *s, int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds,
+                       xf_vfs_timeval_t *timeout);
+static int sock_poll(sock_t *s, int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds, bool update);
+static void sock_stop(sock_t *s, void *sem);
+static void sock_setup(sock_t *s, const xf_vfs_t *vfs);
+static void sock_teardown(sock_t *s);
+static void sock_receive(sock_t *s, int fd);
+static void sock_flush(sock_t *s);
+
+static int uart_open(const char *path, int flags, int mode);
+static int uart_close(int fd);
+static xf_err_t uart_start_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *exceptfds,
+                                  xf_vfs_select_sem_t sem, void **end_select_args);
+static xf_err_t uart_end_select(void *end_select_args);
+static void uart_receive(void);
+
+static void event_thread(void *argument);
+static void event_later(void (*event)(void));
+static void event_sock_b(void);
+static void event_uart(void);
+static void event_unregister_sock_b(void);
+static uint32_t heap_used(void);
+static int select_read(xf_fd_set *readfds, int nfds, uint32_t timeout_ms, uint32_t *elapsed_ms);
+static int fd_max(int a, int b);
+
+static void TEST_CASE_select_one_socket(void);
+static void TEST_CASE_select_two_sockets(void);
+static void TEST_CASE_select_two_sockets_timeout(void);
+static void TEST_CASE_select_two_sockets_and_uart(void);
+static void TEST_CASE_select_two_sockets_reuse_threads(void);
+static void TEST_CASE_select_unregister_while_waiting(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_t s_sock_a_vfs = {
+    .flags = XF_VFS_FLAG_DEFAULT,
+    .close = sock_close,
+    .socket_select = sock_a_select,
+    .stop_socket_select = sock_a_stop,
+    .get_socket_select_semaphore = sock_get_select_semaphore,
+};
+
+static const xf_vfs_t s_sock_b_vfs = {
+    .flags = XF_VFS_FLAG_DEFAULT,
+    .close = sock_close,
+    .socket_select = sock_b_select,
+    .stop_socket_select = sock_b_stop,
+    .get_socket_select_semaphore = sock_get_select_semaphore,
+};
+
+static const xf_vfs_t s_uart_vfs = {
+    .flags = XF_VFS_FLAG_DEFAULT,
+    .open = uart_open,
+    .close = uart_close,
+    .start_select = uart_start_select,
+    .end_select = uart_end_select,
+};
+
+static sock_t s_sock_a = {
+    .name = "A",
+};
+static sock_t s_sock_b = {
+    .name = "B",
+};
+static uart_t s_uart;
+static xf_lock_t s_lock;                    /* 保护两个协议栈、每线程信号量表与串口 */
+static thread_sem_t s_thread_sems[THREAD_SEMS];
+static xf_osal_semaphore_t s_event_done;
+static volatile uint32_t s_sem_gets;        /* VFS 调用 get_socket_select_semaphore 的次数 */
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "event",
+    };
+    s_event_done = xf_osal_semaphore_create(1, 0, &sem_attr);
+    TEST_ASSERT(s_event_done != NULL);
+    TEST_XF_OK(xf_lock_init(&s_lock));
+
+    /* B 先注册，占较小的 VFS ID */
+    sock_setup(&s_sock_b, &s_sock_b_vfs);
+    sock_setup(&s_sock_a, &s_sock_a_vfs);
+    TEST_XF_OK(xf_vfs_register("/uart", &s_uart_vfs, NULL));
+
+    TEST_CASE_select_one_socket();
+    TEST_CASE_select_two_sockets();
+    TEST_CASE_select_two_sockets_timeout();
+    TEST_CASE_select_two_sockets_and_uart();
+    TEST_CASE_select_two_sockets_reuse_threads();
+    TEST_CASE_select_unregister_while_waiting();
+
+    TEST_XF_OK(xf_vfs_unregister("/uart"));
+    sock_teardown(&s_sock_a);
+    sock_teardown(&s_sock_b);
+    xf_lock_destroy(s_lock);
+    xf_osal_semaphore_delete(s_event_done);
+    return 0;
+}
+
+/*
+ * 只有一个 socket VFS 时 socket_select 仍在调用线程中运行；
+ * 串口触发时停止的是正在等待的 A，而不是先注册的 B.
+ */
+static void TEST_CASE_select_one_socket(void)
+{
+    const int uart_fd = xf_vfs_open("/uart/0", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(uart_fd >= 0);
+    const int nfds = fd_max(uart_fd, s_sock_a.fds[SOCK_FDS - 1]) + 1;
+    xf_fd_set readfds;
+    uint32_t elapsed_ms;
+
+    sock_receive(&s_sock_a, s_sock_a.fds[1]);
+    XF_FD_ZERO(&readfds);
+    XF_FD_SET(s_sock_a.fds[1], &readfds);
+    XF_FD_SET(uart_fd, &readfds);
+    TEST_ASSERT_EQUAL(1, select_read(&readfds, nfds, TIMEOUT_MS, &elapsed_ms));
+    TEST_ASSERT(XF_FD_ISSET(s_sock_a.fds[1], &readfds));
+    TEST_ASSERT(!XF_FD_ISSET(uart_fd, &readfds));
+    sock_flush(&s_sock_a);
+
+    s_sock_a.stops = 0;
+    s_sock_b.stops = 0;
+    event_later(event_uart);
+    XF_FD_ZERO(&readfds);
+    XF_FD_SET(s_sock_a.fds[1], &readfds);
+    XF_FD_SET(uart_fd, &readfds);
+    TEST_ASSERT_EQUAL(1, select_read(&readfds, nfds, TIMEOUT_MS, &elapsed_ms));
+    xf_osal_semaphore_acquire(s_event_done, XF_OSAL_WAIT_FOREVER);
+    TEST_ASSERT(XF_FD_ISSET(uart_fd, &readfds));
+    TEST_ASSERT(!XF_FD_ISSET(s_sock_a.fds[1], &readfds));
+    TEST_ASSERT(elapsed_ms < TIMEOUT_MS);
+    TEST_ASSERT_EQUAL(1u, s_sock_a.stops);
+    TEST_ASSERT_EQUAL(0u, s_sock_b.stops);
+
+    s_uart.readable = false;
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(uart_fd));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 两个 socket VFS 的 fd 在同一次 select 中：任一个就绪都返回，结果合并 */
+static void TEST_CASE_select_two_sockets(void)
+{
+    const int nfds = fd_max(s_sock_a.fds[SOCK_FDS - 1], s_sock_b.fds[SOCK_FDS - 1]) + 1;
+    xf_fd_set readfds;
+    uint32_t elapsed_ms;
+
+    /* 等待中 B 收到数据 */
+    event_later(event_sock_b);
+    XF_FD_ZERO(&readfds);
+    XF_FD_SET(s_sock_a.fds[0], &readfds);
+    XF_FD_SET(s_sock_a.fds[2], &readfds);
+    XF_FD_SET(s_sock_b.fds[2], &readfds);
+    TEST_ASSERT_EQUAL(1, select_read(&readfds, nfds, TIMEOUT_MS, &elapsed_ms));
+    xf_osal_semaphore_acquire(s_event_done, XF_OSAL_WAIT_FOREVER);
+    TEST_ASSERT(XF_FD_ISSET(s_sock_b.fds[2], &readfds));
+    TEST_ASSERT(!XF_FD_ISSET(s_sock_a.fds[0], &readfds));
+    TEST_ASSERT(!XF_FD_ISSET(s_sock_a.fds[2], &readfds));
+    TEST_ASSERT(elapsed_ms >= EVENT_DELAY_MS / 2 && elapsed_ms < TIMEOUT_MS);
+    sock_flush(&s_sock_b);
+
+    /* 两边都已就绪，没有要求的 fd 不返回 */
+    sock_receive(&s_sock_a, s_sock_a.fds[0]);
+    sock_receive(&s_sock_a, s_sock_a.fds[3]);
+    sock_receive(&s_sock_b, s_sock_b.fds[1]);
+    XF_FD_ZERO(&readfds);
+    XF_FD_SET(s_sock_a.fds[0], &readfds);
+    XF_FD_SET(s_sock_b.fds[1], &readfds);
+    XF_FD_SET(s_sock_b.fds[3], &readfds);
+    TEST_ASSERT_EQUAL(2, select_read(&readfds, nfds, TIMEOUT_MS, &elapsed_ms));
+    TEST_ASSERT(XF_FD_ISSET(s_sock_a.fds[0], &readfds));
+    TEST_ASSERT(XF_FD_ISSET(s_sock_b.fds[1], &readfds));
+    TEST_ASSERT(!XF_FD_ISSET(s_sock_a.fds[3], &readfds));
+    TEST_ASSERT(!XF_FD_ISSET(s_sock_b.fds[3], &readfds));
+    sock_flush(&s_sock_a);
+    sock_flush(&s_sock_b);
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_select_two_sockets_timeout(void)
+{
+    const int nfds = fd_max(s_sock_a.fds[SOCK_FDS - 1], s_sock_b.fds[SOCK_FDS - 1]) + 1;
+    xf_fd_set readfds;
+    uint32_t elapsed_ms;
+
+    XF_FD_ZERO(&readfds);
+    XF_FD_SET(s_sock_a.fds[1], &readfds);
+    XF_FD_SET(s_sock_b.fds[1], &readfds);
+    TEST_ASSERT_EQUAL(0, select_read(&readfds, nfds, 50, &elapsed_ms));
+    TEST_ASSERT(!XF_FD_ISSET(s_sock_a.fds[1], &readfds));
+    TEST_ASSERT(!XF_FD_ISSET(s_sock_b.fds[1], &readfds));
+    TEST_ASSERT(elapsed_ms >= 50 && elapsed_ms < TIMEOUT_MS);
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 两个 socket VFS 加一个普通 VFS：普通 VFS 的触发停止两个 socket_select */
+static void TEST_CASE_select_two_sockets_and_uart(void)
+{
+    const int uart_fd = xf_vfs_open("/uart/0", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(uart_fd >= 0);
+    const int nfds = fd_max(uart_fd, fd_max(s_sock_a.fds[SOCK_FDS - 1], s_sock_b.fds[SOCK_FDS - 1])) + 1;
+    xf_fd_set readfds;
+    uint32_t elapsed_ms;
+
+    s_sock_a.stops = 0;
+    s_sock_b.stops = 0;
+    event_later(event_uart);
+    XF_FD_ZERO(&readfds);
+    XF_FD_SET(s_sock_a.fds[0], &readfds);
+    XF_FD_SET(s_sock_b.fds[0], &readfds);
+    XF_FD_SET(uart_fd, &readfds);
+    TEST_ASSERT_EQUAL(1, select_read(&readfds, nfds, TIMEOUT_MS, &elapsed_ms));
+    xf_osal_semaphore_acquire(s_event_done, XF_OSAL_WAIT_FOREVER);
+    TEST_ASSERT(XF_FD_ISSET(uart_fd, &readfds));
+    TEST_ASSERT(!XF_FD_ISSET(s_sock_a.fds[0], &readfds));
+    TEST_ASSERT(!XF_FD_ISSET(s_sock_b.fds[0], &readfds));
+    TEST_ASSERT(elapsed_ms < TIMEOUT_MS);
+    TEST_ASSERT_EQUAL(1u, s_sock_a.stops);
+    TEST_ASSERT_EQUAL(1u, s_sock_b.stops);
+    TEST_ASSERT(!s_uart.selecting);
+
+    /* 之后的 select 不受残留的停止信号影响 */
+    s_uart.readable = false;
+    XF_FD_ZERO(&readfds);
+    XF_FD_SET(s_sock_a.fds[0], &readfds);
+    XF_FD_SET(s_sock_b.fds[0], &readfds);
+    XF_FD_SET(uart_fd, &readfds);
+    TEST_ASSERT_EQUAL(0, select_read(&readfds, nfds, 50, &elapsed_ms));
+    TEST_ASSERT(elapsed_ms >= 50);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(uart_fd));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 等待线程在各次 select 之间复用，只在创建时取一次信号量 */
+static void TEST_CASE_select_two_sockets_reuse_threads(void)
+{
+    const int nfds = fd_max(s_sock_a.fds[SOCK_FDS - 1], s_sock_b.fds[SOCK_FDS - 1]) + 1;
+    xf_fd_set readfds;
+    uint32_t elapsed_ms;
+
+    const uint32_t sem_gets = s_sem_gets;
+    for (int i = 0; i < 5; ++i) {
+        XF_FD_ZERO(&readfds);
+        XF_FD_SET(s_sock_a.fds[1], &readfds);
+        XF_FD_SET(s_sock_b.fds[1], &readfds);
+        TEST_ASSERT_EQUAL(0, select_read(&readfds, nfds, 10, &elapsed_ms));
+    }
+    TEST_ASSERT_EQUAL(sem_gets, s_sem_gets);
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/*
+ * B 在 select 期间注销：它正在使用的等待线程在 select 结束时退出，而不是回到空闲链表；
+ * B 重新注册后（驱动函数表可能分配在原来的地址）使用新的等待线程。
+ */
+static void TEST_CASE_select_unregister_while_waiting(void)
+{
+    const int nfds = fd_max(s_sock_a.fds[SOCK_FDS - 1], s_sock_b.fds[SOCK_FDS - 1]) + 1;
+    xf_fd_set readfds;
+    uint32_t elapsed_ms;
+
+    const uint32_t heap_before = heap_used();
+    event_later(event_unregister_sock_b);
+    XF_FD_ZERO(&readfds);
+    XF_FD_SET(s_sock_a.fds[1], &readfds);
+    XF_FD_SET(s_sock_b.fds[1], &readfds);
+    TEST_ASSERT_EQUAL(0, select_read(&readfds, nfds, 4 * EVENT_DELAY_MS, &elapsed_ms));
+    xf_osal_semaphore_acquire(s_event_done, XF_OSAL_WAIT_FOREVER);
+    xf_delay_ms(EVENT_DELAY_MS);
+
+    /* 重新注册后内存只比之前少 B 的等待线程 */
+    const uint32_t sem_gets = s_sem_gets;
+    sock_setup(&s_sock_b, &s_sock_b_vfs);
+    TEST_ASSERT_EQUAL(heap_before - 1, heap_used());
+
+    XF_FD_ZERO(&readfds);
+    XF_FD_SET(s_sock_a.fds[1], &readfds);
+    XF_FD_SET(s_sock_b.fds[1], &readfds);
+    TEST_ASSERT_EQUAL(0, select_read(&readfds, nfds, 10, &elapsed_ms));
+    TEST_ASSERT_EQUAL(sem_gets + 1, s_sem_gets);
+    TEST_ASSERT_EQUAL(heap_before, heap_used());
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static uint32_t heap_used(void)
+{
+    xf_vfs_mem_stats_t stats;
+    xf_vfs_get_mem_stats(&stats);
+    return stats.heap_used;
+}
+
+static int select_read(xf_fd_set *readfds, int nfds, uint32_t timeout_ms, uint32_t *elapsed_ms)
+{
+    xf_vfs_timeval_t tv = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    const uint64_t t0 = xf_sys_time_get_ms();
+    const int ret = xf_vfs_select(nfds, readfds, NULL, NULL, &tv);
+    *elapsed_ms = (uint32_t)(xf_sys_time_get_ms() - t0);
+    return ret;
+}
+
+static int fd_max(int a, int b)
+{
+    return (a > b) ? a : b;
+}
+
+static void event_thread(void *argument)
+{
+    void (*event)(void) = (void (*)(void))argument;
+    xf_delay_ms(EVENT_DELAY_MS);
+    event();
+    xf_osal_semaphore_release(s_event_done);
+    xf_osal_thread_delete(NULL);
+}
+
+static void event_later(void (*event)(void))
+{
+    const xf_osal_thread_attr_t attr = {
+        .name = "event",
+        .stack_size = 4096,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    TEST_ASSERT(xf_osal_thread_create(event_thread, (void *)event, &attr) != NULL);
+}
+
+static void event_sock_b(void)
+{
+    sock_receive(&s_sock_b, s_sock_b.fds[2]);
+}
+
+static void event_uart(void)
+{
+    uart_receive();
+}
+
+static void event_unregister_sock_b(void)
+{
+    sock_teardown(&s_sock_b);
+}
+
+static void sock_setup(sock_t *s, const xf_vfs_t *vfs)
+{
+    TEST_XF_OK(xf_vfs_register_with_id(vfs, s, &s->id));
+    for (int i = 0; i < SOCK_FDS; ++i) {
+        /* 协议栈内部的编号与 VFS 的全局 fd 不同，socket_select 使用全局 fd */
+        TEST_XF_OK(xf_vfs_register_fd_with_local_fd(s->id, 100 + i, true, &s->fds[i]));
+    }
+}
+
+static void sock_teardown(sock_t *s)
+{
+    TEST_XF_OK(xf_vfs_unregister_with_id(s->id));
+}
+
+static void sock_receive(sock_t *s, int fd)
+{
+    xf_lock_lock(s_lock);
+    s->ready[fd] = true;
+    for (int i = 0; i < SOCK_WAITERS; ++i) {
+        if (s->waiters[i] != NULL) {
+            xf_osal_semaphore_release(s->waiters[i]);
+        }
+    }
+    xf_lock_unlock(s_lock);
+}
+
+static void sock_flush(sock_t *s)
+{
+    xf_lock_lock(s_lock);
+    xf_memset(s->ready, 0, sizeof(s->ready));
+    xf_lock_unlock(s_lock);
+}
+
+static int sock_poll(sock_t *s, int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds, bool update)
+{
+    int count = 0;
+    for (int fd = 0; fd < nfds; ++fd) {
+        if (readfds && XF_FD_ISSET(fd, readfds)) {
+            if (s->ready[fd]) {
+                ++count;
+            } else if (update) {
+                XF_FD_CLR(fd, readfds);
+            }
+        }
+    }
+    if (update && writefds) {
+        XF_FD_ZERO(writefds);
+    }
+    if (update && errorfds) {
+        XF_FD_ZERO(errorfds);
+    }
+    return count;
+}
+
+/* 与 lwip 相同：在调用线程的信号量上等待，有数据或被 stop_socket_select 时返回 */
+static int sock_select(sock_t *s, int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds,
+                       xf_vfs_timeval_t *timeout)
+{
+    void *sem = sock_get_semaphore();
+    int slot = -1;
+    xf_lock_lock(s_lock);
+    for (int i = 0; i < SOCK_WAITERS && slot < 0; ++i) {
+        if (s->waiters[i] == NULL) {
+            s->waiters[i] = sem;
+            slot = i;
+        }
+    }
+    const int count = sock_poll(s, nfds, readfds, writefds, errorfds, false);
+    xf_lock_unlock(s_lock);
+    if (slot < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    if (count == 0) {
+        uint32_t ticks = XF_OSAL_WAIT_FOREVER;
+        if (timeout) {
+            ticks = xf_osal_kernel_ms_to_ticks(timeout->tv_sec * 1000 + timeout->tv_usec / 1000);
+        }
+        xf_osal_semaphore_acquire(sem, ticks);
+    }
+
+    xf_lock_lock(s_lock);
+    s->waiters[slot] = NULL;
+    const int ret = sock_poll(s, nfds, readfds, writefds, errorfds, true);
+    xf_lock_unlock(s_lock);
+    return ret;
+}
+
+static void sock_stop(sock_t *s, void *sem)
+{
+    ++s->stops;
+    xf_osal_semaphore_release(sem);
+}
+
+/* 每个线程一个信号量，与 lwip 的 LWIP_NETCONN_THREAD_SEM_GET 相同 */
+static void *sock_get_semaphore(void)
+{
+    const xf_osal_thread_t self = xf_osal_thread_get_current();
+    xf_osal_semaphore_t sem = NULL;
+    xf_lock_lock(s_lock);
+    for (int i = 0; i < THREAD_SEMS && sem == NULL; ++i) {
+        if (s_thread_sems[i].sem == NULL) {
+            xf_osal_semaphore_attr_t sem_attr = {
+                .name = "thread",
+            };
+            s_thread_sems[i].thread = self;
+            s_thread_sems[i].sem = xf_osal_semaphore_create(1, 0, &sem_attr);
+        }
+        if (s_thread_sems[i].thread == self) {
+            sem = s_thread_sems[i].sem;
+        }
+    }
+    xf_lock_unlock(s_lock);
+    TEST_ASSERT(sem != NULL);
+    return sem;
+}
+
+static void *sock_get_select_semaphore(void)
+{
+    ++s_sem_gets;
+    return sock_get_semaphore();
+}
+
+static int sock_a_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds,
+                         xf_vfs_timeval_t *timeout)
+{
+    return sock_select(&s_sock_a, nfds, readfds, writefds, errorfds, timeout);
+}
+
+static void sock_a_stop(void *sem)
+{
+    sock_stop(&s_sock_a, sem);
+}
+
+static int sock_b_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds,
+                         xf_vfs_timeval_t *timeout)
+{
+    return sock_select(&s_sock_b, nfds, readfds, writefds, errorfds, timeout);
+}
+
+static void sock_b_stop(void *sem)
+{
+    sock_stop(&s_sock_b, sem);
+}
+
+static int sock_close(int fd)
+{
+    return 0;
+}
+
+static int uart_open(const char *path, int flags, int mode)
+{
+    return 0;
+}
+
+static int uart_close(int fd)
+{
+    return 0;
+}
+
+static xf_err_t uart_start_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *exceptfds,
+                                  xf_vfs_select_sem_t sem, void **end_select_args)
+{
+    xf_lock_lock(s_lock);
+    s_uart.selecting = readfds && XF_FD_ISSET(0, readfds);
+    s_uart.readfds = readfds;
+    s_uart.sem = sem;
+    if (writefds) {
+        XF_FD_ZERO(writefds);
+    }
+    if (exceptfds) {
+        XF_FD_ZERO(exceptfds);
+    }
+    if (s_uart.selecting && s_uart.readable) {
+        xf_vfs_select_triggered(sem);
+    }
+    xf_lock_unlock(s_lock);
+    *end_select_args = &s_uart;
+    return XF_OK;
+}
+
+static xf_err_t uart_end_select(void *end_select_args)
+{
+    uart_t *uart = end_select_args;
+    xf_lock_lock(s_lock);
+    if (uart->selecting && !uart->readable) {
+        XF_FD_CLR(0, uart->readfds);
+    }
+    uart->selecting = false;
+    xf_lock_unlock(s_lock);
+    return XF_OK;
+}
+
+static void uart_receive(void)
+{
+    xf_lock_lock(s_lock);
+    s_uart.readable = true;
+    if (s_uart.selecting) {
+        xf_vfs_select_triggered(s_uart.sem);
+    }
+    xf_lock_unlock(s_lock);
+}
@@ -0,0 +1,396 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 驱动调用串行化测试：不加锁的驱动在 XF_VFS_FLAG_SERIAL_MOUNT / XF_VFS_FLAG_SERIAL_FILE 下
+ *        不会被并发进入，读操作仍然并行；未设置标志的挂载点不加锁。
+ * @version 1.0
+ * @date 2025-01-25
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_osal.h"
+#include "xf_vfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define DEV_FILES           2
+#define PATH_SLOT           DEV_FILES       /* 路径操作在探针中的计数位置 */
+#define JOBS_MAX            4
+#define PARTNER_WAIT_MS     20              /* 驱动在调用中等待其他调用进入的最长时间 */
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef enum {
+    JOB_PREAD,
+    JOB_PWRITE,
+    JOB_STAT,
+    JOB_UNLINK,
+} job_op_t;
+
+typedef struct {
+    job_op_t op;
+    int fd;
+    const char *path;
+    int ret;
+} job_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int dev_open(const char *path, int flags, int mode);
+static int dev_close(int fd);
+static xf_vfs_ssize_t dev_pread(int fd, void *dst, size_t size, xf_vfs_off_t offset);
+static xf_vfs_ssize_t dev_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset);
+static int dev_stat(const char *path, xf_vfs_stat_t *st);
+static int dev_unlink(const char *path);
+
+static void probe_call(int slot, bool reader);
+static void probe_reset(void);
+static void jobs_run(job_t *jobs, size_t n);
+static void job_thread(void *argument);
+
+static void TEST_CASE_serial_flags(void);
+static void TEST_CASE_serial_none(void);
+static void TEST_CASE_serial_mount(void);
+static void TEST_CASE_serial_file(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_dir_ops_t s_dev_dir_ops = {
+    .stat = dev_stat,
+    .unlink = dev_unlink,
+};
+
+/* 驱动本身不加任何锁，只用探针记录同时进入的调用数 */
+static const xf_vfs_fs_ops_t s_dev_ops = {
+    .open = dev_open,
+    .close = dev_close,
+    .pread = dev_pread,
+    .pwrite = dev_pwrite,
+    .dir = &s_dev_dir_ops,
+};
+
+static xf_lock_t s_probe_lock;
+static volatile int s_active;                       /* 正在驱动中的调用数 */
+static volatile int s_active_slot[DEV_FILES + 1];
+static volatile int s_readers;
+static int s_max_active;
+static int s_max_slot[DEV_FILES + 1];
+static int s_max_readers;
+
+static xf_osal_semaphore_t s_done;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "done",
+    };
+    s_done = xf_osal_semaphore_create(JOBS_MAX, 0, &sem_attr);
+    TEST_ASSERT(s_done != NULL);
+    TEST_XF_OK(xf_lock_init(&s_probe_lock));
+
+    TEST_CASE_serial_flags();
+    TEST_CASE_serial_none();
+    TEST_CASE_serial_mount();
+    TEST_CASE_serial_file();
+
+    xf_lock_destroy(s_probe_lock);
+    xf_osal_semaphore_delete(s_done);
+    return 0;
+}
+
+/* 两个串行化标志互斥 */
+static void TEST_CASE_serial_flags(void)
+{
+    TEST_ASSERT_EQUAL(XF_ERR_INVALID_ARG, xf_vfs_register_fs("/dev", &s_dev_ops,
+                      XF_VFS_FLAG_STATIC | XF_VFS_FLAG_SERIAL_FILE | XF_VFS_FLAG_SERIAL_MOUNT, NULL));
+    TEST_ASSERT(xf_vfs_open("/dev/a", XF_VFS_O_RDWR, 0) < 0);
+
+    TEST_XF_OK(xf_vfs_register_fs("/dev", &s_dev_ops, XF_VFS_FLAG_STATIC | XF_VFS_FLAG_SERIAL_MOUNT, NULL));
+    TEST_XF_OK(xf_vfs_unregister_fs("/dev"));
+    TEST_XF_OK(xf_vfs_register_fs("/dev", &s_dev_ops, XF_VFS_FLAG_STATIC | XF_VFS_FLAG_SERIAL_FILE, NULL));
+    TEST_XF_OK(xf_vfs_unregister_fs("/dev"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 未设置串行化标志时 VFS 不加锁，同一文件上的写入同时进入驱动 */
+static void TEST_CASE_serial_none(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/dev", &s_dev_ops, XF_VFS_FLAG_STATIC, NULL));
+    const int fd = xf_vfs_open("/dev/a", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(fd >= 0);
+
+    job_t jobs[2] = {
+        { .op = JOB_PWRITE, .fd = fd },
+        { .op = JOB_PWRITE, .fd = fd },
+    };
+    probe_reset();
+    jobs_run(jobs, 2);
+    TEST_ASSERT_EQUAL(2, s_max_slot[0]);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_XF_OK(xf_vfs_unregister_fs("/dev"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 整个挂载点串行：不同文件上的写入与路径操作也不会同时进入驱动，pread 与 stat 并行 */
+static void TEST_CASE_serial_mount(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/dev", &s_dev_ops, XF_VFS_FLAG_STATIC | XF_VFS_FLAG_SERIAL_MOUNT, NULL));
+    const int fa = xf_vfs_open("/dev/a", XF_VFS_O_RDWR, 0);
+    const int fb = xf_vfs_open("/dev/b", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(fa >= 0 && fb >= 0);
+
+    job_t writers[4] = {
+        { .op = JOB_PWRITE, .fd = fa },
+        { .op = JOB_PWRITE, .fd = fb },
+        { .op = JOB_UNLINK, .path = "/dev/a" },
+        { .op = JOB_PWRITE, .fd = fa },
+    };
+    probe_reset();
+    jobs_run(writers, 4);
+    TEST_ASSERT_EQUAL(1, s_max_active);
+    for (size_t i = 0; i < 4; ++i) {
+        TEST_ASSERT_EQUAL(0, writers[i].ret);
+    }
+
+    job_t readers[3] = {
+        { .op = JOB_PREAD, .fd = fa },
+        { .op = JOB_PREAD, .fd = fb },
+        { .op = JOB_STAT, .path = "/dev/b" },
+    };
+    probe_reset();
+    jobs_run(readers, 3);
+    TEST_ASSERT(s_max_readers >= 2);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fa));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fb));
+    TEST_XF_OK(xf_vfs_unregister_fs("/dev"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 按文件串行：同一文件上的写入串行，不同文件并行，同一文件上的 pread 并行；路径操作之间串行 */
+static void TEST_CASE_serial_file(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/dev", &s_dev_ops, XF_VFS_FLAG_STATIC | XF_VFS_FLAG_SERIAL_FILE, NULL));
+    const int fa = xf_vfs_open("/dev/a", XF_VFS_O_RDWR, 0);
+    const int fb = xf_vfs_open("/dev/b", XF_VFS_O_RDWR, 0);
+    TEST_ASSERT(fa >= 0 && fb >= 0);
+
+    job_t writers[4] = {
+        { .op = JOB_PWRITE, .fd = fa },
+        { .op = JOB_PWRITE, .fd = fb },
+        { .op = JOB_PWRITE, .fd = fa },
+        { .op = JOB_PWRITE, .fd = fb },
+    };
+    probe_reset();
+    jobs_run(writers, 4);
+    TEST_ASSERT_EQUAL(1, s_max_slot[0]);
+    TEST_ASSERT_EQUAL(1, s_max_slot[1]);
+    TEST_ASSERT_EQUAL(2, s_max_active);
+
+    /* dup 出的 fd 与原 fd 是同一个驱动文件 */
+    const int fa2 = xf_vfs_dup(fa);
+    TEST_ASSERT(fa2 >= 0);
+    job_t same[2] = {
+        { .op = JOB_PWRITE, .fd = fa },
+        { .op = JOB_PWRITE, .fd = fa2 },
+    };
+    probe_reset();
+    jobs_run(same, 2);
+    TEST_ASSERT_EQUAL(1, s_max_slot[0]);
+
+    job_t readers[2] = {
+        { .op = JOB_PREAD, .fd = fa },
+        { .op = JOB_PREAD, .fd = fa2 },
+    };
+    probe_reset();
+    jobs_run(readers, 2);
+    TEST_ASSERT_EQUAL(2, s_max_slot[0]);
+
+    job_t paths[2] = {
+        { .op = JOB_UNLINK, .path = "/dev/a" },
+        { .op = JOB_UNLINK, .path = "/dev/b" },
+    };
+    probe_reset();
+    jobs_run(paths, 2);
+    TEST_ASSERT_EQUAL(1, s_max_slot[PATH_SLOT]);
+
+    job_t stats[2] = {
+        { .op = JOB_STAT, .path = "/dev/a" },
+        { .op = JOB_STAT, .path = "/dev/b" },
+    };
+    probe_reset();
+    jobs_run(stats, 2);
+    TEST_ASSERT_EQUAL(2, s_max_slot[PATH_SLOT]);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fa2));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fa));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fb));
+    TEST_XF_OK(xf_vfs_unregister_fs("/dev"));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void jobs_run(job_t *jobs, size_t n)
+{
+    const xf_osal_thread_attr_t attr = {
+        .name = "job",
+        .stack_size = 4096,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    for (size_t i = 0; i < n; ++i) {
+        TEST_ASSERT(xf_osal_thread_create(job_thread, &jobs[i], &attr) != NULL);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        xf_osal_semaphore_acquire(s_done, XF_OSAL_WAIT_FOREVER);
+    }
+}
+
+static void job_thread(void *argument)
+{
+    job_t *job = argument;
+    char buf[16] = {0};
+    xf_vfs_stat_t st;
+    switch (job->op) {
+    case JOB_PREAD:
+        job->ret = (xf_vfs_pread(job->fd, buf, sizeof(buf), 0) == (xf_vfs_ssize_t)sizeof(buf)) ? 0 : -1;
+        break;
+    case JOB_PWRITE:
+        job->ret = (xf_vfs_pwrite(job->fd, buf, sizeof(buf), 0) == (xf_vfs_ssize_t)sizeof(buf)) ? 0 : -1;
+        break;
+    case JOB_STAT:
+        job->ret = xf_vfs_stat(job->path, &st);
+        break;
+    case JOB_UNLINK:
+        job->ret = xf_vfs_unlink(job->path);
+        break;
+    }
+    xf_osal_semaphore_release(s_done);
+    xf_osal_thread_delete(NULL);
+}
+
+static void probe_reset(void)
+{
+    s_max_active = 0;
+    s_max_readers = 0;
+    xf_memset(s_max_slot, 0, sizeof(s_max_slot));
+}
+
+/*
+ * 记录一次驱动调用：进入后等待其他调用也进入（最多 PARTNER_WAIT_MS），
+ * 没有被 VFS 串行化的调用因此一定会同时出现在驱动中。
+ */
+static void probe_call(int slot, bool reader)
+{
+    xf_lock_lock(s_probe_lock);
+    ++s_active;
+    ++s_active_slot[slot];
+    s_readers += reader;
+    if (s_active > s_max_active) {
+        s_max_active = s_active;
+    }
+    if (s_active_slot[slot] > s_max_slot[slot]) {
+        s_max_slot[slot] = s_active_slot[slot];
+    }
+    if (s_readers > s_max_readers) {
+        s_max_readers = s_readers;
+    }
+    xf_lock_unlock(s_probe_lock);
+
+    for (int i = 0; i < PARTNER_WAIT_MS && s_active < 2; ++i) {
+        xf_osal_delay_ms(1);
+    }
+    /* 等待其他调用看到本调用 */
+    xf_osal_delay_ms(2);
+
+    xf_lock_lock(s_probe_lock);
+    --s_active;
+    --s_active_slot[slot];
+    s_readers -= reader;
+    xf_lock_unlock(s_probe_lock);
+}
+
+static int dev_open(const char *path, int flags, int mode)
+{
+    if (xf_strcmp(path, "/a") == 0) {
+        return 0;
+    }
+    if (xf_strcmp(path, "/b") == 0) {
+        return 1;
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+static int dev_close(int fd)
+{
+    return 0;
+}
+
+static xf_vfs_ssize_t dev_pread(int fd, void *dst, size_t size, xf_vfs_off_t offset)
+{
+    probe_call(fd, true);
+    xf_memset(dst, 0, size);
+    return (xf_vfs_ssize_t)size;
+}
+
+static xf_vfs_ssize_t dev_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    probe_call(fd, false);
+    return (xf_vfs_ssize_t)size;
+}
+
+static int dev_stat(const char *path, xf_vfs_stat_t *st)
+{
+    probe_call(PATH_SLOT, true);
+    xf_memset(st, 0, sizeof(*st));
+    return 0;
+}
+
+static int dev_unlink(const char *path)
+{
+    probe_call(PATH_SLOT, false);
+    return 0;
+}
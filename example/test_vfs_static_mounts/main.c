@@ -0,0 +1,244 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 编译期挂载表测试：不注册即可使用的挂载点，以及与运行时注册的挂载点共存。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+#include "xf_vfs_private.h"
+#include "ramfs.h"
+#include "static_mounts.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int romfs_open(void *ctx, const char *path, int flags, int mode);
+static int romfs_close(void *ctx, int fd);
+static xf_vfs_ssize_t romfs_read(void *ctx, int fd, void *dst, size_t size);
+static int romfs_stat(void *ctx, const char *path, xf_vfs_stat_t *st);
+static int romfs_find(const romfs_t *rom, const char *path);
+
+static int null_open(const char *path, int flags, int mode);
+static int null_close(int fd);
+static xf_vfs_ssize_t null_write(int fd, const void *data, size_t size);
+
+static void TEST_CASE_static_mounts_no_register(void);
+static void TEST_CASE_static_mounts_with_dynamic(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_dir_ops_t s_romfs_dir_ops = {
+    .stat_p = romfs_stat,
+};
+
+/* ==================== [Global Variables] ================================== */
+
+const xf_vfs_fs_ops_t g_romfs_ops = {
+    .open_p = romfs_open,
+    .close_p = romfs_close,
+    .read_p = romfs_read,
+    .dir = &s_romfs_dir_ops,
+};
+
+const xf_vfs_fs_ops_t g_null_ops = {
+    .open = null_open,
+    .close = null_close,
+    .write = null_write,
+};
+
+romfs_t g_rom = {
+    .files = {
+        { "/version", "1.2.3", 5 },
+        { "/board", "xf-demo-board", 13 },
+    },
+};
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    /* 不调用任何注册函数 */
+    TEST_CASE_static_mounts_no_register();
+    TEST_CASE_static_mounts_with_dynamic();
+    return 0;
+}
+
+static void TEST_CASE_static_mounts_no_register(void)
+{
+    TEST_ASSERT_EQUAL(2, XF_VFS_STATIC_MOUNT_COUNT);
+    const xf_vfs_entry_t *rom = xf_vfs_get_vfs_for_index(XF_VFS_STATIC_ID_rom);
+    TEST_ASSERT(rom != NULL);
+    TEST_ASSERT(rom == xf_vfs_get_vfs_for_path("/rom/version"));
+    TEST_ASSERT(rom == xf_vfs_get_vfs_for_path("/rom"));
+    TEST_ASSERT(NULL == xf_vfs_get_vfs_for_path("/romx/version"));
+    TEST_ASSERT(xf_vfs_get_vfs_for_index(XF_VFS_STATIC_ID_null) == xf_vfs_get_vfs_for_path("/dev/null"));
+
+    char buf[16] = { 0 };
+    int fd = xf_vfs_open("/rom/board", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(13, xf_vfs_read(fd, buf, sizeof(buf)));
+    TEST_ASSERT(xf_strcmp(buf, "xf-demo-board") == 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/rom/version", &st));
+    TEST_ASSERT_EQUAL(5, st.st_size);
+    TEST_ASSERT_EQUAL(-1, xf_vfs_stat("/rom/none", &st));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+
+    /* flags 与运行时注册相同 */
+    TEST_ASSERT_EQUAL(-1, xf_vfs_open("/rom/version", XF_VFS_O_WRONLY, 0));
+    TEST_ASSERT_EQUAL(EROFS, errno);
+
+    fd = xf_vfs_open("/dev/null", XF_VFS_O_WRONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(3, xf_vfs_write(fd, "abc", 3));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_static_mounts_with_dynamic(void)
+{
+    xf_vfs_id_t id;
+    TEST_XF_OK(xf_vfs_register_fs_with_id(&g_null_ops, XF_VFS_FLAG_STATIC, NULL, &id));
+    TEST_ASSERT(id >= XF_VFS_STATIC_MOUNT_COUNT);
+    TEST_XF_OK(xf_vfs_unregister_with_id(id));
+
+    /* 更长的前缀优先，不论挂载点来自哪里 */
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/rom/rw", &fs));
+    int fd = xf_vfs_open("/rom/rw/f", XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/rom/rw/f", &st));
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/rom/board", &st));
+    TEST_XF_OK(ramfs_unmount("/rom/rw", fs));
+
+    /* 编译期挂载点也可以注销，注销后槽位可以再用 */
+    TEST_XF_OK(xf_vfs_unregister("/dev/null"));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_open("/dev/null", XF_VFS_O_WRONLY, 0));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+    TEST_XF_OK(xf_vfs_register_fs_with_id(&g_null_ops, XF_VFS_FLAG_STATIC, NULL, &id));
+    TEST_ASSERT_EQUAL(XF_VFS_STATIC_ID_null, id);
+    TEST_XF_OK(xf_vfs_unregister_with_id(id));
+    TEST_XF_OK(xf_vfs_register_fs("/dev/null", &g_null_ops, XF_VFS_FLAG_STATIC, NULL));
+    fd = xf_vfs_open("/dev/null", XF_VFS_O_WRONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_XF_OK(xf_vfs_unregister("/dev/null"));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static int romfs_find(const romfs_t *rom, const char *path)
+{
+    for (int i = 0; i < ROMFS_FILES_MAX; ++i) {
+        if (rom->files[i].name != NULL && xf_strcmp(rom->files[i].name, path) == 0) {
+            return i;
+        }
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+static int romfs_open(void *ctx, const char *path, int flags, int mode)
+{
+    romfs_t *rom = ctx;
+    const int fd = romfs_find(rom, path);
+    if (fd >= 0) {
+        rom->pos[fd] = 0;
+    }
+    return fd;
+}
+
+static int romfs_close(void *ctx, int fd)
+{
+    return 0;
+}
+
+static xf_vfs_ssize_t romfs_read(void *ctx, int fd, void *dst, size_t size)
+{
+    romfs_t *rom = ctx;
+    const romfs_file_t *file = &rom->files[fd];
+    const size_t n = (size < file->size - rom->pos[fd]) ? size : file->size - rom->pos[fd];
+    xf_memcpy(dst, file->data + rom->pos[fd], n);
+    rom->pos[fd] += n;
+    return (xf_vfs_ssize_t)n;
+}
+
+static int romfs_stat(void *ctx, const char *path, xf_vfs_stat_t *st)
+{
+    const romfs_t *rom = ctx;
+    const int i = romfs_find(rom, path);
+    if (i < 0) {
+        return -1;
+    }
+    xf_memset(st, 0, sizeof(xf_vfs_stat_t));
+    st->st_mode = XF_VFS_S_IFREG | 0444;
+    st->st_size = (xf_vfs_off_t)rom->files[i].size;
+    return 0;
+}
+
+static int null_open(const char *path, int flags, int mode)
+{
+    return 0;
+}
+
+static int null_close(int fd)
+{
+    return 0;
+}
+
+static xf_vfs_ssize_t null_write(int fd, const void *data, size_t size)
+{
+    return (xf_vfs_ssize_t)size;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file static_mounts.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 编译期挂载表引用的驱动与上下文，见 xf_vfs_config.h 中的 XF_VFS_STATIC_MOUNTS.
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __STATIC_MOUNTS_H__
+#define __STATIC_MOUNTS_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs_ops.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define ROMFS_FILES_MAX     4
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 只读文件系统，文件内容为常量数据（如位于 flash 中）。
+ */
+typedef struct {
+    const char *name;
+    const char *data;
+    size_t size;
+} romfs_file_t;
+
+typedef struct {
+    romfs_file_t files[ROMFS_FILES_MAX];
+    size_t pos[ROMFS_FILES_MAX];    /*!< 每个文件同时只能打开一次 */
+} romfs_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+extern const xf_vfs_fs_ops_t g_romfs_ops;
+extern const xf_vfs_fs_ops_t g_null_ops;
+extern romfs_t g_rom;
+
+/* ==================== [Macros] ============================================ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __STATIC_MOUNTS_H__ */
@@ -0,0 +1,336 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs_statx() 测试：按字段查询属性，旧驱动回退到 stat.
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define META_MTIME      1700000000
+
+/* 读取时间戳及块数需要额外读一次元数据的字段 */
+#define META_FIELDS     (XF_VFS_STATX_ATIME | XF_VFS_STATX_MTIME | XF_VFS_STATX_CTIME | XF_VFS_STATX_BLOCKS)
+
+/* ==================== [Typedefs] ========================================== */
+
+/*
+ * 模拟 flash 文件系统：根目录下只有一个文件 "/data"，
+ * 类型及大小在内存中，其余字段需要读取元数据块。
+ */
+typedef struct {
+    uint8_t data[64];
+    xf_vfs_off64_t size;
+    uint32_t meta_reads;        /*!< 读取元数据块的次数 */
+} flashfs_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void flash_fill(flashfs_t *fs, bool is_dir, uint32_t mask, xf_vfs_statx_t *stx);
+static int flash_lookup(const char *path, bool *is_dir);
+static int flash_open(void *ctx, const char *path, int flags, int mode);
+static int flash_close(void *ctx, int fd);
+static xf_vfs_ssize_t flash_pread(void *ctx, int fd, void *dst, size_t size, xf_vfs_off_t offset);
+static xf_vfs_ssize_t flash_pwrite(void *ctx, int fd, const void *src, size_t size, xf_vfs_off_t offset);
+static int flash_fstat(void *ctx, int fd, xf_vfs_stat_t *st);
+static int flash_fstatx(void *ctx, int fd, uint32_t mask, xf_vfs_statx_t *stx);
+static int flash_stat(void *ctx, const char *path, xf_vfs_stat_t *st);
+static int flash_statx(void *ctx, const char *path, uint32_t mask, xf_vfs_statx_t *stx);
+
+static void TEST_CASE_statx_size_skips_metadata(void);
+static void TEST_CASE_statx_fstatx(void);
+static void TEST_CASE_statx_append_and_seek_end(void);
+static void TEST_CASE_statx_fallback_to_stat(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_dir_ops_t s_flash_dir_ops = {
+    .stat_p = flash_stat,
+    .statx_p = flash_statx,
+};
+
+static const xf_vfs_fs_ops_t s_flash_ops = {
+    .open_p = flash_open,
+    .close_p = flash_close,
+    .pread_p = flash_pread,
+    .pwrite_p = flash_pwrite,
+    .fstat_p = flash_fstat,
+    .fstatx_p = flash_fstatx,
+    .dir = &s_flash_dir_ops,
+};
+
+static flashfs_t s_flash;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    s_flash.size = 10;
+    TEST_XF_OK(xf_vfs_register_fs("/flash", &s_flash_ops,
+                                  XF_VFS_FLAG_CONTEXT_PTR | XF_VFS_FLAG_VFS_OFFSET | XF_VFS_FLAG_STATIC, &s_flash));
+
+    TEST_CASE_statx_size_skips_metadata();
+    TEST_CASE_statx_fstatx();
+    TEST_CASE_statx_append_and_seek_end();
+    TEST_CASE_statx_fallback_to_stat();
+
+    TEST_XF_OK(xf_vfs_unregister_fs("/flash"));
+    return 0;
+}
+
+static void TEST_CASE_statx_size_skips_metadata(void)
+{
+    xf_vfs_statx_t stx;
+    s_flash.meta_reads = 0;
+    TEST_ASSERT_EQUAL(0, xf_vfs_statx("/flash/data", XF_VFS_STATX_SIZE, &stx));
+    TEST_ASSERT_EQUAL(0, s_flash.meta_reads);
+    TEST_ASSERT(stx.stx_mask & XF_VFS_STATX_SIZE);
+    TEST_ASSERT_EQUAL(10, stx.stx_size);
+    /* 未请求的昂贵字段没有填充 */
+    TEST_ASSERT_EQUAL(0, stx.stx_mask & META_FIELDS);
+    TEST_ASSERT_EQUAL(0, stx.stx_modtime);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_statx("/flash", XF_VFS_STATX_TYPE, &stx));
+    TEST_ASSERT_EQUAL(XF_VFS_S_IFDIR, stx.stx_mode & XF_VFS_S_IFMT);
+    TEST_ASSERT_EQUAL(0, s_flash.meta_reads);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_statx("/flash/data", XF_VFS_STATX_SIZE | XF_VFS_STATX_MTIME, &stx));
+    TEST_ASSERT_EQUAL(1, s_flash.meta_reads);
+    TEST_ASSERT_EQUAL(META_MTIME, stx.stx_modtime);
+
+    /* xf_vfs_stat() 不受影响，总是读取全部字段 */
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/flash/data", &st));
+    TEST_ASSERT_EQUAL(2, s_flash.meta_reads);
+    TEST_ASSERT_EQUAL(10, st.st_size);
+
+    TEST_ASSERT_EQUAL(-1, xf_vfs_statx("/flash/none", XF_VFS_STATX_SIZE, &stx));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_statx_fstatx(void)
+{
+    int fd = xf_vfs_open("/flash/data", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    xf_vfs_statx_t stx;
+    s_flash.meta_reads = 0;
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstatx(fd, XF_VFS_STATX_SIZE | XF_VFS_STATX_TYPE, &stx));
+    TEST_ASSERT_EQUAL(0, s_flash.meta_reads);
+    TEST_ASSERT_EQUAL(10, stx.stx_size);
+    TEST_ASSERT_EQUAL(XF_VFS_S_IFREG, stx.stx_mode & XF_VFS_S_IFMT);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstatx(fd, XF_VFS_STATX_BASIC_STATS, &stx));
+    TEST_ASSERT_EQUAL(1, s_flash.meta_reads);
+    TEST_ASSERT_EQUAL(XF_VFS_STATX_BASIC_STATS, stx.stx_mask & XF_VFS_STATX_BASIC_STATS);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+
+    TEST_ASSERT_EQUAL(-1, xf_vfs_fstatx(fd, XF_VFS_STATX_SIZE, &stx));
+    TEST_ASSERT_EQUAL(EBADF, errno);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* VFS 管理偏移时 O_APPEND 及 SEEK_END 只查询大小 */
+static void TEST_CASE_statx_append_and_seek_end(void)
+{
+    s_flash.meta_reads = 0;
+    int fd = xf_vfs_open("/flash/data", XF_VFS_O_WRONLY | XF_VFS_O_APPEND, 0);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(4, xf_vfs_write(fd, "tail", 4));
+    TEST_ASSERT_EQUAL(14, s_flash.size);
+    TEST_ASSERT_EQUAL(14, xf_vfs_lseek(fd, 0, XF_VFS_SEEK_END));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(0, s_flash.meta_reads);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_statx_fallback_to_stat(void)
+{
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+    int fd = xf_vfs_open("/ram/f", XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(5, xf_vfs_write(fd, "hello", 5));
+
+    /* ramfs 没有 statx：回退到 stat 并报告所有字段 */
+    xf_vfs_statx_t stx;
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(0, xf_vfs_statx("/ram/f", XF_VFS_STATX_SIZE, &stx));
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/ram/f", &st));
+    TEST_ASSERT_EQUAL(XF_VFS_STATX_BASIC_STATS, stx.stx_mask);
+    TEST_ASSERT_EQUAL(5, stx.stx_size);
+    TEST_ASSERT_EQUAL(st.st_mode, stx.stx_mode);
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstatx(fd, XF_VFS_STATX_SIZE, &stx));
+    TEST_ASSERT_EQUAL(XF_VFS_STATX_BASIC_STATS, stx.stx_mask);
+    TEST_ASSERT_EQUAL(5, stx.stx_size);
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlink("/ram/f"));
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 按 mask 填充，只有请求了昂贵字段时才读取元数据 */
+static void flash_fill(flashfs_t *fs, bool is_dir, uint32_t mask, xf_vfs_statx_t *stx)
+{
+    stx->stx_mask = XF_VFS_STATX_TYPE | XF_VFS_STATX_MODE | XF_VFS_STATX_SIZE;
+    stx->stx_mode = (is_dir ? XF_VFS_S_IFDIR : XF_VFS_S_IFREG) | 0644;
+    stx->stx_size = is_dir ? 0 : fs->size;
+    if (mask & (META_FIELDS | XF_VFS_STATX_BLKSIZE | XF_VFS_STATX_DEV)) {
+        ++fs->meta_reads;
+        stx->stx_mask |= META_FIELDS | XF_VFS_STATX_BLKSIZE | XF_VFS_STATX_DEV;
+        stx->stx_actime = META_MTIME;
+        stx->stx_modtime = META_MTIME;
+        stx->stx_chtime = META_MTIME;
+        stx->stx_blksize = 512;
+        stx->stx_blocks = (xf_vfs_blkcnt_t)((stx->stx_size + 511) / 512);
+    }
+}
+
+static int flash_lookup(const char *path, bool *is_dir)
+{
+    if (xf_strcmp(path, "/") == 0) {
+        *is_dir = true;
+        return 0;
+    }
+    if (xf_strcmp(path, "/data") == 0) {
+        *is_dir = false;
+        return 0;
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+static int flash_open(void *ctx, const char *path, int flags, int mode)
+{
+    bool is_dir;
+    if (flash_lookup(path, &is_dir) < 0 || is_dir) {
+        errno = ENOENT;
+        return -1;
+    }
+    return 0;
+}
+
+static int flash_close(void *ctx, int fd)
+{
+    return 0;
+}
+
+static xf_vfs_ssize_t flash_pread(void *ctx, int fd, void *dst, size_t size, xf_vfs_off_t offset)
+{
+    flashfs_t *fs = ctx;
+    if (offset >= fs->size) {
+        return 0;
+    }
+    if (size > (size_t)(fs->size - offset)) {
+        size = (size_t)(fs->size - offset);
+    }
+    xf_memcpy(dst, fs->data + offset, size);
+    return (xf_vfs_ssize_t)size;
+}
+
+static xf_vfs_ssize_t flash_pwrite(void *ctx, int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    flashfs_t *fs = ctx;
+    if (offset + size > sizeof(fs->data)) {
+        errno = ENOSPC;
+        return -1;
+    }
+    xf_memcpy(fs->data + offset, src, size);
+    if (offset + (xf_vfs_off_t)size > fs->size) {
+        fs->size = offset + (xf_vfs_off_t)size;
+    }
+    return (xf_vfs_ssize_t)size;
+}
+
+static int flash_fstat(void *ctx, int fd, xf_vfs_stat_t *st)
+{
+    xf_vfs_statx_t stx = {0};
+    flash_fill(ctx, false, XF_VFS_STATX_BASIC_STATS, &stx);
+    xf_memset(st, 0, sizeof(xf_vfs_stat_t));
+    st->st_mode = stx.stx_mode;
+    st->st_size = (xf_vfs_off_t)stx.stx_size;
+    st->st_modtime = stx.stx_modtime;
+    return 0;
+}
+
+static int flash_fstatx(void *ctx, int fd, uint32_t mask, xf_vfs_statx_t *stx)
+{
+    flash_fill(ctx, false, mask, stx);
+    return 0;
+}
+
+static int flash_stat(void *ctx, const char *path, xf_vfs_stat_t *st)
+{
+    bool is_dir;
+    if (flash_lookup(path, &is_dir) < 0) {
+        return -1;
+    }
+    xf_vfs_statx_t stx = {0};
+    flash_fill(ctx, is_dir, XF_VFS_STATX_BASIC_STATS, &stx);
+    xf_memset(st, 0, sizeof(xf_vfs_stat_t));
+    st->st_mode = stx.stx_mode;
+    st->st_size = (xf_vfs_off_t)stx.stx_size;
+    st->st_modtime = stx.stx_modtime;
+    return 0;
+}
+
+static int flash_statx(void *ctx, const char *path, uint32_t mask, xf_vfs_statx_t *stx)
+{
+    bool is_dir;
+    if (flash_lookup(path, &is_dir) < 0) {
+        return -1;
+    }
+    flash_fill(ctx, is_dir, mask, stx);
+    return 0;
+}
@@ -0,0 +1,417 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 操作跟踪测试：记录内容、环形缓冲区覆盖、按线程分配环形缓冲区，以及跟踪的开销。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_osal.h"
+#include "xf_vfs.h"
+#include "xf_vfs_trace.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define DUMP_BUF_SIZE       (8 * 1024)
+#define RECS_MAX            (XF_VFS_TRACE_RING_SIZE * XF_VFS_TRACE_RINGS)
+#define THREADS             3
+#define THREAD_OPS          20
+#define BENCH_ITERATIONS    100000
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct {
+    uint8_t buf[DUMP_BUF_SIZE];
+    size_t len;
+} dump_t;
+
+/* 解析后的导出数据 */
+typedef struct {
+    xf_vfs_trace_header_t header;
+    char ops[XF_VFS_TRACE_OP_MAX][16];
+    char mounts[XF_VFS_MAX_COUNT][XF_VFS_PATH_MAX + 1];
+    xf_vfs_trace_rec_t recs[RECS_MAX];
+    size_t count;
+} trace_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static int null_open(const char *path, int flags, int mode);
+static int null_close(int fd);
+static xf_vfs_ssize_t null_read(int fd, void *dst, size_t size);
+static xf_vfs_dir_t *null_opendir(const char *name);
+static int null_closedir(xf_vfs_dir_t *pdir);
+static int null_fstatat(xf_vfs_dir_t *pdir, const char *name, xf_vfs_stat_t *st);
+
+static xf_vfs_ssize_t dump_to_buf(const void *data, size_t size, void *arg);
+static void dump_and_parse(trace_t *t);
+static void worker(void *argument);
+static void expect_one(uint8_t op, const char *mount);
+
+static void TEST_CASE_trace_records(void);
+static void TEST_CASE_trace_ring_wrap(void);
+static void TEST_CASE_trace_per_thread(void);
+static void TEST_CASE_trace_overhead(void);
+static void TEST_CASE_trace_one_per_call(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static const xf_vfs_dir_ops_t s_null_dir_ops = {
+    .opendir = null_opendir,
+    .closedir = null_closedir,
+    .fstatat = null_fstatat,
+};
+
+static const xf_vfs_fs_ops_t s_null_ops = {
+    .open = null_open,
+    .close = null_close,
+    .read = null_read,
+    .dir = &s_null_dir_ops,
+};
+
+static xf_vfs_dir_t s_null_dir;
+
+static dump_t s_dump;
+static trace_t s_trace;
+static xf_osal_semaphore_t s_done;
+static xf_osal_semaphore_t s_exit;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    TEST_XF_OK(xf_vfs_register_fs("/null", &s_null_ops, XF_VFS_FLAG_STATIC, NULL));
+
+    TEST_CASE_trace_records();
+    TEST_CASE_trace_ring_wrap();
+    TEST_CASE_trace_per_thread();
+    TEST_CASE_trace_overhead();
+    TEST_CASE_trace_one_per_call();
+
+    TEST_XF_OK(xf_vfs_unregister_fs("/null"));
+    return 0;
+}
+
+static void TEST_CASE_trace_records(void)
+{
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+    xf_vfs_trace_clear();
+
+    char buf[16] = "0123456789";
+    int fd = xf_vfs_open("/ram/f", XF_VFS_O_RDWR | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL(10, xf_vfs_write(fd, buf, 10));
+    TEST_ASSERT_EQUAL(0, xf_vfs_lseek(fd, 0, XF_VFS_SEEK_SET));
+    TEST_ASSERT_EQUAL(10, xf_vfs_read(fd, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_open("/ram/missing", XF_VFS_O_RDONLY, 0));
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlink("/ram/f"));
+
+    dump_and_parse(&s_trace);
+    TEST_ASSERT_EQUAL(XF_VFS_TRACE_VERSION, s_trace.header.version);
+    TEST_ASSERT(xf_strcmp(s_trace.ops[XF_VFS_TRACE_OP_PREAD], "pread") == 0);
+
+    static const uint8_t expected_ops[] = {
+        XF_VFS_TRACE_OP_OPEN, XF_VFS_TRACE_OP_WRITE, XF_VFS_TRACE_OP_LSEEK, XF_VFS_TRACE_OP_READ,
+        XF_VFS_TRACE_OP_CLOSE, XF_VFS_TRACE_OP_OPEN, XF_VFS_TRACE_OP_UNLINK,
+    };
+    TEST_ASSERT_EQUAL(sizeof(expected_ops), s_trace.count);
+    for (size_t i = 0; i < s_trace.count; ++i) {
+        const xf_vfs_trace_rec_t *rec = &s_trace.recs[i];
+        TEST_ASSERT_EQUAL(expected_ops[i], rec->op);
+        TEST_ASSERT(xf_strcmp(s_trace.mounts[rec->vfs], "/ram") == 0);
+        TEST_ASSERT(i == 0 || rec->ts >= s_trace.recs[i - 1].ts + s_trace.recs[i - 1].dur);
+    }
+    const xf_vfs_trace_rec_t *rec = s_trace.recs;
+    TEST_ASSERT_EQUAL(fd, rec[0].fd);                       /* open 记录返回的 fd */
+    TEST_ASSERT_EQUAL(fd, rec[0].result);
+    TEST_ASSERT_EQUAL(10, rec[1].size);
+    TEST_ASSERT_EQUAL(10, rec[1].result);
+    TEST_ASSERT_EQUAL(sizeof(buf), rec[3].size);
+    TEST_ASSERT_EQUAL(10, rec[3].result);
+    TEST_ASSERT_EQUAL(fd, rec[4].fd);                       /* close 之后仍能记录挂载点 */
+    TEST_ASSERT_EQUAL(-1, rec[5].result);
+    TEST_ASSERT_EQUAL(ENOENT, rec[5].err);
+    TEST_ASSERT_EQUAL(-1, rec[6].fd);
+    TEST_ASSERT_EQUAL(0, rec[6].err);
+
+    /* 暂停期间不记录 */
+    xf_vfs_trace_clear();
+    xf_vfs_trace_enable(false);
+    TEST_ASSERT_EQUAL(-1, xf_vfs_open("/ram/missing", XF_VFS_O_RDONLY, 0));
+    xf_vfs_trace_enable(true);
+    dump_and_parse(&s_trace);
+    TEST_ASSERT_EQUAL(0, s_trace.count);
+
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 写满后覆盖最早的记录，导出的是最近的 XF_VFS_TRACE_RING_SIZE 条 */
+static void TEST_CASE_trace_ring_wrap(void)
+{
+    xf_vfs_trace_clear();
+    const int total = XF_VFS_TRACE_RING_SIZE * 3 + 5;
+    for (int i = 0; i < total; ++i) {
+        xf_vfs_close(XF_VFS_CUSTOM_FD_SETSIZE - 1 - (i % 10));
+    }
+    dump_and_parse(&s_trace);
+    TEST_ASSERT_EQUAL(XF_VFS_TRACE_RING_SIZE, s_trace.count);
+    for (size_t i = 0; i < s_trace.count; ++i) {
+        const int n = total - XF_VFS_TRACE_RING_SIZE + (int)i;
+        TEST_ASSERT_EQUAL(XF_VFS_TRACE_OP_CLOSE, s_trace.recs[i].op);
+        TEST_ASSERT_EQUAL(XF_VFS_CUSTOM_FD_SETSIZE - 1 - (n % 10), s_trace.recs[i].fd);
+        TEST_ASSERT_EQUAL(EBADF, s_trace.recs[i].err);
+        TEST_ASSERT_EQUAL(XF_VFS_TRACE_VFS_NONE, s_trace.recs[i].vfs);
+    }
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 每个线程写入各自的环形缓冲区 */
+static void TEST_CASE_trace_per_thread(void)
+{
+    const xf_osal_thread_attr_t attr = {
+        .name = "worker",
+        .stack_size = 2048,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    s_done = xf_osal_semaphore_create(THREADS, 0, NULL);
+    s_exit = xf_osal_semaphore_create(THREADS, 0, NULL);
+    TEST_ASSERT(s_done != NULL && s_exit != NULL);
+
+    xf_vfs_trace_clear();
+    for (int i = 0; i < THREADS; ++i) {
+        TEST_ASSERT(xf_osal_thread_create(worker, NULL, &attr) != NULL);
+    }
+    for (int i = 0; i < THREADS; ++i) {
+        xf_osal_semaphore_acquire(s_done, XF_OSAL_WAIT_FOREVER);
+    }
+    /* 所有线程都写完后才让它们退出，保证线程 ID 互不相同 */
+    for (int i = 0; i < THREADS; ++i) {
+        xf_osal_semaphore_release(s_exit);
+    }
+
+    dump_and_parse(&s_trace);
+    TEST_ASSERT_EQUAL(THREADS * THREAD_OPS * 3, s_trace.count);
+    size_t per_ring[XF_VFS_TRACE_RINGS] = { 0 };
+    for (size_t i = 0; i < s_trace.count; ++i) {
+        const xf_vfs_trace_rec_t *rec = &s_trace.recs[i];
+        TEST_ASSERT(rec->ring < XF_VFS_TRACE_RINGS);
+        TEST_ASSERT(xf_strcmp(s_trace.mounts[rec->vfs], "/null") == 0);
+        ++per_ring[rec->ring];
+        /* 同一线程的记录按时间顺序排列 */
+        TEST_ASSERT(i == 0 || rec->ring != rec[-1].ring || rec->ts >= rec[-1].ts);
+    }
+    for (int r = 0; r < THREADS; ++r) {
+        TEST_ASSERT_EQUAL(THREAD_OPS * 3, per_ring[r]);
+    }
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 结果只打印不判定 */
+static void TEST_CASE_trace_overhead(void)
+{
+    char c;
+    int fd = xf_vfs_open("/null/f", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    for (int enabled = 0; enabled <= 1; ++enabled) {
+        xf_vfs_trace_enable(enabled);
+        const uint64_t start = xf_sys_time_get_ns();
+        for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+            xf_vfs_read(fd, &c, 1);
+        }
+        const uint64_t ns = xf_sys_time_get_ns() - start;
+        xf_log_printf("trace %-3s  read: %u ns/op\n", enabled ? "on" : "off", (unsigned)(ns / BENCH_ITERATIONS));
+    }
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 每次调用只写一条记录：内部转调其他入口函数（fstat 转 fstat64、*at 函数的绝对路径等）不重复记录 */
+static void TEST_CASE_trace_one_per_call(void)
+{
+    ramfs_t *fs;
+    TEST_XF_OK(ramfs_mount("/ram", &fs));
+    int fd = xf_vfs_open("/ram/f", XF_VFS_O_RDWR | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    xf_vfs_trace_clear();
+
+    xf_vfs_stat_t st;
+    xf_vfs_stat64_t st64;
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstat(fd, &st));
+    expect_one(XF_VFS_TRACE_OP_FSTAT, "/ram");
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstat64(fd, &st64));
+    expect_one(XF_VFS_TRACE_OP_FSTAT, "/ram");
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    expect_one(XF_VFS_TRACE_OP_CLOSE, "/ram");
+
+    /* 驱动支持 *at 函数，目录句柄持有驱动的目录 */
+    xf_vfs_dirat_t *dir = xf_vfs_dirat_open("/null");
+    TEST_ASSERT(dir != NULL);
+    expect_one(XF_VFS_TRACE_OP_OPENDIR, "/null");
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstatat(dir, "x", &st));
+    expect_one(XF_VFS_TRACE_OP_STAT, "/null");
+
+    /* 绝对路径与 dir 为 NULL 时转为按路径的函数，记录的是路径所在的挂载点 */
+    fd = xf_vfs_openat(dir, "/ram/f", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    expect_one(XF_VFS_TRACE_OP_OPEN, "/ram");
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    expect_one(XF_VFS_TRACE_OP_CLOSE, "/ram");
+    fd = xf_vfs_openat(NULL, "/ram/f", XF_VFS_O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    expect_one(XF_VFS_TRACE_OP_OPEN, "/ram");
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+    expect_one(XF_VFS_TRACE_OP_CLOSE, "/ram");
+    TEST_ASSERT_EQUAL(0, xf_vfs_fstatat(NULL, "/ram/f", &st));
+    expect_one(XF_VFS_TRACE_OP_STAT, "/ram");
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdirat(dir, "/ram/d", 0777));
+    expect_one(XF_VFS_TRACE_OP_MKDIR, "/ram");
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlinkat(NULL, "/ram/d", XF_VFS_AT_REMOVEDIR));
+    expect_one(XF_VFS_TRACE_OP_UNLINK, "/ram");
+    TEST_ASSERT_EQUAL(0, xf_vfs_unlinkat(dir, "/ram/f", 0));
+    expect_one(XF_VFS_TRACE_OP_UNLINK, "/ram");
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_dirat_close(dir));
+    expect_one(XF_VFS_TRACE_OP_CLOSEDIR, "/null");
+
+    TEST_XF_OK(ramfs_unmount("/ram", fs));
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+/* 自上次检查以来只有一条记录，操作与挂载点符合预期 */
+static void expect_one(uint8_t op, const char *mount)
+{
+    dump_and_parse(&s_trace);
+    TEST_ASSERT_EQUAL(1, s_trace.count);
+    TEST_ASSERT_EQUAL(op, s_trace.recs[0].op);
+    TEST_ASSERT(xf_strcmp(s_trace.mounts[s_trace.recs[0].vfs], mount) == 0);
+    xf_vfs_trace_clear();
+}
+
+static void worker(void *argument)
+{
+    char c;
+    for (int i = 0; i < THREAD_OPS; ++i) {
+        int fd = xf_vfs_open("/null/f", XF_VFS_O_RDONLY, 0);
+        xf_vfs_read(fd, &c, 1);
+        xf_vfs_close(fd);
+    }
+    xf_osal_semaphore_release(s_done);
+    xf_osal_semaphore_acquire(s_exit, XF_OSAL_WAIT_FOREVER);
+    xf_osal_thread_delete(NULL);
+}
+
+static xf_vfs_ssize_t dump_to_buf(const void *data, size_t size, void *arg)
+{
+    dump_t *d = (dump_t *)arg;
+    if (d->len + size > sizeof(d->buf)) {
+        return -1;
+    }
+    xf_memcpy(d->buf + d->len, data, size);
+    d->len += size;
+    return (xf_vfs_ssize_t)size;
+}
+
+/* 导出到 s_dump 并按 xf_vfs_trace_header_t 描述的格式解析 */
+static void dump_and_parse(trace_t *t)
+{
+    s_dump.len = 0;
+    const xf_vfs_ssize_t total = xf_vfs_trace_dump(dump_to_buf, &s_dump);
+    TEST_ASSERT_EQUAL((xf_vfs_ssize_t)s_dump.len, total);
+
+    const uint8_t *p = s_dump.buf;
+    xf_memcpy(&t->header, p, sizeof(t->header));
+    p += sizeof(t->header);
+    TEST_ASSERT(xf_memcmp(t->header.magic, XF_VFS_TRACE_MAGIC, 4) == 0);
+    TEST_ASSERT_EQUAL(sizeof(xf_vfs_trace_rec_t), t->header.rec_size);
+    TEST_ASSERT_EQUAL(XF_VFS_TRACE_OP_MAX, t->header.op_count);
+    for (int i = 0; i < t->header.op_count; ++i) {
+        xf_memcpy(t->ops[i], p + 1, p[0]);
+        t->ops[i][p[0]] = '\0';
+        p += 1 + p[0];
+    }
+    xf_memset(t->mounts, 0, sizeof(t->mounts));
+    for (int i = 0; i < t->header.mount_count; ++i) {
+        xf_memcpy(t->mounts[p[0]], p + 2, p[1]);
+        p += 2 + p[1];
+    }
+    t->count = (size_t)(s_dump.buf + s_dump.len - p) / sizeof(xf_vfs_trace_rec_t);
+    TEST_ASSERT(t->count <= RECS_MAX);
+    xf_memcpy(t->recs, p, t->count * sizeof(xf_vfs_trace_rec_t));
+}
+
+static int null_open(const char *path, int flags, int mode)
+{
+    return 0;
+}
+
+static int null_close(int fd)
+{
+    return 0;
+}
+
+static xf_vfs_ssize_t null_read(int fd, void *dst, size_t size)
+{
+    return (xf_vfs_ssize_t)size;
+}
+
+static xf_vfs_dir_t *null_opendir(const char *name)
+{
+    return &s_null_dir;
+}
+
+static int null_closedir(xf_vfs_dir_t *pdir)
+{
+    return 0;
+}
+
+static int null_fstatat(xf_vfs_dir_t *pdir, const char *name, xf_vfs_stat_t *st)
+{
+    xf_memset(st, 0, sizeof(*st));
+    return 0;
+}
@@ -0,0 +1,325 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs_walk() 测试：d_type 免 stat、剪枝、后序、rm -r/mkdir -p/du 及并行遍历。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_utils.h"
+#include "xf_osal.h"
+#include "xf_vfs.h"
+#include "xf_vfs_walk.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "main"
+
+#define SEEN_MAX        RAMFS_NODES_MAX
+#define WIDE_DIRS       4
+#define WIDE_FILES      12
+
+/* ==================== [Typedefs] ========================================== */
+
+/* 按报告顺序记录的目录项 */
+typedef struct {
+    xf_osal_mutex_t lock;
+    int count;
+    xf_vfs_walk_type_t type[SEEN_MAX];
+    char path[SEEN_MAX][RAMFS_PATH_MAX + 8];
+} seen_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void make_file(const char *path, size_t size);
+static void make_tree(void);
+static int record_cb(const xf_vfs_walk_entry_t *ent, xf_vfs_walk_type_t type, void *arg);
+static int prune_cb(const xf_vfs_walk_entry_t *ent, xf_vfs_walk_type_t type, void *arg);
+static int stop_cb(const xf_vfs_walk_entry_t *ent, xf_vfs_walk_type_t type, void *arg);
+static int seen_index(const seen_t *seen, const char *path, xf_vfs_walk_type_t type);
+static int seen_count(const seen_t *seen, xf_vfs_walk_type_t type);
+
+static void TEST_CASE_walk_preorder_uses_d_type(void);
+static void TEST_CASE_walk_prune_and_stop(void);
+static void TEST_CASE_walk_postorder(void);
+static void TEST_CASE_walk_du_mkdir_p_rm_r(void);
+static void TEST_CASE_walk_parallel(void);
+static int test_main(void);
+
+/* ==================== [Static Variables] ================================== */
+
+static ramfs_t *s_fs;
+static seen_t s_seen;
+
+/* ==================== [Macros] ============================================ */
+
+#define TEST_XF_OK(x) \
+    do { \
+        if (x != XF_OK) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(condition) \
+    do { \
+        if (!(condition)) { \
+            xf_log_printf("Test failed at line %d: %s\n", __LINE__, #condition); \
+            while (1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        if ((expected)!=(actual)) { \
+            xf_log_printf("Test failed at line %d\n", __LINE__); \
+            while (1); \
+        } \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+int main(void)
+{
+    return test_main();
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static int test_main(void)
+{
+    s_seen.lock = xf_osal_mutex_create(NULL);
+    TEST_ASSERT(s_seen.lock != NULL);
+    TEST_XF_OK(ramfs_mount("/ram", &s_fs));
+
+    TEST_CASE_walk_preorder_uses_d_type();
+    TEST_CASE_walk_prune_and_stop();
+    TEST_CASE_walk_postorder();
+    TEST_CASE_walk_du_mkdir_p_rm_r();
+    TEST_CASE_walk_parallel();
+
+    TEST_XF_OK(ramfs_unmount("/ram", s_fs));
+    xf_osal_mutex_delete(s_seen.lock);
+    return 0;
+}
+
+/*
+ * /ram
+ * ├── a/
+ * │   ├── f1        3 bytes
+ * │   └── b/
+ * │       ├── f2    5 bytes
+ * │       └── c/
+ * ├── g             10 bytes
+ * └── skip/
+ *     └── x         0 bytes
+ */
+static void make_tree(void)
+{
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ram/a", 0777));
+    make_file("/ram/a/f1", 3);
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ram/a/b", 0777));
+    make_file("/ram/a/b/f2", 5);
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ram/a/b/c", 0777));
+    make_file("/ram/g", 10);
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir("/ram/skip", 0777));
+    make_file("/ram/skip/x", 0);
+}
+
+static void TEST_CASE_walk_preorder_uses_d_type(void)
+{
+    make_tree();
+
+    s_seen.count = 0;
+    uint32_t calls = s_fs->calls;
+    TEST_ASSERT_EQUAL(0, xf_vfs_walk("/ram", record_cb, &s_seen, 0));
+    const uint32_t calls_d_type = s_fs->calls - calls;
+    TEST_ASSERT_EQUAL(9, s_seen.count);
+    TEST_ASSERT_EQUAL(0, seen_index(&s_seen, "/ram", XF_VFS_WALK_D));
+    TEST_ASSERT_EQUAL(5, seen_count(&s_seen, XF_VFS_WALK_D));
+    TEST_ASSERT_EQUAL(4, seen_count(&s_seen, XF_VFS_WALK_F));
+    /* 先序：目录先于其子项报告 */
+    TEST_ASSERT(seen_index(&s_seen, "/ram/a", XF_VFS_WALK_D) < seen_index(&s_seen, "/ram/a/b", XF_VFS_WALK_D));
+    TEST_ASSERT(seen_index(&s_seen, "/ram/a/b", XF_VFS_WALK_D) < seen_index(&s_seen, "/ram/a/b/f2", XF_VFS_WALK_F));
+
+    /* 要求 stat 时每个子项多一次驱动调用，其余完全相同 */
+    s_seen.count = 0;
+    calls = s_fs->calls;
+    TEST_ASSERT_EQUAL(0, xf_vfs_walk("/ram/", record_cb, &s_seen, XF_VFS_WALK_FLAG_STAT));
+    const uint32_t calls_stat = s_fs->calls - calls;
+    TEST_ASSERT_EQUAL(9, s_seen.count);
+    XF_LOGI(TAG, "driver calls: d_type %u, stat %u", (unsigned)calls_d_type, (unsigned)calls_stat);
+    TEST_ASSERT_EQUAL(calls_d_type + 8, calls_stat);
+
+    /* 起点是文件时只报告它自己 */
+    s_seen.count = 0;
+    TEST_ASSERT_EQUAL(0, xf_vfs_walk("/ram/g", record_cb, &s_seen, 0));
+    TEST_ASSERT_EQUAL(1, s_seen.count);
+    TEST_ASSERT_EQUAL(0, seen_index(&s_seen, "/ram/g", XF_VFS_WALK_F));
+
+    TEST_ASSERT_EQUAL(-1, xf_vfs_walk("/ram/none", record_cb, &s_seen, 0));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_walk_prune_and_stop(void)
+{
+    s_seen.count = 0;
+    TEST_ASSERT_EQUAL(0, xf_vfs_walk("/ram", prune_cb, &s_seen, 0));
+    TEST_ASSERT(seen_index(&s_seen, "/ram/skip", XF_VFS_WALK_D) >= 0);
+    TEST_ASSERT(seen_index(&s_seen, "/ram/skip/x", XF_VFS_WALK_F) < 0);
+    TEST_ASSERT_EQUAL(8, s_seen.count);
+
+    s_seen.count = 0;
+    TEST_ASSERT_EQUAL(XF_VFS_WALK_STOP, xf_vfs_walk("/ram", stop_cb, &s_seen, 0));
+    TEST_ASSERT_EQUAL(3, s_seen.count);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_walk_postorder(void)
+{
+    s_seen.count = 0;
+    TEST_ASSERT_EQUAL(0, xf_vfs_walk("/ram", record_cb, &s_seen, XF_VFS_WALK_FLAG_POSTORDER));
+    TEST_ASSERT_EQUAL(5, seen_count(&s_seen, XF_VFS_WALK_DP));
+    TEST_ASSERT_EQUAL(s_seen.count - 1, seen_index(&s_seen, "/ram", XF_VFS_WALK_DP));
+    TEST_ASSERT(seen_index(&s_seen, "/ram/a/b/f2", XF_VFS_WALK_F) < seen_index(&s_seen, "/ram/a/b", XF_VFS_WALK_DP));
+    TEST_ASSERT(seen_index(&s_seen, "/ram/a/b/c", XF_VFS_WALK_DP) < seen_index(&s_seen, "/ram/a/b", XF_VFS_WALK_DP));
+    TEST_ASSERT(seen_index(&s_seen, "/ram/a/b", XF_VFS_WALK_DP) < seen_index(&s_seen, "/ram/a", XF_VFS_WALK_DP));
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_walk_du_mkdir_p_rm_r(void)
+{
+    xf_vfs_du_t du;
+    TEST_ASSERT_EQUAL(0, xf_vfs_du("/ram", &du));
+    TEST_ASSERT_EQUAL(18, du.bytes);
+    TEST_ASSERT_EQUAL(4, du.files);
+    TEST_ASSERT_EQUAL(5, du.dirs);
+
+    /* "/ram" 是挂载点前缀，"/ram/a" 已存在 */
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir_p("/ram/a/p/q//r/", 0777));
+    xf_vfs_stat_t st;
+    TEST_ASSERT_EQUAL(0, xf_vfs_stat("/ram/a/p/q/r", &st));
+    TEST_ASSERT_EQUAL(XF_VFS_S_IFDIR, st.st_mode & XF_VFS_S_IFMT);
+    TEST_ASSERT_EQUAL(0, xf_vfs_mkdir_p("/ram/a/p/q/r", 0777));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_mkdir_p("/ram/g", 0777));
+    TEST_ASSERT_EQUAL(EEXIST, errno);
+    TEST_ASSERT_EQUAL(-1, xf_vfs_mkdir_p("/ram/g/h", 0777));
+
+    TEST_ASSERT_EQUAL(0, xf_vfs_rm_r("/ram/a"));
+    TEST_ASSERT_EQUAL(-1, xf_vfs_stat("/ram/a", &st));
+    TEST_ASSERT_EQUAL(0, xf_vfs_rm_r("/ram/skip"));
+    TEST_ASSERT_EQUAL(0, xf_vfs_rm_r("/ram/g"));
+    TEST_ASSERT_EQUAL(0, xf_vfs_du("/ram", &du));
+    TEST_ASSERT_EQUAL(0, du.bytes);
+    TEST_ASSERT_EQUAL(0, du.files);
+    TEST_ASSERT_EQUAL(1, du.dirs);
+    TEST_ASSERT_EQUAL(-1, xf_vfs_rm_r("/ram/a"));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void TEST_CASE_walk_parallel(void)
+{
+    char path[RAMFS_PATH_MAX];
+    for (int d = 0; d < WIDE_DIRS; ++d) {
+        xf_snprintf(path, sizeof(path), "/ram/d%d", d);
+        TEST_ASSERT_EQUAL(0, xf_vfs_mkdir(path, 0777));
+        for (int f = 0; f < WIDE_FILES; ++f) {
+            xf_snprintf(path, sizeof(path), "/ram/d%d/f%d", d, f);
+            make_file(path, 1);
+        }
+    }
+
+    s_seen.count = 0;
+    TEST_ASSERT_EQUAL(0, xf_vfs_walk_parallel("/ram", record_cb, &s_seen, XF_VFS_WALK_FLAG_POSTORDER, 4));
+    TEST_ASSERT_EQUAL(1 + WIDE_DIRS, seen_count(&s_seen, XF_VFS_WALK_D));
+    TEST_ASSERT_EQUAL(1 + WIDE_DIRS, seen_count(&s_seen, XF_VFS_WALK_DP));
+    TEST_ASSERT_EQUAL(WIDE_DIRS * WIDE_FILES, seen_count(&s_seen, XF_VFS_WALK_F));
+    /* 后序报告仍在该目录的所有子项之后 */
+    TEST_ASSERT_EQUAL(s_seen.count - 1, seen_index(&s_seen, "/ram", XF_VFS_WALK_DP));
+    for (int d = 0; d < WIDE_DIRS; ++d) {
+        xf_snprintf(path, sizeof(path), "/ram/d%d", d);
+        const int dp = seen_index(&s_seen, path, XF_VFS_WALK_DP);
+        TEST_ASSERT(seen_index(&s_seen, path, XF_VFS_WALK_D) < dp);
+        for (int f = 0; f < WIDE_FILES; ++f) {
+            xf_snprintf(path, sizeof(path), "/ram/d%d/f%d", d, f);
+            TEST_ASSERT(seen_index(&s_seen, path, XF_VFS_WALK_F) < dp);
+        }
+    }
+
+    xf_vfs_du_t du;
+    TEST_ASSERT_EQUAL(0, xf_vfs_du("/ram", &du));
+    TEST_ASSERT_EQUAL(WIDE_DIRS * WIDE_FILES, du.bytes);
+    for (int d = 0; d < WIDE_DIRS; ++d) {
+        xf_snprintf(path, sizeof(path), "/ram/d%d", d);
+        TEST_ASSERT_EQUAL(0, xf_vfs_rm_r(path));
+    }
+
+    XF_LOGI(TAG, "%s passed", __FUNCTION__);
+}
+
+static void make_file(const char *path, size_t size)
+{
+    static const char s_data[16] = "0123456789abcdef";
+    int fd = xf_vfs_open(path, XF_VFS_O_WRONLY | XF_VFS_O_CREAT, 0666);
+    TEST_ASSERT(fd >= 0);
+    TEST_ASSERT_EQUAL((xf_vfs_ssize_t)size, xf_vfs_write(fd, s_data, size));
+    TEST_ASSERT_EQUAL(0, xf_vfs_close(fd));
+}
+
+/* 回调可能在多个线程中调用 */
+static int record_cb(const xf_vfs_walk_entry_t *ent, xf_vfs_walk_type_t type, void *arg)
+{
+    seen_t *seen = (seen_t *)arg;
+    xf_osal_mutex_acquire(seen->lock, XF_OSAL_WAIT_FOREVER);
+    TEST_ASSERT(seen->count < SEEN_MAX);
+    TEST_ASSERT(xf_strlen(ent->path) < sizeof(seen->path[0]));
+    TEST_ASSERT(ent->base == 0 || ent->path[ent->base - 1] == '/');
+    seen->type[seen->count] = type;
+    xf_memcpy(seen->path[seen->count], ent->path, xf_strlen(ent->path) + 1);
+    ++seen->count;
+    xf_osal_mutex_release(seen->lock);
+    return XF_VFS_WALK_CONTINUE;
+}
+
+static int prune_cb(const xf_vfs_walk_entry_t *ent, xf_vfs_walk_type_t type, void *arg)
+{
+    record_cb(ent, type, arg);
+    return (xf_strcmp(ent->path + ent->base, "skip") == 0) ? XF_VFS_WALK_PRUNE : XF_VFS_WALK_CONTINUE;
+}
+
+static int stop_cb(const xf_vfs_walk_entry_t *ent, xf_vfs_walk_type_t type, void *arg)
+{
+    record_cb(ent, type, arg);
+    return (((seen_t *)arg)->count == 3) ? XF_VFS_WALK_STOP : XF_VFS_WALK_CONTINUE;
+}
+
+static int seen_index(const seen_t *seen, const char *path, xf_vfs_walk_type_t type)
+{
+    for (int i = 0; i < seen->count; ++i) {
+        if (seen->type[i] == type && xf_strcmp(seen->path[i], path) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int seen_count(const seen_t *seen, xf_vfs_walk_type_t type)
+{
+    int n = 0;
+    for (int i = 0; i < seen->count; ++i) {
+        n += (seen->type[i] == type);
+    }
+    return n;
+}
@@ -28,10 +28,16 @@
 
 #include "xf_vfs.h"
 #include "xf_vfs_private.h"
+#include "xf_vfs_trace.h"
+
+#if XF_VFS_STATIC_MOUNTS_IS_ENABLE && defined(XF_VFS_STATIC_MOUNTS_HEADER)
+#include XF_VFS_STATIC_MOUNTS_HEADER
+#endif
 
 /* ==================== [Defines] =========================================== */
 
-#define FD_TABLE_ENTRY_UNUSED   (fd_table_t) { .permanent = false, .has_pending_close = false, .has_pending_select = false, .vfs_index = -1, .local_fd = -1 }
+#define FD_TABLE_ENTRY_UNUSED   (fd_table_t) { .permanent = false, .has_pending_close = false, .has_pending_select = false, .vfs_index = -1, .local_fd = -1, .file_index = FILE_INDEX_NONE }
+#define FILE_INDEX_NONE         ((file_index_t) -1)
 
 #if !defined(STATIC_ASSERT)
 #   define STATIC_ASSERT(EXPR, ...)     extern char (*_do_assert(void)) [sizeof(char[1 - 2*!(EXPR)])]
@@ -40,8 +46,99 @@
 #define _lock_acquire(lock)             xf_lock_lock(lock)
 #define _lock_release(lock)             xf_lock_unlock(lock)
 
-#if !defined(xf_strncpy)
-#   define xf_strncpy(dst, src, len)    strncpy((dst), (src), (len))
+/* fd 表按连续区间分片，每个分片由各自的锁保护 */
+#define FD_SHARD_COUNT          (XF_VFS_FD_LOCK_SHARDS)
+#define FD_SHARD_SIZE           ((XF_VFS_FDS_MAX + FD_SHARD_COUNT - 1) / FD_SHARD_COUNT)
+#define FD_SHARD(fd)            ((fd) / FD_SHARD_SIZE)
+#define FD_SHARD_BEGIN(shard)   ((shard) * FD_SHARD_SIZE)
+#define FD_SHARD_END(shard)     (((shard) + 1) * FD_SHARD_SIZE < XF_VFS_FDS_MAX \
+                                 ? ((shard) + 1) * FD_SHARD_SIZE : XF_VFS_FDS_MAX)
+
+#if (FD_SHARD_COUNT > 1) && (defined(__GNUC__) || defined(__clang__))
+#   define FD_SHARD_ALIGNED     __attribute__((aligned(XF_VFS_CACHE_LINE_SIZE)))
+#else
+#   define FD_SHARD_ALIGNED
+#endif
+
+#define XF_VFS_PREFIX_HASH_INIT         (2166136261u)
+
+/*
+ * 内部结构的分配与释放。
+ * 无堆模式下从各自的固定内存池中分配，否则使用 xf_vfs_malloc()，pool 参数被忽略。
+ */
+#if XF_VFS_NO_HEAP_IS_ENABLE
+#   define VFS_ALLOC(pool, size)        xf_vfs_pool_alloc(&(pool), (size))
+#   define VFS_FREE(pool, ptr)          xf_vfs_pool_free(&(pool), (ptr))
+#else
+#   define VFS_ALLOC(pool, size)        xf_vfs_malloc(size)
+#   define VFS_FREE(pool, ptr)          xf_vfs_free(ptr)
+#endif
+
+/* select 的临时数据，无堆模式下位于栈上 */
+#if XF_VFS_NO_HEAP_IS_ENABLE
+#   define SELECT_FREE(ptr)             do {} while (0)
+#else
+#   define SELECT_FREE(ptr)             xf_vfs_free(ptr)
+#endif
+
+#if XF_VFS_STATIC_MOUNTS_IS_ENABLE
+/*
+ * 在编译期对字符串字面量 s 计算与 prefix_hash_step() 相同的哈希，最多 STATIC_PREFIX_MAX 个字符。
+ * 超出长度的位置取到 s 结尾的 '\0'，异或 0 再乘 1 不改变哈希。
+ */
+#define STATIC_PREFIX_MAX               (64)
+#define STATIC_PREFIX_CHAR(s, i)        ((uint8_t)(s)[((i) < sizeof(s)) ? (i) : (sizeof(s) - 1)])
+#define STATIC_PREFIX_STEP(h, s, i)     (((h) ^ STATIC_PREFIX_CHAR(s, i)) * (((i) < sizeof(s) - 1) ? 16777619u : 1u))
+#define STATIC_PREFIX_HASH4(h, s, i)    STATIC_PREFIX_STEP(STATIC_PREFIX_STEP(STATIC_PREFIX_STEP( \
+                                        STATIC_PREFIX_STEP(h, s, i), s, (i) + 1), s, (i) + 2), s, (i) + 3)
+#define STATIC_PREFIX_HASH16(h, s, i)   STATIC_PREFIX_HASH4(STATIC_PREFIX_HASH4(STATIC_PREFIX_HASH4( \
+                                        STATIC_PREFIX_HASH4(h, s, i), s, (i) + 4), s, (i) + 8), s, (i) + 12)
+#define STATIC_PREFIX_HASH(s)           STATIC_PREFIX_HASH16(STATIC_PREFIX_HASH16(STATIC_PREFIX_HASH16( \
+                                        STATIC_PREFIX_HASH16(XF_VFS_PREFIX_HASH_INIT, s, 0), s, 16), s, 32), s, 48)
+
+#define STATIC_MOUNT_CHECK(name, prefix, ops, flags, ctx) \
+    STATIC_ASSERT(sizeof(prefix) - 1 <= STATIC_PREFIX_MAX && sizeof(prefix) - 1 <= XF_VFS_PATH_MAX \
+                  && sizeof(prefix) != 2, "invalid static mount prefix"); \
+    STATIC_ASSERT(!((flags) & (XF_VFS_FLAG_SERIAL_FILE | XF_VFS_FLAG_SERIAL_MOUNT | XF_VFS_FLAG_EXECUTOR)), \
+                  "static mounts can not be serialized");
+#define STATIC_MOUNT_ENTRY(name, prefix, ops, mount_flags, mount_ctx) \
+    [XF_VFS_STATIC_ID_##name] = { \
+        .flags = (mount_flags), \
+        .vfs = &(ops), \
+        .path_prefix = (prefix), \
+        .path_prefix_len = sizeof(prefix) - 1, \
+        .path_prefix_hash = STATIC_PREFIX_HASH(prefix), \
+        .ctx = (mount_ctx), \
+        .offset = XF_VFS_STATIC_ID_##name, \
+    },
+#define STATIC_MOUNT_SLOT(name, prefix, ops, flags, ctx) \
+    [XF_VFS_STATIC_ID_##name] = &s_static_vfs[XF_VFS_STATIC_ID_##name],
+#endif
+
+/* xf_vfs_fs_ops_t 中函数指针部分的大小（不含子组件指针） */
+#define FS_OPS_FN_SIZE  (offsetof(xf_vfs_fs_ops_t, fstatx) + sizeof(((xf_vfs_fs_ops_t *)0)->fstatx))
+
+/* xf_vfs_off_t（long）能表示的范围 */
+#define OFF_MAX                 ((xf_vfs_off64_t)((~(unsigned long)0) >> 1))
+
+/* 由 VFS 串行化驱动调用的挂载点标志 */
+#define SERIAL_FLAGS            (XF_VFS_FLAG_SERIAL_FILE | XF_VFS_FLAG_SERIAL_MOUNT)
+#define OFF_FITS(off)           (((off) <= OFF_MAX) && ((off) >= -OFF_MAX - 1))
+
+/*
+ * 开启跟踪（XF_VFS_TRACE_ENABLE）时，入口函数的实现改名为 traced_xxx 并成为静态函数，
+ * 由 [Trace] 一节中的同名包装函数计时并写入跟踪记录。
+ */
+#if XF_VFS_TRACE_IS_ENABLE
+#   define TRACED_STATIC                static
+#   define TRACED(func)                 traced_##func
+#else
+#   define TRACED_STATIC
+#   define TRACED(func)                 func
+#endif
+
+#if !defined(EOVERFLOW)
+#   define EOVERFLOW            EFBIG
 #endif
 
 /* ==================== [Typedefs] ========================================== */
@@ -55,6 +152,22 @@
 typedef _LOCAL_FD_T_ local_fd_t;
 STATIC_ASSERT((1 << (sizeof(local_fd_t) * 8)) >= XF_VFS_FDS_MAX, "file descriptor type too small");
 
+/* 打开文件描述下标，全 1 值保留给 FILE_INDEX_NONE，因此必须严格大于 XF_VFS_FDS_MAX */
+#if ((1 << (1 /* byte */ * 8)) > XF_VFS_FDS_MAX)
+#   define _FILE_INDEX_T_   uint8_t
+#else
+#   define _FILE_INDEX_T_   uint16_t
+#endif
+
+typedef _FILE_INDEX_T_ file_index_t;
+STATIC_ASSERT((1 << (sizeof(file_index_t) * 8)) > XF_VFS_FDS_MAX, "file index type too small");
+
+STATIC_ASSERT(sizeof(xf_vfs_off_t) == sizeof(long), "OFF_MAX assumes xf_vfs_off_t is long");
+
+STATIC_ASSERT(XF_VFS_FD_LOCK_SHARDS >= 1 && XF_VFS_FD_LOCK_SHARDS <= XF_VFS_FDS_MAX, "invalid fd lock shard count");
+
+STATIC_ASSERT(XF_VFS_APPEND_LOCKS >= 1 && XF_VFS_APPEND_LOCKS <= 256, "invalid XF_VFS_APPEND_LOCKS");
+
 typedef int8_t vfs_index_t;
 STATIC_ASSERT((1 << (sizeof(vfs_index_t) * 8)) >= XF_VFS_MAX_COUNT, "VFS index type too small");
 STATIC_ASSERT(((vfs_index_t) -1) < 0, "vfs_index_t must be a signed type");
@@ -66,15 +179,75 @@ typedef struct {
     uint8_t _reserved : 5;
     vfs_index_t vfs_index;
     local_fd_t local_fd;
+    file_index_t file_index;    /*!< s_file_table 下标，永久 fd 未被复制时为 FILE_INDEX_NONE */
 } fd_table_t;
 
+/**
+ * 打开文件描述（open file description）。
+ * 由 xf_vfs_dup() 等复制出的 fd 共享同一个打开文件描述，
+ * 最后一个引用它的 fd 关闭时才调用驱动的 close.
+ */
+typedef struct {
+    uint16_t refcnt;            /*!< 引用此打开文件描述的 fd 数，0 表示未使用，原子访问 */
+    vfs_index_t vfs_index;
+    local_fd_t local_fd;
+    int flags;                  /*!< 打开时的 flags */
+    uint8_t append_lock;        /*!< XF_VFS_FLAG_VFS_OFFSET 时 O_APPEND 写入使用的 s_append_locks 下标 */
+    xf_vfs_off64_t offset;      /*!< XF_VFS_FLAG_VFS_OFFSET 时由 VFS 维护的文件偏移，原子访问 */
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    void *handle;               /*!< XF_VFS_FLAG_HANDLE 时驱动 open 返回的句柄 */
+#endif
+} file_table_t;
+
+/**
+ * fd 表分片的锁。
+ * 多于一个分片时每个分片独占一个缓存行，避免不同分片的锁之间伪共享。
+ */
+typedef union {
+    xf_lock_t lock;
+#if FD_SHARD_COUNT > 1
+    uint8_t _pad[XF_VFS_CACHE_LINE_SIZE];
+#endif
+} fd_shard_t;
+
 typedef struct {
     bool isset; // none or at least one bit is set in the following 3 fd sets
+    bool is_socket; // socket VFS, the 3 fd sets hold its global FDs for socket_select
     xf_fd_set readfds;
     xf_fd_set writefds;
     xf_fd_set errorfds;
 } fds_triple_t;
 
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+/* 一次 select 涉及多个 socket 类 VFS 时，交给等待线程的一次 socket_select */
+typedef struct {
+    struct _select_waiter_t *waiter;
+    fds_triple_t *fds;              /*!< 输入为要等待的 fd，输出为就绪的 fd */
+    int nfds;
+    bool has_timeout;
+    xf_vfs_timeval_t timeout;
+    int ret;
+    int err;
+    xf_osal_semaphore_t wake;       /*!< select 共同的通知信号量 */
+    xf_osal_semaphore_t sync;       /*!< 等待线程取走任务后及完成后各释放一次 */
+    xf_osal_semaphore_t stopped;    /*!< 所有 socket_select 都已被停止后释放 */
+} select_socket_t;
+
+/*
+ * socket 类 VFS 的常驻等待线程，第一次需要时创建，之后在各次 select 之间复用。
+ * socket_select 在调用线程的信号量上等待，因此一个线程只服务一次注册的一个 VFS.
+ */
+typedef struct _select_waiter_t {
+    struct _select_waiter_t *next;  /*!< 空闲链表 */
+    int vfs_index;
+    uint32_t generation;            /*!< 创建时 s_select_generation[vfs_index] 的值 */
+    const xf_vfs_select_ops_t *ops;
+    void *sem;                      /*!< 本线程的 socket 信号量，stop_socket_select 用 */
+    xf_osal_semaphore_t go;         /*!< 派发任务，job 为 NULL 时线程退出 */
+    select_socket_t *job;
+} select_waiter_t;
+#endif
+
 typedef struct {
 #if XF_VFS_SUPPORT_DIR_IS_ENABLE
     xf_vfs_dir_ops_t *dir;
@@ -82,33 +255,215 @@ typedef struct {
 #if XF_VFS_SUPPORT_SELECT_IS_ENABLE
     xf_vfs_select_ops_t *select;
 #endif
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    xf_vfs_handle_ops_t *handle;
+#endif
 } vfs_component_proxy_t;
 
+/**
+ * 驻留（interned）的操作表。
+ * 内容相同的非静态操作表只保存一份，由引用它的挂载点共享。
+ * 内存布局：[ops_intern_t][dir][select][handle]，子组件仅在驱动提供时存在。
+ */
+typedef struct _ops_intern_t {
+    struct _ops_intern_t *next;
+    uint32_t refcnt;
+    uint32_t hash;
+    xf_vfs_fs_ops_t fs;         /*!< 必须位于末尾，子组件紧随其后 */
+} ops_intern_t;
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+/* xf_vfs_dirat_open() 返回的目录句柄 */
+struct xf_vfs_dirat {
+    int vfs_index;
+    xf_vfs_dir_t *pdir;         /*!< 驱动实现 *at 函数时由 opendir 打开的目录，否则为 NULL */
+    size_t len;                 /*!< path 的长度 */
+    char path[];                /*!< 目录在挂载点内的路径 */
+};
+#endif
+
+/* xf_vfs_path_prepare() 返回的路径句柄 */
+struct xf_vfs_path {
+    uint32_t generation;        /*!< 解析时的 s_vfs_generation */
+    int vfs_index;              /*!< 解析结果，没有匹配的挂载点时为 -1 */
+    const char *path_within_vfs; /*!< 指向 path 中挂载点前缀之后的部分或 "/" */
+    size_t len;                 /*!< path 的长度 */
+    char path[];                /*!< 完整路径 */
+};
+
+#if XF_VFS_NO_HEAP_IS_ENABLE
+/* 驱动函数表副本的最大大小：所有子组件都存在时 */
+#define OPS_INTERN_MAX_SIZE     (offsetof(ops_intern_t, fs) + sizeof(xf_vfs_fs_ops_t) \
+                                 + OPS_INTERN_DIR_SIZE + OPS_INTERN_SELECT_SIZE + OPS_INTERN_HANDLE_SIZE)
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+#   define OPS_INTERN_DIR_SIZE      sizeof(xf_vfs_dir_ops_t)
+#else
+#   define OPS_INTERN_DIR_SIZE      0
+#endif
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+#   define OPS_INTERN_SELECT_SIZE   sizeof(xf_vfs_select_ops_t)
+#else
+#   define OPS_INTERN_SELECT_SIZE   0
+#endif
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+#   define OPS_INTERN_HANDLE_SIZE   sizeof(xf_vfs_handle_ops_t)
+#else
+#   define OPS_INTERN_HANDLE_SIZE   0
+#endif
+#endif
+
 /* ==================== [Static Prototypes] ================================= */
 
 static xf_vfs_ssize_t xf_get_free_index(void);
-static void xf_vfs_free_fs_ops(xf_vfs_fs_ops_t *vfs);
 static void xf_vfs_free_entry(xf_vfs_entry_t *entry);
-static xf_vfs_fs_ops_t *xf_minify_vfs(const xf_vfs_t *const vfs, vfs_component_proxy_t proxy);
-static void free_proxy_members(vfs_component_proxy_t *proxy);
-static xf_vfs_fs_ops_t *xf_vfs_duplicate_fs_ops(const xf_vfs_fs_ops_t *orig);
-static xf_err_t xf_vfs_make_fs_ops(const xf_vfs_t *vfs, xf_vfs_fs_ops_t **min);
+static const xf_vfs_entry_t *path_resolve(xf_vfs_path_t *p);
+static int vfs_open(const xf_vfs_entry_t *vfs, const char *path_within_vfs, int flags, int mode);
+static xf_vfs_ssize_t vfs_write(const xf_vfs_entry_t *vfs, int fd, int local_fd, const void *data, size_t size);
+static xf_vfs_ssize_t vfs_read(const xf_vfs_entry_t *vfs, int fd, int local_fd, void *dst, size_t size);
+static int vfs_fsync(const xf_vfs_entry_t *vfs, int fd, int local_fd);
+static xf_vfs_ssize_t vfs_pwrite(const xf_vfs_entry_t *vfs, int fd, int local_fd,
+                                 const void *src, size_t size, xf_vfs_off64_t offset);
+static void xf_minify_vfs(const xf_vfs_t *const vfs, vfs_component_proxy_t proxy, xf_vfs_fs_ops_t *out);
+static size_t xf_vfs_fs_ops_size(const xf_vfs_fs_ops_t *orig);
+static xf_vfs_fs_ops_t *xf_vfs_copy_fs_ops(const xf_vfs_fs_ops_t *orig, uint8_t *mem);
+static xf_err_t xf_vfs_make_fs_ops(const xf_vfs_t *vfs, vfs_component_proxy_t proxy, xf_vfs_fs_ops_t *min);
+static void prefix_len_max_refresh(void);
+static inline uint32_t prefix_hash_step(uint32_t hash, char c);
+static uint32_t ops_hash_bytes(uint32_t hash, const void *data, size_t size);
+static uint32_t ops_hash(const xf_vfs_fs_ops_t *ops);
+static bool ops_equal(const xf_vfs_fs_ops_t *a, const xf_vfs_fs_ops_t *b);
+static const xf_vfs_fs_ops_t *xf_vfs_intern_fs_ops(const xf_vfs_fs_ops_t *vfs);
+static void xf_vfs_release_fs_ops(const xf_vfs_fs_ops_t *vfs);
 static xf_err_t xf_vfs_register_fs_common(
     const char *base_path, size_t len, const xf_vfs_fs_ops_t *vfs, int flags, void *ctx, int *vfs_index);
 static inline bool fd_valid(int fd);
 static const xf_vfs_entry_t *get_vfs_for_fd(int fd);
 static inline int get_local_fd(const xf_vfs_entry_t *vfs, int fd);
 static const char *translate_path(const xf_vfs_entry_t *vfs, const char *src_path);
+static void fd_table_lock_init(void);
+static inline void fd_shard_lock(int shard);
+static inline void fd_shard_unlock(int shard);
+static void fd_shard_lock_pair(int shard, int shard2);
+static void fd_shard_unlock_pair(int shard, int shard2);
+static void fd_table_lock_all(void);
+static void fd_table_unlock_all(void);
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+static void fd_table_close_handles(const xf_vfs_entry_t *vfs);
+#endif
+static inline int fd_shard_hint(void);
+static int file_table_alloc(int start, int vfs_index, int local_fd);
+static bool file_table_put(int file_index);
+static void fd_table_set(int fd, bool permanent, int vfs_index, int local_fd, int file_index);
+static bool fd_table_release(int fd);
+static int fd_table_share(int fd, int newfd);
+static int dup_from(int fd, int min_fd);
+static int drv_open(const xf_vfs_entry_t *vfs, const char *path_within_vfs, int flags, int mode, void **handle);
+static int fd_install(const xf_vfs_entry_t *vfs, int fd_within_vfs, void *handle, int flags, uint8_t append_lock);
+static uint8_t append_lock_index(const xf_vfs_entry_t *vfs, int flags, const char *path, size_t len, const char *name);
+static inline file_table_t *get_file_for_fd(const xf_vfs_entry_t *vfs, int fd);
+static inline void *get_handle_for_fd(int fd);
+static inline void *get_file_handle(const file_table_t *file);
+static void stat_to_stat64(const xf_vfs_stat_t *src, xf_vfs_stat64_t *dst);
+static int stat64_to_stat(const xf_vfs_stat64_t *src, xf_vfs_stat_t *dst);
+static void stat64_to_statx(const xf_vfs_stat64_t *src, xf_vfs_statx_t *dst);
+static xf_vfs_off64_t drv_lseek64(const xf_vfs_entry_t *vfs, void *h, int local_fd,
+                                  xf_vfs_off64_t offset, int mode);
+static xf_vfs_ssize_t drv_pread64(const xf_vfs_entry_t *vfs, void *h, int local_fd,
+                                  void *dst, size_t size, xf_vfs_off64_t offset);
+static xf_vfs_ssize_t drv_pwrite64(const xf_vfs_entry_t *vfs, void *h, int local_fd,
+                                   const void *src, size_t size, xf_vfs_off64_t offset);
+static int drv_fstat64(const xf_vfs_entry_t *vfs, void *h, int local_fd, xf_vfs_stat64_t *st);
+static int drv_fstatx(const xf_vfs_entry_t *vfs, void *h, int local_fd, uint32_t mask, xf_vfs_statx_t *stx);
+static int drv_fsize64(const xf_vfs_entry_t *vfs, void *h, int local_fd, xf_vfs_off64_t *size);
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+static int drv_ftruncate64(const xf_vfs_entry_t *vfs, void *h, int local_fd, xf_vfs_off64_t length);
+static xf_vfs_ssize_t getdents_readdir(const xf_vfs_entry_t *vfs, xf_vfs_dir_t *pdir, uint8_t *buf, size_t len);
+static int drv_statx(const xf_vfs_entry_t *vfs, const char *path_within_vfs, uint32_t mask, xf_vfs_statx_t *stx);
+static bool dirat_has_at_ops(const xf_vfs_entry_t *vfs);
+static const xf_vfs_entry_t *dirat_get_vfs(const xf_vfs_dirat_t *dir, const char *name);
+static int dirat_join(const xf_vfs_dirat_t *dir, const char *name, char *buf);
+#endif
+static xf_vfs_ssize_t offset_read(const xf_vfs_entry_t *vfs, file_table_t *file, int local_fd,
+                                  void *dst, size_t size);
+static xf_vfs_ssize_t offset_write(const xf_vfs_entry_t *vfs, file_table_t *file, int local_fd,
+                                   const void *data, size_t size);
+static xf_vfs_off64_t offset_lseek(const xf_vfs_entry_t *vfs, file_table_t *file, int local_fd,
+                                   xf_vfs_off64_t offset, int mode);
+static int vfs_ioctl(int fd, int cmd, va_list args);
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+static select_waiter_t *select_waiter_take(int vfs_index, const xf_vfs_select_ops_t *ops);
+static bool select_waiter_put(select_waiter_t *w);
+static void select_waiter_exit(select_waiter_t *w);
+static void select_waiters_forget(int vfs_index);
+#endif
+#if XF_VFS_TRACE_IS_ENABLE
+static int trace_fd_vfs(int fd);
+static int trace_path_vfs(const char *path);
+static int trace_path_p_vfs(xf_vfs_path_t *p);
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+static int trace_dir_vfs(const xf_vfs_dir_t *pdir);
+static int trace_dirat_vfs(const xf_vfs_dirat_t *dir, const char *name);
+#endif
+#endif
 
 /* ==================== [Static Variables] ================================== */
 
 static const char *const TAG = "xf_vfs";
 
+#if XF_VFS_STATIC_MOUNTS_IS_ENABLE
+XF_VFS_STATIC_MOUNTS(STATIC_MOUNT_CHECK)
+
+/* 编译期挂载点，s_vfs 的前 XF_VFS_STATIC_MOUNT_COUNT 项指向这里 */
+static xf_vfs_entry_t s_static_vfs[XF_VFS_STATIC_MOUNT_COUNT] = {
+    XF_VFS_STATIC_MOUNTS(STATIC_MOUNT_ENTRY)
+};
+
+static xf_vfs_entry_t *s_vfs[XF_VFS_MAX_COUNT] = {
+    XF_VFS_STATIC_MOUNTS(STATIC_MOUNT_SLOT)
+};
+static size_t s_vfs_count = XF_VFS_STATIC_MOUNT_COUNT;
+/* 编译期挂载点只知道上界，第一次注册或注销后变为精确值 */
+static size_t s_vfs_prefix_len_max = STATIC_PREFIX_MAX;
+#else
 static xf_vfs_entry_t *s_vfs[XF_VFS_MAX_COUNT] = { 0 };
 static size_t s_vfs_count = 0;
+/* 已注册挂载点中最长的 path_prefix_len，路径查找不必越过这个长度 */
+static size_t s_vfs_prefix_len_max = 0;
+#endif
+/* 挂载表每次变化时加一，路径句柄据此判断缓存的解析结果是否有效 */
+static uint32_t s_vfs_generation = 0;
+
+static ops_intern_t *s_ops_intern = NULL;
+
+#if XF_VFS_NO_HEAP_IS_ENABLE
+XF_VFS_POOL_DEFINE(s_entry_pool, sizeof(xf_vfs_entry_t) + XF_VFS_PATH_MAX + 1, XF_VFS_MAX_COUNT);
+XF_VFS_POOL_DEFINE(s_ops_pool, OPS_INTERN_MAX_SIZE, XF_VFS_MAX_COUNT);
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+XF_VFS_POOL_DEFINE(s_dirat_pool, sizeof(xf_vfs_dirat_t) + XF_VFS_AT_PATH_MAX, XF_VFS_POOL_DIRAT_COUNT);
+#endif
+XF_VFS_POOL_DEFINE(s_path_pool, sizeof(xf_vfs_path_t) + XF_VFS_AT_PATH_MAX, XF_VFS_POOL_PATH_COUNT);
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+XF_VFS_POOL_DEFINE(s_waiter_pool, sizeof(select_waiter_t), XF_VFS_POOL_SELECT_WAITER_COUNT);
+#endif
+#endif
 
 static fd_table_t s_fd_table[XF_VFS_FDS_MAX] = { [0 ... XF_VFS_FDS_MAX - 1] = FD_TABLE_ENTRY_UNUSED };
-static xf_lock_t s_fd_table_lock;
+static fd_shard_t s_fd_shards[FD_SHARD_COUNT] FD_SHARD_ALIGNED;
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+/* 各 socket 类 VFS 空闲的等待线程 */
+static select_waiter_t *s_select_waiters[XF_VFS_MAX_COUNT];
+/* 各 VFS 编号的注册代数，注销时加一；驱动函数表可能被释放后在同一地址重新分配，因此不按函数表区分 */
+static uint32_t s_select_generation[XF_VFS_MAX_COUNT];
+static xf_lock_t s_select_waiter_lock;
+#endif
+/*
+ * XF_VFS_FLAG_VFS_OFFSET 的 O_APPEND 写入在锁内取文件大小并写入。锁按挂载点与打开时的路径散列，
+ * 同一文件分别 open 的 fd 使用同一把锁，无关的文件只在散列冲突时互相等待。
+ */
+static xf_lock_t s_append_locks[XF_VFS_APPEND_LOCKS];
+
+/* 每个打开文件描述至少被一个 fd 引用，因此数量不会超过 XF_VFS_FDS_MAX */
+static file_table_t s_file_table[XF_VFS_FDS_MAX] = { 0 };
 
 /* ==================== [Macros] ============================================ */
 
@@ -116,38 +471,19 @@ static xf_lock_t s_fd_table_lock;
 
 xf_err_t xf_vfs_register_fs(const char *base_path, const xf_vfs_fs_ops_t *vfs, int flags, void *ctx)
 {
-    if (s_fd_table_lock == NULL) {
-        xf_lock_init(&s_fd_table_lock);
-    }
+    fd_table_lock_init();
 
     if (vfs == NULL) {
         XF_LOGE(TAG, "VFS is NULL");
         return XF_ERR_INVALID_ARG;
     }
 
-    if ((flags & XF_VFS_FLAG_STATIC)) {
-        return xf_vfs_register_fs_common(base_path, xf_strlen(base_path), vfs, flags, ctx, NULL);
-    }
-
-    xf_vfs_fs_ops_t *_vfs = xf_vfs_duplicate_fs_ops(vfs);
-    if (_vfs == NULL) {
-        return XF_ERR_NO_MEM;
-    }
-
-    xf_err_t ret = xf_vfs_register_fs_common(base_path, xf_strlen(base_path), _vfs, flags, ctx, NULL);
-    if (ret != XF_OK) {
-        xf_vfs_free_fs_ops(_vfs);
-        return ret;
-    }
-
-    return XF_OK;
+    return xf_vfs_register_fs_common(base_path, xf_strlen(base_path), vfs, flags, ctx, NULL);
 }
 
 xf_err_t xf_vfs_register_common(const char *base_path, size_t len, const xf_vfs_t *vfs, void *ctx, int *vfs_index)
 {
-    if (s_fd_table_lock == NULL) {
-        xf_lock_init(&s_fd_table_lock);
-    }
+    fd_table_lock_init();
 
     if (vfs == NULL) {
         XF_LOGE(TAG, "VFS is NULL");
@@ -159,19 +495,28 @@ xf_err_t xf_vfs_register_common(const char *base_path, size_t len, const xf_vfs_
         return XF_ERR_INVALID_ARG;
     }
 
-    xf_vfs_fs_ops_t *_vfs = NULL;
-    xf_err_t ret = xf_vfs_make_fs_ops(vfs, &_vfs);
-    if (ret != XF_OK) {
-        return ret;
-    }
-
-    ret = xf_vfs_register_fs_common(base_path, len, _vfs, vfs->flags, ctx, vfs_index);
+    /* 先在栈上转换为 xf_vfs_fs_ops_t，注册时再复制到挂载点的内存块中 */
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    xf_vfs_dir_ops_t dir;
+#endif
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+    xf_vfs_select_ops_t select;
+#endif
+    vfs_component_proxy_t proxy = {
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+        .dir = &dir,
+#endif
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+        .select = &select,
+#endif
+    };
+    xf_vfs_fs_ops_t min;
+    xf_err_t ret = xf_vfs_make_fs_ops(vfs, proxy, &min);
     if (ret != XF_OK) {
-        xf_vfs_free_fs_ops(_vfs);
         return ret;
     }
 
-    return XF_OK;
+    return xf_vfs_register_fs_common(base_path, len, &min, vfs->flags, ctx, vfs_index);
 }
 
 xf_err_t xf_vfs_register(const char *base_path, const xf_vfs_t *vfs, void *ctx)
@@ -191,25 +536,26 @@ xf_err_t xf_vfs_register_fd_range(const xf_vfs_t *vfs, void *ctx, int min_fd, in
     xf_err_t ret = xf_vfs_register_common("", XF_VFS_PATH_PREFIX_LEN_IGNORED, vfs, ctx, &index);
 
     if (ret == XF_OK) {
-        _lock_acquire(s_fd_table_lock);
+        fd_table_lock_all();
         for (int i = min_fd; i < max_fd; ++i) {
             if (s_fd_table[i].vfs_index != -1) {
-                xf_free(s_vfs[index]);
+                xf_vfs_free_entry(s_vfs[index]);
                 s_vfs[index] = NULL;
+#if XF_VFS_SUPPORT_SERIAL_IS_ENABLE
+                xf_vfs_serial_detach(index);
+#endif
                 for (int j = min_fd; j < i; ++j) {
                     if (s_fd_table[j].vfs_index == index) {
-                        s_fd_table[j] = FD_TABLE_ENTRY_UNUSED;
+                        fd_table_release(j);
                     }
                 }
-                _lock_release(s_fd_table_lock);
+                fd_table_unlock_all();
                 XF_LOGD(TAG, "xf_vfs_register_fd_range cannot set fd %d (used by other VFS)", i);
                 return XF_ERR_INVALID_ARG;
             }
-            s_fd_table[i].permanent = true;
-            s_fd_table[i].vfs_index = index;
-            s_fd_table[i].local_fd = i;
+            fd_table_set(i, true, index, i, FILE_INDEX_NONE);
         }
-        _lock_release(s_fd_table_lock);
+        fd_table_unlock_all();
 
         XF_LOGW(TAG, "xf_vfs_register_fd_range is successful for range <%d; %d) and VFS ID %d", min_fd, max_fd, index);
     }
@@ -243,17 +589,45 @@ xf_err_t xf_vfs_unregister_with_id(xf_vfs_id_t vfs_id)
         return XF_ERR_INVALID_ARG;
     }
     xf_vfs_entry_t *vfs = s_vfs[vfs_id];
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    fd_table_close_handles(vfs);
+#endif
     xf_vfs_free_entry(vfs);
     s_vfs[vfs_id] = NULL;
+    prefix_len_max_refresh();
+    ++s_vfs_generation;
+#if XF_VFS_LATENCY_IS_ENABLE
+    xf_vfs_latency_forget(vfs_id);
+#endif
+#if XF_VFS_QOS_IS_ENABLE
+    xf_vfs_qos_forget(vfs_id);
+#endif
+#if XF_VFS_MERGE_IS_ENABLE
+    xf_vfs_merge_forget(vfs_id);
+#endif
+#if XF_VFS_SUPPORT_SERIAL_IS_ENABLE
+    xf_vfs_serial_detach(vfs_id);
+#endif
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+    select_waiters_forget(vfs_id);
+#endif
 
-    _lock_acquire(s_fd_table_lock);
+    fd_table_lock_all();
     // Delete all references from the FD lookup-table
-    for (int j = 0; j < XF_VFS_MAX_COUNT; ++j) {
+    for (int j = 0; j < XF_VFS_FDS_MAX; ++j) {
         if (s_fd_table[j].vfs_index == vfs_id) {
             s_fd_table[j] = FD_TABLE_ENTRY_UNUSED;
+#if XF_VFS_QOS_IS_ENABLE
+            xf_vfs_qos_fd_reset(j);
+#endif
+        }
+    }
+    for (int j = 0; j < XF_VFS_FDS_MAX; ++j) {
+        if (XF_VFS_ATOMIC_REF_LOAD(&s_file_table[j].refcnt) != 0 && s_file_table[j].vfs_index == vfs_id) {
+            XF_VFS_ATOMIC_REF_STORE(&s_file_table[j].refcnt, 0);
         }
     }
-    _lock_release(s_fd_table_lock);
+    fd_table_unlock_all();
 
     return XF_OK;
 
@@ -298,23 +672,31 @@ xf_err_t xf_vfs_register_fd_with_local_fd(xf_vfs_id_t vfs_id, int local_fd, bool
         return XF_ERR_INVALID_ARG;
     }
 
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    if (s_vfs[vfs_id] != NULL && (s_vfs[vfs_id]->flags & XF_VFS_FLAG_HANDLE)) {
+        XF_LOGD(TAG, "Can not register fds of a handle mode VFS");
+        return XF_ERR_INVALID_ARG;
+    }
+#endif
+#if XF_VFS_STATIC_MOUNTS_IS_ENABLE
+    fd_table_lock_init();
+#endif
+
     xf_err_t ret = XF_ERR_NO_MEM;
-    _lock_acquire(s_fd_table_lock);
-    for (int i = 0; i < XF_VFS_FDS_MAX; ++i) {
-        if (s_fd_table[i].vfs_index == -1) {
-            s_fd_table[i].permanent = permanent;
-            s_fd_table[i].vfs_index = vfs_id;
-            if (local_fd >= 0) {
-                s_fd_table[i].local_fd = local_fd;
-            } else {
-                s_fd_table[i].local_fd = i;
+    for (int shard = 0; shard < FD_SHARD_COUNT && ret != XF_OK; ++shard) {
+        fd_shard_lock(shard);
+        for (int i = FD_SHARD_BEGIN(shard); i < FD_SHARD_END(shard); ++i) {
+            if (s_fd_table[i].vfs_index == -1) {
+                const int _local_fd = (local_fd >= 0) ? local_fd : i;
+                fd_table_set(i, permanent, vfs_id, _local_fd,
+                             permanent ? FILE_INDEX_NONE : file_table_alloc(i, vfs_id, _local_fd));
+                *fd = i;
+                ret = XF_OK;
+                break;
             }
-            *fd = i;
-            ret = XF_OK;
-            break;
         }
+        fd_shard_unlock(shard);
     }
-    _lock_release(s_fd_table_lock);
 
     XF_LOGD(TAG, "xf_vfs_register_fd_with_local_fd(%d, %d, %d, 0x%p) finished with %s",
             vfs_id, local_fd, permanent, fd, xf_err_to_name(ret));
@@ -331,13 +713,13 @@ xf_err_t xf_vfs_unregister_fd(xf_vfs_id_t vfs_id, int fd)
         return ret;
     }
 
-    _lock_acquire(s_fd_table_lock);
+    fd_shard_lock(FD_SHARD(fd));
     fd_table_t *item = s_fd_table + fd;
     if (item->permanent == true && item->vfs_index == vfs_id && item->local_fd == fd) {
-        *item = FD_TABLE_ENTRY_UNUSED;
+        fd_table_release(fd);
         ret = XF_OK;
     }
-    _lock_release(s_fd_table_lock);
+    fd_shard_unlock(FD_SHARD(fd));
 
     XF_LOGD(TAG, "xf_vfs_unregister_fd(%d, %d) finished with %s", vfs_id, fd, xf_err_to_name(ret));
 
@@ -350,7 +732,7 @@ void xf_vfs_dump_fds(void)
     xf_log_printf("------------------------------------------------------\n");
     xf_log_printf("<VFS Path Prefix>-<FD seen by App>-<FD seen by driver>\n");
     xf_log_printf("------------------------------------------------------\n");
-    _lock_acquire(s_fd_table_lock);
+    fd_table_lock_all();
     for (int index = 0; index < XF_VFS_FDS_MAX; index++) {
         if (s_fd_table[index].vfs_index != -1) {
             vfs = s_vfs[s_fd_table[index].vfs_index];
@@ -361,7 +743,7 @@ void xf_vfs_dump_fds(void)
             }
         }
     }
-    _lock_release(s_fd_table_lock);
+    fd_table_unlock_all();
 }
 
 void xf_vfs_dump_registered_paths(void)
@@ -379,6 +761,23 @@ void xf_vfs_dump_registered_paths(void)
     }
 }
 
+void xf_vfs_get_mem_stats(xf_vfs_mem_stats_t *stats)
+{
+    xf_memset(stats, 0, sizeof(xf_vfs_mem_stats_t));
+    xf_vfs_heap_get_stats(stats);
+#if XF_VFS_NO_HEAP_IS_ENABLE
+    xf_vfs_pool_get_stats(&s_entry_pool, &stats->entry);
+    xf_vfs_pool_get_stats(&s_ops_pool, &stats->ops);
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    xf_vfs_pool_get_stats(&s_dirat_pool, &stats->dirat);
+#endif
+    xf_vfs_pool_get_stats(&s_path_pool, &stats->path);
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+    xf_vfs_pool_get_stats(&s_waiter_pool, &stats->select_waiter);
+#endif
+#endif
+}
+
 /*
  * Set XF_VFS_FLAG_READONLY_FS read-only flag for a registered virtual filesystem
  * for given path prefix. Should be only called from the xf_vfs_*filesystem* register
@@ -414,43 +813,196 @@ const xf_vfs_entry_t *xf_vfs_get_vfs_for_index(int index)
 const xf_vfs_entry_t *xf_vfs_get_vfs_for_path(const char *path)
 {
     const xf_vfs_entry_t *best_match = NULL;
-    xf_vfs_ssize_t best_match_prefix_len = -1;
-    size_t len = xf_strlen(path);
-    for (size_t i = 0; i < s_vfs_count; ++i) {
-        const xf_vfs_entry_t *vfs = s_vfs[i];
-        if (vfs == NULL || vfs->path_prefix_len == XF_VFS_PATH_PREFIX_LEN_IGNORED) {
-            continue;
-        }
-        // match path prefix
-        if (len < vfs->path_prefix_len ||
-                xf_memcmp(path, vfs->path_prefix, vfs->path_prefix_len) != 0) {
-            continue;
-        }
-        // this is the default VFS and we don't have a better match yet.
-        if (vfs->path_prefix_len == 0 && !best_match) {
-            best_match = vfs;
-            continue;
-        }
-        // if path is not equal to the prefix, expect to see a path separator
-        // i.e. don't match "/data" prefix for "/data1/foo.txt" path
-        if (len > vfs->path_prefix_len &&
-                path[vfs->path_prefix_len] != '/') {
-            continue;
+    uint32_t hash = XF_VFS_PREFIX_HASH_INIT;
+    // Walk the path once, hashing it incrementally. Only path[0, i) at the start of
+    // the path, at a path separator or at the end of the path can be a mount prefix,
+    // i.e. don't match "/data" prefix for "/data1/foo.txt" path.
+    // Longer candidates are checked later, so the longest matching prefix wins;
+    // i.e. if "/dev" and "/dev/uart" both match, for "/dev/uart/1" path,
+    // choose "/dev/uart". The empty prefix is the default VFS.
+    for (size_t i = 0; ; ++i) {
+        const char c = path[i];
+        if (i == 0 || c == '/' || c == '\0') {
+            for (size_t j = 0; j < s_vfs_count; ++j) {
+                const xf_vfs_entry_t *vfs = s_vfs[j];
+                if (vfs != NULL && vfs->path_prefix_len == i && vfs->path_prefix_hash == hash
+                        && xf_memcmp(path, vfs->path_prefix, i) == 0) {
+                    best_match = vfs;
+                    break;
+                }
+            }
         }
-        // Out of all matching path prefixes, select the longest one;
-        // i.e. if "/dev" and "/dev/uart" both match, for "/dev/uart/1" path,
-        // choose "/dev/uart",
-        // This causes all s_vfs_count VFS entries to be scanned when opening
-        // a file by name. This can be optimized by introducing a table for
-        // FS search order, sorted so that longer prefixes are checked first.
-        if (best_match_prefix_len < (xf_vfs_ssize_t) vfs->path_prefix_len) {
-            best_match_prefix_len = (xf_vfs_ssize_t) vfs->path_prefix_len;
-            best_match = vfs;
+        if (c == '\0' || i >= s_vfs_prefix_len_max) {
+            break;
         }
+        hash = prefix_hash_step(hash, c);
     }
     return best_match;
 }
 
+#if XF_VFS_QOS_IS_ENABLE
+int xf_vfs_get_vfs_index_for_fd(int fd)
+{
+    const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
+    return (vfs != NULL && get_local_fd(vfs, fd) >= 0) ? vfs->offset : -1;
+}
+#endif
+
+#if XF_VFS_MERGE_IS_ENABLE
+xf_vfs_ssize_t xf_vfs_pwrite_driver(int fd, const void *src, size_t size, xf_vfs_off64_t offset)
+{
+    const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
+    const int local_fd = get_local_fd(vfs, fd);
+    if (vfs == NULL || local_fd < 0) {
+        errno = EBADF;
+        return -1;
+    }
+    return drv_pwrite64(vfs, get_handle_for_fd(fd), local_fd, src, size, offset);
+}
+#endif
+
+/*
+ * 开启延迟直方图（XF_VFS_LATENCY_ENABLE）时，统计驱动方法 func 的一次调用 call 的耗时。
+ * func 由 LAT_OP_##func 映射到 xf_vfs_trace_op_t，规则同跟踪。
+ */
+#if XF_VFS_LATENCY_IS_ENABLE
+#define LATENCY_CALL(pvfs, func, ...) \
+    do { \
+        const uint64_t lat_start = XF_VFS_LATENCY_TIME_NS(); \
+        __VA_ARGS__; \
+        xf_vfs_latency_record((pvfs)->offset, LAT_OP_##func, lat_start); \
+    } while (0)
+
+#define LAT_OP_open             XF_VFS_TRACE_OP_OPEN
+#define LAT_OP_openat           XF_VFS_TRACE_OP_OPEN
+#define LAT_OP_close            XF_VFS_TRACE_OP_CLOSE
+#define LAT_OP_read             XF_VFS_TRACE_OP_READ
+#define LAT_OP_write            XF_VFS_TRACE_OP_WRITE
+#define LAT_OP_pread            XF_VFS_TRACE_OP_PREAD
+#define LAT_OP_pread64          XF_VFS_TRACE_OP_PREAD
+#define LAT_OP_pwrite           XF_VFS_TRACE_OP_PWRITE
+#define LAT_OP_pwrite64         XF_VFS_TRACE_OP_PWRITE
+#define LAT_OP_lseek            XF_VFS_TRACE_OP_LSEEK
+#define LAT_OP_lseek64          XF_VFS_TRACE_OP_LSEEK
+#define LAT_OP_fstat            XF_VFS_TRACE_OP_FSTAT
+#define LAT_OP_fstat64          XF_VFS_TRACE_OP_FSTAT
+#define LAT_OP_fstatx           XF_VFS_TRACE_OP_FSTAT
+#define LAT_OP_fcntl            XF_VFS_TRACE_OP_FCNTL
+#define LAT_OP_ioctl            XF_VFS_TRACE_OP_IOCTL
+#define LAT_OP_fsync            XF_VFS_TRACE_OP_FSYNC
+#define LAT_OP_ftruncate        XF_VFS_TRACE_OP_FTRUNCATE
+#define LAT_OP_ftruncate64      XF_VFS_TRACE_OP_FTRUNCATE
+#define LAT_OP_stat             XF_VFS_TRACE_OP_STAT
+#define LAT_OP_statx            XF_VFS_TRACE_OP_STAT
+#define LAT_OP_fstatat          XF_VFS_TRACE_OP_STAT
+#define LAT_OP_utime            XF_VFS_TRACE_OP_UTIME
+#define LAT_OP_link             XF_VFS_TRACE_OP_LINK
+#define LAT_OP_unlink           XF_VFS_TRACE_OP_UNLINK
+#define LAT_OP_unlinkat         XF_VFS_TRACE_OP_UNLINK
+#define LAT_OP_rename           XF_VFS_TRACE_OP_RENAME
+#define LAT_OP_opendir          XF_VFS_TRACE_OP_OPENDIR
+#define LAT_OP_readdir          XF_VFS_TRACE_OP_READDIR
+#define LAT_OP_readdir_r        XF_VFS_TRACE_OP_READDIR
+#define LAT_OP_telldir          XF_VFS_TRACE_OP_TELLDIR
+#define LAT_OP_seekdir          XF_VFS_TRACE_OP_SEEKDIR
+#define LAT_OP_closedir         XF_VFS_TRACE_OP_CLOSEDIR
+#define LAT_OP_getdents         XF_VFS_TRACE_OP_GETDENTS
+#define LAT_OP_mkdir            XF_VFS_TRACE_OP_MKDIR
+#define LAT_OP_mkdirat          XF_VFS_TRACE_OP_MKDIR
+#define LAT_OP_rmdir            XF_VFS_TRACE_OP_RMDIR
+#define LAT_OP_access           XF_VFS_TRACE_OP_ACCESS
+#define LAT_OP_truncate         XF_VFS_TRACE_OP_TRUNCATE
+#define LAT_OP_truncate64       XF_VFS_TRACE_OP_TRUNCATE
+#else
+#define LATENCY_CALL(pvfs, func, ...) \
+    do { \
+        __VA_ARGS__; \
+    } while (0)
+#endif
+
+/*
+ * 调用驱动方法 func：call 为调用表达式，key 为其操作的 local fd、句柄或目录流。
+ * 以 XF_VFS_FLAG_SERIAL_FILE / XF_VFS_FLAG_SERIAL_MOUNT 注册的挂载点在调用期间持有对应的锁，
+ * func 由 SERIAL_OP_##func 映射到锁的种类；其他挂载点只多一次标志判断。
+ */
+#if XF_VFS_SUPPORT_SERIAL_IS_ENABLE
+#define DRIVER_CALL(pvfs, func, key, ...) \
+    do { \
+        const bool serial = ((pvfs)->flags & SERIAL_FLAGS) != 0; \
+        const uintptr_t serial_key = serial ? (uintptr_t)(key) : 0; \
+        if (serial) { \
+            xf_vfs_serial_enter((pvfs)->offset, SERIAL_OP_##func, serial_key); \
+        } \
+        LATENCY_CALL(pvfs, func, __VA_ARGS__); \
+        if (serial) { \
+            xf_vfs_serial_exit((pvfs)->offset, SERIAL_OP_##func, serial_key); \
+        } \
+    } while (0)
+
+#define SERIAL_SH               XF_VFS_SERIAL_KIND_SHARED
+#define SERIAL_FILE             XF_VFS_SERIAL_KIND_FILE
+
+#define SERIAL_OP_open          (0)
+#define SERIAL_OP_openat        (0)
+#define SERIAL_OP_close         (SERIAL_FILE)
+#define SERIAL_OP_read          (SERIAL_FILE)
+#define SERIAL_OP_write         (SERIAL_FILE)
+#define SERIAL_OP_pread         (SERIAL_FILE | SERIAL_SH)
+#define SERIAL_OP_pread64       (SERIAL_FILE | SERIAL_SH)
+#define SERIAL_OP_pwrite        (SERIAL_FILE)
+#define SERIAL_OP_pwrite64      (SERIAL_FILE)
+#define SERIAL_OP_lseek         (SERIAL_FILE)
+#define SERIAL_OP_lseek64       (SERIAL_FILE)
+#define SERIAL_OP_fstat         (SERIAL_FILE | SERIAL_SH)
+#define SERIAL_OP_fstat64       (SERIAL_FILE | SERIAL_SH)
+#define SERIAL_OP_fstatx        (SERIAL_FILE | SERIAL_SH)
+#define SERIAL_OP_fcntl         (SERIAL_FILE)
+#define SERIAL_OP_ioctl         (SERIAL_FILE)
+#define SERIAL_OP_fsync         (SERIAL_FILE)
+#define SERIAL_OP_ftruncate     (SERIAL_FILE)
+#define SERIAL_OP_ftruncate64   (SERIAL_FILE)
+#define SERIAL_OP_stat          (SERIAL_SH)
+#define SERIAL_OP_statx         (SERIAL_SH)
+#define SERIAL_OP_fstatat       (SERIAL_SH)
+#define SERIAL_OP_access        (SERIAL_SH)
+#define SERIAL_OP_utime         (0)
+#define SERIAL_OP_link          (0)
+#define SERIAL_OP_unlink        (0)
+#define SERIAL_OP_unlinkat      (0)
+#define SERIAL_OP_rename        (0)
+#define SERIAL_OP_opendir       (0)
+#define SERIAL_OP_readdir       (SERIAL_FILE)
+#define SERIAL_OP_readdir_r     (SERIAL_FILE)
+#define SERIAL_OP_telldir       (SERIAL_FILE | SERIAL_SH)
+#define SERIAL_OP_seekdir       (SERIAL_FILE)
+#define SERIAL_OP_closedir      (SERIAL_FILE)
+#define SERIAL_OP_getdents      (SERIAL_FILE)
+#define SERIAL_OP_mkdir         (0)
+#define SERIAL_OP_mkdirat       (0)
+#define SERIAL_OP_rmdir         (0)
+#define SERIAL_OP_truncate      (0)
+#define SERIAL_OP_truncate64    (0)
+#else
+#define DRIVER_CALL(pvfs, func, key, ...) \
+    LATENCY_CALL(pvfs, func, __VA_ARGS__)
+#endif
+
+/* 驱动方法的第一个参数，即 DRIVER_CALL 的 key */
+#define FIRST_ARG(...)          FIRST_ARG_(__VA_ARGS__, 0)
+#define FIRST_ARG_(first, ...)  first
+
+/*
+ * 开启 QoS（XF_VFS_QOS_ENABLE）时，fd 上的读写与 fsync 在调用前按挂载点与 fd 的限制等待。
+ * QOS_ADMIT 定义局部变量 qos_class，之后必须执行对应的 QOS_DONE，因此两者之间不能提前返回。
+ */
+#if XF_VFS_QOS_IS_ENABLE
+#define QOS_ADMIT(pvfs, fd, size)   const int qos_class = xf_vfs_qos_admit((pvfs)->offset, (fd), (size))
+#define QOS_DONE(pvfs)              xf_vfs_qos_done((pvfs)->offset, qos_class)
+#else
+#define QOS_ADMIT(pvfs, fd, size)   do {} while (0)
+#define QOS_DONE(pvfs)              do {} while (0)
+#endif
+
 /*
  * Using huge multi-line macros is never nice, but in this case
  * the only alternative is to repeat this chunk of code (with different function names)
@@ -469,9 +1021,9 @@ const xf_vfs_entry_t *xf_vfs_get_vfs_for_path(const char *path)
         return -1; \
     } \
     if (pvfs->flags & XF_VFS_FLAG_CONTEXT_PTR) { \
-        ret = (*pvfs->vfs->func ## _p)(pvfs->ctx, __VA_ARGS__); \
+        DRIVER_CALL(pvfs, func, FIRST_ARG(__VA_ARGS__), ret = (*pvfs->vfs->func ## _p)(pvfs->ctx, __VA_ARGS__)); \
     } else { \
-        ret = (*pvfs->vfs->func)(__VA_ARGS__); \
+        DRIVER_CALL(pvfs, func, FIRST_ARG(__VA_ARGS__), ret = (*pvfs->vfs->func)(__VA_ARGS__)); \
     }
 
 #define CHECK_AND_CALL_SUBCOMPONENT(ret, r, pvfs, component, func, ...) \
@@ -480,9 +1032,9 @@ const xf_vfs_entry_t *xf_vfs_get_vfs_for_path(const char *path)
         return -1; \
     } \
     if (pvfs->flags & XF_VFS_FLAG_CONTEXT_PTR) { \
-        ret = (*pvfs->vfs->component->func ## _p)(pvfs->ctx, __VA_ARGS__); \
+        DRIVER_CALL(pvfs, func, FIRST_ARG(__VA_ARGS__), ret = (*pvfs->vfs->component->func ## _p)(pvfs->ctx, __VA_ARGS__)); \
     } else { \
-        ret = (*pvfs->vfs->component->func)(__VA_ARGS__); \
+        DRIVER_CALL(pvfs, func, FIRST_ARG(__VA_ARGS__), ret = (*pvfs->vfs->component->func)(__VA_ARGS__)); \
     }
 
 #define CHECK_AND_CALLV(r, pvfs, func, ...) \
@@ -491,9 +1043,9 @@ const xf_vfs_entry_t *xf_vfs_get_vfs_for_path(const char *path)
         return; \
     } \
     if (pvfs->flags & XF_VFS_FLAG_CONTEXT_PTR) { \
-        (*pvfs->vfs->func ## _p)(pvfs->ctx, __VA_ARGS__); \
+        DRIVER_CALL(pvfs, func, FIRST_ARG(__VA_ARGS__), (*pvfs->vfs->func ## _p)(pvfs->ctx, __VA_ARGS__)); \
     } else { \
-        (*pvfs->vfs->func)(__VA_ARGS__); \
+        DRIVER_CALL(pvfs, func, FIRST_ARG(__VA_ARGS__), (*pvfs->vfs->func)(__VA_ARGS__)); \
     }
 
 #define CHECK_AND_CALL_SUBCOMPONENTV(r, pvfs, component, func, ...) \
@@ -502,9 +1054,9 @@ const xf_vfs_entry_t *xf_vfs_get_vfs_for_path(const char *path)
         return; \
     } \
     if (pvfs->flags & XF_VFS_FLAG_CONTEXT_PTR) { \
-        (*pvfs->vfs->component->func ## _p)(pvfs->ctx, __VA_ARGS__); \
+        DRIVER_CALL(pvfs, func, FIRST_ARG(__VA_ARGS__), (*pvfs->vfs->component->func ## _p)(pvfs->ctx, __VA_ARGS__)); \
     } else { \
-        (*pvfs->vfs->component->func)(__VA_ARGS__); \
+        DRIVER_CALL(pvfs, func, FIRST_ARG(__VA_ARGS__), (*pvfs->vfs->component->func)(__VA_ARGS__)); \
     }
 
 #define CHECK_AND_CALLP(ret, r, pvfs, func, ...) \
@@ -513,9 +1065,9 @@ const xf_vfs_entry_t *xf_vfs_get_vfs_for_path(const char *path)
         return NULL; \
     } \
     if (pvfs->flags & XF_VFS_FLAG_CONTEXT_PTR) { \
-        ret = (*pvfs->vfs->func ## _p)(pvfs->ctx, __VA_ARGS__); \
+        DRIVER_CALL(pvfs, func, FIRST_ARG(__VA_ARGS__), ret = (*pvfs->vfs->func ## _p)(pvfs->ctx, __VA_ARGS__)); \
     } else { \
-        ret = (*pvfs->vfs->func)(__VA_ARGS__); \
+        DRIVER_CALL(pvfs, func, FIRST_ARG(__VA_ARGS__), ret = (*pvfs->vfs->func)(__VA_ARGS__)); \
     }
 
 #define CHECK_AND_CALL_SUBCOMPONENTP(ret, r, pvfs, component, func, ...) \
@@ -524,57 +1076,90 @@ const xf_vfs_entry_t *xf_vfs_get_vfs_for_path(const char *path)
         return NULL; \
     } \
     if (pvfs->flags & XF_VFS_FLAG_CONTEXT_PTR) { \
-        ret = (*pvfs->vfs->component->func ## _p)(pvfs->ctx, __VA_ARGS__); \
+        DRIVER_CALL(pvfs, func, FIRST_ARG(__VA_ARGS__), ret = (*pvfs->vfs->component->func ## _p)(pvfs->ctx, __VA_ARGS__)); \
+    } else { \
+        DRIVER_CALL(pvfs, func, FIRST_ARG(__VA_ARGS__), ret = (*pvfs->vfs->component->func)(__VA_ARGS__)); \
+    }
+
+/*
+ * Calls a method which takes an fd as its first argument.
+ * On XF_VFS_FLAG_HANDLE mounts the method of the handle subcomponent is called instead,
+ * with the handle h in place of local_fd (h is only evaluated in that case).
+ */
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+#define CHECK_AND_CALL_FD(ret, r, pvfs, h, func, local_fd, ...) \
+    if (pvfs->flags & XF_VFS_FLAG_HANDLE) { \
+        if (pvfs->vfs->handle->func == NULL) { \
+            errno = ENOSYS; \
+            return -1; \
+        } \
+        DRIVER_CALL(pvfs, func, h, ret = (*pvfs->vfs->handle->func)(pvfs->ctx, (h), ##__VA_ARGS__)); \
     } else { \
-        ret = (*pvfs->vfs->component->func)(__VA_ARGS__); \
+        CHECK_AND_CALL(ret, r, pvfs, func, local_fd, ##__VA_ARGS__); \
     }
 
+#define FD_OP_IS_NULL(pvfs, func) \
+    ((pvfs->flags & XF_VFS_FLAG_HANDLE) ? (pvfs->vfs->handle->func == NULL) : (pvfs->vfs->func == NULL))
+
+#define IS_HANDLE_MODE(pvfs)        ((pvfs->flags & XF_VFS_FLAG_HANDLE) != 0)
+#else
+#define CHECK_AND_CALL_FD(ret, r, pvfs, h, func, local_fd, ...) \
+    CHECK_AND_CALL(ret, r, pvfs, func, local_fd, ##__VA_ARGS__)
+
+#define FD_OP_IS_NULL(pvfs, func)   (pvfs->vfs->func == NULL)
+
+#define IS_HANDLE_MODE(pvfs)        (false)
+#endif
+
+/* Whether the driver provides the 64-bit flavor of a method, to be called with CHECK_AND_CALL_FD */
+#define HAS_OP64(pvfs, func)        (!FD_OP_IS_NULL(pvfs, func))
+
 #define CHECK_VFS_READONLY_FLAG(flags) \
     if (flags & XF_VFS_FLAG_READONLY_FS) { \
         errno = EROFS; \
         return -1; \
     }
 
-int xf_vfs_open(const char *path, int flags, int mode)
+TRACED_STATIC int TRACED(xf_vfs_open)(const char *path, int flags, int mode)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(path);
     if (vfs == NULL) {
         errno = ENOENT;
         return -1;
     }
+    return vfs_open(vfs, translate_path(vfs, path), flags, mode);
+}
 
-    int acc_mode = flags & XF_VFS_O_ACCMODE;
-    int ro_filesystem = vfs->flags & XF_VFS_FLAG_READONLY_FS;
-    if (acc_mode != XF_VFS_O_RDONLY && ro_filesystem) {
-        errno = EROFS;
-        return -1;
+xf_vfs_path_t *xf_vfs_path_prepare(const char *path)
+{
+    const size_t len = xf_strlen(path);
+    xf_vfs_path_t *p = VFS_ALLOC(s_path_pool, sizeof(xf_vfs_path_t) + len + 1);
+    if (p == NULL) {
+        errno = ENOMEM;
+        return NULL;
     }
+    p->len = len;
+    xf_memcpy(p->path, path, len + 1);
+    p->generation = s_vfs_generation - 1;
+    path_resolve(p);
+    return p;
+}
 
-    const char *path_within_vfs = translate_path(vfs, path);
-    int fd_within_vfs;
-    CHECK_AND_CALL(fd_within_vfs, r, vfs, open, path_within_vfs, flags, mode);
-    if (fd_within_vfs >= 0) {
-        _lock_acquire(s_fd_table_lock);
-        for (int i = 0; i < XF_VFS_FDS_MAX; ++i) {
-            if (s_fd_table[i].vfs_index == -1) {
-                s_fd_table[i].permanent = false;
-                s_fd_table[i].vfs_index = vfs->offset;
-                s_fd_table[i].local_fd = fd_within_vfs;
-                _lock_release(s_fd_table_lock);
-                return i;
-            }
-        }
-        _lock_release(s_fd_table_lock);
-        int ret;
-        CHECK_AND_CALL(ret, r, vfs, close, fd_within_vfs);
-        (void) ret; // remove "set but not used" warning
-        errno = ENOMEM;
+void xf_vfs_path_release(xf_vfs_path_t *p)
+{
+    VFS_FREE(s_path_pool, p);
+}
+
+TRACED_STATIC int TRACED(xf_vfs_open_p)(xf_vfs_path_t *p, int flags, int mode)
+{
+    const xf_vfs_entry_t *vfs = path_resolve(p);
+    if (vfs == NULL) {
         return -1;
     }
-    return -1;
+    return vfs_open(vfs, p->path_within_vfs, flags, mode);
 }
 
-xf_vfs_ssize_t xf_vfs_write(int fd, const void *data, size_t size)
+TRACED_STATIC xf_vfs_ssize_t TRACED(xf_vfs_write)(int fd, const void *data, size_t size)
 {
     const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
     const int local_fd = get_local_fd(vfs, fd);
@@ -582,12 +1167,23 @@ xf_vfs_ssize_t xf_vfs_write(int fd, const void *data, size_t size)
         errno = EBADF;
         return -1;
     }
-    xf_vfs_ssize_t ret;
-    CHECK_AND_CALL(ret, r, vfs, write, local_fd, data, size);
+    QOS_ADMIT(vfs, fd, size);
+    const xf_vfs_ssize_t ret = vfs_write(vfs, fd, local_fd, data, size);
+    QOS_DONE(vfs);
     return ret;
 }
 
 xf_vfs_off_t xf_vfs_lseek(int fd, xf_vfs_off_t size, int mode)
+{
+    const xf_vfs_off64_t ret = xf_vfs_lseek64(fd, size, mode);
+    if (!OFF_FITS(ret)) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    return (xf_vfs_off_t)ret;
+}
+
+TRACED_STATIC xf_vfs_off64_t TRACED(xf_vfs_lseek64)(int fd, xf_vfs_off64_t offset, int mode)
 {
     const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
     const int local_fd = get_local_fd(vfs, fd);
@@ -595,12 +1191,14 @@ xf_vfs_off_t xf_vfs_lseek(int fd, xf_vfs_off_t size, int mode)
         errno = EBADF;
         return -1;
     }
-    xf_vfs_off_t ret;
-    CHECK_AND_CALL(ret, r, vfs, lseek, local_fd, size, mode);
-    return ret;
+    file_table_t *file = get_file_for_fd(vfs, fd);
+    if (file) {
+        return offset_lseek(vfs, file, local_fd, offset, mode);
+    }
+    return drv_lseek64(vfs, get_handle_for_fd(fd), local_fd, offset, mode);
 }
 
-xf_vfs_ssize_t xf_vfs_read(int fd, void *dst, size_t size)
+TRACED_STATIC xf_vfs_ssize_t TRACED(xf_vfs_read)(int fd, void *dst, size_t size)
 {
     const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
     const int local_fd = get_local_fd(vfs, fd);
@@ -608,12 +1206,18 @@ xf_vfs_ssize_t xf_vfs_read(int fd, void *dst, size_t size)
         errno = EBADF;
         return -1;
     }
-    xf_vfs_ssize_t ret;
-    CHECK_AND_CALL(ret, r, vfs, read, local_fd, dst, size);
+    QOS_ADMIT(vfs, fd, size);
+    const xf_vfs_ssize_t ret = vfs_read(vfs, fd, local_fd, dst, size);
+    QOS_DONE(vfs);
     return ret;
 }
 
 xf_vfs_ssize_t xf_vfs_pread(int fd, void *dst, size_t size, xf_vfs_off_t offset)
+{
+    return xf_vfs_pread64(fd, dst, size, offset);
+}
+
+TRACED_STATIC xf_vfs_ssize_t TRACED(xf_vfs_pread64)(int fd, void *dst, size_t size, xf_vfs_off64_t offset)
 {
     const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
     const int local_fd = get_local_fd(vfs, fd);
@@ -621,12 +1225,18 @@ xf_vfs_ssize_t xf_vfs_pread(int fd, void *dst, size_t size, xf_vfs_off_t offset)
         errno = EBADF;
         return -1;
     }
-    xf_vfs_ssize_t ret;
-    CHECK_AND_CALL(ret, r, vfs, pread, local_fd, dst, size, offset);
+    QOS_ADMIT(vfs, fd, size);
+    const xf_vfs_ssize_t ret = drv_pread64(vfs, get_handle_for_fd(fd), local_fd, dst, size, offset);
+    QOS_DONE(vfs);
     return ret;
 }
 
 xf_vfs_ssize_t xf_vfs_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    return xf_vfs_pwrite64(fd, src, size, offset);
+}
+
+TRACED_STATIC xf_vfs_ssize_t TRACED(xf_vfs_pwrite64)(int fd, const void *src, size_t size, xf_vfs_off64_t offset)
 {
     const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
     const int local_fd = get_local_fd(vfs, fd);
@@ -634,12 +1244,13 @@ xf_vfs_ssize_t xf_vfs_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t
         errno = EBADF;
         return -1;
     }
-    xf_vfs_ssize_t ret;
-    CHECK_AND_CALL(ret, r, vfs, pwrite, local_fd, src, size, offset);
+    QOS_ADMIT(vfs, fd, size);
+    const xf_vfs_ssize_t ret = vfs_pwrite(vfs, fd, local_fd, src, size, offset);
+    QOS_DONE(vfs);
     return ret;
 }
 
-int xf_vfs_close(int fd)
+TRACED_STATIC int TRACED(xf_vfs_close)(int fd)
 {
     const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
     const int local_fd = get_local_fd(vfs, fd);
@@ -647,35 +1258,111 @@ int xf_vfs_close(int fd)
         errno = EBADF;
         return -1;
     }
-    int ret;
-    CHECK_AND_CALL(ret, r, vfs, close, local_fd);
 
-    _lock_acquire(s_fd_table_lock);
+    fd_shard_lock(FD_SHARD(fd));
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    void *handle = get_handle_for_fd(fd); // the file record may be reused once released
+#endif
+    bool last = true;
     if (!s_fd_table[fd].permanent) {
         if (s_fd_table[fd].has_pending_select) {
+            last = file_table_put(s_fd_table[fd].file_index);
+            s_fd_table[fd].file_index = FILE_INDEX_NONE;
             s_fd_table[fd].has_pending_close = true;
         } else {
-            s_fd_table[fd] = FD_TABLE_ENTRY_UNUSED;
+            last = fd_table_release(fd);
         }
+    } else if (s_fd_table[fd].file_index != FILE_INDEX_NONE) {
+        /* 永久 fd 保留映射，只放弃对打开文件描述的引用 */
+        last = file_table_put(s_fd_table[fd].file_index);
+        s_fd_table[fd].file_index = FILE_INDEX_NONE;
+    }
+    fd_shard_unlock(FD_SHARD(fd));
+
+    if (!last) {
+        return 0;
     }
-    _lock_release(s_fd_table_lock);
+    int ret;
+    CHECK_AND_CALL_FD(ret, r, vfs, handle, close, local_fd);
     return ret;
 }
 
-int xf_vfs_fstat(int fd, xf_vfs_stat_t *st)
+TRACED_STATIC int TRACED(xf_vfs_dup)(int fd)
 {
-    const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
+    return dup_from(fd, 0);
+}
+
+TRACED_STATIC int TRACED(xf_vfs_dup2)(int fd, int fd2)
+{
+    if (get_vfs_for_fd(fd) == NULL || !fd_valid(fd2)) {
+        errno = EBADF;
+        return -1;
+    }
+    if (fd == fd2) {
+        return fd2;
+    }
+
+    fd_shard_lock_pair(FD_SHARD(fd), FD_SHARD(fd2));
+    const fd_table_t old = s_fd_table[fd2];
+    if (old.vfs_index != -1 && (old.permanent || old.has_pending_select)) {
+        /* 永久 fd 由驱动管理，正在 select 的 fd 也不能被替换 */
+        fd_shard_unlock_pair(FD_SHARD(fd), FD_SHARD(fd2));
+        errno = EBUSY;
+        return -1;
+    }
+    bool last = false;
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    void *old_handle = NULL;
+#endif
+    if (old.vfs_index != -1) {
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+        old_handle = s_file_table[old.file_index].handle;
+#endif
+        last = file_table_put(old.file_index);
+        s_fd_table[fd2] = FD_TABLE_ENTRY_UNUSED;
+    }
+    int ret = fd_table_share(fd, fd2);
+    fd_shard_unlock_pair(FD_SHARD(fd), FD_SHARD(fd2));
+
+    /* fd2 原来是最后一个引用者时需要关闭原文件，与 POSIX 一致忽略其错误 */
+    const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(old.vfs_index);
+    if (last && vfs != NULL && !FD_OP_IS_NULL(vfs, close)) {
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+        if (vfs->flags & XF_VFS_FLAG_HANDLE) {
+            DRIVER_CALL(vfs, close, old_handle, (*vfs->vfs->handle->close)(vfs->ctx, old_handle));
+        } else
+#endif
+        if (vfs->flags & XF_VFS_FLAG_CONTEXT_PTR) {
+            DRIVER_CALL(vfs, close, old.local_fd, (*vfs->vfs->close_p)(vfs->ctx, old.local_fd));
+        } else {
+            DRIVER_CALL(vfs, close, old.local_fd, (*vfs->vfs->close)(old.local_fd));
+        }
+    }
+    return ret;
+}
+
+TRACED_STATIC int TRACED(xf_vfs_fstat64)(int fd, xf_vfs_stat64_t *st)
+{
+    const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
     const int local_fd = get_local_fd(vfs, fd);
     if (vfs == NULL || local_fd < 0) {
         errno = EBADF;
         return -1;
     }
-    int ret;
-    CHECK_AND_CALL(ret, r, vfs, fstat, local_fd, st);
-    return ret;
+    return drv_fstat64(vfs, get_handle_for_fd(fd), local_fd, st);
 }
 
-int xf_vfs_fcntl_r(int fd, int cmd, int arg)
+TRACED_STATIC int TRACED(xf_vfs_fstat)(int fd, xf_vfs_stat_t *st)
+{
+    xf_vfs_stat64_t st64;
+    const int ret = TRACED(xf_vfs_fstat64)(fd, &st64);
+    if (ret != 0) {
+        return ret;
+    }
+    return stat64_to_stat(&st64, st);
+}
+
+TRACED_STATIC int TRACED(xf_vfs_fstatx)(int fd, uint32_t mask, xf_vfs_statx_t *stx)
 {
     const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
     const int local_fd = get_local_fd(vfs, fd);
@@ -683,12 +1370,10 @@ int xf_vfs_fcntl_r(int fd, int cmd, int arg)
         errno = EBADF;
         return -1;
     }
-    int ret;
-    CHECK_AND_CALL(ret, r, vfs, fcntl, local_fd, cmd, arg);
-    return ret;
+    return drv_fstatx(vfs, get_handle_for_fd(fd), local_fd, mask, stx);
 }
 
-int xf_vfs_ioctl(int fd, int cmd, ...)
+TRACED_STATIC int TRACED(xf_vfs_fcntl_r)(int fd, int cmd, int arg)
 {
     const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
     const int local_fd = get_local_fd(vfs, fd);
@@ -696,15 +1381,31 @@ int xf_vfs_ioctl(int fd, int cmd, ...)
         errno = EBADF;
         return -1;
     }
+    if (cmd == XF_VFS_F_DUPFD || cmd == XF_VFS_F_DUPFD_CLOEXEC) {
+        return dup_from(fd, arg);
+    }
     int ret;
+    CHECK_AND_CALL_FD(ret, r, vfs, get_handle_for_fd(fd), fcntl, local_fd, cmd, arg);
+    return ret;
+}
+
+int xf_vfs_ioctl(int fd, int cmd, ...)
+{
+#if XF_VFS_TRACE_IS_ENABLE
+    const uint64_t start = xf_vfs_trace_begin();
+    const int trace_vfs = (start != 0) ? trace_fd_vfs(fd) : -1;
+#endif
     va_list args;
     va_start(args, cmd);
-    CHECK_AND_CALL(ret, r, vfs, ioctl, local_fd, cmd, args);
+    const int ret = vfs_ioctl(fd, cmd, args);
     va_end(args);
+#if XF_VFS_TRACE_IS_ENABLE
+    xf_vfs_trace_end(start, XF_VFS_TRACE_OP_IOCTL, fd, trace_vfs, 0, ret);
+#endif
     return ret;
 }
 
-int xf_vfs_fsync(int fd)
+TRACED_STATIC int TRACED(xf_vfs_fsync)(int fd)
 {
     const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
     const int local_fd = get_local_fd(vfs, fd);
@@ -712,14 +1413,15 @@ int xf_vfs_fsync(int fd)
         errno = EBADF;
         return -1;
     }
-    int ret;
-    CHECK_AND_CALL(ret, r, vfs, fsync, local_fd);
+    QOS_ADMIT(vfs, fd, 0);
+    const int ret = vfs_fsync(vfs, fd, local_fd);
+    QOS_DONE(vfs);
     return ret;
 }
 
 #if XF_VFS_SUPPORT_DIR_IS_ENABLE
 
-int xf_vfs_stat(const char *path, xf_vfs_stat_t *st)
+TRACED_STATIC int TRACED(xf_vfs_stat)(const char *path, xf_vfs_stat_t *st)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(path);
     if (vfs == NULL) {
@@ -732,7 +1434,65 @@ int xf_vfs_stat(const char *path, xf_vfs_stat_t *st)
     return ret;
 }
 
-int xf_vfs_utime(const char *path, const xf_vfs_utimbuf_t *times)
+TRACED_STATIC int TRACED(xf_vfs_statx)(const char *path, uint32_t mask, xf_vfs_statx_t *stx)
+{
+    const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(path);
+    if (vfs == NULL) {
+        errno = ENOENT;
+        return -1;
+    }
+    return drv_statx(vfs, translate_path(vfs, path), mask, stx);
+}
+
+TRACED_STATIC int TRACED(xf_vfs_stat_p)(xf_vfs_path_t *p, xf_vfs_stat_t *st)
+{
+    const xf_vfs_entry_t *vfs = path_resolve(p);
+    if (vfs == NULL) {
+        return -1;
+    }
+    int ret;
+    CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, stat, p->path_within_vfs, st);
+    return ret;
+}
+
+TRACED_STATIC int TRACED(xf_vfs_statx_p)(xf_vfs_path_t *p, uint32_t mask, xf_vfs_statx_t *stx)
+{
+    const xf_vfs_entry_t *vfs = path_resolve(p);
+    if (vfs == NULL) {
+        return -1;
+    }
+    return drv_statx(vfs, p->path_within_vfs, mask, stx);
+}
+
+TRACED_STATIC int TRACED(xf_vfs_unlink_p)(xf_vfs_path_t *p)
+{
+    const xf_vfs_entry_t *vfs = path_resolve(p);
+    if (vfs == NULL) {
+        return -1;
+    }
+
+    CHECK_VFS_READONLY_FLAG(vfs->flags);
+
+    int ret;
+    CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, unlink, p->path_within_vfs);
+    return ret;
+}
+
+TRACED_STATIC xf_vfs_dir_t *TRACED(xf_vfs_opendir_p)(xf_vfs_path_t *p)
+{
+    const xf_vfs_entry_t *vfs = path_resolve(p);
+    if (vfs == NULL) {
+        return NULL;
+    }
+    xf_vfs_dir_t *ret;
+    CHECK_AND_CALL_SUBCOMPONENTP(ret, r, vfs, dir, opendir, p->path_within_vfs);
+    if (ret != NULL) {
+        ret->dd_vfs_idx = vfs->offset;
+    }
+    return ret;
+}
+
+TRACED_STATIC int TRACED(xf_vfs_utime)(const char *path, const xf_vfs_utimbuf_t *times)
 {
     int ret;
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(path);
@@ -745,7 +1505,7 @@ int xf_vfs_utime(const char *path, const xf_vfs_utimbuf_t *times)
     return ret;
 }
 
-int xf_vfs_link(const char *n1, const char *n2)
+TRACED_STATIC int TRACED(xf_vfs_link)(const char *n1, const char *n2)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(n1);
     if (vfs == NULL) {
@@ -767,7 +1527,7 @@ int xf_vfs_link(const char *n1, const char *n2)
     return ret;
 }
 
-int xf_vfs_unlink(const char *path)
+TRACED_STATIC int TRACED(xf_vfs_unlink)(const char *path)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(path);
     if (vfs == NULL) {
@@ -783,7 +1543,7 @@ int xf_vfs_unlink(const char *path)
     return ret;
 }
 
-int xf_vfs_rename(const char *src, const char *dst)
+TRACED_STATIC int TRACED(xf_vfs_rename)(const char *src, const char *dst)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(src);
     if (vfs == NULL) {
@@ -808,7 +1568,7 @@ int xf_vfs_rename(const char *src, const char *dst)
     return ret;
 }
 
-xf_vfs_dir_t *xf_vfs_opendir(const char *name)
+TRACED_STATIC xf_vfs_dir_t *TRACED(xf_vfs_opendir)(const char *name)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(name);
     if (vfs == NULL) {
@@ -824,7 +1584,7 @@ xf_vfs_dir_t *xf_vfs_opendir(const char *name)
     return ret;
 }
 
-xf_vfs_dirent_t *xf_vfs_readdir(xf_vfs_dir_t *pdir)
+TRACED_STATIC xf_vfs_dirent_t *TRACED(xf_vfs_readdir)(xf_vfs_dir_t *pdir)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(pdir->dd_vfs_idx);
     if (vfs == NULL) {
@@ -836,7 +1596,7 @@ xf_vfs_dirent_t *xf_vfs_readdir(xf_vfs_dir_t *pdir)
     return ret;
 }
 
-int xf_vfs_readdir_r(xf_vfs_dir_t *pdir, xf_vfs_dirent_t *entry, xf_vfs_dirent_t **out_dirent)
+TRACED_STATIC int TRACED(xf_vfs_readdir_r)(xf_vfs_dir_t *pdir, xf_vfs_dirent_t *entry, xf_vfs_dirent_t **out_dirent)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(pdir->dd_vfs_idx);
     if (vfs == NULL) {
@@ -848,7 +1608,7 @@ int xf_vfs_readdir_r(xf_vfs_dir_t *pdir, xf_vfs_dirent_t *entry, xf_vfs_dirent_t
     return ret;
 }
 
-long xf_vfs_telldir(xf_vfs_dir_t *pdir)
+TRACED_STATIC long TRACED(xf_vfs_telldir)(xf_vfs_dir_t *pdir)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(pdir->dd_vfs_idx);
     if (vfs == NULL) {
@@ -860,7 +1620,7 @@ long xf_vfs_telldir(xf_vfs_dir_t *pdir)
     return ret;
 }
 
-void xf_vfs_seekdir(xf_vfs_dir_t *pdir, long loc)
+TRACED_STATIC void TRACED(xf_vfs_seekdir)(xf_vfs_dir_t *pdir, long loc)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(pdir->dd_vfs_idx);
     if (vfs == NULL) {
@@ -875,7 +1635,7 @@ void xf_vfs_rewinddir(xf_vfs_dir_t *pdir)
     xf_vfs_seekdir(pdir, 0);
 }
 
-int xf_vfs_closedir(xf_vfs_dir_t *pdir)
+TRACED_STATIC int TRACED(xf_vfs_closedir)(xf_vfs_dir_t *pdir)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(pdir->dd_vfs_idx);
     if (vfs == NULL) {
@@ -887,7 +1647,48 @@ int xf_vfs_closedir(xf_vfs_dir_t *pdir)
     return ret;
 }
 
-int xf_vfs_mkdir(const char *name, xf_vfs_mode_t mode)
+TRACED_STATIC xf_vfs_ssize_t TRACED(xf_vfs_getdents)(xf_vfs_dir_t *pdir, void *buf, size_t len)
+{
+    const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(pdir->dd_vfs_idx);
+    if (vfs == NULL) {
+        errno = EBADF;
+        return -1;
+    }
+    if (buf == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+    /* 返回值为 xf_vfs_ssize_t，一次最多填充其能表示的字节数 */
+    const size_t len_max = (size_t)(~0u >> 1);
+    if (len > len_max) {
+        len = len_max;
+    }
+    if (vfs->vfs->dir != NULL && vfs->vfs->dir->getdents != NULL) {
+        xf_vfs_ssize_t ret;
+        CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, getdents, pdir, buf, len);
+        return ret;
+    }
+    return getdents_readdir(vfs, pdir, (uint8_t *)buf, len);
+}
+
+size_t xf_vfs_dirent_rec_fill(void *buf, size_t len, xf_vfs_ino_t ino, uint8_t type,
+                              const char *name, size_t namlen)
+{
+    const size_t reclen = XF_VFS_DIRENT_REC_LEN(namlen);
+    if (reclen > len || namlen >= XF_VFS_DIRENT_NAME_SIZE) {
+        return 0;
+    }
+    xf_vfs_dirent_rec_t *rec = (xf_vfs_dirent_rec_t *)buf;
+    rec->d_ino = ino;
+    rec->d_reclen = (uint16_t)reclen;
+    rec->d_namlen = (uint16_t)namlen;
+    rec->d_type = type;
+    xf_memcpy(rec->d_name, name, namlen);
+    rec->d_name[namlen] = '\0';
+    return reclen;
+}
+
+TRACED_STATIC int TRACED(xf_vfs_mkdir)(const char *name, xf_vfs_mode_t mode)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(name);
     if (vfs == NULL) {
@@ -903,7 +1704,7 @@ int xf_vfs_mkdir(const char *name, xf_vfs_mode_t mode)
     return ret;
 }
 
-int xf_vfs_rmdir(const char *name)
+TRACED_STATIC int TRACED(xf_vfs_rmdir)(const char *name)
 {
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(name);
     if (vfs == NULL) {
@@ -919,7 +1720,179 @@ int xf_vfs_rmdir(const char *name)
     return ret;
 }
 
-int xf_vfs_access(const char *path, int amode)
+TRACED_STATIC xf_vfs_dirat_t *TRACED(xf_vfs_dirat_open)(const char *path)
+{
+    const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(path);
+    if (vfs == NULL) {
+        errno = ENOENT;
+        return NULL;
+    }
+    const char *path_within_vfs = translate_path(vfs, path);
+    size_t len = xf_strlen(path_within_vfs);
+    /* 去掉结尾的 '/'，保留根目录 "/" */
+    while (len > 1 && path_within_vfs[len - 1] == '/') {
+        --len;
+    }
+    xf_vfs_dirat_t *dir = VFS_ALLOC(s_dirat_pool, sizeof(xf_vfs_dirat_t) + len + 1);
+    if (dir == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    dir->vfs_index = vfs->offset;
+    dir->pdir = NULL;
+    dir->len = len;
+    xf_memcpy(dir->path, path_within_vfs, len);
+    dir->path[len] = '\0';
+
+    if (dirat_has_at_ops(vfs)) {
+        CHECK_AND_CALL_SUBCOMPONENTP(dir->pdir, r, vfs, dir, opendir, dir->path);
+        if (dir->pdir == NULL) {
+            VFS_FREE(s_dirat_pool, dir);
+            return NULL;
+        }
+        dir->pdir->dd_vfs_idx = vfs->offset;
+        return dir;
+    }
+
+    /* 驱动不支持 *at 函数时只检查 path 是目录，不支持 stat 的驱动不检查 */
+    xf_vfs_statx_t stx;
+    if (drv_statx(vfs, dir->path, XF_VFS_STATX_TYPE, &stx) == 0) {
+        if ((stx.stx_mask & XF_VFS_STATX_TYPE) && (stx.stx_mode & XF_VFS_S_IFMT) != XF_VFS_S_IFDIR) {
+            VFS_FREE(s_dirat_pool, dir);
+            errno = ENOTDIR;
+            return NULL;
+        }
+    } else if (errno != ENOSYS) {
+        VFS_FREE(s_dirat_pool, dir);
+        return NULL;
+    }
+    return dir;
+}
+
+TRACED_STATIC int TRACED(xf_vfs_dirat_close)(xf_vfs_dirat_t *dir)
+{
+    if (dir == NULL) {
+        errno = EBADF;
+        return -1;
+    }
+    int ret = 0;
+    if (dir->pdir != NULL) {
+        ret = TRACED(xf_vfs_closedir)(dir->pdir);
+    }
+    VFS_FREE(s_dirat_pool, dir);
+    return ret;
+}
+
+TRACED_STATIC int TRACED(xf_vfs_openat)(xf_vfs_dirat_t *dir, const char *name, int flags, int mode)
+{
+    if (dir == NULL || name[0] == '/') {
+        return TRACED(xf_vfs_open)(name, flags, mode);
+    }
+    const xf_vfs_entry_t *vfs = dirat_get_vfs(dir, name);
+    if (vfs == NULL) {
+        return -1;
+    }
+    if ((flags & XF_VFS_O_ACCMODE) != XF_VFS_O_RDONLY && (vfs->flags & XF_VFS_FLAG_READONLY_FS)) {
+        errno = EROFS;
+        return -1;
+    }
+    void *handle = NULL;
+    int fd_within_vfs;
+    if (dir->pdir != NULL && !IS_HANDLE_MODE(vfs) && vfs->vfs->dir->openat != NULL) {
+        CHECK_AND_CALL_SUBCOMPONENT(fd_within_vfs, r, vfs, dir, openat, dir->pdir, name, flags, mode);
+    } else {
+        char buf[XF_VFS_AT_PATH_MAX];
+        if (dirat_join(dir, name, buf) < 0) {
+            return -1;
+        }
+        fd_within_vfs = drv_open(vfs, buf, flags, mode, &handle);
+    }
+    /* 与 dirat_join 的结果散列相同，openat 与 open 同一文件时使用同一把追加写锁 */
+    return fd_install(vfs, fd_within_vfs, handle, flags,
+                      append_lock_index(vfs, flags, dir->path, dir->len, name));
+}
+
+TRACED_STATIC int TRACED(xf_vfs_fstatat)(xf_vfs_dirat_t *dir, const char *name, xf_vfs_stat_t *st)
+{
+    if (dir == NULL || name[0] == '/') {
+        return TRACED(xf_vfs_stat)(name, st);
+    }
+    const xf_vfs_entry_t *vfs = dirat_get_vfs(dir, name);
+    if (vfs == NULL) {
+        return -1;
+    }
+    int ret;
+    if (dir->pdir != NULL && vfs->vfs->dir->fstatat != NULL) {
+        CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, fstatat, dir->pdir, name, st);
+        return ret;
+    }
+    char buf[XF_VFS_AT_PATH_MAX];
+    if (dirat_join(dir, name, buf) < 0) {
+        return -1;
+    }
+    CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, stat, buf, st);
+    return ret;
+}
+
+TRACED_STATIC int TRACED(xf_vfs_unlinkat)(xf_vfs_dirat_t *dir, const char *name, int flags)
+{
+    if (flags & ~XF_VFS_AT_REMOVEDIR) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (dir == NULL || name[0] == '/') {
+        return (flags & XF_VFS_AT_REMOVEDIR) ? TRACED(xf_vfs_rmdir)(name) : TRACED(xf_vfs_unlink)(name);
+    }
+    const xf_vfs_entry_t *vfs = dirat_get_vfs(dir, name);
+    if (vfs == NULL) {
+        return -1;
+    }
+
+    CHECK_VFS_READONLY_FLAG(vfs->flags);
+
+    int ret;
+    if (dir->pdir != NULL && vfs->vfs->dir->unlinkat != NULL) {
+        CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, unlinkat, dir->pdir, name, flags);
+        return ret;
+    }
+    char buf[XF_VFS_AT_PATH_MAX];
+    if (dirat_join(dir, name, buf) < 0) {
+        return -1;
+    }
+    if (flags & XF_VFS_AT_REMOVEDIR) {
+        CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, rmdir, buf);
+    } else {
+        CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, unlink, buf);
+    }
+    return ret;
+}
+
+TRACED_STATIC int TRACED(xf_vfs_mkdirat)(xf_vfs_dirat_t *dir, const char *name, xf_vfs_mode_t mode)
+{
+    if (dir == NULL || name[0] == '/') {
+        return TRACED(xf_vfs_mkdir)(name, mode);
+    }
+    const xf_vfs_entry_t *vfs = dirat_get_vfs(dir, name);
+    if (vfs == NULL) {
+        return -1;
+    }
+
+    CHECK_VFS_READONLY_FLAG(vfs->flags);
+
+    int ret;
+    if (dir->pdir != NULL && vfs->vfs->dir->mkdirat != NULL) {
+        CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, mkdirat, dir->pdir, name, mode);
+        return ret;
+    }
+    char buf[XF_VFS_AT_PATH_MAX];
+    if (dirat_join(dir, name, buf) < 0) {
+        return -1;
+    }
+    CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, mkdir, buf, mode);
+    return ret;
+}
+
+TRACED_STATIC int TRACED(xf_vfs_access)(const char *path, int amode)
 {
     int ret;
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(path);
@@ -933,6 +1906,11 @@ int xf_vfs_access(const char *path, int amode)
 }
 
 int xf_vfs_truncate(const char *path, xf_vfs_off_t length)
+{
+    return xf_vfs_truncate64(path, length);
+}
+
+TRACED_STATIC int TRACED(xf_vfs_truncate64)(const char *path, xf_vfs_off64_t length)
 {
     int ret;
     const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(path);
@@ -944,11 +1922,24 @@ int xf_vfs_truncate(const char *path, xf_vfs_off_t length)
     CHECK_VFS_READONLY_FLAG(vfs->flags);
 
     const char *path_within_vfs = translate_path(vfs, path);
-    CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, truncate, path_within_vfs, length);
+    if (vfs->vfs->dir != NULL && vfs->vfs->dir->truncate64 != NULL) {
+        CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, truncate64, path_within_vfs, length);
+        return ret;
+    }
+    if (!OFF_FITS(length)) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, truncate, path_within_vfs, (xf_vfs_off_t)length);
     return ret;
 }
 
 int xf_vfs_ftruncate(int fd, xf_vfs_off_t length)
+{
+    return xf_vfs_ftruncate64(fd, length);
+}
+
+TRACED_STATIC int TRACED(xf_vfs_ftruncate64)(int fd, xf_vfs_off64_t length)
 {
     const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
     int local_fd = get_local_fd(vfs, fd);
@@ -959,9 +1950,7 @@ int xf_vfs_ftruncate(int fd, xf_vfs_off_t length)
 
     CHECK_VFS_READONLY_FLAG(vfs->flags);
 
-    int ret;
-    CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, ftruncate, local_fd, length);
-    return ret;
+    return drv_ftruncate64(vfs, get_handle_for_fd(fd), local_fd, length);
 }
 
 #endif // CONFIG_XF_VFS_SUPPORT_DIR
@@ -1025,80 +2014,340 @@ static int set_global_fd_sets(const fds_triple_t *vfs_fds_triple, int size, xf_f
     return ret;
 }
 
-static void xf_vfs_log_fd_set(const char *fds_name, const xf_fd_set *fds)
+static void select_waiter_thread(void *argument)
 {
-    if (fds_name && fds) {
-        XF_LOGD(TAG, "FDs in %s =", fds_name);
-        for (int i = 0; i < XF_VFS_FDS_MAX; ++i) {
-            if (xf_vfs_safe_fd_isset(i, fds)) {
-                XF_LOGD(TAG, "%d", i);
-            }
+    select_waiter_t *w = argument;
+    w->sem = w->ops->get_socket_select_semaphore();
+    for (;;) {
+        xf_osal_semaphore_acquire(w->go, XF_OSAL_WAIT_FOREVER);
+        select_socket_t *job = w->job;
+        if (job == NULL) {
+            break;
+        }
+        xf_osal_semaphore_release(job->sync);
+
+        job->ret = w->ops->socket_select(job->nfds, &job->fds->readfds, &job->fds->writefds, &job->fds->errorfds,
+                                         job->has_timeout ? &job->timeout : NULL);
+        job->err = errno;
+        xf_osal_semaphore_release(job->wake);
+
+        // Wait until every socket_select has been stopped, then clear a stop that came after socket_select returned.
+        // The semaphore belongs to this thread.
+        xf_osal_semaphore_acquire(job->stopped, XF_OSAL_WAIT_FOREVER);
+        xf_osal_semaphore_acquire(w->sem, 0);
+        xf_osal_semaphore_t sync = job->sync; // job is freed as soon as the caller sees the last release
+        const bool kept = select_waiter_put(w);
+        xf_osal_semaphore_release(sync);
+        if (!kept) {
+            break;
         }
     }
+    xf_osal_semaphore_delete(w->go);
+    VFS_FREE(s_waiter_pool, w);
+    xf_osal_thread_delete(NULL);
 }
 
-int xf_vfs_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds, xf_vfs_timeval_t *timeout)
+/* 取一个 VFS 当前注册的空闲等待线程，没有时创建 */
+static select_waiter_t *select_waiter_take(int vfs_index, const xf_vfs_select_ops_t *ops)
 {
-    // NOTE: Please see the "Synchronous input/output multiplexing" section of the ESP-IDF Programming Guide
-    // (API Reference -> Storage -> Virtual Filesystem) for a general overview of the implementation of VFS select().
-    int ret = 0;
-
-    XF_LOGD(TAG, "xf_vfs_select starts with nfds = %d", nfds);
-    if (timeout) {
-        XF_LOGD(TAG, "timeout is %lds + %ldus", (long)timeout->tv_sec, timeout->tv_usec);
+    select_waiter_t *stale = NULL;
+    select_waiter_t *w;
+    _lock_acquire(s_select_waiter_lock);
+    const uint32_t generation = s_select_generation[vfs_index];
+    /* 属于之前注册的线程全部结束 */
+    while ((w = s_select_waiters[vfs_index]) != NULL) {
+        s_select_waiters[vfs_index] = w->next;
+        if (w->generation == generation) {
+            break;
+        }
+        w->next = stale;
+        stale = w;
     }
-    xf_vfs_log_fd_set("readfds", readfds);
-    xf_vfs_log_fd_set("writefds", writefds);
-    xf_vfs_log_fd_set("errorfds", errorfds);
-
-    if (nfds > XF_VFS_FDS_MAX || nfds < 0) {
-        XF_LOGD(TAG, "incorrect nfds");
-        errno = EINVAL;
-        return -1;
+    _lock_release(s_select_waiter_lock);
+    while (stale != NULL) {
+        select_waiter_t *next = stale->next;
+        select_waiter_exit(stale);
+        stale = next;
+    }
+    if (w != NULL) {
+        return w;
     }
 
-    // Capture s_vfs_count to a local variable in case a new driver is registered or removed during this actual select()
-    // call. s_vfs_count cannot be protected with a mutex during a select() call (which can be one without a timeout)
-    // because that could block the registration of new driver.
+    w = VFS_ALLOC(s_waiter_pool, sizeof(select_waiter_t));
+    if (w == NULL) {
+        return NULL;
+    }
+    xf_memset(w, 0, sizeof(select_waiter_t));
+    w->vfs_index = vfs_index;
+    w->generation = generation;
+    w->ops = ops;
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "sel_sock",
+    };
+    w->go = xf_osal_semaphore_create(1, 0, &sem_attr);
+    const xf_osal_thread_attr_t thread_attr = {
+        .name = "sel_sock",
+        .stack_size = XF_VFS_SELECT_SOCKET_STACK_SIZE,
+        .priority = XF_VFS_SELECT_SOCKET_PRIORITY,
+    };
+    if (w->go == NULL || xf_osal_thread_create(select_waiter_thread, w, &thread_attr) == NULL) {
+        if (w->go != NULL) {
+            xf_osal_semaphore_delete(w->go);
+        }
+        VFS_FREE(s_waiter_pool, w);
+        return NULL;
+    }
+    XF_LOGD(TAG, "started a socket_select thread for VFS ID %d", vfs_index);
+    return w;
+}
+
+/* 放回空闲链表；VFS 已在这次 select 期间注销时返回 false，线程应结束 */
+static bool select_waiter_put(select_waiter_t *w)
+{
+    _lock_acquire(s_select_waiter_lock);
+    const bool current = (w->generation == s_select_generation[w->vfs_index]);
+    if (current) {
+        w->next = s_select_waiters[w->vfs_index];
+        s_select_waiters[w->vfs_index] = w;
+    }
+    _lock_release(s_select_waiter_lock);
+    return current;
+}
+
+static void select_waiter_exit(select_waiter_t *w)
+{
+    w->job = NULL;
+    xf_osal_semaphore_release(w->go);
+}
+
+/* VFS 注销时结束它空闲的等待线程，正在使用的线程在这次 select 结束时由 select_waiter_put() 结束 */
+static void select_waiters_forget(int vfs_index)
+{
+    if (s_select_waiter_lock == NULL) {
+        return;
+    }
+    _lock_acquire(s_select_waiter_lock);
+    ++s_select_generation[vfs_index];
+    select_waiter_t *w = s_select_waiters[vfs_index];
+    s_select_waiters[vfs_index] = NULL;
+    _lock_release(s_select_waiter_lock);
+    while (w != NULL) {
+        select_waiter_t *next = w->next;
+        select_waiter_exit(w);
+        w = next;
+    }
+}
+
+/**
+ * @brief 每个 socket 类 VFS 的 socket_select 在它的等待线程中运行，返回时都释放同一个 wake 信号量，
+ * 第一个返回的（或其他 VFS 的 xf_vfs_select_triggered()）唤醒调用者，再由调用者停止其余的。
+ *
+ * @return 就绪 fd 的总数，已合并到 readfds、writefds、errorfds；失败时返回 -1 并设置 errno.
+ */
+static int select_sockets(int nfds, fds_triple_t *vfs_fds_triple, size_t vfs_count, int socket_count,
+                          xf_osal_semaphore_t wake, uint32_t ticks_to_wait, const xf_vfs_timeval_t *timeout,
+                          xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds)
+{
+#if XF_VFS_NO_HEAP_IS_ENABLE
+    select_socket_t jobs[XF_VFS_MAX_COUNT];
+#else
+    select_socket_t *jobs = xf_vfs_malloc(socket_count * sizeof(select_socket_t));
+    if (jobs == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+#endif
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "sel_sock",
+    };
+    xf_osal_semaphore_t sync = xf_osal_semaphore_create(socket_count, 0, &sem_attr);
+    xf_osal_semaphore_t stopped = xf_osal_semaphore_create(socket_count, 0, &sem_attr);
+
+    int started = 0;
+    bool failed = (sync == NULL || stopped == NULL);
+    for (size_t i = 0; i < vfs_count && !failed && started < socket_count; ++i) {
+        const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(i);
+        if (!vfs_fds_triple[i].is_socket || vfs == NULL || vfs->vfs->select == NULL) {
+            continue;
+        }
+        select_waiter_t *w = select_waiter_take((int)i, vfs->vfs->select);
+        if (w == NULL) {
+            failed = true;
+            break;
+        }
+        select_socket_t *job = &jobs[started];
+        *job = (select_socket_t) {
+            .waiter = w,
+            .fds = &vfs_fds_triple[i],
+            .nfds = nfds,
+            .has_timeout = (timeout != NULL),
+            .wake = wake,
+            .sync = sync,
+            .stopped = stopped,
+        };
+        if (timeout) {
+            job->timeout = *timeout;
+        }
+        XF_LOGD(TAG, "calling socket_select of VFS ID %d in its waiter thread", (int)i);
+        w->job = job;
+        xf_osal_semaphore_release(w->go);
+        ++started;
+    }
+
+    // Every waiter has its socket semaphore before any stop_socket_select
+    for (int i = 0; i < started; ++i) {
+        xf_osal_semaphore_acquire(sync, XF_OSAL_WAIT_FOREVER);
+    }
+    if (!failed) {
+        xf_osal_semaphore_acquire(wake, ticks_to_wait);
+    }
+    for (int i = 0; i < started; ++i) {
+        const select_waiter_t *w = jobs[i].waiter;
+        if (w->ops->stop_socket_select != NULL) {
+            w->ops->stop_socket_select(w->sem);
+        }
+    }
+    for (int i = 0; i < started; ++i) {
+        xf_osal_semaphore_release(stopped);
+    }
+    for (int i = 0; i < started; ++i) {
+        xf_osal_semaphore_acquire(sync, XF_OSAL_WAIT_FOREVER);
+    }
+
+    int ret = 0;
+    if (failed) {
+        errno = ENOMEM;
+        ret = -1;
+        XF_LOGD(TAG, "cannot get socket_select threads");
+    }
+    for (int i = 0; i < started && ret >= 0; ++i) {
+        if (jobs[i].ret < 0) {
+            errno = jobs[i].err;
+            ret = -1;
+            break;
+        }
+        ret += jobs[i].ret;
+        for (int fd = 0; fd < nfds; ++fd) {
+            if (readfds && XF_FD_ISSET(fd, &jobs[i].fds->readfds)) {
+                XF_FD_SET(fd, readfds);
+            }
+            if (writefds && XF_FD_ISSET(fd, &jobs[i].fds->writefds)) {
+                XF_FD_SET(fd, writefds);
+            }
+            if (errorfds && XF_FD_ISSET(fd, &jobs[i].fds->errorfds)) {
+                XF_FD_SET(fd, errorfds);
+            }
+        }
+    }
+
+    if (sync) {
+        xf_osal_semaphore_delete(sync);
+    }
+    if (stopped) {
+        xf_osal_semaphore_delete(stopped);
+    }
+    SELECT_FREE(jobs);
+    return ret;
+}
+
+static void xf_vfs_log_fd_set(const char *fds_name, const xf_fd_set *fds)
+{
+    if (fds_name && fds) {
+        XF_LOGD(TAG, "FDs in %s =", fds_name);
+        for (int i = 0; i < XF_VFS_FDS_MAX; ++i) {
+            if (xf_vfs_safe_fd_isset(i, fds)) {
+                XF_LOGD(TAG, "%d", i);
+            }
+        }
+    }
+}
+
+TRACED_STATIC int TRACED(xf_vfs_select)(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds, xf_vfs_timeval_t *timeout)
+{
+    // NOTE: Please see the "Synchronous input/output multiplexing" section of the ESP-IDF Programming Guide
+    // (API Reference -> Storage -> Virtual Filesystem) for a general overview of the implementation of VFS select().
+    int ret = 0;
+
+    XF_LOGD(TAG, "xf_vfs_select starts with nfds = %d", nfds);
+    if (timeout) {
+        XF_LOGD(TAG, "timeout is %lds + %ldus", (long)timeout->tv_sec, timeout->tv_usec);
+    }
+    xf_vfs_log_fd_set("readfds", readfds);
+    xf_vfs_log_fd_set("writefds", writefds);
+    xf_vfs_log_fd_set("errorfds", errorfds);
+
+    if (nfds > XF_VFS_FDS_MAX || nfds < 0) {
+        XF_LOGD(TAG, "incorrect nfds");
+        errno = EINVAL;
+        return -1;
+    }
+
+    // Capture s_vfs_count to a local variable in case a new driver is registered or removed during this actual select()
+    // call. s_vfs_count cannot be protected with a mutex during a select() call (which can be one without a timeout)
+    // because that could block the registration of new driver.
     const size_t vfs_count = s_vfs_count;
+#if XF_VFS_NO_HEAP_IS_ENABLE
+    fds_triple_t vfs_fds_triple[XF_VFS_MAX_COUNT];
+#else
     fds_triple_t *vfs_fds_triple;
-    vfs_fds_triple = xf_malloc(vfs_count * sizeof(fds_triple_t));
+    vfs_fds_triple = xf_vfs_malloc(vfs_count * sizeof(fds_triple_t));
     if (vfs_fds_triple == NULL) {
         errno = ENOMEM;
         XF_LOGD(TAG, "calloc is unsuccessful");
         return -1;
     }
+#endif
     xf_memset(vfs_fds_triple, 0, vfs_count * sizeof(fds_triple_t));
 
     xf_vfs_select_sem_t sel_sem = {
         .is_sem_local = false,
         .sem = NULL,
+        .socket_vfs = -1,
     };
 
-    int (*socket_select)(int, xf_fd_set *, xf_fd_set *, xf_fd_set *, xf_vfs_timeval_t *) = NULL;
+    // Socket FDs stay in the global sets and are also collected per socket VFS, in case there are several
+    int socket_count = 0;
+    int socket_vfs = -1;
+    const xf_vfs_select_ops_t *socket_ops = NULL;
     for (int fd = 0; fd < nfds; ++fd) {
-        _lock_acquire(s_fd_table_lock);
+        fd_shard_lock(FD_SHARD(fd));
         const bool is_socket_fd = s_fd_table[fd].permanent;
         const int vfs_index = s_fd_table[fd].vfs_index;
         const int local_fd = s_fd_table[fd].local_fd;
         if (xf_vfs_safe_fd_isset(fd, errorfds)) {
             s_fd_table[fd].has_pending_select = true;
         }
-        _lock_release(s_fd_table_lock);
+        fd_shard_unlock(FD_SHARD(fd));
 
         if (vfs_index < 0) {
             continue;
         }
 
         if (is_socket_fd) {
-            if (!socket_select) {
-                // no socket_select found yet so take a look
-                if (xf_vfs_safe_fd_isset(fd, readfds) ||
-                        xf_vfs_safe_fd_isset(fd, writefds) ||
-                        xf_vfs_safe_fd_isset(fd, errorfds)) {
-                    const xf_vfs_entry_t *vfs = s_vfs[vfs_index];
-                    socket_select = vfs->vfs->select->socket_select;
-                    sel_sem.sem = vfs->vfs->select->get_socket_select_semaphore();
+            const xf_vfs_entry_t *vfs = s_vfs[vfs_index];
+            fds_triple_t *item = &vfs_fds_triple[vfs_index];
+            if (vfs == NULL || vfs->vfs->select == NULL || vfs->vfs->select->socket_select == NULL) {
+                continue;
+            }
+            if (!xf_vfs_safe_fd_isset(fd, readfds) &&
+                    !xf_vfs_safe_fd_isset(fd, writefds) &&
+                    !xf_vfs_safe_fd_isset(fd, errorfds)) {
+                continue;
+            }
+            if (xf_vfs_safe_fd_isset(fd, readfds)) {
+                XF_FD_SET(fd, &item->readfds);
+            }
+            if (xf_vfs_safe_fd_isset(fd, writefds)) {
+                XF_FD_SET(fd, &item->writefds);
+            }
+            if (xf_vfs_safe_fd_isset(fd, errorfds)) {
+                XF_FD_SET(fd, &item->errorfds);
+            }
+            if (!item->is_socket) {
+                item->is_socket = true;
+                if (++socket_count == 1) {
+                    socket_vfs = vfs_index;
+                    socket_ops = vfs->vfs->select;
                 }
             }
             continue;
@@ -1129,30 +2378,38 @@ int xf_vfs_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *
     // the global readfds, writefds and errorfds contain only socket FDs (if
     // there any)
 
-    if (!socket_select) {
+    if (socket_count == 1) {
+        sel_sem.sem = socket_ops->get_socket_select_semaphore();
+        sel_sem.socket_vfs = socket_vfs;
+    } else {
         // There is no socket VFS registered or select() wasn't called for
         // any socket. Therefore, we will use our own signalization.
+        // With several socket VFSes their socket_select threads signal it as well.
         sel_sem.is_sem_local = true;
         xf_osal_semaphore_attr_t sem_attr = {
             .name = "sem",
         };
-        sel_sem.sem = (void *)xf_osal_semaphore_create(1, 1, &sem_attr);
+        sel_sem.sem = (void *)xf_osal_semaphore_create(1, 0, &sem_attr);
         if (sel_sem.sem == NULL) {
-            xf_free(vfs_fds_triple);
+            SELECT_FREE(vfs_fds_triple);
             errno = ENOMEM;
             XF_LOGD(TAG, "cannot create select semaphore");
             return -1;
         }
     }
 
-    void **driver_args = xf_malloc(vfs_count * sizeof(void *));
+#if XF_VFS_NO_HEAP_IS_ENABLE
+    void *driver_args[XF_VFS_MAX_COUNT];
+#else
+    void **driver_args = xf_vfs_malloc(vfs_count * sizeof(void *));
 
     if (driver_args == NULL) {
-        xf_free(vfs_fds_triple);
+        xf_vfs_free(vfs_fds_triple);
         errno = ENOMEM;
         XF_LOGD(TAG, "calloc is unsuccessful for driver args");
         return -1;
     }
+#endif
     xf_memset(driver_args, 0, vfs_count * sizeof(void *));
 
     for (size_t i = 0; i < vfs_count; ++i) {
@@ -1186,20 +2443,20 @@ int xf_vfs_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *
                 xf_osal_semaphore_delete(sel_sem.sem);
                 sel_sem.sem = NULL;
             }
-            xf_free(vfs_fds_triple);
-            xf_free(driver_args);
+            SELECT_FREE(vfs_fds_triple);
+            SELECT_FREE(driver_args);
             errno = EINTR;
             XF_LOGD(TAG, "start_select failed: %s", xf_err_to_name(err));
             return -1;
         }
     }
 
-    if (socket_select) {
+    if (socket_count == 1) {
         XF_LOGD(TAG, "calling socket_select with the following FDs");
         xf_vfs_log_fd_set("readfds", readfds);
         xf_vfs_log_fd_set("writefds", writefds);
         xf_vfs_log_fd_set("errorfds", errorfds);
-        ret = socket_select(nfds, readfds, writefds, errorfds, timeout);
+        ret = socket_ops->socket_select(nfds, readfds, writefds, errorfds, timeout);
         XF_LOGD(TAG, "socket_select returned %d and the FDs are the following", ret);
         xf_vfs_log_fd_set("readfds", readfds);
         xf_vfs_log_fd_set("writefds", writefds);
@@ -1228,8 +2485,14 @@ int xf_vfs_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *
             ticks_to_wait = xf_osal_kernel_ms_to_ticks(timeout_ms) + 1;
             XF_LOGD(TAG, "timeout is %" PRIu32 "ms", timeout_ms);
         }
-        XF_LOGD(TAG, "waiting without calling socket_select");
-        xf_osal_semaphore_acquire(sel_sem.sem, ticks_to_wait);
+        if (socket_count > 1) {
+            ret = select_sockets(nfds, vfs_fds_triple, vfs_count, socket_count, sel_sem.sem, ticks_to_wait, timeout,
+                                 readfds, writefds, errorfds);
+            XF_LOGD(TAG, "socket_select of %d VFSes returned %d", socket_count, ret);
+        } else {
+            XF_LOGD(TAG, "waiting without calling socket_select");
+            xf_osal_semaphore_acquire(sel_sem.sem, ticks_to_wait);
+        }
     }
 
     call_end_selects(vfs_count, vfs_fds_triple, driver_args); // for VFSs for start_select was called before
@@ -1240,7 +2503,7 @@ int xf_vfs_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *
     if (sel_sem.sem) { // Cleanup the select semaphore
         if (sel_sem.is_sem_local) {
             xf_osal_semaphore_delete(sel_sem.sem);
-        } else if (socket_select) {
+        } else {
             // SemaphoreHandle_t *s = sel_sem.sem;
             // /* Select might have been triggered from both lwip and vfs fds at the same time, and
             //  * we have to make sure that the lwip semaphore is cleared when we exit select().
@@ -1250,15 +2513,17 @@ int xf_vfs_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *
         }
         sel_sem.sem = NULL;
     }
-    _lock_acquire(s_fd_table_lock);
-    for (int fd = 0; fd < nfds; ++fd) {
-        if (s_fd_table[fd].has_pending_close) {
-            s_fd_table[fd] = FD_TABLE_ENTRY_UNUSED;
+    for (int shard = 0; shard < FD_SHARD_COUNT && FD_SHARD_BEGIN(shard) < nfds; ++shard) {
+        fd_shard_lock(shard);
+        for (int fd = FD_SHARD_BEGIN(shard); fd < FD_SHARD_END(shard) && fd < nfds; ++fd) {
+            if (s_fd_table[fd].has_pending_close) {
+                s_fd_table[fd] = FD_TABLE_ENTRY_UNUSED; // 打开文件描述的引用已在 close 时释放
+            }
         }
+        fd_shard_unlock(shard);
     }
-    _lock_release(s_fd_table_lock);
-    xf_free(vfs_fds_triple);
-    xf_free(driver_args);
+    SELECT_FREE(vfs_fds_triple);
+    SELECT_FREE(driver_args);
 
     XF_LOGD(TAG, "xf_vfs_select returns %d", ret);
     xf_vfs_log_fd_set("readfds", readfds);
@@ -1272,20 +2537,16 @@ void xf_vfs_select_triggered(xf_vfs_select_sem_t sem)
     if (sem.is_sem_local) {
         xf_osal_semaphore_release(sem.sem);
     } else {
-        // Another way would be to go through s_fd_table and find the VFS
-        // which has a permanent FD. But in order to avoid to lock
-        // s_fd_table_lock we go through the VFS table.
-        for (int i = 0; i < s_vfs_count; ++i) {
-            // Note: s_vfs_count could have changed since the start of vfs_select() call. However, that change doesn't
-            // matter here stop_socket_select() will be called for only valid VFS drivers.
-            const xf_vfs_entry_t *vfs = s_vfs[i];
-            if (vfs != NULL
-                    && vfs->vfs->select != NULL
-                    && vfs->vfs->select->stop_socket_select != NULL
-               ) {
-                vfs->vfs->select->stop_socket_select(sem.sem);
-                break;
-            }
+        // The semaphore belongs to the socket VFS that xf_vfs_select() is waiting in, which is not necessarily
+        // the first socket VFS registered.
+        // Note: the VFS could have been unregistered since the start of vfs_select() call. stop_socket_select() is
+        // called for valid VFS drivers only.
+        const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(sem.socket_vfs);
+        if (vfs != NULL
+                && vfs->vfs->select != NULL
+                && vfs->vfs->select->stop_socket_select != NULL
+           ) {
+            vfs->vfs->select->stop_socket_select(sem.sem);
         }
     }
 }
@@ -1297,177 +2558,454 @@ void xf_vfs_select_triggered_isr(xf_vfs_select_sem_t sem, int *woken)
         /* TODO 未处理 woken */
         xf_osal_semaphore_release(sem.sem);
     } else {
-        // Another way would be to go through s_fd_table and find the VFS
-        // which has a permanent FD. But in order to avoid to lock
-        // s_fd_table_lock we go through the VFS table.
-        for (int i = 0; i < s_vfs_count; ++i) {
-            // Note: s_vfs_count could have changed since the start of vfs_select() call. However, that change doesn't
-            // matter here stop_socket_select() will be called for only valid VFS drivers.
-            const xf_vfs_entry_t *vfs = s_vfs[i];
-            if (vfs != NULL
-                    && vfs->vfs->select != NULL
-                    && vfs->vfs->select->stop_socket_select_isr != NULL
-               ) {
-                // Note: If the UART ISR resides in IRAM, the function referenced by stop_socket_select_isr should also be placed in IRAM.
-                vfs->vfs->select->stop_socket_select_isr(sem.sem, woken);
-                break;
-            }
+        // See xf_vfs_select_triggered()
+        const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(sem.socket_vfs);
+        if (vfs != NULL
+                && vfs->vfs->select != NULL
+                && vfs->vfs->select->stop_socket_select_isr != NULL
+           ) {
+            // Note: If the UART ISR resides in IRAM, the function referenced by stop_socket_select_isr should also be placed in IRAM.
+            vfs->vfs->select->stop_socket_select_isr(sem.sem, woken);
         }
     }
 }
 
 #endif // XF_VFS_SUPPORT_SELECT_IS_ENABLE
 
-/* ==================== [Static Functions] ================================== */
+/* ==================== [Trace] ============================================= */
 
-static xf_vfs_ssize_t xf_get_free_index(void)
+#if XF_VFS_TRACE_IS_ENABLE
+
+/*
+ * 包装函数的函数体：调用 call 并写入跟踪记录。
+ * vfs_index 在调用前求值（close 之后 fd 已失效），fd、size 与 result 在调用后求值，可以引用 ret.
+ */
+#define TRACE_CALL(type, call, op, fd, vfs_index, size, result) \
+    const uint64_t start = xf_vfs_trace_begin(); \
+    const int trace_vfs = (start != 0) ? (vfs_index) : -1; \
+    type ret = call; \
+    xf_vfs_trace_end(start, op, fd, trace_vfs, size, result); \
+    return ret
+
+#define TRACE_FD_CALL(type, call, op, fd, size) \
+    TRACE_CALL(type, call, op, fd, trace_fd_vfs(fd), size, ret)
+
+int xf_vfs_open(const char *path, int flags, int mode)
 {
-    for (xf_vfs_ssize_t i = 0; i < XF_VFS_MAX_COUNT; i++) {
-        if (s_vfs[i] == NULL) {
-            return i;
-        }
-    }
-    return -1;
+    TRACE_CALL(int, traced_xf_vfs_open(path, flags, mode),
+               XF_VFS_TRACE_OP_OPEN, ret, trace_path_vfs(path), 0, ret);
 }
 
-static void xf_vfs_free_fs_ops(xf_vfs_fs_ops_t *vfs)
+int xf_vfs_open_p(xf_vfs_path_t *p, int flags, int mode)
 {
-// We can afford to cast away the const qualifier here, because we know that we allocated the struct and therefore its safe
+    TRACE_CALL(int, traced_xf_vfs_open_p(p, flags, mode),
+               XF_VFS_TRACE_OP_OPEN, ret, trace_path_p_vfs(p), 0, ret);
+}
 
-#if XF_VFS_SUPPORT_DIR_IS_ENABLE
-    xf_free((void *)vfs->dir);
-#endif
+xf_vfs_ssize_t xf_vfs_write(int fd, const void *data, size_t size)
+{
+    TRACE_FD_CALL(xf_vfs_ssize_t, traced_xf_vfs_write(fd, data, size), XF_VFS_TRACE_OP_WRITE, fd, size);
+}
 
-#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
-    xf_free((void *)vfs->select);
-#endif
+xf_vfs_off64_t xf_vfs_lseek64(int fd, xf_vfs_off64_t offset, int mode)
+{
+    TRACE_FD_CALL(xf_vfs_off64_t, traced_xf_vfs_lseek64(fd, offset, mode), XF_VFS_TRACE_OP_LSEEK, fd, 0);
+}
 
-    xf_free(vfs);
+xf_vfs_ssize_t xf_vfs_read(int fd, void *dst, size_t size)
+{
+    TRACE_FD_CALL(xf_vfs_ssize_t, traced_xf_vfs_read(fd, dst, size), XF_VFS_TRACE_OP_READ, fd, size);
 }
 
-static void xf_vfs_free_entry(xf_vfs_entry_t *entry)
+xf_vfs_ssize_t xf_vfs_pread64(int fd, void *dst, size_t size, xf_vfs_off64_t offset)
 {
-    if (entry == NULL) { // Necessary because of the following flags check
-        return;
-    }
+    TRACE_FD_CALL(xf_vfs_ssize_t, traced_xf_vfs_pread64(fd, dst, size, offset), XF_VFS_TRACE_OP_PREAD, fd, size);
+}
 
-    if (!(entry->flags & XF_VFS_FLAG_STATIC)) {
-        xf_vfs_free_fs_ops((xf_vfs_fs_ops_t *)entry->vfs); // const cast, but we know it's not static from the flag
-    }
+xf_vfs_ssize_t xf_vfs_pwrite64(int fd, const void *src, size_t size, xf_vfs_off64_t offset)
+{
+    TRACE_FD_CALL(xf_vfs_ssize_t, traced_xf_vfs_pwrite64(fd, src, size, offset), XF_VFS_TRACE_OP_PWRITE, fd, size);
+}
 
-    xf_free(entry);
+int xf_vfs_close(int fd)
+{
+    TRACE_FD_CALL(int, traced_xf_vfs_close(fd), XF_VFS_TRACE_OP_CLOSE, fd, 0);
 }
 
-static xf_vfs_fs_ops_t *xf_minify_vfs(const xf_vfs_t *const vfs, vfs_component_proxy_t proxy)
+int xf_vfs_dup(int fd)
 {
-    XF_CHECK(vfs == NULL, NULL, TAG, "vfs is NULL");
-#if XF_VFS_SUPPORT_DIR_IS_ENABLE
-    // If the dir functions are not implemented, we don't need to convert them
-    if (proxy.dir != NULL) {
-        xf_vfs_dir_ops_t tmp = {
-            .stat = vfs->stat,
-            .link = vfs->link,
-            .unlink = vfs->unlink,
-            .rename = vfs->rename,
-            .opendir = vfs->opendir,
-            .readdir = vfs->readdir,
-            .readdir_r = vfs->readdir_r,
-            .telldir = vfs->telldir,
-            .seekdir = vfs->seekdir,
-            .closedir = vfs->closedir,
-            .mkdir = vfs->mkdir,
-            .rmdir = vfs->rmdir,
-            .access = vfs->access,
-            .truncate = vfs->truncate,
-            .ftruncate = vfs->ftruncate,
-            .utime = vfs->utime,
-        };
+    TRACE_FD_CALL(int, traced_xf_vfs_dup(fd), XF_VFS_TRACE_OP_DUP, fd, 0);
+}
 
-        xf_memcpy(proxy.dir, &tmp, sizeof(xf_vfs_dir_ops_t));
-    }
-#endif // CONFIG_XF_VFS_SUPPORT_DIR
+int xf_vfs_dup2(int fd, int fd2)
+{
+    TRACE_FD_CALL(int, traced_xf_vfs_dup2(fd, fd2), XF_VFS_TRACE_OP_DUP, fd, 0);
+}
 
-#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
-    // If the select functions are not implemented, we don't need to convert them
-    if (proxy.select != NULL) {
-        xf_vfs_select_ops_t tmp = {
-            .start_select = vfs->start_select,
-            .socket_select = vfs->socket_select,
-            .stop_socket_select = vfs->stop_socket_select,
-            .stop_socket_select_isr = vfs->stop_socket_select_isr,
-            .get_socket_select_semaphore = vfs->get_socket_select_semaphore,
-            .end_select = vfs->end_select,
-        };
+int xf_vfs_fstat(int fd, xf_vfs_stat_t *st)
+{
+    TRACE_FD_CALL(int, traced_xf_vfs_fstat(fd, st), XF_VFS_TRACE_OP_FSTAT, fd, 0);
+}
 
-        xf_memcpy(proxy.select, &tmp, sizeof(xf_vfs_select_ops_t));
-    }
-#endif // XF_VFS_SUPPORT_SELECT_IS_ENABLE
+int xf_vfs_fstat64(int fd, xf_vfs_stat64_t *st)
+{
+    TRACE_FD_CALL(int, traced_xf_vfs_fstat64(fd, st), XF_VFS_TRACE_OP_FSTAT, fd, 0);
+}
+
+int xf_vfs_fstatx(int fd, uint32_t mask, xf_vfs_statx_t *stx)
+{
+    TRACE_FD_CALL(int, traced_xf_vfs_fstatx(fd, mask, stx), XF_VFS_TRACE_OP_FSTAT, fd, 0);
+}
+
+int xf_vfs_fcntl_r(int fd, int cmd, int arg)
+{
+    TRACE_FD_CALL(int, traced_xf_vfs_fcntl_r(fd, cmd, arg), XF_VFS_TRACE_OP_FCNTL, fd, 0);
+}
+
+int xf_vfs_fsync(int fd)
+{
+    TRACE_FD_CALL(int, traced_xf_vfs_fsync(fd), XF_VFS_TRACE_OP_FSYNC, fd, 0);
+}
 
-    xf_vfs_fs_ops_t tmp = {
-        .write = vfs->write,
-        .lseek = vfs->lseek,
-        .read = vfs->read,
-        .pread = vfs->pread,
-        .pwrite = vfs->pwrite,
-        .open = vfs->open,
-        .close = vfs->close,
-        .fstat = vfs->fstat,
-        .fcntl = vfs->fcntl,
-        .ioctl = vfs->ioctl,
-        .fsync = vfs->fsync,
 #if XF_VFS_SUPPORT_DIR_IS_ENABLE
-        .dir = proxy.dir,
-#endif
-#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
-        .select = proxy.select,
-#endif
-    };
 
-    xf_vfs_fs_ops_t *out = xf_malloc(sizeof(xf_vfs_fs_ops_t));
-    if (out == NULL) {
-        return NULL;
-    }
+int xf_vfs_stat(const char *path, xf_vfs_stat_t *st)
+{
+    TRACE_CALL(int, traced_xf_vfs_stat(path, st), XF_VFS_TRACE_OP_STAT, -1, trace_path_vfs(path), 0, ret);
+}
 
-    // Doing this is the only way to correctly initialize const members of a struct according to C standard
-    xf_memcpy(out, &tmp, sizeof(xf_vfs_fs_ops_t));
+int xf_vfs_statx(const char *path, uint32_t mask, xf_vfs_statx_t *stx)
+{
+    TRACE_CALL(int, traced_xf_vfs_statx(path, mask, stx), XF_VFS_TRACE_OP_STAT, -1, trace_path_vfs(path), 0, ret);
+}
 
-    return out;
+int xf_vfs_stat_p(xf_vfs_path_t *p, xf_vfs_stat_t *st)
+{
+    TRACE_CALL(int, traced_xf_vfs_stat_p(p, st), XF_VFS_TRACE_OP_STAT, -1, trace_path_p_vfs(p), 0, ret);
 }
 
-static void free_proxy_members(vfs_component_proxy_t *proxy)
+int xf_vfs_statx_p(xf_vfs_path_t *p, uint32_t mask, xf_vfs_statx_t *stx)
 {
-#if XF_VFS_SUPPORT_DIR_IS_ENABLE
-    xf_free(proxy->dir);
-#endif
-#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
-    xf_free(proxy->select);
-#endif
+    TRACE_CALL(int, traced_xf_vfs_statx_p(p, mask, stx), XF_VFS_TRACE_OP_STAT, -1, trace_path_p_vfs(p), 0, ret);
 }
 
-static xf_vfs_fs_ops_t *xf_vfs_duplicate_fs_ops(const xf_vfs_fs_ops_t *orig)
+int xf_vfs_unlink_p(xf_vfs_path_t *p)
 {
-    vfs_component_proxy_t proxy = {};
+    TRACE_CALL(int, traced_xf_vfs_unlink_p(p), XF_VFS_TRACE_OP_UNLINK, -1, trace_path_p_vfs(p), 0, ret);
+}
 
-#if XF_VFS_SUPPORT_DIR_IS_ENABLE
-    if (orig->dir != NULL) {
-        proxy.dir = (xf_vfs_dir_ops_t *) xf_malloc(sizeof(xf_vfs_dir_ops_t));
-        if (proxy.dir == NULL) {
-            goto fail;
-        }
+xf_vfs_dir_t *xf_vfs_opendir_p(xf_vfs_path_t *p)
+{
+    TRACE_CALL(xf_vfs_dir_t *, traced_xf_vfs_opendir_p(p),
+               XF_VFS_TRACE_OP_OPENDIR, -1, trace_path_p_vfs(p), 0, (ret != NULL) ? 0 : -1);
+}
+
+int xf_vfs_utime(const char *path, const xf_vfs_utimbuf_t *times)
+{
+    TRACE_CALL(int, traced_xf_vfs_utime(path, times), XF_VFS_TRACE_OP_UTIME, -1, trace_path_vfs(path), 0, ret);
+}
+
+int xf_vfs_link(const char *n1, const char *n2)
+{
+    TRACE_CALL(int, traced_xf_vfs_link(n1, n2), XF_VFS_TRACE_OP_LINK, -1, trace_path_vfs(n1), 0, ret);
+}
+
+int xf_vfs_unlink(const char *path)
+{
+    TRACE_CALL(int, traced_xf_vfs_unlink(path), XF_VFS_TRACE_OP_UNLINK, -1, trace_path_vfs(path), 0, ret);
+}
+
+int xf_vfs_rename(const char *src, const char *dst)
+{
+    TRACE_CALL(int, traced_xf_vfs_rename(src, dst), XF_VFS_TRACE_OP_RENAME, -1, trace_path_vfs(src), 0, ret);
+}
+
+xf_vfs_dir_t *xf_vfs_opendir(const char *name)
+{
+    TRACE_CALL(xf_vfs_dir_t *, traced_xf_vfs_opendir(name),
+               XF_VFS_TRACE_OP_OPENDIR, -1, trace_path_vfs(name), 0, (ret != NULL) ? 0 : -1);
+}
+
+/* 目录结束与出错都返回 NULL，result 记录读到的项数 */
+xf_vfs_dirent_t *xf_vfs_readdir(xf_vfs_dir_t *pdir)
+{
+    TRACE_CALL(xf_vfs_dirent_t *, traced_xf_vfs_readdir(pdir),
+               XF_VFS_TRACE_OP_READDIR, -1, trace_dir_vfs(pdir), 0, (ret != NULL) ? 1 : 0);
+}
+
+int xf_vfs_readdir_r(xf_vfs_dir_t *pdir, xf_vfs_dirent_t *entry, xf_vfs_dirent_t **out_dirent)
+{
+    TRACE_CALL(int, traced_xf_vfs_readdir_r(pdir, entry, out_dirent),
+               XF_VFS_TRACE_OP_READDIR, -1, trace_dir_vfs(pdir), 0, ret);
+}
+
+long xf_vfs_telldir(xf_vfs_dir_t *pdir)
+{
+    TRACE_CALL(long, traced_xf_vfs_telldir(pdir), XF_VFS_TRACE_OP_TELLDIR, -1, trace_dir_vfs(pdir), 0, ret);
+}
+
+void xf_vfs_seekdir(xf_vfs_dir_t *pdir, long loc)
+{
+    const uint64_t start = xf_vfs_trace_begin();
+    traced_xf_vfs_seekdir(pdir, loc);
+    xf_vfs_trace_end(start, XF_VFS_TRACE_OP_SEEKDIR, -1, (start != 0) ? trace_dir_vfs(pdir) : -1, 0, 0);
+}
+
+int xf_vfs_closedir(xf_vfs_dir_t *pdir)
+{
+    TRACE_CALL(int, traced_xf_vfs_closedir(pdir), XF_VFS_TRACE_OP_CLOSEDIR, -1, trace_dir_vfs(pdir), 0, ret);
+}
+
+xf_vfs_ssize_t xf_vfs_getdents(xf_vfs_dir_t *pdir, void *buf, size_t len)
+{
+    TRACE_CALL(xf_vfs_ssize_t, traced_xf_vfs_getdents(pdir, buf, len),
+               XF_VFS_TRACE_OP_GETDENTS, -1, trace_dir_vfs(pdir), len, ret);
+}
+
+int xf_vfs_mkdir(const char *name, xf_vfs_mode_t mode)
+{
+    TRACE_CALL(int, traced_xf_vfs_mkdir(name, mode), XF_VFS_TRACE_OP_MKDIR, -1, trace_path_vfs(name), 0, ret);
+}
+
+int xf_vfs_rmdir(const char *name)
+{
+    TRACE_CALL(int, traced_xf_vfs_rmdir(name), XF_VFS_TRACE_OP_RMDIR, -1, trace_path_vfs(name), 0, ret);
+}
+
+xf_vfs_dirat_t *xf_vfs_dirat_open(const char *path)
+{
+    TRACE_CALL(xf_vfs_dirat_t *, traced_xf_vfs_dirat_open(path),
+               XF_VFS_TRACE_OP_OPENDIR, -1, trace_path_vfs(path), 0, (ret != NULL) ? 0 : -1);
+}
+
+int xf_vfs_dirat_close(xf_vfs_dirat_t *dir)
+{
+    TRACE_CALL(int, traced_xf_vfs_dirat_close(dir), XF_VFS_TRACE_OP_CLOSEDIR, -1, trace_dirat_vfs(dir, NULL), 0, ret);
+}
+
+int xf_vfs_openat(xf_vfs_dirat_t *dir, const char *name, int flags, int mode)
+{
+    TRACE_CALL(int, traced_xf_vfs_openat(dir, name, flags, mode),
+               XF_VFS_TRACE_OP_OPEN, ret, trace_dirat_vfs(dir, name), 0, ret);
+}
+
+int xf_vfs_fstatat(xf_vfs_dirat_t *dir, const char *name, xf_vfs_stat_t *st)
+{
+    TRACE_CALL(int, traced_xf_vfs_fstatat(dir, name, st), XF_VFS_TRACE_OP_STAT, -1, trace_dirat_vfs(dir, name), 0, ret);
+}
+
+int xf_vfs_unlinkat(xf_vfs_dirat_t *dir, const char *name, int flags)
+{
+    TRACE_CALL(int, traced_xf_vfs_unlinkat(dir, name, flags),
+               XF_VFS_TRACE_OP_UNLINK, -1, trace_dirat_vfs(dir, name), 0, ret);
+}
+
+int xf_vfs_mkdirat(xf_vfs_dirat_t *dir, const char *name, xf_vfs_mode_t mode)
+{
+    TRACE_CALL(int, traced_xf_vfs_mkdirat(dir, name, mode), XF_VFS_TRACE_OP_MKDIR, -1, trace_dirat_vfs(dir, name), 0, ret);
+}
+
+int xf_vfs_access(const char *path, int amode)
+{
+    TRACE_CALL(int, traced_xf_vfs_access(path, amode), XF_VFS_TRACE_OP_ACCESS, -1, trace_path_vfs(path), 0, ret);
+}
+
+int xf_vfs_truncate64(const char *path, xf_vfs_off64_t length)
+{
+    TRACE_CALL(int, traced_xf_vfs_truncate64(path, length),
+               XF_VFS_TRACE_OP_TRUNCATE, -1, trace_path_vfs(path), (length > 0) ? (size_t)length : 0, ret);
+}
+
+int xf_vfs_ftruncate64(int fd, xf_vfs_off64_t length)
+{
+    TRACE_FD_CALL(int, traced_xf_vfs_ftruncate64(fd, length),
+                  XF_VFS_TRACE_OP_FTRUNCATE, fd, (length > 0) ? (size_t)length : 0);
+}
+
+#endif // XF_VFS_SUPPORT_DIR_IS_ENABLE
+
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+int xf_vfs_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds, xf_vfs_timeval_t *timeout)
+{
+    TRACE_CALL(int, traced_xf_vfs_select(nfds, readfds, writefds, errorfds, timeout),
+               XF_VFS_TRACE_OP_SELECT, -1, -1, 0, ret);
+}
+#endif // XF_VFS_SUPPORT_SELECT_IS_ENABLE
+
+#endif // XF_VFS_TRACE_IS_ENABLE
+
+/* ==================== [Static Functions] ================================== */
+
+static xf_vfs_ssize_t xf_get_free_index(void)
+{
+    for (xf_vfs_ssize_t i = 0; i < XF_VFS_MAX_COUNT; i++) {
+        if (s_vfs[i] == NULL) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void xf_vfs_free_entry(xf_vfs_entry_t *entry)
+{
+    if (entry == NULL) { // Necessary because of the following flags check
+        return;
+    }
+
+#if XF_VFS_STATIC_MOUNTS_IS_ENABLE
+    // Compile-time mounts are neither allocated nor copied
+    if (entry >= s_static_vfs && entry < s_static_vfs + XF_VFS_STATIC_MOUNT_COUNT) {
+        return;
+    }
+#endif
+
+    const xf_vfs_fs_ops_t *ops = entry->vfs;
+#if XF_VFS_SUPPORT_EXECUTOR_IS_ENABLE
+    if (entry->flags & XF_VFS_FLAG_EXECUTOR) {
+        ops = xf_vfs_executor_destroy(entry->ctx);
+    }
+#endif
+    if (!(entry->flags & XF_VFS_FLAG_STATIC)) {
+        xf_vfs_release_fs_ops(ops);
+    }
+
+    // The entry and its path prefix are a single allocation
+    VFS_FREE(s_entry_pool, entry);
+}
+
+static void xf_minify_vfs(const xf_vfs_t *const vfs, vfs_component_proxy_t proxy, xf_vfs_fs_ops_t *out)
+{
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    // If the dir functions are not implemented, we don't need to convert them
+    if (proxy.dir != NULL) {
+        xf_vfs_dir_ops_t tmp = {
+            .stat = vfs->stat,
+            .link = vfs->link,
+            .unlink = vfs->unlink,
+            .rename = vfs->rename,
+            .opendir = vfs->opendir,
+            .readdir = vfs->readdir,
+            .readdir_r = vfs->readdir_r,
+            .telldir = vfs->telldir,
+            .seekdir = vfs->seekdir,
+            .closedir = vfs->closedir,
+            .mkdir = vfs->mkdir,
+            .rmdir = vfs->rmdir,
+            .access = vfs->access,
+            .truncate = vfs->truncate,
+            .ftruncate = vfs->ftruncate,
+            .utime = vfs->utime,
+            .truncate64 = vfs->truncate64,
+            .ftruncate64 = vfs->ftruncate64,
+            .getdents = vfs->getdents,
+            .statx = vfs->statx,
+            .openat = vfs->openat,
+            .fstatat = vfs->fstatat,
+            .unlinkat = vfs->unlinkat,
+            .mkdirat = vfs->mkdirat,
+        };
+
+        xf_memcpy(proxy.dir, &tmp, sizeof(xf_vfs_dir_ops_t));
+    }
+#endif // CONFIG_XF_VFS_SUPPORT_DIR
+
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+    // If the select functions are not implemented, we don't need to convert them
+    if (proxy.select != NULL) {
+        xf_vfs_select_ops_t tmp = {
+            .start_select = vfs->start_select,
+            .socket_select = vfs->socket_select,
+            .stop_socket_select = vfs->stop_socket_select,
+            .stop_socket_select_isr = vfs->stop_socket_select_isr,
+            .get_socket_select_semaphore = vfs->get_socket_select_semaphore,
+            .end_select = vfs->end_select,
+        };
+
+        xf_memcpy(proxy.select, &tmp, sizeof(xf_vfs_select_ops_t));
+    }
+#endif // XF_VFS_SUPPORT_SELECT_IS_ENABLE
+
+    xf_vfs_fs_ops_t tmp = {
+        .write = vfs->write,
+        .lseek = vfs->lseek,
+        .read = vfs->read,
+        .pread = vfs->pread,
+        .pwrite = vfs->pwrite,
+        .open = vfs->open,
+        .close = vfs->close,
+        .fstat = vfs->fstat,
+        .fcntl = vfs->fcntl,
+        .ioctl = vfs->ioctl,
+        .fsync = vfs->fsync,
+        .lseek64 = vfs->lseek64,
+        .pread64 = vfs->pread64,
+        .pwrite64 = vfs->pwrite64,
+        .fstat64 = vfs->fstat64,
+        .fstatx = vfs->fstatx,
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+        .dir = proxy.dir,
+#endif
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+        .select = proxy.select,
+#endif
+    };
+
+    // Doing this is the only way to correctly initialize const members of a struct according to C standard
+    xf_memcpy(out, &tmp, sizeof(xf_vfs_fs_ops_t));
+}
+
+static size_t xf_vfs_fs_ops_size(const xf_vfs_fs_ops_t *orig)
+{
+    size_t size = sizeof(xf_vfs_fs_ops_t);
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    if (orig->dir != NULL) {
+        size += sizeof(xf_vfs_dir_ops_t);
+    }
+#endif
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+    if (orig->select != NULL) {
+        size += sizeof(xf_vfs_select_ops_t);
+    }
+#endif
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    if (orig->handle != NULL) {
+        size += sizeof(xf_vfs_handle_ops_t);
+    }
+#endif
+    return size;
+}
+
+/* 把 orig 及其子组件深拷贝到 mem 中，mem 的大小由 xf_vfs_fs_ops_size() 给出 */
+static xf_vfs_fs_ops_t *xf_vfs_copy_fs_ops(const xf_vfs_fs_ops_t *orig, uint8_t *mem)
+{
+    xf_vfs_fs_ops_t *out = (xf_vfs_fs_ops_t *)mem;
+    mem += sizeof(xf_vfs_fs_ops_t);
+    vfs_component_proxy_t proxy = {0};
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    if (orig->dir != NULL) {
+        proxy.dir = (xf_vfs_dir_ops_t *)mem;
+        mem += sizeof(xf_vfs_dir_ops_t);
         xf_memcpy(proxy.dir, orig->dir, sizeof(xf_vfs_dir_ops_t));
     }
 #endif
 
 #if XF_VFS_SUPPORT_SELECT_IS_ENABLE
     if (orig->select != NULL) {
-        proxy.select = (xf_vfs_select_ops_t *) xf_malloc(sizeof(xf_vfs_select_ops_t));
-        if (proxy.select == NULL) {
-            goto fail;
-        }
+        proxy.select = (xf_vfs_select_ops_t *)mem;
+        mem += sizeof(xf_vfs_select_ops_t);
         xf_memcpy(proxy.select, orig->select, sizeof(xf_vfs_select_ops_t));
     }
 #endif
 
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    if (orig->handle != NULL) {
+        proxy.handle = (xf_vfs_handle_ops_t *)mem;
+        mem += sizeof(xf_vfs_handle_ops_t);
+        xf_memcpy(proxy.handle, orig->handle, sizeof(xf_vfs_handle_ops_t));
+    }
+#endif
+
     // This tediousness is required because of const members
     xf_vfs_fs_ops_t tmp = {
         .write = orig->write,
@@ -1481,29 +3019,28 @@ static xf_vfs_fs_ops_t *xf_vfs_duplicate_fs_ops(const xf_vfs_fs_ops_t *orig)
         .fcntl = orig->fcntl,
         .ioctl = orig->ioctl,
         .fsync = orig->fsync,
+        .lseek64 = orig->lseek64,
+        .pread64 = orig->pread64,
+        .pwrite64 = orig->pwrite64,
+        .fstat64 = orig->fstat64,
+        .fstatx = orig->fstatx,
 #if XF_VFS_SUPPORT_DIR_IS_ENABLE
         .dir = proxy.dir,
 #endif
 #if XF_VFS_SUPPORT_SELECT_IS_ENABLE
         .select = proxy.select,
+#endif
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+        .handle = proxy.handle,
 #endif
     };
 
-    xf_vfs_fs_ops_t *out = xf_malloc(sizeof(xf_vfs_fs_ops_t));
-    if (out == NULL) {
-        goto fail;
-    }
-
     xf_memcpy(out, &tmp, sizeof(xf_vfs_fs_ops_t));
 
     return out;
-
-fail:
-    free_proxy_members(&proxy);
-    return NULL;
 }
 
-static xf_err_t xf_vfs_make_fs_ops(const xf_vfs_t *vfs, xf_vfs_fs_ops_t **min)
+static xf_err_t xf_vfs_make_fs_ops(const xf_vfs_t *vfs, vfs_component_proxy_t proxy, xf_vfs_fs_ops_t *min)
 {
     if (vfs == NULL) {
         XF_LOGE(TAG, "Cannot minify NULL VFS");
@@ -1515,8 +3052,6 @@ static xf_err_t xf_vfs_make_fs_ops(const xf_vfs_t *vfs, xf_vfs_fs_ops_t **min)
         return XF_ERR_INVALID_ARG;
     }
 
-    vfs_component_proxy_t proxy = {};
-
 #if XF_VFS_SUPPORT_DIR_IS_ENABLE
     const bool skip_dir =
         vfs->stat == NULL &&
@@ -1534,13 +3069,18 @@ static xf_err_t xf_vfs_make_fs_ops(const xf_vfs_t *vfs, xf_vfs_fs_ops_t **min)
         vfs->access == NULL &&
         vfs->truncate == NULL &&
         vfs->ftruncate == NULL &&
-        vfs->utime == NULL;
-
-    if (!skip_dir) {
-        proxy.dir = (xf_vfs_dir_ops_t *) xf_malloc(sizeof(xf_vfs_dir_ops_t));
-        if (proxy.dir == NULL) {
-            goto fail;
-        }
+        vfs->utime == NULL &&
+        vfs->truncate64 == NULL &&
+        vfs->ftruncate64 == NULL &&
+        vfs->getdents == NULL &&
+        vfs->statx == NULL &&
+        vfs->openat == NULL &&
+        vfs->fstatat == NULL &&
+        vfs->unlinkat == NULL &&
+        vfs->mkdirat == NULL;
+
+    if (skip_dir) {
+        proxy.dir = NULL;
     }
 #endif
 
@@ -1553,26 +3093,13 @@ static xf_err_t xf_vfs_make_fs_ops(const xf_vfs_t *vfs, xf_vfs_fs_ops_t **min)
         vfs->get_socket_select_semaphore == NULL &&
         vfs->end_select == NULL;
 
-    if (!skip_select) {
-        proxy.select = (xf_vfs_select_ops_t *) xf_malloc(sizeof(xf_vfs_select_ops_t));
-        if (proxy.select == NULL) {
-            goto fail;
-        }
+    if (skip_select) {
+        proxy.select = NULL;
     }
 #endif
 
-    xf_vfs_fs_ops_t *main = xf_minify_vfs(vfs, proxy);
-    if (main == NULL) {
-        goto fail;
-    }
-
-    *min = main;
+    xf_minify_vfs(vfs, proxy, min);
     return XF_OK;
-
-fail:
-
-    free_proxy_members(&proxy);
-    return XF_ERR_NO_MEM;
 }
 
 static xf_err_t xf_vfs_register_fs_common(const char *base_path, size_t len, const xf_vfs_fs_ops_t *vfs, int flags,
@@ -1583,6 +3110,43 @@ static xf_err_t xf_vfs_register_fs_common(const char *base_path, size_t len, con
         return XF_ERR_INVALID_ARG;
     }
 
+    if (flags & XF_VFS_FLAG_HANDLE) {
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+        if (vfs->handle == NULL || vfs->handle->open == NULL) {
+            XF_LOGE(TAG, "Handle mode VFS without handle open");
+            return XF_ERR_INVALID_ARG;
+        }
+#else
+        XF_LOGE(TAG, "Handle mode is disabled");
+        return XF_ERR_INVALID_ARG;
+#endif
+    }
+
+    if (flags & SERIAL_FLAGS) {
+#if XF_VFS_SUPPORT_SERIAL_IS_ENABLE
+        if ((flags & SERIAL_FLAGS) == SERIAL_FLAGS) {
+            XF_LOGE(TAG, "XF_VFS_FLAG_SERIAL_FILE and XF_VFS_FLAG_SERIAL_MOUNT are exclusive");
+            return XF_ERR_INVALID_ARG;
+        }
+#else
+        XF_LOGE(TAG, "Serialization is disabled");
+        return XF_ERR_INVALID_ARG;
+#endif
+    }
+
+    if (flags & XF_VFS_FLAG_EXECUTOR) {
+#if XF_VFS_SUPPORT_EXECUTOR_IS_ENABLE
+        if (flags & SERIAL_FLAGS) {
+            XF_LOGE(TAG, "XF_VFS_FLAG_EXECUTOR already serializes all calls");
+            return XF_ERR_INVALID_ARG;
+        }
+#else
+        XF_LOGE(TAG, "Executor is disabled");
+        return XF_ERR_INVALID_ARG;
+#endif
+    }
+
+    const size_t prefix_len = (len != XF_VFS_PATH_PREFIX_LEN_IGNORED) ? len : 0;
     if (len != XF_VFS_PATH_PREFIX_LEN_IGNORED) {
         /* empty prefix is allowed, "/" is not allowed */
         if ((len == 1) || (len > XF_VFS_PATH_MAX)) {
@@ -1607,30 +3171,99 @@ static xf_err_t xf_vfs_register_fs_common(const char *base_path, size_t len, con
         s_vfs_count++;
     }
 
-    xf_vfs_entry_t *entry = (xf_vfs_entry_t *) xf_malloc(sizeof(xf_vfs_entry_t));
+    /*
+     * Unless XF_VFS_FLAG_STATIC is set, the ops tables are copied once per distinct content
+     * and shared by all mounts of the same driver.
+     */
+    const xf_vfs_fs_ops_t *ops = vfs;
+    if (!(flags & XF_VFS_FLAG_STATIC)) {
+        ops = xf_vfs_intern_fs_ops(vfs);
+        if (ops == NULL) {
+            return XF_ERR_NO_MEM;
+        }
+    }
+
+    // One allocation per mount: [xf_vfs_entry_t][path prefix]
+    xf_vfs_entry_t *entry = (xf_vfs_entry_t *) VFS_ALLOC(s_entry_pool, sizeof(xf_vfs_entry_t) + prefix_len + 1);
     if (entry == NULL) {
+        if (ops != vfs) {
+            xf_vfs_release_fs_ops(ops);
+        }
         return XF_ERR_NO_MEM;
     }
 
-    s_vfs[index] = entry;
-    if (len != XF_VFS_PATH_PREFIX_LEN_IGNORED) {
-        xf_strncpy(entry->path_prefix, base_path, sizeof(entry->path_prefix)); // we have already verified argument length
-    } else {
-        xf_memset(entry->path_prefix, 0, sizeof(entry->path_prefix));
+#if XF_VFS_SUPPORT_SERIAL_IS_ENABLE
+    if ((flags & SERIAL_FLAGS) && xf_vfs_serial_attach(index, flags) != XF_OK) {
+        VFS_FREE(s_entry_pool, entry);
+        if (ops != vfs) {
+            xf_vfs_release_fs_ops(ops);
+        }
+        return XF_ERR_NO_MEM;
     }
-    entry->path_prefix_len = len;
-    entry->vfs = vfs;
-    entry->ctx = ctx;
-    entry->offset = index;
-    entry->flags = flags;
+#endif
 
-    if (vfs_index) {
+#if XF_VFS_SUPPORT_EXECUTOR_IS_ENABLE
+    /* 挂载点注册执行线程的代理，代理以执行线程为上下文调用驱动 */
+    if (flags & XF_VFS_FLAG_EXECUTOR) {
+        void *executor = xf_vfs_executor_create(ops, flags, ctx);
+        if (executor == NULL) {
+            VFS_FREE(s_entry_pool, entry);
+            if (ops != vfs) {
+                xf_vfs_release_fs_ops(ops);
+            }
+            return XF_ERR_NO_MEM;
+        }
+        ops = xf_vfs_executor_ops(executor);
+        ctx = executor;
+        flags |= XF_VFS_FLAG_CONTEXT_PTR;
+    }
+#endif
+
+    s_vfs[index] = entry;
+    entry->vfs = ops;
+    char *path_prefix = (char *)(entry + 1);
+    xf_memcpy(path_prefix, base_path, prefix_len); // we have already verified argument length
+    path_prefix[prefix_len] = '\0';
+    uint32_t hash = XF_VFS_PREFIX_HASH_INIT;
+    for (size_t i = 0; i < prefix_len; ++i) {
+        hash = prefix_hash_step(hash, path_prefix[i]);
+    }
+    entry->path_prefix = path_prefix;
+    entry->path_prefix_hash = hash;
+    entry->path_prefix_len = len;
+    entry->ctx = ctx;
+    entry->offset = index;
+    entry->flags = flags;
+    prefix_len_max_refresh();
+    ++s_vfs_generation;
+
+    if (vfs_index) {
         *vfs_index = index;
     }
 
     return XF_OK;
 }
 
+/* 重新计算 s_vfs_prefix_len_max，只在注册与注销时调用 */
+static void prefix_len_max_refresh(void)
+{
+    size_t len_max = 0;
+    for (size_t i = 0; i < s_vfs_count; ++i) {
+        const xf_vfs_entry_t *vfs = s_vfs[i];
+        if (vfs != NULL && vfs->path_prefix_len != XF_VFS_PATH_PREFIX_LEN_IGNORED
+                && vfs->path_prefix_len > len_max) {
+            len_max = vfs->path_prefix_len;
+        }
+    }
+    s_vfs_prefix_len_max = len_max;
+}
+
+/* FNV-1a */
+static inline uint32_t prefix_hash_step(uint32_t hash, char c)
+{
+    return (hash ^ (uint8_t)c) * 16777619u;
+}
+
 static inline bool fd_valid(int fd)
 {
     return (fd < XF_VFS_FDS_MAX) && (fd >= 0);
@@ -1667,3 +3300,915 @@ static const char *translate_path(const xf_vfs_entry_t *vfs, const char *src_pat
     }
     return src_path + vfs->path_prefix_len;
 }
+
+/*
+ * 取得路径句柄对应的挂载点，挂载表变化后先重新解析。
+ * 没有匹配的挂载点时返回 NULL 并设置 errno.
+ */
+static const xf_vfs_entry_t *path_resolve(xf_vfs_path_t *p)
+{
+    if (p == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    const uint32_t generation = s_vfs_generation;
+    if (p->generation != generation) {
+        const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(p->path);
+        p->vfs_index = -1;
+        if (vfs != NULL) {
+            p->path_within_vfs = (p->len == vfs->path_prefix_len) ? "/" : p->path + vfs->path_prefix_len;
+            p->vfs_index = vfs->offset;
+        }
+        p->generation = generation;
+    }
+    const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(p->vfs_index);
+    if (vfs == NULL) {
+        errno = ENOENT;
+    }
+    return vfs;
+}
+
+static int vfs_open(const xf_vfs_entry_t *vfs, const char *path_within_vfs, int flags, int mode)
+{
+    int acc_mode = flags & XF_VFS_O_ACCMODE;
+    int ro_filesystem = vfs->flags & XF_VFS_FLAG_READONLY_FS;
+    if (acc_mode != XF_VFS_O_RDONLY && ro_filesystem) {
+        errno = EROFS;
+        return -1;
+    }
+
+    void *handle = NULL;
+    const int fd_within_vfs = drv_open(vfs, path_within_vfs, flags, mode, &handle);
+    return fd_install(vfs, fd_within_vfs, handle, flags,
+                      append_lock_index(vfs, flags, path_within_vfs, xf_strlen(path_within_vfs), NULL));
+}
+
+static xf_vfs_ssize_t vfs_write(const xf_vfs_entry_t *vfs, int fd, int local_fd, const void *data, size_t size)
+{
+    file_table_t *file = get_file_for_fd(vfs, fd);
+    if (file) {
+        return offset_write(vfs, file, local_fd, data, size);
+    }
+    xf_vfs_ssize_t ret;
+    CHECK_AND_CALL_FD(ret, r, vfs, get_handle_for_fd(fd), write, local_fd, data, size);
+    return ret;
+}
+
+static xf_vfs_ssize_t vfs_read(const xf_vfs_entry_t *vfs, int fd, int local_fd, void *dst, size_t size)
+{
+    file_table_t *file = get_file_for_fd(vfs, fd);
+    if (file) {
+        return offset_read(vfs, file, local_fd, dst, size);
+    }
+    xf_vfs_ssize_t ret;
+    CHECK_AND_CALL_FD(ret, r, vfs, get_handle_for_fd(fd), read, local_fd, dst, size);
+    return ret;
+}
+
+static int vfs_fsync(const xf_vfs_entry_t *vfs, int fd, int local_fd)
+{
+    int ret;
+    CHECK_AND_CALL_FD(ret, r, vfs, get_handle_for_fd(fd), fsync, local_fd);
+    return ret;
+}
+
+static xf_vfs_ssize_t vfs_pwrite(const xf_vfs_entry_t *vfs, int fd, int local_fd,
+                                 const void *src, size_t size, xf_vfs_off64_t offset)
+{
+#if XF_VFS_MERGE_IS_ENABLE
+    if (xf_vfs_merge_active(vfs->offset)) {
+        /* 句柄模式下 local fd 总是 0，以句柄区分驱动文件 */
+        const uintptr_t key = IS_HANDLE_MODE(vfs) ? (uintptr_t)get_handle_for_fd(fd) : (uintptr_t)local_fd;
+        return xf_vfs_merge_pwrite(vfs->offset, fd, key, src, size, offset);
+    }
+#endif
+    return drv_pwrite64(vfs, get_handle_for_fd(fd), local_fd, src, size, offset);
+}
+
+static void fd_table_lock_init(void)
+{
+    for (int shard = 0; shard < FD_SHARD_COUNT; ++shard) {
+        if (s_fd_shards[shard].lock == NULL) {
+            xf_lock_init(&s_fd_shards[shard].lock);
+        }
+    }
+    for (int i = 0; i < XF_VFS_APPEND_LOCKS; ++i) {
+        if (s_append_locks[i] == NULL) {
+            xf_lock_init(&s_append_locks[i]);
+        }
+    }
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+    if (s_select_waiter_lock == NULL) {
+        xf_lock_init(&s_select_waiter_lock);
+    }
+#endif
+}
+
+static inline void fd_shard_lock(int shard)
+{
+    _lock_acquire(s_fd_shards[shard].lock);
+}
+
+static inline void fd_shard_unlock(int shard)
+{
+    _lock_release(s_fd_shards[shard].lock);
+}
+
+/* 同时锁住两个分片，总是先锁编号小的分片以避免死锁 */
+static void fd_shard_lock_pair(int shard, int shard2)
+{
+    fd_shard_lock((shard < shard2) ? shard : shard2);
+    if (shard != shard2) {
+        fd_shard_lock((shard < shard2) ? shard2 : shard);
+    }
+}
+
+static void fd_shard_unlock_pair(int shard, int shard2)
+{
+    fd_shard_unlock(shard);
+    if (shard != shard2) {
+        fd_shard_unlock(shard2);
+    }
+}
+
+static void fd_table_lock_all(void)
+{
+    for (int shard = 0; shard < FD_SHARD_COUNT; ++shard) {
+        fd_shard_lock(shard);
+    }
+}
+
+static void fd_table_unlock_all(void)
+{
+    for (int shard = FD_SHARD_COUNT - 1; shard >= 0; --shard) {
+        fd_shard_unlock(shard);
+    }
+}
+
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+/*
+ * 注销句柄模式的挂载点时删除它的 fd，并对仍打开的句柄调用驱动的 close.
+ * 这种驱动没有自己的 fd 表，打开文件描述被丢弃后这些句柄就无法再回收。
+ */
+static void fd_table_close_handles(const xf_vfs_entry_t *vfs)
+{
+    if (!IS_HANDLE_MODE(vfs)) {
+        return;
+    }
+    fd_table_lock_all();
+    for (int j = 0; j < XF_VFS_FDS_MAX; ++j) {
+        if (s_fd_table[j].vfs_index == vfs->offset) {
+            s_fd_table[j] = FD_TABLE_ENTRY_UNUSED;
+#if XF_VFS_QOS_IS_ENABLE
+            xf_vfs_qos_fd_reset(j);
+#endif
+        }
+    }
+    fd_table_unlock_all();
+
+    /* 逐个取下记录后在锁外调用驱动 */
+    for (int j = 0; j < XF_VFS_FDS_MAX; ++j) {
+        void *handle = NULL;
+        fd_table_lock_all();
+        if (XF_VFS_ATOMIC_REF_LOAD(&s_file_table[j].refcnt) != 0 && s_file_table[j].vfs_index == vfs->offset) {
+            handle = s_file_table[j].handle;
+            XF_VFS_ATOMIC_REF_STORE(&s_file_table[j].refcnt, 0);
+        }
+        fd_table_unlock_all();
+        if (handle != NULL && vfs->vfs->handle->close != NULL) {
+            int ret;
+            DRIVER_CALL(vfs, close, handle, ret = (*vfs->vfs->handle->close)(vfs->ctx, handle));
+            (void) ret;
+        }
+    }
+}
+#endif
+
+/*
+ * 新 fd 优先从哪个分片分配。
+ * 各线程的栈地址不同，按栈地址散列可让线程大体固定在各自的分片上，
+ * 既不需要线程 ID，也不会像轮转计数器那样引入新的共享写。
+ */
+static inline int fd_shard_hint(void)
+{
+#if FD_SHARD_COUNT > 1
+    int marker;
+    const uint32_t h = (uint32_t)((uintptr_t)&marker >> 10) * 2654435761u;
+    return (int)((h >> 16) % FD_SHARD_COUNT);
+#else
+    return 0;
+#endif
+}
+
+/*
+ * 打开文件描述的引用计数是原子变量，file_table_* 不需要加锁；
+ * 从 start 开始查找空闲项，调用者传入 fd 使各分片使用的打开文件描述也大体分开。
+ */
+static int file_table_alloc(int start, int vfs_index, int local_fd)
+{
+    for (int n = 0; n < XF_VFS_FDS_MAX; ++n) {
+        const int i = (start + n) % XF_VFS_FDS_MAX;
+        uint16_t expected = 0;
+        if (XF_VFS_ATOMIC_REF_LOAD(&s_file_table[i].refcnt) == 0
+                && XF_VFS_ATOMIC_REF_CAS(&s_file_table[i].refcnt, &expected, 1)) {
+            s_file_table[i].vfs_index = vfs_index;
+            s_file_table[i].local_fd = local_fd;
+            s_file_table[i].flags = 0;
+            s_file_table[i].append_lock = 0;
+            s_file_table[i].offset = 0;
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+            s_file_table[i].handle = NULL;
+#endif
+            return i;
+        }
+    }
+    return FILE_INDEX_NONE;
+}
+
+/* 释放一个引用，返回 true 表示这是最后一个引用（需要调用驱动的 close） */
+static bool file_table_put(int file_index)
+{
+    if (file_index == FILE_INDEX_NONE) {
+        return true;
+    }
+    return (XF_VFS_ATOMIC_REF_DEC(&s_file_table[file_index].refcnt) == 0);
+}
+
+/* 以下 fd_table_* 函数的调用者需持有 fd 所在分片的锁 */
+
+static void fd_table_set(int fd, bool permanent, int vfs_index, int local_fd, int file_index)
+{
+    s_fd_table[fd].permanent = permanent;
+    s_fd_table[fd].has_pending_close = false;
+    s_fd_table[fd].has_pending_select = false;
+    s_fd_table[fd].vfs_index = vfs_index;
+    s_fd_table[fd].local_fd = local_fd;
+    s_fd_table[fd].file_index = file_index;
+#if XF_VFS_QOS_IS_ENABLE
+    xf_vfs_qos_fd_reset(fd);
+#endif
+}
+
+static bool fd_table_release(int fd)
+{
+    bool last = file_table_put(s_fd_table[fd].file_index);
+    s_fd_table[fd] = FD_TABLE_ENTRY_UNUSED;
+#if XF_VFS_QOS_IS_ENABLE
+    xf_vfs_qos_fd_reset(fd);
+#endif
+    return last;
+}
+
+/* 令 newfd 引用 fd 的打开文件描述，newfd 必须未被使用；调用者需同时持有两者所在分片的锁 */
+static int fd_table_share(int fd, int newfd)
+{
+    fd_table_t *src = &s_fd_table[fd];
+    if (src->vfs_index == -1) {
+        errno = EBADF;
+        return -1;
+    }
+    if (src->file_index == FILE_INDEX_NONE) {
+        /* 永久 fd 第一次被复制时才分配打开文件描述 */
+        src->file_index = file_table_alloc(fd, src->vfs_index, src->local_fd);
+        if (src->file_index == FILE_INDEX_NONE) {
+            errno = EMFILE;
+            return -1;
+        }
+    }
+    XF_VFS_ATOMIC_REF_INC(&s_file_table[src->file_index].refcnt);
+    fd_table_set(newfd, false, src->vfs_index, src->local_fd, src->file_index);
+    return newfd;
+}
+
+static int dup_from(int fd, int min_fd)
+{
+    if (get_vfs_for_fd(fd) == NULL) {
+        errno = EBADF;
+        return -1;
+    }
+    if (min_fd < 0 || min_fd >= XF_VFS_FDS_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (int shard = FD_SHARD(min_fd); shard < FD_SHARD_COUNT; ++shard) {
+        const int begin = (shard == FD_SHARD(min_fd)) ? min_fd : FD_SHARD_BEGIN(shard);
+        fd_shard_lock_pair(FD_SHARD(fd), shard);
+        for (int i = begin; i < FD_SHARD_END(shard); ++i) {
+            if (s_fd_table[i].vfs_index == -1) {
+                const int ret = fd_table_share(fd, i);
+                fd_shard_unlock_pair(FD_SHARD(fd), shard);
+                return ret;
+            }
+        }
+        fd_shard_unlock_pair(FD_SHARD(fd), shard);
+    }
+    errno = EMFILE;
+    return -1;
+}
+
+/* 挂载点设置了 XF_VFS_FLAG_VFS_OFFSET 时返回 fd 的打开文件描述，否则返回 NULL */
+static inline file_table_t *get_file_for_fd(const xf_vfs_entry_t *vfs, int fd)
+{
+    if (!(vfs->flags & XF_VFS_FLAG_VFS_OFFSET)) {
+        return NULL;
+    }
+    const file_index_t file_index = s_fd_table[fd].file_index; // single read -> no locking is required
+    return (file_index == FILE_INDEX_NONE) ? NULL : &s_file_table[file_index];
+}
+
+/* 返回句柄模式挂载点上 fd 的句柄，其他挂载点返回 NULL */
+static inline void *get_handle_for_fd(int fd)
+{
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    const file_index_t file_index = s_fd_table[fd].file_index; // single read -> no locking is required
+    return (file_index == FILE_INDEX_NONE) ? NULL : s_file_table[file_index].handle;
+#else
+    (void)fd;
+    return NULL;
+#endif
+}
+
+static inline void *get_file_handle(const file_table_t *file)
+{
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    return file->handle;
+#else
+    (void)file;
+    return NULL;
+#endif
+}
+
+/* 调用驱动的 open，句柄模式下句柄写入 *handle，返回驱动内的 fd */
+static int drv_open(const xf_vfs_entry_t *vfs, const char *path_within_vfs, int flags, int mode, void **handle)
+{
+    int fd_within_vfs;
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    if (vfs->flags & XF_VFS_FLAG_HANDLE) {
+        /* 句柄模式下 local_fd 不被使用，固定为 0 */
+        DRIVER_CALL(vfs, open, path_within_vfs, *handle = (*vfs->vfs->handle->open)(vfs->ctx, path_within_vfs, flags, mode));
+        return (*handle != NULL) ? 0 : -1;
+    }
+#endif
+    (void)handle;
+    CHECK_AND_CALL(fd_within_vfs, r, vfs, open, path_within_vfs, flags, mode);
+    return fd_within_vfs;
+}
+
+/* 为驱动打开的文件分配全局 fd，失败时关闭驱动中的文件 */
+static int fd_install(const xf_vfs_entry_t *vfs, int fd_within_vfs, void *handle, int flags, uint8_t append_lock)
+{
+    if (fd_within_vfs < 0) {
+        return -1;
+    }
+#if XF_VFS_STATIC_MOUNTS_IS_ENABLE
+    /* 只有编译期挂载点时没有调用过注册函数，fd 表锁在第一次打开文件时创建 */
+    fd_table_lock_init();
+#endif
+    const int hint = fd_shard_hint();
+    for (int n = 0; n < FD_SHARD_COUNT; ++n) {
+        const int shard = (hint + n) % FD_SHARD_COUNT;
+        fd_shard_lock(shard);
+        for (int i = FD_SHARD_BEGIN(shard); i < FD_SHARD_END(shard); ++i) {
+            if (s_fd_table[i].vfs_index != -1) {
+                continue;
+            }
+            const int file_index = file_table_alloc(i, vfs->offset, fd_within_vfs);
+            if (file_index == FILE_INDEX_NONE) {
+                break;
+            }
+            s_file_table[file_index].flags = flags;
+            s_file_table[file_index].append_lock = append_lock;
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+            s_file_table[file_index].handle = handle;
+#endif
+            fd_table_set(i, false, vfs->offset, fd_within_vfs, file_index);
+            fd_shard_unlock(shard);
+            return i;
+        }
+        fd_shard_unlock(shard);
+    }
+    int ret;
+    CHECK_AND_CALL_FD(ret, r, vfs, handle, close, fd_within_vfs);
+    (void) ret; // remove "set but not used" warning
+    errno = ENOMEM;
+    return -1;
+}
+
+/*
+ * O_APPEND 写入锁的下标，按挂载点与文件在挂载点内的路径（path 的前 len 个字符，name 非 NULL 时
+ * 与 dirat_join() 一样以 '/' 连接）散列。不是 XF_VFS_FLAG_VFS_OFFSET 的 O_APPEND 打开时不使用，返回 0.
+ */
+static uint8_t append_lock_index(const xf_vfs_entry_t *vfs, int flags, const char *path, size_t len, const char *name)
+{
+    if (!(flags & XF_VFS_O_APPEND) || !(vfs->flags & XF_VFS_FLAG_VFS_OFFSET)) {
+        return 0;
+    }
+    uint32_t hash = prefix_hash_step(XF_VFS_PREFIX_HASH_INIT, (char)vfs->offset);
+    for (size_t i = 0; i < len; ++i) {
+        hash = prefix_hash_step(hash, path[i]);
+    }
+    if (name != NULL) {
+        if (len == 0 || path[len - 1] != '/') {
+            hash = prefix_hash_step(hash, '/');
+        }
+        for (; *name != '\0'; ++name) {
+            hash = prefix_hash_step(hash, *name);
+        }
+    }
+    return (uint8_t)(hash % XF_VFS_APPEND_LOCKS);
+}
+
+static void stat_to_stat64(const xf_vfs_stat_t *src, xf_vfs_stat64_t *dst)
+{
+    dst->st_dev = src->st_dev;
+    dst->st_mode = src->st_mode;
+    dst->st_size = src->st_size;
+    dst->st_actime = src->st_actime;
+    dst->st_modtime = src->st_modtime;
+    dst->st_chtime = src->st_chtime;
+    dst->st_blksize = src->st_blksize;
+    dst->st_blocks = src->st_blocks;
+}
+
+static int stat64_to_stat(const xf_vfs_stat64_t *src, xf_vfs_stat_t *dst)
+{
+    if (!OFF_FITS(src->st_size)) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    dst->st_dev = src->st_dev;
+    dst->st_mode = src->st_mode;
+    dst->st_size = (xf_vfs_off_t)src->st_size;
+    dst->st_actime = src->st_actime;
+    dst->st_modtime = src->st_modtime;
+    dst->st_chtime = src->st_chtime;
+    dst->st_blksize = src->st_blksize;
+    dst->st_blocks = src->st_blocks;
+    return 0;
+}
+
+static void stat64_to_statx(const xf_vfs_stat64_t *src, xf_vfs_statx_t *dst)
+{
+    dst->stx_mask = XF_VFS_STATX_BASIC_STATS;
+    dst->stx_dev = src->st_dev;
+    dst->stx_mode = src->st_mode;
+    dst->stx_size = src->st_size;
+    dst->stx_actime = src->st_actime;
+    dst->stx_modtime = src->st_modtime;
+    dst->stx_chtime = src->st_chtime;
+    dst->stx_blksize = src->st_blksize;
+    dst->stx_blocks = src->st_blocks;
+}
+
+/*
+ * 以下 drv_xxx64() 调用驱动的 64 位函数，驱动未提供时回退到 32 位函数，
+ * 偏移超出 xf_vfs_off_t 范围时返回 EOVERFLOW.
+ */
+
+static xf_vfs_off64_t drv_lseek64(const xf_vfs_entry_t *vfs, void *h, int local_fd,
+                                  xf_vfs_off64_t offset, int mode)
+{
+    if (HAS_OP64(vfs, lseek64)) {
+        xf_vfs_off64_t ret;
+        CHECK_AND_CALL_FD(ret, r, vfs, h, lseek64, local_fd, offset, mode);
+        return ret;
+    }
+    if (!OFF_FITS(offset)) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    xf_vfs_off_t ret;
+    CHECK_AND_CALL_FD(ret, r, vfs, h, lseek, local_fd, (xf_vfs_off_t)offset, mode);
+    return ret;
+}
+
+static xf_vfs_ssize_t drv_pread64(const xf_vfs_entry_t *vfs, void *h, int local_fd,
+                                  void *dst, size_t size, xf_vfs_off64_t offset)
+{
+    xf_vfs_ssize_t ret;
+    if (HAS_OP64(vfs, pread64)) {
+        CHECK_AND_CALL_FD(ret, r, vfs, h, pread64, local_fd, dst, size, offset);
+        return ret;
+    }
+    if (!OFF_FITS(offset)) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    CHECK_AND_CALL_FD(ret, r, vfs, h, pread, local_fd, dst, size, (xf_vfs_off_t)offset);
+    return ret;
+}
+
+static xf_vfs_ssize_t drv_pwrite64(const xf_vfs_entry_t *vfs, void *h, int local_fd,
+                                   const void *src, size_t size, xf_vfs_off64_t offset)
+{
+    xf_vfs_ssize_t ret;
+    if (HAS_OP64(vfs, pwrite64)) {
+        CHECK_AND_CALL_FD(ret, r, vfs, h, pwrite64, local_fd, src, size, offset);
+        return ret;
+    }
+    if (!OFF_FITS(offset)) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    CHECK_AND_CALL_FD(ret, r, vfs, h, pwrite, local_fd, src, size, (xf_vfs_off_t)offset);
+    return ret;
+}
+
+static int drv_fstat64(const xf_vfs_entry_t *vfs, void *h, int local_fd, xf_vfs_stat64_t *st)
+{
+    int ret;
+    if (HAS_OP64(vfs, fstat64)) {
+        CHECK_AND_CALL_FD(ret, r, vfs, h, fstat64, local_fd, st);
+        return ret;
+    }
+    xf_vfs_stat_t st32;
+    CHECK_AND_CALL_FD(ret, r, vfs, h, fstat, local_fd, &st32);
+    if (ret == 0) {
+        stat_to_stat64(&st32, st);
+    }
+    return ret;
+}
+
+/* 驱动未实现 fstatx 时回退到完整的 fstat，报告所有字段 */
+static int drv_fstatx(const xf_vfs_entry_t *vfs, void *h, int local_fd, uint32_t mask, xf_vfs_statx_t *stx)
+{
+    int ret;
+    xf_memset(stx, 0, sizeof(xf_vfs_statx_t));
+    if (!IS_HANDLE_MODE(vfs) && vfs->vfs->fstatx != NULL) {
+        CHECK_AND_CALL(ret, r, vfs, fstatx, local_fd, mask, stx);
+        return ret;
+    }
+    xf_vfs_stat64_t st;
+    ret = drv_fstat64(vfs, h, local_fd, &st);
+    if (ret == 0) {
+        stat64_to_statx(&st, stx);
+    }
+    return ret;
+}
+
+/* 只取文件大小，用于 O_APPEND 及 SEEK_END */
+static int drv_fsize64(const xf_vfs_entry_t *vfs, void *h, int local_fd, xf_vfs_off64_t *size)
+{
+    xf_vfs_statx_t stx;
+    if (drv_fstatx(vfs, h, local_fd, XF_VFS_STATX_SIZE, &stx) < 0) {
+        return -1;
+    }
+    if (!(stx.stx_mask & XF_VFS_STATX_SIZE)) {
+        errno = ENOSYS;
+        return -1;
+    }
+    *size = stx.stx_size;
+    return 0;
+}
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+static int drv_statx(const xf_vfs_entry_t *vfs, const char *path_within_vfs, uint32_t mask, xf_vfs_statx_t *stx)
+{
+    int ret;
+    xf_memset(stx, 0, sizeof(xf_vfs_statx_t));
+    if (vfs->vfs->dir != NULL && vfs->vfs->dir->statx != NULL) {
+        CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, statx, path_within_vfs, mask, stx);
+        return ret;
+    }
+    xf_vfs_stat_t st;
+    CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, stat, path_within_vfs, &st);
+    if (ret == 0) {
+        xf_vfs_stat64_t st64;
+        stat_to_stat64(&st, &st64);
+        stat64_to_statx(&st64, stx);
+    }
+    return ret;
+}
+
+static bool dirat_has_at_ops(const xf_vfs_entry_t *vfs)
+{
+    const xf_vfs_dir_ops_t *dir = vfs->vfs->dir;
+    return dir != NULL && dir->opendir != NULL
+           && ((dir->openat != NULL && !IS_HANDLE_MODE(vfs))
+               || dir->fstatat != NULL || dir->unlinkat != NULL || dir->mkdirat != NULL);
+}
+
+/* 取得目录句柄所在的挂载点，挂载点已被注销时返回 NULL 并设置 errno */
+static const xf_vfs_entry_t *dirat_get_vfs(const xf_vfs_dirat_t *dir, const char *name)
+{
+    const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(dir->vfs_index);
+    if (vfs == NULL) {
+        errno = EBADF;
+        return NULL;
+    }
+    if (name[0] == '\0') {
+        errno = ENOENT;
+        return NULL;
+    }
+    return vfs;
+}
+
+/* 把目录句柄的路径与 name 拼接到 buf 中 */
+static int dirat_join(const xf_vfs_dirat_t *dir, const char *name, char *buf)
+{
+    const size_t name_len = xf_strlen(name);
+    const size_t slash = (dir->len > 0 && dir->path[dir->len - 1] == '/') ? 0 : 1;
+    if (dir->len + slash + name_len + 1 > XF_VFS_AT_PATH_MAX) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    xf_memcpy(buf, dir->path, dir->len);
+    if (slash) {
+        buf[dir->len] = '/';
+    }
+    xf_memcpy(buf + dir->len + slash, name, name_len + 1);
+    return 0;
+}
+
+static int drv_ftruncate64(const xf_vfs_entry_t *vfs, void *h, int local_fd, xf_vfs_off64_t length)
+{
+    int ret;
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    if (IS_HANDLE_MODE(vfs) && vfs->vfs->handle->ftruncate64 != NULL) {
+        DRIVER_CALL(vfs, ftruncate64, h, ret = (*vfs->vfs->handle->ftruncate64)(vfs->ctx, h, length));
+        return ret;
+    }
+#endif
+    if (!IS_HANDLE_MODE(vfs) && vfs->vfs->dir != NULL && vfs->vfs->dir->ftruncate64 != NULL) {
+        CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, ftruncate64, local_fd, length);
+        return ret;
+    }
+    if (!OFF_FITS(length)) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    if (IS_HANDLE_MODE(vfs)) {
+        if (vfs->vfs->handle->ftruncate == NULL) {
+            errno = ENOSYS;
+            return -1;
+        }
+        DRIVER_CALL(vfs, ftruncate, h, ret = (*vfs->vfs->handle->ftruncate)(vfs->ctx, h, (xf_vfs_off_t)length));
+        return ret;
+    }
+#endif
+    CHECK_AND_CALL_SUBCOMPONENT(ret, r, vfs, dir, ftruncate, local_fd, (xf_vfs_off_t)length);
+    return ret;
+}
+
+/* 驱动未实现 getdents 时逐个 readdir 并打包 */
+static xf_vfs_ssize_t getdents_readdir(const xf_vfs_entry_t *vfs, xf_vfs_dir_t *pdir, uint8_t *buf, size_t len)
+{
+    const xf_vfs_dir_ops_t *dir = vfs->vfs->dir;
+    if (dir == NULL || dir->readdir == NULL) {
+        errno = ENOSYS;
+        return -1;
+    }
+    /*
+     * 放不下的目录项需要用 telldir/seekdir 退回。
+     * 驱动不支持时，只在剩余空间能容纳任意记录时才读取下一项。
+     */
+    const bool can_rewind = (dir->telldir != NULL && dir->seekdir != NULL);
+    const size_t reserve = can_rewind ? XF_VFS_DIRENT_REC_LEN(0) : XF_VFS_DIRENT_REC_MAX;
+    size_t used = 0;
+    bool eof = false;
+    while (len - used >= reserve) {
+        /* 剩余空间足以容纳任意记录时不会退回，省去 telldir */
+        const bool may_rewind = (len - used < XF_VFS_DIRENT_REC_MAX);
+        const long pos = may_rewind ? xf_vfs_telldir(pdir) : 0;
+        const xf_vfs_dirent_t *ent = xf_vfs_readdir(pdir);
+        if (ent == NULL) {
+            eof = true;
+            break;
+        }
+        const size_t reclen = xf_vfs_dirent_rec_fill(buf + used, len - used, ent->d_ino, ent->d_type,
+                              ent->d_name, xf_strlen(ent->d_name));
+        if (reclen == 0) {
+            xf_vfs_seekdir(pdir, pos);
+            break;
+        }
+        used += reclen;
+    }
+    if (used == 0 && !eof) {
+        errno = EINVAL;
+        return -1;
+    }
+    return (xf_vfs_ssize_t)used;
+}
+#endif
+
+static xf_vfs_ssize_t offset_read(const xf_vfs_entry_t *vfs, file_table_t *file, int local_fd,
+                                  void *dst, size_t size)
+{
+    xf_vfs_off64_t pos = XF_VFS_ATOMIC_LOAD(&file->offset);
+    for (;;) {
+        xf_vfs_ssize_t ret = drv_pread64(vfs, get_file_handle(file), local_fd, dst, size, pos);
+        if (ret <= 0) {
+            return ret;
+        }
+        /* 读取期间其他线程移动了偏移时，pos 被更新为新偏移，重新读取 */
+        if (XF_VFS_ATOMIC_CAS(&file->offset, &pos, pos + ret)) {
+            return ret;
+        }
+    }
+}
+
+static xf_vfs_ssize_t offset_write(const xf_vfs_entry_t *vfs, file_table_t *file, int local_fd,
+                                   const void *data, size_t size)
+{
+    if (!HAS_OP64(vfs, pwrite64) && FD_OP_IS_NULL(vfs, pwrite)) {
+        errno = ENOSYS;
+        return -1;
+    }
+    if (file->flags & XF_VFS_O_APPEND) {
+        /* 文件末尾可能被其他 open 的 fd 移动，每次都向驱动取大小 */
+        xf_lock_t lock = s_append_locks[file->append_lock];
+        xf_vfs_off64_t pos;
+        xf_vfs_ssize_t ret;
+        _lock_acquire(lock);
+        ret = drv_fsize64(vfs, get_file_handle(file), local_fd, &pos);
+        if (ret == 0) {
+            ret = drv_pwrite64(vfs, get_file_handle(file), local_fd, data, size, pos);
+            if (ret >= 0) {
+                XF_VFS_ATOMIC_STORE(&file->offset, pos + ret);
+            }
+        }
+        _lock_release(lock);
+        return ret;
+    }
+    /* 先预留 [pos, pos + size)，写入不足时再尽量归还未使用的部分 */
+    const xf_vfs_off64_t pos = XF_VFS_ATOMIC_FETCH_ADD(&file->offset, (xf_vfs_off64_t)size);
+    const xf_vfs_ssize_t ret = drv_pwrite64(vfs, get_file_handle(file), local_fd, data, size, pos);
+    const xf_vfs_off64_t end = pos + ((ret > 0) ? ret : 0);
+    if (end != pos + (xf_vfs_off64_t)size) {
+        xf_vfs_off64_t expected = pos + (xf_vfs_off64_t)size;
+        XF_VFS_ATOMIC_CAS(&file->offset, &expected, end);
+    }
+    return ret;
+}
+
+static xf_vfs_off64_t offset_lseek(const xf_vfs_entry_t *vfs, file_table_t *file, int local_fd,
+                                   xf_vfs_off64_t offset, int mode)
+{
+    xf_vfs_off64_t base = 0;
+    if (mode == XF_VFS_SEEK_END) {
+        if (drv_fsize64(vfs, get_file_handle(file), local_fd, &base) < 0) {
+            return -1;
+        }
+    } else if (mode != XF_VFS_SEEK_SET && mode != XF_VFS_SEEK_CUR) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    xf_vfs_off64_t cur = XF_VFS_ATOMIC_LOAD(&file->offset);
+    xf_vfs_off64_t pos;
+    do {
+        pos = ((mode == XF_VFS_SEEK_CUR) ? cur : base) + offset;
+        if (pos < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+    } while (!XF_VFS_ATOMIC_CAS(&file->offset, &cur, pos));
+    return pos;
+}
+
+static int vfs_ioctl(int fd, int cmd, va_list args)
+{
+    const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
+    const int local_fd = get_local_fd(vfs, fd);
+    if (vfs == NULL || local_fd < 0) {
+        errno = EBADF;
+        return -1;
+    }
+    int ret;
+    CHECK_AND_CALL_FD(ret, r, vfs, get_handle_for_fd(fd), ioctl, local_fd, cmd, args);
+    return ret;
+}
+
+static uint32_t ops_hash_bytes(uint32_t hash, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/* 按内容（函数指针的值）计算哈希，子组件指针本身不参与 */
+static uint32_t ops_hash(const xf_vfs_fs_ops_t *ops)
+{
+    uint32_t hash = ops_hash_bytes(XF_VFS_PREFIX_HASH_INIT, ops, FS_OPS_FN_SIZE);
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    if (ops->dir != NULL) {
+        hash = ops_hash_bytes(hash, ops->dir, sizeof(xf_vfs_dir_ops_t));
+    }
+#endif
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+    if (ops->select != NULL) {
+        hash = ops_hash_bytes(hash, ops->select, sizeof(xf_vfs_select_ops_t));
+    }
+#endif
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    if (ops->handle != NULL) {
+        hash = ops_hash_bytes(hash, ops->handle, sizeof(xf_vfs_handle_ops_t));
+    }
+#endif
+    return hash;
+}
+
+static bool ops_equal(const xf_vfs_fs_ops_t *a, const xf_vfs_fs_ops_t *b)
+{
+    if (xf_memcmp(a, b, FS_OPS_FN_SIZE) != 0) {
+        return false;
+    }
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    if ((a->dir == NULL) != (b->dir == NULL)
+            || (a->dir != NULL && xf_memcmp(a->dir, b->dir, sizeof(xf_vfs_dir_ops_t)) != 0)) {
+        return false;
+    }
+#endif
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+    if ((a->select == NULL) != (b->select == NULL)
+            || (a->select != NULL && xf_memcmp(a->select, b->select, sizeof(xf_vfs_select_ops_t)) != 0)) {
+        return false;
+    }
+#endif
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    if ((a->handle == NULL) != (b->handle == NULL)
+            || (a->handle != NULL && xf_memcmp(a->handle, b->handle, sizeof(xf_vfs_handle_ops_t)) != 0)) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+/* 返回与 vfs 内容相同的共享操作表（引用计数加一），不存在时创建 */
+static const xf_vfs_fs_ops_t *xf_vfs_intern_fs_ops(const xf_vfs_fs_ops_t *vfs)
+{
+    const uint32_t hash = ops_hash(vfs);
+    for (ops_intern_t *node = s_ops_intern; node != NULL; node = node->next) {
+        if (node->hash == hash && ops_equal(&node->fs, vfs)) {
+            ++node->refcnt;
+            return &node->fs;
+        }
+    }
+
+    const size_t size = offsetof(ops_intern_t, fs) + xf_vfs_fs_ops_size(vfs);
+    ops_intern_t *node = VFS_ALLOC(s_ops_pool, size);
+    if (node == NULL) {
+        return NULL;
+    }
+    node->refcnt = 1;
+    node->hash = hash;
+    xf_vfs_copy_fs_ops(vfs, (uint8_t *)&node->fs);
+    node->next = s_ops_intern;
+    s_ops_intern = node;
+    return &node->fs;
+}
+
+static void xf_vfs_release_fs_ops(const xf_vfs_fs_ops_t *vfs)
+{
+    for (ops_intern_t **pp = &s_ops_intern; *pp != NULL; pp = &(*pp)->next) {
+        ops_intern_t *node = *pp;
+        if (&node->fs != vfs) {
+            continue;
+        }
+        if (--node->refcnt == 0) {
+            *pp = node->next;
+            VFS_FREE(s_ops_pool, node);
+        }
+        return;
+    }
+}
+
+#if XF_VFS_TRACE_IS_ENABLE
+/* 跟踪记录中的挂载点下标，未知时为 -1 */
+static int trace_fd_vfs(int fd)
+{
+    const xf_vfs_entry_t *vfs = get_vfs_for_fd(fd);
+    return (vfs != NULL) ? vfs->offset : -1;
+}
+
+static int trace_path_vfs(const char *path)
+{
+    const xf_vfs_entry_t *vfs = (path != NULL) ? xf_vfs_get_vfs_for_path(path) : NULL;
+    return (vfs != NULL) ? vfs->offset : -1;
+}
+
+static int trace_path_p_vfs(xf_vfs_path_t *p)
+{
+    const xf_vfs_entry_t *vfs = path_resolve(p);
+    return (vfs != NULL) ? vfs->offset : -1;
+}
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+static int trace_dir_vfs(const xf_vfs_dir_t *pdir)
+{
+    return (pdir != NULL) ? pdir->dd_vfs_idx : -1;
+}
+
+/* dir 为 NULL 或 name 为绝对路径时 *at 函数按 name 查找挂载点 */
+static int trace_dirat_vfs(const xf_vfs_dirat_t *dir, const char *name)
+{
+    if (name != NULL && (dir == NULL || name[0] == '/')) {
+        return trace_path_vfs(name);
+    }
+    return (dir != NULL) ? dir->vfs_index : -1;
+}
+#endif
+#endif
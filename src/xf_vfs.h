@@ -51,6 +51,30 @@ extern "C" {
 
 /* ==================== [Typedefs] ========================================== */
 
+#if XF_VFS_STATIC_MOUNTS_IS_ENABLE
+#define XF_VFS_STATIC_ID_ENUM(name, prefix, ops, flags, ctx)    XF_VFS_STATIC_ID_##name,
+
+/**
+ * @brief 编译期挂载点的 vfs_id，见 XF_VFS_STATIC_MOUNTS.
+ */
+enum {
+    XF_VFS_STATIC_MOUNTS(XF_VFS_STATIC_ID_ENUM)
+    XF_VFS_STATIC_MOUNT_COUNT,
+};
+#endif
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+/**
+ * @brief 目录句柄，用于 xf_vfs_openat() 等相对目录的操作，见 xf_vfs_dirat_open().
+ */
+typedef struct xf_vfs_dirat xf_vfs_dirat_t;
+#endif
+
+/**
+ * @brief 预解析的路径句柄，见 xf_vfs_path_prepare().
+ */
+typedef struct xf_vfs_path xf_vfs_path_t;
+
 /* ==================== [Global Prototypes] ================================= */
 
 /**
@@ -132,6 +156,9 @@ xf_err_t xf_vfs_unregister(const char *base_path);
 /**
  * Unregister a virtual filesystem with the given index
  *
+ * For an XF_VFS_FLAG_HANDLE filesystem, the driver's close is called once
+ * for every handle still open on it before the entry is released.
+ *
  * @param vfs_id  The VFS ID returned by xf_vfs_register_with_id
  * @return XF_OK if successful, XF_ERR_INVALID_STATE if VFS for the given index
  *         hasn't been registered
@@ -243,6 +270,168 @@ xf_vfs_ssize_t xf_vfs_pread(int fd, void *dst, size_t size, xf_vfs_off_t offset)
  */
 xf_vfs_ssize_t xf_vfs_pwrite(int fd, const void *src, size_t size, xf_vfs_off_t offset);
 
+/**
+ * @brief 64 位偏移版本的 lseek/pread/pwrite/fstat/truncate/ftruncate, 用于超过 2 GiB 的文件。
+ *
+ * 驱动提供对应的 xxx64 函数时直接调用；否则调用 32 位函数，
+ * 此时偏移超出 xf_vfs_off_t 的范围会返回 -1 并设置 errno 为 EOVERFLOW.
+ * 不带 64 后缀的接口是这些函数的包装，结果无法用 xf_vfs_off_t 表示时同样返回 EOVERFLOW.
+ */
+/**@{*/
+xf_vfs_off64_t xf_vfs_lseek64(int fd, xf_vfs_off64_t offset, int mode);
+xf_vfs_ssize_t xf_vfs_pread64(int fd, void *dst, size_t size, xf_vfs_off64_t offset);
+xf_vfs_ssize_t xf_vfs_pwrite64(int fd, const void *src, size_t size, xf_vfs_off64_t offset);
+int xf_vfs_fstat64(int fd, xf_vfs_stat64_t *st);
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+int xf_vfs_truncate64(const char *path, xf_vfs_off64_t length);
+int xf_vfs_ftruncate64(int fd, xf_vfs_off64_t length);
+#endif
+/**@}*/
+
+/**
+ * @brief 只查询 mask 指定的文件属性。
+ *
+ * 驱动实现 statx/fstatx 时只需读取请求的字段，例如只取大小时不必读取时间戳；
+ * 否则回退到完整的 stat/fstat 并报告所有字段。
+ *
+ * @param mask  需要的字段，XF_VFS_STATX_* 的组合。
+ * @param[out] stx 结果，stx->stx_mask 为实际填充的字段，可能多于或少于 mask
+ *              （驱动无法提供的字段不会置位），未填充的字段为 0.
+ * @return 0 if successful, -1 with errno otherwise.
+ */
+/**@{*/
+int xf_vfs_fstatx(int fd, uint32_t mask, xf_vfs_statx_t *stx);
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+int xf_vfs_statx(const char *path, uint32_t mask, xf_vfs_statx_t *stx);
+#endif
+/**@}*/
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+/**
+ * @brief 批量读取目录项。
+ *
+ * 尽可能多地把目录项以 xf_vfs_dirent_rec_t 记录紧凑地写入 buf，
+ * 每条记录只占用名称实际需要的空间，一次调用可以读出多个目录项。
+ * 驱动未实现 getdents 时逐个调用 readdir 填充。
+ *
+ * @param pdir  xf_vfs_opendir() 返回的目录。
+ * @param buf   缓冲区，按 XF_VFS_DIRENT_REC_ALIGN 对齐，
+ *              大小不小于 XF_VFS_DIRENT_REC_MAX 时总能放下下一条记录。
+ * @param len   缓冲区字节数。
+ * @return 写入的字节数，已到目录末尾时返回 0；
+ *         失败返回 -1 并设置 errno（EINVAL: 缓冲区放不下下一条记录）。
+ */
+xf_vfs_ssize_t xf_vfs_getdents(xf_vfs_dir_t *pdir, void *buf, size_t len);
+
+/**
+ * @brief 向 buf 写入一条紧凑目录项记录，供实现 getdents 的驱动使用。
+ *
+ * @return 记录长度，buf 放不下或名称过长时返回 0.
+ */
+size_t xf_vfs_dirent_rec_fill(void *buf, size_t len, xf_vfs_ino_t ino, uint8_t type,
+                              const char *name, size_t namlen);
+
+/**
+ * @brief 打开目录句柄，供 xf_vfs_openat() 等函数使用。
+ *
+ * 句柄中保存了挂载点的查找结果，之后的相对操作不再按完整路径查找挂载点。
+ * 驱动实现了 openat/fstatat/unlinkat/mkdirat 时还会用 opendir 打开该目录，
+ * 驱动从该目录开始查找，不必每次从根目录逐级解析。
+ *
+ * @param path 目录的完整路径。
+ * @return 目录句柄，失败返回 NULL 并设置 errno（ENOTDIR: path 不是目录）。
+ */
+xf_vfs_dirat_t *xf_vfs_dirat_open(const char *path);
+
+/**
+ * @brief 关闭目录句柄。
+ *
+ * @return 0 if successful, -1 with errno otherwise.
+ */
+int xf_vfs_dirat_close(xf_vfs_dirat_t *dir);
+
+/**
+ * @brief 相对目录句柄的 open/stat/unlink/mkdir.
+ *
+ * name 为相对于 dir 的路径；name 为绝对路径或 dir 为 NULL 时
+ * 等同于对应的 xf_vfs_open()、xf_vfs_stat() 等函数。
+ * xf_vfs_unlinkat() 的 flags 为 XF_VFS_AT_REMOVEDIR 时删除目录。
+ *
+ * @note name 原样传给驱动，含 ".." 时能否越出 dir 由驱动决定。
+ */
+/**@{*/
+int xf_vfs_openat(xf_vfs_dirat_t *dir, const char *name, int flags, int mode);
+int xf_vfs_fstatat(xf_vfs_dirat_t *dir, const char *name, xf_vfs_stat_t *st);
+int xf_vfs_unlinkat(xf_vfs_dirat_t *dir, const char *name, int flags);
+int xf_vfs_mkdirat(xf_vfs_dirat_t *dir, const char *name, xf_vfs_mode_t mode);
+/**@}*/
+#endif
+
+/**
+ * @brief 预解析一个需要反复访问的路径。
+ *
+ * 句柄中缓存了路径长度、匹配的挂载点及挂载点内的路径，
+ * xf_vfs_open_p() 等函数直接使用缓存，不再查找挂载点。
+ * 注册或注销挂载点后，句柄在下次使用时自动重新解析。
+ * 路径当前没有匹配的挂载点时仍返回句柄，使用时失败并设置 errno 为 ENOENT.
+ *
+ * @param path 完整路径。
+ * @return 路径句柄，内存不足时返回 NULL.
+ */
+xf_vfs_path_t *xf_vfs_path_prepare(const char *path);
+
+/**
+ * @brief 释放路径句柄。
+ */
+void xf_vfs_path_release(xf_vfs_path_t *p);
+
+/**
+ * @brief 使用路径句柄的 open/stat/statx/unlink/opendir，行为与对应函数相同。
+ *
+ * @note 重新解析时会修改句柄，多个线程共用一个句柄时需要自行加锁。
+ */
+/**@{*/
+int xf_vfs_open_p(xf_vfs_path_t *p, int flags, int mode);
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+int xf_vfs_stat_p(xf_vfs_path_t *p, xf_vfs_stat_t *st);
+int xf_vfs_statx_p(xf_vfs_path_t *p, uint32_t mask, xf_vfs_statx_t *stx);
+int xf_vfs_unlink_p(xf_vfs_path_t *p);
+xf_vfs_dir_t *xf_vfs_opendir_p(xf_vfs_path_t *p);
+#endif
+/**@}*/
+
+/**
+ * @brief Implements the VFS layer of POSIX dup()
+ *
+ * The new file descriptor shares the open file description (driver fd and file offset)
+ * with fd. Duplication never calls the driver, the driver's close is called only
+ * when the last file descriptor referring to the description is closed.
+ * `xf_vfs_fcntl(fd, XF_VFS_F_DUPFD, min_fd)` is handled the same way.
+ *
+ * @note Closing a permanent fd (see xf_vfs_register_fd_range()) always releases its own reference
+ *       but keeps the fd registered.
+ *
+ * @param fd         File descriptor to duplicate
+ *
+ * @return           The lowest-numbered unused file descriptor, or -1 with errno set
+ *                   (EBADF: fd is not valid, EMFILE: no free file descriptor).
+ */
+int xf_vfs_dup(int fd);
+
+/**
+ * @brief Implements the VFS layer of POSIX dup2()
+ *
+ * Makes fd2 refer to the open file description of fd. If fd2 was open it is closed first,
+ * which calls the driver's close only if fd2 was the last reference.
+ *
+ * @param fd         File descriptor to duplicate
+ * @param fd2        Target file descriptor
+ *
+ * @return           fd2 on success, or -1 with errno set
+ *                   (EBADF: fd or fd2 is not valid, EBUSY: fd2 is permanent or used by select()).
+ */
+int xf_vfs_dup2(int fd, int fd2);
+
 /**
  *
  * @brief Dump the existing VFS FDs data to FILE* fp
@@ -301,6 +490,12 @@ void xf_vfs_dump_registered_paths(void);
  *
  * @return      The number of descriptors set in the descriptor sets, or -1
  *              when an error (specified by errno) have occurred.
+ *
+ * @note If the sets contain descriptors of several socket VFSes (see
+ *       xf_vfs_register_fd_range()), the socket_select of each one runs in a
+ *       waiter thread of that VFS and the first one to return, or any other VFS
+ *       triggering the select, stops the others. Waiter threads are created on
+ *       first use and reused, each takes XF_VFS_SELECT_SOCKET_STACK_SIZE of stack.
  */
 int xf_vfs_select(int nfds, xf_fd_set *readfds, xf_fd_set *writefds, xf_fd_set *errorfds, xf_vfs_timeval_t *timeout);
 
@@ -0,0 +1,590 @@
+/**
+ * @file xf_vfs_bench.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs 负载生成器。
+ * @version 1.0
+ * @date 2025-01-22
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs_bench.h"
+#include "xf_vfs_mem.h"
+
+/* 多线程需要 xf_osal，与 select、并行遍历相同 */
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE || XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE
+#   define BENCH_THREADS_IS_ENABLE  (1)
+#   include "xf_osal.h"
+#else
+#   define BENCH_THREADS_IS_ENABLE  (0)
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define BENCH_FILE_PATH_MAX     (XF_VFS_BENCH_PATH_MAX + XF_VFS_BENCH_NAME_MAX + 24)
+#define BENCH_FILL_BYTE         (0x5A)
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct {
+    const xf_vfs_bench_job_t *job;
+    uint32_t index;             /*!< 线程号 */
+    uint32_t rng;               /*!< xorshift32 状态 */
+    uint32_t errors;
+    int *fds;                   /*!< nrfiles 个，meta 作业为 NULL */
+    uint8_t *buf;               /*!< bs 字节 */
+    char path[BENCH_FILE_PATH_MAX];
+    xf_vfs_bench_stats_t op[XF_VFS_BENCH_OP_MAX];
+#if BENCH_THREADS_IS_ENABLE
+    xf_osal_semaphore_t exited; /*!< 所有线程共用，线程结束时释放一次 */
+#endif
+} bench_worker_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static bool bench_is_read_only(const xf_vfs_bench_job_t *job);
+static bool bench_job_valid(const xf_vfs_bench_job_t *job);
+static const char *bench_path(bench_worker_t *w, uint32_t file);
+static uint32_t bench_random(bench_worker_t *w);
+static void bench_account(bench_worker_t *w, xf_vfs_bench_op_t op, uint64_t t0, bool ok, uint32_t bytes);
+static bool bench_prepare(bench_worker_t *w);
+static void bench_cleanup(bench_worker_t *w);
+static void bench_run_data(bench_worker_t *w);
+static void bench_run_meta(bench_worker_t *w);
+static void bench_run_worker(bench_worker_t *w);
+#if BENCH_THREADS_IS_ENABLE
+static void bench_thread(void *argument);
+#endif
+
+static char *line_trim(char *s, char *end);
+static bool parse_size(const char *s, uint32_t *out);
+static bool parse_item(xf_vfs_bench_job_t *job, const char *key, const char *value);
+
+/* ==================== [Static Variables] ================================== */
+
+static const char *const TAG = "xf_vfs_bench";
+
+static const char *const s_rw_names[XF_VFS_BENCH_RW_MAX] = {
+    "read", "write", "randread", "randwrite", "rw", "randrw", "meta",
+};
+
+static const char *const s_op_names[XF_VFS_BENCH_OP_MAX] = {
+    "read", "write", "fsync", "create", "stat", "unlink",
+};
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+void xf_vfs_bench_job_init(xf_vfs_bench_job_t *job)
+{
+    xf_memset(job, 0, sizeof(*job));
+    job->rw = XF_VFS_BENCH_RW_READ;
+    job->rwmixread = 50;
+    job->numjobs = 1;
+    job->bs = 4 * 1024;
+    job->size = 64 * 1024;
+    job->nrfiles = 1;
+    job->seed = 1;
+}
+
+xf_err_t xf_vfs_bench_parse(const char *text, xf_vfs_bench_job_t *jobs, size_t max, size_t *count)
+{
+    if (text == NULL || jobs == NULL || count == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+    xf_vfs_bench_job_t global;
+    xf_vfs_bench_job_init(&global);
+    xf_vfs_bench_job_t *cur = &global;
+    *count = 0;
+
+    char line[XF_VFS_BENCH_PATH_MAX + 32];
+    int line_no = 0;
+    const char *p = text;
+    while (*p != '\0') {
+        const char *end = p;
+        while (*end != '\0' && *end != '\n') {
+            ++end;
+        }
+        ++line_no;
+        const size_t len = (size_t)(end - p);
+        if (len >= sizeof(line)) {
+            XF_LOGE(TAG, "line %d: too long", line_no);
+            return XF_ERR_INVALID_ARG;
+        }
+        xf_memcpy(line, p, len);
+        line[len] = '\0';
+        p = (*end != '\0') ? end + 1 : end;
+
+        char *s = line_trim(line, line + len);
+        if (*s == '\0' || *s == '#' || *s == ';') {
+            continue;
+        }
+        const size_t slen = xf_strlen(s);
+        if (s[0] == '[') {
+            if (s[slen - 1] != ']' || slen < 3 || slen - 2 >= XF_VFS_BENCH_NAME_MAX) {
+                XF_LOGE(TAG, "line %d: bad section", line_no);
+                return XF_ERR_INVALID_ARG;
+            }
+            s[slen - 1] = '\0';
+            if (xf_strcmp(s + 1, "global") == 0) {
+                cur = &global;
+                continue;
+            }
+            if (*count == max) {
+                XF_LOGE(TAG, "line %d: too many jobs", line_no);
+                return XF_ERR_NO_MEM;
+            }
+            cur = &jobs[(*count)++];
+            *cur = global;
+            xf_memcpy(cur->name, s + 1, slen - 1);
+            continue;
+        }
+
+        char *eq = s;
+        while (*eq != '\0' && *eq != '=') {
+            ++eq;
+        }
+        if (*eq != '=') {
+            XF_LOGE(TAG, "line %d: expected key=value", line_no);
+            return XF_ERR_INVALID_ARG;
+        }
+        *eq = '\0';
+        const char *key = line_trim(s, eq);
+        const char *value = line_trim(eq + 1, eq + 1 + xf_strlen(eq + 1));
+        if (!parse_item(cur, key, value)) {
+            XF_LOGE(TAG, "line %d: bad value for '%s'", line_no, key);
+            return XF_ERR_INVALID_ARG;
+        }
+    }
+    return XF_OK;
+}
+
+xf_err_t xf_vfs_bench_run(const xf_vfs_bench_job_t *job, xf_vfs_bench_result_t *result)
+{
+    if (job == NULL || result == NULL || !bench_job_valid(job)) {
+        return XF_ERR_INVALID_ARG;
+    }
+#if !BENCH_THREADS_IS_ENABLE
+    if (job->numjobs > 1) {
+        return XF_ERR_NOT_SUPPORTED;
+    }
+#endif
+    xf_memset(result, 0, sizeof(*result));
+
+    const uint32_t n = job->numjobs;
+    bench_worker_t *workers = xf_vfs_malloc(n * sizeof(bench_worker_t));
+    if (workers == NULL) {
+        return XF_ERR_NO_MEM;
+    }
+    xf_memset(workers, 0, n * sizeof(bench_worker_t));
+
+    xf_err_t err = XF_OK;
+#if BENCH_THREADS_IS_ENABLE
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "bench",
+    };
+    xf_osal_semaphore_t exited = xf_osal_semaphore_create(n, 0, &sem_attr);
+    if (exited == NULL) {
+        xf_vfs_free(workers);
+        return XF_ERR_NO_MEM;
+    }
+#endif
+    uint32_t prepared = 0;
+    for (; prepared < n; ++prepared) {
+        bench_worker_t *w = &workers[prepared];
+        w->job = job;
+        w->index = prepared;
+        /* 各线程的随机序列不同，且与线程数无关 */
+        w->rng = (job->seed != 0 ? job->seed : 1) * 0x9E3779B1u + prepared;
+        if (w->rng == 0) {
+            w->rng = 1;
+        }
+        if (job->rw != XF_VFS_BENCH_RW_META) {
+            w->fds = xf_vfs_malloc(job->nrfiles * sizeof(int));
+            w->buf = xf_vfs_malloc(job->bs);
+            if (w->fds == NULL || w->buf == NULL) {
+                err = XF_ERR_NO_MEM;
+                break;
+            }
+        }
+#if BENCH_THREADS_IS_ENABLE
+        w->exited = exited;
+#endif
+        if (!bench_prepare(w)) {
+            err = XF_FAIL;
+            ++prepared;
+            break;
+        }
+    }
+
+    if (err == XF_OK) {
+        const uint64_t start = XF_VFS_BENCH_TIME_NS();
+#if BENCH_THREADS_IS_ENABLE
+        const xf_osal_thread_attr_t attr = {
+            .name = "bench",
+            .stack_size = XF_VFS_BENCH_STACK_SIZE,
+            .priority = XF_OSAL_PRIORITY_NORMAL,
+        };
+        uint32_t started = 1;
+        for (; started < n; ++started) {
+            if (xf_osal_thread_create(bench_thread, &workers[started], &attr) == NULL) {
+                break;
+            }
+        }
+        bench_run_worker(&workers[0]);
+        for (uint32_t i = 1; i < started; ++i) {
+            xf_osal_semaphore_acquire(exited, XF_OSAL_WAIT_FOREVER);
+        }
+        if (started != n) {
+            err = XF_ERR_NO_MEM;
+        }
+#else
+        bench_run_worker(&workers[0]);
+#endif
+        result->elapsed_ns = XF_VFS_BENCH_TIME_NS() - start;
+
+        for (uint32_t i = 0; i < n; ++i) {
+            result->errors += workers[i].errors;
+            for (int op = 0; op < XF_VFS_BENCH_OP_MAX; ++op) {
+                result->op[op].ios += workers[i].op[op].ios;
+                result->op[op].bytes += workers[i].op[op].bytes;
+                xf_vfs_latency_hist_merge(&result->op[op].lat, &workers[i].op[op].lat);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+        bench_worker_t *w = &workers[i];
+        if (i < prepared) {
+            bench_cleanup(w);
+        }
+        xf_vfs_free(w->fds);
+        xf_vfs_free(w->buf);
+    }
+#if BENCH_THREADS_IS_ENABLE
+    xf_osal_semaphore_delete(exited);
+#endif
+    xf_vfs_free(workers);
+    return err;
+}
+
+void xf_vfs_bench_report(const xf_vfs_bench_job_t *job, const xf_vfs_bench_result_t *result)
+{
+    static const uint16_t s_permyriad[] = { 5000, 9000, 9900, 9990, 10000 };
+    if (job == NULL || result == NULL) {
+        return;
+    }
+    const uint64_t us = result->elapsed_ns / 1000;
+    xf_log_printf("[%s] rw=%s bs=%lu size=%lu nrfiles=%lu numjobs=%u: %lu us, errors %lu\n",
+                  job->name, (job->rw < XF_VFS_BENCH_RW_MAX) ? s_rw_names[job->rw] : "?",
+                  (unsigned long)job->bs, (unsigned long)job->size, (unsigned long)job->nrfiles,
+                  (unsigned)job->numjobs, (unsigned long)us, (unsigned long)result->errors);
+    xf_log_printf("  <op> ios KiB KiB/s IOPS p50 p90 p99 p99.9 max (us)\n");
+    for (int op = 0; op < XF_VFS_BENCH_OP_MAX; ++op) {
+        const xf_vfs_bench_stats_t *st = &result->op[op];
+        if (st->ios == 0) {
+            continue;
+        }
+        xf_log_printf("  %s %lu %lu %lu %lu", s_op_names[op], (unsigned long)st->ios,
+                      (unsigned long)(st->bytes / 1024),
+                      (unsigned long)((us != 0) ? st->bytes * 1000000 / 1024 / us : 0),
+                      (unsigned long)((us != 0) ? (uint64_t)st->ios * 1000000 / us : 0));
+        for (size_t i = 0; i < sizeof(s_permyriad) / sizeof(s_permyriad[0]); ++i) {
+            const uint32_t ns = xf_vfs_latency_value_at(&st->lat, s_permyriad[i]);
+            xf_log_printf(" %lu.%lu", (unsigned long)(ns / 1000), (unsigned long)((ns % 1000) / 100));
+        }
+        xf_log_printf("\n");
+    }
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static bool bench_is_read_only(const xf_vfs_bench_job_t *job)
+{
+    return job->rw == XF_VFS_BENCH_RW_READ || job->rw == XF_VFS_BENCH_RW_RANDREAD;
+}
+
+static bool bench_job_valid(const xf_vfs_bench_job_t *job)
+{
+    if (job->rw >= XF_VFS_BENCH_RW_MAX || job->rwmixread > 100 || job->nrfiles == 0
+            || job->numjobs == 0 || job->numjobs > XF_VFS_BENCH_THREADS_MAX
+            || job->directory[0] == '\0') {
+        return false;
+    }
+    return job->rw == XF_VFS_BENCH_RW_META || (job->bs != 0 && job->bs <= job->size);
+}
+
+static const char *bench_path(bench_worker_t *w, uint32_t file)
+{
+    char *p = w->path;
+    const size_t dlen = xf_strlen(w->job->directory);
+    xf_memcpy(p, w->job->directory, dlen);
+    p += dlen;
+    if (dlen == 0 || p[-1] != '/') {
+        *p++ = '/';
+    }
+    const size_t nlen = xf_strlen(w->job->name);
+    xf_memcpy(p, w->job->name, nlen);
+    p += nlen;
+    const uint32_t nums[2] = { w->index, file };
+    for (int i = 0; i < 2; ++i) {
+        char digits[10];
+        size_t d = 0;
+        uint32_t v = nums[i];
+        do {
+            digits[d++] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v != 0);
+        *p++ = '.';
+        while (d > 0) {
+            *p++ = digits[--d];
+        }
+    }
+    *p = '\0';
+    return w->path;
+}
+
+static uint32_t bench_random(bench_worker_t *w)
+{
+    uint32_t x = w->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    w->rng = x;
+    return x;
+}
+
+static void bench_account(bench_worker_t *w, xf_vfs_bench_op_t op, uint64_t t0, bool ok, uint32_t bytes)
+{
+    const uint64_t t1 = XF_VFS_BENCH_TIME_NS();
+    if (!ok) {
+        ++w->errors;
+        return;
+    }
+    xf_vfs_bench_stats_t *st = &w->op[op];
+    ++st->ios;
+    st->bytes += bytes;
+    xf_vfs_latency_hist_add(&st->lat, t1 - t0);
+}
+
+/* 打开（并在需要读时写满）线程的文件，不计时 */
+static bool bench_prepare(bench_worker_t *w)
+{
+    const xf_vfs_bench_job_t *job = w->job;
+    if (job->rw == XF_VFS_BENCH_RW_META) {
+        return true;
+    }
+    for (uint32_t i = 0; i < job->nrfiles; ++i) {
+        w->fds[i] = -1;
+    }
+    xf_memset(w->buf, BENCH_FILL_BYTE, job->bs);
+    const bool fill = (job->rw != XF_VFS_BENCH_RW_WRITE && job->rw != XF_VFS_BENCH_RW_RANDWRITE);
+    for (uint32_t i = 0; i < job->nrfiles; ++i) {
+        w->fds[i] = xf_vfs_open(bench_path(w, i), XF_VFS_O_RDWR | XF_VFS_O_CREAT | XF_VFS_O_TRUNC, 0666);
+        if (w->fds[i] < 0) {
+            return false;
+        }
+        for (uint32_t off = 0; fill && off < job->size; off += job->bs) {
+            const uint32_t n = (job->size - off < job->bs) ? job->size - off : job->bs;
+            if (xf_vfs_pwrite(w->fds[i], w->buf, n, (xf_vfs_off_t)off) != (xf_vfs_ssize_t)n) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void bench_cleanup(bench_worker_t *w)
+{
+    const xf_vfs_bench_job_t *job = w->job;
+    for (uint32_t i = 0; i < job->nrfiles; ++i) {
+        if (w->fds != NULL && w->fds[i] >= 0) {
+            xf_vfs_close(w->fds[i]);
+            w->fds[i] = -1;
+        }
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+        /* meta 作业正常结束时文件已删除 */
+        if (job->rw != XF_VFS_BENCH_RW_META || w->errors != 0) {
+            xf_vfs_unlink(bench_path(w, i));
+        }
+#endif
+    }
+}
+
+static void bench_run_data(bench_worker_t *w)
+{
+    const xf_vfs_bench_job_t *job = w->job;
+    const uint32_t blocks = job->size / job->bs;
+    const uint32_t ios = (job->ios != 0) ? job->ios : job->nrfiles * blocks;
+    const bool random = (job->rw == XF_VFS_BENCH_RW_RANDREAD || job->rw == XF_VFS_BENCH_RW_RANDWRITE
+                         || job->rw == XF_VFS_BENCH_RW_RANDRW);
+    const bool mixed = (job->rw == XF_VFS_BENCH_RW_RW || job->rw == XF_VFS_BENCH_RW_RANDRW);
+    uint32_t file = 0;
+    uint32_t block = 0;
+    uint32_t writes = 0;
+
+    for (uint32_t i = 0; i < ios; ++i) {
+        bool is_read;
+        if (mixed) {
+            is_read = (bench_random(w) % 100) < job->rwmixread;
+        } else {
+            is_read = bench_is_read_only(job);
+        }
+        if (random) {
+            file = (job->nrfiles > 1) ? bench_random(w) % job->nrfiles : 0;
+            block = bench_random(w) % blocks;
+        }
+        const int fd = w->fds[file];
+        const xf_vfs_off_t off = (xf_vfs_off_t)block * job->bs;
+
+        const uint64_t t0 = XF_VFS_BENCH_TIME_NS();
+        if (is_read) {
+            const xf_vfs_ssize_t n = xf_vfs_pread(fd, w->buf, job->bs, off);
+            bench_account(w, XF_VFS_BENCH_OP_READ, t0, n == (xf_vfs_ssize_t)job->bs, job->bs);
+        } else {
+            const xf_vfs_ssize_t n = xf_vfs_pwrite(fd, w->buf, job->bs, off);
+            bench_account(w, XF_VFS_BENCH_OP_WRITE, t0, n == (xf_vfs_ssize_t)job->bs, job->bs);
+            if (job->fsync != 0 && ++writes % job->fsync == 0) {
+                const uint64_t ts = XF_VFS_BENCH_TIME_NS();
+                bench_account(w, XF_VFS_BENCH_OP_FSYNC, ts, xf_vfs_fsync(fd) == 0, 0);
+            }
+        }
+
+        if (!random && ++block == blocks) {
+            block = 0;
+            file = (file + 1) % job->nrfiles;
+        }
+    }
+}
+
+static void bench_run_meta(bench_worker_t *w)
+{
+    const xf_vfs_bench_job_t *job = w->job;
+    for (uint32_t i = 0; i < job->nrfiles; ++i) {
+        const char *path = bench_path(w, i);
+        const uint64_t t0 = XF_VFS_BENCH_TIME_NS();
+        const int fd = xf_vfs_open(path, XF_VFS_O_WRONLY | XF_VFS_O_CREAT | XF_VFS_O_TRUNC, 0666);
+        bench_account(w, XF_VFS_BENCH_OP_CREATE, t0, fd >= 0 && xf_vfs_close(fd) == 0, 0);
+    }
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    for (uint32_t i = 0; i < job->nrfiles; ++i) {
+        const char *path = bench_path(w, i);
+        xf_vfs_stat_t st;
+        const uint64_t t0 = XF_VFS_BENCH_TIME_NS();
+        bench_account(w, XF_VFS_BENCH_OP_STAT, t0, xf_vfs_stat(path, &st) == 0, 0);
+    }
+    for (uint32_t i = 0; i < job->nrfiles; ++i) {
+        const char *path = bench_path(w, i);
+        const uint64_t t0 = XF_VFS_BENCH_TIME_NS();
+        bench_account(w, XF_VFS_BENCH_OP_UNLINK, t0, xf_vfs_unlink(path) == 0, 0);
+    }
+#endif
+}
+
+static void bench_run_worker(bench_worker_t *w)
+{
+    if (w->job->rw == XF_VFS_BENCH_RW_META) {
+        bench_run_meta(w);
+    } else {
+        bench_run_data(w);
+    }
+}
+
+#if BENCH_THREADS_IS_ENABLE
+static void bench_thread(void *argument)
+{
+    bench_worker_t *w = argument;
+    bench_run_worker(w);
+    xf_osal_semaphore_release(w->exited);
+    xf_osal_thread_delete(NULL);
+}
+#endif
+
+/* 去掉 [s, end) 两端的空白，返回开头并在结尾写入 '\0' */
+static char *line_trim(char *s, char *end)
+{
+    while (s < end && (*s == ' ' || *s == '\t')) {
+        ++s;
+    }
+    while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+        --end;
+    }
+    *end = '\0';
+    return s;
+}
+
+static bool parse_size(const char *s, uint32_t *out)
+{
+    uint64_t v = 0;
+    const char *p = s;
+    while (*p >= '0' && *p <= '9') {
+        v = v * 10 + (uint64_t)(*p++ - '0');
+        if (v > UINT32_MAX) {
+            return false;
+        }
+    }
+    if (p == s) {
+        return false;
+    }
+    if ((*p == 'K' || *p == 'k') && p[1] == '\0') {
+        v *= 1024;
+    } else if ((*p == 'M' || *p == 'm') && p[1] == '\0') {
+        v *= 1024 * 1024;
+    } else if (*p != '\0') {
+        return false;
+    }
+    if (v > UINT32_MAX) {
+        return false;
+    }
+    *out = (uint32_t)v;
+    return true;
+}
+
+static bool parse_item(xf_vfs_bench_job_t *job, const char *key, const char *value)
+{
+    uint32_t v;
+    if (xf_strcmp(key, "rw") == 0) {
+        for (int i = 0; i < XF_VFS_BENCH_RW_MAX; ++i) {
+            if (xf_strcmp(value, s_rw_names[i]) == 0) {
+                job->rw = (uint8_t)i;
+                return true;
+            }
+        }
+        return false;
+    }
+    if (xf_strcmp(key, "directory") == 0) {
+        const size_t len = xf_strlen(value);
+        if (len == 0 || len >= XF_VFS_BENCH_PATH_MAX) {
+            return false;
+        }
+        xf_memcpy(job->directory, value, len + 1);
+        return true;
+    }
+    if (!parse_size(value, &v)) {
+        return false;
+    }
+    if (xf_strcmp(key, "bs") == 0) {
+        job->bs = v;
+    } else if (xf_strcmp(key, "size") == 0) {
+        job->size = v;
+    } else if (xf_strcmp(key, "nrfiles") == 0) {
+        job->nrfiles = v;
+    } else if (xf_strcmp(key, "ios") == 0) {
+        job->ios = v;
+    } else if (xf_strcmp(key, "fsync") == 0) {
+        job->fsync = v;
+    } else if (xf_strcmp(key, "seed") == 0) {
+        job->seed = v;
+    } else if (xf_strcmp(key, "numjobs") == 0 && v >= 1 && v <= XF_VFS_BENCH_THREADS_MAX) {
+        job->numjobs = (uint16_t)v;
+    } else if (xf_strcmp(key, "rwmixread") == 0 && v <= 100) {
+        job->rwmixread = (uint8_t)v;
+    } else {
+        return false;
+    }
+    return true;
+}
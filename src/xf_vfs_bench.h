@@ -0,0 +1,181 @@
+/**
+ * @file xf_vfs_bench.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs 负载生成器：按作业描述通过 xf_vfs_* 接口产生顺序/随机读写、混合读写、
+ *        多线程并发与元数据（创建/stat/删除）负载，统计带宽、IOPS 与延迟分位数，
+ *        用于在同一接口下比较不同的存储后端。作业格式类似 fio 的作业文件。
+ * @version 1.0
+ * @date 2025-01-22
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __XF_VFS_BENCH_H__
+#define __XF_VFS_BENCH_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs.h"
+#include "xf_vfs_latency.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @cond (XFAPI_USER || XFAPI_PORT || XFAPI_INTERNAL)
+ * @addtogroup group_xf_vfs
+ * @endcond
+ * @{
+ */
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 作业的访问方式（作业文件中的 rw=）。
+ */
+typedef enum {
+    XF_VFS_BENCH_RW_READ = 0,       /*!< "read"：顺序读 */
+    XF_VFS_BENCH_RW_WRITE,          /*!< "write"：顺序写 */
+    XF_VFS_BENCH_RW_RANDREAD,       /*!< "randread"：随机读 */
+    XF_VFS_BENCH_RW_RANDWRITE,      /*!< "randwrite"：随机写 */
+    XF_VFS_BENCH_RW_RW,             /*!< "rw"：顺序混合读写，读的比例为 rwmixread */
+    XF_VFS_BENCH_RW_RANDRW,         /*!< "randrw"：随机混合读写 */
+    XF_VFS_BENCH_RW_META,           /*!< "meta"：依次创建、stat、删除 nrfiles 个文件 */
+    XF_VFS_BENCH_RW_MAX,
+} xf_vfs_bench_rw_t;
+
+/**
+ * @brief 分别统计的操作类别。
+ */
+typedef enum {
+    XF_VFS_BENCH_OP_READ = 0,
+    XF_VFS_BENCH_OP_WRITE,
+    XF_VFS_BENCH_OP_FSYNC,
+    XF_VFS_BENCH_OP_CREATE,         /*!< open(O_CREAT) 加 close */
+    XF_VFS_BENCH_OP_STAT,
+    XF_VFS_BENCH_OP_UNLINK,
+    XF_VFS_BENCH_OP_MAX,
+} xf_vfs_bench_op_t;
+
+/**
+ * @brief 一个作业。每个线程使用自己的 nrfiles 个文件，
+ * 文件名为 "<directory>/<name>.<线程号>.<文件号>".
+ */
+typedef struct {
+    char name[XF_VFS_BENCH_NAME_MAX];       /*!< 作业名（作业文件中的 [name]） */
+    char directory[XF_VFS_BENCH_PATH_MAX];  /*!< 存放文件的目录（directory=），须已存在 */
+    uint8_t rw;                 /*!< xf_vfs_bench_rw_t（rw=） */
+    uint8_t rwmixread;          /*!< 混合读写中读的百分比（rwmixread=），默认 50 */
+    uint16_t numjobs;           /*!< 并发线程数，即队列深度（numjobs=），默认 1 */
+    uint32_t bs;                /*!< 每次读写的字节数（bs=），默认 4K */
+    uint32_t size;              /*!< 每个文件的大小（size=），默认 64K */
+    uint32_t nrfiles;           /*!< 每个线程的文件数（nrfiles=），默认 1 */
+    uint32_t ios;               /*!< 每个线程的读写次数（ios=），0 为把所有文件完整读写一遍 */
+    uint32_t fsync;             /*!< 每写若干次 fsync 一次（fsync=），0 为不 fsync */
+    uint32_t seed;              /*!< 随机偏移与混合读写的种子（seed=），默认 1 */
+} xf_vfs_bench_job_t;
+
+/**
+ * @brief 一类操作的统计。
+ */
+typedef struct {
+    uint32_t ios;               /*!< 成功的次数 */
+    uint64_t bytes;             /*!< 读写的字节数 */
+    xf_vfs_latency_hist_t lat;  /*!< 每次的耗时 */
+} xf_vfs_bench_stats_t;
+
+/**
+ * @brief 一个作业的结果。
+ */
+typedef struct {
+    uint32_t errors;            /*!< 失败的操作数 */
+    uint64_t elapsed_ns;        /*!< 从所有线程开始到全部结束的时间，不含准备与清理文件 */
+    xf_vfs_bench_stats_t op[XF_VFS_BENCH_OP_MAX];
+} xf_vfs_bench_result_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 把所有字段设为默认值，name 与 directory 为空。
+ */
+void xf_vfs_bench_job_init(xf_vfs_bench_job_t *job);
+
+/**
+ * @brief 解析作业文件。
+ *
+ * 格式：
+ * - 每行一个 `key=value`，'#' 或 ';' 开头的行为注释；
+ * - `[name]` 开始一个作业，其后的设置属于该作业；
+ * - `[global]` 中的设置作为之后各作业的默认值；
+ * - 大小可带 K/M 后缀（1024 进制）。
+ *
+ * 例如：
+ * @code
+ * [global]
+ * directory=/sd/bench
+ * size=256K
+ *
+ * [seqwrite]
+ * rw=write
+ * bs=4K
+ * fsync=16
+ *
+ * [randread-qd4]
+ * rw=randread
+ * bs=512
+ * numjobs=4
+ * ios=2000
+ *
+ * [files]
+ * rw=meta
+ * nrfiles=200
+ * @endcode
+ *
+ * @param text  作业文件的内容。
+ * @param jobs  输出。
+ * @param max   jobs 的个数。
+ * @param count 输出，解析出的作业数。
+ *
+ * @return  XF_OK if successful.
+ *          XF_ERR_INVALID_ARG if the text has an error (the line is logged).
+ *          XF_ERR_NO_MEM if there are more than max jobs.
+ */
+xf_err_t xf_vfs_bench_parse(const char *text, xf_vfs_bench_job_t *jobs, size_t max, size_t *count);
+
+/**
+ * @brief 运行一个作业：准备文件，启动 numjobs 个线程并计时，结束后删除文件。
+ *
+ * 读写均使用 xf_vfs_pread()/xf_vfs_pwrite()，读之前先把文件写满到 size（不计时）。
+ *
+ * @param job    作业。
+ * @param result 输出。
+ *
+ * @return  XF_OK if successful（个别操作失败记入 result->errors）.
+ *          XF_ERR_INVALID_ARG if the job is invalid.
+ *          XF_ERR_NOT_SUPPORTED if numjobs > 1 without xf_osal.
+ *          XF_ERR_NO_MEM if out of memory.
+ *          XF_FAIL if the files could not be prepared.
+ */
+xf_err_t xf_vfs_bench_run(const xf_vfs_bench_job_t *job, xf_vfs_bench_result_t *result);
+
+/**
+ * @brief 打印作业结果：每类操作的次数、带宽、IOPS 与延迟 p50/p90/p99/p99.9/max.
+ */
+void xf_vfs_bench_report(const xf_vfs_bench_job_t *job, const xf_vfs_bench_result_t *result);
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * End of addtogroup group_xf_vfs
+ * @}
+ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __XF_VFS_BENCH_H__ */
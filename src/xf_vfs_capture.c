@@ -0,0 +1,1109 @@
+/**
+ * @file xf_vfs_capture.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs capture（I/O 负载记录）驱动与重放。
+ * @version 1.0
+ * @date 2025-01-21
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs_capture.h"
+#include "xf_vfs_mem.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define FNV64_OFFSET            (0xCBF29CE484222325ull)
+#define FNV64_PRIME             (0x00000100000001B3ull)
+
+#define NAMES_INIT_CAP          (16)    /* 名字表的初始容量，须为 2 的幂 */
+#define REPLAY_FILL_BYTE        (0xA5)  /* 重放写入的数据 */
+
+/* ==================== [Typedefs] ========================================== */
+
+/* 每种操作记录的路径数与整数参数个数（fd/目录号在参数的首位） */
+typedef struct {
+    uint8_t paths;
+    uint8_t args;
+} cap_layout_t;
+
+typedef struct {
+    xf_vfs_dir_t base;          /*!< 必须位于首位 */
+    xf_vfs_dir_t *inner;
+    uint32_t id;                /*!< 记录中的目录号 */
+} cap_dir_t;
+
+/* 路径分量名字的哈希到编号，开放寻址，hash 为 0 表示空位 */
+typedef struct {
+    uint64_t hash;
+    uint32_t id;
+} cap_name_t;
+
+typedef struct _cap_t {
+    struct _cap_t *next;
+    char *base_path;
+    char *target;
+    xf_lock_t lock;
+    xf_vfs_capture_write_t write;
+    void *arg;
+    bool failed;                /*!< 输出失败或内存不足，之后的记录被丢弃 */
+    uint64_t last_ts;           /*!< 上一条记录的开始时间 */
+    uint32_t next_dir;
+    cap_name_t *names;
+    uint32_t names_cap;
+    uint32_t names_count;
+    size_t len;
+    uint8_t buf[XF_VFS_CAPTURE_BUF_SIZE];
+} cap_t;
+
+typedef struct {
+    uint32_t id;
+    xf_vfs_dir_t *dir;          /*!< NULL 为空位 */
+} replay_dir_t;
+
+typedef struct {
+    const char *root;
+    xf_vfs_capture_read_t read;
+    void *arg;
+    bool read_failed;
+    size_t pos;
+    size_t len;
+    uint8_t *data;              /*!< 读写使用的缓冲区 */
+    size_t data_size;
+    int fds[XF_VFS_FDS_MAX];    /*!< 记录时的 fd 到重放时的 fd，-1 为没有打开 */
+    replay_dir_t dirs[XF_VFS_REPLAY_DIRS_MAX];
+    char path[2][XF_VFS_CAPTURE_PATH_MAX];
+    uint8_t buf[XF_VFS_CAPTURE_BUF_SIZE];
+} replay_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static char *cap_strdup(const char *s);
+static int cap_join(char *buf, const char *base, const char *path);
+static void cap_flush(cap_t *c);
+static void cap_put(cap_t *c, uint8_t b);
+static void cap_put_uint(cap_t *c, uint64_t v);
+static void cap_put_int(cap_t *c, int64_t v);
+static bool cap_name_id(cap_t *c, uint64_t hash, uint32_t *id);
+static void cap_put_path(cap_t *c, const char *path);
+static void cap_record(cap_t *c, xf_vfs_trace_op_t op, uint64_t t0, int64_t ret,
+                       const char *p1, const char *p2, const int64_t *args);
+
+static bool in_byte(replay_t *r, uint8_t *b);
+static bool in_uint(replay_t *r, uint64_t *v);
+static bool in_int(replay_t *r, int64_t *v);
+static bool in_path(replay_t *r, char *buf, bool *fits);
+static int replay_fd(replay_t *r, int64_t fd);
+static replay_dir_t *replay_dir(replay_t *r, int64_t id);
+static bool replay_data(replay_t *r, int64_t size);
+static int64_t replay_exec(replay_t *r, xf_vfs_trace_op_t op, int64_t rec_ret, const int64_t *a,
+                           bool *skipped, xf_vfs_replay_stats_t *stats);
+static void replay_cleanup(replay_t *r);
+
+static int cap_open(void *ctx, const char *path, int flags, int mode);
+static int cap_close(void *ctx, int fd);
+static xf_vfs_ssize_t cap_read(void *ctx, int fd, void *dst, size_t size);
+static xf_vfs_ssize_t cap_write(void *ctx, int fd, const void *data, size_t size);
+static xf_vfs_ssize_t cap_pread(void *ctx, int fd, void *dst, size_t size, xf_vfs_off_t offset);
+static xf_vfs_ssize_t cap_pwrite(void *ctx, int fd, const void *src, size_t size, xf_vfs_off_t offset);
+static xf_vfs_off_t cap_lseek(void *ctx, int fd, xf_vfs_off_t offset, int mode);
+static int cap_fstat(void *ctx, int fd, xf_vfs_stat_t *st);
+static int cap_fsync(void *ctx, int fd);
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+static int cap_stat(void *ctx, const char *path, xf_vfs_stat_t *st);
+static int cap_link(void *ctx, const char *n1, const char *n2);
+static int cap_unlink(void *ctx, const char *path);
+static int cap_rename(void *ctx, const char *src, const char *dst);
+static xf_vfs_dir_t *cap_opendir(void *ctx, const char *name);
+static xf_vfs_dirent_t *cap_readdir(void *ctx, xf_vfs_dir_t *pdir);
+static long cap_telldir(void *ctx, xf_vfs_dir_t *pdir);
+static void cap_seekdir(void *ctx, xf_vfs_dir_t *pdir, long offset);
+static int cap_closedir(void *ctx, xf_vfs_dir_t *pdir);
+static int cap_mkdir(void *ctx, const char *name, xf_vfs_mode_t mode);
+static int cap_rmdir(void *ctx, const char *name);
+static int cap_access(void *ctx, const char *path, int amode);
+static int cap_truncate(void *ctx, const char *path, xf_vfs_off_t length);
+static int cap_ftruncate(void *ctx, int fd, xf_vfs_off_t length);
+static int cap_utime(void *ctx, const char *path, const xf_vfs_utimbuf_t *times);
+#endif
+
+/* ==================== [Static Variables] ================================== */
+
+static cap_t *s_caps = NULL;
+
+static const cap_layout_t s_layout[XF_VFS_TRACE_OP_MAX] = {
+    [XF_VFS_TRACE_OP_OPEN]      = { 1, 2 },     /* flags, mode */
+    [XF_VFS_TRACE_OP_CLOSE]     = { 0, 1 },
+    [XF_VFS_TRACE_OP_READ]      = { 0, 2 },     /* fd, size */
+    [XF_VFS_TRACE_OP_WRITE]     = { 0, 2 },
+    [XF_VFS_TRACE_OP_PREAD]     = { 0, 3 },     /* fd, size, offset */
+    [XF_VFS_TRACE_OP_PWRITE]    = { 0, 3 },
+    [XF_VFS_TRACE_OP_LSEEK]     = { 0, 3 },     /* fd, offset, whence */
+    [XF_VFS_TRACE_OP_FSTAT]     = { 0, 1 },
+    [XF_VFS_TRACE_OP_FSYNC]     = { 0, 1 },
+    [XF_VFS_TRACE_OP_FTRUNCATE] = { 0, 2 },     /* fd, length */
+    [XF_VFS_TRACE_OP_STAT]      = { 1, 0 },
+    [XF_VFS_TRACE_OP_UTIME]     = { 1, 0 },
+    [XF_VFS_TRACE_OP_LINK]      = { 2, 0 },
+    [XF_VFS_TRACE_OP_UNLINK]    = { 1, 0 },
+    [XF_VFS_TRACE_OP_RENAME]    = { 2, 0 },
+    [XF_VFS_TRACE_OP_OPENDIR]   = { 1, 0 },
+    [XF_VFS_TRACE_OP_READDIR]   = { 0, 1 },     /* dir */
+    [XF_VFS_TRACE_OP_TELLDIR]   = { 0, 1 },
+    [XF_VFS_TRACE_OP_SEEKDIR]   = { 0, 2 },     /* dir, offset */
+    [XF_VFS_TRACE_OP_CLOSEDIR]  = { 0, 1 },
+    [XF_VFS_TRACE_OP_MKDIR]     = { 1, 1 },     /* mode */
+    [XF_VFS_TRACE_OP_RMDIR]     = { 1, 0 },
+    [XF_VFS_TRACE_OP_ACCESS]    = { 1, 1 },     /* amode */
+    [XF_VFS_TRACE_OP_TRUNCATE]  = { 1, 1 },     /* length */
+};
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+static const xf_vfs_dir_ops_t s_cap_dir_ops = {
+    .stat_p = cap_stat,
+    .link_p = cap_link,
+    .unlink_p = cap_unlink,
+    .rename_p = cap_rename,
+    .opendir_p = cap_opendir,
+    .readdir_p = cap_readdir,
+    .telldir_p = cap_telldir,
+    .seekdir_p = cap_seekdir,
+    .closedir_p = cap_closedir,
+    .mkdir_p = cap_mkdir,
+    .rmdir_p = cap_rmdir,
+    .access_p = cap_access,
+    .truncate_p = cap_truncate,
+    .ftruncate_p = cap_ftruncate,
+    .utime_p = cap_utime,
+};
+#endif
+
+static const xf_vfs_fs_ops_t s_cap_ops = {
+    .write_p = cap_write,
+    .lseek_p = cap_lseek,
+    .read_p = cap_read,
+    .pread_p = cap_pread,
+    .pwrite_p = cap_pwrite,
+    .open_p = cap_open,
+    .close_p = cap_close,
+    .fstat_p = cap_fstat,
+    .fsync_p = cap_fsync,
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    .dir = &s_cap_dir_ops,
+#endif
+};
+
+/* ==================== [Macros] ============================================ */
+
+/* 转发 call 并记录，参数依次为 s_layout 中的整数参数（没有时传 0） */
+#define CAPTURE_CALL(ctx, op, type, call, p1, p2, ...) \
+    do { \
+        const uint64_t t0 = XF_VFS_CAPTURE_TIME_NS(); \
+        type ret = call; \
+        cap_record((cap_t *)(ctx), (op), t0, (int64_t)ret, (p1), (p2), \
+                   (const int64_t[]){ __VA_ARGS__ }); \
+        return ret; \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+xf_err_t xf_vfs_capture_start(const char *base_path, const char *target_path,
+                              xf_vfs_capture_write_t write, void *arg)
+{
+    if (base_path == NULL || target_path == NULL || write == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+
+    cap_t *c = xf_vfs_malloc(sizeof(cap_t));
+    if (c == NULL) {
+        return XF_ERR_NO_MEM;
+    }
+    xf_memset(c, 0, sizeof(cap_t));
+    c->write = write;
+    c->arg = arg;
+    c->base_path = cap_strdup(base_path);
+    c->target = cap_strdup(target_path);
+    xf_err_t err = XF_ERR_NO_MEM;
+    if (c->base_path == NULL || c->target == NULL || xf_lock_init(&c->lock) != XF_OK) {
+        goto fail;
+    }
+
+    xf_vfs_capture_header_t hdr = { .magic = XF_VFS_CAPTURE_MAGIC };
+    hdr.version = XF_VFS_CAPTURE_VERSION;
+    hdr.op_count = XF_VFS_TRACE_OP_MAX;
+    if (write(&hdr, sizeof(hdr), arg) != (xf_vfs_ssize_t)sizeof(hdr)) {
+        err = XF_FAIL;
+        goto fail;
+    }
+
+    c->last_ts = XF_VFS_CAPTURE_TIME_NS();
+    err = xf_vfs_register_fs(base_path, &s_cap_ops, XF_VFS_FLAG_CONTEXT_PTR | XF_VFS_FLAG_STATIC, c);
+    if (err != XF_OK) {
+        goto fail;
+    }
+
+    c->next = s_caps;
+    s_caps = c;
+    return XF_OK;
+
+fail:
+    if (c->lock) {
+        xf_lock_destroy(c->lock);
+    }
+    xf_vfs_free(c->base_path);
+    xf_vfs_free(c->target);
+    xf_vfs_free(c);
+    return err;
+}
+
+xf_err_t xf_vfs_capture_stop(const char *base_path)
+{
+    cap_t **pp = &s_caps;
+    while (*pp && xf_strcmp((*pp)->base_path, base_path) != 0) {
+        pp = &(*pp)->next;
+    }
+    cap_t *c = *pp;
+    if (c == NULL) {
+        return XF_ERR_INVALID_STATE;
+    }
+    xf_err_t err = xf_vfs_unregister_fs(base_path);
+    if (err != XF_OK) {
+        return err;
+    }
+    *pp = c->next;
+
+    cap_flush(c);
+    err = c->failed ? XF_FAIL : XF_OK;
+    xf_lock_destroy(c->lock);
+    xf_vfs_free(c->names);
+    xf_vfs_free(c->base_path);
+    xf_vfs_free(c->target);
+    xf_vfs_free(c);
+    return err;
+}
+
+xf_err_t xf_vfs_replay(const char *root, xf_vfs_capture_read_t read, void *arg,
+                       bool timed, xf_vfs_replay_stats_t *stats)
+{
+    if (root == NULL || read == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+    xf_vfs_replay_stats_t local;
+    if (stats == NULL) {
+        stats = &local;
+    }
+    xf_memset(stats, 0, sizeof(*stats));
+
+    replay_t *r = xf_vfs_malloc(sizeof(replay_t));
+    if (r == NULL) {
+        return XF_ERR_NO_MEM;
+    }
+    xf_memset(r, 0, sizeof(replay_t));
+    r->root = (xf_strcmp(root, "/") == 0) ? "" : root;
+    r->read = read;
+    r->arg = arg;
+    for (size_t i = 0; i < XF_VFS_FDS_MAX; ++i) {
+        r->fds[i] = -1;
+    }
+
+    xf_err_t err = XF_OK;
+    xf_vfs_capture_header_t hdr;
+    uint8_t *p = (uint8_t *)&hdr;
+    for (size_t i = 0; i < sizeof(hdr); ++i) {
+        if (!in_byte(r, &p[i])) {
+            err = r->read_failed ? XF_FAIL : XF_ERR_INVALID_ARG;
+            goto out;
+        }
+    }
+    if (xf_memcmp(hdr.magic, XF_VFS_CAPTURE_MAGIC, sizeof(hdr.magic)) != 0) {
+        err = XF_ERR_INVALID_ARG;
+        goto out;
+    }
+    if (hdr.version != XF_VFS_CAPTURE_VERSION || hdr.op_count != XF_VFS_TRACE_OP_MAX) {
+        err = XF_ERR_NOT_SUPPORTED;
+        goto out;
+    }
+
+    const uint64_t start = XF_VFS_CAPTURE_TIME_NS();
+    int64_t ts = 0;
+    int64_t ts_first = 0;
+    int64_t ts_last = 0;
+    bool first = true;
+    uint8_t op;
+    while (in_byte(r, &op)) {
+        int64_t dt;
+        uint64_t dur;
+        int64_t rec_ret;
+        int64_t rec_err;
+        int64_t a[3] = { 0 };
+        bool fits[2] = { true, true };
+        bool ok = (op < XF_VFS_TRACE_OP_MAX) && in_int(r, &dt) && in_uint(r, &dur) && in_int(r, &rec_ret)
+                  && (rec_ret >= 0 || in_int(r, &rec_err));
+        for (uint8_t i = 0; ok && i < s_layout[op].paths; ++i) {
+            ok = in_path(r, r->path[i], &fits[i]);
+        }
+        for (uint8_t i = 0; ok && i < s_layout[op].args; ++i) {
+            ok = in_int(r, &a[i]);
+        }
+        if (!ok) {
+            err = r->read_failed ? XF_FAIL : XF_ERR_INVALID_ARG;
+            break;
+        }
+
+        ts += dt;
+        if (first) {
+            ts_first = ts;
+            first = false;
+        }
+        ts_last = ts;
+        if (timed) {
+            const int64_t due = ts - ts_first;
+            const int64_t now = (int64_t)(XF_VFS_CAPTURE_TIME_NS() - start);
+            if (due > now && (due - now) >= 1000) {
+                XF_VFS_REPLAY_DELAY_US((uint32_t)(((due - now) / 1000 > UINT32_MAX) ? UINT32_MAX : (due - now) / 1000));
+            }
+        }
+
+        if (!fits[0] || !fits[1]) {
+            ++stats->skipped;
+            continue;
+        }
+        bool skipped = false;
+        const uint64_t t0 = XF_VFS_CAPTURE_TIME_NS();
+        const int64_t ret = replay_exec(r, (xf_vfs_trace_op_t)op, rec_ret, a, &skipped, stats);
+        const uint64_t t1 = XF_VFS_CAPTURE_TIME_NS();
+        if (r->data == NULL && r->data_size != 0) {
+            err = XF_ERR_NO_MEM;
+            break;
+        }
+        if (skipped) {
+            ++stats->skipped;
+            continue;
+        }
+        xf_vfs_replay_op_stats_t *os = &stats->op[op];
+        const uint64_t ns = t1 - t0;
+        ++stats->ops;
+        ++os->count;
+        os->total_ns += ns;
+        if (ns > os->max_ns) {
+            os->max_ns = (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+        }
+        if ((rec_ret < 0) != (ret < 0)) {
+            ++stats->mismatches;
+        }
+    }
+    if (err == XF_OK && r->read_failed) {
+        err = XF_FAIL;
+    }
+    stats->elapsed_ns = XF_VFS_CAPTURE_TIME_NS() - start;
+    stats->recorded_ns = (uint64_t)(ts_last - ts_first);
+
+out:
+    replay_cleanup(r);
+    xf_vfs_free(r->data);
+    xf_vfs_free(r);
+    return err;
+}
+
+void xf_vfs_replay_report(const xf_vfs_replay_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    const uint64_t us = stats->elapsed_ns / 1000;
+    const uint64_t bytes = stats->bytes_read + stats->bytes_written;
+    xf_log_printf("------------------------------------------------------\n");
+    xf_log_printf("ops %lu, mismatches %lu, skipped %lu\n", (unsigned long)stats->ops,
+                  (unsigned long)stats->mismatches, (unsigned long)stats->skipped);
+    xf_log_printf("elapsed %lu us (recorded %lu us)\n",
+                  (unsigned long)us, (unsigned long)(stats->recorded_ns / 1000));
+    xf_log_printf("read %lu B, written %lu B, %lu KiB/s, %lu ops/s\n",
+                  (unsigned long)stats->bytes_read, (unsigned long)stats->bytes_written,
+                  (unsigned long)((us != 0) ? bytes * 1000000 / 1024 / us : 0),
+                  (unsigned long)((us != 0) ? (uint64_t)stats->ops * 1000000 / us : 0));
+    xf_log_printf("------------------------------------------------------\n");
+    xf_log_printf("<op> count avg max (us)\n");
+    for (int op = 0; op < XF_VFS_TRACE_OP_MAX; ++op) {
+        const xf_vfs_replay_op_stats_t *os = &stats->op[op];
+        if (os->count == 0) {
+            continue;
+        }
+        const uint64_t avg = os->total_ns / os->count;
+        xf_log_printf("%s %lu %lu.%lu %lu.%lu\n", xf_vfs_trace_op_name((xf_vfs_trace_op_t)op),
+                      (unsigned long)os->count,
+                      (unsigned long)(avg / 1000), (unsigned long)((avg % 1000) / 100),
+                      (unsigned long)(os->max_ns / 1000), (unsigned long)((os->max_ns % 1000) / 100));
+    }
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static char *cap_strdup(const char *s)
+{
+    size_t len = xf_strlen(s) + 1;
+    char *d = xf_vfs_malloc(len);
+    if (d) {
+        xf_memcpy(d, s, len);
+    }
+    return d;
+}
+
+static int cap_join(char *buf, const char *base, const char *path)
+{
+    const char *rest = (xf_strcmp(path, "/") == 0) ? "" : path;
+    size_t blen = xf_strlen(base);
+    size_t rlen = xf_strlen(rest);
+    if (blen + rlen + 1 > XF_VFS_CAPTURE_PATH_MAX) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    xf_memcpy(buf, base, blen);
+    xf_memcpy(buf + blen, rest, rlen + 1);
+    if (blen + rlen == 0) {
+        buf[0] = '/';
+        buf[1] = '\0';
+    }
+    return 0;
+}
+
+/* 以下 cap_* 输出函数调用时须持有 c->lock */
+
+static void cap_flush(cap_t *c)
+{
+    if (!c->failed && c->len != 0
+            && c->write(c->buf, c->len, c->arg) != (xf_vfs_ssize_t)c->len) {
+        c->failed = true;
+    }
+    c->len = 0;
+}
+
+static void cap_put(cap_t *c, uint8_t b)
+{
+    if (c->len == sizeof(c->buf)) {
+        cap_flush(c);
+    }
+    c->buf[c->len++] = b;
+}
+
+static void cap_put_uint(cap_t *c, uint64_t v)
+{
+    while (v >= 0x80) {
+        cap_put(c, (uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    cap_put(c, (uint8_t)v);
+}
+
+static void cap_put_int(cap_t *c, int64_t v)
+{
+    cap_put_uint(c, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+/* 取得名字的编号，新名字按出现顺序编号 */
+static bool cap_name_id(cap_t *c, uint64_t hash, uint32_t *id)
+{
+    if ((c->names_count + 1) * 4 > c->names_cap * 3) {
+        const uint32_t cap = (c->names_cap != 0) ? c->names_cap * 2 : NAMES_INIT_CAP;
+        cap_name_t *names = xf_vfs_malloc(cap * sizeof(cap_name_t));
+        if (names == NULL) {
+            return false;
+        }
+        xf_memset(names, 0, cap * sizeof(cap_name_t));
+        for (uint32_t i = 0; i < c->names_cap; ++i) {
+            if (c->names[i].hash == 0) {
+                continue;
+            }
+            uint32_t j = (uint32_t)c->names[i].hash & (cap - 1);
+            while (names[j].hash != 0) {
+                j = (j + 1) & (cap - 1);
+            }
+            names[j] = c->names[i];
+        }
+        xf_vfs_free(c->names);
+        c->names = names;
+        c->names_cap = cap;
+    }
+    uint32_t i = (uint32_t)hash & (c->names_cap - 1);
+    while (c->names[i].hash != 0 && c->names[i].hash != hash) {
+        i = (i + 1) & (c->names_cap - 1);
+    }
+    if (c->names[i].hash == 0) {
+        c->names[i].hash = hash;
+        c->names[i].id = c->names_count++;
+    }
+    *id = c->names[i].id;
+    return true;
+}
+
+/*
+ * 路径记录为分量数加各分量的编号。
+ * 编号按名字的 64 位哈希分配，只在内存中保存哈希，不保存也不输出名字。
+ */
+static void cap_put_path(cap_t *c, const char *path)
+{
+    uint32_t ids[XF_VFS_CAPTURE_PATH_MAX / 2];
+    uint32_t n = 0;
+    const char *s = path;
+    while (*s != '\0') {
+        while (*s == '/') {
+            ++s;
+        }
+        if (*s == '\0') {
+            break;
+        }
+        uint64_t hash = FNV64_OFFSET;
+        while (*s != '\0' && *s != '/') {
+            hash = (hash ^ (uint8_t)*s++) * FNV64_PRIME;
+        }
+        if (hash == 0) {
+            hash = 1;
+        }
+        if (n == sizeof(ids) / sizeof(ids[0]) || !cap_name_id(c, hash, &ids[n])) {
+            c->failed = true;
+            return;
+        }
+        ++n;
+    }
+    cap_put_uint(c, n);
+    for (uint32_t i = 0; i < n; ++i) {
+        cap_put_uint(c, ids[i]);
+    }
+}
+
+static void cap_record(cap_t *c, xf_vfs_trace_op_t op, uint64_t t0, int64_t ret,
+                       const char *p1, const char *p2, const int64_t *args)
+{
+    const uint64_t t1 = XF_VFS_CAPTURE_TIME_NS();
+    const int err = errno;
+
+    xf_lock_lock(c->lock);
+    if (!c->failed) {
+        cap_put(c, (uint8_t)op);
+        cap_put_int(c, (int64_t)(t0 - c->last_ts));
+        cap_put_uint(c, t1 - t0);
+        cap_put_int(c, ret);
+        if (ret < 0) {
+            cap_put_int(c, err);
+        }
+        if (s_layout[op].paths > 0) {
+            cap_put_path(c, p1);
+        }
+        if (s_layout[op].paths > 1) {
+            cap_put_path(c, p2);
+        }
+        for (uint8_t i = 0; i < s_layout[op].args; ++i) {
+            cap_put_int(c, args[i]);
+        }
+        c->last_ts = t0;
+    }
+    xf_lock_unlock(c->lock);
+
+    errno = err;
+}
+
+static bool in_byte(replay_t *r, uint8_t *b)
+{
+    if (r->pos == r->len) {
+        if (r->read_failed) {
+            return false;
+        }
+        xf_vfs_ssize_t n = r->read(r->buf, sizeof(r->buf), r->arg);
+        if (n <= 0) {
+            r->read_failed = (n < 0);
+            return false;
+        }
+        r->pos = 0;
+        r->len = (size_t)n;
+    }
+    *b = r->buf[r->pos++];
+    return true;
+}
+
+static bool in_uint(replay_t *r, uint64_t *v)
+{
+    uint64_t x = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t b;
+        if (!in_byte(r, &b)) {
+            return false;
+        }
+        x |= (uint64_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            *v = x;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool in_int(replay_t *r, int64_t *v)
+{
+    uint64_t x;
+    if (!in_uint(r, &x)) {
+        return false;
+    }
+    *v = (int64_t)(x >> 1) ^ -(int64_t)(x & 1);
+    return true;
+}
+
+/* 读取路径并还原为 root/n<id>/...，放不下时 fits 为 false（数据仍被读完） */
+static bool in_path(replay_t *r, char *buf, bool *fits)
+{
+    uint64_t n;
+    if (!in_uint(r, &n) || n > XF_VFS_CAPTURE_PATH_MAX) {
+        return false;
+    }
+    size_t len = xf_strlen(r->root);
+    *fits = (len < XF_VFS_CAPTURE_PATH_MAX);
+    if (*fits) {
+        xf_memcpy(buf, r->root, len + 1);
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        uint64_t id;
+        if (!in_uint(r, &id)) {
+            return false;
+        }
+        char digits[20];
+        size_t d = 0;
+        do {
+            digits[d++] = (char)('0' + id % 10);
+            id /= 10;
+        } while (id != 0);
+        if (!*fits || len + 2 + d + 1 > XF_VFS_CAPTURE_PATH_MAX) {
+            *fits = false;
+            continue;
+        }
+        buf[len++] = '/';
+        buf[len++] = 'n';
+        while (d > 0) {
+            buf[len++] = digits[--d];
+        }
+        buf[len] = '\0';
+    }
+    if (*fits && len == 0) {
+        buf[0] = '/';
+        buf[1] = '\0';
+    }
+    return true;
+}
+
+static int replay_fd(replay_t *r, int64_t fd)
+{
+    return (fd >= 0 && fd < XF_VFS_FDS_MAX) ? r->fds[fd] : -1;
+}
+
+static replay_dir_t *replay_dir(replay_t *r, int64_t id)
+{
+    for (size_t i = 0; i < XF_VFS_REPLAY_DIRS_MAX; ++i) {
+        if (r->dirs[i].dir != NULL && r->dirs[i].id == (uint64_t)id) {
+            return &r->dirs[i];
+        }
+    }
+    return NULL;
+}
+
+/* 保证读写缓冲区至少有 size 字节，失败时 data 为 NULL、data_size 不为 0 */
+static bool replay_data(replay_t *r, int64_t size)
+{
+    if (size < 0 || (uint64_t)size > SIZE_MAX) {
+        return false;
+    }
+    if ((size_t)size <= r->data_size && r->data != NULL) {
+        return true;
+    }
+    xf_vfs_free(r->data);
+    r->data_size = (size_t)size;
+    r->data = xf_vfs_malloc((size != 0) ? (size_t)size : 1);
+    if (r->data == NULL) {
+        return false;
+    }
+    xf_memset(r->data, REPLAY_FILL_BYTE, r->data_size);
+    return true;
+}
+
+/*
+ * 重放一条记录，返回重放时的返回值（返回指针的函数成功为 0）。
+ * fd 或目录在重放时不存在时置 skipped.
+ */
+static int64_t replay_exec(replay_t *r, xf_vfs_trace_op_t op, int64_t rec_ret, const int64_t *a,
+                           bool *skipped, xf_vfs_replay_stats_t *stats)
+{
+    const char *p1 = r->path[0];
+    int64_t ret = -1;
+    int fd = -1;
+    replay_dir_t *d = NULL;
+
+    if (s_layout[op].paths == 0 && s_layout[op].args != 0) {
+        if (op >= XF_VFS_TRACE_OP_READDIR && op <= XF_VFS_TRACE_OP_CLOSEDIR) {
+            d = replay_dir(r, a[0]);
+            *skipped = (d == NULL);
+        } else {
+            fd = replay_fd(r, a[0]);
+            *skipped = (fd < 0);
+        }
+        if (*skipped) {
+            return -1;
+        }
+    }
+
+    switch (op) {
+    case XF_VFS_TRACE_OP_OPEN:
+        ret = xf_vfs_open(p1, (int)a[0], (int)a[1]);
+        if (ret >= 0 && rec_ret >= 0 && rec_ret < XF_VFS_FDS_MAX) {
+            r->fds[rec_ret] = (int)ret;
+        } else if (ret >= 0) {
+            xf_vfs_close((int)ret);
+        }
+        break;
+    case XF_VFS_TRACE_OP_CLOSE:
+        ret = xf_vfs_close(fd);
+        r->fds[a[0]] = -1;
+        break;
+    case XF_VFS_TRACE_OP_READ:
+    case XF_VFS_TRACE_OP_PREAD:
+        if (!replay_data(r, a[1])) {
+            return -1;
+        }
+        ret = (op == XF_VFS_TRACE_OP_READ) ? xf_vfs_read(fd, r->data, (size_t)a[1])
+              : xf_vfs_pread(fd, r->data, (size_t)a[1], (xf_vfs_off_t)a[2]);
+        stats->bytes_read += (ret > 0) ? (uint64_t)ret : 0;
+        break;
+    case XF_VFS_TRACE_OP_WRITE:
+    case XF_VFS_TRACE_OP_PWRITE:
+        if (!replay_data(r, a[1])) {
+            return -1;
+        }
+        ret = (op == XF_VFS_TRACE_OP_WRITE) ? xf_vfs_write(fd, r->data, (size_t)a[1])
+              : xf_vfs_pwrite(fd, r->data, (size_t)a[1], (xf_vfs_off_t)a[2]);
+        stats->bytes_written += (ret > 0) ? (uint64_t)ret : 0;
+        break;
+    case XF_VFS_TRACE_OP_LSEEK:
+        ret = xf_vfs_lseek(fd, (xf_vfs_off_t)a[1], (int)a[2]);
+        break;
+    case XF_VFS_TRACE_OP_FSTAT: {
+        xf_vfs_stat_t st;
+        ret = xf_vfs_fstat(fd, &st);
+        break;
+    }
+    case XF_VFS_TRACE_OP_FSYNC:
+        ret = xf_vfs_fsync(fd);
+        break;
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    case XF_VFS_TRACE_OP_FTRUNCATE:
+        ret = xf_vfs_ftruncate(fd, (xf_vfs_off_t)a[1]);
+        break;
+    case XF_VFS_TRACE_OP_STAT: {
+        xf_vfs_stat_t st;
+        ret = xf_vfs_stat(p1, &st);
+        break;
+    }
+    case XF_VFS_TRACE_OP_UTIME:
+        ret = xf_vfs_utime(p1, NULL);
+        break;
+    case XF_VFS_TRACE_OP_LINK:
+        ret = xf_vfs_link(p1, r->path[1]);
+        break;
+    case XF_VFS_TRACE_OP_UNLINK:
+        ret = xf_vfs_unlink(p1);
+        break;
+    case XF_VFS_TRACE_OP_RENAME:
+        ret = xf_vfs_rename(p1, r->path[1]);
+        break;
+    case XF_VFS_TRACE_OP_OPENDIR: {
+        xf_vfs_dir_t *dir = xf_vfs_opendir(p1);
+        ret = (dir != NULL) ? 0 : -1;
+        if (dir != NULL) {
+            replay_dir_t *slot = replay_dir(r, rec_ret);
+            for (size_t i = 0; slot == NULL && i < XF_VFS_REPLAY_DIRS_MAX; ++i) {
+                slot = (r->dirs[i].dir == NULL) ? &r->dirs[i] : NULL;
+            }
+            if (rec_ret < 0 || slot == NULL) {
+                /* 记录时失败，或同时打开的目录太多 */
+                xf_vfs_closedir(dir);
+            } else {
+                if (slot->dir != NULL) {
+                    xf_vfs_closedir(slot->dir);
+                }
+                slot->id = (uint32_t)rec_ret;
+                slot->dir = dir;
+            }
+        }
+        break;
+    }
+    case XF_VFS_TRACE_OP_READDIR:
+        ret = (xf_vfs_readdir(d->dir) != NULL) ? 0 : -1;
+        break;
+    case XF_VFS_TRACE_OP_TELLDIR:
+        ret = xf_vfs_telldir(d->dir);
+        break;
+    case XF_VFS_TRACE_OP_SEEKDIR:
+        xf_vfs_seekdir(d->dir, (long)a[1]);
+        ret = 0;
+        break;
+    case XF_VFS_TRACE_OP_CLOSEDIR:
+        ret = xf_vfs_closedir(d->dir);
+        d->dir = NULL;
+        break;
+    case XF_VFS_TRACE_OP_MKDIR:
+        ret = xf_vfs_mkdir(p1, (xf_vfs_mode_t)a[0]);
+        break;
+    case XF_VFS_TRACE_OP_RMDIR:
+        ret = xf_vfs_rmdir(p1);
+        break;
+    case XF_VFS_TRACE_OP_ACCESS:
+        ret = xf_vfs_access(p1, (int)a[0]);
+        break;
+    case XF_VFS_TRACE_OP_TRUNCATE:
+        ret = xf_vfs_truncate(p1, (xf_vfs_off_t)a[0]);
+        break;
+#endif
+    default:
+        /* capture 驱动不会记录的操作 */
+        *skipped = true;
+        break;
+    }
+    return ret;
+}
+
+/* 关闭重放结束时仍打开的文件与目录 */
+static void replay_cleanup(replay_t *r)
+{
+    for (size_t i = 0; i < XF_VFS_FDS_MAX; ++i) {
+        if (r->fds[i] >= 0) {
+            xf_vfs_close(r->fds[i]);
+            r->fds[i] = -1;
+        }
+    }
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    for (size_t i = 0; i < XF_VFS_REPLAY_DIRS_MAX; ++i) {
+        if (r->dirs[i].dir != NULL) {
+            xf_vfs_closedir(r->dirs[i].dir);
+            r->dirs[i].dir = NULL;
+        }
+    }
+#endif
+}
+
+static int cap_open(void *ctx, const char *path, int flags, int mode)
+{
+    cap_t *c = ctx;
+    char buf[XF_VFS_CAPTURE_PATH_MAX];
+    if (cap_join(buf, c->target, path) < 0) {
+        return -1;
+    }
+    /* 本驱动的 local fd 即底层的全局 fd，记录中的 fd 也是它 */
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_OPEN, int, xf_vfs_open(buf, flags, mode), path, NULL, flags, mode);
+}
+
+static int cap_close(void *ctx, int fd)
+{
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_CLOSE, int, xf_vfs_close(fd), NULL, NULL, fd);
+}
+
+static xf_vfs_ssize_t cap_read(void *ctx, int fd, void *dst, size_t size)
+{
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_READ, xf_vfs_ssize_t, xf_vfs_read(fd, dst, size),
+                 NULL, NULL, fd, (int64_t)size);
+}
+
+static xf_vfs_ssize_t cap_write(void *ctx, int fd, const void *data, size_t size)
+{
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_WRITE, xf_vfs_ssize_t, xf_vfs_write(fd, data, size),
+                 NULL, NULL, fd, (int64_t)size);
+}
+
+static xf_vfs_ssize_t cap_pread(void *ctx, int fd, void *dst, size_t size, xf_vfs_off_t offset)
+{
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_PREAD, xf_vfs_ssize_t, xf_vfs_pread(fd, dst, size, offset),
+                 NULL, NULL, fd, (int64_t)size, offset);
+}
+
+static xf_vfs_ssize_t cap_pwrite(void *ctx, int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_PWRITE, xf_vfs_ssize_t, xf_vfs_pwrite(fd, src, size, offset),
+                 NULL, NULL, fd, (int64_t)size, offset);
+}
+
+static xf_vfs_off_t cap_lseek(void *ctx, int fd, xf_vfs_off_t offset, int mode)
+{
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_LSEEK, xf_vfs_off_t, xf_vfs_lseek(fd, offset, mode),
+                 NULL, NULL, fd, offset, mode);
+}
+
+static int cap_fstat(void *ctx, int fd, xf_vfs_stat_t *st)
+{
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_FSTAT, int, xf_vfs_fstat(fd, st), NULL, NULL, fd);
+}
+
+static int cap_fsync(void *ctx, int fd)
+{
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_FSYNC, int, xf_vfs_fsync(fd), NULL, NULL, fd);
+}
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+
+static int cap_stat(void *ctx, const char *path, xf_vfs_stat_t *st)
+{
+    cap_t *c = ctx;
+    char buf[XF_VFS_CAPTURE_PATH_MAX];
+    if (cap_join(buf, c->target, path) < 0) {
+        return -1;
+    }
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_STAT, int, xf_vfs_stat(buf, st), path, NULL, 0);
+}
+
+static int cap_link(void *ctx, const char *n1, const char *n2)
+{
+    cap_t *c = ctx;
+    char buf1[XF_VFS_CAPTURE_PATH_MAX];
+    char buf2[XF_VFS_CAPTURE_PATH_MAX];
+    if (cap_join(buf1, c->target, n1) < 0 || cap_join(buf2, c->target, n2) < 0) {
+        return -1;
+    }
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_LINK, int, xf_vfs_link(buf1, buf2), n1, n2, 0);
+}
+
+static int cap_unlink(void *ctx, const char *path)
+{
+    cap_t *c = ctx;
+    char buf[XF_VFS_CAPTURE_PATH_MAX];
+    if (cap_join(buf, c->target, path) < 0) {
+        return -1;
+    }
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_UNLINK, int, xf_vfs_unlink(buf), path, NULL, 0);
+}
+
+static int cap_rename(void *ctx, const char *src, const char *dst)
+{
+    cap_t *c = ctx;
+    char buf1[XF_VFS_CAPTURE_PATH_MAX];
+    char buf2[XF_VFS_CAPTURE_PATH_MAX];
+    if (cap_join(buf1, c->target, src) < 0 || cap_join(buf2, c->target, dst) < 0) {
+        return -1;
+    }
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_RENAME, int, xf_vfs_rename(buf1, buf2), src, dst, 0);
+}
+
+static xf_vfs_dir_t *cap_opendir(void *ctx, const char *name)
+{
+    cap_t *c = ctx;
+    char buf[XF_VFS_CAPTURE_PATH_MAX];
+    if (cap_join(buf, c->target, name) < 0) {
+        return NULL;
+    }
+    cap_dir_t *dir = xf_vfs_malloc(sizeof(cap_dir_t));
+    if (dir == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    xf_memset(dir, 0, sizeof(cap_dir_t));
+
+    const uint64_t t0 = XF_VFS_CAPTURE_TIME_NS();
+    dir->inner = xf_vfs_opendir(buf);
+    if (dir->inner != NULL) {
+        xf_lock_lock(c->lock);
+        dir->id = c->next_dir++;
+        xf_lock_unlock(c->lock);
+    }
+    cap_record(c, XF_VFS_TRACE_OP_OPENDIR, t0, (dir->inner != NULL) ? (int64_t)dir->id : -1,
+               name, NULL, NULL);
+    if (dir->inner == NULL) {
+        xf_vfs_free(dir);
+        return NULL;
+    }
+    return &dir->base;
+}
+
+static xf_vfs_dirent_t *cap_readdir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    cap_dir_t *dir = (cap_dir_t *)pdir;
+    const uint64_t t0 = XF_VFS_CAPTURE_TIME_NS();
+    xf_vfs_dirent_t *ent = xf_vfs_readdir(dir->inner);
+    cap_record(ctx, XF_VFS_TRACE_OP_READDIR, t0, (ent != NULL) ? 0 : -1, NULL, NULL,
+               (const int64_t[]){ dir->id });
+    return ent;
+}
+
+static long cap_telldir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    cap_dir_t *dir = (cap_dir_t *)pdir;
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_TELLDIR, long, xf_vfs_telldir(dir->inner), NULL, NULL, dir->id);
+}
+
+static void cap_seekdir(void *ctx, xf_vfs_dir_t *pdir, long offset)
+{
+    cap_dir_t *dir = (cap_dir_t *)pdir;
+    const uint64_t t0 = XF_VFS_CAPTURE_TIME_NS();
+    xf_vfs_seekdir(dir->inner, offset);
+    cap_record(ctx, XF_VFS_TRACE_OP_SEEKDIR, t0, 0, NULL, NULL, (const int64_t[]){ dir->id, offset });
+}
+
+static int cap_closedir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    cap_dir_t *dir = (cap_dir_t *)pdir;
+    const uint64_t t0 = XF_VFS_CAPTURE_TIME_NS();
+    int ret = xf_vfs_closedir(dir->inner);
+    cap_record(ctx, XF_VFS_TRACE_OP_CLOSEDIR, t0, ret, NULL, NULL, (const int64_t[]){ dir->id });
+    xf_vfs_free(dir);
+    return ret;
+}
+
+static int cap_mkdir(void *ctx, const char *name, xf_vfs_mode_t mode)
+{
+    cap_t *c = ctx;
+    char buf[XF_VFS_CAPTURE_PATH_MAX];
+    if (cap_join(buf, c->target, name) < 0) {
+        return -1;
+    }
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_MKDIR, int, xf_vfs_mkdir(buf, mode), name, NULL, mode);
+}
+
+static int cap_rmdir(void *ctx, const char *name)
+{
+    cap_t *c = ctx;
+    char buf[XF_VFS_CAPTURE_PATH_MAX];
+    if (cap_join(buf, c->target, name) < 0) {
+        return -1;
+    }
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_RMDIR, int, xf_vfs_rmdir(buf), name, NULL, 0);
+}
+
+static int cap_access(void *ctx, const char *path, int amode)
+{
+    cap_t *c = ctx;
+    char buf[XF_VFS_CAPTURE_PATH_MAX];
+    if (cap_join(buf, c->target, path) < 0) {
+        return -1;
+    }
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_ACCESS, int, xf_vfs_access(buf, amode), path, NULL, amode);
+}
+
+static int cap_truncate(void *ctx, const char *path, xf_vfs_off_t length)
+{
+    cap_t *c = ctx;
+    char buf[XF_VFS_CAPTURE_PATH_MAX];
+    if (cap_join(buf, c->target, path) < 0) {
+        return -1;
+    }
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_TRUNCATE, int, xf_vfs_truncate(buf, length), path, NULL, length);
+}
+
+static int cap_ftruncate(void *ctx, int fd, xf_vfs_off_t length)
+{
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_FTRUNCATE, int, xf_vfs_ftruncate(fd, length), NULL, NULL, fd, length);
+}
+
+static int cap_utime(void *ctx, const char *path, const xf_vfs_utimbuf_t *times)
+{
+    cap_t *c = ctx;
+    char buf[XF_VFS_CAPTURE_PATH_MAX];
+    if (cap_join(buf, c->target, path) < 0) {
+        return -1;
+    }
+    CAPTURE_CALL(ctx, XF_VFS_TRACE_OP_UTIME, int, xf_vfs_utime(buf, times), path, NULL, 0);
+}
+
+#endif /* XF_VFS_SUPPORT_DIR_IS_ENABLE */
@@ -0,0 +1,167 @@
+/**
+ * @file xf_vfs_capture.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs capture（I/O 负载记录）驱动与重放。
+ *        capture 驱动把调用转发到另一个挂载点，同时把调用序列（操作、大小、偏移、时间、
+ *        匿名化的路径）记录为紧凑的二进制数据；xf_vfs_replay() 把记录在任意目录上重放，
+ *        并统计吞吐量与延迟，使真实负载可以在不泄露数据的情况下作为回归基准。
+ * @version 1.0
+ * @date 2025-01-21
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __XF_VFS_CAPTURE_H__
+#define __XF_VFS_CAPTURE_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs.h"
+#include "xf_vfs_trace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @cond (XFAPI_USER || XFAPI_PORT || XFAPI_INTERNAL)
+ * @addtogroup group_xf_vfs
+ * @endcond
+ * @{
+ */
+
+/* ==================== [Defines] =========================================== */
+
+#define XF_VFS_CAPTURE_MAGIC        "XFVC"  /*!< 记录数据开头的 4 字节 */
+#define XF_VFS_CAPTURE_VERSION      (1)     /*!< 记录数据格式的版本 */
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 记录数据的头部。
+ *
+ * 头部之后直到数据结尾为变长记录。无符号整数为 LEB128 变长编码，有符号整数先做 zigzag 变换。
+ * 每条记录依次为：
+ * - 1 字节操作（xf_vfs_trace_op_t）；
+ * - 与上一条记录开始时间之差（ns，有符号），第一条为与开始记录之差；
+ * - 耗时（ns）；
+ * - 返回值（有符号），小于 0 时接着是 errno；
+ * - 操作的参数：fd 为记录时的 fd，目录为记录时按打开顺序编号的目录号；
+ *   路径为分量数加每个分量的编号，相同的名字编号相同，不记录名字本身；
+ *   open 记录 flags 与 mode，读写记录请求的字节数，pread/pwrite/lseek/truncate/seekdir 记录偏移或长度，
+ *   mkdir 记录 mode，access 记录 amode。不记录读写的数据与 utime 的时间。
+ *
+ * 记录按调用完成的顺序排列，并发调用时开始时间之差可能为负。
+ */
+typedef struct {
+    char magic[4];              /*!< XF_VFS_CAPTURE_MAGIC */
+    uint16_t version;           /*!< XF_VFS_CAPTURE_VERSION */
+    uint16_t op_count;          /*!< XF_VFS_TRACE_OP_MAX */
+} xf_vfs_capture_header_t;
+
+/**
+ * @brief capture 驱动的输出函数。
+ *
+ * @return 写入的字节数，小于 size 时之后的记录被丢弃，xf_vfs_capture_stop() 返回 XF_FAIL.
+ */
+typedef xf_vfs_ssize_t (*xf_vfs_capture_write_t)(const void *data, size_t size, void *arg);
+
+/**
+ * @brief xf_vfs_replay() 的输入函数。
+ *
+ * @return 读到的字节数，0 为数据结尾，小于 0 为失败。
+ */
+typedef xf_vfs_ssize_t (*xf_vfs_capture_read_t)(void *dst, size_t size, void *arg);
+
+/**
+ * @brief 一种操作的重放统计。
+ */
+typedef struct {
+    uint32_t count;             /*!< 重放次数 */
+    uint32_t max_ns;            /*!< 最大耗时（ns） */
+    uint64_t total_ns;          /*!< 耗时总和（ns） */
+} xf_vfs_replay_op_stats_t;
+
+/**
+ * @brief 重放统计。
+ */
+typedef struct {
+    uint32_t ops;               /*!< 重放的调用数 */
+    uint32_t mismatches;        /*!< 成败与记录时不一致的调用数 */
+    uint32_t skipped;           /*!< 因 fd 或目录在重放时没有打开成功等原因跳过的记录数 */
+    uint64_t bytes_read;        /*!< 实际读取的字节数 */
+    uint64_t bytes_written;     /*!< 实际写入的字节数 */
+    uint64_t elapsed_ns;        /*!< 重放用时（ns） */
+    uint64_t recorded_ns;       /*!< 记录时第一条到最后一条记录开始的时间（ns） */
+    xf_vfs_replay_op_stats_t op[XF_VFS_TRACE_OP_MAX];
+} xf_vfs_replay_stats_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 注册 capture 文件系统并开始记录：base_path 下的路径转发到 target_path 下的同名路径，
+ * 每次调用完成后向输出追加一条记录。注册时先输出 xf_vfs_capture_header_t.
+ *
+ * @note 输出在持有 capture 驱动内部锁时调用，可以写入其他挂载点上的文件，但不能访问 base_path.
+ *
+ * @param base_path   capture 的挂载点，规则与 xf_vfs_register() 相同。
+ * @param target_path 被记录的目录的完整路径，如 "/data".
+ * @param write       输出函数。
+ * @param arg         传给 write 的参数。
+ *
+ * @return  XF_OK if successful.
+ *          XF_ERR_NO_MEM if out of memory or too many VFSes are registered.
+ *          XF_ERR_INVALID_ARG if given an invalid parameter.
+ *          XF_FAIL if writing the header failed.
+ */
+xf_err_t xf_vfs_capture_start(const char *base_path, const char *target_path,
+                              xf_vfs_capture_write_t write, void *arg);
+
+/**
+ * @brief 输出缓冲区中剩余的记录并注销 capture 文件系统。
+ *
+ * @note 注销前应关闭通过它打开的文件与目录，否则底层挂载点上对应的 fd 不会被关闭。
+ *
+ * @return XF_OK if successful, XF_ERR_INVALID_STATE if no capture mount is at base_path,
+ *         XF_FAIL if any output failed (records were lost).
+ */
+xf_err_t xf_vfs_capture_stop(const char *base_path);
+
+/**
+ * @brief 在 root 下重放记录。路径分量编号为 n 的名字重放为 "n<n>"，写入的数据为固定的填充字节。
+ *
+ * 开启 XF_VFS_LATENCY_ENABLE 时，重放的调用同样计入延迟直方图，可得到各操作的分位数。
+ *
+ * @param root  重放的目录的完整路径，如 "/sd/bench"，通常应为空目录。
+ * @param read  输入函数。
+ * @param arg   传给 read 的参数。
+ * @param timed true: 按记录时的时间间隔发出调用；false: 尽快重放。
+ * @param stats 输出，可以为 NULL.
+ *
+ * @return  XF_OK if successful.
+ *          XF_ERR_INVALID_ARG if given an invalid parameter or the data is malformed.
+ *          XF_ERR_NOT_SUPPORTED if the data has a different version.
+ *          XF_ERR_NO_MEM if out of memory.
+ *          XF_FAIL if read failed.
+ */
+xf_err_t xf_vfs_replay(const char *root, xf_vfs_capture_read_t read, void *arg,
+                       bool timed, xf_vfs_replay_stats_t *stats);
+
+/**
+ * @brief 打印重放统计：用时、吞吐量，以及各操作的次数、平均与最大耗时。
+ */
+void xf_vfs_replay_report(const xf_vfs_replay_stats_t *stats);
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * End of addtogroup group_xf_vfs
+ * @}
+ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __XF_VFS_CAPTURE_H__ */
@@ -42,6 +42,16 @@ extern "C" {
 #   define XF_VFS_SUPPORT_SELECT_IS_ENABLE     (0)
 #endif
 
+/**
+ * 句柄模式（XF_VFS_FLAG_HANDLE）支持。
+ * 关闭后 xf_vfs_fs_ops_t 中没有 handle 子组件，打开文件描述也不保存句柄。
+ */
+#if (!defined(XF_VFS_SUPPORT_HANDLE_ENABLE)) || (XF_VFS_SUPPORT_HANDLE_ENABLE) || defined(__DOXYGEN__)
+#   define XF_VFS_SUPPORT_HANDLE_IS_ENABLE  (1)
+#else
+#   define XF_VFS_SUPPORT_HANDLE_IS_ENABLE  (0)
+#endif
+
 #if !defined(XF_VFS_MAX_COUNT) || defined(__DOXYGEN__)
 #   define XF_VFS_MAX_COUNT                 (8)
 #endif
@@ -66,14 +76,492 @@ extern "C" {
 #   define XF_VFS_CUSTOM_FD_SETSIZE         (64)
 #endif
 
+/**
+ * 编译期挂载表。
+ * 定义为 X 宏列表，每项为 X(name, prefix, ops, flags, ctx)，例如：
+ *
+ *     #define XF_VFS_STATIC_MOUNTS(X) \
+ *         X(rom,  "/rom",      g_rom_ops,  XF_VFS_FLAG_CONTEXT_PTR, &g_rom) \
+ *         X(null, "/dev/null", g_null_ops, XF_VFS_FLAG_DEFAULT,     NULL)
+ *
+ * 挂载点在编译期写入挂载表，启动时不需要注册，也不分配内存。
+ * name 生成 vfs_id 常量 XF_VFS_STATIC_ID_name；prefix 必须是字符串字面量，规则同 xf_vfs_register_fs()；
+ * ops 为 xf_vfs_fs_ops_t 对象，按 XF_VFS_FLAG_STATIC 处理，不复制。
+ * ops 与 ctx 引用的对象需在 XF_VFS_STATIC_MOUNTS_HEADER 指定的头文件中声明。
+ */
+#if defined(XF_VFS_STATIC_MOUNTS) || defined(__DOXYGEN__)
+#   define XF_VFS_STATIC_MOUNTS_IS_ENABLE   (1)
+#else
+#   define XF_VFS_STATIC_MOUNTS_IS_ENABLE   (0)
+#endif
+
+/**
+ * fd 表锁的分片数。
+ * 为 1 时与单锁相同，新 fd 总是取最小的空闲 fd；
+ * 大于 1 时 fd 表按连续区间分片，各线程优先从自己的分片分配 fd，
+ * 不同分片上的 open/close 互不阻塞，但不再保证返回最小的空闲 fd.
+ */
+#if !defined(XF_VFS_FD_LOCK_SHARDS) || defined(__DOXYGEN__)
+#   define XF_VFS_FD_LOCK_SHARDS            (1)
+#endif
+
+/**
+ * 缓存行大小。fd 表锁分片数大于 1 时每个分片的锁独占一个缓存行。
+ */
+#if !defined(XF_VFS_CACHE_LINE_SIZE) || defined(__DOXYGEN__)
+#   define XF_VFS_CACHE_LINE_SIZE           (64)
+#endif
+
+/**
+ * 挂载点路径前缀的最大长度（不含结尾 '\0'）。
+ * 前缀按实际长度与挂载点存放在同一块内存中，增大此值不会增加内存占用。
+ */
 #if !defined(XF_VFS_PATH_MAX) || defined(__DOXYGEN__)
-#   define XF_VFS_PATH_MAX                  (15)
+#   define XF_VFS_PATH_MAX                  (64)
 #endif
 
 #if !defined(XF_VFS_DIRENT_NAME_SIZE) || defined(__DOXYGEN__)
 #   define XF_VFS_DIRENT_NAME_SIZE          (256)
 #endif
 
+/**
+ * 不支持无锁 __atomic 内建函数的平台上，原子操作（文件偏移、打开文件描述引用计数）使用的临界区。
+ * 默认为空，仅适用于单线程使用 xf_vfs 的场合。
+ */
+#if !defined(XF_VFS_ATOMIC_ENTER) || defined(__DOXYGEN__)
+#   define XF_VFS_ATOMIC_ENTER()            do {} while (0)
+#endif
+
+#if !defined(XF_VFS_ATOMIC_EXIT) || defined(__DOXYGEN__)
+#   define XF_VFS_ATOMIC_EXIT()             do {} while (0)
+#endif
+
+/**
+ * xf_vfs_openat() 等函数在驱动不支持相对目录操作时，
+ * 拼接目录路径与相对路径使用的缓冲区大小（含结尾 '\0'）。
+ */
+#if !defined(XF_VFS_AT_PATH_MAX) || defined(__DOXYGEN__)
+#   define XF_VFS_AT_PATH_MAX               (256)
+#endif
+
+/**
+ * 无堆模式。
+ * 开启后 xf_vfs 内部结构（挂载点、驱动函数表副本、目录句柄、路径句柄、select 等待线程）都取自按下列配置
+ * 静态分配的固定内存池，select 的临时数据放在栈上，不再调用 xf_malloc().
+ * xf_vfs_malloc() 默认返回 NULL，需要内存的 overlay 驱动、xf_vfs_walk() 等
+ * 只能在通过 xf_vfs_set_allocator() 提供分配器后使用。
+ */
+#if (defined(XF_VFS_NO_HEAP_ENABLE) && (XF_VFS_NO_HEAP_ENABLE)) || defined(__DOXYGEN__)
+#   define XF_VFS_NO_HEAP_IS_ENABLE         (1)
+#else
+#   define XF_VFS_NO_HEAP_IS_ENABLE         (0)
+#endif
+
+/**
+ * 无堆模式下目录句柄（xf_vfs_dirat_open()）内存池的块数。
+ * 每块可保存 XF_VFS_AT_PATH_MAX 长的路径。
+ */
+#if !defined(XF_VFS_POOL_DIRAT_COUNT) || defined(__DOXYGEN__)
+#   define XF_VFS_POOL_DIRAT_COUNT          (XF_VFS_MAX_COUNT)
+#endif
+
+/**
+ * 无堆模式下路径句柄（xf_vfs_path_prepare()）内存池的块数。
+ * 每块可保存 XF_VFS_AT_PATH_MAX 长的路径。
+ */
+#if !defined(XF_VFS_POOL_PATH_COUNT) || defined(__DOXYGEN__)
+#   define XF_VFS_POOL_PATH_COUNT           (XF_VFS_MAX_COUNT)
+#endif
+
+/**
+ * 无堆模式下 select 等待线程（见 XF_VFS_SELECT_SOCKET_STACK_SIZE）内存池的块数，所有 socket 类 VFS 共用。
+ * 每个 socket 类 VFS 同时参与几个涉及多个 socket 类 VFS 的 select 就需要几块，
+ * 默认为每个挂载点 2 块；VFS 在 select 期间注销时其等待线程在该 select 结束后才归还。
+ */
+#if !defined(XF_VFS_POOL_SELECT_WAITER_COUNT) || defined(__DOXYGEN__)
+#   define XF_VFS_POOL_SELECT_WAITER_COUNT  (XF_VFS_MAX_COUNT * 2)
+#endif
+
+/**
+ * overlay 驱动同时打开的文件数。
+ */
+#if !defined(XF_VFS_OVERLAY_FILES_MAX) || defined(__DOXYGEN__)
+#   define XF_VFS_OVERLAY_FILES_MAX         (8)
+#endif
+
+/**
+ * overlay 驱动拼接底层路径时使用的缓冲区大小（含结尾 '\0'）。
+ */
+#if !defined(XF_VFS_OVERLAY_PATH_MAX) || defined(__DOXYGEN__)
+#   define XF_VFS_OVERLAY_PATH_MAX          (128)
+#endif
+
+/**
+ * overlay 驱动上层索引（上层文件及 whiteout）的哈希桶数量。
+ */
+#if !defined(XF_VFS_OVERLAY_INDEX_BUCKETS) || defined(__DOXYGEN__)
+#   define XF_VFS_OVERLAY_INDEX_BUCKETS     (32)
+#endif
+
+/**
+ * overlay 驱动 copy-up 时使用的拷贝缓冲区大小。
+ */
+#if !defined(XF_VFS_OVERLAY_COPY_BUF_SIZE) || defined(__DOXYGEN__)
+#   define XF_VFS_OVERLAY_COPY_BUF_SIZE     (256)
+#endif
+
+/**
+ * fault 驱动（xf_vfs_fault.h）拼接底层路径时使用的缓冲区大小（含结尾 '\0'）。
+ */
+#if !defined(XF_VFS_FAULT_PATH_MAX) || defined(__DOXYGEN__)
+#   define XF_VFS_FAULT_PATH_MAX            (128)
+#endif
+
+/**
+ * fault 驱动注入延迟的方式，默认忙等或睡眠 us 微秒。
+ * 可改为推进模拟时钟，在不实际等待的情况下得到可复现的耗时。
+ */
+#if !defined(XF_VFS_FAULT_DELAY_US) || defined(__DOXYGEN__)
+#   define XF_VFS_FAULT_DELAY_US(us)        xf_delay_us(us)
+#endif
+
+/**
+ * capture 驱动（xf_vfs_capture.h）与 xf_vfs_replay() 拼接路径使用的缓冲区大小（含结尾 '\0'）。
+ */
+#if !defined(XF_VFS_CAPTURE_PATH_MAX) || defined(__DOXYGEN__)
+#   define XF_VFS_CAPTURE_PATH_MAX          (128)
+#endif
+
+/**
+ * capture 驱动的输出缓冲区大小，写满或停止记录时交给输出函数。
+ * xf_vfs_replay() 读取记录时使用同样大小的缓冲区。
+ */
+#if !defined(XF_VFS_CAPTURE_BUF_SIZE) || defined(__DOXYGEN__)
+#   define XF_VFS_CAPTURE_BUF_SIZE          (256)
+#endif
+
+/**
+ * xf_vfs_replay() 同时打开的目录数。
+ */
+#if !defined(XF_VFS_REPLAY_DIRS_MAX) || defined(__DOXYGEN__)
+#   define XF_VFS_REPLAY_DIRS_MAX           (8)
+#endif
+
+/**
+ * 记录与重放使用的时间（ns）。
+ */
+#if !defined(XF_VFS_CAPTURE_TIME_NS) || defined(__DOXYGEN__)
+#   define XF_VFS_CAPTURE_TIME_NS()         xf_sys_time_get_ns()
+#endif
+
+/**
+ * 按原始时间重放时等待的方式。
+ */
+#if !defined(XF_VFS_REPLAY_DELAY_US) || defined(__DOXYGEN__)
+#   define XF_VFS_REPLAY_DELAY_US(us)       xf_delay_us(us)
+#endif
+
+/**
+ * xf_vfs_bench 作业名的缓冲区大小（含结尾 '\0'）。
+ */
+#if !defined(XF_VFS_BENCH_NAME_MAX) || defined(__DOXYGEN__)
+#   define XF_VFS_BENCH_NAME_MAX            (16)
+#endif
+
+/**
+ * xf_vfs_bench 作业目录的缓冲区大小（含结尾 '\0'），目录后还要拼接文件名。
+ */
+#if !defined(XF_VFS_BENCH_PATH_MAX) || defined(__DOXYGEN__)
+#   define XF_VFS_BENCH_PATH_MAX            (96)
+#endif
+
+/**
+ * xf_vfs_bench 一个作业的最大线程数（numjobs），多于 1 个时需要 xf_osal.
+ */
+#if !defined(XF_VFS_BENCH_THREADS_MAX) || defined(__DOXYGEN__)
+#   define XF_VFS_BENCH_THREADS_MAX         (8)
+#endif
+
+/**
+ * xf_vfs_bench 工作线程的栈大小。
+ */
+#if !defined(XF_VFS_BENCH_STACK_SIZE) || defined(__DOXYGEN__)
+#   define XF_VFS_BENCH_STACK_SIZE          (4096)
+#endif
+
+/**
+ * xf_vfs_bench 计时用的时间（ns）。
+ */
+#if !defined(XF_VFS_BENCH_TIME_NS) || defined(__DOXYGEN__)
+#   define XF_VFS_BENCH_TIME_NS()           xf_sys_time_get_ns()
+#endif
+
+/**
+ * xf_vfs_walk() 拼接路径使用的缓冲区大小（含结尾 '\0'）。
+ */
+#if !defined(XF_VFS_WALK_PATH_MAX) || defined(__DOXYGEN__)
+#   define XF_VFS_WALK_PATH_MAX             (256)
+#endif
+
+/**
+ * xf_vfs_walk() 的最大递归深度，每层同时打开一个目录。
+ * 更深的目录按无法打开（XF_VFS_WALK_DNR）报告。
+ */
+#if !defined(XF_VFS_WALK_DEPTH_MAX) || defined(__DOXYGEN__)
+#   define XF_VFS_WALK_DEPTH_MAX            (16)
+#endif
+
+/**
+ * xf_vfs_walk_parallel() 支持，需要 xf_osal.
+ */
+#if (!defined(XF_VFS_SUPPORT_WALK_PARALLEL_ENABLE)) || (XF_VFS_SUPPORT_WALK_PARALLEL_ENABLE) || defined(__DOXYGEN__)
+#   define XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE   (1)
+#else
+#   define XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE   (0)
+#endif
+
+/**
+ * xf_vfs_walk_parallel() 工作线程的栈大小。
+ */
+#if !defined(XF_VFS_WALK_WORKER_STACK_SIZE) || defined(__DOXYGEN__)
+#   define XF_VFS_WALK_WORKER_STACK_SIZE    (4096)
+#endif
+
+/**
+ * VFS 操作跟踪。
+ * 开启后 xf_vfs.c 的每个入口函数都向环形缓冲区写入一条定长的二进制记录，见 xf_vfs_trace.h.
+ */
+#if (defined(XF_VFS_TRACE_ENABLE) && (XF_VFS_TRACE_ENABLE)) || defined(__DOXYGEN__)
+#   define XF_VFS_TRACE_IS_ENABLE           (1)
+#else
+#   define XF_VFS_TRACE_IS_ENABLE           (0)
+#endif
+
+/**
+ * 每个跟踪环形缓冲区的记录数，须为 2 的幂且不大于 32768.
+ * 每条记录 32 字节，写满后覆盖最早的记录。
+ */
+#if !defined(XF_VFS_TRACE_RING_SIZE) || defined(__DOXYGEN__)
+#   define XF_VFS_TRACE_RING_SIZE           (128)
+#endif
+
+/**
+ * 跟踪环形缓冲区的个数。
+ * 前 XF_VFS_TRACE_RINGS 个写入记录的线程各自独占一个，之后的线程按线程 ID 共用。
+ */
+#if !defined(XF_VFS_TRACE_RINGS) || defined(__DOXYGEN__)
+#   define XF_VFS_TRACE_RINGS               (4)
+#endif
+
+/**
+ * 当前线程的 ID（uintptr_t），用于为线程选择跟踪环形缓冲区。
+ * 没有 xf_osal 时默认为 0，所有线程共用一个环形缓冲区。
+ */
+#if !defined(XF_VFS_TRACE_THREAD_ID) || defined(__DOXYGEN__)
+#   if XF_VFS_SUPPORT_SELECT_IS_ENABLE || XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE
+#       define XF_VFS_TRACE_THREAD_ID()     ((uintptr_t)xf_osal_thread_get_current())
+#   else
+#       define XF_VFS_TRACE_THREAD_ID()     ((uintptr_t)0)
+#   endif
+#endif
+
+/**
+ * 跟踪记录的时间戳（ns）。
+ */
+#if !defined(XF_VFS_TRACE_TIME_NS) || defined(__DOXYGEN__)
+#   define XF_VFS_TRACE_TIME_NS()           xf_sys_time_get_ns()
+#endif
+
+/**
+ * 每个挂载点、每种操作的延迟直方图，见 xf_vfs_latency.h.
+ */
+#if (defined(XF_VFS_LATENCY_ENABLE) && (XF_VFS_LATENCY_ENABLE)) || defined(__DOXYGEN__)
+#   define XF_VFS_LATENCY_IS_ENABLE         (1)
+#else
+#   define XF_VFS_LATENCY_IS_ENABLE         (0)
+#endif
+
+/**
+ * 延迟直方图的个数，即最多能统计的（挂载点, 操作）组合数。
+ * 每个直方图占 2 * (XF_VFS_LATENCY_BUCKETS + 2) * 4 字节，组合首次出现时分配，用完后新组合的样本被丢弃。
+ */
+#if !defined(XF_VFS_LATENCY_SLOTS) || defined(__DOXYGEN__)
+#   define XF_VFS_LATENCY_SLOTS             (8)
+#endif
+
+/**
+ * 延迟直方图每个 2 倍区间内的子桶数的对数（1~6），决定相对误差（2^-XF_VFS_LATENCY_SUB_BITS）。
+ * 默认 3，即相对误差不超过 12.5%，共 192 个桶。
+ */
+#if !defined(XF_VFS_LATENCY_SUB_BITS) || defined(__DOXYGEN__)
+#   define XF_VFS_LATENCY_SUB_BITS          (3)
+#endif
+
+/**
+ * 延迟计时用的时间（ns）。
+ */
+#if !defined(XF_VFS_LATENCY_TIME_NS) || defined(__DOXYGEN__)
+#   define XF_VFS_LATENCY_TIME_NS()         xf_sys_time_get_ns()
+#endif
+
+/**
+ * 按挂载点、按 fd 的 QoS：令牌桶限制带宽与 IOPS，以及优先级类别，见 xf_vfs_qos.h.
+ */
+#if (defined(XF_VFS_QOS_ENABLE) && (XF_VFS_QOS_ENABLE)) || defined(__DOXYGEN__)
+#   define XF_VFS_QOS_IS_ENABLE             (1)
+#else
+#   define XF_VFS_QOS_IS_ENABLE             (0)
+#endif
+
+/**
+ * 可以同时设置单独限速的 fd 数，每个占 40 字节左右。
+ */
+#if !defined(XF_VFS_QOS_FD_SLOTS) || defined(__DOXYGEN__)
+#   define XF_VFS_QOS_FD_SLOTS              (4)
+#endif
+
+/**
+ * 实时类别的最后一次调用结束后，后台类别的调用继续等待的时间（us），
+ * 使实时类别连续的小读写之间不被后台的大块读写插入。
+ */
+#if !defined(XF_VFS_QOS_BG_HOLDOFF_US) || defined(__DOXYGEN__)
+#   define XF_VFS_QOS_BG_HOLDOFF_US         (2000)
+#endif
+
+/**
+ * 后台类别等待实时类别的调用结束时，每次检查之间的间隔（us）。
+ */
+#if !defined(XF_VFS_QOS_POLL_US) || defined(__DOXYGEN__)
+#   define XF_VFS_QOS_POLL_US               (500)
+#endif
+
+/**
+ * 令牌桶用的时间（ns）。
+ */
+#if !defined(XF_VFS_QOS_TIME_NS) || defined(__DOXYGEN__)
+#   define XF_VFS_QOS_TIME_NS()             xf_sys_time_get_ns()
+#endif
+
+/**
+ * 被限速的调用等待 us 微秒，在有 RTOS 时可改为让出 CPU 的延时。
+ */
+#if !defined(XF_VFS_QOS_DELAY_US) || defined(__DOXYGEN__)
+#   define XF_VFS_QOS_DELAY_US(us)          xf_delay_us(us)
+#endif
+
+/**
+ * pwrite 合并调度，见 xf_vfs_merge.h. 需要 xf_osal.
+ */
+#if ((defined(XF_VFS_MERGE_ENABLE) && (XF_VFS_MERGE_ENABLE)) \
+        && (XF_VFS_SUPPORT_SELECT_IS_ENABLE || XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE)) || defined(__DOXYGEN__)
+#   define XF_VFS_MERGE_IS_ENABLE           (1)
+#else
+#   define XF_VFS_MERGE_IS_ENABLE           (0)
+#endif
+
+/**
+ * 每个挂载点一次最多合并的请求数（1~32），每个占一个信号量。
+ * 排队的请求达到此数时立即下发，不再等待截止时间。
+ */
+#if !defined(XF_VFS_MERGE_BATCH_MAX) || defined(__DOXYGEN__)
+#   define XF_VFS_MERGE_BATCH_MAX           (8)
+#endif
+
+/**
+ * xf_vfs_merge_config_t::deadline_us 为 0 时的默认值（us）。
+ */
+#if !defined(XF_VFS_MERGE_DEADLINE_US) || defined(__DOXYGEN__)
+#   define XF_VFS_MERGE_DEADLINE_US         (2000)
+#endif
+
+/**
+ * xf_vfs_merge_config_t::max_bytes 为 0 时的默认值（字节）。
+ */
+#if !defined(XF_VFS_MERGE_MAX_BYTES) || defined(__DOXYGEN__)
+#   define XF_VFS_MERGE_MAX_BYTES           (4096)
+#endif
+
+/**
+ * 统计排队时间用的时间（ns）。
+ */
+#if !defined(XF_VFS_MERGE_TIME_NS) || defined(__DOXYGEN__)
+#   define XF_VFS_MERGE_TIME_NS()           xf_sys_time_get_ns()
+#endif
+
+/**
+ * 挂载点的串行化标志 XF_VFS_FLAG_SERIAL_FILE 与 XF_VFS_FLAG_SERIAL_MOUNT 支持。
+ * 关闭后使用这两个标志注册会失败。
+ */
+#if (!defined(XF_VFS_SUPPORT_SERIAL_ENABLE)) || (XF_VFS_SUPPORT_SERIAL_ENABLE) || defined(__DOXYGEN__)
+#   define XF_VFS_SUPPORT_SERIAL_IS_ENABLE  (1)
+#else
+#   define XF_VFS_SUPPORT_SERIAL_IS_ENABLE  (0)
+#endif
+
+/**
+ * XF_VFS_FLAG_SERIAL_FILE 挂载点上文件锁的个数（1~256），文件按 local fd 或句柄散列到其中之一。
+ * 同时访问的文件较多时可增大以减少无关文件共用一把锁。
+ */
+#if !defined(XF_VFS_SERIAL_FILE_LOCKS) || defined(__DOXYGEN__)
+#   define XF_VFS_SERIAL_FILE_LOCKS         (8)
+#endif
+
+/**
+ * XF_VFS_FLAG_VFS_OFFSET 挂载点上 O_APPEND 写入锁的个数（1~256），文件按挂载点与打开时的路径散列到其中之一。
+ * 同时追加写的文件较多时可增大以减少无关文件共用一把锁。
+ */
+#if !defined(XF_VFS_APPEND_LOCKS) || defined(__DOXYGEN__)
+#   define XF_VFS_APPEND_LOCKS              (8)
+#endif
+
+/**
+ * 挂载点的执行线程标志 XF_VFS_FLAG_EXECUTOR 支持，需要 xf_osal.
+ */
+#if (((!defined(XF_VFS_SUPPORT_EXECUTOR_ENABLE)) || (XF_VFS_SUPPORT_EXECUTOR_ENABLE)) \
+        && (XF_VFS_SUPPORT_SELECT_IS_ENABLE || XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE)) || defined(__DOXYGEN__)
+#   define XF_VFS_SUPPORT_EXECUTOR_IS_ENABLE    (1)
+#else
+#   define XF_VFS_SUPPORT_EXECUTOR_IS_ENABLE    (0)
+#endif
+
+/**
+ * 每个执行线程同时排队的调用数（1~32），每个占一个完成信号量。已满时调用者等待空位。
+ */
+#if !defined(XF_VFS_EXECUTOR_QUEUE_LEN) || defined(__DOXYGEN__)
+#   define XF_VFS_EXECUTOR_QUEUE_LEN        (8)
+#endif
+
+/**
+ * 执行线程的栈大小，需要容纳驱动调用的栈。
+ */
+#if !defined(XF_VFS_EXECUTOR_STACK_SIZE) || defined(__DOXYGEN__)
+#   define XF_VFS_EXECUTOR_STACK_SIZE       (4096)
+#endif
+
+/**
+ * 执行线程的优先级。
+ */
+#if !defined(XF_VFS_EXECUTOR_PRIORITY) || defined(__DOXYGEN__)
+#   define XF_VFS_EXECUTOR_PRIORITY         XF_OSAL_PRIORITY_NORMAL
+#endif
+
+/**
+ * 一次 select 涉及多个 socket 类 VFS 时，每个 socket_select 在该 VFS 的常驻等待线程中运行，
+ * 此为该线程的栈大小，需要容纳 socket_select 的栈。
+ * 等待线程在第一次需要时创建，之后复用，VFS 注销时结束；每个参与过这种 select 的 socket 类 VFS
+ * 至少常驻一个线程，同时进行的这种 select 有几个，该 VFS 就有几个线程，各占一份此大小的栈。
+ */
+#if !defined(XF_VFS_SELECT_SOCKET_STACK_SIZE) || defined(__DOXYGEN__)
+#   define XF_VFS_SELECT_SOCKET_STACK_SIZE  (4096)
+#endif
+
+/**
+ * 运行 socket_select 的等待线程的优先级。
+ */
+#if !defined(XF_VFS_SELECT_SOCKET_PRIORITY) || defined(__DOXYGEN__)
+#   define XF_VFS_SELECT_SOCKET_PRIORITY    XF_OSAL_PRIORITY_NORMAL
+#endif
+
 /* ==================== [Typedefs] ========================================== */
 
 /* ==================== [Global Prototypes] ================================= */
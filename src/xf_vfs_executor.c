@@ -0,0 +1,494 @@
+/**
+ * @file xf_vfs_executor.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs 挂载点执行线程（XF_VFS_FLAG_EXECUTOR）。
+ *        挂载点的驱动方法被替换为代理：代理把参数的地址与调用函数放入队列，
+ *        由挂载点的执行线程调用驱动，调用者等待完成。
+ * @version 1.0
+ * @date 2025-01-26
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs.h"
+#include "xf_vfs_private.h"
+
+#if XF_VFS_SUPPORT_EXECUTOR_IS_ENABLE
+
+#include "xf_osal.h"
+
+/* ==================== [Defines] =========================================== */
+
+#if !defined(STATIC_ASSERT)
+#   define STATIC_ASSERT(EXPR, ...)     extern char (*_do_assert(void)) [sizeof(char[1 - 2*!(EXPR)])]
+#endif
+
+/* 占用的完成信号量以位掩码记录 */
+STATIC_ASSERT(XF_VFS_EXECUTOR_QUEUE_LEN >= 1 && XF_VFS_EXECUTOR_QUEUE_LEN <= 32, "invalid XF_VFS_EXECUTOR_QUEUE_LEN");
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct _exec_t exec_t;
+typedef struct _exec_req_t exec_req_t;
+
+/* 在执行线程中调用驱动方法，参数与返回值通过 req 中的指针传递 */
+typedef void (*exec_call_t)(const exec_t *x, exec_req_t *req);
+
+/* 一次调用，位于调用者的栈上 */
+struct _exec_req_t {
+    exec_req_t *next;
+    exec_call_t call;           /*!< NULL 为停止执行线程 */
+    void **args;                /*!< 代理函数各参数的地址 */
+    void *ret;                  /*!< 返回值的地址 */
+    int err;                    /*!< 调用前后的 errno */
+    uint8_t slot;               /*!< 等待用的完成信号量 */
+};
+
+struct _exec_t {
+    xf_vfs_fs_ops_t ops;        /*!< 代理，注册到挂载点 */
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    xf_vfs_dir_ops_t dir;
+#endif
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    xf_vfs_handle_ops_t handle;
+#endif
+    const xf_vfs_fs_ops_t *target;  /*!< 驱动 */
+    int flags;                  /*!< 注册时的标志 */
+    void *ctx;                  /*!< 注册时的上下文 */
+    xf_osal_thread_t thread;
+    xf_lock_t lock;             /*!< 保护队列与 slots_used */
+    exec_req_t *head;
+    exec_req_t **tail;
+    uint32_t slots_used;
+    xf_osal_semaphore_t items;  /*!< 队列中的调用数 */
+    xf_osal_semaphore_t space;  /*!< 空闲的完成信号量数 */
+    xf_osal_semaphore_t done[XF_VFS_EXECUTOR_QUEUE_LEN];
+};
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void exec_run(void *ctx, exec_call_t call, void **args, void *ret);
+static void exec_submit(exec_t *x, exec_req_t *req);
+static void exec_thread(void *argument);
+static void exec_free(exec_t *x);
+static void exec_build_ops(exec_t *x);
+
+/* ==================== [Static Variables] ================================== */
+
+/* ==================== [Macros] ============================================ */
+
+/* 驱动方法所在的组件 */
+#define EXEC_COMP_fs(x)             ((x)->target)
+#define EXEC_COMP_dir(x)            ((x)->target->dir)
+#define EXEC_COMP_handle(x)         ((x)->target->handle)
+
+/* 按注册时的标志调用驱动方法，handle 组件总是传入上下文 */
+#define EXEC_INVOKE_fs(x, name, ...) \
+    (((x)->flags & XF_VFS_FLAG_CONTEXT_PTR) ? (x)->target->name##_p((x)->ctx, __VA_ARGS__) \
+                                            : (x)->target->name(__VA_ARGS__))
+#define EXEC_INVOKE_dir(x, name, ...) \
+    (((x)->flags & XF_VFS_FLAG_CONTEXT_PTR) ? (x)->target->dir->name##_p((x)->ctx, __VA_ARGS__) \
+                                            : (x)->target->dir->name(__VA_ARGS__))
+#define EXEC_INVOKE_handle(x, name, ...) \
+    (x)->target->handle->name((x)->ctx, __VA_ARGS__)
+
+#define EXEC_ARG(req, i, T)         (*(T *)(req)->args[i])
+
+/*
+ * 定义组件 comp 的方法 name 的代理 exec_<comp>_<name>() 与执行线程中的调用 exec_call_<comp>_<name>()，
+ * 方法有 n 个参数（不含上下文）。
+ */
+#define EXEC_OP_1(comp, name, ret_t, T1) \
+    static void exec_call_##comp##_##name(const exec_t *x, exec_req_t *req) \
+    { \
+        *(ret_t *)req->ret = EXEC_INVOKE_##comp(x, name, EXEC_ARG(req, 0, T1)); \
+    } \
+    static ret_t exec_##comp##_##name(void *ctx, T1 a1) \
+    { \
+        ret_t ret; \
+        void *args[] = { &a1 }; \
+        exec_run(ctx, exec_call_##comp##_##name, args, &ret); \
+        return ret; \
+    }
+
+#define EXEC_OP_2(comp, name, ret_t, T1, T2) \
+    static void exec_call_##comp##_##name(const exec_t *x, exec_req_t *req) \
+    { \
+        *(ret_t *)req->ret = EXEC_INVOKE_##comp(x, name, EXEC_ARG(req, 0, T1), EXEC_ARG(req, 1, T2)); \
+    } \
+    static ret_t exec_##comp##_##name(void *ctx, T1 a1, T2 a2) \
+    { \
+        ret_t ret; \
+        void *args[] = { &a1, &a2 }; \
+        exec_run(ctx, exec_call_##comp##_##name, args, &ret); \
+        return ret; \
+    }
+
+#define EXEC_OP_3(comp, name, ret_t, T1, T2, T3) \
+    static void exec_call_##comp##_##name(const exec_t *x, exec_req_t *req) \
+    { \
+        *(ret_t *)req->ret = EXEC_INVOKE_##comp(x, name, EXEC_ARG(req, 0, T1), EXEC_ARG(req, 1, T2), \
+                                                EXEC_ARG(req, 2, T3)); \
+    } \
+    static ret_t exec_##comp##_##name(void *ctx, T1 a1, T2 a2, T3 a3) \
+    { \
+        ret_t ret; \
+        void *args[] = { &a1, &a2, &a3 }; \
+        exec_run(ctx, exec_call_##comp##_##name, args, &ret); \
+        return ret; \
+    }
+
+#define EXEC_OP_4(comp, name, ret_t, T1, T2, T3, T4) \
+    static void exec_call_##comp##_##name(const exec_t *x, exec_req_t *req) \
+    { \
+        *(ret_t *)req->ret = EXEC_INVOKE_##comp(x, name, EXEC_ARG(req, 0, T1), EXEC_ARG(req, 1, T2), \
+                                                EXEC_ARG(req, 2, T3), EXEC_ARG(req, 3, T4)); \
+    } \
+    static ret_t exec_##comp##_##name(void *ctx, T1 a1, T2 a2, T3 a3, T4 a4) \
+    { \
+        ret_t ret; \
+        void *args[] = { &a1, &a2, &a3, &a4 }; \
+        exec_run(ctx, exec_call_##comp##_##name, args, &ret); \
+        return ret; \
+    }
+
+/* 驱动实现了方法时使用代理，否则保持 NULL，VFS 的回退逻辑不变 */
+#define EXEC_PROXY(x, comp, name)   ((EXEC_COMP_##comp(x)->name != NULL) ? exec_##comp##_##name : NULL)
+
+/*
+ * ioctl 的 va_list 复制一份后传地址：va_list 可能是数组类型，不能直接对参数取地址。
+ * 调用者在等待期间栈帧保持有效，执行线程可以读取其中的可变参数。
+ */
+#define EXEC_OP_IOCTL(comp, ctx_arg_t) \
+    static void exec_call_##comp##_ioctl(const exec_t *x, exec_req_t *req) \
+    { \
+        *(int *)req->ret = EXEC_INVOKE_##comp(x, ioctl, EXEC_ARG(req, 0, ctx_arg_t), EXEC_ARG(req, 1, int), \
+                                              *(va_list *)req->args[2]); \
+    } \
+    static int exec_##comp##_ioctl(void *ctx, ctx_arg_t a1, int a2, va_list a3) \
+    { \
+        int ret; \
+        va_list ap; \
+        va_copy(ap, a3); \
+        void *args[] = { &a1, &a2, &ap }; \
+        exec_run(ctx, exec_call_##comp##_ioctl, args, &ret); \
+        va_end(ap); \
+        return ret; \
+    }
+
+/* *INDENT-OFF* */
+EXEC_OP_3(fs, write,       xf_vfs_ssize_t, int, const void *, size_t)
+EXEC_OP_3(fs, lseek,       xf_vfs_off_t,   int, xf_vfs_off_t, int)
+EXEC_OP_3(fs, read,        xf_vfs_ssize_t, int, void *, size_t)
+EXEC_OP_4(fs, pread,       xf_vfs_ssize_t, int, void *, size_t, xf_vfs_off_t)
+EXEC_OP_4(fs, pwrite,      xf_vfs_ssize_t, int, const void *, size_t, xf_vfs_off_t)
+EXEC_OP_3(fs, open,        int,            const char *, int, int)
+EXEC_OP_1(fs, close,       int,            int)
+EXEC_OP_2(fs, fstat,       int,            int, xf_vfs_stat_t *)
+EXEC_OP_3(fs, fcntl,       int,            int, int, int)
+EXEC_OP_IOCTL(fs, int)
+EXEC_OP_1(fs, fsync,       int,            int)
+EXEC_OP_3(fs, lseek64,     xf_vfs_off64_t, int, xf_vfs_off64_t, int)
+EXEC_OP_4(fs, pread64,     xf_vfs_ssize_t, int, void *, size_t, xf_vfs_off64_t)
+EXEC_OP_4(fs, pwrite64,    xf_vfs_ssize_t, int, const void *, size_t, xf_vfs_off64_t)
+EXEC_OP_2(fs, fstat64,     int,            int, xf_vfs_stat64_t *)
+EXEC_OP_3(fs, fstatx,      int,            int, uint32_t, xf_vfs_statx_t *)
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+EXEC_OP_2(dir, stat,       int,                const char *, xf_vfs_stat_t *)
+EXEC_OP_2(dir, link,       int,                const char *, const char *)
+EXEC_OP_1(dir, unlink,     int,                const char *)
+EXEC_OP_2(dir, rename,     int,                const char *, const char *)
+EXEC_OP_1(dir, opendir,    xf_vfs_dir_t *,     const char *)
+EXEC_OP_1(dir, readdir,    xf_vfs_dirent_t *,  xf_vfs_dir_t *)
+EXEC_OP_3(dir, readdir_r,  int,                xf_vfs_dir_t *, xf_vfs_dirent_t *, xf_vfs_dirent_t **)
+EXEC_OP_1(dir, telldir,    long,               xf_vfs_dir_t *)
+EXEC_OP_1(dir, closedir,   int,                xf_vfs_dir_t *)
+EXEC_OP_2(dir, mkdir,      int,                const char *, xf_vfs_mode_t)
+EXEC_OP_1(dir, rmdir,      int,                const char *)
+EXEC_OP_2(dir, access,     int,                const char *, int)
+EXEC_OP_2(dir, truncate,   int,                const char *, xf_vfs_off_t)
+EXEC_OP_2(dir, ftruncate,  int,                int, xf_vfs_off_t)
+EXEC_OP_2(dir, utime,      int,                const char *, const xf_vfs_utimbuf_t *)
+EXEC_OP_2(dir, truncate64, int,                const char *, xf_vfs_off64_t)
+EXEC_OP_2(dir, ftruncate64, int,               int, xf_vfs_off64_t)
+EXEC_OP_3(dir, getdents,   xf_vfs_ssize_t,     xf_vfs_dir_t *, void *, size_t)
+EXEC_OP_3(dir, statx,      int,                const char *, uint32_t, xf_vfs_statx_t *)
+EXEC_OP_4(dir, openat,     int,                xf_vfs_dir_t *, const char *, int, int)
+EXEC_OP_3(dir, fstatat,    int,                xf_vfs_dir_t *, const char *, xf_vfs_stat_t *)
+EXEC_OP_3(dir, unlinkat,   int,                xf_vfs_dir_t *, const char *, int)
+EXEC_OP_3(dir, mkdirat,    int,                xf_vfs_dir_t *, const char *, xf_vfs_mode_t)
+
+/* seekdir 没有返回值 */
+static void exec_call_dir_seekdir(const exec_t *x, exec_req_t *req)
+{
+    EXEC_INVOKE_dir(x, seekdir, EXEC_ARG(req, 0, xf_vfs_dir_t *), EXEC_ARG(req, 1, long));
+}
+
+static void exec_dir_seekdir(void *ctx, xf_vfs_dir_t *a1, long a2)
+{
+    void *args[] = { &a1, &a2 };
+    exec_run(ctx, exec_call_dir_seekdir, args, NULL);
+}
+#endif
+
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+EXEC_OP_3(handle, open,      void *,         const char *, int, int)
+EXEC_OP_1(handle, close,     int,            void *)
+EXEC_OP_3(handle, write,     xf_vfs_ssize_t, void *, const void *, size_t)
+EXEC_OP_3(handle, lseek,     xf_vfs_off_t,   void *, xf_vfs_off_t, int)
+EXEC_OP_3(handle, read,      xf_vfs_ssize_t, void *, void *, size_t)
+EXEC_OP_4(handle, pread,     xf_vfs_ssize_t, void *, void *, size_t, xf_vfs_off_t)
+EXEC_OP_4(handle, pwrite,    xf_vfs_ssize_t, void *, const void *, size_t, xf_vfs_off_t)
+EXEC_OP_2(handle, fstat,     int,            void *, xf_vfs_stat_t *)
+EXEC_OP_3(handle, fcntl,     int,            void *, int, int)
+EXEC_OP_IOCTL(handle, void *)
+EXEC_OP_1(handle, fsync,     int,            void *)
+EXEC_OP_2(handle, ftruncate, int,            void *, xf_vfs_off_t)
+EXEC_OP_3(handle, lseek64,   xf_vfs_off64_t, void *, xf_vfs_off64_t, int)
+EXEC_OP_4(handle, pread64,   xf_vfs_ssize_t, void *, void *, size_t, xf_vfs_off64_t)
+EXEC_OP_4(handle, pwrite64,  xf_vfs_ssize_t, void *, const void *, size_t, xf_vfs_off64_t)
+EXEC_OP_2(handle, fstat64,   int,            void *, xf_vfs_stat64_t *)
+EXEC_OP_2(handle, ftruncate64, int,          void *, xf_vfs_off64_t)
+#endif
+/* *INDENT-ON* */
+
+/* ==================== [Global Functions] ================================== */
+
+void *xf_vfs_executor_create(const xf_vfs_fs_ops_t *ops, int flags, void *ctx)
+{
+    exec_t *x = xf_vfs_malloc(sizeof(exec_t));
+    if (x == NULL) {
+        return NULL;
+    }
+    xf_memset(x, 0, sizeof(exec_t));
+    x->target = ops;
+    x->flags = flags;
+    x->ctx = ctx;
+    x->tail = &x->head;
+    exec_build_ops(x);
+
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "executor",
+    };
+    x->items = xf_osal_semaphore_create(UINT16_MAX, 0, &sem_attr);
+    x->space = xf_osal_semaphore_create(XF_VFS_EXECUTOR_QUEUE_LEN, XF_VFS_EXECUTOR_QUEUE_LEN, &sem_attr);
+    bool ok = (x->items != NULL) && (x->space != NULL) && (xf_lock_init(&x->lock) == XF_OK);
+    for (int i = 0; ok && i < XF_VFS_EXECUTOR_QUEUE_LEN; ++i) {
+        x->done[i] = xf_osal_semaphore_create(1, 0, &sem_attr);
+        ok = (x->done[i] != NULL);
+    }
+    if (ok) {
+        const xf_osal_thread_attr_t thread_attr = {
+            .name = "executor",
+            .stack_size = XF_VFS_EXECUTOR_STACK_SIZE,
+            .priority = XF_VFS_EXECUTOR_PRIORITY,
+        };
+        x->thread = xf_osal_thread_create(exec_thread, x, &thread_attr);
+        ok = (x->thread != NULL);
+    }
+    if (!ok) {
+        exec_free(x);
+        return NULL;
+    }
+    return x;
+}
+
+const xf_vfs_fs_ops_t *xf_vfs_executor_ops(void *executor)
+{
+    return &((exec_t *)executor)->ops;
+}
+
+const xf_vfs_fs_ops_t *xf_vfs_executor_destroy(void *executor)
+{
+    exec_t *x = executor;
+    const xf_vfs_fs_ops_t *target = x->target;
+    /* 停止请求排在已有的调用之后，完成后执行线程不再访问 x */
+    exec_req_t req = {
+        .call = NULL,
+    };
+    exec_submit(x, &req);
+    exec_free(x);
+    return target;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static void exec_run(void *ctx, exec_call_t call, void **args, void *ret)
+{
+    exec_t *x = ctx;
+    exec_req_t req = {
+        .call = call,
+        .args = args,
+        .ret = ret,
+    };
+    /* 驱动在执行线程中再调用本挂载点时直接执行，否则会等待自己 */
+    if (xf_osal_thread_get_current() == x->thread) {
+        call(x, &req);
+        return;
+    }
+    req.err = errno;
+    exec_submit(x, &req);
+    errno = req.err;
+}
+
+static void exec_submit(exec_t *x, exec_req_t *req)
+{
+    xf_osal_semaphore_acquire(x->space, XF_OSAL_WAIT_FOREVER);
+    xf_lock_lock(x->lock);
+    uint8_t slot = 0;
+    while (x->slots_used & (1u << slot)) {
+        ++slot;
+    }
+    x->slots_used |= 1u << slot;
+    req->slot = slot;
+    req->next = NULL;
+    *x->tail = req;
+    x->tail = &req->next;
+    xf_lock_unlock(x->lock);
+    xf_osal_semaphore_release(x->items);
+
+    xf_osal_semaphore_acquire(x->done[slot], XF_OSAL_WAIT_FOREVER);
+
+    xf_lock_lock(x->lock);
+    x->slots_used &= ~(1u << slot);
+    xf_lock_unlock(x->lock);
+    xf_osal_semaphore_release(x->space);
+}
+
+static void exec_thread(void *argument)
+{
+    exec_t *x = argument;
+    bool stop = false;
+    while (!stop) {
+        xf_osal_semaphore_acquire(x->items, XF_OSAL_WAIT_FOREVER);
+        xf_lock_lock(x->lock);
+        exec_req_t *req = x->head;
+        x->head = req->next;
+        if (x->head == NULL) {
+            x->tail = &x->head;
+        }
+        xf_lock_unlock(x->lock);
+
+        stop = (req->call == NULL);
+        if (!stop) {
+            errno = req->err;
+            req->call(x, req);
+            req->err = errno;
+        }
+        xf_osal_semaphore_release(x->done[req->slot]);
+    }
+    xf_osal_thread_delete(NULL);
+}
+
+static void exec_free(exec_t *x)
+{
+    for (int i = 0; i < XF_VFS_EXECUTOR_QUEUE_LEN; ++i) {
+        if (x->done[i] != NULL) {
+            xf_osal_semaphore_delete(x->done[i]);
+        }
+    }
+    if (x->items != NULL) {
+        xf_osal_semaphore_delete(x->items);
+    }
+    if (x->space != NULL) {
+        xf_osal_semaphore_delete(x->space);
+    }
+    if (x->lock != NULL) {
+        xf_lock_destroy(x->lock);
+    }
+    xf_vfs_free(x);
+}
+
+static void exec_build_ops(exec_t *x)
+{
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    if (x->target->dir != NULL) {
+        const xf_vfs_dir_ops_t dir = {
+            .stat_p = EXEC_PROXY(x, dir, stat),
+            .link_p = EXEC_PROXY(x, dir, link),
+            .unlink_p = EXEC_PROXY(x, dir, unlink),
+            .rename_p = EXEC_PROXY(x, dir, rename),
+            .opendir_p = EXEC_PROXY(x, dir, opendir),
+            .readdir_p = EXEC_PROXY(x, dir, readdir),
+            .readdir_r_p = EXEC_PROXY(x, dir, readdir_r),
+            .telldir_p = EXEC_PROXY(x, dir, telldir),
+            .seekdir_p = EXEC_PROXY(x, dir, seekdir),
+            .closedir_p = EXEC_PROXY(x, dir, closedir),
+            .mkdir_p = EXEC_PROXY(x, dir, mkdir),
+            .rmdir_p = EXEC_PROXY(x, dir, rmdir),
+            .access_p = EXEC_PROXY(x, dir, access),
+            .truncate_p = EXEC_PROXY(x, dir, truncate),
+            .ftruncate_p = EXEC_PROXY(x, dir, ftruncate),
+            .utime_p = EXEC_PROXY(x, dir, utime),
+            .truncate64_p = EXEC_PROXY(x, dir, truncate64),
+            .ftruncate64_p = EXEC_PROXY(x, dir, ftruncate64),
+            .getdents_p = EXEC_PROXY(x, dir, getdents),
+            .statx_p = EXEC_PROXY(x, dir, statx),
+            .openat_p = EXEC_PROXY(x, dir, openat),
+            .fstatat_p = EXEC_PROXY(x, dir, fstatat),
+            .unlinkat_p = EXEC_PROXY(x, dir, unlinkat),
+            .mkdirat_p = EXEC_PROXY(x, dir, mkdirat),
+        };
+        xf_memcpy(&x->dir, &dir, sizeof(dir));
+    }
+#endif
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+    if (x->target->handle != NULL) {
+        const xf_vfs_handle_ops_t handle = {
+            .open = EXEC_PROXY(x, handle, open),
+            .close = EXEC_PROXY(x, handle, close),
+            .write = EXEC_PROXY(x, handle, write),
+            .lseek = EXEC_PROXY(x, handle, lseek),
+            .read = EXEC_PROXY(x, handle, read),
+            .pread = EXEC_PROXY(x, handle, pread),
+            .pwrite = EXEC_PROXY(x, handle, pwrite),
+            .fstat = EXEC_PROXY(x, handle, fstat),
+            .fcntl = EXEC_PROXY(x, handle, fcntl),
+            .ioctl = EXEC_PROXY(x, handle, ioctl),
+            .fsync = EXEC_PROXY(x, handle, fsync),
+            .ftruncate = EXEC_PROXY(x, handle, ftruncate),
+            .lseek64 = EXEC_PROXY(x, handle, lseek64),
+            .pread64 = EXEC_PROXY(x, handle, pread64),
+            .pwrite64 = EXEC_PROXY(x, handle, pwrite64),
+            .fstat64 = EXEC_PROXY(x, handle, fstat64),
+            .ftruncate64 = EXEC_PROXY(x, handle, ftruncate64),
+        };
+        xf_memcpy(&x->handle, &handle, sizeof(handle));
+    }
+#endif
+    const xf_vfs_fs_ops_t ops = {
+        .write_p = EXEC_PROXY(x, fs, write),
+        .lseek_p = EXEC_PROXY(x, fs, lseek),
+        .read_p = EXEC_PROXY(x, fs, read),
+        .pread_p = EXEC_PROXY(x, fs, pread),
+        .pwrite_p = EXEC_PROXY(x, fs, pwrite),
+        .open_p = EXEC_PROXY(x, fs, open),
+        .close_p = EXEC_PROXY(x, fs, close),
+        .fstat_p = EXEC_PROXY(x, fs, fstat),
+        .fcntl_p = EXEC_PROXY(x, fs, fcntl),
+        .ioctl_p = EXEC_PROXY(x, fs, ioctl),
+        .fsync_p = EXEC_PROXY(x, fs, fsync),
+        .lseek64_p = EXEC_PROXY(x, fs, lseek64),
+        .pread64_p = EXEC_PROXY(x, fs, pread64),
+        .pwrite64_p = EXEC_PROXY(x, fs, pwrite64),
+        .fstat64_p = EXEC_PROXY(x, fs, fstat64),
+        .fstatx_p = EXEC_PROXY(x, fs, fstatx),
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+        .dir = (x->target->dir != NULL) ? &x->dir : NULL,
+#endif
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE
+        /* select 的回调不经过执行线程 */
+        .select = x->target->select,
+#endif
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE
+        .handle = (x->target->handle != NULL) ? &x->handle : NULL,
+#endif
+    };
+    xf_memcpy(&x->ops, &ops, sizeof(ops));
+}
+
+#endif /* XF_VFS_SUPPORT_EXECUTOR_IS_ENABLE */
@@ -0,0 +1,892 @@
+/**
+ * @file xf_vfs_fault.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs fault（故障注入）驱动。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs_fault.h"
+#include "xf_vfs_mem.h"
+
+/* ==================== [Defines] =========================================== */
+
+#if !defined(STATIC_ASSERT)
+#   define STATIC_ASSERT(EXPR, ...)     extern char (*_do_assert(void)) [sizeof(char[1 - 2*!(EXPR)])]
+#endif
+
+/* 脚本中一项修改了规则的哪些部分 */
+#define PATCH_DIST              (1u << 0)
+#define PATCH_BW                (1u << 1)
+#define PATCH_STALL             (1u << 2)
+#define PATCH_ERROR             (1u << 3)
+#define PATCH_CLEAR             (1u << 4)
+
+/* 规则按操作的位掩码批量设置 */
+STATIC_ASSERT(XF_VFS_TRACE_OP_MAX < 32, "too many ops for the op mask");
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct {
+    xf_vfs_fault_rule_t rule;
+    uint32_t calls;             /*!< 设置规则以来的调用数，用于 stall_every / error_every */
+} fault_op_t;
+
+typedef struct {
+    xf_vfs_dir_t base;          /*!< 必须位于首位 */
+    xf_vfs_dir_t *inner;
+} fault_dir_t;
+
+typedef struct _fault_t {
+    struct _fault_t *next;
+    char *base_path;
+    char *target;
+    xf_lock_t lock;
+    uint32_t rng;               /*!< xorshift32 状态 */
+    xf_vfs_fault_stats_t stats;
+    fault_op_t ops[XF_VFS_TRACE_OP_MAX];
+} fault_t;
+
+/* xf_vfs_fault_configure() 解析出的一条规则 */
+typedef struct {
+    uint32_t ops;               /*!< 操作的位掩码 */
+    uint32_t fields;            /*!< PATCH_* */
+    xf_vfs_fault_rule_t rule;
+} fault_patch_t;
+
+typedef struct {
+    const char *s;
+    size_t len;
+} fault_token_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static char *fault_strdup(const char *s);
+static fault_t *fault_find(const char *base_path);
+static int fault_join(char *buf, const char *base, const char *path);
+static uint32_t fault_random(fault_t *f);
+static uint32_t fault_base_delay(fault_t *f, const xf_vfs_fault_rule_t *rule);
+static int fault_inject(fault_t *f, xf_vfs_trace_op_t op, size_t size);
+static void fault_apply(fault_t *f, const fault_patch_t *patch);
+
+static bool token_next(const char **p, const char *end, fault_token_t *tok);
+static bool token_eq(const fault_token_t *tok, const char *s);
+static bool token_split(fault_token_t *tok, char sep, fault_token_t *head);
+static bool parse_uint(const fault_token_t *tok, uint32_t *out, const char **suffix);
+static bool parse_time(const fault_token_t *tok, uint32_t *us);
+static bool parse_bytes(const fault_token_t *tok, uint32_t *bytes);
+static bool parse_errno(const fault_token_t *tok, int *err);
+static bool parse_ops(fault_token_t tok, uint32_t *ops);
+static bool parse_item(fault_token_t tok, fault_patch_t *patch);
+
+static int fault_open(void *ctx, const char *path, int flags, int mode);
+static int fault_close(void *ctx, int fd);
+static xf_vfs_ssize_t fault_read(void *ctx, int fd, void *dst, size_t size);
+static xf_vfs_ssize_t fault_write(void *ctx, int fd, const void *data, size_t size);
+static xf_vfs_ssize_t fault_pread(void *ctx, int fd, void *dst, size_t size, xf_vfs_off_t offset);
+static xf_vfs_ssize_t fault_pwrite(void *ctx, int fd, const void *src, size_t size, xf_vfs_off_t offset);
+static xf_vfs_off_t fault_lseek(void *ctx, int fd, xf_vfs_off_t offset, int mode);
+static int fault_fstat(void *ctx, int fd, xf_vfs_stat_t *st);
+static int fault_fsync(void *ctx, int fd);
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+static int fault_stat(void *ctx, const char *path, xf_vfs_stat_t *st);
+static int fault_link(void *ctx, const char *n1, const char *n2);
+static int fault_unlink(void *ctx, const char *path);
+static int fault_rename(void *ctx, const char *src, const char *dst);
+static xf_vfs_dir_t *fault_opendir(void *ctx, const char *name);
+static xf_vfs_dirent_t *fault_readdir(void *ctx, xf_vfs_dir_t *pdir);
+static long fault_telldir(void *ctx, xf_vfs_dir_t *pdir);
+static void fault_seekdir(void *ctx, xf_vfs_dir_t *pdir, long offset);
+static int fault_closedir(void *ctx, xf_vfs_dir_t *pdir);
+static int fault_mkdir(void *ctx, const char *name, xf_vfs_mode_t mode);
+static int fault_rmdir(void *ctx, const char *name);
+static int fault_access(void *ctx, const char *path, int amode);
+static int fault_truncate(void *ctx, const char *path, xf_vfs_off_t length);
+static int fault_ftruncate(void *ctx, int fd, xf_vfs_off_t length);
+static int fault_utime(void *ctx, const char *path, const xf_vfs_utimbuf_t *times);
+#endif
+
+/* ==================== [Static Variables] ================================== */
+
+static fault_t *s_faults = NULL;
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+static const xf_vfs_dir_ops_t s_fault_dir_ops = {
+    .stat_p = fault_stat,
+    .link_p = fault_link,
+    .unlink_p = fault_unlink,
+    .rename_p = fault_rename,
+    .opendir_p = fault_opendir,
+    .readdir_p = fault_readdir,
+    .telldir_p = fault_telldir,
+    .seekdir_p = fault_seekdir,
+    .closedir_p = fault_closedir,
+    .mkdir_p = fault_mkdir,
+    .rmdir_p = fault_rmdir,
+    .access_p = fault_access,
+    .truncate_p = fault_truncate,
+    .ftruncate_p = fault_ftruncate,
+    .utime_p = fault_utime,
+};
+#endif
+
+static const xf_vfs_fs_ops_t s_fault_ops = {
+    .write_p = fault_write,
+    .lseek_p = fault_lseek,
+    .read_p = fault_read,
+    .pread_p = fault_pread,
+    .pwrite_p = fault_pwrite,
+    .open_p = fault_open,
+    .close_p = fault_close,
+    .fstat_p = fault_fstat,
+    .fsync_p = fault_fsync,
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+    .dir = &s_fault_dir_ops,
+#endif
+};
+
+static const struct {
+    const char *name;
+    int err;
+} s_errno_names[] = {
+    { "EIO",        EIO },
+    { "ENOSPC",     ENOSPC },
+    { "ETIMEDOUT",  ETIMEDOUT },
+    { "EBUSY",      EBUSY },
+};
+
+/* ==================== [Macros] ============================================ */
+
+/* 注入失败时返回 err_ret，否则转发 */
+#define FAULT_FORWARD(ctx, op, size, err_ret, call) \
+    do { \
+        if (fault_inject((fault_t *)(ctx), (op), (size)) < 0) { \
+            return err_ret; \
+        } \
+        return call; \
+    } while (0)
+
+/* ==================== [Global Functions] ================================== */
+
+xf_err_t xf_vfs_fault_register(const char *base_path, const char *target_path, uint32_t seed)
+{
+    if (base_path == NULL || target_path == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+
+    fault_t *f = xf_vfs_malloc(sizeof(fault_t));
+    if (f == NULL) {
+        return XF_ERR_NO_MEM;
+    }
+    xf_memset(f, 0, sizeof(fault_t));
+    f->rng = (seed != 0) ? seed : 0x9E3779B9u;
+    f->base_path = fault_strdup(base_path);
+    f->target = fault_strdup(target_path);
+    xf_err_t err = XF_ERR_NO_MEM;
+    if (f->base_path == NULL || f->target == NULL || xf_lock_init(&f->lock) != XF_OK) {
+        goto fail;
+    }
+
+    err = xf_vfs_register_fs(base_path, &s_fault_ops, XF_VFS_FLAG_CONTEXT_PTR | XF_VFS_FLAG_STATIC, f);
+    if (err != XF_OK) {
+        goto fail;
+    }
+
+    f->next = s_faults;
+    s_faults = f;
+    return XF_OK;
+
+fail:
+    if (f->lock) {
+        xf_lock_destroy(f->lock);
+    }
+    xf_vfs_free(f->base_path);
+    xf_vfs_free(f->target);
+    xf_vfs_free(f);
+    return err;
+}
+
+xf_err_t xf_vfs_fault_unregister(const char *base_path)
+{
+    fault_t **pp = &s_faults;
+    while (*pp && xf_strcmp((*pp)->base_path, base_path) != 0) {
+        pp = &(*pp)->next;
+    }
+    fault_t *f = *pp;
+    if (f == NULL) {
+        return XF_ERR_INVALID_STATE;
+    }
+    xf_err_t err = xf_vfs_unregister_fs(base_path);
+    if (err != XF_OK) {
+        return err;
+    }
+    *pp = f->next;
+
+    xf_lock_destroy(f->lock);
+    xf_vfs_free(f->base_path);
+    xf_vfs_free(f->target);
+    xf_vfs_free(f);
+    return XF_OK;
+}
+
+xf_err_t xf_vfs_fault_set_rule(const char *base_path, xf_vfs_trace_op_t op, const xf_vfs_fault_rule_t *rule)
+{
+    fault_t *f = fault_find(base_path);
+    if (f == NULL) {
+        return XF_ERR_INVALID_STATE;
+    }
+    if ((unsigned)op > XF_VFS_FAULT_OP_ALL || (rule != NULL && rule->dist > XF_VFS_FAULT_DIST_LONG_TAIL)) {
+        return XF_ERR_INVALID_ARG;
+    }
+    fault_patch_t patch = { 0 };
+    patch.ops = (op == XF_VFS_FAULT_OP_ALL) ? ((1u << XF_VFS_TRACE_OP_MAX) - 1) : (1u << op);
+    if (rule != NULL) {
+        patch.fields = PATCH_CLEAR | PATCH_DIST | PATCH_BW | PATCH_STALL | PATCH_ERROR;
+        patch.rule = *rule;
+    } else {
+        patch.fields = PATCH_CLEAR;
+    }
+    fault_apply(f, &patch);
+    return XF_OK;
+}
+
+xf_err_t xf_vfs_fault_configure(const char *base_path, const char *script)
+{
+    fault_t *f = fault_find(base_path);
+    if (f == NULL) {
+        return XF_ERR_INVALID_STATE;
+    }
+    if (script == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+
+    const char *p = script;
+    while (*p != '\0') {
+        /* 一条规则到 ';'、换行或结尾为止 */
+        const char *end = p;
+        while (*end != '\0' && *end != ';' && *end != '\n') {
+            ++end;
+        }
+        fault_token_t tok;
+        const char *q = p;
+        if (token_next(&q, end, &tok)) {
+            fault_patch_t patch = { 0 };
+            if (!parse_ops(tok, &patch.ops)) {
+                return XF_ERR_INVALID_ARG;
+            }
+            while (token_next(&q, end, &tok)) {
+                if (!parse_item(tok, &patch)) {
+                    return XF_ERR_INVALID_ARG;
+                }
+            }
+            fault_apply(f, &patch);
+        }
+        p = (*end != '\0') ? end + 1 : end;
+    }
+    return XF_OK;
+}
+
+xf_err_t xf_vfs_fault_get_stats(const char *base_path, xf_vfs_fault_stats_t *stats, bool reset)
+{
+    fault_t *f = fault_find(base_path);
+    if (f == NULL) {
+        return XF_ERR_INVALID_STATE;
+    }
+    if (stats == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+    xf_lock_lock(f->lock);
+    *stats = f->stats;
+    if (reset) {
+        xf_memset(&f->stats, 0, sizeof(f->stats));
+    }
+    xf_lock_unlock(f->lock);
+    return XF_OK;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static char *fault_strdup(const char *s)
+{
+    size_t len = xf_strlen(s) + 1;
+    char *d = xf_vfs_malloc(len);
+    if (d) {
+        xf_memcpy(d, s, len);
+    }
+    return d;
+}
+
+static fault_t *fault_find(const char *base_path)
+{
+    if (base_path == NULL) {
+        return NULL;
+    }
+    fault_t *f = s_faults;
+    while (f && xf_strcmp(f->base_path, base_path) != 0) {
+        f = f->next;
+    }
+    return f;
+}
+
+static int fault_join(char *buf, const char *base, const char *path)
+{
+    const char *rest = (xf_strcmp(path, "/") == 0) ? "" : path;
+    size_t blen = xf_strlen(base);
+    size_t rlen = xf_strlen(rest);
+    if (blen + rlen + 1 > XF_VFS_FAULT_PATH_MAX) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    xf_memcpy(buf, base, blen);
+    xf_memcpy(buf + blen, rest, rlen + 1);
+    if (blen + rlen == 0) {
+        buf[0] = '/';
+        buf[1] = '\0';
+    }
+    return 0;
+}
+
+/* 调用时须持有 f->lock */
+static uint32_t fault_random(fault_t *f)
+{
+    uint32_t x = f->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    f->rng = x;
+    return x;
+}
+
+/* 调用时须持有 f->lock */
+static uint32_t fault_base_delay(fault_t *f, const xf_vfs_fault_rule_t *rule)
+{
+    switch (rule->dist) {
+    case XF_VFS_FAULT_DIST_FIXED:
+        return rule->lat_us;
+    case XF_VFS_FAULT_DIST_UNIFORM:
+        if (rule->lat_max_us <= rule->lat_us) {
+            return rule->lat_us;
+        }
+        return rule->lat_us + (uint32_t)((uint64_t)fault_random(f) * (rule->lat_max_us - rule->lat_us + 1) >> 32);
+    case XF_VFS_FAULT_DIST_LONG_TAIL: {
+        uint32_t us = rule->lat_us;
+        while (us < rule->lat_max_us && (fault_random(f) % 10000) < rule->tail_permyriad) {
+            us = (us > rule->lat_max_us / 2) ? rule->lat_max_us : ((us != 0) ? us * 2 : 1);
+        }
+        return us;
+    }
+    default:
+        return 0;
+    }
+}
+
+/*
+ * 按 op 的规则计算并执行注入的延迟。
+ *
+ * @return 0: 继续转发；-1: 注入错误，errno 已设置。
+ */
+static int fault_inject(fault_t *f, xf_vfs_trace_op_t op, size_t size)
+{
+    fault_op_t *o = &f->ops[op];
+    bool fail = false;
+
+    xf_lock_lock(f->lock);
+    const xf_vfs_fault_rule_t *rule = &o->rule;
+    const uint32_t n = ++o->calls;
+    uint64_t us = fault_base_delay(f, rule);
+    if (rule->bytes_per_sec != 0 && size != 0) {
+        us += ((uint64_t)size * 1000000u + rule->bytes_per_sec - 1) / rule->bytes_per_sec;
+    }
+    if (rule->stall_every != 0 && n % rule->stall_every == 0) {
+        us += rule->stall_us;
+        ++f->stats.stalls;
+    }
+    const int err = (rule->error != 0) ? rule->error : EIO;
+    if (rule->error_every != 0 && n % rule->error_every == 0) {
+        fail = true;
+        ++f->stats.errors;
+    }
+    if (us > UINT32_MAX) {
+        us = UINT32_MAX;
+    }
+    ++f->stats.calls;
+    f->stats.delay_us += us;
+    xf_lock_unlock(f->lock);
+
+    if (us != 0) {
+        XF_VFS_FAULT_DELAY_US((uint32_t)us);
+    }
+    if (fail) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+static void fault_apply(fault_t *f, const fault_patch_t *patch)
+{
+    xf_lock_lock(f->lock);
+    for (int op = 0; op < XF_VFS_TRACE_OP_MAX; ++op) {
+        if ((patch->ops & (1u << op)) == 0) {
+            continue;
+        }
+        xf_vfs_fault_rule_t *rule = &f->ops[op].rule;
+        if (patch->fields & PATCH_CLEAR) {
+            xf_memset(rule, 0, sizeof(*rule));
+        }
+        if (patch->fields & PATCH_DIST) {
+            rule->dist = patch->rule.dist;
+            rule->lat_us = patch->rule.lat_us;
+            rule->lat_max_us = patch->rule.lat_max_us;
+            rule->tail_permyriad = patch->rule.tail_permyriad;
+        }
+        if (patch->fields & PATCH_BW) {
+            rule->bytes_per_sec = patch->rule.bytes_per_sec;
+        }
+        if (patch->fields & PATCH_STALL) {
+            rule->stall_every = patch->rule.stall_every;
+            rule->stall_us = patch->rule.stall_us;
+        }
+        if (patch->fields & PATCH_ERROR) {
+            rule->error_every = patch->rule.error_every;
+            rule->error = patch->rule.error;
+        }
+        f->ops[op].calls = 0;
+    }
+    xf_lock_unlock(f->lock);
+}
+
+/* 取出 [*p, end) 中下一个以空白分隔的单词 */
+static bool token_next(const char **p, const char *end, fault_token_t *tok)
+{
+    const char *s = *p;
+    while (s < end && (*s == ' ' || *s == '\t' || *s == '\r')) {
+        ++s;
+    }
+    const char *e = s;
+    while (e < end && *e != ' ' && *e != '\t' && *e != '\r') {
+        ++e;
+    }
+    *p = e;
+    tok->s = s;
+    tok->len = (size_t)(e - s);
+    return tok->len != 0;
+}
+
+static bool token_eq(const fault_token_t *tok, const char *s)
+{
+    return xf_strlen(s) == tok->len && xf_strncmp(tok->s, s, tok->len) == 0;
+}
+
+/* 把 tok 在第一个 sep 处分开：head 为之前的部分，tok 为之后的部分；没有 sep 时整个作为 head */
+static bool token_split(fault_token_t *tok, char sep, fault_token_t *head)
+{
+    size_t i = 0;
+    while (i < tok->len && tok->s[i] != sep) {
+        ++i;
+    }
+    head->s = tok->s;
+    head->len = i;
+    if (i < tok->len) {
+        tok->s += i + 1;
+        tok->len -= i + 1;
+        return true;
+    }
+    tok->s += i;
+    tok->len = 0;
+    return false;
+}
+
+/* 解析开头的十进制数，suffix 指向其后的字符 */
+static bool parse_uint(const fault_token_t *tok, uint32_t *out, const char **suffix)
+{
+    uint64_t v = 0;
+    size_t i = 0;
+    while (i < tok->len && tok->s[i] >= '0' && tok->s[i] <= '9') {
+        v = v * 10 + (uint64_t)(tok->s[i] - '0');
+        if (v > UINT32_MAX) {
+            return false;
+        }
+        ++i;
+    }
+    if (i == 0) {
+        return false;
+    }
+    *out = (uint32_t)v;
+    *suffix = tok->s + i;
+    return true;
+}
+
+static bool parse_time(const fault_token_t *tok, uint32_t *us)
+{
+    uint32_t v;
+    const char *suffix;
+    if (!parse_uint(tok, &v, &suffix)) {
+        return false;
+    }
+    const fault_token_t unit = { suffix, (size_t)(tok->s + tok->len - suffix) };
+    uint64_t scale;
+    if (unit.len == 0 || token_eq(&unit, "us")) {
+        scale = 1;
+    } else if (token_eq(&unit, "ms")) {
+        scale = 1000;
+    } else if (token_eq(&unit, "s")) {
+        scale = 1000000;
+    } else {
+        return false;
+    }
+    if ((uint64_t)v * scale > UINT32_MAX) {
+        return false;
+    }
+    *us = (uint32_t)(v * scale);
+    return true;
+}
+
+static bool parse_bytes(const fault_token_t *tok, uint32_t *bytes)
+{
+    uint32_t v;
+    const char *suffix;
+    if (!parse_uint(tok, &v, &suffix)) {
+        return false;
+    }
+    const size_t rest = (size_t)(tok->s + tok->len - suffix);
+    uint64_t scale = 1;
+    if (rest == 1 && (*suffix == 'K' || *suffix == 'k')) {
+        scale = 1024;
+    } else if (rest == 1 && (*suffix == 'M' || *suffix == 'm')) {
+        scale = 1024 * 1024;
+    } else if (rest != 0) {
+        return false;
+    }
+    if ((uint64_t)v * scale > UINT32_MAX) {
+        return false;
+    }
+    *bytes = (uint32_t)(v * scale);
+    return true;
+}
+
+static bool parse_errno(const fault_token_t *tok, int *err)
+{
+    for (size_t i = 0; i < sizeof(s_errno_names) / sizeof(s_errno_names[0]); ++i) {
+        if (token_eq(tok, s_errno_names[i].name)) {
+            *err = s_errno_names[i].err;
+            return true;
+        }
+    }
+    uint32_t v;
+    const char *suffix;
+    if (!parse_uint(tok, &v, &suffix) || suffix != tok->s + tok->len || v == 0 || v > 0x7FFF) {
+        return false;
+    }
+    *err = (int)v;
+    return true;
+}
+
+/* "read,write" 或 "all" */
+static bool parse_ops(fault_token_t tok, uint32_t *ops)
+{
+    *ops = 0;
+    fault_token_t name;
+    bool more;
+    do {
+        more = token_split(&tok, ',', &name);
+        if (token_eq(&name, "all")) {
+            *ops |= (1u << XF_VFS_TRACE_OP_MAX) - 1;
+            continue;
+        }
+        int op = 0;
+        while (op < XF_VFS_TRACE_OP_MAX && !token_eq(&name, xf_vfs_trace_op_name((xf_vfs_trace_op_t)op))) {
+            ++op;
+        }
+        if (op == XF_VFS_TRACE_OP_MAX) {
+            return false;
+        }
+        *ops |= 1u << op;
+    } while (more);
+    return true;
+}
+
+static bool parse_item(fault_token_t tok, fault_patch_t *patch)
+{
+    fault_token_t key;
+    fault_token_t a;
+    fault_token_t b;
+    xf_vfs_fault_rule_t *rule = &patch->rule;
+
+    if (token_eq(&tok, "clear")) {
+        patch->fields = PATCH_CLEAR;
+        xf_memset(rule, 0, sizeof(*rule));
+        return true;
+    }
+    if (!token_split(&tok, '=', &key)) {
+        return false;
+    }
+    if (token_eq(&key, "fixed")) {
+        rule->dist = XF_VFS_FAULT_DIST_FIXED;
+        patch->fields |= PATCH_DIST;
+        return parse_time(&tok, &rule->lat_us);
+    }
+    if (token_eq(&key, "uniform")) {
+        rule->dist = XF_VFS_FAULT_DIST_UNIFORM;
+        patch->fields |= PATCH_DIST;
+        return token_split(&tok, ':', &a) && parse_time(&a, &rule->lat_us)
+               && parse_time(&tok, &rule->lat_max_us) && rule->lat_max_us >= rule->lat_us;
+    }
+    if (token_eq(&key, "tail")) {
+        uint32_t p;
+        const char *suffix;
+        rule->dist = XF_VFS_FAULT_DIST_LONG_TAIL;
+        patch->fields |= PATCH_DIST;
+        if (!token_split(&tok, ':', &a) || !token_split(&tok, ':', &b)
+                || !parse_time(&a, &rule->lat_us) || !parse_time(&b, &rule->lat_max_us)
+                || !parse_uint(&tok, &p, &suffix) || suffix != tok.s + tok.len || p > 10000) {
+            return false;
+        }
+        rule->tail_permyriad = (uint16_t)p;
+        return true;
+    }
+    if (token_eq(&key, "bw")) {
+        patch->fields |= PATCH_BW;
+        return parse_bytes(&tok, &rule->bytes_per_sec);
+    }
+    if (token_eq(&key, "stall")) {
+        const char *suffix;
+        patch->fields |= PATCH_STALL;
+        return token_split(&tok, ':', &a) && parse_uint(&a, &rule->stall_every, &suffix)
+               && suffix == a.s + a.len && parse_time(&tok, &rule->stall_us);
+    }
+    if (token_eq(&key, "error")) {
+        const char *suffix;
+        patch->fields |= PATCH_ERROR;
+        rule->error = EIO;
+        const bool has_errno = token_split(&tok, ':', &a);
+        if (!parse_uint(&a, &rule->error_every, &suffix) || suffix != a.s + a.len) {
+            return false;
+        }
+        return !has_errno || parse_errno(&tok, &rule->error);
+    }
+    return false;
+}
+
+static int fault_open(void *ctx, const char *path, int flags, int mode)
+{
+    fault_t *f = ctx;
+    char buf[XF_VFS_FAULT_PATH_MAX];
+    if (fault_join(buf, f->target, path) < 0) {
+        return -1;
+    }
+    /* 本驱动的 local fd 即底层的全局 fd */
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_OPEN, 0, -1, xf_vfs_open(buf, flags, mode));
+}
+
+static int fault_close(void *ctx, int fd)
+{
+    /* 注入错误时 fd 仍需关闭，否则底层 fd 泄漏 */
+    if (fault_inject(ctx, XF_VFS_TRACE_OP_CLOSE, 0) < 0) {
+        const int err = errno;
+        xf_vfs_close(fd);
+        errno = err;
+        return -1;
+    }
+    return xf_vfs_close(fd);
+}
+
+static xf_vfs_ssize_t fault_read(void *ctx, int fd, void *dst, size_t size)
+{
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_READ, size, -1, xf_vfs_read(fd, dst, size));
+}
+
+static xf_vfs_ssize_t fault_write(void *ctx, int fd, const void *data, size_t size)
+{
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_WRITE, size, -1, xf_vfs_write(fd, data, size));
+}
+
+static xf_vfs_ssize_t fault_pread(void *ctx, int fd, void *dst, size_t size, xf_vfs_off_t offset)
+{
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_PREAD, size, -1, xf_vfs_pread(fd, dst, size, offset));
+}
+
+static xf_vfs_ssize_t fault_pwrite(void *ctx, int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_PWRITE, size, -1, xf_vfs_pwrite(fd, src, size, offset));
+}
+
+static xf_vfs_off_t fault_lseek(void *ctx, int fd, xf_vfs_off_t offset, int mode)
+{
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_LSEEK, 0, -1, xf_vfs_lseek(fd, offset, mode));
+}
+
+static int fault_fstat(void *ctx, int fd, xf_vfs_stat_t *st)
+{
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_FSTAT, 0, -1, xf_vfs_fstat(fd, st));
+}
+
+static int fault_fsync(void *ctx, int fd)
+{
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_FSYNC, 0, -1, xf_vfs_fsync(fd));
+}
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+
+static int fault_stat(void *ctx, const char *path, xf_vfs_stat_t *st)
+{
+    fault_t *f = ctx;
+    char buf[XF_VFS_FAULT_PATH_MAX];
+    if (fault_join(buf, f->target, path) < 0) {
+        return -1;
+    }
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_STAT, 0, -1, xf_vfs_stat(buf, st));
+}
+
+static int fault_link(void *ctx, const char *n1, const char *n2)
+{
+    fault_t *f = ctx;
+    char buf1[XF_VFS_FAULT_PATH_MAX];
+    char buf2[XF_VFS_FAULT_PATH_MAX];
+    if (fault_join(buf1, f->target, n1) < 0 || fault_join(buf2, f->target, n2) < 0) {
+        return -1;
+    }
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_LINK, 0, -1, xf_vfs_link(buf1, buf2));
+}
+
+static int fault_unlink(void *ctx, const char *path)
+{
+    fault_t *f = ctx;
+    char buf[XF_VFS_FAULT_PATH_MAX];
+    if (fault_join(buf, f->target, path) < 0) {
+        return -1;
+    }
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_UNLINK, 0, -1, xf_vfs_unlink(buf));
+}
+
+static int fault_rename(void *ctx, const char *src, const char *dst)
+{
+    fault_t *f = ctx;
+    char buf1[XF_VFS_FAULT_PATH_MAX];
+    char buf2[XF_VFS_FAULT_PATH_MAX];
+    if (fault_join(buf1, f->target, src) < 0 || fault_join(buf2, f->target, dst) < 0) {
+        return -1;
+    }
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_RENAME, 0, -1, xf_vfs_rename(buf1, buf2));
+}
+
+static xf_vfs_dir_t *fault_opendir(void *ctx, const char *name)
+{
+    fault_t *f = ctx;
+    char buf[XF_VFS_FAULT_PATH_MAX];
+    if (fault_join(buf, f->target, name) < 0) {
+        return NULL;
+    }
+    if (fault_inject(f, XF_VFS_TRACE_OP_OPENDIR, 0) < 0) {
+        return NULL;
+    }
+    fault_dir_t *dir = xf_vfs_malloc(sizeof(fault_dir_t));
+    if (dir == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    xf_memset(dir, 0, sizeof(fault_dir_t));
+    dir->inner = xf_vfs_opendir(buf);
+    if (dir->inner == NULL) {
+        xf_vfs_free(dir);
+        return NULL;
+    }
+    return &dir->base;
+}
+
+static xf_vfs_dirent_t *fault_readdir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    fault_dir_t *dir = (fault_dir_t *)pdir;
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_READDIR, 0, NULL, xf_vfs_readdir(dir->inner));
+}
+
+static long fault_telldir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    fault_dir_t *dir = (fault_dir_t *)pdir;
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_TELLDIR, 0, -1, xf_vfs_telldir(dir->inner));
+}
+
+static void fault_seekdir(void *ctx, xf_vfs_dir_t *pdir, long offset)
+{
+    fault_dir_t *dir = (fault_dir_t *)pdir;
+    if (fault_inject(ctx, XF_VFS_TRACE_OP_SEEKDIR, 0) == 0) {
+        xf_vfs_seekdir(dir->inner, offset);
+    }
+}
+
+static int fault_closedir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    fault_dir_t *dir = (fault_dir_t *)pdir;
+    /* 与 close 相同，注入错误时也释放 */
+    const int injected = fault_inject(ctx, XF_VFS_TRACE_OP_CLOSEDIR, 0);
+    const int err = errno;
+    int ret = xf_vfs_closedir(dir->inner);
+    xf_vfs_free(dir);
+    if (injected < 0) {
+        errno = err;
+        return -1;
+    }
+    return ret;
+}
+
+static int fault_mkdir(void *ctx, const char *name, xf_vfs_mode_t mode)
+{
+    fault_t *f = ctx;
+    char buf[XF_VFS_FAULT_PATH_MAX];
+    if (fault_join(buf, f->target, name) < 0) {
+        return -1;
+    }
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_MKDIR, 0, -1, xf_vfs_mkdir(buf, mode));
+}
+
+static int fault_rmdir(void *ctx, const char *name)
+{
+    fault_t *f = ctx;
+    char buf[XF_VFS_FAULT_PATH_MAX];
+    if (fault_join(buf, f->target, name) < 0) {
+        return -1;
+    }
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_RMDIR, 0, -1, xf_vfs_rmdir(buf));
+}
+
+static int fault_access(void *ctx, const char *path, int amode)
+{
+    fault_t *f = ctx;
+    char buf[XF_VFS_FAULT_PATH_MAX];
+    if (fault_join(buf, f->target, path) < 0) {
+        return -1;
+    }
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_ACCESS, 0, -1, xf_vfs_access(buf, amode));
+}
+
+static int fault_truncate(void *ctx, const char *path, xf_vfs_off_t length)
+{
+    fault_t *f = ctx;
+    char buf[XF_VFS_FAULT_PATH_MAX];
+    if (fault_join(buf, f->target, path) < 0) {
+        return -1;
+    }
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_TRUNCATE, 0, -1, xf_vfs_truncate(buf, length));
+}
+
+static int fault_ftruncate(void *ctx, int fd, xf_vfs_off_t length)
+{
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_FTRUNCATE, 0, -1, xf_vfs_ftruncate(fd, length));
+}
+
+static int fault_utime(void *ctx, const char *path, const xf_vfs_utimbuf_t *times)
+{
+    fault_t *f = ctx;
+    char buf[XF_VFS_FAULT_PATH_MAX];
+    if (fault_join(buf, f->target, path) < 0) {
+        return -1;
+    }
+    FAULT_FORWARD(ctx, XF_VFS_TRACE_OP_UTIME, 0, -1, xf_vfs_utime(buf, times));
+}
+
+#endif /* XF_VFS_SUPPORT_DIR_IS_ENABLE */
@@ -0,0 +1,159 @@
+/**
+ * @file xf_vfs_fault.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs fault（故障注入）驱动。
+ *        把调用转发到另一个挂载点，并按操作注入延迟、带宽限制、周期性卡顿与错误，
+ *        用于在没有硬件的情况下模拟慢速设备（SPI flash、SD 卡等）并评估缓存等功能。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __XF_VFS_FAULT_H__
+#define __XF_VFS_FAULT_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs.h"
+#include "xf_vfs_trace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @cond (XFAPI_USER || XFAPI_PORT || XFAPI_INTERNAL)
+ * @addtogroup group_xf_vfs
+ * @endcond
+ * @{
+ */
+
+/* ==================== [Defines] =========================================== */
+
+/**
+ * @brief xf_vfs_fault_set_rule() 的 op 取此值时设置所有操作。
+ */
+#define XF_VFS_FAULT_OP_ALL         XF_VFS_TRACE_OP_MAX
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 每次调用的基础延迟分布。
+ */
+typedef enum {
+    XF_VFS_FAULT_DIST_NONE = 0,     /*!< 无延迟 */
+    XF_VFS_FAULT_DIST_FIXED,        /*!< 固定为 lat_us */
+    XF_VFS_FAULT_DIST_UNIFORM,      /*!< 在 [lat_us, lat_max_us] 内均匀分布 */
+    /**
+     * 长尾：从 lat_us 开始，每次以 tail_permyriad / 10000 的概率翻倍，直到 lat_max_us，
+     * 即 P(延迟 >= lat_us * 2^k) = p^k（离散 Pareto 分布）。
+     */
+    XF_VFS_FAULT_DIST_LONG_TAIL,
+} xf_vfs_fault_dist_t;
+
+/**
+ * @brief 一种操作的注入规则。各项叠加：基础延迟 + 传输时间 + 卡顿。
+ */
+typedef struct {
+    uint8_t dist;               /*!< xf_vfs_fault_dist_t */
+    uint16_t tail_permyriad;    /*!< XF_VFS_FAULT_DIST_LONG_TAIL 每次翻倍的概率（万分比） */
+    uint32_t lat_us;            /*!< 基础延迟（us），见 xf_vfs_fault_dist_t */
+    uint32_t lat_max_us;        /*!< 基础延迟上限（us），见 xf_vfs_fault_dist_t */
+    uint32_t bytes_per_sec;     /*!< 读写的带宽上限，按请求的字节数计算传输时间；0 为不限 */
+    uint32_t stall_every;       /*!< 每 stall_every 次调用卡顿一次，0 为不卡顿 */
+    uint32_t stall_us;          /*!< 卡顿的额外延迟（us） */
+    uint32_t error_every;       /*!< 每 error_every 次调用失败一次（不转发），0 为不注入错误 */
+    int error;                  /*!< 注入的 errno，0 时为 EIO */
+} xf_vfs_fault_rule_t;
+
+/**
+ * @brief 注入统计。
+ */
+typedef struct {
+    uint32_t calls;             /*!< 经过 fault 驱动的调用数 */
+    uint32_t stalls;            /*!< 注入的卡顿次数 */
+    uint32_t errors;            /*!< 注入的错误次数 */
+    uint64_t delay_us;          /*!< 注入的延迟总和（us） */
+} xf_vfs_fault_stats_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 注册 fault 文件系统：base_path 下的路径转发到 target_path 下的同名路径。
+ * 初始时不注入任何故障。
+ *
+ * @param base_path   fault 的挂载点，规则与 xf_vfs_register() 相同。
+ * @param target_path 被包装的目录的完整路径，如 "/ram".
+ * @param seed        随机延迟的种子，相同的种子与调用序列得到相同的延迟序列。
+ *
+ * @return  XF_OK if successful.
+ *          XF_ERR_NO_MEM if out of memory or too many VFSes are registered.
+ *          XF_ERR_INVALID_ARG if given an invalid parameter.
+ */
+xf_err_t xf_vfs_fault_register(const char *base_path, const char *target_path, uint32_t seed);
+
+/**
+ * @brief 注销由 xf_vfs_fault_register() 注册的 fault 文件系统。
+ *
+ * @note 注销前应关闭通过它打开的文件与目录，否则底层挂载点上对应的 fd 不会被关闭。
+ *
+ * @return XF_OK if successful, XF_ERR_INVALID_STATE if no fault mount is at base_path.
+ */
+xf_err_t xf_vfs_fault_unregister(const char *base_path);
+
+/**
+ * @brief 设置一种操作的注入规则，并清零其调用计数（stall_every / error_every 重新开始计数）。
+ *
+ * @param op   操作，XF_VFS_FAULT_OP_ALL 为所有操作。
+ * @param rule 规则，NULL 为取消注入。
+ *
+ * @return XF_OK if successful, XF_ERR_INVALID_STATE if no fault mount is at base_path,
+ *         XF_ERR_INVALID_ARG if op or rule is invalid.
+ */
+xf_err_t xf_vfs_fault_set_rule(const char *base_path, xf_vfs_trace_op_t op, const xf_vfs_fault_rule_t *rule);
+
+/**
+ * @brief 用文本脚本设置注入规则，便于在基准测试或作业文件中描述设备。
+ *
+ * 脚本由 ';' 或换行分隔的若干条规则组成，每条为空格分隔的
+ * `<操作>[,<操作>...] <项>...`，操作名同 xf_vfs_trace_op_name()，"all" 为所有操作。
+ * 同一操作的多条规则依次覆盖其中出现的项。项：
+ * - `fixed=<时间>`
+ * - `uniform=<最小>:<最大>`
+ * - `tail=<起点>:<上限>:<万分比>`，长尾分布
+ * - `bw=<字节数>`，每秒字节数，可带 K/M 后缀（1024 进制）
+ * - `stall=<次数>:<时间>`，每若干次调用卡顿一次
+ * - `error=<次数>[:<errno>]`，每若干次调用失败一次，errno 可为 EIO/ENOSPC/ETIMEDOUT/EBUSY 或数字
+ * - `clear`，取消该操作的注入
+ *
+ * 时间为整数加单位 us/ms/s（无单位为 us）。例如模拟偶尔擦除的 SPI flash：
+ * `"read fixed=40us bw=4M; write,pwrite uniform=200us:400us bw=512K stall=64:80ms; fsync error=100:EIO"`.
+ *
+ * @return XF_OK if successful（所有规则均已生效）,
+ *         XF_ERR_INVALID_ARG if the script has a syntax error（之前的规则已生效）,
+ *         XF_ERR_INVALID_STATE if no fault mount is at base_path.
+ */
+xf_err_t xf_vfs_fault_configure(const char *base_path, const char *script);
+
+/**
+ * @brief 取得注入统计。
+ *
+ * @param reset 取得后清零。
+ * @return XF_OK if successful, XF_ERR_INVALID_STATE if no fault mount is at base_path.
+ */
+xf_err_t xf_vfs_fault_get_stats(const char *base_path, xf_vfs_fault_stats_t *stats, bool reset);
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * End of addtogroup group_xf_vfs
+ * @}
+ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __XF_VFS_FAULT_H__ */
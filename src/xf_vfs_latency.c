@@ -0,0 +1,387 @@
+/**
+ * @file xf_vfs_latency.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs 延迟直方图：按（挂载点, 操作）统计驱动调用的耗时分布，用于观察尾延迟。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs_latency.h"
+#include "xf_vfs_private.h"
+
+#if XF_VFS_LATENCY_IS_ENABLE && XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE
+#include "xf_osal.h"
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#if !defined(STATIC_ASSERT)
+#   define STATIC_ASSERT(EXPR, ...)     extern char (*_do_assert(void)) [sizeof(char[1 - 2*!(EXPR)])]
+#endif
+
+#define SUB_COUNT               (1u << XF_VFS_LATENCY_SUB_BITS)
+#define VALUE_MAX               ((1u << XF_VFS_LATENCY_VALUE_BITS) - 1)
+
+#if XF_VFS_LATENCY_IS_ENABLE
+
+/* s_slot_of[][] 的取值：0 为未分配，SLOT_CLAIMING 为正在分配，否则为槽位下标加 1 */
+#define SLOT_CLAIMING           (0xFFFFu)
+
+/* 槽位状态 */
+#define SLOT_FREE               (0)
+#define SLOT_CLAIMING_STATE     (1)
+#define SLOT_USED               (2)
+
+/*
+ * 写入方与快照之间的相位计数（WriterReaderPhaser）。
+ * s_phaser.start 的最低位为当前相位，其余位为该相位开始的写入次数（每次加 2，回绕不影响相位位）。
+ */
+#define PHASE_BIT               (1u)
+#define PHASE_STEP              (2u)
+
+#if XF_VFS_SUPPORT_SELECT_IS_ENABLE || XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE
+#   define LATENCY_YIELD()      xf_osal_thread_yield()
+#else
+#   define LATENCY_YIELD()      do {} while (0)
+#endif
+
+STATIC_ASSERT(XF_VFS_LATENCY_SLOTS >= 1 && XF_VFS_LATENCY_SLOTS < SLOT_CLAIMING, "invalid XF_VFS_LATENCY_SLOTS");
+
+#endif
+
+STATIC_ASSERT(XF_VFS_LATENCY_SUB_BITS >= 1 && XF_VFS_LATENCY_SUB_BITS <= 6, "invalid XF_VFS_LATENCY_SUB_BITS");
+
+/* ==================== [Typedefs] ========================================== */
+
+#if XF_VFS_LATENCY_IS_ENABLE
+
+/*
+ * 一个（挂载点, 操作）组合的直方图。
+ * 写入方写 phase[当前相位]，快照切换相位后读取另一个。
+ */
+typedef struct {
+    uint16_t state;             // SLOT_*，原子访问
+    uint8_t vfs;
+    uint8_t op;
+    xf_vfs_latency_hist_t phase[2];
+} latency_slot_t;
+
+typedef struct {
+    uint32_t start;             // 相位位加写入开始次数，原子访问
+    uint32_t end[2];            // 各相位的写入完成次数（每次加 PHASE_STEP），原子访问
+} latency_phaser_t;
+
+#endif
+
+/* ==================== [Static Prototypes] ================================= */
+
+static uint32_t bucket_of(uint32_t value);
+static uint32_t bucket_upper_ns(uint32_t index);
+
+#if XF_VFS_LATENCY_IS_ENABLE
+static latency_slot_t *slot_get(int vfs_index, int op);
+static void max_update(uint32_t *max, uint32_t value);
+static void reader_lock(void);
+static void reader_unlock(void);
+static uint32_t phase_flip(void);
+static void report_cb(xf_vfs_id_t vfs_id, xf_vfs_trace_op_t op, const xf_vfs_latency_hist_t *hist, void *arg);
+#endif
+
+/* ==================== [Static Variables] ================================== */
+
+#if XF_VFS_LATENCY_IS_ENABLE
+
+static latency_slot_t s_slots[XF_VFS_LATENCY_SLOTS];
+static uint16_t s_slot_of[XF_VFS_MAX_COUNT][XF_VFS_TRACE_OP_MAX];
+static latency_phaser_t s_phaser;
+static uint32_t s_reader;
+static uint32_t s_dropped;
+#endif
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+uint32_t xf_vfs_latency_value_at(const xf_vfs_latency_hist_t *hist, uint32_t permyriad)
+{
+    if (hist == NULL || hist->count == 0) {
+        return 0;
+    }
+    if (permyriad >= 10000) {
+        return hist->max;
+    }
+    // 第 rank 个（从 1 开始）样本所在的桶
+    uint64_t rank = ((uint64_t)hist->count * permyriad + 9999) / 10000;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < XF_VFS_LATENCY_BUCKETS; ++b) {
+        seen += hist->buckets[b];
+        if (seen >= rank) {
+            const uint32_t upper = bucket_upper_ns(b);
+            return (upper < hist->max) ? upper : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+void xf_vfs_latency_hist_add(xf_vfs_latency_hist_t *hist, uint64_t ns)
+{
+    const uint32_t ns32 = (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+    ++hist->buckets[bucket_of(ns32 >> XF_VFS_LATENCY_UNIT_SHIFT)];
+    ++hist->count;
+    if (ns32 > hist->max) {
+        hist->max = ns32;
+    }
+}
+
+void xf_vfs_latency_hist_merge(xf_vfs_latency_hist_t *dst, const xf_vfs_latency_hist_t *src)
+{
+    for (int b = 0; b < XF_VFS_LATENCY_BUCKETS; ++b) {
+        dst->buckets[b] += src->buckets[b];
+    }
+    dst->count += src->count;
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+}
+
+#if XF_VFS_LATENCY_IS_ENABLE
+
+int xf_vfs_latency_snapshot(xf_vfs_latency_cb_t cb, void *arg, bool reset)
+{
+    if (cb == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    reader_lock();
+    const uint32_t old = phase_flip();
+
+    for (int i = 0; i < XF_VFS_LATENCY_SLOTS; ++i) {
+        latency_slot_t *slot = &s_slots[i];
+        if (XF_VFS_ATOMIC_REF_LOAD(&slot->state) != SLOT_USED) {
+            continue;
+        }
+        xf_vfs_latency_hist_t *hist = &slot->phase[old];
+        if (hist->count != 0) {
+            cb(slot->vfs, (xf_vfs_trace_op_t)slot->op, hist, arg);
+        }
+        if (!reset && hist->count != 0) {
+            // 把快照的样本并回当前相位，之后的快照继续包含它们
+            xf_vfs_latency_hist_t *cur = &slot->phase[old ^ 1];
+            for (int b = 0; b < XF_VFS_LATENCY_BUCKETS; ++b) {
+                if (hist->buckets[b] != 0) {
+                    XF_VFS_ATOMIC_U32_FETCH_ADD(&cur->buckets[b], hist->buckets[b]);
+                }
+            }
+            XF_VFS_ATOMIC_U32_FETCH_ADD(&cur->count, hist->count);
+            max_update(&cur->max, hist->max);
+        }
+        xf_memset(hist, 0, sizeof(*hist));
+    }
+
+    reader_unlock();
+    return 0;
+}
+
+uint32_t xf_vfs_latency_dropped(void)
+{
+    return XF_VFS_ATOMIC_U32_LOAD(&s_dropped);
+}
+
+void xf_vfs_latency_report(bool reset)
+{
+    xf_log_printf("------------------------------------------------------\n");
+    xf_log_printf("<VFS Path Prefix>:<op> count p50 p90 p99 p99.9 max (us)\n");
+    xf_log_printf("------------------------------------------------------\n");
+    xf_vfs_latency_snapshot(report_cb, NULL, reset);
+    const uint32_t dropped = xf_vfs_latency_dropped();
+    if (dropped != 0) {
+        xf_log_printf("(dropped) %lu\n", (unsigned long)dropped);
+    }
+}
+
+void xf_vfs_latency_record(int vfs_index, int op, uint64_t start)
+{
+    const int err = errno;
+    const uint64_t ns = XF_VFS_LATENCY_TIME_NS() - start;
+    const uint32_t ns32 = (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+
+    latency_slot_t *slot = slot_get(vfs_index, op);
+    if (slot == NULL) {
+        XF_VFS_ATOMIC_U32_FETCH_ADD(&s_dropped, 1);
+        errno = err;
+        return;
+    }
+
+    const uint32_t ticket = XF_VFS_ATOMIC_U32_FETCH_ADD(&s_phaser.start, PHASE_STEP);
+    const uint32_t phase = ticket & PHASE_BIT;
+    xf_vfs_latency_hist_t *hist = &slot->phase[phase];
+    XF_VFS_ATOMIC_U32_FETCH_ADD(&hist->buckets[bucket_of(ns32 >> XF_VFS_LATENCY_UNIT_SHIFT)], 1);
+    XF_VFS_ATOMIC_U32_FETCH_ADD(&hist->count, 1);
+    max_update(&hist->max, ns32);
+    XF_VFS_ATOMIC_U32_FETCH_ADD(&s_phaser.end[phase], PHASE_STEP);
+
+    errno = err;
+}
+
+void xf_vfs_latency_forget(int vfs_index)
+{
+    if (vfs_index < 0 || vfs_index >= XF_VFS_MAX_COUNT) {
+        return;
+    }
+    reader_lock();
+    for (int op = 0; op < XF_VFS_TRACE_OP_MAX; ++op) {
+        const uint16_t v = XF_VFS_ATOMIC_REF_LOAD(&s_slot_of[vfs_index][op]);
+        if (v == 0 || v == SLOT_CLAIMING) {
+            continue;
+        }
+        XF_VFS_ATOMIC_REF_STORE(&s_slot_of[vfs_index][op], 0);
+        latency_slot_t *slot = &s_slots[v - 1];
+        xf_memset(slot->phase, 0, sizeof(slot->phase));
+        XF_VFS_ATOMIC_REF_STORE(&slot->state, SLOT_FREE);
+    }
+    reader_unlock();
+}
+
+#endif /* XF_VFS_LATENCY_IS_ENABLE */
+
+/* ==================== [Static Functions] ================================== */
+
+/*
+ * 计时单位表示的耗时对应的桶：
+ * 小于 SUB_COUNT 时每个值一个桶；否则设最高位为 m，k = m - SUB_BITS + 1，
+ * 取最高 SUB_BITS + 1 位作为 k 号区间内的子桶。
+ */
+static uint32_t bucket_of(uint32_t value)
+{
+    if (value > VALUE_MAX) {
+        value = VALUE_MAX;
+    }
+    if (value < SUB_COUNT) {
+        return value;
+    }
+    uint32_t m = 0;
+    for (uint32_t v = value; v > 1; v >>= 1) {
+        ++m;
+    }
+    const uint32_t k = m - XF_VFS_LATENCY_SUB_BITS + 1;
+    return (k << XF_VFS_LATENCY_SUB_BITS) + (value >> (k - 1)) - SUB_COUNT;
+}
+
+/* 桶内最大耗时（ns） */
+static uint32_t bucket_upper_ns(uint32_t index)
+{
+    const uint32_t k = index >> XF_VFS_LATENCY_SUB_BITS;
+    const uint32_t sub = index & (SUB_COUNT - 1);
+    uint64_t hi;
+    if (k == 0) {
+        hi = sub;
+    } else {
+        hi = ((uint64_t)(sub + SUB_COUNT) << (k - 1)) + ((uint64_t)1 << (k - 1)) - 1;
+    }
+    const uint64_t ns = ((hi + 1) << XF_VFS_LATENCY_UNIT_SHIFT) - 1;
+    return (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+}
+
+#if XF_VFS_LATENCY_IS_ENABLE
+
+/*
+ * 取得（挂载点, 操作）的直方图，首次出现时分配一个空闲槽位。
+ * 多个线程同时首次记录同一组合时，只有一个分配，其余的本次样本被丢弃。
+ */
+static latency_slot_t *slot_get(int vfs_index, int op)
+{
+    if (vfs_index < 0 || vfs_index >= XF_VFS_MAX_COUNT || op < 0 || op >= XF_VFS_TRACE_OP_MAX) {
+        return NULL;
+    }
+    uint16_t *map = &s_slot_of[vfs_index][op];
+    uint16_t v = XF_VFS_ATOMIC_REF_LOAD(map);
+    if (v != 0) {
+        return (v == SLOT_CLAIMING) ? NULL : &s_slots[v - 1];
+    }
+
+    uint16_t expected = 0;
+    if (!XF_VFS_ATOMIC_REF_CAS(map, &expected, SLOT_CLAIMING)) {
+        return (expected == SLOT_CLAIMING) ? NULL : &s_slots[expected - 1];
+    }
+    for (int i = 0; i < XF_VFS_LATENCY_SLOTS; ++i) {
+        uint16_t state = SLOT_FREE;
+        if (XF_VFS_ATOMIC_REF_CAS(&s_slots[i].state, &state, SLOT_CLAIMING_STATE)) {
+            s_slots[i].vfs = (uint8_t)vfs_index;
+            s_slots[i].op = (uint8_t)op;
+            XF_VFS_ATOMIC_REF_STORE(&s_slots[i].state, SLOT_USED);
+            XF_VFS_ATOMIC_REF_STORE(map, (uint16_t)(i + 1));
+            return &s_slots[i];
+        }
+    }
+    // 没有空闲槽位，允许之后（如有挂载点卸载后）再次尝试
+    XF_VFS_ATOMIC_REF_STORE(map, 0);
+    return NULL;
+}
+
+static void max_update(uint32_t *max, uint32_t value)
+{
+    uint32_t cur = XF_VFS_ATOMIC_U32_LOAD(max);
+    while (value > cur) {
+        if (XF_VFS_ATOMIC_U32_CAS(max, &cur, value)) {
+            break;
+        }
+    }
+}
+
+static void reader_lock(void)
+{
+    uint32_t expected = 0;
+    while (!XF_VFS_ATOMIC_U32_CAS(&s_reader, &expected, 1)) {
+        expected = 0;
+        LATENCY_YIELD();
+    }
+}
+
+static void reader_unlock(void)
+{
+    XF_VFS_ATOMIC_U32_STORE(&s_reader, 0);
+}
+
+/*
+ * 切换相位，并等待切换前开始的写入全部完成。
+ * 新相位的 end 已在上次切换时清零，因此切换后 start 与 end 同时从 0 计数。
+ *
+ * @return 切换前的相位，其数据此后只有快照访问。
+ */
+static uint32_t phase_flip(void)
+{
+    const uint32_t cur = XF_VFS_ATOMIC_U32_LOAD(&s_phaser.start) & PHASE_BIT;
+    const uint32_t started = XF_VFS_ATOMIC_U32_XCHG(&s_phaser.start, cur ^ PHASE_BIT);
+    const uint32_t target = started & ~PHASE_BIT;
+    while (XF_VFS_ATOMIC_U32_LOAD(&s_phaser.end[cur]) != target) {
+        LATENCY_YIELD();
+    }
+    XF_VFS_ATOMIC_U32_STORE(&s_phaser.end[cur], 0);
+    return cur;
+}
+
+static void report_cb(xf_vfs_id_t vfs_id, xf_vfs_trace_op_t op, const xf_vfs_latency_hist_t *hist, void *arg)
+{
+    static const uint16_t s_permyriad[] = { 5000, 9000, 9900, 9990, 10000 };
+    (void)arg;
+
+    const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(vfs_id);
+    xf_log_printf("(%s):%s %lu", (vfs != NULL) ? vfs->path_prefix : "NULL",
+                  xf_vfs_trace_op_name(op), (unsigned long)hist->count);
+    for (size_t i = 0; i < sizeof(s_permyriad) / sizeof(s_permyriad[0]); ++i) {
+        const uint32_t ns = xf_vfs_latency_value_at(hist, s_permyriad[i]);
+        xf_log_printf(" %lu.%lu", (unsigned long)(ns / 1000), (unsigned long)((ns % 1000) / 100));
+    }
+    xf_log_printf("\n");
+}
+
+#endif /* XF_VFS_LATENCY_IS_ENABLE */
@@ -0,0 +1,141 @@
+/**
+ * @file xf_vfs_latency.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs 延迟直方图：按（挂载点, 操作）统计驱动调用的耗时分布，用于观察尾延迟。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __XF_VFS_LATENCY_H__
+#define __XF_VFS_LATENCY_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs.h"
+#include "xf_vfs_trace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @cond (XFAPI_USER || XFAPI_PORT || XFAPI_INTERNAL)
+ * @addtogroup group_xf_vfs
+ * @endcond
+ * @{
+ */
+
+/* ==================== [Defines] =========================================== */
+
+/**
+ * @brief 最小计时单位为 2^XF_VFS_LATENCY_UNIT_SHIFT ns（64 ns），可表示的最大耗时约 4.29 s.
+ */
+#define XF_VFS_LATENCY_UNIT_SHIFT   (6)
+#define XF_VFS_LATENCY_VALUE_BITS   (26)    /*!< 以计时单位表示的耗时的位数 */
+
+/**
+ * @brief 每个直方图的桶数。
+ *
+ * 前 2^XF_VFS_LATENCY_SUB_BITS 个桶各对应一个计时单位，
+ * 之后每个 2 倍区间均分为 2^XF_VFS_LATENCY_SUB_BITS 个桶（log-linear，同 HdrHistogram）。
+ */
+#define XF_VFS_LATENCY_BUCKETS \
+    ((XF_VFS_LATENCY_VALUE_BITS - XF_VFS_LATENCY_SUB_BITS + 1) << XF_VFS_LATENCY_SUB_BITS)
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 延迟直方图，每个（挂载点, 操作）组合一个；也可单独用于统计其他耗时（如 xf_vfs_bench.h）。
+ */
+typedef struct {
+    uint32_t count;                             /*!< 样本数 */
+    uint32_t max;                               /*!< 最大耗时（ns），超出范围时为 UINT32_MAX */
+    uint32_t buckets[XF_VFS_LATENCY_BUCKETS];   /*!< 各桶的样本数 */
+} xf_vfs_latency_hist_t;
+
+#if XF_VFS_LATENCY_IS_ENABLE || defined(__DOXYGEN__)
+
+/**
+ * @brief xf_vfs_latency_snapshot() 的回调，每个有样本的直方图调用一次。
+ *
+ * @param vfs_id 挂载点的 vfs_id.
+ * @param op     操作，32 位与 64 位版本、*at 函数与对应的路径函数统计为同一操作（同 xf_vfs_trace.h）。
+ * @param hist   直方图，仅在回调期间有效。
+ * @param arg    xf_vfs_latency_snapshot() 的 arg.
+ */
+typedef void (*xf_vfs_latency_cb_t)(
+    xf_vfs_id_t vfs_id, xf_vfs_trace_op_t op, const xf_vfs_latency_hist_t *hist, void *arg);
+
+#endif /* XF_VFS_LATENCY_IS_ENABLE || defined(__DOXYGEN__) */
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 直方图中不小于 permyriad / 10000 的样本不超过的耗时，即分位数。
+ *
+ * 结果为所在桶的上界（不超过 max），相对误差不超过 2^-XF_VFS_LATENCY_SUB_BITS.
+ *
+ * @param permyriad 万分比，如 p50 为 5000，p99.9 为 9990；10000 返回 max.
+ * @return 耗时（ns），直方图为空时为 0.
+ */
+uint32_t xf_vfs_latency_value_at(const xf_vfs_latency_hist_t *hist, uint32_t permyriad);
+
+/**
+ * @brief 向直方图加入一个样本，不做同步，供单个线程自己的直方图使用。
+ *
+ * @param ns 耗时（ns），超出范围时按 UINT32_MAX 计。
+ */
+void xf_vfs_latency_hist_add(xf_vfs_latency_hist_t *hist, uint64_t ns);
+
+/**
+ * @brief 把 src 的样本并入 dst，如合并各线程的直方图。
+ */
+void xf_vfs_latency_hist_merge(xf_vfs_latency_hist_t *dst, const xf_vfs_latency_hist_t *src);
+
+#if XF_VFS_LATENCY_IS_ENABLE || defined(__DOXYGEN__)
+
+/**
+ * @brief 取得所有直方图的快照。
+ *
+ * 所有直方图在同一时刻切换到备用缓冲区，因此快照中各直方图对应同一段时间，
+ * 切换前开始记录的样本都包含在快照中，之后的样本都不包含，不会丢失也不会重复。
+ * 记录样本的线程不需要等待，快照期间 xf_vfs 的调用照常进行。
+ *
+ * @note 多个线程同时调用时依次进行。
+ *
+ * @param cb    回调。
+ * @param arg   传给回调的参数。
+ * @param reset true: 快照后清零所有直方图；false: 快照中的样本继续累计。
+ * @return 0 if successful, -1 with errno (EINVAL) otherwise.
+ */
+int xf_vfs_latency_snapshot(xf_vfs_latency_cb_t cb, void *arg, bool reset);
+
+/**
+ * @brief 因直方图（XF_VFS_LATENCY_SLOTS）用完而丢弃的样本数。
+ */
+uint32_t xf_vfs_latency_dropped(void);
+
+/**
+ * @brief 用 xf_log_printf 打印所有直方图的 p50/p90/p99/p99.9/max（us）。
+ *
+ * @param reset 同 xf_vfs_latency_snapshot().
+ */
+void xf_vfs_latency_report(bool reset);
+
+#endif /* XF_VFS_LATENCY_IS_ENABLE || defined(__DOXYGEN__) */
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * End of addtogroup group_xf_vfs
+ * @}
+ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __XF_VFS_LATENCY_H__ */
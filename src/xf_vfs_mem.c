@@ -0,0 +1,143 @@
+/**
+ * @file xf_vfs_mem.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs 内部内存分配：可替换的分配器、无堆模式的固定内存池及使用统计。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs.h"
+#include "xf_vfs_mem.h"
+#include "xf_vfs_private.h"
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static void *default_alloc(size_t size, void *ctx);
+static void default_dealloc(void *ptr, void *ctx);
+static void counter_inc(uint16_t *counter, uint16_t *peak);
+
+/* ==================== [Static Variables] ================================== */
+
+static xf_vfs_allocator_t s_allocator = {
+    .alloc = default_alloc,
+    .dealloc = default_dealloc,
+    .ctx = NULL,
+};
+
+/* 分配器的使用统计 */
+static uint16_t s_heap_used = 0;
+static uint16_t s_heap_peak = 0;
+static uint16_t s_heap_fails = 0;
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+void xf_vfs_set_allocator(const xf_vfs_allocator_t *allocator)
+{
+    if (allocator == NULL || allocator->alloc == NULL || allocator->dealloc == NULL) {
+        s_allocator.alloc = default_alloc;
+        s_allocator.dealloc = default_dealloc;
+        s_allocator.ctx = NULL;
+        return;
+    }
+    s_allocator = *allocator;
+}
+
+void *xf_vfs_malloc(size_t size)
+{
+    void *ptr = s_allocator.alloc(size, s_allocator.ctx);
+    if (ptr == NULL) {
+        XF_VFS_ATOMIC_REF_INC(&s_heap_fails);
+        return NULL;
+    }
+    counter_inc(&s_heap_used, &s_heap_peak);
+    return ptr;
+}
+
+void xf_vfs_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    XF_VFS_ATOMIC_REF_DEC(&s_heap_used);
+    s_allocator.dealloc(ptr, s_allocator.ctx);
+}
+
+void *xf_vfs_pool_alloc(xf_vfs_pool_t *pool, size_t size)
+{
+    if (size <= pool->block_size) {
+        for (uint16_t i = 0; i < pool->count; ++i) {
+            uint16_t expected = 0;
+            if (XF_VFS_ATOMIC_REF_LOAD(&pool->used[i]) == 0
+                    && XF_VFS_ATOMIC_REF_CAS(&pool->used[i], &expected, 1)) {
+                counter_inc(&pool->in_use, &pool->peak);
+                return pool->mem + (size_t)i * pool->block_size;
+            }
+        }
+    }
+    XF_VFS_ATOMIC_REF_INC(&pool->fails);
+    return NULL;
+}
+
+void xf_vfs_pool_free(xf_vfs_pool_t *pool, void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    const size_t i = (size_t)((uint8_t *)ptr - pool->mem) / pool->block_size;
+    XF_VFS_ATOMIC_REF_DEC(&pool->in_use);
+    XF_VFS_ATOMIC_REF_STORE(&pool->used[i], 0);
+}
+
+void xf_vfs_pool_get_stats(xf_vfs_pool_t *pool, xf_vfs_pool_stats_t *stats)
+{
+    stats->block_size = pool->block_size;
+    stats->count = pool->count;
+    stats->used = XF_VFS_ATOMIC_REF_LOAD(&pool->in_use);
+    stats->peak = XF_VFS_ATOMIC_REF_LOAD(&pool->peak);
+    stats->fails = XF_VFS_ATOMIC_REF_LOAD(&pool->fails);
+}
+
+void xf_vfs_heap_get_stats(xf_vfs_mem_stats_t *stats)
+{
+    stats->heap_used = XF_VFS_ATOMIC_REF_LOAD(&s_heap_used);
+    stats->heap_peak = XF_VFS_ATOMIC_REF_LOAD(&s_heap_peak);
+    stats->heap_fails = XF_VFS_ATOMIC_REF_LOAD(&s_heap_fails);
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static void *default_alloc(size_t size, void *ctx)
+{
+#if XF_VFS_NO_HEAP_IS_ENABLE
+    return NULL;
+#else
+    return xf_malloc(size);
+#endif
+}
+
+static void default_dealloc(void *ptr, void *ctx)
+{
+#if !XF_VFS_NO_HEAP_IS_ENABLE
+    xf_free(ptr);
+#endif
+}
+
+/* 计数加一并更新峰值 */
+static void counter_inc(uint16_t *counter, uint16_t *peak)
+{
+    const uint16_t now = XF_VFS_ATOMIC_REF_INC(counter);
+    uint16_t old = XF_VFS_ATOMIC_REF_LOAD(peak);
+    while (old < now && !XF_VFS_ATOMIC_REF_CAS(peak, &old, now)) {
+    }
+}
@@ -0,0 +1,111 @@
+/**
+ * @file xf_vfs_mem.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs 内部内存分配：可替换的分配器、无堆模式的固定内存池及使用统计。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __XF_VFS_MEM_H__
+#define __XF_VFS_MEM_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs_config_internal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @cond (XFAPI_USER || XFAPI_PORT || XFAPI_INTERNAL)
+ * @addtogroup group_xf_vfs
+ * @endcond
+ * @{
+ */
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief xf_vfs 使用的分配器。
+ */
+typedef struct {
+    void *(*alloc)(size_t size, void *ctx);     /*!< 失败返回 NULL */
+    void (*dealloc)(void *ptr, void *ctx);      /*!< ptr 可能为 NULL */
+    void *ctx;                                  /*!< 传给 alloc/dealloc 的参数 */
+} xf_vfs_allocator_t;
+
+/**
+ * @brief 一个固定内存池的使用情况。
+ */
+typedef struct {
+    size_t block_size;          /*!< 每块的字节数 */
+    uint32_t count;             /*!< 总块数 */
+    uint32_t used;              /*!< 当前已分配的块数 */
+    uint32_t peak;              /*!< used 的历史最大值 */
+    uint32_t fails;             /*!< 内存池已满或请求大于块大小而失败的次数 */
+} xf_vfs_pool_stats_t;
+
+/**
+ * @brief xf_vfs 的内存使用情况，见 xf_vfs_get_mem_stats().
+ */
+typedef struct {
+    uint32_t heap_used;         /*!< 通过分配器分配且尚未释放的块数 */
+    uint32_t heap_peak;         /*!< heap_used 的历史最大值 */
+    uint32_t heap_fails;        /*!< 分配器返回 NULL 的次数 */
+    xf_vfs_pool_stats_t entry;  /*!< 挂载点，无堆模式下有效 */
+    xf_vfs_pool_stats_t ops;    /*!< 驱动函数表副本，无堆模式下有效 */
+    xf_vfs_pool_stats_t dirat;  /*!< 目录句柄，无堆模式下有效 */
+    xf_vfs_pool_stats_t path;   /*!< 路径句柄，无堆模式下有效 */
+    xf_vfs_pool_stats_t select_waiter;  /*!< select 等待线程，无堆模式下有效 */
+} xf_vfs_mem_stats_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 设置 xf_vfs 使用的分配器。
+ *
+ * 须在第一次分配之前（注册任何挂载点之前）调用，
+ * 之前分配的内存会交给新的分配器释放。
+ *
+ * @param allocator 分配器，内容会被复制；NULL 恢复默认分配器
+ *                  （xf_malloc()/xf_free()，无堆模式下总是分配失败）。
+ */
+void xf_vfs_set_allocator(const xf_vfs_allocator_t *allocator);
+
+/**
+ * @brief 通过当前分配器分配内存，供 xf_vfs 及其驱动使用。
+ *
+ * @return 失败返回 NULL.
+ */
+void *xf_vfs_malloc(size_t size);
+
+/**
+ * @brief 释放 xf_vfs_malloc() 分配的内存，ptr 可以为 NULL.
+ */
+void xf_vfs_free(void *ptr);
+
+/**
+ * @brief 取得 xf_vfs 的内存使用情况。
+ *
+ * @param stats 输出。
+ */
+void xf_vfs_get_mem_stats(xf_vfs_mem_stats_t *stats);
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * End of addtogroup group_xf_vfs
+ * @}
+ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __XF_VFS_MEM_H__ */
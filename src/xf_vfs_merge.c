@@ -0,0 +1,528 @@
+/**
+ * @file xf_vfs_merge.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs pwrite 合并调度。
+ * @version 1.0
+ * @date 2025-01-24
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs_merge.h"
+#include "xf_vfs_private.h"
+
+#if XF_VFS_MERGE_IS_ENABLE
+
+#include "xf_osal.h"
+
+/* ==================== [Defines] =========================================== */
+
+#if !defined(STATIC_ASSERT)
+#   define STATIC_ASSERT(EXPR, ...)     extern char (*_do_assert(void)) [sizeof(char[1 - 2*!(EXPR)])]
+#endif
+
+/* 占用的信号量以位掩码记录 */
+STATIC_ASSERT(XF_VFS_MERGE_BATCH_MAX >= 1 && XF_VFS_MERGE_BATCH_MAX <= 32, "invalid XF_VFS_MERGE_BATCH_MAX");
+
+#define SLOTS_FULL              ((uint32_t)(((uint64_t)1 << XF_VFS_MERGE_BATCH_MAX) - 1))
+
+/* ==================== [Typedefs] ========================================== */
+
+/* 一次 pwrite 请求，位于调用者的栈上 */
+typedef struct _merge_req_t {
+    struct _merge_req_t *next;
+    int fd;
+    uintptr_t key;              /*!< 驱动文件：local fd，XF_VFS_FLAG_HANDLE 挂载点上为句柄 */
+    const void *src;
+    size_t size;
+    xf_vfs_off64_t offset;
+    uint64_t queued_ns;
+    xf_vfs_ssize_t ret;
+    int err;
+    uint8_t slot;               /*!< 等待用的信号量 */
+    uint8_t run;                /*!< 下发时所在的合并段 */
+} merge_req_t;
+
+typedef struct {
+    xf_lock_t lock;
+    uint32_t users;             /*!< 正在使用本结构的 pwrite 数，由 s_lock 保护 */
+    bool retired;               /*!< 已关闭，最后一个 pwrite 返回时释放 */
+    uint32_t deadline_ticks;
+    uint32_t max_bytes;
+    merge_req_t *head;          /*!< 排队的请求，按排队顺序 */
+    merge_req_t **tail;
+    uint8_t leader_slot;        /*!< 负责下发本批次的请求的信号量 */
+    bool collecting;            /*!< 有请求在等待截止时间 */
+    bool kicked;                /*!< 批次已满，已唤醒 leader_slot */
+    uint32_t slots_used;
+    xf_osal_semaphore_t sem[XF_VFS_MERGE_BATCH_MAX];
+    xf_vfs_merge_stats_t stats;
+} merge_mount_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static bool merge_lock_init(void);
+static merge_mount_t *merge_get(int vfs_index);
+static void merge_put(merge_mount_t *m);
+static void merge_retire(int vfs_index);
+static merge_mount_t *merge_create(void);
+static void merge_destroy(merge_mount_t *m);
+static void merge_configure(merge_mount_t *m, const xf_vfs_merge_config_t *config);
+static void merge_slot_free(merge_mount_t *m, uint8_t slot);
+static xf_vfs_ssize_t merge_direct(merge_mount_t *m, int fd, const void *src, size_t size, xf_vfs_off64_t offset);
+static void merge_flush(merge_mount_t *m, merge_req_t *list, const merge_req_t *self, uint32_t max_bytes);
+static uint32_t merge_issue_run(merge_req_t **reqs, size_t n, merge_req_t **run, size_t count);
+static uint32_t merge_issue_one(merge_req_t *req);
+
+/* ==================== [Static Variables] ================================== */
+
+/* 保护 s_mounts 与各挂载点的 users */
+static xf_lock_t s_lock = NULL;
+static merge_mount_t *s_mounts[XF_VFS_MAX_COUNT];
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+xf_err_t xf_vfs_merge_set(const char *path, const xf_vfs_merge_config_t *config)
+{
+    if (path == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+    const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(path);
+    if (vfs == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+    if (config == NULL) {
+        merge_retire(vfs->offset);
+        return XF_OK;
+    }
+    if (!merge_lock_init()) {
+        return XF_ERR_NO_MEM;
+    }
+    merge_mount_t *m = merge_get(vfs->offset);
+    if (m == NULL) {
+        merge_mount_t *created = merge_create();
+        if (created == NULL) {
+            return XF_ERR_NO_MEM;
+        }
+        merge_configure(created, config);
+        xf_lock_lock(s_lock);
+        if (s_mounts[vfs->offset] == NULL) {
+            s_mounts[vfs->offset] = created;
+            created = NULL;
+        }
+        xf_lock_unlock(s_lock);
+        /* 同时有其他线程开启了合并时以它为准 */
+        merge_destroy(created);
+        return XF_OK;
+    }
+    xf_lock_lock(m->lock);
+    merge_configure(m, config);
+    xf_lock_unlock(m->lock);
+    merge_put(m);
+    return XF_OK;
+}
+
+xf_err_t xf_vfs_merge_get_stats(const char *path, xf_vfs_merge_stats_t *stats, bool reset)
+{
+    if (path == NULL || stats == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+    const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(path);
+    if (vfs == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+    merge_mount_t *m = merge_get(vfs->offset);
+    if (m == NULL) {
+        return XF_ERR_INVALID_STATE;
+    }
+    xf_lock_lock(m->lock);
+    *stats = m->stats;
+    if (reset) {
+        xf_memset(&m->stats, 0, sizeof(m->stats));
+    }
+    xf_lock_unlock(m->lock);
+    merge_put(m);
+    return XF_OK;
+}
+
+bool xf_vfs_merge_active(int vfs_index)
+{
+    return vfs_index >= 0 && vfs_index < XF_VFS_MAX_COUNT && s_mounts[vfs_index] != NULL;
+}
+
+xf_vfs_ssize_t xf_vfs_merge_pwrite(int vfs_index, int fd, uintptr_t key,
+                                   const void *src, size_t size, xf_vfs_off64_t offset)
+{
+    merge_mount_t *m = merge_get(vfs_index);
+    if (m == NULL) {
+        /* 检查 xf_vfs_merge_active() 之后合并被关闭 */
+        return xf_vfs_pwrite_driver(fd, src, size, offset);
+    }
+
+    merge_req_t req = {
+        .next = NULL,
+        .fd = fd,
+        .key = key,
+        .src = src,
+        .size = size,
+        .offset = offset,
+        .queued_ns = XF_VFS_MERGE_TIME_NS(),
+    };
+
+    xf_lock_lock(m->lock);
+    if (size == 0 || size >= m->max_bytes || m->slots_used == SLOTS_FULL) {
+        /* 过大的请求，或之前批次的请求还未取走结果 */
+        xf_lock_unlock(m->lock);
+        const xf_vfs_ssize_t ret = merge_direct(m, fd, src, size, offset);
+        merge_put(m);
+        return ret;
+    }
+    uint8_t slot = 0;
+    while (m->slots_used & (1u << slot)) {
+        ++slot;
+    }
+    m->slots_used |= 1u << slot;
+    req.slot = slot;
+    *m->tail = &req;
+    m->tail = &req.next;
+
+    const bool leader = !m->collecting;
+    if (leader) {
+        m->collecting = true;
+        m->kicked = false;
+        m->leader_slot = slot;
+    } else if (m->slots_used == SLOTS_FULL && !m->kicked) {
+        /* 批次已满，不再等待截止时间 */
+        m->kicked = true;
+        xf_osal_semaphore_release(m->sem[m->leader_slot]);
+    }
+    const uint32_t deadline_ticks = m->deadline_ticks;
+    xf_lock_unlock(m->lock);
+
+    if (!leader) {
+        xf_osal_semaphore_acquire(m->sem[slot], XF_OSAL_WAIT_FOREVER);
+        merge_slot_free(m, slot);
+        merge_put(m);
+        if (req.ret < 0) {
+            errno = req.err;
+        }
+        return req.ret;
+    }
+
+    const xf_err_t woken = xf_osal_semaphore_acquire(m->sem[slot], deadline_ticks);
+    xf_lock_lock(m->lock);
+    if (woken != XF_OK && m->kicked) {
+        /* 超时与批次排满同时发生，取走多余的计数 */
+        xf_osal_semaphore_acquire(m->sem[slot], 0);
+    }
+    merge_req_t *list = m->head;
+    m->head = NULL;
+    m->tail = &m->head;
+    m->collecting = false;
+    const uint32_t max_bytes = m->max_bytes;
+    xf_lock_unlock(m->lock);
+
+    merge_flush(m, list, &req, max_bytes);
+    merge_slot_free(m, slot);
+    merge_put(m);
+    if (req.ret < 0) {
+        errno = req.err;
+    }
+    return req.ret;
+}
+
+void xf_vfs_merge_forget(int vfs_index)
+{
+    if (vfs_index < 0 || vfs_index >= XF_VFS_MAX_COUNT) {
+        return;
+    }
+    merge_retire(vfs_index);
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static bool merge_lock_init(void)
+{
+    if (s_lock == NULL) {
+        xf_lock_init(&s_lock);
+    }
+    return s_lock != NULL;
+}
+
+/* 取得挂载点的合并状态并增加引用，未开启时返回 NULL */
+static merge_mount_t *merge_get(int vfs_index)
+{
+    if (s_lock == NULL) {
+        return NULL;
+    }
+    xf_lock_lock(s_lock);
+    merge_mount_t *m = s_mounts[vfs_index];
+    if (m != NULL) {
+        ++m->users;
+    }
+    xf_lock_unlock(s_lock);
+    return m;
+}
+
+static void merge_put(merge_mount_t *m)
+{
+    xf_lock_lock(s_lock);
+    const bool last = (--m->users == 0) && m->retired;
+    xf_lock_unlock(s_lock);
+    if (last) {
+        merge_destroy(m);
+    }
+}
+
+/* 关闭挂载点的合并，正在排队的请求立即下发，最后一个返回的请求释放状态 */
+static void merge_retire(int vfs_index)
+{
+    if (s_lock == NULL) {
+        return;
+    }
+    xf_lock_lock(s_lock);
+    merge_mount_t *m = s_mounts[vfs_index];
+    s_mounts[vfs_index] = NULL;
+    const bool idle = (m != NULL) && (m->users == 0);
+    if (m != NULL) {
+        m->retired = true;
+        /* 不再等待截止时间 */
+        xf_lock_lock(m->lock);
+        if (m->collecting && !m->kicked) {
+            m->kicked = true;
+            xf_osal_semaphore_release(m->sem[m->leader_slot]);
+        }
+        xf_lock_unlock(m->lock);
+    }
+    xf_lock_unlock(s_lock);
+    if (idle) {
+        merge_destroy(m);
+    }
+}
+
+static merge_mount_t *merge_create(void)
+{
+    merge_mount_t *m = xf_vfs_malloc(sizeof(merge_mount_t));
+    if (m == NULL) {
+        return NULL;
+    }
+    xf_memset(m, 0, sizeof(merge_mount_t));
+    m->tail = &m->head;
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "merge",
+    };
+    for (int i = 0; i < XF_VFS_MERGE_BATCH_MAX; ++i) {
+        m->sem[i] = xf_osal_semaphore_create(1, 0, &sem_attr);
+        if (m->sem[i] == NULL) {
+            merge_destroy(m);
+            return NULL;
+        }
+    }
+    if (xf_lock_init(&m->lock) != XF_OK) {
+        merge_destroy(m);
+        return NULL;
+    }
+    return m;
+}
+
+static void merge_destroy(merge_mount_t *m)
+{
+    if (m == NULL) {
+        return;
+    }
+    for (int i = 0; i < XF_VFS_MERGE_BATCH_MAX; ++i) {
+        if (m->sem[i] != NULL) {
+            xf_osal_semaphore_delete(m->sem[i]);
+        }
+    }
+    if (m->lock != NULL) {
+        xf_lock_destroy(m->lock);
+    }
+    xf_vfs_free(m);
+}
+
+static void merge_configure(merge_mount_t *m, const xf_vfs_merge_config_t *config)
+{
+    const uint32_t us = (config->deadline_us != 0) ? config->deadline_us : XF_VFS_MERGE_DEADLINE_US;
+    const uint32_t ticks = xf_osal_kernel_ms_to_ticks((us + 999) / 1000);
+    m->deadline_ticks = (ticks != 0) ? ticks : 1;
+    m->max_bytes = (config->max_bytes != 0) ? config->max_bytes : XF_VFS_MERGE_MAX_BYTES;
+}
+
+static void merge_slot_free(merge_mount_t *m, uint8_t slot)
+{
+    xf_lock_lock(m->lock);
+    m->slots_used &= ~(1u << slot);
+    xf_lock_unlock(m->lock);
+}
+
+/* 不排队的请求 */
+static xf_vfs_ssize_t merge_direct(merge_mount_t *m, int fd, const void *src, size_t size, xf_vfs_off64_t offset)
+{
+    const xf_vfs_ssize_t ret = xf_vfs_pwrite_driver(fd, src, size, offset);
+    const int err = errno;
+    xf_lock_lock(m->lock);
+    ++m->stats.requests;
+    ++m->stats.driver_calls;
+    m->stats.bytes += size;
+    xf_lock_unlock(m->lock);
+    errno = err;
+    return ret;
+}
+
+/*
+ * 下发一个批次：按 (驱动文件, 偏移) 排序，把相邻（合并后不超过 max_bytes）
+ * 或重叠的请求分为一段，每段一次驱动调用，然后唤醒 self 以外的请求。
+ */
+static void merge_flush(merge_mount_t *m, merge_req_t *list, const merge_req_t *self, uint32_t max_bytes)
+{
+    merge_req_t *reqs[XF_VFS_MERGE_BATCH_MAX];
+    merge_req_t *sorted[XF_VFS_MERGE_BATCH_MAX];
+    size_t n = 0;
+    for (merge_req_t *r = list; r != NULL; r = r->next) {
+        reqs[n] = r;
+        /* 插入排序，相同位置保持排队顺序 */
+        size_t i = n;
+        while (i > 0 && (sorted[i - 1]->key > r->key
+                         || (sorted[i - 1]->key == r->key && sorted[i - 1]->offset > r->offset))) {
+            sorted[i] = sorted[i - 1];
+            --i;
+        }
+        sorted[i] = r;
+        ++n;
+    }
+
+    /* 先分段，下发时按段号找出段内的请求 */
+    size_t bounds[XF_VFS_MERGE_BATCH_MAX + 1];
+    size_t runs = 0;
+    for (size_t i = 0; i < n;) {
+        const xf_vfs_off64_t start = sorted[i]->offset;
+        xf_vfs_off64_t end = start + (xf_vfs_off64_t)sorted[i]->size;
+        size_t j = i + 1;
+        for (; j < n && sorted[j]->key == sorted[i]->key; ++j) {
+            const xf_vfs_off64_t rs = sorted[j]->offset;
+            const xf_vfs_off64_t re = rs + (xf_vfs_off64_t)sorted[j]->size;
+            const bool overlap = rs < end;
+            const bool adjacent = (rs == end) && (re - start <= (xf_vfs_off64_t)max_bytes);
+            if (!overlap && !adjacent) {
+                break;
+            }
+            if (re > end) {
+                end = re;
+            }
+        }
+        for (size_t k = i; k < j; ++k) {
+            sorted[k]->run = (uint8_t)runs;
+        }
+        bounds[runs++] = i;
+        i = j;
+    }
+    bounds[runs] = n;
+
+    const uint64_t issue_ns = XF_VFS_MERGE_TIME_NS();
+    uint32_t calls = 0;
+    uint32_t merged = 0;
+    for (size_t r = 0; r < runs; ++r) {
+        const size_t count = bounds[r + 1] - bounds[r];
+        calls += merge_issue_run(reqs, n, &sorted[bounds[r]], count);
+        if (count > 1) {
+            merged += (uint32_t)count;
+        }
+    }
+
+    xf_lock_lock(m->lock);
+    xf_vfs_merge_stats_t *st = &m->stats;
+    st->requests += (uint32_t)n;
+    st->driver_calls += calls;
+    st->merged += merged;
+    ++st->batches;
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t wait_us = (uint32_t)((issue_ns - reqs[i]->queued_ns) / 1000);
+        st->wait_us += wait_us;
+        if (wait_us > st->max_wait_us) {
+            st->max_wait_us = wait_us;
+        }
+        st->bytes += reqs[i]->size;
+    }
+    xf_lock_unlock(m->lock);
+
+    /* 唤醒后请求所在的栈可能立即失效，之后不能再访问 */
+    for (size_t i = 0; i < n; ++i) {
+        if (reqs[i] != self) {
+            xf_osal_semaphore_release(m->sem[reqs[i]->slot]);
+        }
+    }
+}
+
+/* 下发一段（按偏移排序的 run[0..count)，reqs 为整个批次），返回驱动调用数 */
+static uint32_t merge_issue_run(merge_req_t **reqs, size_t n, merge_req_t **run, size_t count)
+{
+    if (count == 1) {
+        return merge_issue_one(run[0]);
+    }
+
+    const uint8_t run_index = run[0]->run;
+    const xf_vfs_off64_t start = run[0]->offset;
+    xf_vfs_off64_t end = start;
+    for (size_t i = 0; i < count; ++i) {
+        const xf_vfs_off64_t re = run[i]->offset + (xf_vfs_off64_t)run[i]->size;
+        end = (re > end) ? re : end;
+    }
+    const size_t len = (size_t)(end - start);
+    uint8_t *buf = xf_vfs_malloc(len);
+    uint32_t calls = 0;
+    if (buf == NULL) {
+        /* 无法合并时按排队顺序逐个下发 */
+        for (size_t i = 0; i < n; ++i) {
+            if (reqs[i]->run == run_index) {
+                calls += merge_issue_one(reqs[i]);
+            }
+        }
+        return calls;
+    }
+
+    /* 按排队顺序复制，重叠部分以后排队的请求为准 */
+    for (size_t i = 0; i < n; ++i) {
+        merge_req_t *r = reqs[i];
+        if (r->run == run_index) {
+            xf_memcpy(buf + (size_t)(r->offset - start), r->src, r->size);
+        }
+    }
+    const xf_vfs_ssize_t ret = xf_vfs_pwrite_driver(run[0]->fd, buf, len, start);
+    const int err = errno;
+    xf_vfs_free(buf);
+    calls = 1;
+
+    for (size_t i = 0; i < count; ++i) {
+        merge_req_t *r = run[i];
+        if (ret < 0) {
+            r->ret = -1;
+            r->err = err;
+            continue;
+        }
+        /* 只写入一部分时，本请求已写入的字节数 */
+        const xf_vfs_off64_t covered = (xf_vfs_off64_t)ret - (r->offset - start);
+        if (covered >= (xf_vfs_off64_t)r->size) {
+            r->ret = (xf_vfs_ssize_t)r->size;
+        } else if (covered > 0) {
+            r->ret = (xf_vfs_ssize_t)covered;
+        } else {
+            calls += merge_issue_one(r);
+        }
+    }
+    return calls;
+}
+
+static uint32_t merge_issue_one(merge_req_t *req)
+{
+    req->ret = xf_vfs_pwrite_driver(req->fd, req->src, req->size, req->offset);
+    req->err = errno;
+    return 1;
+}
+
+#endif /* XF_VFS_MERGE_IS_ENABLE */
@@ -0,0 +1,117 @@
+/**
+ * @file xf_vfs_merge.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs pwrite 合并调度。
+ *        开启后，挂载点上的 xf_vfs_pwrite() 先短暂排队，
+ *        同一文件上相邻或重叠的请求按偏移排序并合并为一次驱动调用，
+ *        减少 flash 等设备上小块写入引起的擦写次数。
+ * @version 1.0
+ * @date 2025-01-24
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __XF_VFS_MERGE_H__
+#define __XF_VFS_MERGE_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @cond (XFAPI_USER || XFAPI_PORT || XFAPI_INTERNAL)
+ * @addtogroup group_xf_vfs
+ * @endcond
+ * @{
+ */
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 合并调度的参数。
+ */
+typedef struct {
+    /**
+     * 第一个请求排队后最多等待多久（us）再下发，0 为 XF_VFS_MERGE_DEADLINE_US.
+     * 按系统节拍向上取整，即每个请求增加的延迟不超过约一个截止时间。
+     */
+    uint32_t deadline_us;
+    /**
+     * 相邻请求合并后的最大字节数，0 为 XF_VFS_MERGE_MAX_BYTES.
+     * 不小于此大小的请求不排队，直接下发；重叠的请求总是合并。
+     */
+    uint32_t max_bytes;
+} xf_vfs_merge_config_t;
+
+/**
+ * @brief 合并调度的统计。合并率为 1 - driver_calls / requests.
+ */
+typedef struct {
+    uint32_t requests;          /*!< 经过调度的 pwrite 调用数 */
+    uint32_t driver_calls;      /*!< 下发到驱动的 pwrite 调用数 */
+    uint32_t merged;            /*!< 与其他请求合并下发的请求数 */
+    uint32_t batches;           /*!< 下发的批次数 */
+    uint32_t max_wait_us;       /*!< 单个请求最长的排队时间（us） */
+    uint64_t wait_us;           /*!< 排队时间的总和（us），即合并增加的延迟 */
+    uint64_t bytes;             /*!< 请求的字节数 */
+} xf_vfs_merge_stats_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+#if XF_VFS_MERGE_IS_ENABLE || defined(__DOXYGEN__)
+
+/**
+ * @brief 开启或关闭挂载点上的 pwrite 合并调度。
+ *
+ * 只调度 xf_vfs_pwrite()/xf_vfs_pwrite64(). 第一个排队的请求所在的线程等待截止时间
+ * 或批次排满后，把同一批次中同一驱动文件（local fd 或句柄相同，包括 dup 出的 fd）上
+ * 相邻或重叠的请求合并下发，重叠部分以后排队的请求为准，然后唤醒其他请求的线程。
+ * 每个调用者得到自己请求的结果：合并的调用失败时均返回 -1 与相同的 errno，
+ * 合并的调用只写入一部分时，未写入的请求单独重新下发。
+ *
+ * @note 关闭时已排队的请求立即合并下发，之后的 pwrite 直接调用驱动；
+ *       修改参数只影响之后排队的批次。
+ *
+ * @param path   挂载点内的任意路径，如 "/flash".
+ * @param config 参数，NULL 为关闭。
+ *
+ * @return  XF_OK if successful.
+ *          XF_ERR_INVALID_ARG if no mount matches path.
+ *          XF_ERR_NO_MEM if out of memory.
+ */
+xf_err_t xf_vfs_merge_set(const char *path, const xf_vfs_merge_config_t *config);
+
+/**
+ * @brief 获取挂载点的合并调度统计。
+ *
+ * @param path  挂载点内的任意路径。
+ * @param stats 输出。
+ * @param reset 是否在获取后清零。
+ *
+ * @return  XF_OK if successful.
+ *          XF_ERR_INVALID_ARG if no mount matches path.
+ *          XF_ERR_INVALID_STATE if merging is not enabled on the mount.
+ */
+xf_err_t xf_vfs_merge_get_stats(const char *path, xf_vfs_merge_stats_t *stats, bool reset);
+
+#endif /* XF_VFS_MERGE_IS_ENABLE || defined(__DOXYGEN__) */
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * End of addtogroup group_xf_vfs
+ * @}
+ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __XF_VFS_MERGE_H__ */
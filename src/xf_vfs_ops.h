@@ -83,6 +83,22 @@ typedef              int (*xf_vfs_ftruncate_ctx_op_t) (void *ctx, int fd, xf_vfs
 typedef              int (*xf_vfs_ftruncate_op_t)     (           int fd, xf_vfs_off_t length);                         /*!< ftruncate without context pointer */
 typedef              int (*xf_vfs_utime_ctx_op_t)     (void *ctx, const char *path, const xf_vfs_utimbuf_t *times);     /*!< utime with context pointer */
 typedef              int (*xf_vfs_utime_op_t)         (           const char *path, const xf_vfs_utimbuf_t *times);     /*!< utime without context pointer */
+typedef              int (*xf_vfs_truncate64_ctx_op_t)  (void *ctx, const char *path, xf_vfs_off64_t length);           /*!< 64-bit truncate with context pointer */
+typedef              int (*xf_vfs_truncate64_op_t)      (           const char *path, xf_vfs_off64_t length);           /*!< 64-bit truncate without context pointer */
+typedef              int (*xf_vfs_ftruncate64_ctx_op_t) (void *ctx, int fd, xf_vfs_off64_t length);                     /*!< 64-bit ftruncate with context pointer */
+typedef              int (*xf_vfs_ftruncate64_op_t)     (           int fd, xf_vfs_off64_t length);                     /*!< 64-bit ftruncate without context pointer */
+typedef   xf_vfs_ssize_t (*xf_vfs_getdents_ctx_op_t)    (void *ctx, xf_vfs_dir_t *pdir, void *buf, size_t len);          /*!< getdents with context pointer */
+typedef   xf_vfs_ssize_t (*xf_vfs_getdents_op_t)        (           xf_vfs_dir_t *pdir, void *buf, size_t len);          /*!< getdents without context pointer */
+typedef              int (*xf_vfs_statx_ctx_op_t)       (void *ctx, const char *path, uint32_t mask, xf_vfs_statx_t *stx); /*!< statx with context pointer */
+typedef              int (*xf_vfs_statx_op_t)           (           const char *path, uint32_t mask, xf_vfs_statx_t *stx); /*!< statx without context pointer */
+typedef              int (*xf_vfs_openat_ctx_op_t)      (void *ctx, xf_vfs_dir_t *pdir, const char *name, int flags, int mode); /*!< openat with context pointer */
+typedef              int (*xf_vfs_openat_op_t)          (           xf_vfs_dir_t *pdir, const char *name, int flags, int mode); /*!< openat without context pointer */
+typedef              int (*xf_vfs_fstatat_ctx_op_t)     (void *ctx, xf_vfs_dir_t *pdir, const char *name, xf_vfs_stat_t *st);  /*!< fstatat with context pointer */
+typedef              int (*xf_vfs_fstatat_op_t)         (           xf_vfs_dir_t *pdir, const char *name, xf_vfs_stat_t *st);  /*!< fstatat without context pointer */
+typedef              int (*xf_vfs_unlinkat_ctx_op_t)    (void *ctx, xf_vfs_dir_t *pdir, const char *name, int flags);          /*!< unlinkat with context pointer */
+typedef              int (*xf_vfs_unlinkat_op_t)        (           xf_vfs_dir_t *pdir, const char *name, int flags);          /*!< unlinkat without context pointer */
+typedef              int (*xf_vfs_mkdirat_ctx_op_t)     (void *ctx, xf_vfs_dir_t *pdir, const char *name, xf_vfs_mode_t mode); /*!< mkdirat with context pointer */
+typedef              int (*xf_vfs_mkdirat_op_t)         (           xf_vfs_dir_t *pdir, const char *name, xf_vfs_mode_t mode); /*!< mkdirat without context pointer */
 
 /**
  * @brief Struct containing function pointers to directory related functionality.
@@ -152,6 +168,44 @@ typedef struct {
         const xf_vfs_utime_ctx_op_t     utime_p;     /*!< utime with context pointer */
         const xf_vfs_utime_op_t         utime;       /*!< utime without context pointer */
     };
+    union {
+        const xf_vfs_truncate64_ctx_op_t  truncate64_p;  /*!< 64-bit truncate with context pointer, truncate is used if NULL */
+        const xf_vfs_truncate64_op_t      truncate64;    /*!< 64-bit truncate without context pointer */
+    };
+    union {
+        const xf_vfs_ftruncate64_ctx_op_t ftruncate64_p; /*!< 64-bit ftruncate with context pointer, ftruncate is used if NULL */
+        const xf_vfs_ftruncate64_op_t     ftruncate64;   /*!< 64-bit ftruncate without context pointer */
+    };
+    union {
+        const xf_vfs_getdents_ctx_op_t    getdents_p;    /*!< getdents with context pointer, readdir is used if NULL */
+        const xf_vfs_getdents_op_t        getdents;      /*!< getdents without context pointer */
+    };
+    union {
+        const xf_vfs_statx_ctx_op_t       statx_p;       /*!< statx with context pointer, stat is used if NULL */
+        const xf_vfs_statx_op_t           statx;         /*!< statx without context pointer */
+    };
+
+    /*
+     * 相对目录的操作，可选，见 xf_vfs_dirat_open().
+     * pdir 为驱动 opendir 返回的目录，name 是相对于它的路径。
+     * 为 NULL 时 VFS 拼接出完整路径后调用 open/stat/unlink/rmdir/mkdir.
+     */
+    union {
+        const xf_vfs_openat_ctx_op_t      openat_p;      /*!< openat with context pointer, not used in handle mode */
+        const xf_vfs_openat_op_t          openat;        /*!< openat without context pointer */
+    };
+    union {
+        const xf_vfs_fstatat_ctx_op_t     fstatat_p;     /*!< fstatat with context pointer */
+        const xf_vfs_fstatat_op_t         fstatat;       /*!< fstatat without context pointer */
+    };
+    union {
+        const xf_vfs_unlinkat_ctx_op_t    unlinkat_p;    /*!< unlinkat with context pointer, flags may contain XF_VFS_AT_REMOVEDIR */
+        const xf_vfs_unlinkat_op_t        unlinkat;      /*!< unlinkat without context pointer */
+    };
+    union {
+        const xf_vfs_mkdirat_ctx_op_t     mkdirat_p;     /*!< mkdirat with context pointer */
+        const xf_vfs_mkdirat_op_t         mkdirat;       /*!< mkdirat without context pointer */
+    };
 } xf_vfs_dir_ops_t;
 
 /* *INDENT-ON* */
@@ -181,6 +235,71 @@ typedef            int (*xf_vfs_ioctl_ctx_op_t)  (void *ctx, int fd, int cmd, va
 typedef            int (*xf_vfs_ioctl_op_t)      (           int fd, int cmd, va_list args);                        /*!< ioctl without context pointer */
 typedef            int (*xf_vfs_fsync_ctx_op_t)  (void *ctx, int fd);                                               /*!< fsync with context pointer */
 typedef            int (*xf_vfs_fsync_op_t)      (           int fd);                                               /*!< fsync without context pointer */
+typedef xf_vfs_off64_t (*xf_vfs_lseek64_ctx_op_t)  (void *ctx, int fd, xf_vfs_off64_t size, int mode);                    /*!< 64-bit seek with context pointer */
+typedef xf_vfs_off64_t (*xf_vfs_lseek64_op_t)      (           int fd, xf_vfs_off64_t size, int mode);                    /*!< 64-bit seek without context pointer */
+typedef xf_vfs_ssize_t (*xf_vfs_pread64_ctx_op_t)  (void *ctx, int fd, void *dst, size_t size, xf_vfs_off64_t offset);       /*!< 64-bit pread with context pointer */
+typedef xf_vfs_ssize_t (*xf_vfs_pread64_op_t)      (           int fd, void *dst, size_t size, xf_vfs_off64_t offset);       /*!< 64-bit pread without context pointer */
+typedef xf_vfs_ssize_t (*xf_vfs_pwrite64_ctx_op_t) (void *ctx, int fd, const void *src, size_t size, xf_vfs_off64_t offset); /*!< 64-bit pwrite with context pointer */
+typedef xf_vfs_ssize_t (*xf_vfs_pwrite64_op_t)     (           int fd, const void *src, size_t size, xf_vfs_off64_t offset); /*!< 64-bit pwrite without context pointer */
+typedef            int (*xf_vfs_fstat64_ctx_op_t)  (void *ctx, int fd, xf_vfs_stat64_t *st);                              /*!< 64-bit fstat with context pointer */
+typedef            int (*xf_vfs_fstat64_op_t)      (           int fd, xf_vfs_stat64_t *st);                              /*!< 64-bit fstat without context pointer */
+typedef            int (*xf_vfs_fstatx_ctx_op_t)   (void *ctx, int fd, uint32_t mask, xf_vfs_statx_t *stx);               /*!< fstatx with context pointer */
+typedef            int (*xf_vfs_fstatx_op_t)       (           int fd, uint32_t mask, xf_vfs_statx_t *stx);               /*!< fstatx without context pointer */
+
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE || defined __DOXYGEN__
+/* *INDENT-OFF* */
+
+typedef          void* (*xf_vfs_handle_open_op_t)     (void *ctx, const char *path, int flags, int mode);               /*!< open, returns NULL and sets errno on failure */
+typedef            int (*xf_vfs_handle_close_op_t)    (void *ctx, void *h);                                             /*!< close */
+typedef xf_vfs_ssize_t (*xf_vfs_handle_write_op_t)    (void *ctx, void *h, const void *data, size_t size);              /*!< write */
+typedef   xf_vfs_off_t (*xf_vfs_handle_lseek_op_t)    (void *ctx, void *h, xf_vfs_off_t size, int mode);                /*!< lseek */
+typedef xf_vfs_ssize_t (*xf_vfs_handle_read_op_t)     (void *ctx, void *h, void *dst, size_t size);                     /*!< read */
+typedef xf_vfs_ssize_t (*xf_vfs_handle_pread_op_t)    (void *ctx, void *h, void *dst, size_t size, xf_vfs_off_t offset);       /*!< pread */
+typedef xf_vfs_ssize_t (*xf_vfs_handle_pwrite_op_t)   (void *ctx, void *h, const void *src, size_t size, xf_vfs_off_t offset); /*!< pwrite */
+typedef            int (*xf_vfs_handle_fstat_op_t)    (void *ctx, void *h, xf_vfs_stat_t *st);                          /*!< fstat */
+typedef            int (*xf_vfs_handle_fcntl_op_t)    (void *ctx, void *h, int cmd, int arg);                           /*!< fcntl */
+typedef            int (*xf_vfs_handle_ioctl_op_t)    (void *ctx, void *h, int cmd, va_list args);                      /*!< ioctl */
+typedef            int (*xf_vfs_handle_fsync_op_t)    (void *ctx, void *h);                                             /*!< fsync */
+typedef            int (*xf_vfs_handle_ftruncate_op_t)(void *ctx, void *h, xf_vfs_off_t length);                        /*!< ftruncate */
+typedef xf_vfs_off64_t (*xf_vfs_handle_lseek64_op_t)  (void *ctx, void *h, xf_vfs_off64_t size, int mode);              /*!< 64-bit lseek */
+typedef xf_vfs_ssize_t (*xf_vfs_handle_pread64_op_t)  (void *ctx, void *h, void *dst, size_t size, xf_vfs_off64_t offset);       /*!< 64-bit pread */
+typedef xf_vfs_ssize_t (*xf_vfs_handle_pwrite64_op_t) (void *ctx, void *h, const void *src, size_t size, xf_vfs_off64_t offset); /*!< 64-bit pwrite */
+typedef            int (*xf_vfs_handle_fstat64_op_t)  (void *ctx, void *h, xf_vfs_stat64_t *st);                        /*!< 64-bit fstat */
+typedef            int (*xf_vfs_handle_ftruncate64_op_t)(void *ctx, void *h, xf_vfs_off64_t length);                    /*!< 64-bit ftruncate */
+
+/**
+ * @brief Struct containing function pointers to file operations of a handle mode driver, see XF_VFS_FLAG_HANDLE.
+ *
+ * The context pointer given at registration is always passed as the first argument,
+ * regardless of XF_VFS_FLAG_CONTEXT_PTR.
+ */
+typedef struct {
+    const xf_vfs_handle_open_op_t      open;      /*!< open, must not be NULL */
+    const xf_vfs_handle_close_op_t     close;     /*!< close */
+    const xf_vfs_handle_write_op_t     write;     /*!< write */
+    const xf_vfs_handle_lseek_op_t     lseek;     /*!< lseek */
+    const xf_vfs_handle_read_op_t      read;      /*!< read */
+    const xf_vfs_handle_pread_op_t     pread;     /*!< pread */
+    const xf_vfs_handle_pwrite_op_t    pwrite;    /*!< pwrite */
+    const xf_vfs_handle_fstat_op_t     fstat;     /*!< fstat */
+    const xf_vfs_handle_fcntl_op_t     fcntl;     /*!< fcntl */
+    const xf_vfs_handle_ioctl_op_t     ioctl;     /*!< ioctl */
+    const xf_vfs_handle_fsync_op_t     fsync;     /*!< fsync */
+    const xf_vfs_handle_ftruncate_op_t ftruncate; /*!< ftruncate */
+
+    /*
+     * 64 位偏移版本，可选。为 NULL 时使用对应的 32 位函数，
+     * 偏移超出 xf_vfs_off_t 的范围时返回 EOVERFLOW.
+     */
+    const xf_vfs_handle_lseek64_op_t     lseek64;     /*!< 64-bit lseek */
+    const xf_vfs_handle_pread64_op_t     pread64;     /*!< 64-bit pread */
+    const xf_vfs_handle_pwrite64_op_t    pwrite64;    /*!< 64-bit pwrite */
+    const xf_vfs_handle_fstat64_op_t     fstat64;     /*!< 64-bit fstat */
+    const xf_vfs_handle_ftruncate64_op_t ftruncate64; /*!< 64-bit ftruncate */
+} xf_vfs_handle_ops_t;
+
+/* *INDENT-ON* */
+#endif
 
 /**
  * @brief Main struct of the minified vfs API, containing basic function pointers as well as pointers to the other subcomponents.
@@ -231,6 +350,36 @@ typedef struct {
         const xf_vfs_fsync_op_t      fsync;    /*!< fsync without context pointer */
     };
 
+    /*
+     * 64 位偏移版本，可选。为 NULL 时使用对应的 32 位函数，
+     * 偏移超出 xf_vfs_off_t 的范围时返回 EOVERFLOW.
+     */
+    union {
+        const xf_vfs_lseek64_ctx_op_t  lseek64_p;  /*!< 64-bit seek with context pointer */
+        const xf_vfs_lseek64_op_t      lseek64;    /*!< 64-bit seek without context pointer */
+    };
+    union {
+        const xf_vfs_pread64_ctx_op_t  pread64_p;  /*!< 64-bit pread with context pointer */
+        const xf_vfs_pread64_op_t      pread64;    /*!< 64-bit pread without context pointer */
+    };
+    union {
+        const xf_vfs_pwrite64_ctx_op_t pwrite64_p; /*!< 64-bit pwrite with context pointer */
+        const xf_vfs_pwrite64_op_t     pwrite64;   /*!< 64-bit pwrite without context pointer */
+    };
+    union {
+        const xf_vfs_fstat64_ctx_op_t  fstat64_p;  /*!< 64-bit fstat with context pointer */
+        const xf_vfs_fstat64_op_t      fstat64;    /*!< 64-bit fstat without context pointer */
+    };
+
+    /*
+     * 只查询部分字段的 fstat，可选。驱动填充 mask 中请求的字段（可以多填），
+     * 并在 stx->stx_mask 中报告实际填充的字段。为 NULL 时使用 fstat64/fstat.
+     */
+    union {
+        const xf_vfs_fstatx_ctx_op_t   fstatx_p;   /*!< fstatx with context pointer */
+        const xf_vfs_fstatx_op_t       fstatx;     /*!< fstatx without context pointer */
+    };
+
 #if XF_VFS_SUPPORT_DIR_IS_ENABLE
     const xf_vfs_dir_ops_t *const dir;         /*!< pointer to the dir subcomponent */
 #endif
@@ -239,6 +388,10 @@ typedef struct {
     const xf_vfs_select_ops_t *const select;   /*!< pointer to the select subcomponent */
 #endif
 
+#if XF_VFS_SUPPORT_HANDLE_IS_ENABLE || defined __DOXYGEN__
+    const xf_vfs_handle_ops_t *const handle;   /*!< pointer to the handle subcomponent, used with XF_VFS_FLAG_HANDLE */
+#endif
+
 } xf_vfs_fs_ops_t;
 
 /* *INDENT-ON* */
@@ -267,6 +420,7 @@ typedef struct {
  *                                     if it is not enabled a deep copy of the provided struct will be created, which will be managed by the VFS component
  *             - XF_VFS_FLAG_CONTEXT_PTR - If set, the VFS will use the context-aware versions of the filesystem operation functions (suffixed with `_p`) in `xf_vfs_fs_ops_t` and its subcomponents.
  *                                          The `ctx` parameter will be passed as the context argument when these functions are invoked.
+ *             - XF_VFS_FLAG_HANDLE - If set, file operations are dispatched to the `handle` subcomponent, which must be provided.
  *
  * @param ctx  Context pointer for fs operation functions, see the XF_VFS_FLAG_CONTEXT_PTR.
  *             Should be `NULL` if not used.
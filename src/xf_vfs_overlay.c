@@ -0,0 +1,1277 @@
+/**
+ * @file xf_vfs_overlay.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs overlay（联合）文件系统驱动。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs_overlay.h"
+#include "xf_vfs_mem.h"
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+
+/* ==================== [Defines] =========================================== */
+
+#define OVL_WH_PREFIX           XF_VFS_OVERLAY_WHITEOUT_PREFIX
+#define OVL_WH_PREFIX_LEN       (sizeof(OVL_WH_PREFIX) - 1)
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef enum {
+    OVL_KIND_LOWER = 0,         /*!< 不在索引中：不存在于上层，交给下层 */
+    OVL_KIND_UPPER_FILE,
+    OVL_KIND_UPPER_DIR,
+    OVL_KIND_WHITEOUT,          /*!< 下层同名文件已被删除 */
+} ovl_kind_t;
+
+typedef struct _ovl_node_t {
+    struct _ovl_node_t *next;
+    uint32_t hash;
+    uint8_t kind;
+    char path[];
+} ovl_node_t;
+
+typedef struct {
+    bool used;
+    bool copy_pending;          /*!< 当前打开的是下层文件，首次写入时需要 copy-up */
+    int fd;                     /*!< 底层挂载点的全局 fd */
+    int retired_fd;             /*!< copy-up 换下的下层 fd，最后一个使用者结束后关闭 */
+    uint16_t users;             /*!< 正在使用 fd 的调用数，见 ovl_file_get() */
+    int flags;                  /*!< 调用者打开时使用的 flags */
+    char *path;                 /*!< overlay 内路径，仅 copy_pending 时有效 */
+} ovl_file_t;
+
+typedef struct {
+    xf_vfs_dir_t base;          /*!< 必须位于首位 */
+    xf_vfs_dir_t *upper;
+    xf_vfs_dir_t *lower;
+    char *path;
+    xf_vfs_dirent_t ent;
+} ovl_dir_t;
+
+typedef struct _ovl_t {
+    struct _ovl_t *next;
+    char *base_path;
+    char *lower;
+    char *upper;
+    xf_lock_t lock;
+    ovl_node_t *index[XF_VFS_OVERLAY_INDEX_BUCKETS];
+    ovl_file_t files[XF_VFS_OVERLAY_FILES_MAX];
+} ovl_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static char *ovl_strdup(const char *s);
+static uint32_t ovl_hash(const char *path);
+static ovl_node_t *ovl_index_find(ovl_t *ovl, const char *path);
+static ovl_kind_t ovl_lookup(ovl_t *ovl, const char *path);
+static int ovl_index_set(ovl_t *ovl, const char *path, ovl_kind_t kind);
+static void ovl_index_remove(ovl_t *ovl, const char *path);
+static void ovl_index_remove_subtree(ovl_t *ovl, const char *path);
+static void ovl_index_free(ovl_t *ovl);
+static int ovl_join(char *buf, const char *base, const char *path);
+static int ovl_child(char *buf, const char *dir, const char *name);
+static int ovl_whiteout_path(char *buf, const char *upper, const char *path);
+static int ovl_scan_upper(ovl_t *ovl, const char *path);
+static bool ovl_lower_exists(ovl_t *ovl, const char *path, bool *is_dir);
+static int ovl_ensure_parents(ovl_t *ovl, const char *path);
+static int ovl_clear_whiteout(ovl_t *ovl, const char *path);
+static int ovl_add_whiteout(ovl_t *ovl, const char *path);
+static int ovl_copy_up(ovl_t *ovl, const char *path, bool truncate);
+static int ovl_file_copy_up(ovl_t *ovl, ovl_file_t *file);
+static ovl_file_t *ovl_get_file(ovl_t *ovl, int fd);
+static int ovl_file_get(ovl_t *ovl, ovl_file_t *file);
+static void ovl_file_put(ovl_t *ovl, ovl_file_t *file);
+static int ovl_whiteout_lower_children(ovl_t *ovl, const char *path);
+static int ovl_purge_upper_whiteouts(ovl_t *ovl, const char *path);
+
+static int ovl_open(void *ctx, const char *path, int flags, int mode);
+static int ovl_close(void *ctx, int fd);
+static xf_vfs_ssize_t ovl_read(void *ctx, int fd, void *dst, size_t size);
+static xf_vfs_ssize_t ovl_write(void *ctx, int fd, const void *data, size_t size);
+static xf_vfs_ssize_t ovl_pread(void *ctx, int fd, void *dst, size_t size, xf_vfs_off_t offset);
+static xf_vfs_ssize_t ovl_pwrite(void *ctx, int fd, const void *src, size_t size, xf_vfs_off_t offset);
+static xf_vfs_off_t ovl_lseek(void *ctx, int fd, xf_vfs_off_t offset, int mode);
+static int ovl_fstat(void *ctx, int fd, xf_vfs_stat_t *st);
+static int ovl_fsync(void *ctx, int fd);
+static int ovl_stat(void *ctx, const char *path, xf_vfs_stat_t *st);
+static int ovl_unlink(void *ctx, const char *path);
+static int ovl_rename(void *ctx, const char *src, const char *dst);
+static xf_vfs_dir_t *ovl_opendir(void *ctx, const char *name);
+static xf_vfs_dirent_t *ovl_readdir(void *ctx, xf_vfs_dir_t *pdir);
+static void ovl_seekdir(void *ctx, xf_vfs_dir_t *pdir, long offset);
+static int ovl_closedir(void *ctx, xf_vfs_dir_t *pdir);
+static int ovl_mkdir(void *ctx, const char *name, xf_vfs_mode_t mode);
+static int ovl_rmdir(void *ctx, const char *name);
+static int ovl_access(void *ctx, const char *path, int amode);
+static int ovl_truncate(void *ctx, const char *path, xf_vfs_off_t length);
+static int ovl_ftruncate(void *ctx, int fd, xf_vfs_off_t length);
+static int ovl_utime(void *ctx, const char *path, const xf_vfs_utimbuf_t *times);
+
+/* ==================== [Static Variables] ================================== */
+
+static const char *const TAG = "xf_vfs_overlay";
+
+static ovl_t *s_overlays = NULL;
+
+static const xf_vfs_dir_ops_t s_ovl_dir_ops = {
+    .stat_p = ovl_stat,
+    .unlink_p = ovl_unlink,
+    .rename_p = ovl_rename,
+    .opendir_p = ovl_opendir,
+    .readdir_p = ovl_readdir,
+    .seekdir_p = ovl_seekdir,
+    .closedir_p = ovl_closedir,
+    .mkdir_p = ovl_mkdir,
+    .rmdir_p = ovl_rmdir,
+    .access_p = ovl_access,
+    .truncate_p = ovl_truncate,
+    .ftruncate_p = ovl_ftruncate,
+    .utime_p = ovl_utime,
+};
+
+static const xf_vfs_fs_ops_t s_ovl_ops = {
+    .write_p = ovl_write,
+    .lseek_p = ovl_lseek,
+    .read_p = ovl_read,
+    .pread_p = ovl_pread,
+    .pwrite_p = ovl_pwrite,
+    .open_p = ovl_open,
+    .close_p = ovl_close,
+    .fstat_p = ovl_fstat,
+    .fsync_p = ovl_fsync,
+    .dir = &s_ovl_dir_ops,
+};
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+xf_err_t xf_vfs_overlay_register(const char *base_path, const char *lower_path, const char *upper_path)
+{
+    if (base_path == NULL || lower_path == NULL || upper_path == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+
+    ovl_t *ovl = xf_vfs_malloc(sizeof(ovl_t));
+    if (ovl == NULL) {
+        return XF_ERR_NO_MEM;
+    }
+    xf_memset(ovl, 0, sizeof(ovl_t));
+    ovl->base_path = ovl_strdup(base_path);
+    ovl->lower = ovl_strdup(lower_path);
+    ovl->upper = ovl_strdup(upper_path);
+    xf_err_t err = XF_ERR_NO_MEM;
+    if (ovl->base_path == NULL || ovl->lower == NULL || ovl->upper == NULL
+            || xf_lock_init(&ovl->lock) != XF_OK) {
+        goto fail;
+    }
+
+    /* 根目录总是存在于上层 */
+    if (ovl_index_set(ovl, "/", OVL_KIND_UPPER_DIR) < 0) {
+        goto fail;
+    }
+    if (ovl_scan_upper(ovl, "/") < 0) {
+        XF_LOGE(TAG, "cannot scan upper dir %s", upper_path);
+        err = XF_ERR_NOT_FOUND;
+        goto fail;
+    }
+
+    err = xf_vfs_register_fs(base_path, &s_ovl_ops, XF_VFS_FLAG_CONTEXT_PTR | XF_VFS_FLAG_STATIC, ovl);
+    if (err != XF_OK) {
+        goto fail;
+    }
+
+    ovl->next = s_overlays;
+    s_overlays = ovl;
+    return XF_OK;
+
+fail:
+    ovl_index_free(ovl);
+    if (ovl->lock) {
+        xf_lock_destroy(ovl->lock);
+    }
+    xf_vfs_free(ovl->base_path);
+    xf_vfs_free(ovl->lower);
+    xf_vfs_free(ovl->upper);
+    xf_vfs_free(ovl);
+    return err;
+}
+
+xf_err_t xf_vfs_overlay_unregister(const char *base_path)
+{
+    ovl_t **pp = &s_overlays;
+    while (*pp && xf_strcmp((*pp)->base_path, base_path) != 0) {
+        pp = &(*pp)->next;
+    }
+    ovl_t *ovl = *pp;
+    if (ovl == NULL) {
+        return XF_ERR_INVALID_STATE;
+    }
+    xf_err_t err = xf_vfs_unregister_fs(base_path);
+    if (err != XF_OK) {
+        return err;
+    }
+    *pp = ovl->next;
+
+    for (int i = 0; i < XF_VFS_OVERLAY_FILES_MAX; ++i) {
+        if (ovl->files[i].used) {
+            xf_vfs_close(ovl->files[i].fd);
+            xf_vfs_free(ovl->files[i].path);
+        }
+    }
+    ovl_index_free(ovl);
+    xf_lock_destroy(ovl->lock);
+    xf_vfs_free(ovl->base_path);
+    xf_vfs_free(ovl->lower);
+    xf_vfs_free(ovl->upper);
+    xf_vfs_free(ovl);
+    return XF_OK;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static char *ovl_strdup(const char *s)
+{
+    size_t len = xf_strlen(s) + 1;
+    char *out = xf_vfs_malloc(len);
+    if (out) {
+        xf_memcpy(out, s, len);
+    }
+    return out;
+}
+
+/* FNV-1a */
+static uint32_t ovl_hash(const char *path)
+{
+    uint32_t h = 2166136261u;
+    while (*path) {
+        h ^= (uint8_t) * path++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static ovl_node_t *ovl_index_find(ovl_t *ovl, const char *path)
+{
+    uint32_t hash = ovl_hash(path);
+    ovl_node_t *node = ovl->index[hash % XF_VFS_OVERLAY_INDEX_BUCKETS];
+    for (; node; node = node->next) {
+        if (node->hash == hash && xf_strcmp(node->path, path) == 0) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+static ovl_kind_t ovl_lookup(ovl_t *ovl, const char *path)
+{
+    const ovl_node_t *node = ovl_index_find(ovl, path);
+    return node ? (ovl_kind_t)node->kind : OVL_KIND_LOWER;
+}
+
+static int ovl_index_set(ovl_t *ovl, const char *path, ovl_kind_t kind)
+{
+    ovl_node_t *node = ovl_index_find(ovl, path);
+    if (node) {
+        node->kind = (uint8_t)kind;
+        return 0;
+    }
+    size_t len = xf_strlen(path) + 1;
+    node = xf_vfs_malloc(sizeof(ovl_node_t) + len);
+    if (node == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    node->hash = ovl_hash(path);
+    node->kind = (uint8_t)kind;
+    xf_memcpy(node->path, path, len);
+    ovl_node_t **bucket = &ovl->index[node->hash % XF_VFS_OVERLAY_INDEX_BUCKETS];
+    node->next = *bucket;
+    *bucket = node;
+    return 0;
+}
+
+static void ovl_index_remove(ovl_t *ovl, const char *path)
+{
+    uint32_t hash = ovl_hash(path);
+    ovl_node_t **pp = &ovl->index[hash % XF_VFS_OVERLAY_INDEX_BUCKETS];
+    for (; *pp; pp = &(*pp)->next) {
+        if ((*pp)->hash == hash && xf_strcmp((*pp)->path, path) == 0) {
+            ovl_node_t *node = *pp;
+            *pp = node->next;
+            xf_vfs_free(node);
+            return;
+        }
+    }
+}
+
+static void ovl_index_remove_subtree(ovl_t *ovl, const char *path)
+{
+    size_t len = xf_strlen(path);
+    for (int i = 0; i < XF_VFS_OVERLAY_INDEX_BUCKETS; ++i) {
+        ovl_node_t **pp = &ovl->index[i];
+        while (*pp) {
+            ovl_node_t *node = *pp;
+            if (xf_strncmp(node->path, path, len) == 0
+                    && (node->path[len] == '\0' || node->path[len] == '/')) {
+                *pp = node->next;
+                xf_vfs_free(node);
+            } else {
+                pp = &node->next;
+            }
+        }
+    }
+}
+
+static void ovl_index_free(ovl_t *ovl)
+{
+    for (int i = 0; i < XF_VFS_OVERLAY_INDEX_BUCKETS; ++i) {
+        while (ovl->index[i]) {
+            ovl_node_t *node = ovl->index[i];
+            ovl->index[i] = node->next;
+            xf_vfs_free(node);
+        }
+    }
+}
+
+/* base + path，path 为 "/" 时即 base 本身 */
+static int ovl_join(char *buf, const char *base, const char *path)
+{
+    const char *rest = (xf_strcmp(path, "/") == 0) ? "" : path;
+    size_t blen = xf_strlen(base);
+    size_t rlen = xf_strlen(rest);
+    if (blen + rlen + 1 > XF_VFS_OVERLAY_PATH_MAX) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    xf_memcpy(buf, base, blen);
+    xf_memcpy(buf + blen, rest, rlen + 1);
+    if (blen + rlen == 0) {
+        buf[0] = '/';
+        buf[1] = '\0';
+    }
+    return 0;
+}
+
+static int ovl_child(char *buf, const char *dir, const char *name)
+{
+    size_t dlen = (xf_strcmp(dir, "/") == 0) ? 0 : xf_strlen(dir);
+    size_t nlen = xf_strlen(name);
+    if (dlen + 1 + nlen + 1 > XF_VFS_OVERLAY_PATH_MAX) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    xf_memcpy(buf, dir, dlen);
+    buf[dlen] = '/';
+    xf_memcpy(buf + dlen + 1, name, nlen + 1);
+    return 0;
+}
+
+/* "/a/b" -> upper + "/a/.wh.b" */
+static int ovl_whiteout_path(char *buf, const char *upper, const char *path)
+{
+    const char *name = path;
+    for (const char *p = path; *p; ++p) {
+        if (*p == '/') {
+            name = p + 1;
+        }
+    }
+    size_t ulen = xf_strlen(upper);
+    size_t dlen = (size_t)(name - path);
+    size_t nlen = xf_strlen(name);
+    if (ulen + dlen + OVL_WH_PREFIX_LEN + nlen + 1 > XF_VFS_OVERLAY_PATH_MAX) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    char *p = buf;
+    xf_memcpy(p, upper, ulen);
+    p += ulen;
+    xf_memcpy(p, path, dlen);
+    p += dlen;
+    xf_memcpy(p, OVL_WH_PREFIX, OVL_WH_PREFIX_LEN);
+    p += OVL_WH_PREFIX_LEN;
+    xf_memcpy(p, name, nlen + 1);
+    return 0;
+}
+
+static int ovl_scan_upper(ovl_t *ovl, const char *path)
+{
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    if (ovl_join(buf, ovl->upper, path) < 0) {
+        return -1;
+    }
+    xf_vfs_dir_t *dir = xf_vfs_opendir(buf);
+    if (dir == NULL) {
+        return -1;
+    }
+    int ret = 0;
+    xf_vfs_dirent_t *ent;
+    while (ret == 0 && (ent = xf_vfs_readdir(dir)) != NULL) {
+        if (xf_strncmp(ent->d_name, OVL_WH_PREFIX, OVL_WH_PREFIX_LEN) == 0) {
+            if (ovl_child(buf, path, ent->d_name + OVL_WH_PREFIX_LEN) < 0
+                    || ovl_index_set(ovl, buf, OVL_KIND_WHITEOUT) < 0) {
+                ret = -1;
+            }
+            continue;
+        }
+        if (ovl_child(buf, path, ent->d_name) < 0) {
+            ret = -1;
+            continue;
+        }
+        bool is_dir = (ent->d_type == XF_VFS_DT_DIR);
+        if (ent->d_type == XF_VFS_DT_UNKNOWN) {
+            char full[XF_VFS_OVERLAY_PATH_MAX];
+            xf_vfs_statx_t stx;
+            if (ovl_join(full, ovl->upper, buf) < 0 || xf_vfs_statx(full, XF_VFS_STATX_TYPE, &stx) < 0) {
+                ret = -1;
+                continue;
+            }
+            is_dir = ((stx.stx_mode & XF_VFS_S_IFMT) == XF_VFS_S_IFDIR);
+        }
+        if (ovl_index_set(ovl, buf, is_dir ? OVL_KIND_UPPER_DIR : OVL_KIND_UPPER_FILE) < 0) {
+            ret = -1;
+            continue;
+        }
+        if (is_dir) {
+            /* buf 会被下一轮 readdir 复用，递归前拷贝一份 */
+            char *child = ovl_strdup(buf);
+            if (child == NULL) {
+                ret = -1;
+                continue;
+            }
+            ret = ovl_scan_upper(ovl, child);
+            xf_vfs_free(child);
+        }
+    }
+    xf_vfs_closedir(dir);
+    return ret;
+}
+
+static bool ovl_lower_exists(ovl_t *ovl, const char *path, bool *is_dir)
+{
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    xf_vfs_statx_t stx;
+    if (ovl_join(buf, ovl->lower, path) < 0 || xf_vfs_statx(buf, XF_VFS_STATX_TYPE, &stx) < 0) {
+        return false;
+    }
+    if (is_dir) {
+        *is_dir = ((stx.stx_mode & XF_VFS_S_IFMT) == XF_VFS_S_IFDIR);
+    }
+    return true;
+}
+
+/* 确保 path 的所有父目录都存在于上层 */
+static int ovl_ensure_parents(ovl_t *ovl, const char *path)
+{
+    char dir[XF_VFS_OVERLAY_PATH_MAX];
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    size_t len = xf_strlen(path);
+    if (len >= sizeof(dir)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    for (size_t i = 1; i < len; ++i) {
+        if (path[i] != '/') {
+            continue;
+        }
+        xf_memcpy(dir, path, i);
+        dir[i] = '\0';
+        ovl_kind_t kind = ovl_lookup(ovl, dir);
+        if (kind == OVL_KIND_UPPER_DIR) {
+            continue;
+        }
+        if (kind == OVL_KIND_UPPER_FILE) {
+            errno = ENOTDIR;
+            return -1;
+        }
+        if (kind == OVL_KIND_WHITEOUT) {
+            errno = ENOENT;
+            return -1;
+        }
+        if (ovl_join(buf, ovl->upper, dir) < 0 || xf_vfs_mkdir(buf, 0777) < 0) {
+            return -1;
+        }
+        if (ovl_index_set(ovl, dir, OVL_KIND_UPPER_DIR) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int ovl_clear_whiteout(ovl_t *ovl, const char *path)
+{
+    if (ovl_lookup(ovl, path) != OVL_KIND_WHITEOUT) {
+        return 0;
+    }
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    if (ovl_whiteout_path(buf, ovl->upper, path) < 0 || xf_vfs_unlink(buf) < 0) {
+        return -1;
+    }
+    ovl_index_remove(ovl, path);
+    return 0;
+}
+
+static int ovl_add_whiteout(ovl_t *ovl, const char *path)
+{
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    if (ovl_ensure_parents(ovl, path) < 0 || ovl_whiteout_path(buf, ovl->upper, path) < 0) {
+        return -1;
+    }
+    int fd = xf_vfs_open(buf, XF_VFS_O_WRONLY | XF_VFS_O_CREAT | XF_VFS_O_TRUNC, 0666);
+    if (fd < 0) {
+        return -1;
+    }
+    xf_vfs_close(fd);
+    return ovl_index_set(ovl, path, OVL_KIND_WHITEOUT);
+}
+
+/* 把下层文件复制到上层，truncate 为 true 时只创建空文件 */
+static int ovl_copy_up(ovl_t *ovl, const char *path, bool truncate)
+{
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    if (ovl_ensure_parents(ovl, path) < 0 || ovl_join(buf, ovl->upper, path) < 0) {
+        return -1;
+    }
+    int dst = xf_vfs_open(buf, XF_VFS_O_WRONLY | XF_VFS_O_CREAT | XF_VFS_O_TRUNC, 0666);
+    if (dst < 0) {
+        return -1;
+    }
+    int ret = 0;
+    if (!truncate) {
+        int src = -1;
+        uint8_t *chunk = xf_vfs_malloc(XF_VFS_OVERLAY_COPY_BUF_SIZE);
+        if (chunk == NULL) {
+            errno = ENOMEM;
+            ret = -1;
+        } else if (ovl_join(buf, ovl->lower, path) < 0
+                   || (src = xf_vfs_open(buf, XF_VFS_O_RDONLY, 0)) < 0) {
+            ret = -1;
+        }
+        while (ret == 0) {
+            xf_vfs_ssize_t n = xf_vfs_read(src, chunk, XF_VFS_OVERLAY_COPY_BUF_SIZE);
+            if (n <= 0) {
+                ret = (int)n;
+                break;
+            }
+            if (xf_vfs_write(dst, chunk, (size_t)n) != n) {
+                ret = -1;
+            }
+        }
+        if (src >= 0) {
+            xf_vfs_close(src);
+        }
+        xf_vfs_free(chunk);
+    }
+    xf_vfs_close(dst);
+    if (ret < 0) {
+        ovl_join(buf, ovl->upper, path);
+        xf_vfs_unlink(buf);
+        return -1;
+    }
+    return ovl_index_set(ovl, path, OVL_KIND_UPPER_FILE);
+}
+
+/* 把以下层文件打开的 file 切换到上层副本，保持当前偏移 */
+static int ovl_file_copy_up(ovl_t *ovl, ovl_file_t *file)
+{
+    int ret = 0;
+    xf_lock_lock(ovl->lock);
+    if (!file->copy_pending) {
+        goto out;
+    }
+    xf_vfs_off_t pos = xf_vfs_lseek(file->fd, 0, XF_VFS_SEEK_CUR);
+    if (pos < 0) {
+        pos = 0;
+    }
+    if (ovl_lookup(ovl, file->path) != OVL_KIND_UPPER_FILE
+            && ovl_copy_up(ovl, file->path, false) < 0) {
+        ret = -1;
+        goto out;
+    }
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    int fd = -1;
+    if (ovl_join(buf, ovl->upper, file->path) == 0) {
+        fd = xf_vfs_open(buf, file->flags & ~(XF_VFS_O_CREAT | XF_VFS_O_EXCL | XF_VFS_O_TRUNC), 0);
+    }
+    if (fd < 0) {
+        ret = -1;
+        goto out;
+    }
+    if (pos > 0) {
+        xf_vfs_lseek(fd, pos, XF_VFS_SEEK_SET);
+    }
+    /* 其他线程（如经 dup 的 fd）可能仍在使用下层 fd，此时关闭后其全局 fd 可能被无关的 open 重用 */
+    if (file->users == 0) {
+        xf_vfs_close(file->fd);
+    } else {
+        file->retired_fd = file->fd;
+    }
+    file->fd = fd;
+    file->copy_pending = false;
+    xf_vfs_free(file->path);
+    file->path = NULL;
+out:
+    xf_lock_unlock(ovl->lock);
+    return ret;
+}
+
+static ovl_file_t *ovl_get_file(ovl_t *ovl, int fd)
+{
+    if (fd < 0 || fd >= XF_VFS_OVERLAY_FILES_MAX || !ovl->files[fd].used) {
+        errno = EBADF;
+        return NULL;
+    }
+    return &ovl->files[fd];
+}
+
+/* 取得 file 当前的底层 fd，在 ovl_file_put() 之前 copy-up 不会关闭它 */
+static int ovl_file_get(ovl_t *ovl, ovl_file_t *file)
+{
+    xf_lock_lock(ovl->lock);
+    const int fd = file->fd;
+    ++file->users;
+    xf_lock_unlock(ovl->lock);
+    return fd;
+}
+
+static void ovl_file_put(ovl_t *ovl, ovl_file_t *file)
+{
+    int retired = -1;
+    xf_lock_lock(ovl->lock);
+    if (--file->users == 0) {
+        retired = file->retired_fd;
+        file->retired_fd = -1;
+    }
+    xf_lock_unlock(ovl->lock);
+    if (retired >= 0) {
+        const int err = errno;
+        xf_vfs_close(retired);
+        errno = err;
+    }
+}
+
+/* 在上层为下层目录 path 的所有子项创建 whiteout，用于在 whiteout 上重建目录 */
+static int ovl_whiteout_lower_children(ovl_t *ovl, const char *path)
+{
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    if (ovl_join(buf, ovl->lower, path) < 0) {
+        return -1;
+    }
+    xf_vfs_dir_t *dir = xf_vfs_opendir(buf);
+    if (dir == NULL) {
+        return 0;
+    }
+    int ret = 0;
+    xf_vfs_dirent_t *ent;
+    while (ret == 0 && (ent = xf_vfs_readdir(dir)) != NULL) {
+        if (ovl_child(buf, path, ent->d_name) < 0 || ovl_add_whiteout(ovl, buf) < 0) {
+            ret = -1;
+        }
+    }
+    xf_vfs_closedir(dir);
+    return ret;
+}
+
+/* 删除上层目录 path 中的所有 whiteout 标记文件 */
+static int ovl_purge_upper_whiteouts(ovl_t *ovl, const char *path)
+{
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    char child[XF_VFS_OVERLAY_PATH_MAX];
+    for (;;) {
+        if (ovl_join(buf, ovl->upper, path) < 0) {
+            return -1;
+        }
+        xf_vfs_dir_t *dir = xf_vfs_opendir(buf);
+        if (dir == NULL) {
+            return -1;
+        }
+        bool found = false;
+        xf_vfs_dirent_t *ent;
+        while ((ent = xf_vfs_readdir(dir)) != NULL) {
+            if (xf_strncmp(ent->d_name, OVL_WH_PREFIX, OVL_WH_PREFIX_LEN) == 0) {
+                found = (ovl_child(child, path, ent->d_name + OVL_WH_PREFIX_LEN) == 0);
+                break;
+            }
+        }
+        xf_vfs_closedir(dir);
+        if (!found) {
+            return 0;
+        }
+        /* 删除会改变目录内容，每删除一个就重新打开目录 */
+        if (ovl_clear_whiteout(ovl, child) < 0) {
+            return -1;
+        }
+    }
+}
+
+static int ovl_open(void *ctx, const char *path, int flags, int mode)
+{
+    ovl_t *ovl = ctx;
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    const int acc_mode = flags & XF_VFS_O_ACCMODE;
+    const bool writable = (acc_mode != XF_VFS_O_RDONLY) || (flags & XF_VFS_O_TRUNC);
+    int ret = -1;
+
+    xf_lock_lock(ovl->lock);
+    int slot = -1;
+    for (int i = 0; i < XF_VFS_OVERLAY_FILES_MAX; ++i) {
+        if (!ovl->files[i].used) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        errno = ENFILE;
+        goto out;
+    }
+    ovl_file_t *file = &ovl->files[slot];
+    xf_memset(file, 0, sizeof(ovl_file_t));
+    file->flags = flags;
+    file->fd = -1;
+    file->retired_fd = -1;
+
+    switch (ovl_lookup(ovl, path)) {
+    case OVL_KIND_UPPER_FILE:
+    case OVL_KIND_UPPER_DIR:
+        if (ovl_join(buf, ovl->upper, path) == 0) {
+            file->fd = xf_vfs_open(buf, flags, mode);
+        }
+        break;
+    case OVL_KIND_WHITEOUT:
+        if (!(flags & XF_VFS_O_CREAT)) {
+            errno = ENOENT;
+            break;
+        }
+        if (ovl_clear_whiteout(ovl, path) == 0 && ovl_ensure_parents(ovl, path) == 0
+                && ovl_join(buf, ovl->upper, path) == 0) {
+            file->fd = xf_vfs_open(buf, flags, mode);
+            if (file->fd >= 0) {
+                ovl_index_set(ovl, path, OVL_KIND_UPPER_FILE);
+            }
+        }
+        break;
+    case OVL_KIND_LOWER:
+    default:
+        if (ovl_join(buf, ovl->lower, path) < 0) {
+            break;
+        }
+        if (!writable) {
+            /* 未修改过的默认文件：只有一次驱动调用 */
+            file->fd = xf_vfs_open(buf, flags, mode);
+            break;
+        }
+        if (flags & XF_VFS_O_TRUNC) {
+            /* 截断不需要旧内容，直接在上层创建 */
+            if (!(flags & XF_VFS_O_CREAT) && !ovl_lower_exists(ovl, path, NULL)) {
+                errno = ENOENT;
+                break;
+            }
+            if (ovl_copy_up(ovl, path, true) == 0 && ovl_join(buf, ovl->upper, path) == 0) {
+                file->fd = xf_vfs_open(buf, flags, mode);
+            }
+            break;
+        }
+        file->fd = xf_vfs_open(buf, XF_VFS_O_RDONLY, 0);
+        if (file->fd < 0) {
+            if (errno != ENOENT || !(flags & XF_VFS_O_CREAT)) {
+                break;
+            }
+            if (ovl_ensure_parents(ovl, path) == 0 && ovl_join(buf, ovl->upper, path) == 0) {
+                file->fd = xf_vfs_open(buf, flags, mode);
+                if (file->fd >= 0) {
+                    ovl_index_set(ovl, path, OVL_KIND_UPPER_FILE);
+                }
+            }
+            break;
+        }
+        if ((flags & XF_VFS_O_CREAT) && (flags & XF_VFS_O_EXCL)) {
+            xf_vfs_close(file->fd);
+            file->fd = -1;
+            errno = EEXIST;
+            break;
+        }
+        /* 延迟 copy-up：首次写入时再复制 */
+        file->path = ovl_strdup(path);
+        if (file->path == NULL) {
+            xf_vfs_close(file->fd);
+            file->fd = -1;
+            errno = ENOMEM;
+            break;
+        }
+        file->copy_pending = true;
+        break;
+    }
+
+    if (file->fd >= 0) {
+        file->used = true;
+        ret = slot;
+    }
+out:
+    xf_lock_unlock(ovl->lock);
+    return ret;
+}
+
+static int ovl_close(void *ctx, int fd)
+{
+    ovl_t *ovl = ctx;
+    ovl_file_t *file = ovl_get_file(ovl, fd);
+    if (file == NULL) {
+        return -1;
+    }
+    xf_lock_lock(ovl->lock);
+    const int real_fd = file->fd;
+    const int retired = file->retired_fd;
+    xf_vfs_free(file->path);
+    xf_memset(file, 0, sizeof(ovl_file_t));
+    xf_lock_unlock(ovl->lock);
+    if (retired >= 0) {
+        xf_vfs_close(retired);
+    }
+    return xf_vfs_close(real_fd);
+}
+
+/* 对 file 的底层 fd 执行 call，期间底层 fd 不会被 copy-up 关闭 */
+#define OVL_FILE_CALL(ovl, file, ret, real_fd, call) \
+    do { \
+        const int real_fd = ovl_file_get(ovl, file); \
+        ret = call; \
+        ovl_file_put(ovl, file); \
+    } while (0)
+
+static xf_vfs_ssize_t ovl_read(void *ctx, int fd, void *dst, size_t size)
+{
+    ovl_file_t *file = ovl_get_file(ctx, fd);
+    if (file == NULL) {
+        return -1;
+    }
+    xf_vfs_ssize_t ret;
+    OVL_FILE_CALL(ctx, file, ret, real_fd, xf_vfs_read(real_fd, dst, size));
+    return ret;
+}
+
+static xf_vfs_ssize_t ovl_write(void *ctx, int fd, const void *data, size_t size)
+{
+    ovl_file_t *file = ovl_get_file(ctx, fd);
+    if (file == NULL) {
+        return -1;
+    }
+    if (file->copy_pending && ovl_file_copy_up(ctx, file) < 0) {
+        return -1;
+    }
+    xf_vfs_ssize_t ret;
+    OVL_FILE_CALL(ctx, file, ret, real_fd, xf_vfs_write(real_fd, data, size));
+    return ret;
+}
+
+static xf_vfs_ssize_t ovl_pread(void *ctx, int fd, void *dst, size_t size, xf_vfs_off_t offset)
+{
+    ovl_file_t *file = ovl_get_file(ctx, fd);
+    if (file == NULL) {
+        return -1;
+    }
+    xf_vfs_ssize_t ret;
+    OVL_FILE_CALL(ctx, file, ret, real_fd, xf_vfs_pread(real_fd, dst, size, offset));
+    return ret;
+}
+
+static xf_vfs_ssize_t ovl_pwrite(void *ctx, int fd, const void *src, size_t size, xf_vfs_off_t offset)
+{
+    ovl_file_t *file = ovl_get_file(ctx, fd);
+    if (file == NULL) {
+        return -1;
+    }
+    if (file->copy_pending && ovl_file_copy_up(ctx, file) < 0) {
+        return -1;
+    }
+    xf_vfs_ssize_t ret;
+    OVL_FILE_CALL(ctx, file, ret, real_fd, xf_vfs_pwrite(real_fd, src, size, offset));
+    return ret;
+}
+
+static xf_vfs_off_t ovl_lseek(void *ctx, int fd, xf_vfs_off_t offset, int mode)
+{
+    ovl_file_t *file = ovl_get_file(ctx, fd);
+    if (file == NULL) {
+        return -1;
+    }
+    xf_vfs_off_t ret;
+    OVL_FILE_CALL(ctx, file, ret, real_fd, xf_vfs_lseek(real_fd, offset, mode));
+    return ret;
+}
+
+static int ovl_fstat(void *ctx, int fd, xf_vfs_stat_t *st)
+{
+    ovl_file_t *file = ovl_get_file(ctx, fd);
+    if (file == NULL) {
+        return -1;
+    }
+    int ret;
+    OVL_FILE_CALL(ctx, file, ret, real_fd, xf_vfs_fstat(real_fd, st));
+    return ret;
+}
+
+static int ovl_fsync(void *ctx, int fd)
+{
+    ovl_file_t *file = ovl_get_file(ctx, fd);
+    if (file == NULL) {
+        return -1;
+    }
+    int ret;
+    OVL_FILE_CALL(ctx, file, ret, real_fd, xf_vfs_fsync(real_fd));
+    return ret;
+}
+
+static int ovl_stat(void *ctx, const char *path, xf_vfs_stat_t *st)
+{
+    ovl_t *ovl = ctx;
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    xf_lock_lock(ovl->lock);
+    ovl_kind_t kind = ovl_lookup(ovl, path);
+    int ret = -1;
+    if (kind == OVL_KIND_WHITEOUT) {
+        errno = ENOENT;
+    } else if (ovl_join(buf, (kind == OVL_KIND_LOWER) ? ovl->lower : ovl->upper, path) == 0) {
+        ret = 0;
+    }
+    xf_lock_unlock(ovl->lock);
+    return (ret == 0) ? xf_vfs_stat(buf, st) : -1;
+}
+
+static int ovl_access(void *ctx, const char *path, int amode)
+{
+    ovl_t *ovl = ctx;
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    xf_lock_lock(ovl->lock);
+    ovl_kind_t kind = ovl_lookup(ovl, path);
+    int ret = -1;
+    if (kind == OVL_KIND_WHITEOUT) {
+        errno = ENOENT;
+    } else if (kind == OVL_KIND_LOWER && (amode & XF_VFS_W_OK)) {
+        /* 下层文件可以通过 copy-up 写入，只需检查存在性 */
+        ret = ovl_lower_exists(ovl, path, NULL) ? 0 : -1;
+        if (ret < 0) {
+            errno = ENOENT;
+        }
+        xf_lock_unlock(ovl->lock);
+        return ret;
+    } else if (ovl_join(buf, (kind == OVL_KIND_LOWER) ? ovl->lower : ovl->upper, path) == 0) {
+        ret = 0;
+    }
+    xf_lock_unlock(ovl->lock);
+    return (ret == 0) ? xf_vfs_access(buf, amode) : -1;
+}
+
+static int ovl_unlink(void *ctx, const char *path)
+{
+    ovl_t *ovl = ctx;
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    int ret = -1;
+    bool is_dir = false;
+    xf_lock_lock(ovl->lock);
+    switch (ovl_lookup(ovl, path)) {
+    case OVL_KIND_WHITEOUT:
+        errno = ENOENT;
+        break;
+    case OVL_KIND_UPPER_DIR:
+        errno = EISDIR;
+        break;
+    case OVL_KIND_UPPER_FILE:
+        if (ovl_join(buf, ovl->upper, path) < 0 || xf_vfs_unlink(buf) < 0) {
+            break;
+        }
+        ovl_index_remove(ovl, path);
+        ret = ovl_lower_exists(ovl, path, NULL) ? ovl_add_whiteout(ovl, path) : 0;
+        break;
+    case OVL_KIND_LOWER:
+    default:
+        if (!ovl_lower_exists(ovl, path, &is_dir)) {
+            errno = ENOENT;
+        } else if (is_dir) {
+            errno = EISDIR;
+        } else {
+            ret = ovl_add_whiteout(ovl, path);
+        }
+        break;
+    }
+    xf_lock_unlock(ovl->lock);
+    return ret;
+}
+
+static int ovl_rename(void *ctx, const char *src, const char *dst)
+{
+    ovl_t *ovl = ctx;
+    char from[XF_VFS_OVERLAY_PATH_MAX];
+    char to[XF_VFS_OVERLAY_PATH_MAX];
+    int ret = -1;
+    bool lower_is_dir = false;
+    xf_lock_lock(ovl->lock);
+    ovl_kind_t kind = ovl_lookup(ovl, src);
+    const bool in_lower = (kind != OVL_KIND_WHITEOUT) && ovl_lower_exists(ovl, src, &lower_is_dir);
+    ovl_kind_t dst_kind = ovl_lookup(ovl, dst);
+    if (kind == OVL_KIND_WHITEOUT || (kind == OVL_KIND_LOWER && !in_lower)) {
+        errno = ENOENT;
+        goto out;
+    }
+    if (in_lower && lower_is_dir) {
+        errno = EXDEV;
+        goto out;
+    }
+    if (dst_kind == OVL_KIND_UPPER_DIR) {
+        errno = EISDIR;
+        goto out;
+    }
+    if (kind == OVL_KIND_LOWER && ovl_copy_up(ovl, src, false) < 0) {
+        goto out;
+    }
+    if (ovl_clear_whiteout(ovl, dst) < 0 || ovl_ensure_parents(ovl, dst) < 0
+            || ovl_join(from, ovl->upper, src) < 0 || ovl_join(to, ovl->upper, dst) < 0
+            || xf_vfs_rename(from, to) < 0) {
+        goto out;
+    }
+    if (kind == OVL_KIND_UPPER_DIR) {
+        ovl_index_remove_subtree(ovl, src);
+        if (ovl_index_set(ovl, dst, OVL_KIND_UPPER_DIR) < 0 || ovl_scan_upper(ovl, dst) < 0) {
+            goto out;
+        }
+    } else {
+        ovl_index_remove(ovl, src);
+        if (ovl_index_set(ovl, dst, OVL_KIND_UPPER_FILE) < 0) {
+            goto out;
+        }
+    }
+    ret = in_lower ? ovl_add_whiteout(ovl, src) : 0;
+out:
+    xf_lock_unlock(ovl->lock);
+    return ret;
+}
+
+static xf_vfs_dir_t *ovl_opendir(void *ctx, const char *name)
+{
+    ovl_t *ovl = ctx;
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    xf_lock_lock(ovl->lock);
+    ovl_kind_t kind = ovl_lookup(ovl, name);
+    xf_lock_unlock(ovl->lock);
+    if (kind == OVL_KIND_WHITEOUT) {
+        errno = ENOENT;
+        return NULL;
+    }
+    if (kind == OVL_KIND_UPPER_FILE) {
+        errno = ENOTDIR;
+        return NULL;
+    }
+    ovl_dir_t *dir = xf_vfs_malloc(sizeof(ovl_dir_t));
+    if (dir == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    xf_memset(dir, 0, sizeof(ovl_dir_t));
+    dir->path = ovl_strdup(name);
+    if (dir->path == NULL) {
+        xf_vfs_free(dir);
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (kind == OVL_KIND_UPPER_DIR && ovl_join(buf, ovl->upper, name) == 0) {
+        dir->upper = xf_vfs_opendir(buf);
+    }
+    if (ovl_join(buf, ovl->lower, name) == 0) {
+        dir->lower = xf_vfs_opendir(buf);
+    }
+    if (dir->upper == NULL && dir->lower == NULL) {
+        xf_vfs_free(dir->path);
+        xf_vfs_free(dir);
+        errno = ENOENT;
+        return NULL;
+    }
+    return &dir->base;
+}
+
+static xf_vfs_dirent_t *ovl_readdir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    ovl_t *ovl = ctx;
+    ovl_dir_t *dir = (ovl_dir_t *)pdir;
+    xf_vfs_dirent_t *ent;
+    while (dir->upper && (ent = xf_vfs_readdir(dir->upper)) != NULL) {
+        if (xf_strncmp(ent->d_name, OVL_WH_PREFIX, OVL_WH_PREFIX_LEN) != 0) {
+            xf_memcpy(&dir->ent, ent, sizeof(xf_vfs_dirent_t));
+            return &dir->ent;
+        }
+    }
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    while (dir->lower && (ent = xf_vfs_readdir(dir->lower)) != NULL) {
+        /* 上层已列出的同名项以及 whiteout 都在索引中 */
+        if (ovl_child(buf, dir->path, ent->d_name) < 0) {
+            continue;
+        }
+        xf_lock_lock(ovl->lock);
+        bool hidden = (ovl_index_find(ovl, buf) != NULL);
+        xf_lock_unlock(ovl->lock);
+        if (!hidden) {
+            xf_memcpy(&dir->ent, ent, sizeof(xf_vfs_dirent_t));
+            return &dir->ent;
+        }
+    }
+    return NULL;
+}
+
+static void ovl_seekdir(void *ctx, xf_vfs_dir_t *pdir, long offset)
+{
+    ovl_dir_t *dir = (ovl_dir_t *)pdir;
+    if (offset != 0) {
+        errno = EINVAL;
+        return;
+    }
+    if (dir->upper) {
+        xf_vfs_rewinddir(dir->upper);
+    }
+    if (dir->lower) {
+        xf_vfs_rewinddir(dir->lower);
+    }
+}
+
+static int ovl_closedir(void *ctx, xf_vfs_dir_t *pdir)
+{
+    ovl_dir_t *dir = (ovl_dir_t *)pdir;
+    if (dir->upper) {
+        xf_vfs_closedir(dir->upper);
+    }
+    if (dir->lower) {
+        xf_vfs_closedir(dir->lower);
+    }
+    xf_vfs_free(dir->path);
+    xf_vfs_free(dir);
+    return 0;
+}
+
+static int ovl_mkdir(void *ctx, const char *name, xf_vfs_mode_t mode)
+{
+    ovl_t *ovl = ctx;
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    int ret = -1;
+    xf_lock_lock(ovl->lock);
+    ovl_kind_t kind = ovl_lookup(ovl, name);
+    if (kind == OVL_KIND_UPPER_FILE || kind == OVL_KIND_UPPER_DIR
+            || (kind == OVL_KIND_LOWER && ovl_lower_exists(ovl, name, NULL))) {
+        errno = EEXIST;
+        goto out;
+    }
+    if (ovl_clear_whiteout(ovl, name) < 0 || ovl_ensure_parents(ovl, name) < 0
+            || ovl_join(buf, ovl->upper, name) < 0 || xf_vfs_mkdir(buf, mode) < 0
+            || ovl_index_set(ovl, name, OVL_KIND_UPPER_DIR) < 0) {
+        goto out;
+    }
+    /* 在已删除的下层目录上重建时，下层旧内容不应重新出现 */
+    ret = (kind == OVL_KIND_WHITEOUT) ? ovl_whiteout_lower_children(ovl, name) : 0;
+out:
+    xf_lock_unlock(ovl->lock);
+    return ret;
+}
+
+static int ovl_rmdir(void *ctx, const char *name)
+{
+    ovl_t *ovl = ctx;
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    int ret = -1;
+    bool lower_is_dir = false;
+
+    /* 合并视图必须为空 */
+    xf_vfs_dir_t *dir = ovl_opendir(ctx, name);
+    if (dir == NULL) {
+        return -1;
+    }
+    bool empty = (ovl_readdir(ctx, dir) == NULL);
+    ovl_closedir(ctx, dir);
+    if (!empty) {
+        errno = ENOTEMPTY;
+        return -1;
+    }
+
+    xf_lock_lock(ovl->lock);
+    ovl_kind_t kind = ovl_lookup(ovl, name);
+    const bool in_lower = ovl_lower_exists(ovl, name, &lower_is_dir) && lower_is_dir;
+    if (kind == OVL_KIND_UPPER_FILE) {
+        errno = ENOTDIR;
+        goto out;
+    }
+    if (kind == OVL_KIND_UPPER_DIR) {
+        if (ovl_purge_upper_whiteouts(ovl, name) < 0
+                || ovl_join(buf, ovl->upper, name) < 0 || xf_vfs_rmdir(buf) < 0) {
+            goto out;
+        }
+        ovl_index_remove_subtree(ovl, name);
+    }
+    ret = in_lower ? ovl_add_whiteout(ovl, name) : 0;
+out:
+    xf_lock_unlock(ovl->lock);
+    return ret;
+}
+
+static int ovl_truncate(void *ctx, const char *path, xf_vfs_off_t length)
+{
+    ovl_t *ovl = ctx;
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    int ret = -1;
+    xf_lock_lock(ovl->lock);
+    ovl_kind_t kind = ovl_lookup(ovl, path);
+    if (kind == OVL_KIND_WHITEOUT) {
+        errno = ENOENT;
+    } else if (kind == OVL_KIND_LOWER && !ovl_lower_exists(ovl, path, NULL)) {
+        errno = ENOENT;
+    } else if (kind != OVL_KIND_LOWER || ovl_copy_up(ovl, path, length == 0) == 0) {
+        ret = ovl_join(buf, ovl->upper, path);
+    }
+    xf_lock_unlock(ovl->lock);
+    return (ret == 0) ? xf_vfs_truncate(buf, length) : -1;
+}
+
+static int ovl_ftruncate(void *ctx, int fd, xf_vfs_off_t length)
+{
+    ovl_file_t *file = ovl_get_file(ctx, fd);
+    if (file == NULL) {
+        return -1;
+    }
+    if (file->copy_pending && ovl_file_copy_up(ctx, file) < 0) {
+        return -1;
+    }
+    int ret;
+    OVL_FILE_CALL(ctx, file, ret, real_fd, xf_vfs_ftruncate(real_fd, length));
+    return ret;
+}
+
+static int ovl_utime(void *ctx, const char *path, const xf_vfs_utimbuf_t *times)
+{
+    ovl_t *ovl = ctx;
+    char buf[XF_VFS_OVERLAY_PATH_MAX];
+    int ret = -1;
+    bool is_dir = false;
+    xf_lock_lock(ovl->lock);
+    ovl_kind_t kind = ovl_lookup(ovl, path);
+    if (kind == OVL_KIND_WHITEOUT) {
+        errno = ENOENT;
+    } else if (kind == OVL_KIND_LOWER) {
+        if (!ovl_lower_exists(ovl, path, &is_dir)) {
+            errno = ENOENT;
+        } else if (is_dir) {
+            if (ovl_ensure_parents(ovl, path) == 0 && ovl_join(buf, ovl->upper, path) == 0
+                    && xf_vfs_mkdir(buf, 0777) == 0) {
+                ret = ovl_index_set(ovl, path, OVL_KIND_UPPER_DIR);
+            }
+        } else if (ovl_copy_up(ovl, path, false) == 0) {
+            ret = ovl_join(buf, ovl->upper, path);
+        }
+    } else {
+        ret = ovl_join(buf, ovl->upper, path);
+    }
+    xf_lock_unlock(ovl->lock);
+    return (ret == 0) ? xf_vfs_utime(buf, times) : -1;
+}
+
+#endif /* XF_VFS_SUPPORT_DIR_IS_ENABLE */
@@ -0,0 +1,88 @@
+/**
+ * @file xf_vfs_overlay.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs overlay（联合）文件系统驱动。
+ *        将只读的下层挂载点与可写的上层挂载点叠加为一个挂载点。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __XF_VFS_OVERLAY_H__
+#define __XF_VFS_OVERLAY_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @cond (XFAPI_USER || XFAPI_PORT || XFAPI_INTERNAL)
+ * @addtogroup group_xf_vfs
+ * @endcond
+ * @{
+ */
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE || defined(__DOXYGEN__)
+
+/* ==================== [Defines] =========================================== */
+
+/**
+ * 上层中表示“下层同名文件已删除”的标记文件名前缀。
+ */
+#define XF_VFS_OVERLAY_WHITEOUT_PREFIX      ".wh."
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 注册 overlay 文件系统。
+ *
+ * 查找时先查上层：注册时会遍历一次上层，建立上层文件及 whiteout 的内存索引，
+ * 之后不在索引中的路径直接交给下层，因此读取未修改过的默认文件只需一次驱动调用。
+ * 以写方式打开仅存在于下层的文件时，首次写入才会把文件复制到上层（copy-up）。
+ * 删除下层文件时在上层创建 `.wh.<name>` 标记文件。
+ *
+ * @note 上层挂载点只应通过 overlay 修改，否则内存索引会与上层内容不一致。
+ * @note 重命名仅存在于下层的目录会返回 EXDEV.
+ *
+ * @param base_path  overlay 的挂载点，规则与 xf_vfs_register() 相同。
+ * @param lower_path 下层（只读）目录的完整路径，如 "/rom/cfg".
+ * @param upper_path 上层（可写）目录的完整路径，如 "/data/cfg"，必须已存在。
+ *
+ * @return  XF_OK if successful.
+ *          XF_ERR_NO_MEM if out of memory or too many VFSes are registered.
+ *          XF_ERR_INVALID_ARG if given an invalid parameter.
+ *          XF_ERR_NOT_FOUND if upper_path cannot be scanned.
+ */
+xf_err_t xf_vfs_overlay_register(const char *base_path, const char *lower_path, const char *upper_path);
+
+/**
+ * @brief 注销由 xf_vfs_overlay_register() 注册的 overlay 文件系统。
+ *
+ * @param base_path overlay 的挂载点。
+ *
+ * @return XF_OK if successful, XF_ERR_INVALID_STATE if no overlay is mounted at base_path.
+ */
+xf_err_t xf_vfs_overlay_unregister(const char *base_path);
+
+#endif /* XF_VFS_SUPPORT_DIR_IS_ENABLE || defined(__DOXYGEN__) */
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * End of addtogroup group_xf_vfs
+ * @}
+ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __XF_VFS_OVERLAY_H__ */
@@ -30,6 +30,7 @@
 /* ==================== [Includes] ========================================== */
 
 #include "xf_vfs_types.h"
+#include "xf_vfs_mem.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -44,13 +45,120 @@ extern "C" {
 
 /* ==================== [Defines] =========================================== */
 
+/*
+ * 64 位文件偏移的原子操作。
+ * 支持 __atomic 内建函数且 64 位原子操作无锁的编译器（GCC、Clang、ARMCC 6）直接使用内建函数，
+ * 其他情况（如 Cortex-M 等 32 位目标）使用 XF_VFS_ATOMIC_ENTER()/XF_VFS_ATOMIC_EXIT() 临界区。
+ */
+#if (defined(__GNUC__) || defined(__clang__)) \
+        && defined(__GCC_ATOMIC_LLONG_LOCK_FREE) && (__GCC_ATOMIC_LLONG_LOCK_FREE == 2)
+#   define XF_VFS_ATOMIC_OFF64_BUILTIN      (1)
+#else
+#   define XF_VFS_ATOMIC_OFF64_BUILTIN      (0)
+#endif
+
+#if XF_VFS_ATOMIC_OFF64_BUILTIN
+#   define XF_VFS_ATOMIC_LOAD(ptr)              __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#   define XF_VFS_ATOMIC_STORE(ptr, val)        __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#   define XF_VFS_ATOMIC_FETCH_ADD(ptr, val)    __atomic_fetch_add((ptr), (val), __ATOMIC_ACQ_REL)
+#   define XF_VFS_ATOMIC_CAS(ptr, pexpected, desired) \
+        __atomic_compare_exchange_n((ptr), (pexpected), (desired), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#else
+#   define XF_VFS_ATOMIC_LOAD(ptr)              xf_vfs_atomic_load_off(ptr)
+#   define XF_VFS_ATOMIC_STORE(ptr, val)        xf_vfs_atomic_store_off((ptr), (val))
+#   define XF_VFS_ATOMIC_FETCH_ADD(ptr, val)    xf_vfs_atomic_fetch_add_off((ptr), (val))
+#   define XF_VFS_ATOMIC_CAS(ptr, pexpected, desired) \
+        xf_vfs_atomic_cas_off((ptr), (pexpected), (desired))
+#endif
+
+/*
+ * 打开文件描述引用计数（uint16_t）的原子操作，规则同上。
+ */
+#if (defined(__GNUC__) || defined(__clang__)) \
+        && defined(__GCC_ATOMIC_SHORT_LOCK_FREE) && (__GCC_ATOMIC_SHORT_LOCK_FREE == 2)
+#   define XF_VFS_ATOMIC_REF_BUILTIN        (1)
+#else
+#   define XF_VFS_ATOMIC_REF_BUILTIN        (0)
+#endif
+
+#if XF_VFS_ATOMIC_REF_BUILTIN
+#   define XF_VFS_ATOMIC_REF_LOAD(ptr)          __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#   define XF_VFS_ATOMIC_REF_STORE(ptr, val)    __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#   define XF_VFS_ATOMIC_REF_INC(ptr)           __atomic_add_fetch((ptr), 1, __ATOMIC_ACQ_REL)
+#   define XF_VFS_ATOMIC_REF_DEC(ptr)           __atomic_sub_fetch((ptr), 1, __ATOMIC_ACQ_REL)
+#   define XF_VFS_ATOMIC_REF_CAS(ptr, pexpected, desired) \
+        __atomic_compare_exchange_n((ptr), (pexpected), (desired), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#else
+#   define XF_VFS_ATOMIC_REF_LOAD(ptr)          xf_vfs_atomic_load_ref(ptr)
+#   define XF_VFS_ATOMIC_REF_STORE(ptr, val)    xf_vfs_atomic_store_ref((ptr), (val))
+#   define XF_VFS_ATOMIC_REF_INC(ptr)           xf_vfs_atomic_add_ref((ptr), 1)
+#   define XF_VFS_ATOMIC_REF_DEC(ptr)           xf_vfs_atomic_add_ref((ptr), -1)
+#   define XF_VFS_ATOMIC_REF_CAS(ptr, pexpected, desired) \
+        xf_vfs_atomic_cas_ref((ptr), (pexpected), (desired))
+#endif
+
+/*
+ * 32 位计数器（uint32_t）的原子操作，规则同上。
+ */
+#if (defined(__GNUC__) || defined(__clang__)) \
+        && defined(__GCC_ATOMIC_INT_LOCK_FREE) && (__GCC_ATOMIC_INT_LOCK_FREE == 2)
+#   define XF_VFS_ATOMIC_U32_BUILTIN        (1)
+#else
+#   define XF_VFS_ATOMIC_U32_BUILTIN        (0)
+#endif
+
+#if XF_VFS_ATOMIC_U32_BUILTIN
+#   define XF_VFS_ATOMIC_U32_LOAD(ptr)          __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#   define XF_VFS_ATOMIC_U32_STORE(ptr, val)    __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#   define XF_VFS_ATOMIC_U32_FETCH_ADD(ptr, val) __atomic_fetch_add((ptr), (val), __ATOMIC_ACQ_REL)
+#   define XF_VFS_ATOMIC_U32_XCHG(ptr, val)     __atomic_exchange_n((ptr), (val), __ATOMIC_ACQ_REL)
+#   define XF_VFS_ATOMIC_U32_CAS(ptr, pexpected, desired) \
+        __atomic_compare_exchange_n((ptr), (pexpected), (desired), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#else
+#   define XF_VFS_ATOMIC_U32_LOAD(ptr)          xf_vfs_atomic_load_u32(ptr)
+#   define XF_VFS_ATOMIC_U32_STORE(ptr, val)    xf_vfs_atomic_xchg_u32((ptr), (val))
+#   define XF_VFS_ATOMIC_U32_FETCH_ADD(ptr, val) xf_vfs_atomic_fetch_add_u32((ptr), (val))
+#   define XF_VFS_ATOMIC_U32_XCHG(ptr, val)     xf_vfs_atomic_xchg_u32((ptr), (val))
+#   define XF_VFS_ATOMIC_U32_CAS(ptr, pexpected, desired) \
+        xf_vfs_atomic_cas_u32((ptr), (pexpected), (desired))
+#endif
+
+/*
+ * 定义一个静态分配的固定内存池 name，共 n 块，每块至少 size 字节，按 8 字节对齐。
+ */
+#define XF_VFS_POOL_WORDS(size)             (((size) + sizeof(uint64_t) - 1) / sizeof(uint64_t))
+#define XF_VFS_POOL_DEFINE(name, size, n) \
+    static uint64_t name##_mem[(n) * XF_VFS_POOL_WORDS(size)]; \
+    static uint16_t name##_used[(n)]; \
+    static xf_vfs_pool_t name = { \
+        .mem = (uint8_t *)name##_mem, \
+        .used = name##_used, \
+        .block_size = XF_VFS_POOL_WORDS(size) * sizeof(uint64_t), \
+        .count = (n), \
+    }
+
 /* ==================== [Typedefs] ========================================== */
 
+/*
+ * 固定大小块的内存池，用于无堆模式。
+ * 每块的占用标志用 CAS 置位，分配与释放不需要加锁。
+ */
+typedef struct {
+    uint8_t *mem;
+    uint16_t *used;         // 每块的占用标志
+    size_t block_size;
+    uint16_t count;
+    uint16_t in_use;
+    uint16_t peak;
+    uint16_t fails;
+} xf_vfs_pool_t;
+
 typedef struct _xf_vfs_entry_t {
     int flags;              /*!< XF_VFS_FLAG_CONTEXT_PTR and/or XF_VFS_FLAG_READONLY_FS or XF_VFS_FLAG_DEFAULT */
     const xf_vfs_fs_ops_t *vfs;          // contains pointers to VFS functions
-    char path_prefix[XF_VFS_PATH_MAX]; // path prefix mapped to this VFS
+    const char *path_prefix; // path prefix mapped to this VFS, stored in the same allocation as the entry
     size_t path_prefix_len; // micro-optimization to avoid doing extra strlen
+    uint32_t path_prefix_hash; // hash of path_prefix, see xf_vfs_get_vfs_for_path()
     void *ctx;              // optional pointer which can be passed to VFS
     int offset;             // index of this structure in s_vfs array
 } xf_vfs_entry_t;
@@ -101,8 +209,291 @@ const xf_vfs_entry_t *xf_vfs_get_vfs_for_path(const char *path);
  */
 const xf_vfs_entry_t *xf_vfs_get_vfs_for_index(int index);
 
+/**
+ * Allocate a block of at least size bytes from a fixed pool.
+ *
+ * @return Pointer to the block, or NULL if the pool is full or size is larger than the block size.
+ */
+void *xf_vfs_pool_alloc(xf_vfs_pool_t *pool, size_t size);
+
+/**
+ * Return a block allocated by xf_vfs_pool_alloc() to the pool. ptr may be NULL.
+ */
+void xf_vfs_pool_free(xf_vfs_pool_t *pool, void *ptr);
+
+/**
+ * Fill the usage statistics of a fixed pool.
+ */
+void xf_vfs_pool_get_stats(xf_vfs_pool_t *pool, xf_vfs_pool_stats_t *stats);
+
+/**
+ * Fill the allocator part (heap_*) of the memory statistics.
+ */
+void xf_vfs_heap_get_stats(xf_vfs_mem_stats_t *stats);
+
+#if XF_VFS_TRACE_IS_ENABLE
+/**
+ * Start timing a traced call.
+ *
+ * @return Start timestamp to pass to xf_vfs_trace_end(), or 0 if tracing is paused.
+ */
+uint64_t xf_vfs_trace_begin(void);
+
+/**
+ * Write the trace record of a call started by xf_vfs_trace_begin(). Does nothing if start is 0.
+ * errno is preserved.
+ *
+ * @param vfs_index Mount index, or -1 if unknown.
+ * @param fd        File descriptor, or -1 if the call does not involve one.
+ */
+void xf_vfs_trace_end(uint64_t start, int op, int fd, int vfs_index, size_t size, int64_t result);
+#endif
+
+#if XF_VFS_LATENCY_IS_ENABLE
+/**
+ * Add the time elapsed since start (XF_VFS_LATENCY_TIME_NS()) to the latency histogram of (vfs_index, op).
+ * Lock-free; errno is preserved.
+ */
+void xf_vfs_latency_record(int vfs_index, int op, uint64_t start);
+
+/**
+ * Drop the latency histograms of an unregistered mount so their slots can be reused.
+ */
+void xf_vfs_latency_forget(int vfs_index);
+#endif
+
+#if XF_VFS_QOS_IS_ENABLE
+/**
+ * Wait until a read/write/fsync of size bytes on fd (mount vfs_index) is admitted
+ * by the QoS limits and priority classes. errno is preserved.
+ *
+ * @return The class of the call, to pass to xf_vfs_qos_done().
+ */
+int xf_vfs_qos_admit(int vfs_index, int fd, size_t size);
+
+/**
+ * Finish a call admitted by xf_vfs_qos_admit(). errno is preserved.
+ */
+void xf_vfs_qos_done(int vfs_index, int cls);
+
+/**
+ * Drop the QoS settings of fd when it is closed or assigned again.
+ */
+void xf_vfs_qos_fd_reset(int fd);
+
+/**
+ * Drop the QoS settings and statistics of an unregistered mount.
+ */
+void xf_vfs_qos_forget(int vfs_index);
+
+/**
+ * Get the mount index of an open fd.
+ *
+ * @return Index for xf_vfs_get_vfs_for_index(), or -1 if fd is not open.
+ */
+int xf_vfs_get_vfs_index_for_fd(int fd);
+#endif
+
+#if XF_VFS_MERGE_IS_ENABLE
+/**
+ * Whether pwrite merging is enabled on the mount. Lock-free.
+ */
+bool xf_vfs_merge_active(int vfs_index);
+
+/**
+ * Queue a pwrite on fd (mount vfs_index) for merging, and wait until it has been written.
+ * Requests with the same key (the driver's local fd, or its handle on XF_VFS_FLAG_HANDLE
+ * mounts) are on the same driver file and may be merged.
+ *
+ * @return Same as xf_vfs_pwrite64().
+ */
+xf_vfs_ssize_t xf_vfs_merge_pwrite(int vfs_index, int fd, uintptr_t key,
+                                   const void *src, size_t size, xf_vfs_off64_t offset);
+
+/**
+ * Drop the merge state of an unregistered mount.
+ */
+void xf_vfs_merge_forget(int vfs_index);
+
+/**
+ * Call the driver's pwrite for fd directly, bypassing merging, QoS and tracing.
+ */
+xf_vfs_ssize_t xf_vfs_pwrite_driver(int fd, const void *src, size_t size, xf_vfs_off64_t offset);
+#endif
+
+#if XF_VFS_SUPPORT_SERIAL_IS_ENABLE
+/* Kind of a serialized driver call, see xf_vfs_serial_enter() */
+#define XF_VFS_SERIAL_KIND_SHARED   (1 << 0)    // read-only call, may run in parallel with other shared calls
+#define XF_VFS_SERIAL_KIND_FILE     (1 << 1)    // call on an open file or directory stream, keyed by it
+
+/**
+ * Create the locks of a mount registered with XF_VFS_FLAG_SERIAL_FILE or XF_VFS_FLAG_SERIAL_MOUNT.
+ *
+ * @return XF_OK, or XF_ERR_NO_MEM.
+ */
+xf_err_t xf_vfs_serial_attach(int vfs_index, int flags);
+
+/**
+ * Delete the locks of an unregistered mount. No call may be in progress on it.
+ */
+void xf_vfs_serial_detach(int vfs_index);
+
+/**
+ * Take the lock for a driver call of the given kind on an attached mount.
+ * key is the local fd, handle or directory stream for XF_VFS_SERIAL_KIND_FILE calls.
+ */
+void xf_vfs_serial_enter(int vfs_index, int kind, uintptr_t key);
+
+/**
+ * Release the lock taken by xf_vfs_serial_enter() with the same arguments. errno is preserved.
+ */
+void xf_vfs_serial_exit(int vfs_index, int kind, uintptr_t key);
+#endif
+
+#if XF_VFS_SUPPORT_EXECUTOR_IS_ENABLE
+/**
+ * Start the worker thread of a mount registered with XF_VFS_FLAG_EXECUTOR.
+ * ops, flags and ctx are the ones given at registration.
+ *
+ * @return The executor, to be registered as the mount's context, or NULL if out of memory.
+ */
+void *xf_vfs_executor_create(const xf_vfs_fs_ops_t *ops, int flags, void *ctx);
+
+/**
+ * Get the proxy ops of an executor, which queue each call to its worker thread.
+ * They always take the executor as context pointer.
+ */
+const xf_vfs_fs_ops_t *xf_vfs_executor_ops(void *executor);
+
+/**
+ * Stop the worker thread after the queued calls and free the executor.
+ *
+ * @return The ops given to xf_vfs_executor_create().
+ */
+const xf_vfs_fs_ops_t *xf_vfs_executor_destroy(void *executor);
+#endif
+
 /* ==================== [Global Prototypes] ================================= */
 
+#if !XF_VFS_ATOMIC_OFF64_BUILTIN
+static inline xf_vfs_off64_t xf_vfs_atomic_load_off(xf_vfs_off64_t *ptr)
+{
+    XF_VFS_ATOMIC_ENTER();
+    xf_vfs_off64_t val = *ptr;
+    XF_VFS_ATOMIC_EXIT();
+    return val;
+}
+
+static inline void xf_vfs_atomic_store_off(xf_vfs_off64_t *ptr, xf_vfs_off64_t val)
+{
+    XF_VFS_ATOMIC_ENTER();
+    *ptr = val;
+    XF_VFS_ATOMIC_EXIT();
+}
+
+static inline xf_vfs_off64_t xf_vfs_atomic_fetch_add_off(xf_vfs_off64_t *ptr, xf_vfs_off64_t val)
+{
+    XF_VFS_ATOMIC_ENTER();
+    xf_vfs_off64_t old = *ptr;
+    *ptr = old + val;
+    XF_VFS_ATOMIC_EXIT();
+    return old;
+}
+
+static inline bool xf_vfs_atomic_cas_off(xf_vfs_off64_t *ptr, xf_vfs_off64_t *expected, xf_vfs_off64_t desired)
+{
+    XF_VFS_ATOMIC_ENTER();
+    bool ok = (*ptr == *expected);
+    if (ok) {
+        *ptr = desired;
+    } else {
+        *expected = *ptr;
+    }
+    XF_VFS_ATOMIC_EXIT();
+    return ok;
+}
+#endif
+
+#if !XF_VFS_ATOMIC_REF_BUILTIN
+static inline uint16_t xf_vfs_atomic_load_ref(uint16_t *ptr)
+{
+    XF_VFS_ATOMIC_ENTER();
+    uint16_t val = *ptr;
+    XF_VFS_ATOMIC_EXIT();
+    return val;
+}
+
+static inline void xf_vfs_atomic_store_ref(uint16_t *ptr, uint16_t val)
+{
+    XF_VFS_ATOMIC_ENTER();
+    *ptr = val;
+    XF_VFS_ATOMIC_EXIT();
+}
+
+static inline uint16_t xf_vfs_atomic_add_ref(uint16_t *ptr, int val)
+{
+    XF_VFS_ATOMIC_ENTER();
+    uint16_t ret = (uint16_t)(*ptr + val);
+    *ptr = ret;
+    XF_VFS_ATOMIC_EXIT();
+    return ret;
+}
+
+static inline bool xf_vfs_atomic_cas_ref(uint16_t *ptr, uint16_t *expected, uint16_t desired)
+{
+    XF_VFS_ATOMIC_ENTER();
+    bool ok = (*ptr == *expected);
+    if (ok) {
+        *ptr = desired;
+    } else {
+        *expected = *ptr;
+    }
+    XF_VFS_ATOMIC_EXIT();
+    return ok;
+}
+#endif
+
+#if !XF_VFS_ATOMIC_U32_BUILTIN
+static inline uint32_t xf_vfs_atomic_load_u32(uint32_t *ptr)
+{
+    XF_VFS_ATOMIC_ENTER();
+    uint32_t val = *ptr;
+    XF_VFS_ATOMIC_EXIT();
+    return val;
+}
+
+static inline uint32_t xf_vfs_atomic_fetch_add_u32(uint32_t *ptr, uint32_t val)
+{
+    XF_VFS_ATOMIC_ENTER();
+    uint32_t old = *ptr;
+    *ptr = old + val;
+    XF_VFS_ATOMIC_EXIT();
+    return old;
+}
+
+static inline uint32_t xf_vfs_atomic_xchg_u32(uint32_t *ptr, uint32_t val)
+{
+    XF_VFS_ATOMIC_ENTER();
+    uint32_t old = *ptr;
+    *ptr = val;
+    XF_VFS_ATOMIC_EXIT();
+    return old;
+}
+
+static inline bool xf_vfs_atomic_cas_u32(uint32_t *ptr, uint32_t *expected, uint32_t desired)
+{
+    XF_VFS_ATOMIC_ENTER();
+    bool ok = (*ptr == *expected);
+    if (ok) {
+        *ptr = desired;
+    } else {
+        *expected = *ptr;
+    }
+    XF_VFS_ATOMIC_EXIT();
+    return ok;
+}
+#endif
+
 /* ==================== [Macros] ============================================ */
 
 /**
@@ -0,0 +1,367 @@
+/**
+ * @file xf_vfs_qos.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs QoS：令牌桶限速与优先级类别。
+ * @version 1.0
+ * @date 2025-01-23
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs_qos.h"
+#include "xf_vfs_private.h"
+
+#if XF_VFS_QOS_IS_ENABLE
+
+/* ==================== [Defines] =========================================== */
+
+#if !defined(STATIC_ASSERT)
+#   define STATIC_ASSERT(EXPR, ...)     extern char (*_do_assert(void)) [sizeof(char[1 - 2*!(EXPR)])]
+#endif
+
+/* 令牌以百万分之一为单位保存，补充时不因取整丢失 */
+#define TOKEN_SCALE             (1000000)
+
+/* s_fd_qos[] 的低 2 位为类别，其余位为限速槽位下标加 1 */
+#define FD_CLASS_MASK           (0x3u)
+#define FD_SLOT_SHIFT           (2)
+
+STATIC_ASSERT(XF_VFS_QOS_CLASS_MAX - 1 <= FD_CLASS_MASK, "fd class does not fit");
+STATIC_ASSERT(XF_VFS_QOS_FD_SLOTS >= 1 && XF_VFS_QOS_FD_SLOTS <= (0xFF >> FD_SLOT_SHIFT) - 1,
+              "invalid XF_VFS_QOS_FD_SLOTS");
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct {
+    int64_t tokens;             /*!< 令牌数 * TOKEN_SCALE，可以为负 */
+    uint64_t last_ns;           /*!< 上次补充的时间 */
+    uint32_t rate;              /*!< 每秒补充的令牌数，0 为不限制 */
+    uint32_t burst;             /*!< 容量 */
+} bucket_t;
+
+typedef struct {
+    bucket_t bytes;
+    bucket_t ops;
+} qos_limit_state_t;
+
+typedef struct {
+    bool active;                /*!< 调用过 xf_vfs_qos_set_mount() */
+    bool rt_seen;               /*!< rt_last_ns 有效 */
+    uint8_t cls;                /*!< 默认类别 */
+    uint16_t rt_pending;        /*!< 正在进行的实时类别调用数 */
+    uint64_t rt_last_ns;        /*!< 最后一次实时类别调用结束的时间 */
+    qos_limit_state_t limit;
+    xf_vfs_qos_stats_t stats;
+} qos_mount_t;
+
+typedef struct {
+    bool used;
+    qos_limit_state_t limit;
+} qos_fd_slot_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static bool qos_lock_init(void);
+static void bucket_set(bucket_t *b, uint32_t rate, uint32_t burst, uint64_t now);
+static void bucket_refill(bucket_t *b, uint64_t now);
+static uint32_t bucket_wait_us(const bucket_t *b);
+static void bucket_take(bucket_t *b, uint32_t cost);
+static void limit_set(qos_limit_state_t *l, const xf_vfs_qos_limit_t *limit, uint64_t now);
+static uint32_t limit_wait_us(qos_limit_state_t *l, uint64_t now);
+static void limit_take(qos_limit_state_t *l, size_t size);
+static uint32_t realtime_wait_us(const qos_mount_t *m, uint64_t now);
+
+/* ==================== [Static Variables] ================================== */
+
+/* 首次设置时创建，之前所有调用都走快速路径 */
+static xf_lock_t s_lock = NULL;
+static qos_mount_t s_mounts[XF_VFS_MAX_COUNT];
+static uint8_t s_fd_qos[XF_VFS_FDS_MAX];
+static qos_fd_slot_t s_fd_slots[XF_VFS_QOS_FD_SLOTS];
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+xf_err_t xf_vfs_qos_set_mount(const char *path, xf_vfs_qos_class_t cls, const xf_vfs_qos_limit_t *limit)
+{
+    if (path == NULL || (unsigned)cls >= XF_VFS_QOS_CLASS_MAX) {
+        return XF_ERR_INVALID_ARG;
+    }
+    const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(path);
+    if (vfs == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+    if (!qos_lock_init()) {
+        return XF_ERR_NO_MEM;
+    }
+    xf_lock_lock(s_lock);
+    qos_mount_t *m = &s_mounts[vfs->offset];
+    m->active = true;
+    m->cls = (uint8_t)cls;
+    limit_set(&m->limit, limit, XF_VFS_QOS_TIME_NS());
+    xf_lock_unlock(s_lock);
+    return XF_OK;
+}
+
+xf_err_t xf_vfs_qos_set_fd(int fd, xf_vfs_qos_class_t cls, const xf_vfs_qos_limit_t *limit)
+{
+    if ((unsigned)cls >= XF_VFS_QOS_CLASS_MAX || xf_vfs_get_vfs_index_for_fd(fd) < 0) {
+        return XF_ERR_INVALID_ARG;
+    }
+    if (!qos_lock_init()) {
+        return XF_ERR_NO_MEM;
+    }
+    xf_lock_lock(s_lock);
+    int slot = (int)(s_fd_qos[fd] >> FD_SLOT_SHIFT) - 1;
+    if (limit != NULL && slot < 0) {
+        for (int i = 0; i < XF_VFS_QOS_FD_SLOTS; ++i) {
+            if (!s_fd_slots[i].used) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0) {
+            xf_lock_unlock(s_lock);
+            return XF_ERR_NO_MEM;
+        }
+    }
+    if (limit != NULL) {
+        s_fd_slots[slot].used = true;
+        limit_set(&s_fd_slots[slot].limit, limit, XF_VFS_QOS_TIME_NS());
+    } else if (slot >= 0) {
+        s_fd_slots[slot].used = false;
+        slot = -1;
+    }
+    s_fd_qos[fd] = (uint8_t)((unsigned)cls | ((unsigned)(slot + 1) << FD_SLOT_SHIFT));
+    xf_lock_unlock(s_lock);
+    return XF_OK;
+}
+
+xf_err_t xf_vfs_qos_get_stats(const char *path, xf_vfs_qos_stats_t *stats, bool reset)
+{
+    if (path == NULL || stats == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+    const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_path(path);
+    if (vfs == NULL) {
+        return XF_ERR_INVALID_ARG;
+    }
+    if (s_lock == NULL) {
+        xf_memset(stats, 0, sizeof(*stats));
+        return XF_OK;
+    }
+    xf_lock_lock(s_lock);
+    qos_mount_t *m = &s_mounts[vfs->offset];
+    *stats = m->stats;
+    if (reset) {
+        xf_memset(&m->stats, 0, sizeof(m->stats));
+    }
+    xf_lock_unlock(s_lock);
+    return XF_OK;
+}
+
+int xf_vfs_qos_admit(int vfs_index, int fd, size_t size)
+{
+    if (s_lock == NULL || vfs_index < 0 || vfs_index >= XF_VFS_MAX_COUNT) {
+        return XF_VFS_QOS_CLASS_NORMAL;
+    }
+    qos_mount_t *m = &s_mounts[vfs_index];
+    const bool has_fd = (fd >= 0 && fd < XF_VFS_FDS_MAX);
+    /* 没有设置的挂载点与 fd 不加锁、不统计 */
+    if (!m->active && (!has_fd || s_fd_qos[fd] == 0)) {
+        return XF_VFS_QOS_CLASS_NORMAL;
+    }
+
+    xf_lock_lock(s_lock);
+    const uint8_t fq = has_fd ? s_fd_qos[fd] : 0;
+    int cls = (int)(fq & FD_CLASS_MASK);
+    if (cls == XF_VFS_QOS_CLASS_DEFAULT) {
+        cls = (m->cls != XF_VFS_QOS_CLASS_DEFAULT) ? m->cls : XF_VFS_QOS_CLASS_NORMAL;
+    }
+    const int slot = (int)(fq >> FD_SLOT_SHIFT) - 1;
+    qos_limit_state_t *fl = (slot >= 0) ? &s_fd_slots[slot].limit : NULL;
+
+    uint64_t waited = 0;
+    for (;;) {
+        const uint64_t now = XF_VFS_QOS_TIME_NS();
+        uint32_t wait = (cls == XF_VFS_QOS_CLASS_BACKGROUND) ? realtime_wait_us(m, now) : 0;
+        if (wait == 0) {
+            const uint32_t mw = limit_wait_us(&m->limit, now);
+            const uint32_t fw = (fl != NULL) ? limit_wait_us(fl, now) : 0;
+            /* 实时类别只消耗令牌，不等待 */
+            if (cls != XF_VFS_QOS_CLASS_REALTIME) {
+                wait = (mw > fw) ? mw : fw;
+            }
+        }
+        if (wait == 0) {
+            break;
+        }
+        xf_lock_unlock(s_lock);
+        XF_VFS_QOS_DELAY_US(wait);
+        waited += wait;
+        xf_lock_lock(s_lock);
+    }
+
+    limit_take(&m->limit, size);
+    if (fl != NULL) {
+        limit_take(fl, size);
+    }
+    if (cls == XF_VFS_QOS_CLASS_REALTIME) {
+        ++m->rt_pending;
+    }
+    xf_vfs_qos_class_stats_t *st = &m->stats.cls[cls];
+    ++st->ops;
+    st->bytes += size;
+    if (waited != 0) {
+        ++st->throttled;
+        st->wait_us += waited;
+        if (waited > st->max_wait_us) {
+            st->max_wait_us = (waited > UINT32_MAX) ? UINT32_MAX : (uint32_t)waited;
+        }
+    }
+    xf_lock_unlock(s_lock);
+    return cls;
+}
+
+void xf_vfs_qos_done(int vfs_index, int cls)
+{
+    if (cls != XF_VFS_QOS_CLASS_REALTIME) {
+        return;
+    }
+    xf_lock_lock(s_lock);
+    qos_mount_t *m = &s_mounts[vfs_index];
+    if (m->rt_pending != 0) {
+        --m->rt_pending;
+    }
+    m->rt_seen = true;
+    m->rt_last_ns = XF_VFS_QOS_TIME_NS();
+    xf_lock_unlock(s_lock);
+}
+
+void xf_vfs_qos_fd_reset(int fd)
+{
+    if (fd < 0 || fd >= XF_VFS_FDS_MAX || s_fd_qos[fd] == 0) {
+        return;
+    }
+    xf_lock_lock(s_lock);
+    const int slot = (int)(s_fd_qos[fd] >> FD_SLOT_SHIFT) - 1;
+    if (slot >= 0) {
+        s_fd_slots[slot].used = false;
+    }
+    s_fd_qos[fd] = 0;
+    xf_lock_unlock(s_lock);
+}
+
+void xf_vfs_qos_forget(int vfs_index)
+{
+    if (s_lock == NULL || vfs_index < 0 || vfs_index >= XF_VFS_MAX_COUNT) {
+        return;
+    }
+    xf_lock_lock(s_lock);
+    xf_memset(&s_mounts[vfs_index], 0, sizeof(s_mounts[vfs_index]));
+    xf_lock_unlock(s_lock);
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static bool qos_lock_init(void)
+{
+    if (s_lock == NULL) {
+        xf_lock_init(&s_lock);
+    }
+    return s_lock != NULL;
+}
+
+static void bucket_set(bucket_t *b, uint32_t rate, uint32_t burst, uint64_t now)
+{
+    b->rate = rate;
+    if (burst == 0) {
+        burst = (rate / 10 != 0) ? rate / 10 : 1;
+    }
+    b->burst = burst;
+    b->tokens = (int64_t)burst * TOKEN_SCALE;
+    b->last_ns = now;
+}
+
+static void bucket_refill(bucket_t *b, uint64_t now)
+{
+    if (b->rate == 0) {
+        return;
+    }
+    const int64_t full = (int64_t)b->burst * TOKEN_SCALE;
+    const uint64_t elapsed = now - b->last_ns;
+    b->last_ns = now;
+    if (b->tokens >= full) {
+        return;
+    }
+    /* 补满所需的时间（ns），先比较再相乘以免溢出 */
+    const uint64_t to_full = (uint64_t)(full - b->tokens) * 1000 / b->rate;
+    if (elapsed >= to_full) {
+        b->tokens = full;
+    } else {
+        b->tokens += (int64_t)(elapsed * b->rate / 1000);
+    }
+}
+
+static uint32_t bucket_wait_us(const bucket_t *b)
+{
+    if (b->rate == 0 || b->tokens >= 0) {
+        return 0;
+    }
+    const uint64_t us = ((uint64_t)(-b->tokens) + b->rate - 1) / b->rate;
+    return (us > UINT32_MAX) ? UINT32_MAX : (uint32_t)us;
+}
+
+static void bucket_take(bucket_t *b, uint32_t cost)
+{
+    if (b->rate != 0) {
+        b->tokens -= (int64_t)cost * TOKEN_SCALE;
+    }
+}
+
+static void limit_set(qos_limit_state_t *l, const xf_vfs_qos_limit_t *limit, uint64_t now)
+{
+    static const xf_vfs_qos_limit_t s_none = { 0 };
+    if (limit == NULL) {
+        limit = &s_none;
+    }
+    bucket_set(&l->bytes, limit->bytes_per_sec, limit->bytes_burst, now);
+    bucket_set(&l->ops, limit->iops, limit->iops_burst, now);
+}
+
+static uint32_t limit_wait_us(qos_limit_state_t *l, uint64_t now)
+{
+    bucket_refill(&l->bytes, now);
+    bucket_refill(&l->ops, now);
+    const uint32_t bw = bucket_wait_us(&l->bytes);
+    const uint32_t ow = bucket_wait_us(&l->ops);
+    return (bw > ow) ? bw : ow;
+}
+
+static void limit_take(qos_limit_state_t *l, size_t size)
+{
+    bucket_take(&l->bytes, (size > UINT32_MAX) ? UINT32_MAX : (uint32_t)size);
+    bucket_take(&l->ops, 1);
+}
+
+/* 后台类别需要等待的时间：实时调用进行中，或最后一次结束后不足 XF_VFS_QOS_BG_HOLDOFF_US */
+static uint32_t realtime_wait_us(const qos_mount_t *m, uint64_t now)
+{
+    if (m->rt_pending != 0) {
+        return XF_VFS_QOS_POLL_US;
+    }
+    if (!m->rt_seen) {
+        return 0;
+    }
+    const uint64_t since_us = (now - m->rt_last_ns) / 1000;
+    if (since_us >= XF_VFS_QOS_BG_HOLDOFF_US) {
+        return 0;
+    }
+    return (uint32_t)(XF_VFS_QOS_BG_HOLDOFF_US - since_us);
+}
+
+#endif /* XF_VFS_QOS_IS_ENABLE */
@@ -0,0 +1,138 @@
+/**
+ * @file xf_vfs_qos.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs QoS：按挂载点、按 fd 的令牌桶带宽与 IOPS 限制，以及优先级类别。
+ *        实时类别的调用不等待；后台类别的调用在同一挂载点上有实时类别的调用时等待，
+ *        使大量后台读写（如上传日志）时关键路径上的读写延迟仍然有界。
+ * @version 1.0
+ * @date 2025-01-23
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __XF_VFS_QOS_H__
+#define __XF_VFS_QOS_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @cond (XFAPI_USER || XFAPI_PORT || XFAPI_INTERNAL)
+ * @addtogroup group_xf_vfs
+ * @endcond
+ * @{
+ */
+
+/* ==================== [Defines] =========================================== */
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 优先级类别。
+ */
+typedef enum {
+    XF_VFS_QOS_CLASS_DEFAULT = 0,   /*!< fd 使用所在挂载点的类别，挂载点为普通类别 */
+    XF_VFS_QOS_CLASS_REALTIME,      /*!< 实时：不等待，消耗的令牌由其他类别偿还 */
+    XF_VFS_QOS_CLASS_NORMAL,        /*!< 普通：令牌不足时等待 */
+    XF_VFS_QOS_CLASS_BACKGROUND,    /*!< 后台：令牌不足或同一挂载点上有实时调用时等待 */
+    XF_VFS_QOS_CLASS_MAX,
+} xf_vfs_qos_class_t;
+
+/**
+ * @brief 令牌桶限制，速率为 0 表示不限制。
+ *
+ * 令牌数不小于 0 时调用即可开始，并扣除全部令牌（可以扣为负数），
+ * 因此大于桶容量的读写也能进行，之后的调用等待令牌补足。
+ */
+typedef struct {
+    uint32_t bytes_per_sec;     /*!< 带宽（字节/秒） */
+    uint32_t bytes_burst;       /*!< 带宽令牌桶容量（字节），0 为 bytes_per_sec / 10 */
+    uint32_t iops;              /*!< 每秒调用数 */
+    uint32_t iops_burst;        /*!< 调用数令牌桶容量，0 为 iops / 10（至少 1） */
+} xf_vfs_qos_limit_t;
+
+/**
+ * @brief 一个类别的统计。
+ */
+typedef struct {
+    uint32_t ops;               /*!< 调用数 */
+    uint32_t throttled;         /*!< 等待过的调用数 */
+    uint32_t max_wait_us;       /*!< 最长的一次等待（us） */
+    uint64_t bytes;             /*!< 请求的字节数 */
+    uint64_t wait_us;           /*!< 等待的总时间（us） */
+} xf_vfs_qos_class_stats_t;
+
+/**
+ * @brief 一个挂载点的 QoS 统计，按类别（XF_VFS_QOS_CLASS_REALTIME 等）下标。
+ */
+typedef struct {
+    xf_vfs_qos_class_stats_t cls[XF_VFS_QOS_CLASS_MAX];
+} xf_vfs_qos_stats_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+#if XF_VFS_QOS_IS_ENABLE || defined(__DOXYGEN__)
+
+/**
+ * @brief 设置挂载点的默认类别与限制。
+ *
+ * 受 QoS 控制的调用为 read、write、pread、pwrite（及 64 位版本）与 fsync，
+ * 每次调用消耗 1 个调用数令牌与 size 个带宽令牌（fsync 为 0）。
+ *
+ * @param path  挂载点内的任意路径，如 "/sd".
+ * @param cls   没有单独设置类别的 fd 使用的类别。
+ * @param limit 挂载点上所有调用共用的限制，NULL 为不限制。
+ *
+ * @return  XF_OK if successful.
+ *          XF_ERR_INVALID_ARG if no mount matches path or cls is invalid.
+ *          XF_ERR_NO_MEM if the lock could not be created.
+ */
+xf_err_t xf_vfs_qos_set_mount(const char *path, xf_vfs_qos_class_t cls, const xf_vfs_qos_limit_t *limit);
+
+/**
+ * @brief 设置 fd 的类别与单独的限制，fd 关闭后恢复默认。
+ *
+ * fd 的调用同时受 fd 与挂载点的限制（实时类别只消耗令牌，不等待）。
+ * xf_vfs_dup() 等复制出的 fd 不继承设置。
+ *
+ * @param fd    已打开的 fd.
+ * @param cls   类别，XF_VFS_QOS_CLASS_DEFAULT 为使用挂载点的类别。
+ * @param limit 只对该 fd 的限制，NULL 为不限制。
+ *
+ * @return  XF_OK if successful.
+ *          XF_ERR_INVALID_ARG if fd is not open or cls is invalid.
+ *          XF_ERR_NO_MEM if XF_VFS_QOS_FD_SLOTS fds already have limits, or the lock could not be created.
+ */
+xf_err_t xf_vfs_qos_set_fd(int fd, xf_vfs_qos_class_t cls, const xf_vfs_qos_limit_t *limit);
+
+/**
+ * @brief 获取挂载点的 QoS 统计。
+ *
+ * @param path  挂载点内的任意路径。
+ * @param stats 输出。
+ * @param reset 是否在获取后清零。
+ *
+ * @return XF_OK if successful, XF_ERR_INVALID_ARG if no mount matches path.
+ */
+xf_err_t xf_vfs_qos_get_stats(const char *path, xf_vfs_qos_stats_t *stats, bool reset);
+
+#endif /* XF_VFS_QOS_IS_ENABLE || defined(__DOXYGEN__) */
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * End of addtogroup group_xf_vfs
+ * @}
+ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __XF_VFS_QOS_H__ */
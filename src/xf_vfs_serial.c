@@ -0,0 +1,255 @@
+/**
+ * @file xf_vfs_serial.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs 驱动调用的串行化（XF_VFS_FLAG_SERIAL_FILE / XF_VFS_FLAG_SERIAL_MOUNT）。
+ * @version 1.0
+ * @date 2025-01-25
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs.h"
+#include "xf_vfs_private.h"
+
+#if XF_VFS_SUPPORT_SERIAL_IS_ENABLE
+
+/* ==================== [Defines] =========================================== */
+
+#if !defined(STATIC_ASSERT)
+#   define STATIC_ASSERT(EXPR, ...)     extern char (*_do_assert(void)) [sizeof(char[1 - 2*!(EXPR)])]
+#endif
+
+STATIC_ASSERT(XF_VFS_SERIAL_FILE_LOCKS >= 1 && XF_VFS_SERIAL_FILE_LOCKS <= 256, "invalid XF_VFS_SERIAL_FILE_LOCKS");
+
+/* 读写锁需要信号量，没有 xf_osal 时读操作也互斥 */
+#define SERIAL_RWLOCK           (XF_VFS_SUPPORT_SELECT_IS_ENABLE || XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE)
+
+#if SERIAL_RWLOCK
+#include "xf_osal.h"
+#endif
+
+/* ==================== [Typedefs] ========================================== */
+
+/*
+ * 写者不会饿死的读写锁：写者持有 turnstile 直到结束，挡住其后到来的读者；
+ * 第一个读者或写者取走 room，最后一个读者归还，因此 room 用信号量而不是互斥锁。
+ */
+typedef struct {
+    xf_lock_t mutex;                /*!< 保护 readers，没有 xf_osal 时即整把锁 */
+#if SERIAL_RWLOCK
+    xf_lock_t turnstile;
+    xf_osal_semaphore_t room;       /*!< 空闲时计数为 1 */
+    uint16_t readers;
+#endif
+} serial_rwlock_t;
+
+typedef struct {
+    serial_rwlock_t mount;          /*!< 路径操作，SERIAL_MOUNT 时为所有操作 */
+    uint16_t file_locks;            /*!< file[] 的个数，SERIAL_MOUNT 时为 0 */
+    serial_rwlock_t file[];         /*!< 按 local fd、句柄或目录流散列 */
+} serial_mount_t;
+
+/* ==================== [Static Prototypes] ================================= */
+
+static serial_rwlock_t *serial_lock_for(int vfs_index, int kind, uintptr_t key);
+static xf_err_t rwlock_init(serial_rwlock_t *l);
+static void rwlock_deinit(serial_rwlock_t *l);
+static void rwlock_rdlock(serial_rwlock_t *l);
+static void rwlock_rdunlock(serial_rwlock_t *l);
+static void rwlock_wrlock(serial_rwlock_t *l);
+static void rwlock_wrunlock(serial_rwlock_t *l);
+
+/* ==================== [Static Variables] ================================== */
+
+static serial_mount_t *s_mounts[XF_VFS_MAX_COUNT];
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+xf_err_t xf_vfs_serial_attach(int vfs_index, int flags)
+{
+    const uint16_t file_locks = (flags & XF_VFS_FLAG_SERIAL_FILE) ? XF_VFS_SERIAL_FILE_LOCKS : 0;
+    serial_mount_t *m = xf_vfs_malloc(sizeof(serial_mount_t) + file_locks * sizeof(serial_rwlock_t));
+    if (m == NULL) {
+        return XF_ERR_NO_MEM;
+    }
+    xf_memset(m, 0, sizeof(serial_mount_t) + file_locks * sizeof(serial_rwlock_t));
+    if (rwlock_init(&m->mount) != XF_OK) {
+        xf_vfs_free(m);
+        return XF_ERR_NO_MEM;
+    }
+    for (uint16_t i = 0; i < file_locks; ++i) {
+        if (rwlock_init(&m->file[i]) != XF_OK) {
+            m->file_locks = i;
+            s_mounts[vfs_index] = m;
+            xf_vfs_serial_detach(vfs_index);
+            return XF_ERR_NO_MEM;
+        }
+    }
+    m->file_locks = file_locks;
+    s_mounts[vfs_index] = m;
+    return XF_OK;
+}
+
+void xf_vfs_serial_detach(int vfs_index)
+{
+    if (vfs_index < 0 || vfs_index >= XF_VFS_MAX_COUNT || s_mounts[vfs_index] == NULL) {
+        return;
+    }
+    serial_mount_t *m = s_mounts[vfs_index];
+    s_mounts[vfs_index] = NULL;
+    rwlock_deinit(&m->mount);
+    for (uint16_t i = 0; i < m->file_locks; ++i) {
+        rwlock_deinit(&m->file[i]);
+    }
+    xf_vfs_free(m);
+}
+
+void xf_vfs_serial_enter(int vfs_index, int kind, uintptr_t key)
+{
+    serial_rwlock_t *l = serial_lock_for(vfs_index, kind, key);
+    if (kind & XF_VFS_SERIAL_KIND_SHARED) {
+        rwlock_rdlock(l);
+    } else {
+        rwlock_wrlock(l);
+    }
+}
+
+void xf_vfs_serial_exit(int vfs_index, int kind, uintptr_t key)
+{
+    const int err = errno;
+    serial_rwlock_t *l = serial_lock_for(vfs_index, kind, key);
+    if (kind & XF_VFS_SERIAL_KIND_SHARED) {
+        rwlock_rdunlock(l);
+    } else {
+        rwlock_wrunlock(l);
+    }
+    errno = err;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static serial_rwlock_t *serial_lock_for(int vfs_index, int kind, uintptr_t key)
+{
+    serial_mount_t *m = s_mounts[vfs_index];
+    if (!(kind & XF_VFS_SERIAL_KIND_FILE) || m->file_locks == 0) {
+        return &m->mount;
+    }
+    /* local fd 是小整数，句柄与目录流是对齐的指针，混入高位后再取模 */
+    key ^= (key >> 4) ^ (key >> 12);
+    return &m->file[key % m->file_locks];
+}
+
+#if SERIAL_RWLOCK
+
+static xf_err_t rwlock_init(serial_rwlock_t *l)
+{
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "serial",
+    };
+    l->room = xf_osal_semaphore_create(1, 1, &sem_attr);
+    if (l->room == NULL) {
+        return XF_ERR_NO_MEM;
+    }
+    if (xf_lock_init(&l->mutex) != XF_OK) {
+        xf_osal_semaphore_delete(l->room);
+        l->room = NULL;
+        return XF_ERR_NO_MEM;
+    }
+    if (xf_lock_init(&l->turnstile) != XF_OK) {
+        xf_lock_destroy(l->mutex);
+        xf_osal_semaphore_delete(l->room);
+        l->room = NULL;
+        return XF_ERR_NO_MEM;
+    }
+    l->readers = 0;
+    return XF_OK;
+}
+
+static void rwlock_deinit(serial_rwlock_t *l)
+{
+    if (l->room == NULL) {
+        return;
+    }
+    xf_lock_destroy(l->turnstile);
+    xf_lock_destroy(l->mutex);
+    xf_osal_semaphore_delete(l->room);
+    l->room = NULL;
+}
+
+static void rwlock_rdlock(serial_rwlock_t *l)
+{
+    /* 有写者在等待时在此排队 */
+    xf_lock_lock(l->turnstile);
+    xf_lock_unlock(l->turnstile);
+
+    xf_lock_lock(l->mutex);
+    if (++l->readers == 1) {
+        xf_osal_semaphore_acquire(l->room, XF_OSAL_WAIT_FOREVER);
+    }
+    xf_lock_unlock(l->mutex);
+}
+
+static void rwlock_rdunlock(serial_rwlock_t *l)
+{
+    xf_lock_lock(l->mutex);
+    if (--l->readers == 0) {
+        xf_osal_semaphore_release(l->room);
+    }
+    xf_lock_unlock(l->mutex);
+}
+
+static void rwlock_wrlock(serial_rwlock_t *l)
+{
+    xf_lock_lock(l->turnstile);
+    xf_osal_semaphore_acquire(l->room, XF_OSAL_WAIT_FOREVER);
+}
+
+static void rwlock_wrunlock(serial_rwlock_t *l)
+{
+    xf_osal_semaphore_release(l->room);
+    xf_lock_unlock(l->turnstile);
+}
+
+#else
+
+static xf_err_t rwlock_init(serial_rwlock_t *l)
+{
+    return (xf_lock_init(&l->mutex) == XF_OK) ? XF_OK : XF_ERR_NO_MEM;
+}
+
+static void rwlock_deinit(serial_rwlock_t *l)
+{
+    if (l->mutex != NULL) {
+        xf_lock_destroy(l->mutex);
+        l->mutex = NULL;
+    }
+}
+
+static void rwlock_rdlock(serial_rwlock_t *l)
+{
+    xf_lock_lock(l->mutex);
+}
+
+static void rwlock_rdunlock(serial_rwlock_t *l)
+{
+    xf_lock_unlock(l->mutex);
+}
+
+static void rwlock_wrlock(serial_rwlock_t *l)
+{
+    xf_lock_lock(l->mutex);
+}
+
+static void rwlock_wrunlock(serial_rwlock_t *l)
+{
+    xf_lock_unlock(l->mutex);
+}
+
+#endif /* SERIAL_RWLOCK */
+
+#endif /* XF_VFS_SUPPORT_SERIAL_IS_ENABLE */
@@ -52,10 +52,46 @@ typedef struct {
     char                d_name[XF_VFS_DIRENT_NAME_SIZE]; /*!< The null-terminated file name */
 } xf_vfs_dirent_t;
 
+/**
+ * @brief xf_vfs_getdents() 填充的紧凑目录项记录。
+ *
+ * 记录在缓冲区中依次排列，长度随名称变化（见 XF_VFS_DIRENT_REC_LEN()），
+ * 下一条记录位于 XF_VFS_DIRENT_REC_NEXT(rec).
+ */
+typedef struct {
+    xf_vfs_ino_t        d_ino;
+    uint16_t            d_reclen;   /*!< 本记录的长度，含结尾 '\0' 及对齐填充 */
+    uint16_t            d_namlen;   /*!< 名称长度，不含结尾 '\0' */
+    uint8_t             d_type;     /*!< XF_VFS_DT_* */
+    char                d_name[];   /*!< The null-terminated file name */
+} xf_vfs_dirent_rec_t;
+
 /* ==================== [Global Prototypes] ================================= */
 
 /* ==================== [Macros] ============================================ */
 
+/**
+ * @brief 紧凑目录项记录的对齐字节数，xf_vfs_getdents() 的缓冲区也应按此对齐。
+ */
+#define XF_VFS_DIRENT_REC_ALIGN         (sizeof(xf_vfs_ino_t))
+
+/**
+ * @brief 名称长度为 namlen 的紧凑目录项记录的长度。
+ */
+#define XF_VFS_DIRENT_REC_LEN(namlen) \
+    ((offsetof(xf_vfs_dirent_rec_t, d_name) + (namlen) + 1 + XF_VFS_DIRENT_REC_ALIGN - 1) \
+     & ~(XF_VFS_DIRENT_REC_ALIGN - 1))
+
+/**
+ * @brief 能容纳任意名称的记录长度，xf_vfs_getdents() 的缓冲区不应小于此值。
+ */
+#define XF_VFS_DIRENT_REC_MAX           XF_VFS_DIRENT_REC_LEN(XF_VFS_DIRENT_NAME_SIZE - 1)
+
+/**
+ * @brief 缓冲区中的下一条记录。
+ */
+#define XF_VFS_DIRENT_REC_NEXT(rec)     ((xf_vfs_dirent_rec_t *)((char *)(rec) + (rec)->d_reclen))
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
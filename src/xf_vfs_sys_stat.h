@@ -60,6 +60,20 @@ extern "C" {
 #define     XF_VFS_S_IWOTH 0000002  /*!< 写权限，其他 */
 #define     XF_VFS_S_IXOTH 0000001  /*!< 执行/搜索权限，其他 */
 
+/**
+ * xf_vfs_statx() 的字段掩码，也用于 xf_vfs_statx_t::stx_mask.
+ */
+#define XF_VFS_STATX_TYPE           0x0001U /*!< stx_mode 中的文件类型（XF_VFS_S_IFMT） */
+#define XF_VFS_STATX_MODE           0x0002U /*!< stx_mode 中的权限位 */
+#define XF_VFS_STATX_SIZE           0x0004U /*!< stx_size */
+#define XF_VFS_STATX_ATIME          0x0008U /*!< stx_actime */
+#define XF_VFS_STATX_MTIME          0x0010U /*!< stx_modtime */
+#define XF_VFS_STATX_CTIME          0x0020U /*!< stx_chtime */
+#define XF_VFS_STATX_BLKSIZE        0x0040U /*!< stx_blksize */
+#define XF_VFS_STATX_BLOCKS         0x0080U /*!< stx_blocks */
+#define XF_VFS_STATX_DEV            0x0100U /*!< stx_dev */
+#define XF_VFS_STATX_BASIC_STATS    0x01FFU /*!< xf_vfs_stat_t 中的所有字段 */
+
 /* ==================== [Typedefs] ========================================== */
 
 typedef struct xf_vfs_stat {
@@ -79,6 +93,35 @@ typedef struct xf_vfs_stat {
     xf_vfs_blkcnt_t     st_blocks;     /*!< 文件块数 */
 } xf_vfs_stat_t;
 
+/**
+ * 使用 64 位文件大小的 xf_vfs_stat_t, 见 xf_vfs_fstat64().
+ */
+typedef struct xf_vfs_stat64 {
+    xf_vfs_dev_t        st_dev;        /*!< Device.  */
+    xf_vfs_mode_t       st_mode;       /*!< 文件模式 */
+    xf_vfs_off64_t      st_size;       /*!< 文件字节数 */
+    xf_vfs_time_t       st_actime;     /*!< 上次访问时间 */
+    xf_vfs_time_t       st_modtime;    /*!< 最后修改时间 */
+    xf_vfs_time_t       st_chtime;     /*!< 最后一次状态改变的时间 */
+    xf_vfs_blksize_t    st_blksize;    /*!< I/O 的最佳块大小。 */
+    xf_vfs_blkcnt_t     st_blocks;     /*!< 文件块数 */
+} xf_vfs_stat64_t;
+
+/**
+ * xf_vfs_statx() 的结果。只有 stx_mask 中的字段有效，其余字段为 0.
+ */
+typedef struct xf_vfs_statx {
+    uint32_t            stx_mask;      /*!< 已填充的字段，XF_VFS_STATX_* */
+    xf_vfs_dev_t        stx_dev;       /*!< Device.  */
+    xf_vfs_mode_t       stx_mode;      /*!< 文件模式 */
+    xf_vfs_off64_t      stx_size;      /*!< 文件字节数 */
+    xf_vfs_time_t       stx_actime;    /*!< 上次访问时间 */
+    xf_vfs_time_t       stx_modtime;   /*!< 最后修改时间 */
+    xf_vfs_time_t       stx_chtime;    /*!< 最后一次状态改变的时间 */
+    xf_vfs_blksize_t    stx_blksize;   /*!< I/O 的最佳块大小。 */
+    xf_vfs_blkcnt_t     stx_blocks;    /*!< 文件块数 */
+} xf_vfs_statx_t;
+
 /* ==================== [Global Prototypes] ================================= */
 
 /* ==================== [Macros] ============================================ */
@@ -37,6 +37,12 @@ typedef unsigned long   xf_vfs_mode_t;
 
 typedef long            xf_vfs_off_t;
 
+/**
+ * 64 位文件偏移，用于 xf_vfs_lseek64() 等接口。
+ * 32 位平台上 xf_vfs_off_t 只能表示 2 GiB 以内的文件。
+ */
+typedef int64_t         xf_vfs_off64_t;
+
 typedef long            xf_vfs_blksize_t;
 typedef long            xf_vfs_blkcnt_t;
 
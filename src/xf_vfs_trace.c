@@ -0,0 +1,278 @@
+/**
+ * @file xf_vfs_trace.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs 操作跟踪：每次调用记录一条定长二进制记录，用于事后分析卡顿与突发。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs_trace.h"
+#include "xf_vfs_private.h"
+
+#if XF_VFS_TRACE_IS_ENABLE && XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE
+#include "xf_osal.h"
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#if XF_VFS_TRACE_IS_ENABLE
+
+#if !defined(STATIC_ASSERT)
+#   define STATIC_ASSERT(EXPR, ...)     extern char (*_do_assert(void)) [sizeof(char[1 - 2*!(EXPR)])]
+#endif
+
+/*
+ * 记录的 seq 为其在环形缓冲区中的序号（低 15 位）加上 SEQ_VALID.
+ * 写入期间 seq 为 0，读取时据此跳过未写完或被覆盖的记录。
+ */
+#define SEQ_VALID               (0x8000u)
+#define SEQ_MASK                (0x7FFFu)
+
+/* 环形缓冲区的绑定状态 */
+#define RING_FREE               (0)
+#define RING_CLAIMING           (1)
+#define RING_OWNED              (2)
+
+STATIC_ASSERT(sizeof(xf_vfs_trace_rec_t) == 32, "trace record must be 32 bytes");
+STATIC_ASSERT((XF_VFS_TRACE_RING_SIZE & (XF_VFS_TRACE_RING_SIZE - 1)) == 0
+              && XF_VFS_TRACE_RING_SIZE <= (SEQ_MASK + 1), "invalid XF_VFS_TRACE_RING_SIZE");
+STATIC_ASSERT(XF_VFS_TRACE_RINGS >= 1 && XF_VFS_TRACE_RINGS <= 255, "invalid XF_VFS_TRACE_RINGS");
+#endif
+
+/* ==================== [Typedefs] ========================================== */
+
+#if XF_VFS_TRACE_IS_ENABLE
+
+/*
+ * 一个环形缓冲区。
+ * 写入位置由 head 原子递增取得，因此共用同一缓冲区的多个线程也不需要加锁。
+ */
+typedef struct {
+    uint16_t head;              // 下一条记录的序号，原子访问
+    uint16_t state;             // RING_*，原子访问
+    uintptr_t owner;            // 绑定的线程 ID，state 为 RING_OWNED 时有效
+    xf_vfs_trace_rec_t recs[XF_VFS_TRACE_RING_SIZE];
+} trace_ring_t;
+#endif
+
+/* ==================== [Static Prototypes] ================================= */
+
+#if XF_VFS_TRACE_IS_ENABLE
+static uint8_t ring_for_thread(void);
+static bool dump_write(xf_vfs_trace_write_t write, void *arg, const void *data, size_t size, xf_vfs_ssize_t *total);
+static bool dump_string(xf_vfs_trace_write_t write, void *arg, const char *str, xf_vfs_ssize_t *total);
+#endif
+
+/* ==================== [Static Variables] ================================== */
+
+#if XF_VFS_TRACE_IS_ENABLE
+static trace_ring_t s_rings[XF_VFS_TRACE_RINGS];
+static volatile bool s_enabled = true;
+#endif
+
+static const char *const s_op_names[XF_VFS_TRACE_OP_MAX] = {
+    [XF_VFS_TRACE_OP_OPEN]      = "open",
+    [XF_VFS_TRACE_OP_CLOSE]     = "close",
+    [XF_VFS_TRACE_OP_READ]      = "read",
+    [XF_VFS_TRACE_OP_WRITE]     = "write",
+    [XF_VFS_TRACE_OP_PREAD]     = "pread",
+    [XF_VFS_TRACE_OP_PWRITE]    = "pwrite",
+    [XF_VFS_TRACE_OP_LSEEK]     = "lseek",
+    [XF_VFS_TRACE_OP_DUP]       = "dup",
+    [XF_VFS_TRACE_OP_FSTAT]     = "fstat",
+    [XF_VFS_TRACE_OP_FCNTL]     = "fcntl",
+    [XF_VFS_TRACE_OP_IOCTL]     = "ioctl",
+    [XF_VFS_TRACE_OP_FSYNC]     = "fsync",
+    [XF_VFS_TRACE_OP_FTRUNCATE] = "ftruncate",
+    [XF_VFS_TRACE_OP_STAT]      = "stat",
+    [XF_VFS_TRACE_OP_UTIME]     = "utime",
+    [XF_VFS_TRACE_OP_LINK]      = "link",
+    [XF_VFS_TRACE_OP_UNLINK]    = "unlink",
+    [XF_VFS_TRACE_OP_RENAME]    = "rename",
+    [XF_VFS_TRACE_OP_OPENDIR]   = "opendir",
+    [XF_VFS_TRACE_OP_READDIR]   = "readdir",
+    [XF_VFS_TRACE_OP_TELLDIR]   = "telldir",
+    [XF_VFS_TRACE_OP_SEEKDIR]   = "seekdir",
+    [XF_VFS_TRACE_OP_CLOSEDIR]  = "closedir",
+    [XF_VFS_TRACE_OP_GETDENTS]  = "getdents",
+    [XF_VFS_TRACE_OP_MKDIR]     = "mkdir",
+    [XF_VFS_TRACE_OP_RMDIR]     = "rmdir",
+    [XF_VFS_TRACE_OP_ACCESS]    = "access",
+    [XF_VFS_TRACE_OP_TRUNCATE]  = "truncate",
+    [XF_VFS_TRACE_OP_SELECT]    = "select",
+};
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+const char *xf_vfs_trace_op_name(xf_vfs_trace_op_t op)
+{
+    if ((unsigned)op >= XF_VFS_TRACE_OP_MAX) {
+        return "?";
+    }
+    return s_op_names[op];
+}
+
+#if XF_VFS_TRACE_IS_ENABLE
+
+void xf_vfs_trace_enable(bool enable)
+{
+    s_enabled = enable;
+}
+
+bool xf_vfs_trace_is_enabled(void)
+{
+    return s_enabled;
+}
+
+void xf_vfs_trace_clear(void)
+{
+    xf_memset(s_rings, 0, sizeof(s_rings));
+}
+
+xf_vfs_ssize_t xf_vfs_trace_dump(xf_vfs_trace_write_t write, void *arg)
+{
+    const bool enabled = s_enabled;
+    s_enabled = false;
+
+    xf_vfs_ssize_t total = 0;
+    xf_vfs_trace_header_t header = {
+        .magic = XF_VFS_TRACE_MAGIC,
+        .version = XF_VFS_TRACE_VERSION,
+        .rec_size = sizeof(xf_vfs_trace_rec_t),
+        .op_count = XF_VFS_TRACE_OP_MAX,
+        .mount_count = 0,
+        .ring_size = XF_VFS_TRACE_RING_SIZE,
+        .rings = XF_VFS_TRACE_RINGS,
+    };
+    for (int i = 0; i < XF_VFS_MAX_COUNT; ++i) {
+        header.mount_count += (xf_vfs_get_vfs_for_index(i) != NULL);
+    }
+    bool ok = dump_write(write, arg, &header, sizeof(header), &total);
+    for (int op = 0; ok && op < XF_VFS_TRACE_OP_MAX; ++op) {
+        ok = dump_string(write, arg, s_op_names[op], &total);
+    }
+    for (int i = 0; ok && i < XF_VFS_MAX_COUNT; ++i) {
+        const xf_vfs_entry_t *vfs = xf_vfs_get_vfs_for_index(i);
+        if (vfs == NULL) {
+            continue;
+        }
+        const uint8_t index = (uint8_t)i;
+        ok = dump_write(write, arg, &index, 1, &total)
+             && dump_string(write, arg, vfs->path_prefix, &total);
+    }
+
+    /* 从最早的记录开始，跳过空槽及导出期间被覆盖的记录 */
+    for (int r = 0; ok && r < XF_VFS_TRACE_RINGS; ++r) {
+        trace_ring_t *ring = &s_rings[r];
+        const uint16_t head = XF_VFS_ATOMIC_REF_LOAD(&ring->head);
+        for (uint32_t n = 0; ok && n < XF_VFS_TRACE_RING_SIZE; ++n) {
+            const uint16_t seq = (uint16_t)(head + n);
+            xf_vfs_trace_rec_t *slot = &ring->recs[seq & (XF_VFS_TRACE_RING_SIZE - 1)];
+            const uint16_t tag = XF_VFS_ATOMIC_REF_LOAD(&slot->seq);
+            if (!(tag & SEQ_VALID)) {
+                continue;
+            }
+            xf_vfs_trace_rec_t rec = *slot;
+            if (XF_VFS_ATOMIC_REF_LOAD(&slot->seq) != tag) {
+                continue;
+            }
+            ok = dump_write(write, arg, &rec, sizeof(rec), &total);
+        }
+    }
+
+    s_enabled = enabled;
+    return ok ? total : -1;
+}
+
+uint64_t xf_vfs_trace_begin(void)
+{
+    if (!s_enabled) {
+        return 0;
+    }
+    const uint64_t now = XF_VFS_TRACE_TIME_NS();
+    return (now != 0) ? now : 1;
+}
+
+void xf_vfs_trace_end(uint64_t start, int op, int fd, int vfs_index, size_t size, int64_t result)
+{
+    if (start == 0) {
+        return;
+    }
+    const int err = errno;
+    const uint64_t dur = XF_VFS_TRACE_TIME_NS() - start;
+    const uint8_t r = ring_for_thread();
+    trace_ring_t *ring = &s_rings[r];
+    const uint16_t seq = (uint16_t)(XF_VFS_ATOMIC_REF_INC(&ring->head) - 1);
+    xf_vfs_trace_rec_t *rec = &ring->recs[seq & (XF_VFS_TRACE_RING_SIZE - 1)];
+
+    XF_VFS_ATOMIC_REF_STORE(&rec->seq, 0);
+    rec->ts = start;
+    rec->dur = (dur > UINT32_MAX) ? UINT32_MAX : (uint32_t)dur;
+    rec->size = (size > UINT32_MAX) ? UINT32_MAX : (uint32_t)size;
+    rec->result = (result > INT32_MAX) ? INT32_MAX : (result < INT32_MIN) ? INT32_MIN : (int32_t)result;
+    rec->fd = (int16_t)fd;
+    rec->err = (result < 0) ? (uint16_t)err : 0;
+    rec->op = (uint8_t)op;
+    rec->vfs = (vfs_index >= 0) ? (uint8_t)vfs_index : XF_VFS_TRACE_VFS_NONE;
+    rec->ring = r;
+    XF_VFS_ATOMIC_REF_STORE(&rec->seq, (uint16_t)((seq & SEQ_MASK) | SEQ_VALID));
+
+    errno = err;
+}
+
+#endif /* XF_VFS_TRACE_IS_ENABLE */
+
+/* ==================== [Static Functions] ================================== */
+
+#if XF_VFS_TRACE_IS_ENABLE
+
+/*
+ * 当前线程使用的环形缓冲区。
+ * 优先使用已绑定的，其次绑定一个空闲的，都没有时按线程 ID 与其他线程共用。
+ */
+static uint8_t ring_for_thread(void)
+{
+    const uintptr_t tid = XF_VFS_TRACE_THREAD_ID();
+    for (int i = 0; i < XF_VFS_TRACE_RINGS; ++i) {
+        if (XF_VFS_ATOMIC_REF_LOAD(&s_rings[i].state) == RING_OWNED && s_rings[i].owner == tid) {
+            return (uint8_t)i;
+        }
+    }
+    for (int i = 0; i < XF_VFS_TRACE_RINGS; ++i) {
+        uint16_t expected = RING_FREE;
+        if (XF_VFS_ATOMIC_REF_LOAD(&s_rings[i].state) == RING_FREE
+                && XF_VFS_ATOMIC_REF_CAS(&s_rings[i].state, &expected, RING_CLAIMING)) {
+            s_rings[i].owner = tid;
+            XF_VFS_ATOMIC_REF_STORE(&s_rings[i].state, RING_OWNED);
+            return (uint8_t)i;
+        }
+    }
+    return (uint8_t)(tid % XF_VFS_TRACE_RINGS);
+}
+
+static bool dump_write(xf_vfs_trace_write_t write, void *arg, const void *data, size_t size, xf_vfs_ssize_t *total)
+{
+    if (write(data, size, arg) != (xf_vfs_ssize_t)size) {
+        return false;
+    }
+    *total += (xf_vfs_ssize_t)size;
+    return true;
+}
+
+/* 1 字节长度加不含 '\0' 的字符，超过 255 的部分被截断 */
+static bool dump_string(xf_vfs_trace_write_t write, void *arg, const char *str, xf_vfs_ssize_t *total)
+{
+    const size_t len = xf_strlen(str);
+    const uint8_t len8 = (len > 0xFF) ? 0xFF : (uint8_t)len;
+    return dump_write(write, arg, &len8, 1, total)
+           && (len8 == 0 || dump_write(write, arg, str, len8, total));
+}
+
+#endif /* XF_VFS_TRACE_IS_ENABLE */
@@ -0,0 +1,177 @@
+/**
+ * @file xf_vfs_trace.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs 操作跟踪：每次调用记录一条定长二进制记录，用于事后分析卡顿与突发。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __XF_VFS_TRACE_H__
+#define __XF_VFS_TRACE_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @cond (XFAPI_USER || XFAPI_PORT || XFAPI_INTERNAL)
+ * @addtogroup group_xf_vfs
+ * @endcond
+ * @{
+ */
+
+/* ==================== [Defines] =========================================== */
+
+#if XF_VFS_TRACE_IS_ENABLE || defined(__DOXYGEN__)
+
+#define XF_VFS_TRACE_MAGIC          "XFVT"  /*!< 导出数据开头的 4 字节 */
+#define XF_VFS_TRACE_VERSION        (1)     /*!< 导出数据格式的版本 */
+#define XF_VFS_TRACE_VFS_NONE       (0xFF)  /*!< xf_vfs_trace_rec_t::vfs 未知 */
+
+#endif
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 被跟踪的操作，也用于延迟直方图（xf_vfs_latency.h）。
+ * 32 位版本（如 xf_vfs_lseek()）按 64 位版本记录；*at 函数与对应的路径函数记录为同一操作。
+ */
+typedef enum {
+    XF_VFS_TRACE_OP_OPEN = 0,
+    XF_VFS_TRACE_OP_CLOSE,
+    XF_VFS_TRACE_OP_READ,
+    XF_VFS_TRACE_OP_WRITE,
+    XF_VFS_TRACE_OP_PREAD,
+    XF_VFS_TRACE_OP_PWRITE,
+    XF_VFS_TRACE_OP_LSEEK,
+    XF_VFS_TRACE_OP_DUP,
+    XF_VFS_TRACE_OP_FSTAT,
+    XF_VFS_TRACE_OP_FCNTL,
+    XF_VFS_TRACE_OP_IOCTL,
+    XF_VFS_TRACE_OP_FSYNC,
+    XF_VFS_TRACE_OP_FTRUNCATE,
+    XF_VFS_TRACE_OP_STAT,
+    XF_VFS_TRACE_OP_UTIME,
+    XF_VFS_TRACE_OP_LINK,
+    XF_VFS_TRACE_OP_UNLINK,
+    XF_VFS_TRACE_OP_RENAME,
+    XF_VFS_TRACE_OP_OPENDIR,
+    XF_VFS_TRACE_OP_READDIR,
+    XF_VFS_TRACE_OP_TELLDIR,
+    XF_VFS_TRACE_OP_SEEKDIR,
+    XF_VFS_TRACE_OP_CLOSEDIR,
+    XF_VFS_TRACE_OP_GETDENTS,
+    XF_VFS_TRACE_OP_MKDIR,
+    XF_VFS_TRACE_OP_RMDIR,
+    XF_VFS_TRACE_OP_ACCESS,
+    XF_VFS_TRACE_OP_TRUNCATE,
+    XF_VFS_TRACE_OP_SELECT,
+    XF_VFS_TRACE_OP_MAX,
+} xf_vfs_trace_op_t;
+
+#if XF_VFS_TRACE_IS_ENABLE || defined(__DOXYGEN__)
+
+/**
+ * @brief 一条跟踪记录，32 字节。
+ */
+typedef struct {
+    uint64_t ts;                /*!< 调用开始的时间（ns，XF_VFS_TRACE_TIME_NS()） */
+    uint32_t dur;               /*!< 耗时（ns），超出范围时为 UINT32_MAX */
+    uint32_t size;              /*!< 请求的字节数，没有时为 0 */
+    int32_t result;             /*!< 返回值，截断到 int32_t 范围；返回指针的函数成功为 0，失败为 -1 */
+    int16_t fd;                 /*!< 操作的 fd（open 为返回的 fd），不涉及 fd 时为 -1 */
+    uint16_t err;               /*!< result 小于 0 时的 errno，否则为 0 */
+    uint8_t op;                 /*!< xf_vfs_trace_op_t */
+    uint8_t vfs;                /*!< 挂载点的 vfs_id，未知时为 XF_VFS_TRACE_VFS_NONE */
+    uint8_t ring;               /*!< 写入的环形缓冲区，即调用线程 */
+    uint8_t _reserved;
+    uint16_t seq;               /*!< 内部使用 */
+    uint16_t _reserved2;
+} xf_vfs_trace_rec_t;
+
+/**
+ * @brief xf_vfs_trace_dump() 导出数据的头部。
+ *
+ * 导出数据依次为（整数均为本机字节序）：
+ * - 头部；
+ * - op_count 个操作名，每个为 1 字节长度加不含 '\0' 的字符；
+ * - mount_count 个挂载点，每个为 1 字节 vfs_id、1 字节长度加不含 '\0' 的路径前缀；
+ * - 直到数据结尾的 xf_vfs_trace_rec_t 记录，每个环形缓冲区内按时间顺序排列。
+ */
+typedef struct {
+    char magic[4];              /*!< XF_VFS_TRACE_MAGIC */
+    uint16_t version;           /*!< XF_VFS_TRACE_VERSION */
+    uint16_t rec_size;          /*!< sizeof(xf_vfs_trace_rec_t) */
+    uint16_t op_count;          /*!< XF_VFS_TRACE_OP_MAX */
+    uint16_t mount_count;       /*!< 导出时已注册的挂载点数 */
+    uint16_t ring_size;         /*!< XF_VFS_TRACE_RING_SIZE */
+    uint16_t rings;             /*!< XF_VFS_TRACE_RINGS */
+} xf_vfs_trace_header_t;
+
+/**
+ * @brief xf_vfs_trace_dump() 的输出函数。
+ *
+ * @return 写入的字节数，小于 size 时导出中止。
+ */
+typedef xf_vfs_ssize_t (*xf_vfs_trace_write_t)(const void *data, size_t size, void *arg);
+
+#endif
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 操作名，如 "read".
+ */
+const char *xf_vfs_trace_op_name(xf_vfs_trace_op_t op);
+
+#if XF_VFS_TRACE_IS_ENABLE || defined(__DOXYGEN__)
+
+/**
+ * @brief 开始或暂停跟踪，默认开启。
+ */
+void xf_vfs_trace_enable(bool enable);
+
+/**
+ * @brief 跟踪是否开启。
+ */
+bool xf_vfs_trace_is_enabled(void);
+
+/**
+ * @brief 清空所有记录，并释放线程与环形缓冲区的绑定。
+ *
+ * @note 调用时不能有其他线程正在调用 xf_vfs 的函数。
+ */
+void xf_vfs_trace_clear(void);
+
+/**
+ * @brief 导出所有记录，格式见 xf_vfs_trace_header_t.
+ * 导出期间暂停跟踪，因此 write 中可以调用 xf_vfs_write() 等函数。
+ * 导出的数据可用 tools/xf_vfs_trace2json.py 转换为 Chrome/Perfetto 的 trace JSON.
+ *
+ * @param write 输出函数。
+ * @param arg   传给 write 的参数。
+ * @return 导出的字节数；write 失败时为 -1.
+ */
+xf_vfs_ssize_t xf_vfs_trace_dump(xf_vfs_trace_write_t write, void *arg);
+
+#endif /* XF_VFS_TRACE_IS_ENABLE || defined(__DOXYGEN__) */
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * End of addtogroup group_xf_vfs
+ * @}
+ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __XF_VFS_TRACE_H__ */
@@ -81,6 +81,65 @@ extern "C" {
  */
 #define XF_VFS_FLAG_STATIC              (1 << 3)
 
+/**
+ * Flag which indicates that the VFS keeps the file offset of each open file
+ * and implements read/write/lseek on top of the driver's pread/pwrite (and fstat for SEEK_END).
+ * The driver's read/write/lseek are not called, threads sharing an fd issue positional I/O
+ * without serializing on the driver.
+ * @note O_APPEND writes take the current file size from the driver and write there under a lock
+ *       picked by hashing the mount and the path the file was opened with (XF_VFS_APPEND_LOCKS),
+ *       so appenders on separately opened fds of the same path never overwrite each other, while
+ *       unrelated files only wait on each other when their paths hash to the same lock.
+ *       Opening one file under different spellings (e.g. hard links) does not share the lock.
+ */
+#define XF_VFS_FLAG_VFS_OFFSET          (1 << 4)
+
+/**
+ * Flag which indicates that the driver works with pointer-sized handles instead of local fds.
+ * The VFS calls the `handle` subcomponent of xf_vfs_fs_ops_t: open returns a `void *` handle,
+ * which is kept in the open file description and passed directly to the other file operations,
+ * so the driver needs no local fd -> object table of its own.
+ * @note Only usable with xf_vfs_register_fs(), fds of such a mount can not be registered
+ *       with xf_vfs_register_fd*() and can not be used in select().
+ */
+#define XF_VFS_FLAG_HANDLE              (1 << 5)
+
+/**
+ * Flag which indicates that the driver is only safe for one call per open file at a time.
+ * The VFS serializes calls on the same driver file (local fd, handle or directory stream)
+ * with a reader/writer lock: pread and fstat of a file run in parallel, the other file
+ * operations are exclusive. Path operations (open, stat, unlink, rename, mkdir...) are
+ * serialized against each other by a mount-wide reader/writer lock, stat and access
+ * running in parallel. Calls on different files are not serialized.
+ * @note Files are told apart by local fd / handle, which are hashed onto
+ *       XF_VFS_SERIAL_FILE_LOCKS locks, so a few unrelated files may share one lock.
+ *       select() callbacks are not serialized. The driver must not call back into the VFS
+ *       on the same mount. Not usable with compile-time mounts or together with
+ *       XF_VFS_FLAG_SERIAL_MOUNT.
+ */
+#define XF_VFS_FLAG_SERIAL_FILE         (1 << 6)
+
+/**
+ * Flag which indicates that the driver is not reentrant at all.
+ * The VFS serializes all calls on the mount with one reader/writer lock:
+ * pread, fstat, stat and access take it shared and run in parallel,
+ * every other call takes it exclusively.
+ * Without either serialization flag the driver must be fully reentrant and no lock is taken.
+ * @note Same limitations as XF_VFS_FLAG_SERIAL_FILE. Without xf_osal the shared calls
+ *       are exclusive as well.
+ */
+#define XF_VFS_FLAG_SERIAL_MOUNT        (1 << 7)
+
+/**
+ * Flag which indicates that the driver must only be called from one thread.
+ * The VFS creates a worker thread for the mount and every driver call of the mount is queued
+ * to it, the caller waiting for its completion. The driver needs no locks and its state is
+ * only touched by one thread. Calls made by the driver itself on its own mount run directly.
+ * @note Requires xf_osal. select() callbacks still run on the caller's thread.
+ *       Not usable with compile-time mounts or the serialization flags.
+ */
+#define XF_VFS_FLAG_EXECUTOR            (1 << 8)
+
 /* ==================== [Typedefs] ========================================== */
 
 #if XF_VFS_SUPPORT_SELECT_IS_ENABLE
@@ -90,6 +149,7 @@ extern "C" {
 typedef struct {
     bool is_sem_local;      /*!< type of "sem" is SemaphoreHandle_t when true, defined by socket driver otherwise */
     void *sem;              /*!< semaphore instance */
+    int socket_vfs;         /*!< index of the socket VFS whose stop_socket_select() wakes "sem", -1 when is_sem_local */
 } xf_vfs_select_sem_t;
 #endif // XF_VFS_SUPPORT_SELECT_IS_ENABLE
 
@@ -218,6 +278,26 @@ typedef struct
         int (*fsync_p)(void* ctx, int fd);                                                          /*!< fsync with context pointer */
         int (*fsync)(int fd);                                                                       /*!< fsync without context pointer */
     };
+    union {
+        xf_vfs_off64_t (*lseek64_p)(void* p, int fd, xf_vfs_off64_t size, int mode);                        /*!< 64-bit seek with context pointer */
+        xf_vfs_off64_t (*lseek64)(int fd, xf_vfs_off64_t size, int mode);                                   /*!< 64-bit seek without context pointer */
+    };
+    union {
+        xf_vfs_ssize_t (*pread64_p)(void *ctx, int fd, void * dst, size_t size, xf_vfs_off64_t offset);     /*!< 64-bit pread with context pointer */
+        xf_vfs_ssize_t (*pread64)(int fd, void * dst, size_t size, xf_vfs_off64_t offset);                  /*!< 64-bit pread without context pointer */
+    };
+    union {
+        xf_vfs_ssize_t (*pwrite64_p)(void *ctx, int fd, const void *src, size_t size, xf_vfs_off64_t offset); /*!< 64-bit pwrite with context pointer */
+        xf_vfs_ssize_t (*pwrite64)(int fd, const void *src, size_t size, xf_vfs_off64_t offset);            /*!< 64-bit pwrite without context pointer */
+    };
+    union {
+        int (*fstat64_p)(void* ctx, int fd, xf_vfs_stat64_t * st);                                  /*!< 64-bit fstat with context pointer */
+        int (*fstat64)(int fd, xf_vfs_stat64_t * st);                                               /*!< 64-bit fstat without context pointer */
+    };
+    union {
+        int (*fstatx_p)(void* ctx, int fd, uint32_t mask, xf_vfs_statx_t * stx);                    /*!< fstatx with context pointer */
+        int (*fstatx)(int fd, uint32_t mask, xf_vfs_statx_t * stx);                                 /*!< fstatx without context pointer */
+    };
 #if XF_VFS_SUPPORT_DIR_IS_ENABLE
     union {
         int (*access_p)(void* ctx, const char *path, int amode);                                    /*!< access with context pointer */
@@ -235,6 +315,38 @@ typedef struct
         int (*utime_p)(void* ctx, const char *path, const xf_vfs_utimbuf_t *times);                   /*!< utime with context pointer */
         int (*utime)(const char *path, const xf_vfs_utimbuf_t *times);                                /*!< utime without context pointer */
     };
+    union {
+        int (*truncate64_p)(void* ctx, const char *path, xf_vfs_off64_t length);                    /*!< 64-bit truncate with context pointer */
+        int (*truncate64)(const char *path, xf_vfs_off64_t length);                                 /*!< 64-bit truncate without context pointer */
+    };
+    union {
+        int (*ftruncate64_p)(void* ctx, int fd, xf_vfs_off64_t length);                             /*!< 64-bit ftruncate with context pointer */
+        int (*ftruncate64)(int fd, xf_vfs_off64_t length);                                          /*!< 64-bit ftruncate without context pointer */
+    };
+    union {
+        xf_vfs_ssize_t (*getdents_p)(void* ctx, xf_vfs_dir_t* pdir, void *buf, size_t len);         /*!< getdents with context pointer */
+        xf_vfs_ssize_t (*getdents)(xf_vfs_dir_t* pdir, void *buf, size_t len);                      /*!< getdents without context pointer */
+    };
+    union {
+        int (*statx_p)(void* ctx, const char * path, uint32_t mask, xf_vfs_statx_t * stx);          /*!< statx with context pointer */
+        int (*statx)(const char * path, uint32_t mask, xf_vfs_statx_t * stx);                       /*!< statx without context pointer */
+    };
+    union {
+        int (*openat_p)(void* ctx, xf_vfs_dir_t* pdir, const char * name, int flags, int mode);     /*!< openat with context pointer */
+        int (*openat)(xf_vfs_dir_t* pdir, const char * name, int flags, int mode);                  /*!< openat without context pointer */
+    };
+    union {
+        int (*fstatat_p)(void* ctx, xf_vfs_dir_t* pdir, const char * name, xf_vfs_stat_t * st);     /*!< fstatat with context pointer */
+        int (*fstatat)(xf_vfs_dir_t* pdir, const char * name, xf_vfs_stat_t * st);                  /*!< fstatat without context pointer */
+    };
+    union {
+        int (*unlinkat_p)(void* ctx, xf_vfs_dir_t* pdir, const char * name, int flags);             /*!< unlinkat with context pointer */
+        int (*unlinkat)(xf_vfs_dir_t* pdir, const char * name, int flags);                          /*!< unlinkat without context pointer */
+    };
+    union {
+        int (*mkdirat_p)(void* ctx, xf_vfs_dir_t* pdir, const char * name, xf_vfs_mode_t mode);     /*!< mkdirat with context pointer */
+        int (*mkdirat)(xf_vfs_dir_t* pdir, const char * name, xf_vfs_mode_t mode);                  /*!< mkdirat without context pointer */
+    };
 #endif // CONFIG_XF_VFS_SUPPORT_DIR
 #if XF_VFS_SUPPORT_SELECT_IS_ENABLE || defined __DOXYGEN__
     /** start_select is called for setting up synchronous I/O multiplexing of the desired file descriptors in the given VFS */
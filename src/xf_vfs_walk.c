@@ -0,0 +1,675 @@
+/**
+ * @file xf_vfs_walk.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs 目录树遍历（类似 nftw/fts）及基于它的批量操作。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs_walk.h"
+#include "xf_vfs_mem.h"
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE
+
+#if XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE
+#include "xf_osal.h"
+#endif
+
+/* ==================== [Defines] =========================================== */
+
+#define IS_DOT_OR_DOTDOT(name) \
+    ((name)[0] == '.' && ((name)[1] == '\0' || ((name)[1] == '.' && (name)[2] == '\0')))
+
+#define IS_DIR_MODE(mode)       (((mode) & XF_VFS_S_IFMT) == XF_VFS_S_IFDIR)
+
+/* ==================== [Typedefs] ========================================== */
+
+typedef struct {
+    xf_vfs_walk_cb_t cb;
+    void *arg;
+    int flags;
+    int err;                    /*!< 路径过长等被跳过的错误，0 表示无 */
+    char path[XF_VFS_WALK_PATH_MAX];
+} walk_t;
+
+#if XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE
+/**
+ * 并行遍历中待列举的目录。
+ * pending 计入自身的列举及尚未完成的子目录，减为 0 时该目录完成，
+ * 此时才报告 XF_VFS_WALK_DP 并通知上级目录。
+ */
+typedef struct _walk_node_t {
+    struct _walk_node_t *next;
+    struct _walk_node_t *parent;
+    uint32_t pending;
+    bool opened;
+    int level;
+    size_t len;
+    size_t base;
+    char path[];
+} walk_node_t;
+
+typedef struct {
+    xf_vfs_walk_cb_t cb;
+    void *arg;
+    int flags;
+    int threads;                /*!< 除调用者外的工作线程数 */
+    xf_osal_mutex_t lock;       /*!< 保护队列、pending、stop 及 err */
+    xf_osal_semaphore_t work;   /*!< 每个入队的目录释放一次，结束时再为每个线程释放一次 */
+    xf_osal_semaphore_t exited;
+    walk_node_t *head;
+    walk_node_t *tail;
+    bool stop;
+    int err;
+} walk_pool_t;
+#endif
+
+/* ==================== [Static Prototypes] ================================= */
+
+static size_t walk_init_path(char *buf, const char *path);
+static size_t walk_join(char *buf, size_t dir_len, const char *name);
+static size_t walk_base(const char *path, size_t len);
+static xf_vfs_walk_type_t walk_classify(const char *path, int flags, uint8_t *d_type,
+                                        xf_vfs_stat_t *st, bool *has_st);
+static int walk_report(xf_vfs_walk_cb_t cb, void *arg, const char *path, size_t base, int level,
+                       uint8_t d_type, const xf_vfs_stat_t *st, xf_vfs_walk_type_t type);
+static int walk_visit(walk_t *w, size_t len, size_t base, int level, uint8_t d_type);
+static int walk_enter(walk_t *w, size_t len, size_t base, int level, xf_vfs_walk_type_t type, uint8_t d_type,
+                      const xf_vfs_stat_t *st);
+static int walk_dir(walk_t *w, xf_vfs_dir_t *dir, size_t len, int level);
+
+#if XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE
+static bool walk_pool_stopped(walk_pool_t *p);
+static void walk_pool_set_stop(walk_pool_t *p);
+static bool walk_pool_push(walk_pool_t *p, walk_node_t *parent, const char *path, size_t len, size_t base,
+                           int level);
+static walk_node_t *walk_pool_pop(walk_pool_t *p);
+static void walk_pool_list(walk_pool_t *p, walk_node_t *node, char *buf);
+static void walk_pool_complete(walk_pool_t *p, walk_node_t *node);
+static void walk_pool_run(walk_pool_t *p);
+static void walk_pool_thread(void *argument);
+#endif
+
+static int rm_r_cb(const xf_vfs_walk_entry_t *ent, xf_vfs_walk_type_t type, void *arg);
+static int du_cb(const xf_vfs_walk_entry_t *ent, xf_vfs_walk_type_t type, void *arg);
+
+/* ==================== [Static Variables] ================================== */
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+int xf_vfs_walk(const char *path, xf_vfs_walk_cb_t cb, void *arg, int flags)
+{
+    if (path == NULL || cb == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+    walk_t *w = xf_vfs_malloc(sizeof(walk_t));
+    if (w == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    w->cb = cb;
+    w->arg = arg;
+    w->flags = flags;
+    w->err = 0;
+
+    const size_t len = walk_init_path(w->path, path);
+    int ret = -1;
+    if (len == 0) {
+        errno = (path[0] == '\0') ? ENOENT : ENAMETOOLONG;
+    } else {
+        uint8_t d_type = XF_VFS_DT_UNKNOWN;
+        xf_vfs_stat_t st;
+        bool has_st;
+        const xf_vfs_walk_type_t type = walk_classify(w->path, flags | XF_VFS_WALK_FLAG_STAT, &d_type, &st, &has_st);
+        if (type != XF_VFS_WALK_NS) {
+            ret = walk_enter(w, len, walk_base(w->path, len), 0, type, d_type, has_st ? &st : NULL);
+        }
+    }
+    if (ret == XF_VFS_WALK_PRUNE) {
+        ret = XF_VFS_WALK_CONTINUE;
+    }
+    if (ret == XF_VFS_WALK_CONTINUE && w->err != 0) {
+        errno = w->err;
+        ret = -1;
+    }
+    xf_vfs_free(w);
+    return ret;
+}
+
+#if XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE
+int xf_vfs_walk_parallel(const char *path, xf_vfs_walk_cb_t cb, void *arg, int flags, int workers)
+{
+    if (workers <= 1) {
+        return xf_vfs_walk(path, cb, arg, flags);
+    }
+    if (path == NULL || cb == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    char buf[XF_VFS_WALK_PATH_MAX];
+    const size_t len = walk_init_path(buf, path);
+    if (len == 0) {
+        errno = (path[0] == '\0') ? ENOENT : ENAMETOOLONG;
+        return -1;
+    }
+
+    /* 起点在调用者线程中处理，不是目录或被剪枝时不需要线程池 */
+    uint8_t d_type = XF_VFS_DT_UNKNOWN;
+    xf_vfs_stat_t st;
+    bool has_st;
+    const xf_vfs_walk_type_t type = walk_classify(buf, flags | XF_VFS_WALK_FLAG_STAT, &d_type, &st, &has_st);
+    if (type == XF_VFS_WALK_NS) {
+        return -1;
+    }
+    const size_t base = walk_base(buf, len);
+    const int action = walk_report(cb, arg, buf, base, 0, d_type, has_st ? &st : NULL, type);
+    if (action == XF_VFS_WALK_STOP) {
+        return XF_VFS_WALK_STOP;
+    }
+    if (type != XF_VFS_WALK_D || action == XF_VFS_WALK_PRUNE) {
+        return 0;
+    }
+
+    walk_pool_t pool = {
+        .cb = cb,
+        .arg = arg,
+        .flags = flags,
+    };
+    xf_osal_mutex_attr_t mutex_attr = {
+        .name = "walk",
+    };
+    xf_osal_semaphore_attr_t sem_attr = {
+        .name = "walk",
+    };
+    pool.lock = xf_osal_mutex_create(&mutex_attr);
+    pool.work = xf_osal_semaphore_create(0x7FFFFFFF, 0, &sem_attr);
+    pool.exited = xf_osal_semaphore_create(workers, 0, &sem_attr);
+    int ret = -1;
+    if (pool.lock == NULL || pool.work == NULL || pool.exited == NULL) {
+        errno = ENOMEM;
+        goto cleanup;
+    }
+
+    /* 线程数确定后才放入起点：结束时要为每个线程释放一次 work */
+    const xf_osal_thread_attr_t thread_attr = {
+        .name = "walk",
+        .stack_size = XF_VFS_WALK_WORKER_STACK_SIZE,
+        .priority = XF_OSAL_PRIORITY_NORMAL,
+    };
+    for (int i = 1; i < workers; ++i) {
+        if (xf_osal_thread_create(walk_pool_thread, &pool, &thread_attr) == NULL) {
+            break;
+        }
+        ++pool.threads;
+    }
+    if (!walk_pool_push(&pool, NULL, buf, len, base, 0)) {
+        /* 起点无法入队时线程正在等待 work，直接通知它们退出 */
+        for (int i = 0; i < pool.threads; ++i) {
+            xf_osal_semaphore_release(pool.work);
+        }
+    } else {
+        walk_pool_run(&pool);
+    }
+    for (int i = 0; i < pool.threads; ++i) {
+        xf_osal_semaphore_acquire(pool.exited, XF_OSAL_WAIT_FOREVER);
+    }
+
+    if (pool.stop) {
+        ret = XF_VFS_WALK_STOP;
+    } else if (pool.err != 0) {
+        errno = pool.err;
+    } else {
+        ret = 0;
+    }
+
+cleanup:
+    if (pool.exited != NULL) {
+        xf_osal_semaphore_delete(pool.exited);
+    }
+    if (pool.work != NULL) {
+        xf_osal_semaphore_delete(pool.work);
+    }
+    if (pool.lock != NULL) {
+        xf_osal_mutex_delete(pool.lock);
+    }
+    return ret;
+}
+#endif
+
+int xf_vfs_rm_r(const char *path)
+{
+    int err = 0;
+    if (xf_vfs_walk(path, rm_r_cb, &err, XF_VFS_WALK_FLAG_POSTORDER) < 0) {
+        return -1;
+    }
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+int xf_vfs_mkdir_p(const char *path, xf_vfs_mode_t mode)
+{
+    char buf[XF_VFS_WALK_PATH_MAX];
+    const size_t len = (path == NULL) ? 0 : walk_init_path(buf, path);
+    if (len == 0) {
+        errno = (path == NULL) ? EINVAL : (path[0] == '\0') ? ENOENT : ENAMETOOLONG;
+        return -1;
+    }
+    for (size_t i = 1; i <= len; ++i) {
+        if (i < len && buf[i] != '/') {
+            continue;
+        }
+        const char c = buf[i];
+        buf[i] = '\0';
+        int ret = xf_vfs_mkdir(buf, mode);
+        if (ret != 0) {
+            /* 已存在的目录（包括只读挂载点上的）不算失败 */
+            const int err = errno;
+            xf_vfs_stat_t st;
+            if (xf_vfs_stat(buf, &st) == 0) {
+                ret = IS_DIR_MODE(st.st_mode) ? 0 : -1;
+                errno = EEXIST;
+            } else if (i < len && err == ENOENT) {
+                /* 挂载点前缀中的上级路径，由下一级判断 */
+                ret = 0;
+            } else {
+                errno = err;
+            }
+        }
+        buf[i] = c;
+        if (ret != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int xf_vfs_du(const char *path, xf_vfs_du_t *out)
+{
+    if (out == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+    xf_memset(out, 0, sizeof(xf_vfs_du_t));
+    return (xf_vfs_walk(path, du_cb, out, 0) == 0) ? 0 : -1;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+/* 复制起点路径，合并重复的 '/' 并去掉结尾的 '/'，为空或超长返回 0 */
+static size_t walk_init_path(char *buf, const char *path)
+{
+    size_t len = 0;
+    for (; *path != '\0'; ++path) {
+        if (*path == '/' && len > 0 && buf[len - 1] == '/') {
+            continue;
+        }
+        if (len + 1 >= XF_VFS_WALK_PATH_MAX) {
+            return 0;
+        }
+        buf[len++] = *path;
+    }
+    while (len > 1 && buf[len - 1] == '/') {
+        --len;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+/* 在 buf 中长度为 dir_len 的目录后追加 "/name"，返回新长度，超长返回 0 */
+static size_t walk_join(char *buf, size_t dir_len, const char *name)
+{
+    const size_t name_len = xf_strlen(name);
+    const size_t slash = (buf[dir_len - 1] == '/') ? 0 : 1;
+    if (dir_len + slash + name_len + 1 > XF_VFS_WALK_PATH_MAX) {
+        return 0;
+    }
+    if (slash) {
+        buf[dir_len++] = '/';
+    }
+    xf_memcpy(buf + dir_len, name, name_len + 1);
+    return dir_len + name_len;
+}
+
+/* 最后一级名称在 path 中的偏移 */
+static size_t walk_base(const char *path, size_t len)
+{
+    size_t base = len;
+    while (base > 0 && path[base - 1] != '/') {
+        --base;
+    }
+    return (base == len) ? 0 : base;
+}
+
+/*
+ * 确定 path 的类别：d_type 已知且不要求 stat 时直接使用，
+ * 否则调用 stat，只需类别时用 statx 查询 XF_VFS_STATX_TYPE.
+ * 驱动不支持 stat 时，能打开的视为目录。
+ */
+static xf_vfs_walk_type_t walk_classify(const char *path, int flags, uint8_t *d_type,
+                                        xf_vfs_stat_t *st, bool *has_st)
+{
+    *has_st = false;
+    if (*d_type != XF_VFS_DT_UNKNOWN && !(flags & XF_VFS_WALK_FLAG_STAT)) {
+        return (*d_type == XF_VFS_DT_DIR) ? XF_VFS_WALK_D : XF_VFS_WALK_F;
+    }
+    int ret;
+    xf_vfs_mode_t mode = 0;
+    if (flags & XF_VFS_WALK_FLAG_STAT) {
+        ret = xf_vfs_stat(path, st);
+        *has_st = (ret == 0);
+        mode = st->st_mode;
+    } else {
+        xf_vfs_statx_t stx;
+        ret = xf_vfs_statx(path, XF_VFS_STATX_TYPE, &stx);
+        if (ret == 0 && !(stx.stx_mask & XF_VFS_STATX_TYPE)) {
+            errno = ENOSYS;
+            ret = -1;
+        }
+        mode = stx.stx_mode;
+    }
+    if (ret == 0) {
+        *d_type = IS_DIR_MODE(mode) ? XF_VFS_DT_DIR : XF_VFS_DT_REG;
+        return (*d_type == XF_VFS_DT_DIR) ? XF_VFS_WALK_D : XF_VFS_WALK_F;
+    }
+    if (errno == ENOSYS && *d_type == XF_VFS_DT_UNKNOWN) {
+        xf_vfs_dir_t *dir = xf_vfs_opendir(path);
+        if (dir != NULL) {
+            xf_vfs_closedir(dir);
+            *d_type = XF_VFS_DT_DIR;
+            return XF_VFS_WALK_D;
+        }
+        errno = ENOSYS;
+    }
+    if (*d_type != XF_VFS_DT_UNKNOWN) {
+        /* 要求 stat 但失败时仍按 d_type 报告 */
+        return (*d_type == XF_VFS_DT_DIR) ? XF_VFS_WALK_D : XF_VFS_WALK_F;
+    }
+    return XF_VFS_WALK_NS;
+}
+
+static int walk_report(xf_vfs_walk_cb_t cb, void *arg, const char *path, size_t base, int level,
+                       uint8_t d_type, const xf_vfs_stat_t *st, xf_vfs_walk_type_t type)
+{
+    const xf_vfs_walk_entry_t ent = {
+        .path = path,
+        .base = base,
+        .level = level,
+        .d_type = d_type,
+        .st = st,
+    };
+    return cb(&ent, type, arg);
+}
+
+/* 确定 w->path 的类别后访问它 */
+static int walk_visit(walk_t *w, size_t len, size_t base, int level, uint8_t d_type)
+{
+    xf_vfs_stat_t st;
+    bool has_st;
+    const xf_vfs_walk_type_t type = walk_classify(w->path, w->flags, &d_type, &st, &has_st);
+    return walk_enter(w, len, base, level, type, d_type, has_st ? &st : NULL);
+}
+
+/* 报告 w->path 并在它是目录时递归，返回 XF_VFS_WALK_STOP 或 XF_VFS_WALK_CONTINUE */
+static int walk_enter(walk_t *w, size_t len, size_t base, int level, xf_vfs_walk_type_t type, uint8_t d_type,
+                      const xf_vfs_stat_t *pst)
+{
+    int action = walk_report(w->cb, w->arg, w->path, base, level, d_type, pst, type);
+    if (type != XF_VFS_WALK_D || action != XF_VFS_WALK_CONTINUE) {
+        return (action == XF_VFS_WALK_STOP) ? XF_VFS_WALK_STOP : XF_VFS_WALK_CONTINUE;
+    }
+
+    xf_vfs_dir_t *dir = NULL;
+    if (level < XF_VFS_WALK_DEPTH_MAX) {
+        dir = xf_vfs_opendir(w->path);
+    } else {
+        errno = ELOOP;
+    }
+    if (dir == NULL) {
+        action = walk_report(w->cb, w->arg, w->path, base, level, d_type, pst, XF_VFS_WALK_DNR);
+        return (action == XF_VFS_WALK_STOP) ? XF_VFS_WALK_STOP : XF_VFS_WALK_CONTINUE;
+    }
+    if (walk_dir(w, dir, len, level) == XF_VFS_WALK_STOP) {
+        return XF_VFS_WALK_STOP;
+    }
+    if (w->flags & XF_VFS_WALK_FLAG_POSTORDER) {
+        action = walk_report(w->cb, w->arg, w->path, base, level, d_type, pst, XF_VFS_WALK_DP);
+    }
+    return (action == XF_VFS_WALK_STOP) ? XF_VFS_WALK_STOP : XF_VFS_WALK_CONTINUE;
+}
+
+/* 逐项访问已打开的目录 w->path，结束后关闭 dir */
+static int walk_dir(walk_t *w, xf_vfs_dir_t *dir, size_t len, int level)
+{
+    int action = XF_VFS_WALK_CONTINUE;
+    const xf_vfs_dirent_t *de;
+    while (action != XF_VFS_WALK_STOP && (de = xf_vfs_readdir(dir)) != NULL) {
+        if (IS_DOT_OR_DOTDOT(de->d_name)) {
+            continue;
+        }
+        const size_t sub_len = walk_join(w->path, len, de->d_name);
+        if (sub_len == 0) {
+            w->err = ENAMETOOLONG;
+            continue;
+        }
+        const size_t sub_base = sub_len - xf_strlen(de->d_name);
+        action = walk_visit(w, sub_len, sub_base, level + 1, de->d_type);
+        w->path[len] = '\0';
+    }
+    xf_vfs_closedir(dir);
+    return action;
+}
+
+#if XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE
+static bool walk_pool_stopped(walk_pool_t *p)
+{
+    xf_osal_mutex_acquire(p->lock, XF_OSAL_WAIT_FOREVER);
+    const bool stop = p->stop;
+    xf_osal_mutex_release(p->lock);
+    return stop;
+}
+
+static void walk_pool_set_stop(walk_pool_t *p)
+{
+    xf_osal_mutex_acquire(p->lock, XF_OSAL_WAIT_FOREVER);
+    p->stop = true;
+    xf_osal_mutex_release(p->lock);
+}
+
+static bool walk_pool_push(walk_pool_t *p, walk_node_t *parent, const char *path, size_t len, size_t base,
+                           int level)
+{
+    walk_node_t *node = xf_vfs_malloc(sizeof(walk_node_t) + len + 1);
+    if (node == NULL) {
+        xf_osal_mutex_acquire(p->lock, XF_OSAL_WAIT_FOREVER);
+        p->err = ENOMEM;
+        xf_osal_mutex_release(p->lock);
+        return false;
+    }
+    node->next = NULL;
+    node->parent = parent;
+    node->pending = 1;
+    node->opened = false;
+    node->level = level;
+    node->len = len;
+    node->base = base;
+    xf_memcpy(node->path, path, len + 1);
+
+    xf_osal_mutex_acquire(p->lock, XF_OSAL_WAIT_FOREVER);
+    if (parent != NULL) {
+        ++parent->pending;
+    }
+    if (p->tail != NULL) {
+        p->tail->next = node;
+    } else {
+        p->head = node;
+    }
+    p->tail = node;
+    xf_osal_mutex_release(p->lock);
+    xf_osal_semaphore_release(p->work);
+    return true;
+}
+
+static walk_node_t *walk_pool_pop(walk_pool_t *p)
+{
+    xf_osal_mutex_acquire(p->lock, XF_OSAL_WAIT_FOREVER);
+    walk_node_t *node = p->head;
+    if (node != NULL) {
+        p->head = node->next;
+        if (p->head == NULL) {
+            p->tail = NULL;
+        }
+    }
+    xf_osal_mutex_release(p->lock);
+    return node;
+}
+
+/* 列举一个目录：非目录直接报告，子目录报告后入队 */
+static void walk_pool_list(walk_pool_t *p, walk_node_t *node, char *buf)
+{
+    xf_vfs_dir_t *dir = walk_pool_stopped(p) ? NULL : xf_vfs_opendir(node->path);
+    if (dir == NULL) {
+        if (!walk_pool_stopped(p)
+                && walk_report(p->cb, p->arg, node->path, node->base, node->level, XF_VFS_DT_DIR, NULL,
+                               XF_VFS_WALK_DNR) == XF_VFS_WALK_STOP) {
+            walk_pool_set_stop(p);
+        }
+        walk_pool_complete(p, node);
+        return;
+    }
+    node->opened = true;
+
+    xf_memcpy(buf, node->path, node->len + 1);
+    const xf_vfs_dirent_t *de;
+    while (!walk_pool_stopped(p) && (de = xf_vfs_readdir(dir)) != NULL) {
+        if (IS_DOT_OR_DOTDOT(de->d_name)) {
+            continue;
+        }
+        const size_t len = walk_join(buf, node->len, de->d_name);
+        if (len == 0) {
+            xf_osal_mutex_acquire(p->lock, XF_OSAL_WAIT_FOREVER);
+            p->err = ENAMETOOLONG;
+            xf_osal_mutex_release(p->lock);
+            continue;
+        }
+        const size_t base = len - xf_strlen(de->d_name);
+        uint8_t d_type = de->d_type;
+        xf_vfs_stat_t st;
+        bool has_st;
+        const xf_vfs_walk_type_t type = walk_classify(buf, p->flags, &d_type, &st, &has_st);
+        const int action = walk_report(p->cb, p->arg, buf, base, node->level + 1, d_type,
+                                       has_st ? &st : NULL, type);
+        if (action == XF_VFS_WALK_STOP) {
+            walk_pool_set_stop(p);
+        } else if (type == XF_VFS_WALK_D && action == XF_VFS_WALK_CONTINUE) {
+            walk_pool_push(p, node, buf, len, base, node->level + 1);
+        }
+        buf[node->len] = '\0';
+    }
+    xf_vfs_closedir(dir);
+    walk_pool_complete(p, node);
+}
+
+/* 结束一个目录的列举，并向上完成所有已无未完成子目录的目录 */
+static void walk_pool_complete(walk_pool_t *p, walk_node_t *node)
+{
+    xf_osal_mutex_acquire(p->lock, XF_OSAL_WAIT_FOREVER);
+    while (--node->pending == 0) {
+        walk_node_t *parent = node->parent;
+        const bool report = (p->flags & XF_VFS_WALK_FLAG_POSTORDER) && node->opened && !p->stop;
+        xf_osal_mutex_release(p->lock);
+        if (report && walk_report(p->cb, p->arg, node->path, node->base, node->level, XF_VFS_DT_DIR, NULL,
+                                  XF_VFS_WALK_DP) == XF_VFS_WALK_STOP) {
+            walk_pool_set_stop(p);
+        }
+        xf_vfs_free(node);
+        if (parent == NULL) {
+            /* 起点已完成，队列必然为空，通知所有线程退出 */
+            for (int i = 0; i <= p->threads; ++i) {
+                xf_osal_semaphore_release(p->work);
+            }
+            return;
+        }
+        xf_osal_mutex_acquire(p->lock, XF_OSAL_WAIT_FOREVER);
+        node = parent;
+    }
+    xf_osal_mutex_release(p->lock);
+}
+
+static void walk_pool_run(walk_pool_t *p)
+{
+    char buf[XF_VFS_WALK_PATH_MAX];
+    for (;;) {
+        xf_osal_semaphore_acquire(p->work, XF_OSAL_WAIT_FOREVER);
+        walk_node_t *node = walk_pool_pop(p);
+        if (node == NULL) {
+            break;
+        }
+        walk_pool_list(p, node, buf);
+    }
+}
+
+static void walk_pool_thread(void *argument)
+{
+    walk_pool_t *p = (walk_pool_t *)argument;
+    walk_pool_run(p);
+    xf_osal_semaphore_release(p->exited);
+    xf_osal_thread_delete(NULL);
+}
+#endif
+
+static int rm_r_cb(const xf_vfs_walk_entry_t *ent, xf_vfs_walk_type_t type, void *arg)
+{
+    int *err = (int *)arg;
+    int ret = 0;
+    switch (type) {
+    case XF_VFS_WALK_F:
+        ret = xf_vfs_unlink(ent->path);
+        break;
+    case XF_VFS_WALK_DP:
+        ret = xf_vfs_rmdir(ent->path);
+        break;
+    case XF_VFS_WALK_DNR:
+    case XF_VFS_WALK_NS:
+        ret = -1;
+        break;
+    default:
+        break;
+    }
+    if (ret != 0 && *err == 0) {
+        *err = errno;
+    }
+    return XF_VFS_WALK_CONTINUE;
+}
+
+static int du_cb(const xf_vfs_walk_entry_t *ent, xf_vfs_walk_type_t type, void *arg)
+{
+    xf_vfs_du_t *du = (xf_vfs_du_t *)arg;
+    if (type == XF_VFS_WALK_D) {
+        ++du->dirs;
+    } else if (type == XF_VFS_WALK_F) {
+        ++du->files;
+        /* 只有文件需要大小，目录按 d_type 判断即可 */
+        xf_vfs_statx_t stx;
+        if (ent->st != NULL) {
+            du->bytes += (uint64_t)ent->st->st_size;
+        } else if (xf_vfs_statx(ent->path, XF_VFS_STATX_SIZE, &stx) == 0
+                   && (stx.stx_mask & XF_VFS_STATX_SIZE)) {
+            du->bytes += (uint64_t)stx.stx_size;
+        }
+    }
+    return XF_VFS_WALK_CONTINUE;
+}
+
+#endif /* XF_VFS_SUPPORT_DIR_IS_ENABLE */
@@ -0,0 +1,166 @@
+/**
+ * @file xf_vfs_walk.h
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief xf_vfs 目录树遍历（类似 nftw/fts）及基于它的批量操作。
+ * @version 1.0
+ * @date 2025-01-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef __XF_VFS_WALK_H__
+#define __XF_VFS_WALK_H__
+
+/* ==================== [Includes] ========================================== */
+
+#include "xf_vfs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @cond (XFAPI_USER || XFAPI_PORT || XFAPI_INTERNAL)
+ * @addtogroup group_xf_vfs
+ * @endcond
+ * @{
+ */
+
+#if XF_VFS_SUPPORT_DIR_IS_ENABLE || defined(__DOXYGEN__)
+
+/* ==================== [Defines] =========================================== */
+
+/**
+ * @brief xf_vfs_walk() 的 flags.
+ */
+/**@{*/
+#define XF_VFS_WALK_FLAG_STAT       (1 << 0)    /*!< 对每一项都调用 stat，否则只在 d_type 未知时调用 */
+#define XF_VFS_WALK_FLAG_POSTORDER  (1 << 1)    /*!< 目录的所有子项处理完后再以 XF_VFS_WALK_DP 报告一次 */
+/**@}*/
+
+/* ==================== [Typedefs] ========================================== */
+
+/**
+ * @brief 回调中目录项的类别。
+ */
+typedef enum {
+    XF_VFS_WALK_F = 0,          /*!< 非目录 */
+    XF_VFS_WALK_D,              /*!< 目录，进入前报告 */
+    XF_VFS_WALK_DP,             /*!< 目录，子项处理完后报告（XF_VFS_WALK_FLAG_POSTORDER） */
+    XF_VFS_WALK_DNR,            /*!< 已报告过 XF_VFS_WALK_D 的目录无法打开，errno 为原因 */
+    XF_VFS_WALK_NS,             /*!< 无法确定类别（stat 失败），errno 为原因 */
+} xf_vfs_walk_type_t;
+
+/**
+ * @brief 回调的返回值。
+ */
+typedef enum {
+    XF_VFS_WALK_CONTINUE = 0,   /*!< 继续遍历 */
+    XF_VFS_WALK_PRUNE,          /*!< 对 XF_VFS_WALK_D 有效：不进入该目录 */
+    XF_VFS_WALK_STOP,           /*!< 停止遍历，xf_vfs_walk() 返回 XF_VFS_WALK_STOP */
+} xf_vfs_walk_action_t;
+
+/**
+ * @brief 回调收到的目录项。
+ */
+typedef struct {
+    const char *path;           /*!< 完整路径 */
+    size_t base;                /*!< 名称在 path 中的偏移 */
+    int level;                  /*!< 深度，起点为 0 */
+    uint8_t d_type;             /*!< XF_VFS_DT_*，NS 时为 XF_VFS_DT_UNKNOWN */
+    const xf_vfs_stat_t *st;    /*!< 调用过 stat 时有效，否则为 NULL */
+} xf_vfs_walk_entry_t;
+
+/**
+ * @brief 遍历回调。
+ *
+ * @param ent  目录项，仅在回调期间有效。
+ * @param type 目录项类别。
+ * @param arg  xf_vfs_walk() 的 arg.
+ * @return xf_vfs_walk_action_t
+ */
+typedef int (*xf_vfs_walk_cb_t)(const xf_vfs_walk_entry_t *ent, xf_vfs_walk_type_t type, void *arg);
+
+/**
+ * @brief xf_vfs_du() 的统计结果。
+ */
+typedef struct {
+    uint64_t bytes;             /*!< 文件大小之和 */
+    uint32_t files;             /*!< 非目录数 */
+    uint32_t dirs;              /*!< 目录数，含起点 */
+} xf_vfs_du_t;
+
+/* ==================== [Global Prototypes] ================================= */
+
+/**
+ * @brief 先序遍历以 path 为根的目录树。
+ *
+ * 驱动的 readdir 给出 d_type 时直接使用，不调用 stat；
+ * 仅当 d_type 为 XF_VFS_DT_UNKNOWN 或设置了 XF_VFS_WALK_FLAG_STAT 时才调用 stat.
+ * 子树中的错误（XF_VFS_WALK_DNR / XF_VFS_WALK_NS）报告给回调后继续遍历。
+ *
+ * @param path  起点，可以是目录或文件。
+ * @param cb    回调。
+ * @param arg   传给回调的参数。
+ * @param flags XF_VFS_WALK_FLAG_*.
+ * @return 0: 遍历完成；XF_VFS_WALK_STOP: 被回调停止；
+ *         -1: 起点无法访问、路径超过 XF_VFS_WALK_PATH_MAX 或内存不足，errno 为原因。
+ */
+int xf_vfs_walk(const char *path, xf_vfs_walk_cb_t cb, void *arg, int flags);
+
+#if XF_VFS_SUPPORT_WALK_PARALLEL_IS_ENABLE || defined(__DOXYGEN__)
+/**
+ * @brief 用 workers 个线程（含调用者）并行遍历目录树。
+ *
+ * 每个子目录作为一个任务放入共享队列，由空闲线程取出并列举，
+ * 因此同一目录的子项仍按顺序报告，不同目录之间的顺序不确定。
+ * XF_VFS_WALK_DP 仍保证在该目录所有后代之后报告。
+ *
+ * @note 回调会在多个线程中同时调用，需自行保证线程安全。
+ *
+ * @param workers 线程数，不大于 1 时等同于 xf_vfs_walk().
+ * @return 同 xf_vfs_walk().
+ */
+int xf_vfs_walk_parallel(const char *path, xf_vfs_walk_cb_t cb, void *arg, int flags, int workers);
+#endif
+
+/**
+ * @brief 递归删除 path（rm -r）。
+ *
+ * @return 0 if successful, -1 with errno of the first failure otherwise;
+ *         能删除的部分仍会被删除。
+ */
+int xf_vfs_rm_r(const char *path);
+
+/**
+ * @brief 创建 path 及其所有不存在的上级目录（mkdir -p）。
+ *
+ * 属于挂载点前缀的上级路径（如 "/data/logs" 挂载时的 "/data"）不需要存在。
+ *
+ * @return 0 if successful (包括 path 已是目录), -1 with errno otherwise.
+ */
+int xf_vfs_mkdir_p(const char *path, xf_vfs_mode_t mode);
+
+/**
+ * @brief 统计以 path 为根的目录树占用的字节数及文件、目录数（du）。
+ *
+ * @return 0 if successful, -1 with errno otherwise.
+ *         无法访问的子项被跳过，不视为失败。
+ */
+int xf_vfs_du(const char *path, xf_vfs_du_t *out);
+
+#endif /* XF_VFS_SUPPORT_DIR_IS_ENABLE || defined(__DOXYGEN__) */
+
+/* ==================== [Macros] ============================================ */
+
+/**
+ * End of addtogroup group_xf_vfs
+ * @}
+ */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __XF_VFS_WALK_H__ */
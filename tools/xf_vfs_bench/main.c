@@ -0,0 +1,115 @@
+/**
+ * @file main.c
+ * @author catcatBlue (catcatblue@qq.com)
+ * @brief 负载生成器（主机工具）：在内存文件系统上运行作业文件，可用 fault 驱动模拟慢速设备。
+ *
+ * 用法：
+ *     xmake r xf_vfs_bench tools/xf_vfs_bench/sample.fio ["write bw=512K; fsync fixed=5ms"]
+ *
+ * 内存文件系统挂载在 /ram；给出第二个参数时注册 /slow 转发到 /ram，并以该参数为 fault 脚本。
+ * 作业的 directory 不存在时自动创建。
+ * @version 1.0
+ * @date 2025-01-22
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+/* ==================== [Includes] ========================================== */
+
+#include <stdio.h>
+
+#include "xf_utils.h"
+#include "xf_vfs.h"
+#include "xf_vfs_bench.h"
+#include "xf_vfs_fault.h"
+#include "xf_vfs_walk.h"
+#include "ramfs.h"
+
+/* ==================== [Defines] =========================================== */
+
+#define TAG "xf_vfs_bench"
+
+#define JOBS_MAX            (16)
+#define JOB_FILE_MAX        (16 * 1024)
+
+/* ==================== [Typedefs] ========================================== */
+
+/* ==================== [Static Prototypes] ================================= */
+
+static char *read_file(const char *path);
+
+/* ==================== [Static Variables] ================================== */
+
+static xf_vfs_bench_job_t s_jobs[JOBS_MAX];
+static xf_vfs_bench_result_t s_result;
+
+/* ==================== [Macros] ============================================ */
+
+/* ==================== [Global Functions] ================================== */
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 3) {
+        xf_log_printf("usage: %s <job file> [fault script]\n", argv[0]);
+        return 1;
+    }
+    char *text = read_file(argv[1]);
+    if (text == NULL) {
+        XF_LOGE(TAG, "cannot read %s", argv[1]);
+        return 1;
+    }
+    size_t count = 0;
+    xf_err_t err = xf_vfs_bench_parse(text, s_jobs, JOBS_MAX, &count);
+    xf_free(text);
+    if (err != XF_OK) {
+        return 1;
+    }
+
+    ramfs_t *fs;
+    if (ramfs_mount("/ram", &fs) != XF_OK) {
+        return 1;
+    }
+    if (argc == 3) {
+        if (xf_vfs_fault_register("/slow", "/ram", 1) != XF_OK
+                || xf_vfs_fault_configure("/slow", argv[2]) != XF_OK) {
+            return 1;
+        }
+    }
+
+    int ret = 0;
+    for (size_t i = 0; i < count; ++i) {
+        xf_vfs_mkdir_p(s_jobs[i].directory, 0777);
+        err = xf_vfs_bench_run(&s_jobs[i], &s_result);
+        if (err != XF_OK) {
+            XF_LOGE(TAG, "[%s] failed: %d", s_jobs[i].name, (int)err);
+            ret = 1;
+            continue;
+        }
+        xf_vfs_bench_report(&s_jobs[i], &s_result);
+    }
+
+    if (argc == 3) {
+        xf_vfs_fault_unregister("/slow");
+    }
+    ramfs_unmount("/ram", fs);
+    return ret;
+}
+
+/* ==================== [Static Functions] ================================== */
+
+static char *read_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    char *text = xf_malloc(JOB_FILE_MAX + 1);
+    size_t n = 0;
+    if (text != NULL) {
+        n = fread(text, 1, JOB_FILE_MAX, f);
+        text[n] = '\0';
+    }
+    fclose(f);
+    return text;
+}
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+将 xf_vfs_trace_dump() 导出的二进制数据转换为 Chrome/Perfetto trace JSON.
+
+用法：
+    python3 xf_vfs_trace2json.py trace.bin [-o trace.json] [--big-endian]
+
+生成的文件可以在 https://ui.perfetto.dev 或 chrome://tracing 中打开。
+每个环形缓冲区（即每个线程）显示为一条时间线，每次调用显示为一个区间，
+名称为操作名，参数中给出挂载点、fd、字节数、返回值及 errno.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = b"XFVT"
+VERSION = 1
+VFS_NONE = 0xFF
+
+HEADER = "4sHHHHHH"
+# 与 xf_vfs_trace_rec_t 一致
+RECORD = "QIIihHBBBBHH"
+
+
+def read_string(data, pos):
+    n = data[pos]
+    return data[pos + 1:pos + 1 + n].decode("utf-8", "replace"), pos + 1 + n
+
+
+def parse(data, endian):
+    header_size = struct.calcsize(endian + HEADER)
+    magic, version, rec_size, op_count, mount_count, ring_size, rings = \
+        struct.unpack_from(endian + HEADER, data, 0)
+    if magic != MAGIC:
+        raise ValueError("not an xf_vfs trace (bad magic)")
+    if version != VERSION:
+        raise ValueError("unsupported trace version %d" % version)
+    if rec_size != struct.calcsize(endian + RECORD):
+        raise ValueError("unexpected record size %d (wrong --big-endian?)" % rec_size)
+
+    pos = header_size
+    ops = []
+    for _ in range(op_count):
+        name, pos = read_string(data, pos)
+        ops.append(name)
+    mounts = {}
+    for _ in range(mount_count):
+        index = data[pos]
+        prefix, pos = read_string(data, pos + 1)
+        mounts[index] = prefix if prefix else "(default)"
+
+    records = []
+    while pos + rec_size <= len(data):
+        (ts, dur, size, result, fd, err, op, vfs, ring, _r1, _seq, _r2) = \
+            struct.unpack_from(endian + RECORD, data, pos)
+        pos += rec_size
+        records.append({
+            "ts": ts, "dur": dur, "size": size, "result": result,
+            "fd": fd, "err": err, "op": op, "vfs": vfs, "ring": ring,
+        })
+    return ops, mounts, rings, records
+
+
+def to_chrome(ops, mounts, records):
+    events = []
+    events.append({"ph": "M", "pid": 1, "name": "process_name", "args": {"name": "xf_vfs"}})
+    for ring in sorted({r["ring"] for r in records}):
+        events.append({"ph": "M", "pid": 1, "tid": ring, "name": "thread_name",
+                       "args": {"name": "thread %d" % ring}})
+
+    base = min((r["ts"] for r in records), default=0)
+    for r in sorted(records, key=lambda r: r["ts"]):
+        op = ops[r["op"]] if r["op"] < len(ops) else "op%d" % r["op"]
+        mount = mounts.get(r["vfs"], "?") if r["vfs"] != VFS_NONE else "?"
+        args = {"mount": mount, "result": r["result"]}
+        if r["fd"] >= 0:
+            args["fd"] = r["fd"]
+        if r["size"]:
+            args["size"] = r["size"]
+        if r["result"] < 0:
+            args["errno"] = r["err"]
+        events.append({
+            "ph": "X",
+            "pid": 1,
+            "tid": r["ring"],
+            "name": op,
+            "cat": mount,
+            "ts": (r["ts"] - base) / 1000.0,    # us
+            "dur": r["dur"] / 1000.0,
+            "args": args,
+        })
+    return {"traceEvents": events, "displayTimeUnit": "ns"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="convert an xf_vfs trace dump to Chrome/Perfetto JSON")
+    parser.add_argument("input", help="binary dump written by xf_vfs_trace_dump()")
+    parser.add_argument("-o", "--output", help="output JSON file (default: stdout)")
+    parser.add_argument("--big-endian", action="store_true", help="the dump comes from a big-endian target")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+    ops, mounts, _rings, records = parse(data, ">" if args.big_endian else "<")
+    trace = to_chrome(ops, mounts, records)
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    json.dump(trace, out, indent=1)
+    if args.output:
+        out.close()
+    sys.stderr.write("%d records, %d rings\n" % (len(records), len({r["ring"] for r in records})))
+
+
+if __name__ == "__main__":
+    main()
@@ -17,6 +17,42 @@ function add_target(name)
         add_xf_vfs()
         add_files(string.format("example/%s/*.c", name))
         add_includedirs(string.format("example/%s", name))
+        add_files("example/common/*.c")
+        add_includedirs("example/common")
 end 
 
 add_target("test_vfs_paths")
+add_target("test_vfs_overlay")
+add_target("test_vfs_dup")
+add_target("test_vfs_offset")
+add_target("test_vfs_handle")
+add_target("test_vfs_off64")
+add_target("test_vfs_fd_shards")
+add_target("test_vfs_getdents")
+add_target("test_vfs_walk")
+add_target("test_vfs_statx")
+add_target("test_vfs_dirat")
+add_target("test_vfs_path_prepare")
+add_target("test_vfs_static_mounts")
+add_target("test_vfs_mem")
+add_target("test_vfs_trace")
+add_target("test_vfs_latency")
+add_target("test_vfs_fault")
+add_target("test_vfs_capture")
+add_target("test_vfs_bench")
+add_target("test_vfs_qos")
+add_target("test_vfs_merge")
+add_target("test_vfs_serial")
+add_target("test_vfs_executor")
+add_target("test_vfs_select_sockets")
+
+-- 负载生成器（主机工具）：xmake r xf_vfs_bench tools/xf_vfs_bench/sample.fio
+target("xf_vfs_bench")
+    set_kind("binary")
+    add_cflags("-Wall")
+    add_cflags("-std=gnu99 -O2")
+    add_xf_vfs()
+    add_files("tools/xf_vfs_bench/*.c")
+    add_includedirs("tools/xf_vfs_bench")
+    add_files("example/common/*.c")
+    add_includedirs("example/common")